@@ -0,0 +1,23 @@
+# Filename: FindBasisU.cmake
+# Authors: rdb (17 Oct, 2026)
+#
+# Usage:
+#   find_package(BasisU [REQUIRED] [QUIET])
+#
+# Once done this will define:
+#   BASISU_FOUND       - system has the Basis Universal transcoder
+#   BASISU_INCLUDE_DIR - the include directory containing basisu_transcoder.h
+#   BASISU_LIBRARY     - the path to the transcoder library
+#
+
+find_path(BASISU_INCLUDE_DIR
+  NAMES "basisu_transcoder.h"
+  PATH_SUFFIXES "basisu" "basisu/transcoder")
+
+find_library(BASISU_LIBRARY
+  NAMES "basisu_transcoder" "basisu_encoder" "basisu")
+
+mark_as_advanced(BASISU_INCLUDE_DIR BASISU_LIBRARY)
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(BasisU DEFAULT_MSG BASISU_INCLUDE_DIR BASISU_LIBRARY)
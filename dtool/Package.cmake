@@ -96,7 +96,6 @@ if(THIRDPARTY_DIRECTORY)
     Freetype
     HarfBuzz
     JPEG
-    LibSquish
     MIMALLOC
     ODE
     Ogg
@@ -127,8 +126,6 @@ if(THIRDPARTY_DIRECTORY)
       set(_package "vorbis") # It's in the same install dir here
     elseif(_package STREQUAL "opusfile")
       set(_package "opus")
-    elseif(_package STREQUAL "libsquish")
-      set(_package "squish")
     elseif(_package STREQUAL "swresample" OR _package STREQUAL "swscale")
       set(_package "ffmpeg") # These are also part of FFmpeg
     elseif(_package STREQUAL "vorbisfile")
@@ -492,6 +489,24 @@ package_option(ZLIB
 
 package_status(ZLIB "zlib")
 
+# Zstandard
+find_package(Zstd QUIET MODULE)
+
+package_option(ZSTD
+  "Enables support for loading KTX2 textures with Zstandard supercompression."
+  FOUND_AS Zstd)
+
+package_status(ZSTD "Zstandard")
+
+# Basis Universal
+find_package(BasisU QUIET MODULE)
+
+package_option(BASISU
+  "Enables support for transcoding Basis Universal data in KTX2 textures."
+  FOUND_AS BasisU)
+
+package_status(BASISU "Basis Universal")
+
 
 #
 # ------------ Image formats ------------
@@ -535,15 +550,6 @@ endif()
 
 package_status(OpenEXR "OpenEXR")
 
-# libsquish
-find_package(LibSquish QUIET MODULE)
-
-package_option(SQUISH
-  "Enables support for automatic compression of DXT textures."
-  FOUND_AS LibSquish)
-
-package_status(SQUISH "libsquish")
-
 
 #
 # ------------ Asset formats ------------
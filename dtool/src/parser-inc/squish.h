@@ -1,9 +0,0 @@
-#ifndef SQUISH_H
-#define SQUISH_H
-
-namespace squish {
-  typedef unsigned char u8;
-};
-
-#endif
-
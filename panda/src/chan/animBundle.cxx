@@ -47,6 +47,21 @@ copy_bundle() const {
   return DCAST(AnimBundle, group.p());
 }
 
+/**
+ * Replaces all of the AnimChannelMatrixXfmTables in the bundle with
+ * AnimChannelMatrixQuantized channels, which use much less memory, at the
+ * cost of a small loss of precision.  See the AnimChannelMatrixQuantized
+ * constructor for the meaning of the tolerance parameters.
+ *
+ * This should be done before the bundle is bound to any PartBundles, since
+ * those will continue to use the original channels.  Returns the number of
+ * channels that were replaced.
+ */
+int AnimBundle::
+quantize_channels(PN_stdfloat tolerance, PN_stdfloat angle_tolerance) {
+  return r_quantize_channels(tolerance, angle_tolerance);
+}
+
 /**
  * Writes a one-line description of the bundle.
  */
@@ -34,6 +34,8 @@ PUBLISHED:
   INLINE explicit AnimBundle(std::string name, PN_stdfloat fps, int num_frames);
 
   PT(AnimBundle) copy_bundle() const;
+  int quantize_channels(PN_stdfloat tolerance = 0.001f,
+                        PN_stdfloat angle_tolerance = 0.01f);
 
   INLINE double get_base_frame_rate() const;
   INLINE int get_num_frames() const;
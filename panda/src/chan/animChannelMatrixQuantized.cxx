@@ -0,0 +1,715 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file animChannelMatrixQuantized.cxx
+ * @author rdb
+ * @date 2026-10-17
+ */
+
+#include "animChannelMatrixQuantized.h"
+#include "animChannelMatrixXfmTable.h"
+#include "compose_matrix.h"
+#include "indent.h"
+#include "datagram.h"
+#include "datagramIterator.h"
+#include "bamReader.h"
+#include "bamWriter.h"
+
+#include <algorithm>
+
+TypeHandle AnimChannelMatrixQuantized::_type_handle;
+
+// The three smallest components of a unit quaternion lie within this range.
+static const PN_stdfloat quat_component_range = 0.70710678118654752440f;
+
+// The rotation components are quantized to this many steps, leaving one bit
+// of each 16-bit word to store the index of the omitted component.
+static const int quat_component_steps = 32767;
+
+/**
+ * Interpolates linearly between two rotations, along the shortest path, and
+ * normalizes the result.
+ */
+static LQuaternion
+nlerp(const LQuaternion &a, const LQuaternion &b, PN_stdfloat t) {
+  LQuaternion result;
+  if (a.dot(b) < 0.0f) {
+    result = a * (1.0f - t) - b * t;
+  } else {
+    result = a * (1.0f - t) + b * t;
+  }
+  result.normalize();
+  return result;
+}
+
+/**
+ * Used only for bam loader.
+ */
+AnimChannelMatrixQuantized::
+AnimChannelMatrixQuantized() {
+}
+
+/**
+ * Creates a new AnimChannelMatrixQuantized, just like this one, without
+ * copying any children.  The new copy is added to the indicated parent.
+ * Intended to be called by make_copy() only.
+ */
+AnimChannelMatrixQuantized::
+AnimChannelMatrixQuantized(AnimGroup *parent, const AnimChannelMatrixQuantized &copy) :
+  AnimChannelMatrix(parent, copy)
+{
+  for (int i = 0; i < T_num_tracks; ++i) {
+    _tracks[i] = copy._tracks[i];
+  }
+}
+
+/**
+ * Creates a new channel that approximates the indicated table, and adds it to
+ * the indicated parent, which may be NULL.  The children of the table are not
+ * copied.
+ *
+ * The tolerance specifies how far the scale, shear and translation values
+ * may deviate from the values in the table, and angle_tolerance specifies the
+ * maximum error in the rotation, in degrees.  The error may be greater if
+ * the range of the values in a channel is so great that 16 bits are not
+ * sufficient to represent it with that precision.
+ */
+AnimChannelMatrixQuantized::
+AnimChannelMatrixQuantized(AnimGroup *parent,
+                           const AnimChannelMatrixXfmTable &source,
+                           PN_stdfloat tolerance, PN_stdfloat angle_tolerance) :
+  AnimChannelMatrix(parent, source)
+{
+  CPTA_stdfloat tables[num_matrix_components];
+  for (int i = 0; i < num_matrix_components; ++i) {
+    tables[i] = source.get_table(matrix_component_letters[i]);
+  }
+
+  // Each track is as long as the longest table among its components; the
+  // other tables are either empty or have a single value.
+  auto get_length = [&] (int first) {
+    return std::max(std::max(tables[first].size(), tables[first + 1].size()),
+                    tables[first + 2].size());
+  };
+  auto get_sample = [&] (int first, size_t frame) {
+    LVecBase3 value;
+    for (int i = 0; i < 3; ++i) {
+      const CPTA_stdfloat &table = tables[first + i];
+      if (table.empty()) {
+        value[i] = (PN_stdfloat)matrix_component_defaults[first + i];
+      } else {
+        value[i] = table[frame % table.size()];
+      }
+    }
+    return value;
+  };
+
+  static const struct {
+    TrackType _type;
+    int _first;
+  } vector_tracks[] = {{T_scale, 0}, {T_shear, 3}, {T_pos, 9}};
+
+  for (const auto &vt : vector_tracks) {
+    pvector<LVecBase3> samples(get_length(vt._first), LVecBase3::zero());
+    for (size_t f = 0; f < samples.size(); ++f) {
+      samples[f] = get_sample(vt._first, f);
+    }
+    quantize_vector(vt._type, samples, tolerance);
+  }
+
+  pvector<LQuaternion> rotations(get_length(6), LQuaternion::ident_quat());
+  for (size_t f = 0; f < rotations.size(); ++f) {
+    rotations[f].set_hpr(get_sample(6, f));
+  }
+  quantize_rotation(rotations, angle_tolerance);
+}
+
+/**
+ *
+ */
+AnimChannelMatrixQuantized::
+~AnimChannelMatrixQuantized() {
+}
+
+/**
+ * Returns the number of frames of the longest track in the channel.
+ */
+int AnimChannelMatrixQuantized::
+get_num_frames() const {
+  int num_frames = 0;
+  for (const Track &track : _tracks) {
+    num_frames = std::max(num_frames, track._num_frames);
+  }
+  return num_frames;
+}
+
+/**
+ * Returns the total number of keys stored for all of the tracks.  This is an
+ * indication of how well the animation has been compressed.
+ */
+int AnimChannelMatrixQuantized::
+get_num_keys() const {
+  int num_keys = 0;
+  for (const Track &track : _tracks) {
+    num_keys += (int)track._keys.size();
+  }
+  return num_keys;
+}
+
+/**
+ * Returns true if the value has changed since the last call to has_changed().
+ * last_frame is the frame number of the last call; this_frame is the current
+ * frame number.
+ */
+bool AnimChannelMatrixQuantized::
+has_changed(int last_frame, double last_frac,
+            int this_frame, double this_frac) {
+  if (last_frame != this_frame) {
+    for (const Track &track : _tracks) {
+      if (track.is_animated() && track.has_changed(last_frame, this_frame)) {
+        return true;
+      }
+    }
+  }
+
+  if (last_frac != this_frac) {
+    // If we have some fractional changes, also check the next subsequent
+    // frame (since we'll be blending with that).
+    for (const Track &track : _tracks) {
+      if (track.is_animated() && track.has_changed(last_frame, this_frame + 1)) {
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+/**
+ * Gets the value of the channel at the indicated frame.
+ */
+void AnimChannelMatrixQuantized::
+get_value(int frame, LMatrix4 &mat) {
+  LVecBase3 scale = get_vector(T_scale, frame, LVecBase3(1.0f, 1.0f, 1.0f));
+  LVecBase3 shear = get_vector(T_shear, frame, LVecBase3::zero());
+  LVecBase3 pos = get_vector(T_pos, frame, LVecBase3::zero());
+
+  mat = LMatrix4::scale_shear_mat(scale, shear) * get_rotation(frame);
+  mat.set_row(3, pos);
+}
+
+/**
+ * Gets the value of the channel at the indicated frame, without any scale or
+ * shear information.
+ */
+void AnimChannelMatrixQuantized::
+get_value_no_scale_shear(int frame, LMatrix4 &mat) {
+  get_rotation(frame).extract_to_matrix(mat);
+  mat.set_row(3, get_vector(T_pos, frame, LVecBase3::zero()));
+}
+
+/**
+ * Gets the scale value at the indicated frame.
+ */
+void AnimChannelMatrixQuantized::
+get_scale(int frame, LVecBase3 &scale) {
+  scale = get_vector(T_scale, frame, LVecBase3(1.0f, 1.0f, 1.0f));
+}
+
+/**
+ * Returns the h, p, and r components associated with the current frame.
+ * These are derived from the stored rotation, so they may not be the same
+ * angles as in the original table.
+ */
+void AnimChannelMatrixQuantized::
+get_hpr(int frame, LVecBase3 &hpr) {
+  hpr = get_rotation(frame).get_hpr();
+}
+
+/**
+ * Returns the rotation component associated with the current frame,
+ * expressed as a quaternion.
+ */
+void AnimChannelMatrixQuantized::
+get_quat(int frame, LQuaternion &quat) {
+  quat = get_rotation(frame);
+}
+
+/**
+ * Returns the x, y, and z translation components associated with the current
+ * frame.
+ */
+void AnimChannelMatrixQuantized::
+get_pos(int frame, LVecBase3 &pos) {
+  pos = get_vector(T_pos, frame, LVecBase3::zero());
+}
+
+/**
+ * Returns the a, b, and c shear components associated with the current frame.
+ */
+void AnimChannelMatrixQuantized::
+get_shear(int frame, LVecBase3 &shear) {
+  shear = get_vector(T_shear, frame, LVecBase3::zero());
+}
+
+/**
+ * Writes a brief description of the channel and all of its descendants.
+ */
+void AnimChannelMatrixQuantized::
+write(std::ostream &out, int indent_level) const {
+  static const char *const track_names[T_num_tracks] = {
+    "scale", "shear", "rotate", "pos",
+  };
+
+  indent(out, indent_level)
+    << get_type() << " " << get_name() << " ";
+
+  // Write the number of keys out of the number of frames of each track.
+  bool found_any = false;
+  for (int i = 0; i < T_num_tracks; ++i) {
+    const Track &track = _tracks[i];
+    if (track._num_frames != 0) {
+      if (found_any) {
+        out << " ";
+      }
+      out << track_names[i] << " " << track._keys.size() << "/"
+          << track._num_frames;
+      found_any = true;
+    }
+  }
+
+  if (!found_any) {
+    out << "(no data)";
+  }
+
+  if (!_children.empty()) {
+    out << " {\n";
+    write_descendants(out, indent_level + 2);
+    indent(out, indent_level) << "}";
+  }
+
+  out << "\n";
+}
+
+/**
+ * Returns a copy of this object, and attaches it to the indicated parent
+ * (which may be NULL only if this is an AnimBundle).  Intended to be called
+ * by copy_subtree() only.
+ */
+AnimGroup *AnimChannelMatrixQuantized::
+make_copy(AnimGroup *parent) const {
+  return new AnimChannelMatrixQuantized(parent, *this);
+}
+
+/**
+ * Determines the key that precedes the indicated frame, and the fraction of
+ * the way towards the next key at which the frame lies.  If t is returned as
+ * 0, the next key need not exist.
+ */
+void AnimChannelMatrixQuantized::Track::
+find_key(int frame, size_t &key, PN_stdfloat &t) const {
+  size_t num_keys = _keys.size();
+  key = 0;
+  t = 0.0f;
+  if (num_keys <= 1) {
+    return;
+  }
+
+  frame %= _num_frames;
+
+  // The first key is always at frame 0.
+  const unsigned short *begin = &_keys[0];
+  const unsigned short *end = begin + num_keys;
+  key = (std::upper_bound(begin, end, (unsigned short)frame) - begin) - 1;
+
+  if (key + 1 < num_keys) {
+    int frame0 = _keys[key];
+    int frame1 = _keys[key + 1];
+    t = (PN_stdfloat)(frame - frame0) / (PN_stdfloat)(frame1 - frame0);
+  }
+}
+
+/**
+ * Returns true if the track may have a different value at the two indicated
+ * frames.
+ */
+bool AnimChannelMatrixQuantized::Track::
+has_changed(int frame_a, int frame_b) const {
+  size_t key_a, key_b;
+  PN_stdfloat t_a, t_b;
+  find_key(frame_a, key_a, t_a);
+  find_key(frame_b, key_b, t_b);
+  if (key_a == key_b && t_a == t_b) {
+    return false;
+  }
+
+  // The value can only be the same if all of the keys that the frames are
+  // interpolated from are the same.
+  size_t first = std::min(key_a, key_b);
+  size_t last = std::max(key_a + (t_a != 0.0f), key_b + (t_b != 0.0f));
+  const unsigned short *words = &_values[0];
+  for (size_t key = first + 1; key <= last; ++key) {
+    if (words[key * 3] != words[first * 3] ||
+        words[key * 3 + 1] != words[first * 3 + 1] ||
+        words[key * 3 + 2] != words[first * 3 + 2]) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Returns the value of the rotation track at the indicated frame.
+ */
+LQuaternion AnimChannelMatrixQuantized::
+get_rotation(int frame) const {
+  const Track &track = _tracks[T_rotate];
+  if (track._num_frames == 0) {
+    return LQuaternion::ident_quat();
+  }
+
+  size_t key;
+  PN_stdfloat t;
+  track.find_key(frame, key, t);
+  LQuaternion a = decode_quat(&track._values[key * 3]);
+  if (t == 0.0f) {
+    return a;
+  }
+  return nlerp(a, decode_quat(&track._values[key * 3 + 3]), t);
+}
+
+/**
+ * Decodes a unit quaternion from three 16-bit words, as encoded by
+ * encode_quat().
+ */
+LQuaternion AnimChannelMatrixQuantized::
+decode_quat(const unsigned short *words) {
+  int largest = (words[0] & 1) | ((words[1] & 1) << 1);
+
+  PN_stdfloat components[4];
+  PN_stdfloat sum = 0.0f;
+  int w = 0;
+  for (int i = 0; i < 4; ++i) {
+    if (i != largest) {
+      PN_stdfloat v = (words[w++] >> 1) * (2.0f / quat_component_steps) - 1.0f;
+      components[i] = v * quat_component_range;
+      sum += components[i] * components[i];
+    }
+  }
+  components[largest] = csqrt(std::max((PN_stdfloat)0.0f, 1.0f - sum));
+
+  return LQuaternion(components[0], components[1], components[2], components[3]);
+}
+
+/**
+ * Encodes a unit quaternion into three 16-bit words.  The largest component
+ * is omitted, since it can be derived from the other three; its index is
+ * stored in the low bits of the first two words.
+ */
+void AnimChannelMatrixQuantized::
+encode_quat(const LQuaternion &quat, unsigned short *words) {
+  int largest = 0;
+  for (int i = 1; i < 4; ++i) {
+    if (cabs(quat[i]) > cabs(quat[largest])) {
+      largest = i;
+    }
+  }
+
+  // q and -q represent the same rotation; pick the one for which the omitted
+  // component is positive.
+  PN_stdfloat sign = (quat[largest] < 0.0f) ? -1.0f : 1.0f;
+
+  int w = 0;
+  for (int i = 0; i < 4; ++i) {
+    if (i != largest) {
+      PN_stdfloat v = quat[i] * sign / quat_component_range;
+      int q = (int)cfloor((v + 1.0f) * 0.5f * quat_component_steps + 0.5f);
+      q = std::min(std::max(q, 0), quat_component_steps);
+      words[w++] = (unsigned short)(q << 1);
+    }
+  }
+  words[0] |= (largest & 1);
+  words[1] |= (largest >> 1) & 1;
+}
+
+/**
+ * Fills in the indicated scale, shear or translation track from the given
+ * per-frame values.
+ */
+void AnimChannelMatrixQuantized::
+quantize_vector(TrackType type, const pvector<LVecBase3> &samples,
+                PN_stdfloat tolerance) {
+  Track &track = _tracks[type];
+  track = Track();
+
+  size_t num_frames = samples.size();
+  nassertv(num_frames <= 65536);
+  track._num_frames = (int)num_frames;
+  if (num_frames == 0) {
+    return;
+  }
+
+  // Determine the range of values of each component.
+  LVecBase3 min_value = samples[0];
+  LVecBase3 max_value = samples[0];
+  for (const LVecBase3 &sample : samples) {
+    min_value = min_value.fmin(sample);
+    max_value = max_value.fmax(sample);
+  }
+  track._base = LCAST(float, min_value);
+  track._step = LCAST(float, (max_value - min_value) / 65535.0f);
+
+  pvector<unsigned short> words(num_frames * 3);
+  bool constant = true;
+  for (size_t f = 0; f < num_frames; ++f) {
+    for (int i = 0; i < 3; ++i) {
+      int q = 0;
+      if (track._step[i] != 0.0f) {
+        q = (int)cfloor((samples[f][i] - track._base[i]) / track._step[i] + 0.5f);
+        q = std::min(std::max(q, 0), 65535);
+      }
+      words[f * 3 + i] = (unsigned short)q;
+      constant = constant && (words[f * 3 + i] == words[i]);
+    }
+  }
+
+  pvector<int> keys;
+  if (constant) {
+    keys.push_back(0);
+  } else {
+    // Use the quantized values for the keys, so that we take the error due to
+    // the quantization into account when fitting.
+    track._values = PTA_ushort(words.data(), words.data() + words.size(), get_class_type());
+    auto fits = [&] (int a, int b) {
+      LVecBase3 value_a = decode_vector(track, a);
+      LVecBase3 delta = decode_vector(track, b) - value_a;
+      for (int f = a + 1; f < b; ++f) {
+        LVecBase3 value = value_a + delta * ((PN_stdfloat)(f - a) / (PN_stdfloat)(b - a));
+        LVecBase3 error = value - samples[f];
+        if (cabs(error[0]) > tolerance || cabs(error[1]) > tolerance ||
+            cabs(error[2]) > tolerance) {
+          return false;
+        }
+      }
+      return true;
+    };
+    reduce_keys(num_frames, keys, fits);
+  }
+
+  PTA_ushort key_frames(get_class_type());
+  PTA_ushort key_values(get_class_type());
+  key_frames.reserve(keys.size());
+  key_values.reserve(keys.size() * 3);
+  for (int f : keys) {
+    key_frames.push_back((unsigned short)f);
+    key_values.push_back(words[f * 3]);
+    key_values.push_back(words[f * 3 + 1]);
+    key_values.push_back(words[f * 3 + 2]);
+  }
+  track._keys = key_frames;
+  track._values = key_values;
+}
+
+/**
+ * Fills in the rotation track from the given per-frame values, which should
+ * be unit quaternions.
+ */
+void AnimChannelMatrixQuantized::
+quantize_rotation(const pvector<LQuaternion> &samples,
+                  PN_stdfloat angle_tolerance) {
+  Track &track = _tracks[T_rotate];
+  track = Track();
+
+  size_t num_frames = samples.size();
+  nassertv(num_frames <= 65536);
+  track._num_frames = (int)num_frames;
+  if (num_frames == 0) {
+    return;
+  }
+
+  pvector<unsigned short> words(num_frames * 3);
+  bool constant = true;
+  for (size_t f = 0; f < num_frames; ++f) {
+    encode_quat(samples[f], &words[f * 3]);
+    for (int i = 0; i < 3; ++i) {
+      constant = constant && (words[f * 3 + i] == words[i]);
+    }
+  }
+
+  pvector<int> keys;
+  if (constant) {
+    keys.push_back(0);
+  } else {
+    pvector<LQuaternion> decoded(num_frames, LQuaternion::ident_quat());
+    for (size_t f = 0; f < num_frames; ++f) {
+      decoded[f] = decode_quat(&words[f * 3]);
+    }
+
+    // Compare the cosine of half the angle between the rotations, which is
+    // the dot product of the quaternions.
+    PN_stdfloat min_dot = ccos(deg_2_rad(angle_tolerance) * 0.5f);
+    auto fits = [&] (int a, int b) {
+      for (int f = a + 1; f < b; ++f) {
+        LQuaternion quat = nlerp(decoded[a], decoded[b],
+                                 (PN_stdfloat)(f - a) / (PN_stdfloat)(b - a));
+        if (cabs(quat.dot(samples[f])) < min_dot) {
+          return false;
+        }
+      }
+      return true;
+    };
+    reduce_keys(num_frames, keys, fits);
+  }
+
+  PTA_ushort key_frames(get_class_type());
+  PTA_ushort key_values(get_class_type());
+  key_frames.reserve(keys.size());
+  key_values.reserve(keys.size() * 3);
+  for (int f : keys) {
+    key_frames.push_back((unsigned short)f);
+    key_values.push_back(words[f * 3]);
+    key_values.push_back(words[f * 3 + 1]);
+    key_values.push_back(words[f * 3 + 2]);
+  }
+  track._keys = key_frames;
+  track._values = key_values;
+}
+
+/**
+ * Chooses the frames to keep as keys, given a function that returns whether
+ * interpolating between two frames reproduces all of the frames in between
+ * them closely enough.  The first and last frames are always kept.
+ *
+ * This greedily extends each segment as far as it will go, by doubling its
+ * length and then bisecting, so that long smooth segments are found quickly.
+ */
+template<class Fits>
+void AnimChannelMatrixQuantized::
+reduce_keys(size_t num_samples, pvector<int> &keys, Fits fits) {
+  keys.clear();
+  keys.push_back(0);
+
+  int last = (int)num_samples - 1;
+  int a = 0;
+  while (a < last) {
+    // A segment to the very next frame always fits.
+    int good = a + 1;
+    int bad = last + 1;
+    for (int span = 2; a + span <= last; span *= 2) {
+      if (!fits(a, a + span)) {
+        bad = a + span;
+        break;
+      }
+      good = a + span;
+    }
+    if (bad > last && good < last) {
+      if (fits(a, last)) {
+        good = last;
+      } else {
+        bad = last;
+      }
+    }
+    while (bad - good > 1) {
+      int mid = (good + bad) / 2;
+      if (fits(a, mid)) {
+        good = mid;
+      } else {
+        bad = mid;
+      }
+    }
+
+    keys.push_back(good);
+    a = good;
+  }
+}
+
+/**
+ * Tells the BamReader how to create objects of type
+ * AnimChannelMatrixQuantized.
+ */
+void AnimChannelMatrixQuantized::
+register_with_read_factory() {
+  BamReader::get_factory()->register_factory(get_class_type(), make_from_bam);
+}
+
+/**
+ * Writes the contents of this object to the datagram for shipping out to a
+ * Bam file.
+ */
+void AnimChannelMatrixQuantized::
+write_datagram(BamWriter *manager, Datagram &me) {
+  AnimChannelMatrix::write_datagram(manager, me);
+
+  for (const Track &track : _tracks) {
+    me.add_uint32(track._num_frames);
+    if (track._num_frames == 0) {
+      continue;
+    }
+
+    track._base.write_datagram_fixed(me);
+    track._step.write_datagram_fixed(me);
+
+    me.add_uint32(track._keys.size());
+    for (unsigned short key : track._keys) {
+      me.add_uint16(key);
+    }
+    for (unsigned short word : track._values) {
+      me.add_uint16(word);
+    }
+  }
+}
+
+/**
+ * This function is called by the BamReader's factory when a new object of
+ * type AnimChannelMatrixQuantized is encountered in the Bam file.  It should
+ * create the AnimChannelMatrixQuantized and extract its information from the
+ * file.
+ */
+TypedWritable *AnimChannelMatrixQuantized::
+make_from_bam(const FactoryParams &params) {
+  AnimChannelMatrixQuantized *me = new AnimChannelMatrixQuantized;
+  DatagramIterator scan;
+  BamReader *manager;
+
+  parse_params(params, scan, manager);
+  me->fillin(scan, manager);
+  return me;
+}
+
+/**
+ * This internal function is called by make_from_bam to read in all of the
+ * relevant data from the BamFile for the new AnimChannelMatrixQuantized.
+ */
+void AnimChannelMatrixQuantized::
+fillin(DatagramIterator &scan, BamReader *manager) {
+  AnimChannelMatrix::fillin(scan, manager);
+
+  for (Track &track : _tracks) {
+    track = Track();
+    track._num_frames = (int)scan.get_uint32();
+    if (track._num_frames == 0) {
+      continue;
+    }
+
+    track._base.read_datagram_fixed(scan);
+    track._step.read_datagram_fixed(scan);
+
+    size_t num_keys = scan.get_uint32();
+    nassertv(num_keys != 0);
+    PTA_ushort keys = PTA_ushort::empty_array(num_keys, get_class_type());
+    for (size_t i = 0; i < num_keys; ++i) {
+      keys[i] = scan.get_uint16();
+    }
+    PTA_ushort values = PTA_ushort::empty_array(num_keys * 3, get_class_type());
+    for (size_t i = 0; i < num_keys * 3; ++i) {
+      values[i] = scan.get_uint16();
+    }
+    track._keys = keys;
+    track._values = values;
+  }
+}
@@ -0,0 +1,148 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file animChannelMatrixQuantized.h
+ * @author rdb
+ * @date 2026-10-17
+ */
+
+#ifndef ANIMCHANNELMATRIXQUANTIZED_H
+#define ANIMCHANNELMATRIXQUANTIZED_H
+
+#include "pandabase.h"
+
+#include "animChannel.h"
+#include "pta_ushort.h"
+
+class AnimChannelMatrixXfmTable;
+
+/**
+ * A compact alternative to AnimChannelMatrixXfmTable.  Instead of storing one
+ * float per frame for each of the twelve components, this stores a reduced
+ * set of keyframes for each of the scale, shear, rotation and translation,
+ * between which the values are linearly interpolated.  The keys are chosen so
+ * that the interpolated curve stays within a given tolerance of the original
+ * table.
+ *
+ * The scale, shear and translation values are stored as 16-bit integers,
+ * relative to the range of values taken on by that channel.  The rotation is
+ * stored as a quaternion, using 16 bits for each of its three smallest
+ * components.
+ *
+ * The channel is evaluated directly from the compressed data; it is never
+ * expanded back into a table.  See AnimBundle::quantize_channels().
+ */
+class EXPCL_PANDA_CHAN AnimChannelMatrixQuantized : public AnimChannelMatrix {
+protected:
+  AnimChannelMatrixQuantized();
+  AnimChannelMatrixQuantized(AnimGroup *parent, const AnimChannelMatrixQuantized &copy);
+
+PUBLISHED:
+  explicit AnimChannelMatrixQuantized(AnimGroup *parent,
+                                      const AnimChannelMatrixXfmTable &source,
+                                      PN_stdfloat tolerance = 0.001f,
+                                      PN_stdfloat angle_tolerance = 0.01f);
+  virtual ~AnimChannelMatrixQuantized();
+
+  int get_num_frames() const;
+  int get_num_keys() const;
+
+  MAKE_PROPERTY(num_frames, get_num_frames);
+  MAKE_PROPERTY(num_keys, get_num_keys);
+
+public:
+  virtual bool has_changed(int last_frame, double last_frac,
+                           int this_frame, double this_frac);
+  virtual void get_value(int frame, LMatrix4 &mat);
+
+  virtual void get_value_no_scale_shear(int frame, LMatrix4 &value);
+  virtual void get_scale(int frame, LVecBase3 &scale);
+  virtual void get_hpr(int frame, LVecBase3 &hpr);
+  virtual void get_quat(int frame, LQuaternion &quat);
+  virtual void get_pos(int frame, LVecBase3 &pos);
+  virtual void get_shear(int frame, LVecBase3 &shear);
+
+  virtual void write(std::ostream &out, int indent_level) const;
+
+protected:
+  virtual AnimGroup *make_copy(AnimGroup *parent) const;
+
+private:
+  enum TrackType {
+    T_scale,
+    T_shear,
+    T_rotate,
+    T_pos,
+    T_num_tracks,
+  };
+
+  // One animated property of the joint.  Each key stores a frame number in
+  // _keys and three quantized values in _values.  A track with no frames
+  // takes on the default value; a track with a single key is constant.
+  class Track {
+  public:
+    INLINE Track();
+
+    INLINE bool is_animated() const;
+    void find_key(int frame, size_t &key, PN_stdfloat &t) const;
+    bool has_changed(int frame_a, int frame_b) const;
+
+    int _num_frames;
+    PTA_ushort _keys;
+    PTA_ushort _values;
+    LVecBase3f _base;
+    LVecBase3f _step;
+  };
+
+  INLINE LVecBase3 get_vector(TrackType type, int frame,
+                              const LVecBase3 &default_value) const;
+  LQuaternion get_rotation(int frame) const;
+
+  INLINE static LVecBase3 decode_vector(const Track &track, size_t key);
+  static LQuaternion decode_quat(const unsigned short *words);
+  static void encode_quat(const LQuaternion &quat, unsigned short *words);
+
+  void quantize_vector(TrackType type, const pvector<LVecBase3> &samples,
+                       PN_stdfloat tolerance);
+  void quantize_rotation(const pvector<LQuaternion> &samples,
+                         PN_stdfloat angle_tolerance);
+  template<class Fits>
+  static void reduce_keys(size_t num_samples, pvector<int> &keys, Fits fits);
+
+  Track _tracks[T_num_tracks];
+
+public:
+  static void register_with_read_factory();
+  virtual void write_datagram(BamWriter *manager, Datagram &me);
+
+  static TypedWritable *make_from_bam(const FactoryParams &params);
+
+protected:
+  void fillin(DatagramIterator &scan, BamReader *manager);
+
+public:
+  virtual TypeHandle get_type() const {
+    return get_class_type();
+  }
+  virtual TypeHandle force_init_type() {init_type(); return get_class_type();}
+  static TypeHandle get_class_type() {
+    return _type_handle;
+  }
+  static void init_type() {
+    AnimChannelMatrix::init_type();
+    register_type(_type_handle, "AnimChannelMatrixQuantized",
+                  AnimChannelMatrix::get_class_type());
+  }
+
+private:
+  static TypeHandle _type_handle;
+};
+
+#include "animChannelMatrixQuantized.I"
+
+#endif
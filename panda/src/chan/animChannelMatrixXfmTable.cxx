@@ -111,15 +111,7 @@ has_changed(int last_frame, double last_frac,
 void AnimChannelMatrixXfmTable::
 get_value(int frame, LMatrix4 &mat) {
   PN_stdfloat components[num_matrix_components];
-
-  for (int i = 0; i < num_matrix_components; i++) {
-    if (_tables[i].empty()) {
-      components[i] = get_default_value(i);
-    } else {
-      components[i] = _tables[i][frame % _tables[i].size()];
-    }
-  }
-
+  get_components(frame, components);
   compose_matrix(mat, components);
 }
 
@@ -330,7 +322,8 @@ write_datagram(BamWriter *manager, Datagram &me) {
   if (compress_channels) {
     chan_cat.warning()
       << "FFT compression of animations is deprecated.  For compatibility "
-         "with future versions of Panda3D, set compress-channels to false.\n";
+         "with future versions of Panda3D, set compress-channels to false, "
+         "and consider using quantize-channels instead.\n";
 
     if (!FFTCompressor::is_compression_available()) {
       chan_cat.error()
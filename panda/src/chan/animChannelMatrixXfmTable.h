@@ -62,6 +62,8 @@ PUBLISHED:
   MAKE_MAP_PROPERTY(tables, has_table, get_table, set_table, clear_table);
 
 public:
+  INLINE void get_components(int frame, PN_stdfloat components[num_matrix_components]) const;
+
   virtual void write(std::ostream &out, int indent_level) const;
 
 protected:
@@ -71,6 +71,8 @@ public:
 
   bool channel_has_changed(AnimChannelBase *channel, bool frame_blend_flag) const;
   void mark_channels(bool frame_blend_flag);
+  INLINE int get_marked_frame() const;
+  INLINE double get_marked_frac() const;
 
 protected:
   virtual void animation_activated();
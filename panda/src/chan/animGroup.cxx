@@ -13,6 +13,8 @@
 
 #include "animGroup.h"
 #include "animBundle.h"
+#include "animChannelMatrixQuantized.h"
+#include "animChannelMatrixXfmTable.h"
 #include "config_chan.h"
 
 #include "indent.h"
@@ -234,6 +236,40 @@ copy_subtree(AnimGroup *parent) const {
   return new_group;
 }
 
+/**
+ * Replaces each AnimChannelMatrixXfmTable at this node and below with an
+ * equivalent AnimChannelMatrixQuantized.  Returns the number of channels
+ * replaced.  See AnimBundle::quantize_channels().
+ */
+int AnimGroup::
+r_quantize_channels(PN_stdfloat tolerance, PN_stdfloat angle_tolerance) {
+  int num_quantized = 0;
+
+  for (PT(AnimGroup) &child : _children) {
+    if (child->is_exact_type(AnimChannelMatrixXfmTable::get_class_type())) {
+      AnimChannelMatrixXfmTable *table = DCAST(AnimChannelMatrixXfmTable, child);
+
+      // The keys store frame numbers in 16 bits.
+      bool too_long = false;
+      for (int i = 0; i < num_matrix_components; ++i) {
+        too_long = too_long ||
+          table->get_table(matrix_component_letters[i]).size() > 65536;
+      }
+      if (!too_long) {
+        PT(AnimGroup) new_child = new AnimChannelMatrixQuantized(nullptr, *table, tolerance, angle_tolerance);
+        new_child->_root = _root;
+        new_child->_children.swap(child->_children);
+        child = std::move(new_child);
+        ++num_quantized;
+      }
+    }
+
+    num_quantized += child->r_quantize_channels(tolerance, angle_tolerance);
+  }
+
+  return num_quantized;
+}
+
 /**
  * Function to write the important information in the particular object to a
  * Datagram
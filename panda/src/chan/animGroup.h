@@ -62,6 +62,7 @@ protected:
 
   [[nodiscard]] virtual AnimGroup *make_copy(AnimGroup *parent) const;
   PT(AnimGroup) copy_subtree(AnimGroup *parent) const;
+  int r_quantize_channels(PN_stdfloat tolerance, PN_stdfloat angle_tolerance);
 
 protected:
   typedef pvector< PT(AnimGroup) > Children;
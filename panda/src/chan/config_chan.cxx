@@ -16,6 +16,7 @@
 #include "animBundleNode.h"
 #include "animChannelBase.h"
 #include "animChannelMatrixXfmTable.h"
+#include "animChannelMatrixQuantized.h"
 #include "animChannelMatrixDynamic.h"
 #include "animChannelMatrixFixed.h"
 #include "animChannelScalarTable.h"
@@ -78,6 +79,24 @@ PRC_DESC("Set this false to disable reading of compressed animation channels, "
          "might want to do this would be to speed load time when you don't "
          "care about what the animation looks like."));
 
+ConfigVariableBool quantize_channels
+("quantize-channels", false,
+ PRC_DESC("Set this true to convert the animation tables loaded from egg "
+          "files to a compact, keyframe-reduced representation, which is "
+          "also what will be written to a bam file.  Unlike "
+          "compress-channels, this also reduces the memory footprint of the "
+          "animations at runtime.  See quantize-chan-tolerance."));
+
+ConfigVariableDouble quantize_chan_tolerance
+("quantize-chan-tolerance", 0.001,
+ PRC_DESC("The maximum error introduced in the translation, scale and shear "
+          "of a joint when quantize-channels is in effect."));
+
+ConfigVariableDouble quantize_chan_angle_tolerance
+("quantize-chan-angle-tolerance", 0.01,
+ PRC_DESC("The maximum error, in degrees, introduced in the rotation of a "
+          "joint when quantize-channels is in effect."));
+
 ConfigVariableBool interpolate_frames
 ("interpolate-frames", false,
 PRC_DESC("Set this true to interpolate character animations between frames, "
@@ -92,6 +111,14 @@ PRC_DESC("When this is true, setting all control effects on an Actor to 0 "
          "false, it retains whatever its last-computed pose was "
          "(which may or may not be the default pose)."));
 
+ConfigVariableBool part_bundle_update_plan
+("part-bundle-update-plan", true,
+PRC_DESC("When this is true, PartBundle::update() brings the joints up-to-date "
+         "by walking a flattened copy of the part hierarchy that is cached "
+         "on the bundle, reading the animation tables directly where "
+         "possible.  Set this false to use the original recursive update "
+         "instead."));
+
 ConfigVariableInt async_bind_priority
 ("async-bind-priority", 100,
 PRC_DESC("This specifies the priority assign to an asynchronous bind "
@@ -106,6 +133,7 @@ ConfigureFn(config_chan) {
   AnimBundleNode::init_type();
   AnimChannelBase::init_type();
   AnimChannelMatrixXfmTable::init_type();
+  AnimChannelMatrixQuantized::init_type();
   AnimChannelMatrixDynamic::init_type();
   AnimChannelMatrixFixed::init_type();
   AnimChannelScalarTable::init_type();
@@ -137,6 +165,7 @@ ConfigureFn(config_chan) {
   AnimBundle::register_with_read_factory();
   AnimBundleNode::register_with_read_factory();
   AnimChannelMatrixXfmTable::register_with_read_factory();
+  AnimChannelMatrixQuantized::register_with_read_factory();
   AnimChannelMatrixDynamic::register_with_read_factory();
   AnimChannelMatrixFixed::register_with_read_factory();
   AnimChannelScalarTable::register_with_read_factory();
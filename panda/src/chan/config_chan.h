@@ -17,6 +17,7 @@
 #include "pandabase.h"
 #include "notifyCategoryProxy.h"
 #include "configVariableBool.h"
+#include "configVariableDouble.h"
 #include "configVariableInt.h"
 
 // Configure variables for chan package.
@@ -25,8 +26,12 @@ NotifyCategoryDecl(chan, EXPCL_PANDA_CHAN, EXPTP_PANDA_CHAN);
 EXPCL_PANDA_CHAN extern ConfigVariableBool compress_channels;
 EXPCL_PANDA_CHAN extern ConfigVariableInt compress_chan_quality;
 EXPCL_PANDA_CHAN extern ConfigVariableBool read_compressed_channels;
+EXPCL_PANDA_CHAN extern ConfigVariableBool quantize_channels;
+EXPCL_PANDA_CHAN extern ConfigVariableDouble quantize_chan_tolerance;
+EXPCL_PANDA_CHAN extern ConfigVariableDouble quantize_chan_angle_tolerance;
 EXPCL_PANDA_CHAN extern ConfigVariableBool interpolate_frames;
 EXPCL_PANDA_CHAN extern ConfigVariableBool restore_initial_pose;
+EXPCL_PANDA_CHAN extern ConfigVariableBool part_bundle_update_plan;
 EXPCL_PANDA_CHAN extern ConfigVariableInt async_bind_priority;
 
 #endif
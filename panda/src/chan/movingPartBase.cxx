@@ -28,7 +28,8 @@ TypeHandle MovingPartBase::_type_handle;
 MovingPartBase::
 MovingPartBase(PartGroup *parent, std::string name) :
   PartGroup(parent, std::move(name)),
-  _effective_control(nullptr)
+  _effective_control(nullptr),
+  _exclude_from_update(false)
 {
 }
 
@@ -37,7 +38,8 @@ MovingPartBase(PartGroup *parent, std::string name) :
  */
 MovingPartBase::
 MovingPartBase() :
-  _effective_control(nullptr)
+  _effective_control(nullptr),
+  _exclude_from_update(false)
 {
 }
 
@@ -110,11 +112,11 @@ do_update(PartBundle *root, const CycleData *root_cdata, PartGroup *parent,
           bool parent_changed, bool anim_changed,
           Thread *current_thread) {
   bool any_changed = false;
-  bool needs_update = anim_changed;
+  bool needs_update = anim_changed && !_exclude_from_update;
 
   // See if any of the channel values have changed since last time.
 
-  if (!needs_update) {
+  if (!needs_update && !_exclude_from_update) {
     if (_forced_channel != nullptr) {
       needs_update = _forced_channel->has_changed(0, 0.0, 0, 0.0);
 
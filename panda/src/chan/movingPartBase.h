@@ -62,6 +62,9 @@ public:
                                 bool self_changed, bool parent_changed,
                                 Thread *current_thread);
 
+  INLINE void set_exclude_from_update(bool flag);
+  INLINE bool get_exclude_from_update() const;
+
 protected:
   MovingPartBase();
 
@@ -90,6 +93,10 @@ protected:
   // set_forced_channel().  It overrides all of the above if set.
   PT(AnimChannelBase) _forced_channel;
 
+  // Set by PartBundle::set_update_subset() for parts that should keep their
+  // last value rather than being re-evaluated from the animation.
+  bool _exclude_from_update;
+
 public:
   virtual void write_datagram(BamWriter *manager, Datagram &dg);
   virtual int complete_pointers(TypedWritable **plist, BamReader *manager);
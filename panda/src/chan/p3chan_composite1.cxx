@@ -6,6 +6,7 @@
 #include "animChannelFixed.cxx"
 #include "animChannelMatrixDynamic.cxx"
 #include "animChannelMatrixFixed.cxx"
+#include "animChannelMatrixQuantized.cxx"
 #include "animChannelMatrixXfmTable.cxx"
 #include "animChannelScalarDynamic.cxx"
 #include "animChannelScalarTable.cxx"
@@ -6,6 +6,7 @@
 #include "movingPartScalar.cxx"
 #include "partBundle.cxx"
 #include "partBundleNode.cxx"
+#include "partBundleUpdatePlan.cxx"
 #include "partGroup.cxx"
 #include "partSubset.cxx"
 #include "vector_PartGroupStar.cxx"
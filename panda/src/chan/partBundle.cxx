@@ -12,9 +12,11 @@
  */
 
 #include "partBundle.h"
+#include "partBundleUpdatePlan.h"
 #include "animBundle.h"
 #include "animBundleNode.h"
 #include "animControl.h"
+#include "movingPartBase.h"
 #include "loader.h"
 #include "animPreloadTable.h"
 #include "config_chan.h"
@@ -28,6 +30,7 @@
 #include "configVariableEnum.h"
 #include "loaderOptions.h"
 #include "bindAnimRequest.h"
+#include "asyncTaskManager.h"
 
 #include <algorithm>
 
@@ -51,7 +54,8 @@ static ConfigVariableEnum<PartBundle::BlendType> anim_blend_type
  */
 PartBundle::
 PartBundle(const PartBundle &copy) :
-  PartGroup(copy)
+  PartGroup(copy),
+  _update_plan(nullptr)
 {
   _anim_preload = copy._anim_preload;
   _update_delay = 0.0;
@@ -70,11 +74,20 @@ PartBundle(const PartBundle &copy) :
  */
 PartBundle::
 PartBundle(std::string name) :
-  PartGroup(std::move(name))
+  PartGroup(std::move(name)),
+  _update_plan(nullptr)
 {
   _update_delay = 0.0;
 }
 
+/**
+ *
+ */
+PartBundle::
+~PartBundle() {
+  delete _update_plan;
+}
+
 /**
  * Allocates and returns a new copy of the node.  Children are not copied, but
  * see copy_subgraph().
@@ -465,6 +478,38 @@ release_joint(std::string_view joint_name) {
   return child->clear_forced_channel();
 }
 
+/**
+ * Restricts subsequent updates of the bundle to the joints and sliders within
+ * the indicated subset, using the same rules as bind_anim().  The parts
+ * outside of the subset hold whatever value they had last, though they still
+ * move along with their parents.  This is intended for reducing the cost of
+ * animating distant characters, where the small joints such as fingers and
+ * facial joints are not visible anyway.
+ *
+ * Returns the number of parts that will still be updated.
+ */
+int PartBundle::
+set_update_subset(const PartSubset &subset) {
+  int num_included = 0;
+  r_set_update_subset(this, subset.is_include_empty(), subset, num_included);
+
+  // Make sure that the parts that were excluded before are brought up-to-
+  // date with the next update.
+  CDWriter cdata(_cycler, false);
+  cdata->_anim_changed = true;
+
+  return num_included;
+}
+
+/**
+ * Undoes the effect of a previous call to set_update_subset(), so that all of
+ * the parts are updated again.  Returns the number of parts in the bundle.
+ */
+int PartBundle::
+clear_update_subset() {
+  return set_update_subset(PartSubset());
+}
+
 /**
  * Updates all the parts in the bundle to reflect the data for the current
  * frame (as set in each of the AnimControls).
@@ -475,53 +520,163 @@ release_joint(std::string_view joint_name) {
 bool PartBundle::
 update() {
   Thread *current_thread = Thread::get_current_thread();
-  CDWriter cdata(_cycler, false, current_thread);
-  bool any_changed = false;
+  if (!begin_update(false, current_thread)) {
+    return false;
+  }
+  return finish_update(false, current_thread);
+}
 
-  double now = ClockObject::get_global_clock()->get_frame_time(current_thread);
-  if (now > cdata->_last_update + _update_delay || cdata->_anim_changed) {
-    bool anim_changed = cdata->_anim_changed;
-    bool frame_blend_flag = cdata->_frame_blend_flag;
+/**
+ * Updates all the parts in the bundle to reflect the data for the current
+ * frame, whether we believe it needs it or not.
+ */
+bool PartBundle::
+force_update() {
+  Thread *current_thread = Thread::get_current_thread();
+  begin_update(true, current_thread);
+  return finish_update(true, current_thread);
+}
 
-    any_changed = do_update(this, cdata, nullptr, false, anim_changed,
-                            current_thread);
+/**
+ * The first half of update() or force_update().  Returns false if the bundle
+ * does not need to be updated at all; otherwise, computes the new values of
+ * the parts that have changed, and returns true to indicate that
+ * finish_update() should be called to apply them.
+ *
+ * This only modifies the parts of this bundle, so it may be called for
+ * several different bundles at once from different threads.  See
+ * update_bundles().
+ */
+bool PartBundle::
+begin_update(bool force, Thread *current_thread) {
+  CDWriter cdata(_cycler, false, current_thread);
 
-    // Now update all the controls for next time.
-    ChannelBlend::const_iterator cbi;
-    for (cbi = cdata->_blend.begin(); cbi != cdata->_blend.end(); ++cbi) {
-      AnimControl *control = (*cbi).first;
-      control->mark_channels(frame_blend_flag);
+  if (!force) {
+    double now = ClockObject::get_global_clock()->get_frame_time(current_thread);
+    if (now <= cdata->_last_update + _update_delay && !cdata->_anim_changed) {
+      return false;
     }
-
-    cdata->_anim_changed = false;
-    cdata->_last_update = now;
   }
 
-  return any_changed;
+  if (part_bundle_update_plan) {
+    if (_update_plan == nullptr) {
+      _update_plan = new PartBundleUpdatePlan;
+    }
+    if (_update_plan->is_stale() || !_update_plan->matches(cdata->_blend)) {
+      _update_plan->build(this, cdata->_blend);
+    }
+    _update_plan->evaluate(this, cdata->_blend_type, cdata->_frame_blend_flag,
+                           force || cdata->_anim_changed);
+  }
+  return true;
 }
 
 /**
- * Updates all the parts in the bundle to reflect the data for the current
- * frame, whether we believe it needs it or not.
+ * The second half of update() or force_update(), which must be called after
+ * begin_update() returns true.  Applies the new values of the parts to the
+ * nodes and vertex transforms that depend on them.  Returns true if any part
+ * has changed.
  */
 bool PartBundle::
-force_update() {
-  Thread *current_thread = Thread::get_current_thread();
+finish_update(bool force, Thread *current_thread) {
   CDWriter cdata(_cycler, false, current_thread);
-  bool any_changed = do_update(this, cdata, nullptr, true, true, current_thread);
+  bool anim_changed = force || cdata->_anim_changed;
+  bool frame_blend_flag = cdata->_frame_blend_flag;
+
+  bool any_changed;
+  if (_update_plan != nullptr && _update_plan->is_evaluated()) {
+    any_changed = _update_plan->propagate(this, current_thread);
+  } else {
+    any_changed = do_update(this, cdata, nullptr, force, anim_changed,
+                            current_thread);
+  }
 
   // Now update all the controls for next time.
   ChannelBlend::const_iterator cbi;
   for (cbi = cdata->_blend.begin(); cbi != cdata->_blend.end(); ++cbi) {
     AnimControl *control = (*cbi).first;
-    control->mark_channels(cdata->_frame_blend_flag);
+    control->mark_channels(frame_blend_flag);
   }
 
   cdata->_anim_changed = false;
+  if (!force) {
+    cdata->_last_update = ClockObject::get_global_clock()->get_frame_time(current_thread);
+  }
 
   return any_changed;
 }
 
+/**
+ * Calls update() (or force_update(), if force is true) on each of the
+ * indicated bundles.  If num_threads is greater than zero, the new values of
+ * the parts of the different bundles are computed in parallel on up to that
+ * many threads; the results are still applied to the scene graph from the
+ * calling thread.  The same bundle may not appear in the list twice.
+ *
+ * Returns true if any part of any bundle has changed.
+ */
+bool PartBundle::
+update_bundles(const pvector<PartBundle *> &bundles, bool force,
+               int num_threads) {
+  Thread *current_thread = Thread::get_current_thread();
+  size_t num_bundles = bundles.size();
+  pvector<unsigned char> due(num_bundles, 0);
+
+  if (num_threads > 0 && num_bundles > 1 && part_bundle_update_plan) {
+    static PT(AsyncTaskChain) chain =
+      AsyncTaskManager::get_global_ptr()->make_task_chain("anim_update");
+    if (chain->get_num_threads() < num_threads) {
+      chain->set_num_threads(num_threads);
+    }
+
+    // The worker threads must see the same pipeline stage as the caller.
+    int pipeline_stage = current_thread->get_pipeline_stage();
+    chain->parallel_for(num_bundles, [&] (size_t i) {
+      Thread *thread = Thread::get_current_thread();
+      if (thread->get_pipeline_stage() != pipeline_stage) {
+        thread->set_pipeline_stage(pipeline_stage);
+      }
+      due[i] = bundles[i]->begin_update(force, thread);
+    });
+  } else {
+    for (size_t i = 0; i < num_bundles; ++i) {
+      due[i] = bundles[i]->begin_update(force, current_thread);
+    }
+  }
+
+  bool any_changed = false;
+  for (size_t i = 0; i < num_bundles; ++i) {
+    if (due[i] && bundles[i]->finish_update(force, current_thread)) {
+      any_changed = true;
+    }
+  }
+  return any_changed;
+}
+
+/**
+ * The recursive implementation of set_update_subset().
+ */
+void PartBundle::
+r_set_update_subset(PartGroup *group, bool is_included,
+                    const PartSubset &subset, int &num_included) {
+  if (subset.matches_include(group->get_name())) {
+    is_included = true;
+  } else if (subset.matches_exclude(group->get_name())) {
+    is_included = false;
+  }
+
+  if (group->is_of_type(MovingPartBase::get_class_type())) {
+    DCAST(MovingPartBase, group)->set_exclude_from_update(!is_included);
+    if (is_included) {
+      ++num_included;
+    }
+  }
+
+  int num_children = group->get_num_children();
+  for (int i = 0; i < num_children; ++i) {
+    r_set_update_subset(group->get_child(i), is_included, subset, num_included);
+  }
+}
 
 /**
  * Called by the AnimControl whenever it starts an animation.  This is just a
@@ -621,6 +776,9 @@ do_bind_anim(AnimControl *control, AnimBundle *anim,
   control->setup_anim(this, anim, channel_index, bound_joints);
 
   determine_effective_channels(cdata);
+  if (_update_plan != nullptr) {
+    _update_plan->mark_stale();
+  }
 
   return true;
 }
@@ -36,6 +36,7 @@ class Loader;
 class AnimBundle;
 class PartBundleNode;
 class PartBundleNode;
+class PartBundleUpdatePlan;
 class TransformState;
 class AnimPreloadTable;
 
@@ -56,6 +57,7 @@ protected:
 
 PUBLISHED:
   explicit PartBundle(std::string name = "");
+  virtual ~PartBundle();
   virtual PartGroup *make_copy() const;
 
   INLINE CPT(AnimPreloadTable) get_anim_preload() const;
@@ -142,6 +144,9 @@ PUBLISHED:
   bool control_joint(std::string_view joint_name, PandaNode *node);
   bool release_joint(std::string_view joint_name);
 
+  int set_update_subset(const PartSubset &subset);
+  int clear_update_subset();
+
   bool update();
   bool force_update();
 
@@ -152,6 +157,11 @@ public:
   void control_removed(AnimControl *control);
   INLINE void set_update_delay(double delay);
 
+  bool begin_update(bool force, Thread *current_thread);
+  bool finish_update(bool force, Thread *current_thread);
+  static bool update_bundles(const pvector<PartBundle *> &bundles,
+                             bool force = false, int num_threads = 0);
+
   bool do_bind_anim(AnimControl *control, AnimBundle *anim,
                     int hierarchy_match_flags, const PartSubset &subset);
 
@@ -165,6 +175,8 @@ private:
   void do_set_control_effect(AnimControl *control, PN_stdfloat effect, CData *cdata);
   PN_stdfloat do_get_control_effect(AnimControl *control, const CData *cdata) const;
   void clear_and_stop_intersecting(AnimControl *control, CData *cdata);
+  static void r_set_update_subset(PartGroup *group, bool is_included,
+                                  const PartSubset &subset, int &num_included);
 
   COWPT(AnimPreloadTable) _anim_preload;
 
@@ -176,6 +188,10 @@ private:
 
   double _update_delay;
 
+  // A flattened copy of the hierarchy, used by update().  This is created
+  // the first time it is needed.
+  PartBundleUpdatePlan *_update_plan;
+
   // This is the data that must be cycled between pipeline stages.
   class CData : public CycleData {
   public:
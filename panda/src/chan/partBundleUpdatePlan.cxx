@@ -0,0 +1,422 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file partBundleUpdatePlan.cxx
+ * @author rdb
+ * @date 2026-10-17
+ */
+
+#include "partBundleUpdatePlan.h"
+#include "animChannelMatrixXfmTable.h"
+#include "animControl.h"
+#include "movingPartMatrix.h"
+#include "compose_matrix.h"
+#include "config_chan.h"
+
+/**
+ *
+ */
+PartBundleUpdatePlan::
+PartBundleUpdatePlan() :
+  _hierarchy_seq(0),
+  _stale(true),
+  _evaluated(false)
+{
+}
+
+/**
+ * Rebuilds the plan from the current hierarchy of the bundle and the
+ * indicated set of active controls.
+ */
+void PartBundleUpdatePlan::
+build(PartBundle *bundle, const PartBundle::ChannelBlend &blend) {
+  // Read this first, so that we will notice a change made while we are busy.
+  _hierarchy_seq = PartGroup::get_hierarchy_seq();
+
+  _parts.clear();
+  _parents.clear();
+  _flags.clear();
+  _num_channels.clear();
+  _channels.clear();
+  _controls.clear();
+  _effects.clear();
+
+  for (const auto &item : blend) {
+    _controls.push_back(item.first);
+    _effects.push_back(item.second);
+  }
+
+  size_t num_controls = _controls.size();
+  _frames.resize(num_controls);
+  _next_frames.resize(num_controls);
+  _fracs.resize(num_controls);
+  _marked_frames.resize(num_controls);
+  _marked_fracs.resize(num_controls);
+  _check_fracs.resize(num_controls);
+
+  int num_children = bundle->get_num_children();
+  for (int i = 0; i < num_children; ++i) {
+    r_build(bundle->get_child(i), -1);
+  }
+
+  _stale = false;
+  _evaluated = false;
+}
+
+/**
+ * Returns true if the plan was built for the indicated set of active controls
+ * and their effects.
+ */
+bool PartBundleUpdatePlan::
+matches(const PartBundle::ChannelBlend &blend) const {
+  if (blend.size() != _controls.size()) {
+    return false;
+  }
+  size_t c = 0;
+  for (const auto &item : blend) {
+    if (item.first != _controls[c] || item.second != _effects[c]) {
+      return false;
+    }
+    ++c;
+  }
+  return true;
+}
+
+/**
+ * Determines which of the parts need to be updated, and computes their new
+ * values.  This is the part of PartBundle::update() that may be performed in
+ * parallel with other bundles.
+ */
+void PartBundleUpdatePlan::
+evaluate(PartBundle *bundle, PartBundle::BlendType blend_type,
+         bool frame_blend_flag, bool anim_changed) {
+  // First, query each of the controls only once.
+  size_t num_controls = _controls.size();
+  for (size_t c = 0; c < num_controls; ++c) {
+    AnimControl *control = _controls[c];
+    _frames[c] = control->get_frame();
+    _marked_frames[c] = control->get_marked_frame();
+    _marked_fracs[c] = control->get_marked_frac();
+    if (frame_blend_flag) {
+      double frac = control->get_frac();
+      _next_frames[c] = control->get_next_frame();
+      _fracs[c] = (PN_stdfloat)frac;
+      _check_fracs[c] = frac;
+    } else {
+      _next_frames[c] = _frames[c];
+      _fracs[c] = 0.0f;
+      _check_fracs[c] = 0.0;
+    }
+  }
+
+  size_t num_parts = _parts.size();
+  for (size_t pi = 0; pi < num_parts; ++pi) {
+    int &flags = _flags[pi];
+    flags &= ~PF_needs_update;
+    if ((flags & PF_moving) == 0) {
+      continue;
+    }
+
+    MovingPartBase *part = (MovingPartBase *)_parts[pi];
+    if (part->get_exclude_from_update()) {
+      continue;
+    }
+
+    if (anim_changed || check_changed(pi)) {
+      flags |= PF_needs_update;
+
+      if ((flags & PF_xfm_table) != 0 && part->get_forced_channel() == nullptr) {
+        evaluate_matrix(pi, blend_type, frame_blend_flag);
+      } else {
+        part->get_blend_value(bundle);
+      }
+    }
+  }
+
+  _evaluated = true;
+}
+
+/**
+ * Composes the values computed by the last call to evaluate() down the
+ * hierarchy, updating the nodes and vertex transforms that are controlled by
+ * the parts.  Returns true if any part has changed.
+ *
+ * This must be called from the thread that owns the bundle.
+ */
+bool PartBundleUpdatePlan::
+propagate(PartBundle *bundle, Thread *current_thread) {
+  nassertr(_evaluated, false);
+  _evaluated = false;
+
+  bool any_changed = false;
+
+  size_t num_parts = _parts.size();
+  for (size_t pi = 0; pi < num_parts; ++pi) {
+    int parent = _parents[pi];
+    bool parent_changed = (parent >= 0 && (_flags[parent] & PF_changed) != 0);
+
+    int &flags = _flags[pi];
+    bool changed = parent_changed;
+    if ((flags & PF_moving) != 0) {
+      bool needs_update = (flags & PF_needs_update) != 0;
+      if (needs_update || parent_changed) {
+        PartGroup *parent_group = (parent >= 0) ? _parts[parent] : bundle;
+        MovingPartBase *part = (MovingPartBase *)_parts[pi];
+        if (part->update_internals(bundle, parent_group, needs_update,
+                                   parent_changed, current_thread)) {
+          any_changed = true;
+        }
+        changed = true;
+      }
+    }
+
+    if (changed) {
+      flags |= PF_changed;
+    } else {
+      flags &= ~PF_changed;
+    }
+  }
+
+  return any_changed;
+}
+
+/**
+ * Appends the indicated group and its descendants to the plan.
+ */
+void PartBundleUpdatePlan::
+r_build(PartGroup *group, int parent_index) {
+  int index = (int)_parts.size();
+  _parts.push_back(group);
+  _parents.push_back(parent_index);
+
+  int flags = 0;
+  int num_channels = 0;
+  if (group->is_of_type(MovingPartBase::get_class_type())) {
+    flags |= PF_moving;
+    MovingPartBase *part = DCAST(MovingPartBase, group);
+
+    // We can only read the tables directly if we know exactly how the part
+    // and its channels compute their values.
+    bool direct = group->is_exact_type(MovingPartMatrix::get_class_type());
+
+    for (AnimControl *control : _controls) {
+      AnimChannelBase *channel = nullptr;
+      int channel_index = control->get_channel_index();
+      if (channel_index >= 0 && channel_index < part->get_max_bound()) {
+        channel = part->get_bound(channel_index);
+      }
+      _channels.push_back(channel);
+
+      if (channel != nullptr) {
+        ++num_channels;
+        if (!channel->is_exact_type(AnimChannelMatrixXfmTable::get_class_type())) {
+          direct = false;
+        }
+      }
+    }
+    if (direct) {
+      flags |= PF_xfm_table;
+    }
+  } else {
+    _channels.resize(_channels.size() + _controls.size(), nullptr);
+  }
+
+  _flags.push_back(flags);
+  _num_channels.push_back(num_channels);
+
+  int num_children = group->get_num_children();
+  for (int i = 0; i < num_children; ++i) {
+    r_build(group->get_child(i), index);
+  }
+}
+
+/**
+ * Returns true if any of the channels bound to the indicated part has changed
+ * since the controls were last marked.  This is equivalent to the check made
+ * by MovingPartBase::do_update().
+ */
+bool PartBundleUpdatePlan::
+check_changed(size_t pi) const {
+  MovingPartBase *part = (MovingPartBase *)_parts[pi];
+  AnimChannelBase *forced_channel = part->get_forced_channel();
+  if (forced_channel != nullptr) {
+    return forced_channel->has_changed(0, 0.0, 0, 0.0);
+  }
+
+  size_t num_controls = _controls.size();
+  AnimChannelBase *const *channels = _channels.data() + pi * num_controls;
+  for (size_t c = 0; c < num_controls; ++c) {
+    AnimChannelBase *channel = channels[c];
+    if (channel != nullptr) {
+      if (_marked_frames[c] < 0 ||
+          channel->has_changed(_marked_frames[c], _marked_fracs[c],
+                               _frames[c], _check_fracs[c])) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+/**
+ * Computes the new value of a MovingPartMatrix whose channels are all
+ * AnimChannelMatrixXfmTables.  This produces the same result as
+ * MovingPartMatrix::get_blend_value(), but reads the tables directly.
+ */
+void PartBundleUpdatePlan::
+evaluate_matrix(size_t pi, PartBundle::BlendType blend_type,
+                bool frame_blend_flag) {
+  MovingPartMatrix *part = (MovingPartMatrix *)_parts[pi];
+  LMatrix4 &value = part->_value;
+
+  size_t num_controls = _controls.size();
+  AnimChannelBase *const *channels = _channels.data() + pi * num_controls;
+  PN_stdfloat components[num_matrix_components];
+
+  if (_num_channels[pi] == 0) {
+    // No channel is bound; supply the default value.
+    if (restore_initial_pose) {
+      value = part->_default_value;
+    }
+    return;
+  }
+
+  if (_num_channels[pi] == 1 && !frame_blend_flag) {
+    // A single value, the normal case.
+    for (size_t c = 0; c < num_controls; ++c) {
+      if (channels[c] != nullptr) {
+        AnimChannelMatrixXfmTable *channel = (AnimChannelMatrixXfmTable *)channels[c];
+        channel->get_components(_frames[c], components);
+        compose_matrix(value, components);
+        return;
+      }
+    }
+  }
+
+  // A blend of two or more values.  Each control contributes either one
+  // frame, or two successive frames if frame blending is enabled.
+  LMatrix4 net_value = LMatrix4::zeros_mat();
+  LVecBase3 scale(0.0f, 0.0f, 0.0f);
+  LVecBase3 shear(0.0f, 0.0f, 0.0f);
+  LVecBase3 hpr(0.0f, 0.0f, 0.0f);
+  LVecBase3 pos(0.0f, 0.0f, 0.0f);
+  LQuaternion quat(0.0f, 0.0f, 0.0f, 0.0f);
+  PN_stdfloat net_effect = 0.0f;
+
+  for (size_t c = 0; c < num_controls; ++c) {
+    AnimChannelMatrixXfmTable *channel = (AnimChannelMatrixXfmTable *)channels[c];
+    if (channel == nullptr) {
+      continue;
+    }
+
+    PN_stdfloat effect = _effects[c];
+    int num_samples = frame_blend_flag ? 2 : 1;
+    for (int s = 0; s < num_samples; ++s) {
+      int frame;
+      PN_stdfloat e;
+      if (!frame_blend_flag) {
+        frame = _frames[c];
+        e = effect;
+      } else if (s == 0) {
+        frame = _frames[c];
+        e = effect * (1.0f - _fracs[c]);
+      } else {
+        frame = _next_frames[c];
+        e = effect * _fracs[c];
+      }
+
+      channel->get_components(frame, components);
+      LVecBase3 iscale(components[0], components[1], components[2]);
+      LVecBase3 ishear(components[3], components[4], components[5]);
+      LVecBase3 ihpr(components[6], components[7], components[8]);
+      LVecBase3 ipos(components[9], components[10], components[11]);
+
+      switch (blend_type) {
+      case PartBundle::BT_linear:
+        {
+          LMatrix4 v;
+          compose_matrix(v, components);
+          net_value += v * e;
+        }
+        break;
+
+      case PartBundle::BT_normalized_linear:
+        {
+          LMatrix4 v;
+          compose_matrix(v, LVecBase3(1.0f, 1.0f, 1.0f),
+                         LVecBase3(0.0f, 0.0f, 0.0f), ihpr, ipos);
+          net_value += v * e;
+          scale += iscale * e;
+          shear += ishear * e;
+        }
+        break;
+
+      case PartBundle::BT_componentwise:
+        scale += iscale * e;
+        hpr += ihpr * e;
+        pos += ipos * e;
+        shear += ishear * e;
+        break;
+
+      case PartBundle::BT_componentwise_quat:
+        {
+          LQuaternion iquat;
+          iquat.set_hpr(ihpr);
+          scale += iscale * e;
+          quat += iquat * e;
+          pos += ipos * e;
+          shear += ishear * e;
+        }
+        break;
+      }
+    }
+    net_effect += effect;
+  }
+
+  if (net_effect == 0.0f) {
+    if (restore_initial_pose) {
+      value = part->_default_value;
+    }
+    return;
+  }
+
+  switch (blend_type) {
+  case PartBundle::BT_linear:
+    value = net_value / net_effect;
+    break;
+
+  case PartBundle::BT_normalized_linear:
+    {
+      net_value /= net_effect;
+      scale /= net_effect;
+      shear /= net_effect;
+
+      LVector3 false_scale, false_shear, net_hpr, translate;
+      decompose_matrix(net_value, false_scale, false_shear, net_hpr, translate);
+      compose_matrix(value, scale, shear, net_hpr, translate);
+    }
+    break;
+
+  case PartBundle::BT_componentwise:
+    scale /= net_effect;
+    hpr /= net_effect;
+    pos /= net_effect;
+    shear /= net_effect;
+    compose_matrix(value, scale, shear, hpr, pos);
+    break;
+
+  case PartBundle::BT_componentwise_quat:
+    scale /= net_effect;
+    quat /= net_effect;
+    pos /= net_effect;
+    shear /= net_effect;
+    value = LMatrix4::scale_shear_mat(scale, shear) * quat;
+    value.set_row(3, pos);
+    break;
+  }
+}
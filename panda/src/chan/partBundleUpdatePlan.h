@@ -0,0 +1,114 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file partBundleUpdatePlan.h
+ * @author rdb
+ * @date 2026-10-17
+ */
+
+#ifndef PARTBUNDLEUPDATEPLAN_H
+#define PARTBUNDLEUPDATEPLAN_H
+
+#include "pandabase.h"
+#include "partBundle.h"
+#include "pvector.h"
+
+class AnimChannelBase;
+class AnimChannelMatrixXfmTable;
+class AnimControl;
+class MovingPartBase;
+class MovingPartMatrix;
+
+/**
+ * A flattened form of the hierarchy of a PartBundle, and of the channels
+ * bound to each of its parts, which PartBundle::update() uses to bring all of
+ * the parts up-to-date in a single pass over a few flat arrays, rather than
+ * by recursing through the PartGroup hierarchy.
+ *
+ * The update is done in two steps.  evaluate() determines which parts have
+ * changed and computes their new values; it touches only the parts of this
+ * bundle and the channels bound to it, so the bundles of several characters
+ * may be evaluated in parallel.  propagate() then composes the values down
+ * the hierarchy and notifies the nodes and vertex transforms that depend on
+ * them, which must be done from a single thread.
+ *
+ * The joints of the common AnimChannelMatrixXfmTable type are evaluated by
+ * reading the tables directly, and the frame numbers of each AnimControl are
+ * only computed once per update rather than once per joint.  Other kinds of
+ * parts and channels fall back to MovingPartBase::get_blend_value().
+ *
+ * The plan must be rebuilt whenever the hierarchy, the bound animations or
+ * the set of active controls changes.
+ */
+class EXPCL_PANDA_CHAN PartBundleUpdatePlan {
+public:
+  PartBundleUpdatePlan();
+
+  INLINE bool is_stale() const;
+  bool matches(const PartBundle::ChannelBlend &blend) const;
+  INLINE void mark_stale();
+  INLINE bool is_evaluated() const;
+  INLINE size_t get_num_parts() const;
+
+  void build(PartBundle *bundle, const PartBundle::ChannelBlend &blend);
+  void evaluate(PartBundle *bundle, PartBundle::BlendType blend_type,
+                bool frame_blend_flag, bool anim_changed);
+  bool propagate(PartBundle *bundle, Thread *current_thread);
+
+private:
+  void r_build(PartGroup *group, int parent_index);
+  bool check_changed(size_t pi) const;
+  void evaluate_matrix(size_t pi, PartBundle::BlendType blend_type,
+                       bool frame_blend_flag);
+
+  enum PartFlags {
+    // The part is a MovingPartBase.
+    PF_moving       = 0x01,
+
+    // The part is a MovingPartMatrix whose bound channels are all of type
+    // AnimChannelMatrixXfmTable, so it may be evaluated directly.
+    PF_xfm_table    = 0x02,
+
+    // The value of the part has been recomputed by evaluate().
+    PF_needs_update = 0x04,
+
+    // The part or one of its ancestors changed in the last propagate().
+    PF_changed      = 0x08,
+  };
+
+  // These arrays are all indexed by the index of the part, in depth-first
+  // order.  The parents always come before their children.
+  pvector<PartGroup *> _parts;
+  pvector<int> _parents;
+  pvector<int> _flags;
+  pvector<int> _num_channels;
+
+  // The channel bound to each part for each of the controls, indexed by
+  // part * num_controls + control.  NULL if the part isn't bound.
+  pvector<AnimChannelBase *> _channels;
+
+  // These are indexed by control.
+  pvector<AnimControl *> _controls;
+  pvector<PN_stdfloat> _effects;
+
+  // These are filled in by evaluate(), also indexed by control.
+  pvector<int> _frames;
+  pvector<int> _next_frames;
+  pvector<PN_stdfloat> _fracs;
+  pvector<int> _marked_frames;
+  pvector<double> _marked_fracs;
+  pvector<double> _check_fracs;
+
+  unsigned int _hierarchy_seq;
+  bool _stale;
+  bool _evaluated;
+};
+
+#include "partBundleUpdatePlan.I"
+
+#endif
@@ -29,6 +29,8 @@ using std::ostream;
 
 TypeHandle PartGroup::_type_handle;
 
+patomic<unsigned int> PartGroup::_hierarchy_seq(0);
+
 /**
  * Creates the PartGroup, and adds it to the indicated parent.  The only way
  * to delete it subsequently is to delete the entire hierarchy.
@@ -41,6 +43,7 @@ PartGroup(PartGroup *parent, std::string name) :
   nassertv(parent != nullptr);
 
   parent->_children.push_back(this);
+  mark_hierarchy_changed();
 }
 
 /**
@@ -85,6 +88,7 @@ copy_subgraph() const {
     PartGroup *child = (*ci)->copy_subgraph();
     root->_children.push_back(child);
   }
+  mark_hierarchy_changed();
 
   return root;
 }
@@ -162,6 +166,7 @@ public:
 void PartGroup::
 sort_descendants() {
   std::stable_sort(_children.begin(), _children.end(), PartGroupAlphabeticalOrder());
+  mark_hierarchy_changed();
 
   Children::iterator ci;
   for (ci = _children.begin(); ci != _children.end(); ++ci) {
@@ -666,6 +671,7 @@ complete_pointers(TypedWritable **p_list, BamReader *manager) {
   for (ci = _children.begin(); ci != _children.end(); ++ci) {
     (*ci) = DCAST(PartGroup, p_list[pi++]);
   }
+  mark_hierarchy_changed();
 
   return pi;
 }
@@ -22,6 +22,7 @@
 #include "thread.h"
 #include "plist.h"
 #include "luse.h"
+#include "patomic.h"
 
 class AnimControl;
 class AnimGroup;
@@ -93,6 +94,9 @@ public:
                        const PartGroup *parent,
                        int hierarchy_match_flags = 0) const;
 
+  INLINE static unsigned int get_hierarchy_seq();
+  INLINE static void mark_hierarchy_changed();
+
   virtual bool do_update(PartBundle *root, const CycleData *root_cdata,
                          PartGroup *parent, bool parent_changed,
                          bool anim_changed, Thread *current_thread);
@@ -115,6 +119,9 @@ protected:
   typedef pvector< PT(PartGroup) > Children;
   Children _children;
 
+  // This is incremented whenever the children of any PartGroup change.
+  static patomic<unsigned int> _hierarchy_seq;
+
 public:
   static void register_with_read_factory();
   virtual void write_datagram(BamWriter* manager, Datagram &me);
@@ -13,6 +13,7 @@
 
 #include "character.h"
 #include "characterJoint.h"
+#include "characterLodManager.h"
 #include "config_char.h"
 #include "nodePath.h"
 #include "geomNode.h"
@@ -27,6 +28,8 @@
 #include "camera.h"
 #include "cullTraverser.h"
 #include "cullTraverserData.h"
+#include "boundingSphere.h"
+#include "lens.h"
 
 TypeHandle Character::_type_handle;
 
@@ -46,6 +49,14 @@ Character(const Character &copy, bool copy_bundles) :
   _lod_near_distance(copy._lod_near_distance),
   _lod_delay_factor(copy._lod_delay_factor),
   _do_lod_animation(copy._do_lod_animation),
+  _lod_manager(nullptr),
+  _lod_screen_size(0.0f),
+  _lod_seen_frame(-1),
+  _lod_handled_frame(-1),
+  _lod_level(-1),
+  _lod_num_joints(0),
+  _lod_wait_frames(0),
+  _lod_last_update(-1.0),
   _joints_pcollector(copy._joints_pcollector),
   _skinning_pcollector(copy._skinning_pcollector)
 {
@@ -78,6 +89,14 @@ Character(std::string_view name) :
   _last_auto_update(-1.0),
   _view_frame(-1),
   _view_distance2(0.0f),
+  _lod_manager(nullptr),
+  _lod_screen_size(0.0f),
+  _lod_seen_frame(-1),
+  _lod_handled_frame(-1),
+  _lod_level(-1),
+  _lod_num_joints(0),
+  _lod_wait_frames(0),
+  _lod_last_update(-1.0),
   _joints_pcollector(PStatCollector(_animation_pcollector, name), "Joints"),
   _skinning_pcollector(PStatCollector(_animation_pcollector, name), "Vertices")
 {
@@ -90,6 +109,10 @@ Character(std::string_view name) :
  */
 Character::
 ~Character() {
+  if (_lod_manager != nullptr) {
+    _lod_manager->remove_character(this);
+  }
+
   LightMutexHolder holder(_lock);
   for (PartBundleHandle *handle : _bundles) {
     r_clear_joint_characters(handle->get_bundle());
@@ -197,6 +220,13 @@ cull_callback(CullTraverser *trav, CullTraverserData &data) {
     }
   }
 
+  if (_lod_manager != nullptr &&
+      record_lod_view(calc_screen_size(trav, data))) {
+    // The CharacterLodManager has already decided whether we should be
+    // animated this frame.
+    return true;
+  }
+
   update();
   return true;
 }
@@ -535,6 +565,96 @@ get_rel_transform(CullTraverser *trav, CullTraverserData &data) {
   return rel_transform;
 }
 
+/**
+ * Returns the fraction of the height of the screen covered by the bounding
+ * volume of this character, as seen by the current camera.
+ */
+PN_stdfloat Character::
+calc_screen_size(CullTraverser *trav, CullTraverserData &data) {
+  const Lens *lens = trav->get_scene()->get_lens();
+  CPT(BoundingVolume) bounds = data.node_reader()->get_bounds();
+  if (lens == nullptr || bounds->is_empty()) {
+    return 0.0f;
+  }
+  if (bounds->is_infinite()) {
+    return 1.0f;
+  }
+
+  LPoint3 center;
+  PN_stdfloat radius;
+  const BoundingSphere *sphere = bounds->as_bounding_sphere();
+  if (sphere != nullptr) {
+    center = sphere->get_center();
+    radius = sphere->get_radius();
+  } else {
+    const FiniteBoundingVolume *fbv = bounds->as_finite_bounding_volume();
+    if (fbv == nullptr) {
+      return 1.0f;
+    }
+    center = (fbv->get_min() + fbv->get_max()) * 0.5f;
+    radius = (fbv->get_max() - fbv->get_min()).length() * 0.5f;
+  }
+
+  CPT(TransformState) modelview = data.get_modelview_transform(trav);
+  const LMatrix4 &mat = modelview->get_mat();
+  center = center * mat;
+  radius *= std::max(mat.get_row3(0).length(),
+                     std::max(mat.get_row3(1).length(), mat.get_row3(2).length()));
+
+  if (lens->is_orthographic()) {
+    return radius * 2.0f / lens->get_film_size()[1];
+  }
+
+  PN_stdfloat dist = std::max(center.length(), radius);
+  PN_stdfloat tan_fov = ctan(deg_2_rad(lens->get_fov()[1] * 0.5f));
+  if (dist <= 0.0f || tan_fov <= 0.0f) {
+    return 1.0f;
+  }
+  return radius / (dist * tan_fov);
+}
+
+/**
+ * Called by cull_callback() to inform the CharacterLodManager that the
+ * character has been seen by a camera, covering the indicated fraction of the
+ * screen height.  Returns true if the manager has already handled the
+ * character this frame, or false if the character should still be updated
+ * by the caller.
+ *
+ * This may also be called by an application that determines the visibility
+ * of its characters by other means.
+ */
+bool Character::
+record_lod_view(PN_stdfloat screen_size) {
+  int this_frame = ClockObject::get_global_clock()->get_frame_count();
+
+  LightMutexHolder holder(_lock);
+  if (_lod_seen_frame != this_frame || screen_size > _lod_screen_size) {
+    _lod_screen_size = screen_size;
+  }
+  _lod_seen_frame = this_frame;
+  return _lod_handled_frame == this_frame;
+}
+
+/**
+ * Restricts the joints that are updated in all of our bundles to the
+ * indicated subset, or updates all of the joints if it is NULL.  Returns the
+ * number of joints that will be updated.
+ */
+int Character::
+set_lod_subset(const PartSubset *subset) {
+  LightMutexHolder holder(_lock);
+  int num_joints = 0;
+  for (PartBundleHandle *handle : _bundles) {
+    PartBundle *bundle = handle->get_bundle();
+    if (subset != nullptr) {
+      num_joints += bundle->set_update_subset(*subset);
+    } else {
+      num_joints += bundle->clear_update_subset();
+    }
+  }
+  return num_joints;
+}
+
 /**
  * The actual implementation of update().  Assumes the appropriate
  * PStatCollector has already been started, and that the lock is held.
@@ -707,6 +827,7 @@ r_merge_bundles(Character::JointMap &joint_map,
   }
 
   new_group->_children.swap(new_children);
+  PartGroup::mark_hierarchy_changed();
 }
 
 /**
@@ -30,6 +30,7 @@
 #include "sliderTable.h"
 
 class CharacterJointBundle;
+class CharacterLodManager;
 
 /**
  * An animated character, with skeleton-morph animation and either soft-
@@ -67,6 +68,11 @@ PUBLISHED:
                          PN_stdfloat delay_factor);
   void clear_lod_animation();
 
+  INLINE CharacterLodManager *get_lod_manager() const;
+  INLINE int get_lod_level() const;
+  INLINE PN_stdfloat get_lod_screen_size() const;
+  bool record_lod_view(PN_stdfloat screen_size);
+
   CharacterJoint *find_joint(std::string_view name) const;
   CharacterSlider *find_slider(std::string_view name) const;
 
@@ -83,10 +89,12 @@ protected:
   virtual void update_bundle(PartBundleHandle *old_bundle_handle,
                              PartBundle *new_bundle);
   CPT(TransformState) get_rel_transform(CullTraverser *trav, CullTraverserData &data);
+  PN_stdfloat calc_screen_size(CullTraverser *trav, CullTraverserData &data);
 
 private:
   void do_update();
   void set_lod_current_delay(double delay);
+  int set_lod_subset(const PartSubset *subset);
 
   typedef pmap<const PandaNode *, PandaNode *> NodeMap;
   typedef pmap<const PartGroup *, PartGroup *> JointMap;
@@ -140,6 +148,16 @@ private:
   PN_stdfloat _lod_delay_factor;
   bool _do_lod_animation;
 
+  // These are maintained by the CharacterLodManager, if any.
+  CharacterLodManager *_lod_manager;
+  PN_stdfloat _lod_screen_size;
+  int _lod_seen_frame;
+  int _lod_handled_frame;
+  int _lod_level;
+  int _lod_num_joints;
+  int _lod_wait_frames;
+  double _lod_last_update;
+
   // Statistics
   PStatCollector _joints_pcollector;
   PStatCollector _skinning_pcollector;
@@ -174,6 +192,8 @@ public:
 
 private:
   static TypeHandle _type_handle;
+
+  friend class CharacterLodManager;
 };
 
 #include "character.I"
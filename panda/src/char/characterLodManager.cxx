@@ -0,0 +1,326 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file characterLodManager.cxx
+ * @author rdb
+ * @date 2026-10-17
+ */
+
+#include "characterLodManager.h"
+#include "character.h"
+#include "config_char.h"
+#include "clockObject.h"
+#include "pStatTimer.h"
+
+#include <algorithm>
+
+TypeHandle CharacterLodManager::_type_handle;
+
+PStatCollector CharacterLodManager::_update_pcollector("App:Animation:LOD");
+
+/**
+ * Creates a manager with no levels.  Until levels are added, all of the
+ * characters it manages are animated every frame, subject only to the joint
+ * budget.
+ */
+CharacterLodManager::
+CharacterLodManager() :
+  _joint_budget(0),
+  _num_threads(0),
+  _num_updated_characters(0),
+  _num_updated_joints(0),
+  _num_deferred_characters(0)
+{
+}
+
+/**
+ * Releases all of the characters, which then go back to being animated by
+ * the cull traversal.
+ */
+CharacterLodManager::
+~CharacterLodManager() {
+  for (const WPT(Character) &ref : _characters) {
+    PT(Character) character = ref.lock();
+    if (character != nullptr) {
+      character->_lod_manager = nullptr;
+      character->set_lod_subset(nullptr);
+    }
+  }
+}
+
+/**
+ * Adds a new level, which applies to the characters whose projected height
+ * is at least min_screen_size times the height of the screen, but which do
+ * not fit in a level with a larger min_screen_size.  Characters smaller than
+ * every level are assigned to the level with the smallest min_screen_size.
+ *
+ * The characters at this level are animated at most once every update_delay
+ * seconds.  If the subset is not empty, only the joints in the subset are
+ * evaluated; the other joints hold their last pose.  See
+ * PartBundle::set_update_subset().
+ *
+ * Returns the index of the new level.  The levels are kept sorted from the
+ * largest min_screen_size to the smallest, so this index may change when
+ * more levels are added.
+ */
+int CharacterLodManager::
+add_level(PN_stdfloat min_screen_size, double update_delay,
+          const PartSubset &subset) {
+  LightMutexHolder holder(_lock);
+  Level level;
+  level._min_screen_size = min_screen_size;
+  level._update_delay = update_delay;
+  level._subset = subset;
+  level._rigid = false;
+
+  size_t n = 0;
+  while (n < _levels.size() && _levels[n]._min_screen_size >= min_screen_size) {
+    ++n;
+  }
+  _levels.insert(_levels.begin() + n, std::move(level));
+  return (int)n;
+}
+
+/**
+ * Specifies that the characters at the nth level should not be animated at
+ * all, but hold whichever pose they had when they entered this level.  This
+ * is intended for the farthest level, at which characters are little more
+ * than a few pixels high.
+ */
+void CharacterLodManager::
+set_level_rigid(int n, bool rigid) {
+  LightMutexHolder holder(_lock);
+  nassertv(n >= 0 && n < (int)_levels.size());
+  _levels[n]._rigid = rigid;
+}
+
+/**
+ * Removes all of the levels added by add_level().
+ */
+void CharacterLodManager::
+clear_levels() {
+  LightMutexHolder holder(_lock);
+  _levels.clear();
+}
+
+/**
+ * Adds the indicated character to the set of characters managed by this
+ * object.  A character may only be managed by one CharacterLodManager at a
+ * time.  The manager does not keep the character alive.
+ */
+void CharacterLodManager::
+add_character(Character *character) {
+  nassertv(character != nullptr);
+  if (character->_lod_manager == this) {
+    return;
+  }
+  if (character->_lod_manager != nullptr) {
+    character->_lod_manager->remove_character(character);
+  }
+
+  LightMutexHolder holder(_lock);
+  character->_lod_manager = this;
+  character->_lod_level = -1;
+  character->_lod_handled_frame = -1;
+  character->_lod_last_update = -1.0;
+  character->_lod_wait_frames = 0;
+  character->_lod_num_joints = character->set_lod_subset(nullptr);
+  _characters.push_back(character);
+}
+
+/**
+ * Removes the indicated character from the set of characters managed by this
+ * object.  It will henceforth be animated by the cull traversal again, with
+ * all of its joints.  Returns true if the character was removed, false if it
+ * was not being managed by this object.
+ */
+bool CharacterLodManager::
+remove_character(Character *character) {
+  nassertr(character != nullptr, false);
+  LightMutexHolder holder(_lock);
+  Characters::iterator ci = _characters.begin();
+  while (ci != _characters.end() && (*ci).get_orig() != character) {
+    ++ci;
+  }
+  if (ci == _characters.end()) {
+    return false;
+  }
+
+  _characters.erase(ci);
+  character->_lod_manager = nullptr;
+  character->_lod_level = -1;
+  character->set_lod_subset(nullptr);
+  return true;
+}
+
+/**
+ * Returns the number of characters currently managed by this object.
+ */
+int CharacterLodManager::
+get_num_characters() const {
+  LightMutexHolder holder(_lock);
+  int num_characters = 0;
+  for (const WPT(Character) &ref : _characters) {
+    if (!ref.was_deleted()) {
+      ++num_characters;
+    }
+  }
+  return num_characters;
+}
+
+/**
+ * Returns the index of the level to which a character covering the indicated
+ * fraction of the screen height would be assigned, or -1 if there are no
+ * levels.
+ */
+int CharacterLodManager::
+get_level_for_screen_size(PN_stdfloat screen_size) const {
+  LightMutexHolder holder(_lock);
+  return do_get_level_for_screen_size(screen_size);
+}
+
+/**
+ * The implementation of get_level_for_screen_size().  Assumes the lock is
+ * held.
+ */
+int CharacterLodManager::
+do_get_level_for_screen_size(PN_stdfloat screen_size) const {
+  int num_levels = (int)_levels.size();
+  for (int i = 0; i < num_levels; ++i) {
+    if (screen_size >= _levels[i]._min_screen_size) {
+      return i;
+    }
+  }
+  return num_levels - 1;
+}
+
+/**
+ * Assigns the characters that were seen in the previous frame to their
+ * levels, and animates the ones that are due, in order of importance, until
+ * the joint budget is used up.  This should be called once per frame, before
+ * the scene is rendered.
+ */
+void CharacterLodManager::
+update() {
+  PStatTimer timer(_update_pcollector);
+  Thread *current_thread = Thread::get_current_thread();
+  ClockObject *clock = ClockObject::get_global_clock();
+  int frame = clock->get_frame_count(current_thread);
+  double now = clock->get_frame_time(current_thread);
+
+  LightMutexHolder holder(_lock);
+
+  // These are the characters that are due to be animated this frame.
+  struct Candidate {
+    PT(Character) _character;
+    PN_stdfloat _priority;
+    int _num_joints;
+  };
+  pvector<Candidate> candidates;
+
+  Characters::iterator ci = _characters.begin();
+  while (ci != _characters.end()) {
+    PT(Character) character = (*ci).lock();
+    if (character == nullptr) {
+      ci = _characters.erase(ci);
+      continue;
+    }
+    ++ci;
+
+    PN_stdfloat screen_size;
+    {
+      LightMutexHolder char_holder(character->_lock);
+      if (character->_lod_seen_frame < 0 ||
+          character->_lod_seen_frame < frame - 1) {
+        // It wasn't visible last frame, so we leave it to the cull traversal
+        // to animate it, should it come into view.
+        continue;
+      }
+      character->_lod_handled_frame = frame;
+      screen_size = character->_lod_screen_size;
+    }
+
+    int level = do_get_level_for_screen_size(screen_size);
+    if (level != character->_lod_level) {
+      apply_level(character, level);
+    }
+
+    double delay = 0.0;
+    if (level >= 0) {
+      if (_levels[level]._rigid) {
+        continue;
+      }
+      delay = _levels[level]._update_delay;
+    }
+    if (character->_lod_last_update >= 0.0 &&
+        now < character->_lod_last_update + delay) {
+      continue;
+    }
+
+    // The longer a character has been kept waiting, the more likely it is
+    // to be picked this time.
+    Candidate candidate;
+    candidate._priority = screen_size * (PN_stdfloat)(1 + character->_lod_wait_frames);
+    candidate._num_joints = character->_lod_num_joints;
+    candidate._character = std::move(character);
+    candidates.push_back(std::move(candidate));
+  }
+
+  std::stable_sort(candidates.begin(), candidates.end(),
+    [] (const Candidate &a, const Candidate &b) {
+      return a._priority > b._priority;
+    });
+
+  _num_updated_characters = 0;
+  _num_updated_joints = 0;
+  _num_deferred_characters = 0;
+
+  pvector<PartBundle *> bundles;
+  for (Candidate &candidate : candidates) {
+    Character *character = candidate._character;
+    if (_joint_budget > 0 && _num_updated_joints > 0 &&
+        _num_updated_joints + candidate._num_joints > _joint_budget) {
+      ++character->_lod_wait_frames;
+      ++_num_deferred_characters;
+      continue;
+    }
+
+    LightMutexHolder char_holder(character->_lock);
+    character->_lod_wait_frames = 0;
+    character->_lod_last_update = now;
+    character->_last_auto_update = now;
+    for (PartBundleHandle *handle : character->_bundles) {
+      bundles.push_back(handle->get_bundle());
+    }
+    ++_num_updated_characters;
+    _num_updated_joints += candidate._num_joints;
+  }
+
+  if (char_cat.is_spam()) {
+    char_cat.spam()
+      << "Animating " << _num_updated_characters << " characters with "
+      << _num_updated_joints << " joints, deferring "
+      << _num_deferred_characters << "\n";
+  }
+
+  PartBundle::update_bundles(bundles, false, _num_threads);
+}
+
+/**
+ * Applies the settings of the indicated level to the character.  Assumes the
+ * lock is held.
+ */
+void CharacterLodManager::
+apply_level(Character *character, int level) {
+  const PartSubset *subset = nullptr;
+  if (level >= 0) {
+    subset = &_levels[level]._subset;
+  }
+  character->_lod_level = level;
+  character->_lod_num_joints = character->set_lod_subset(subset);
+}
@@ -0,0 +1,127 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file characterLodManager.h
+ * @author rdb
+ * @date 2026-10-17
+ */
+
+#ifndef CHARACTERLODMANAGER_H
+#define CHARACTERLODMANAGER_H
+
+#include "pandabase.h"
+
+#include "typedReferenceCount.h"
+#include "partSubset.h"
+#include "weakPointerTo.h"
+#include "lightMutex.h"
+#include "lightMutexHolder.h"
+#include "pvector.h"
+#include "pStatCollector.h"
+
+class Character;
+
+/**
+ * Manages the animation level of detail of a whole crowd of Characters at
+ * once.  Each frame, the characters that were seen by a camera in the
+ * previous frame are sorted into levels according to the fraction of the
+ * screen they cover, and each level determines how often the character is
+ * animated and which of its joints are evaluated.  A global budget limits the
+ * total number of joints evaluated per frame; characters that don't fit are
+ * deferred to a later frame, the smallest ones first.
+ *
+ * Call update() once per frame, before rendering, for instance from a task.
+ * The characters that the manager has looked at in a given frame are no
+ * longer updated by the cull traversal; characters that come into view
+ * without having been seen in the previous frame are still updated by the
+ * cull traversal as usual.
+ */
+class EXPCL_PANDA_CHAR CharacterLodManager : public TypedReferenceCount {
+PUBLISHED:
+  CharacterLodManager();
+  virtual ~CharacterLodManager();
+
+  int add_level(PN_stdfloat min_screen_size, double update_delay,
+                const PartSubset &subset = PartSubset());
+  void set_level_rigid(int n, bool rigid);
+  void clear_levels();
+  INLINE int get_num_levels() const;
+  INLINE PN_stdfloat get_level_min_screen_size(int n) const;
+  INLINE double get_level_update_delay(int n) const;
+  INLINE bool is_level_rigid(int n) const;
+
+  INLINE void set_joint_budget(int budget);
+  INLINE int get_joint_budget() const;
+  INLINE void set_num_threads(int num_threads);
+  INLINE int get_num_threads() const;
+
+  void add_character(Character *character);
+  bool remove_character(Character *character);
+  int get_num_characters() const;
+
+  int get_level_for_screen_size(PN_stdfloat screen_size) const;
+
+  void update();
+
+  INLINE int get_num_updated_characters() const;
+  INLINE int get_num_updated_joints() const;
+  INLINE int get_num_deferred_characters() const;
+
+  MAKE_PROPERTY(joint_budget, get_joint_budget, set_joint_budget);
+  MAKE_PROPERTY(num_threads, get_num_threads, set_num_threads);
+  MAKE_PROPERTY(num_characters, get_num_characters);
+
+private:
+  int do_get_level_for_screen_size(PN_stdfloat screen_size) const;
+  void apply_level(Character *character, int level);
+
+  class Level {
+  public:
+    PN_stdfloat _min_screen_size;
+    double _update_delay;
+    PartSubset _subset;
+    bool _rigid;
+  };
+  typedef pvector<Level> Levels;
+  Levels _levels;
+
+  typedef pvector<WPT(Character)> Characters;
+  Characters _characters;
+
+  int _joint_budget;
+  int _num_threads;
+
+  int _num_updated_characters;
+  int _num_updated_joints;
+  int _num_deferred_characters;
+
+  mutable LightMutex _lock;
+
+  static PStatCollector _update_pcollector;
+
+public:
+  static TypeHandle get_class_type() {
+    return _type_handle;
+  }
+  static void init_type() {
+    TypedReferenceCount::init_type();
+    register_type(_type_handle, "CharacterLodManager",
+                  TypedReferenceCount::get_class_type());
+  }
+  virtual TypeHandle get_type() const {
+    return get_class_type();
+  }
+  virtual TypeHandle force_init_type() {init_type(); return get_class_type();}
+
+private:
+  static TypeHandle _type_handle;
+};
+
+#include "characterLodManager.I"
+
+#endif
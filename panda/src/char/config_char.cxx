@@ -16,6 +16,7 @@
 #include "characterJoint.h"
 #include "characterJointBundle.h"
 #include "characterJointEffect.h"
+#include "characterLodManager.h"
 #include "characterSlider.h"
 #include "characterVertexSlider.h"
 #include "jointVertexTransform.h"
@@ -59,6 +60,7 @@ init_libchar() {
   CharacterJoint::init_type();
   CharacterJointBundle::init_type();
   CharacterJointEffect::init_type();
+  CharacterLodManager::init_type();
   CharacterSlider::init_type();
   CharacterVertexSlider::init_type();
   JointVertexTransform::init_type();
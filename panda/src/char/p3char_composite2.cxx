@@ -1,4 +1,5 @@
 #include "characterJointEffect.cxx"
+#include "characterLodManager.cxx"
 #include "characterSlider.cxx"
 #include "characterVertexSlider.cxx"
 #include "jointVertexTransform.cxx"
@@ -0,0 +1,359 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file collisionBVH.cxx
+ * @author rdb
+ * @date 2026-10-17
+ */
+
+#include "collisionBVH.h"
+#include "geometricBoundingVolume.h"
+#include "finiteBoundingVolume.h"
+#include "boundingLine.h"
+#include "pStatTimer.h"
+
+#include <algorithm>
+
+// The number of bins used to evaluate the surface area heuristic along each
+// axis.
+static const int num_sah_bins = 16;
+
+// Nodes with this many items or fewer are always made into leaves.
+static const size_t min_leaf_items = 2;
+
+// Beyond this depth, nodes are split at the median rather than by the
+// surface area heuristic, so that the depth of the tree stays bounded.
+static const int max_sah_depth = 64;
+
+// The query stack must be able to hold the deepest possible path through the
+// tree.  Median splits add at most one level per bit of the item count.
+static const int max_stack_depth = max_sah_depth + 64;
+
+PStatCollector CollisionBVH::_build_pcollector("App:Collisions:Build BVH");
+PStatCollector CollisionBVH::_volume_pcollector("Collision Volumes:BVH");
+
+/**
+ * Adds a new item with the indicated bounding box.  The item is identified by
+ * the number of items that were added before it.  build() must be called
+ * after all items have been added.
+ */
+void CollisionBVH::
+add_item(const LPoint3 &min, const LPoint3 &max) {
+  Item item;
+  item._min = min;
+  item._max = max;
+  item._center = (min + max) * (PN_stdfloat)0.5;
+  item._number = (int)_num_items++;
+  _items.push_back(item);
+}
+
+/**
+ * Adds a new item that has no finite bounding box, such as an infinite
+ * plane.  Such an item will be reported by every query.
+ */
+void CollisionBVH::
+add_unbounded_item() {
+  _unbounded.push_back((int)_num_items++);
+}
+
+/**
+ * Builds the hierarchy from the items added by add_item().
+ */
+void CollisionBVH::
+build() {
+  PStatTimer timer(_build_pcollector);
+
+  _nodes.clear();
+  _indices.clear();
+
+  if (!_items.empty()) {
+    // A binary tree with n leaves never has more than 2n - 1 nodes.
+    _nodes.reserve(_items.size() * 2 - 1);
+    _nodes.push_back(Node());
+    r_build(0, 0, _items.size(), 0);
+
+    // r_build() reordered the items into leaf order; we only need to keep
+    // the item numbers.
+    _indices.reserve(_items.size());
+    for (const Item &item : _items) {
+      _indices.push_back(item._number);
+    }
+  }
+
+  Items().swap(_items);
+}
+
+/**
+ * Fills result with the sorted numbers of all items whose bounding box might
+ * intersect the indicated bounding volume, which should be in the same
+ * coordinate space as the items.
+ *
+ * Returns false if the bounding volume is of a kind that the hierarchy can't
+ * be tested against, in which case the caller should consider every item
+ * instead.
+ */
+bool CollisionBVH::
+find_overlaps(const GeometricBoundingVolume *bounds, vector_int &result) const {
+  result.clear();
+
+  if (bounds == nullptr || bounds->is_empty() || bounds->is_infinite()) {
+    return false;
+  }
+
+  const BoundingLine *line = bounds->as_bounding_line();
+  if (line != nullptr) {
+    const LPoint3 &origin = line->get_point_a();
+    find_overlaps_line(origin, line->get_point_b() - origin, result);
+  } else {
+    const FiniteBoundingVolume *fbv = bounds->as_finite_bounding_volume();
+    if (fbv == nullptr) {
+      return false;
+    }
+    find_overlaps_box(fbv->get_min(), fbv->get_max(), result);
+  }
+
+  result.insert(result.end(), _unbounded.begin(), _unbounded.end());
+
+  // The caller expects to visit the items in their original order, so that
+  // the collisions are reported in the same order as without the hierarchy.
+  std::sort(result.begin(), result.end());
+  return true;
+}
+
+/**
+ *
+ */
+void CollisionBVH::
+output(std::ostream &out) const {
+  out << "CollisionBVH, " << _num_items << " items, " << _nodes.size()
+      << " nodes";
+}
+
+/**
+ * Appends to result the items whose bounding box overlaps the indicated
+ * box.
+ */
+void CollisionBVH::
+find_overlaps_box(const LPoint3 &min, const LPoint3 &max,
+                  vector_int &result) const {
+  if (_nodes.empty()) {
+    return;
+  }
+
+  int stack[max_stack_depth];
+  int sp = 0;
+  stack[sp++] = 0;
+  int num_tested = 0;
+
+  while (sp > 0) {
+    const Node &node = _nodes[stack[--sp]];
+    ++num_tested;
+    if (!overlaps_box(node._min, node._max, min, max)) {
+      continue;
+    }
+    if (node._count != 0) {
+      result.insert(result.end(), _indices.begin() + node._index,
+                    _indices.begin() + node._index + node._count);
+    } else {
+      nassertd(sp + 2 <= max_stack_depth) break;
+      stack[sp++] = node._index;
+      stack[sp++] = (int)(&node - _nodes.data()) + 1;
+    }
+  }
+
+  _volume_pcollector.add_level(num_tested);
+}
+
+/**
+ * Appends to result the items whose bounding box is crossed by the indicated
+ * infinite line.
+ */
+void CollisionBVH::
+find_overlaps_line(const LPoint3 &origin, const LVector3 &direction,
+                   vector_int &result) const {
+  if (_nodes.empty()) {
+    return;
+  }
+
+  int stack[max_stack_depth];
+  int sp = 0;
+  stack[sp++] = 0;
+  int num_tested = 0;
+
+  while (sp > 0) {
+    const Node &node = _nodes[stack[--sp]];
+    ++num_tested;
+    if (!overlaps_line(node._min, node._max, origin, direction)) {
+      continue;
+    }
+    if (node._count != 0) {
+      result.insert(result.end(), _indices.begin() + node._index,
+                    _indices.begin() + node._index + node._count);
+    } else {
+      nassertd(sp + 2 <= max_stack_depth) break;
+      stack[sp++] = node._index;
+      stack[sp++] = (int)(&node - _nodes.data()) + 1;
+    }
+  }
+
+  _volume_pcollector.add_level(num_tested);
+}
+
+/**
+ * Recursively fills in the indicated node, which covers the items in the
+ * range [begin, end), and creates its children.  The items in the range are
+ * reordered so that each leaf references a contiguous range.
+ */
+void CollisionBVH::
+r_build(size_t node_index, size_t begin, size_t end, int depth) {
+  const PN_stdfloat inf = std::numeric_limits<PN_stdfloat>::infinity();
+  LPoint3 min(inf, inf, inf), max(-inf, -inf, -inf);
+  LPoint3 cmin(inf, inf, inf), cmax(-inf, -inf, -inf);
+
+  for (size_t i = begin; i < end; ++i) {
+    const Item &item = _items[i];
+    min = min.fmin(item._min);
+    max = max.fmax(item._max);
+    cmin = cmin.fmin(item._center);
+    cmax = cmax.fmax(item._center);
+  }
+
+  {
+    Node &node = _nodes[node_index];
+    node._min = min;
+    node._max = max;
+    node._index = (int)begin;
+    node._count = (int)(end - begin);
+  }
+
+  size_t count = end - begin;
+  if (count <= min_leaf_items) {
+    return;
+  }
+
+  // Find the axis along which the centers are spread out the most; this is
+  // the one used for median splits, and for the binning below.
+  LVector3 extent = cmax - cmin;
+  int widest = 0;
+  if (extent[1] > extent[widest]) {
+    widest = 1;
+  }
+  if (extent[2] > extent[widest]) {
+    widest = 2;
+  }
+  if (extent[widest] <= (PN_stdfloat)0) {
+    // All of the items are centered at the same point; there's no sensible
+    // way to split them up.
+    return;
+  }
+
+  size_t mid = begin;
+  if (depth < max_sah_depth) {
+    // Evaluate the surface area heuristic at the bin boundaries along each
+    // axis and pick the cheapest split.
+    PN_stdfloat best_cost = inf;
+    int best_axis = -1;
+    int best_bin = 0;
+
+    for (int axis = 0; axis < 3; ++axis) {
+      if (extent[axis] <= (PN_stdfloat)0) {
+        continue;
+      }
+      PN_stdfloat scale = num_sah_bins / extent[axis];
+
+      int bin_counts[num_sah_bins] = {0};
+      LPoint3 bin_mins[num_sah_bins], bin_maxs[num_sah_bins];
+      for (int b = 0; b < num_sah_bins; ++b) {
+        bin_mins[b].set(inf, inf, inf);
+        bin_maxs[b].set(-inf, -inf, -inf);
+      }
+
+      for (size_t i = begin; i < end; ++i) {
+        const Item &item = _items[i];
+        int b = std::min(num_sah_bins - 1,
+                         (int)((item._center[axis] - cmin[axis]) * scale));
+        ++bin_counts[b];
+        bin_mins[b] = bin_mins[b].fmin(item._min);
+        bin_maxs[b] = bin_maxs[b].fmax(item._max);
+      }
+
+      // Sweep from the right to compute the cost of everything right of
+      // each boundary, then from the left to complete the cost.
+      PN_stdfloat right_costs[num_sah_bins];
+      LPoint3 rmin(inf, inf, inf), rmax(-inf, -inf, -inf);
+      int rcount = 0;
+      for (int b = num_sah_bins - 1; b > 0; --b) {
+        if (bin_counts[b] != 0) {
+          rmin = rmin.fmin(bin_mins[b]);
+          rmax = rmax.fmax(bin_maxs[b]);
+          rcount += bin_counts[b];
+        }
+        right_costs[b] = (rcount != 0) ? rcount * get_half_area(rmin, rmax) : 0;
+      }
+
+      LPoint3 lmin(inf, inf, inf), lmax(-inf, -inf, -inf);
+      int lcount = 0;
+      for (int b = 1; b < num_sah_bins; ++b) {
+        if (bin_counts[b - 1] != 0) {
+          lmin = lmin.fmin(bin_mins[b - 1]);
+          lmax = lmax.fmax(bin_maxs[b - 1]);
+          lcount += bin_counts[b - 1];
+        }
+        if (lcount == 0 || lcount == (int)count) {
+          continue;
+        }
+        PN_stdfloat cost = lcount * get_half_area(lmin, lmax) + right_costs[b];
+        if (cost < best_cost) {
+          best_cost = cost;
+          best_axis = axis;
+          best_bin = b;
+        }
+      }
+    }
+
+    if (best_axis >= 0) {
+      // Don't bother splitting small nodes if that isn't expected to save
+      // any work; testing a node costs about as much as testing an item.
+      PN_stdfloat leaf_cost = count * get_half_area(min, max);
+      if (count <= 4 && best_cost + get_half_area(min, max) >= leaf_cost) {
+        return;
+      }
+
+      PN_stdfloat cmin_axis = cmin[best_axis];
+      PN_stdfloat scale = num_sah_bins / extent[best_axis];
+      Items::iterator split =
+        std::partition(_items.begin() + begin, _items.begin() + end,
+          [=] (const Item &item) {
+            return std::min(num_sah_bins - 1,
+              (int)((item._center[best_axis] - cmin_axis) * scale)) < best_bin;
+          });
+      mid = split - _items.begin();
+    }
+  }
+
+  if (mid == begin || mid == end) {
+    // Fall back to splitting at the median along the widest axis.
+    mid = begin + count / 2;
+    std::nth_element(_items.begin() + begin, _items.begin() + mid,
+                     _items.begin() + end,
+      [=] (const Item &a, const Item &b) {
+        return a._center[widest] < b._center[widest];
+      });
+  }
+
+  // The left child immediately follows this node; the right child follows
+  // the entire left subtree.
+  _nodes[node_index]._count = 0;
+  _nodes.push_back(Node());
+  r_build(node_index + 1, begin, mid, depth + 1);
+
+  size_t right_index = _nodes.size();
+  _nodes[node_index]._index = (int)right_index;
+  _nodes.push_back(Node());
+  r_build(right_index, mid, end, depth + 1);
+}
@@ -0,0 +1,113 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file collisionBVH.h
+ * @author rdb
+ * @date 2026-10-17
+ */
+
+#ifndef COLLISIONBVH_H
+#define COLLISIONBVH_H
+
+#include "pandabase.h"
+
+#include "referenceCount.h"
+#include "luse.h"
+#include "pvector.h"
+#include "vector_int.h"
+#include "pStatCollector.h"
+
+class GeometricBoundingVolume;
+
+/**
+ * A bounding volume hierarchy of axis-aligned boxes, built with the surface
+ * area heuristic.  Each item added to the hierarchy is identified by the
+ * order in which it was added.
+ *
+ * The CollisionTraverser uses this to quickly find the solids of a
+ * CollisionNode, or the triangles of a Geom, whose bounds may intersect a
+ * particular collider, rather than testing each of them in turn.  Items
+ * without finite bounds are never culled by the hierarchy.
+ */
+class EXPCL_PANDA_COLLIDE CollisionBVH : public ReferenceCount {
+public:
+  CollisionBVH() = default;
+
+  void add_item(const LPoint3 &min, const LPoint3 &max);
+  void add_unbounded_item();
+  void build();
+
+  INLINE size_t get_num_items() const;
+  INLINE size_t get_num_nodes() const;
+
+  bool find_overlaps(const GeometricBoundingVolume *bounds,
+                     vector_int &result) const;
+
+  void output(std::ostream &out) const;
+
+  INLINE static void flush_level();
+
+private:
+  void find_overlaps_box(const LPoint3 &min, const LPoint3 &max,
+                         vector_int &result) const;
+  void find_overlaps_line(const LPoint3 &origin, const LVector3 &direction,
+                          vector_int &result) const;
+
+  INLINE static bool overlaps_box(const LPoint3 &amin, const LPoint3 &amax,
+                                  const LPoint3 &bmin, const LPoint3 &bmax);
+  INLINE static bool overlaps_line(const LPoint3 &min, const LPoint3 &max,
+                                   const LPoint3 &origin,
+                                   const LVector3 &direction);
+  INLINE static PN_stdfloat get_half_area(const LPoint3 &min,
+                                          const LPoint3 &max);
+
+  void r_build(size_t node_index, size_t begin, size_t end, int depth);
+
+  // A node of the hierarchy.  Interior nodes have _count == 0; their left
+  // child immediately follows them in _nodes, and _index is the index of the
+  // right child.  Leaf nodes reference _count entries of _indices starting
+  // at _index.
+  class Node {
+  public:
+    LPoint3 _min = LPoint3::zero();
+    LPoint3 _max = LPoint3::zero();
+    int _index = 0;
+    int _count = 0;
+  };
+  typedef pvector<Node> Nodes;
+  Nodes _nodes;
+
+  // This holds the item numbers in leaf order.
+  vector_int _indices;
+
+  // These are only used while building.
+  class Item {
+  public:
+    LPoint3 _min;
+    LPoint3 _max;
+    LPoint3 _center;
+    int _number;
+  };
+  typedef pvector<Item> Items;
+  Items _items;
+
+  size_t _num_items = 0;
+  vector_int _unbounded;
+
+  static PStatCollector _build_pcollector;
+  static PStatCollector _volume_pcollector;
+};
+
+INLINE std::ostream &operator << (std::ostream &out, const CollisionBVH &bvh) {
+  bvh.output(out);
+  return out;
+}
+
+#include "collisionBVH.I"
+
+#endif
@@ -0,0 +1,176 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file collisionGeomBVH.cxx
+ * @author rdb
+ * @date 2026-10-17
+ */
+
+#include "collisionGeomBVH.h"
+#include "collisionPolygon.h"
+#include "config_collide.h"
+#include "geomTriangles.h"
+#include "geomVertexReader.h"
+#include "lightMutexHolder.h"
+
+CollisionGeomBVH::Cache CollisionGeomBVH::_cache;
+size_t CollisionGeomBVH::_cache_clean_size = 0;
+LightMutex CollisionGeomBVH::_cache_lock("CollisionGeomBVH::_cache_lock");
+
+/**
+ * Collects the non-degenerate triangles of the indicated Geom and builds the
+ * hierarchy around them.
+ */
+CollisionGeomBVH::
+CollisionGeomBVH(const Geom *geom, Thread *current_thread) {
+  CPT(GeomVertexData) data = geom->get_vertex_data(current_thread);
+  _geom_modified = geom->get_modified(current_thread);
+  _data_modified = data->get_modified(current_thread);
+
+  GeomVertexReader vertex(data, InternalName::get_vertex(), current_thread);
+
+  size_t num_primitives = geom->get_num_primitives();
+  _primitives_modified.reserve(num_primitives);
+  for (size_t i = 0; i < num_primitives; ++i) {
+    CPT(GeomPrimitive) primitive = geom->get_primitive(i);
+    _primitives_modified.push_back(primitive->get_modified());
+
+    CPT(GeomPrimitive) tris = primitive->decompose();
+    nassertd(tris->is_of_type(GeomTriangles::get_class_type())) continue;
+
+    if (tris->is_indexed()) {
+      GeomVertexReader index(tris->get_vertices(), 0, current_thread);
+      while (!index.is_at_end()) {
+        LPoint3 v[3];
+
+        vertex.set_row_unsafe(index.get_data1i());
+        v[0] = vertex.get_data3();
+        vertex.set_row_unsafe(index.get_data1i());
+        v[1] = vertex.get_data3();
+        vertex.set_row_unsafe(index.get_data1i());
+        v[2] = vertex.get_data3();
+
+        add_triangle(v[0], v[1], v[2]);
+      }
+    } else {
+      vertex.set_row_unsafe(tris->get_first_vertex());
+      int num_vertices = tris->get_num_vertices();
+      for (int j = 0; j < num_vertices; j += 3) {
+        LPoint3 v[3];
+
+        v[0] = vertex.get_data3();
+        v[1] = vertex.get_data3();
+        v[2] = vertex.get_data3();
+
+        add_triangle(v[0], v[1], v[2]);
+      }
+    }
+  }
+
+  build();
+}
+
+/**
+ * Returns the hierarchy for the triangles of the indicated Geom, building it
+ * first if necessary.  Returns NULL if the Geom is not suitable, because it
+ * does not consist of polygons or because its vertices are animated.
+ *
+ * This may safely be called from multiple threads at once.
+ */
+CPT(CollisionGeomBVH) CollisionGeomBVH::
+get_bvh(const Geom *geom, Thread *current_thread) {
+  if (geom->get_primitive_type() != Geom::PT_polygons) {
+    return nullptr;
+  }
+
+  {
+    CPT(GeomVertexData) data = geom->get_vertex_data(current_thread);
+    if (data->get_format()->get_animation().get_animation_type() != Geom::AT_none ||
+        data->get_slider_table() != nullptr) {
+      // The vertices may be different every frame; it isn't worth building
+      // a hierarchy for them.
+      return nullptr;
+    }
+  }
+
+  LightMutexHolder holder(_cache_lock);
+  CacheEntry &entry = _cache[geom];
+  if (entry._bvh != nullptr && !entry._geom.was_deleted() &&
+      entry._geom == geom && !entry._bvh->is_stale(geom, current_thread)) {
+    return entry._bvh;
+  }
+
+  // Note that we build the hierarchy while holding the lock, so that several
+  // threads that reach the same Geom at the same time don't each build it.
+  entry._geom = geom;
+  entry._bvh = new CollisionGeomBVH(geom, current_thread);
+  CPT(CollisionGeomBVH) result = entry._bvh;
+
+  if (collide_cat.is_debug()) {
+    collide_cat.debug()
+      << "Built " << *result << " for " << *geom << "\n";
+  }
+
+  if (_cache.size() >= _cache_clean_size * 2) {
+    // Every so often, drop the entries for Geoms that no longer exist.
+    Cache::iterator ci = _cache.begin();
+    while (ci != _cache.end()) {
+      if ((*ci).second._geom.was_deleted()) {
+        ci = _cache.erase(ci);
+      } else {
+        ++ci;
+      }
+    }
+    _cache_clean_size = std::max(_cache.size(), (size_t)16);
+  }
+
+  return result;
+}
+
+/**
+ * Releases all of the cached hierarchies.  They will be rebuilt on demand.
+ */
+void CollisionGeomBVH::
+clear_cache() {
+  LightMutexHolder holder(_cache_lock);
+  _cache.clear();
+  _cache_clean_size = 0;
+}
+
+/**
+ * Returns true if the indicated Geom has been modified since this hierarchy
+ * was built from it.
+ */
+bool CollisionGeomBVH::
+is_stale(const Geom *geom, Thread *current_thread) const {
+  if (geom->get_modified(current_thread) != _geom_modified ||
+      geom->get_vertex_data(current_thread)->get_modified(current_thread) != _data_modified ||
+      geom->get_num_primitives() != _primitives_modified.size()) {
+    return true;
+  }
+
+  for (size_t i = 0; i < _primitives_modified.size(); ++i) {
+    if (geom->get_primitive(i)->get_modified() != _primitives_modified[i]) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Adds the indicated triangle, unless it is degenerate.
+ */
+void CollisionGeomBVH::
+add_triangle(const LPoint3 &v0, const LPoint3 &v1, const LPoint3 &v2) {
+  if (CollisionPolygon::verify_points(v0, v1, v2)) {
+    _vertices.push_back(v0);
+    _vertices.push_back(v1);
+    _vertices.push_back(v2);
+    add_item(v0.fmin(v1).fmin(v2), v0.fmax(v1).fmax(v2));
+  }
+}
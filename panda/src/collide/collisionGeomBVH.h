@@ -0,0 +1,74 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file collisionGeomBVH.h
+ * @author rdb
+ * @date 2026-10-17
+ */
+
+#ifndef COLLISIONGEOMBVH_H
+#define COLLISIONGEOMBVH_H
+
+#include "pandabase.h"
+
+#include "collisionBVH.h"
+#include "geom.h"
+#include "updateSeq.h"
+#include "weakPointerTo.h"
+#include "lightMutex.h"
+#include "pmap.h"
+
+/**
+ * A CollisionBVH over the triangles of a Geom, which also stores the vertices
+ * of those triangles, so that the CollisionTraverser can test a collider
+ * against a large Geom without visiting all of its triangles.
+ *
+ * These are cached per Geom by get_bvh(), and rebuilt automatically when the
+ * Geom or its vertex data is modified.  Degenerate triangles are omitted, so
+ * the item numbers correspond to the order in which the valid triangles
+ * appear in the Geom.
+ */
+class EXPCL_PANDA_COLLIDE CollisionGeomBVH : public CollisionBVH {
+private:
+  CollisionGeomBVH(const Geom *geom, Thread *current_thread);
+
+public:
+  static CPT(CollisionGeomBVH) get_bvh(const Geom *geom,
+                                       Thread *current_thread);
+  static void clear_cache();
+
+  INLINE size_t get_num_triangles() const;
+  INLINE const LPoint3 *get_triangle(size_t n) const;
+
+private:
+  bool is_stale(const Geom *geom, Thread *current_thread) const;
+  void add_triangle(const LPoint3 &v0, const LPoint3 &v1, const LPoint3 &v2);
+
+  typedef pvector<LPoint3> Vertices;
+  Vertices _vertices;
+
+  // These record the state of the Geom at the time this was built.
+  UpdateSeq _geom_modified;
+  UpdateSeq _data_modified;
+  typedef pvector<UpdateSeq> PrimitivesModified;
+  PrimitivesModified _primitives_modified;
+
+  class CacheEntry {
+  public:
+    WCPT(Geom) _geom;
+    CPT(CollisionGeomBVH) _bvh;
+  };
+  typedef pmap<const Geom *, CacheEntry> Cache;
+  static Cache _cache;
+  static size_t _cache_clean_size;
+  static LightMutex _cache_lock;
+};
+
+#include "collisionGeomBVH.I"
+
+#endif
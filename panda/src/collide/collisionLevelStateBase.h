@@ -32,6 +32,7 @@
 
 class CollisionSolid;
 class CollisionNode;
+class CollisionHandler;
 
 /**
  * This is the state information the CollisionTraverser retains for each level
@@ -47,6 +48,7 @@ public:
     CPT(CollisionSolid) _collider;
     CollisionNode *_node;
     NodePath _node_path;
+    CollisionHandler *_handler;
   };
 
   INLINE CollisionLevelStateBase(const NodePath &node_path);
@@ -69,6 +71,7 @@ public:
   INLINE const CollisionSolid *get_collider(int n) const;
   INLINE CollisionNode *get_collider_node(int n) const;
   INLINE NodePath get_collider_node_path(int n) const;
+  INLINE CollisionHandler *get_collider_handler(int n) const;
   INLINE const GeometricBoundingVolume *get_node_bound() const;
   INLINE const GeometricBoundingVolume *get_local_bound(int n) const;
   INLINE const GeometricBoundingVolume *get_parent_bound(int n) const;
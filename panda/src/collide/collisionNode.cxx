@@ -29,6 +29,7 @@
 #include "boundingSphere.h"
 #include "boundingBox.h"
 #include "config_mathutil.h"
+#include "lightMutexHolder.h"
 
 TypeHandle CollisionNode::_type_handle;
 
@@ -271,6 +272,43 @@ clear_owner() {
   _owner_callback = nullptr;
 }
 
+/**
+ * Returns a bounding volume hierarchy over the solids of this node, which the
+ * CollisionTraverser uses to avoid testing each solid in turn.  It is built
+ * the first time it is requested, and rebuilt after the solids have been
+ * changed.  Item n of the hierarchy corresponds to solid n.
+ */
+CPT(CollisionBVH) CollisionNode::
+get_bvh(Thread *current_thread) const {
+  CPT(BoundingVolume) internal_bounds = get_internal_bounds(current_thread);
+
+  LightMutexHolder holder(_bvh_lock);
+  if (_bvh != nullptr && _bvh_internal_bounds == internal_bounds) {
+    return _bvh;
+  }
+
+  PT(CollisionBVH) bvh = new CollisionBVH;
+  for (const COWPT(CollisionSolid) &solid : _solids) {
+    CPT(BoundingVolume) volume = solid.get_read_pointer(current_thread)->get_bounds();
+    const FiniteBoundingVolume *fbv = volume->as_finite_bounding_volume();
+    if (fbv != nullptr && !volume->is_empty()) {
+      bvh->add_item(fbv->get_min(), fbv->get_max());
+    } else {
+      bvh->add_unbounded_item();
+    }
+  }
+  bvh->build();
+
+  if (collide_cat.is_debug()) {
+    collide_cat.debug()
+      << "Built " << *bvh << " for " << *this << "\n";
+  }
+
+  _bvh = bvh;
+  _bvh_internal_bounds = std::move(internal_bounds);
+  return _bvh;
+}
+
 /**
  * Called when needed to recompute the node's _internal_bound object.  Nodes
  * that contain anything of substance should redefine this to do the right
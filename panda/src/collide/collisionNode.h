@@ -20,6 +20,8 @@
 
 #include "collideMask.h"
 #include "pandaNode.h"
+#include "collisionBVH.h"
+#include "lightMutex.h"
 
 /**
  * A node in the scene graph that can hold any number of CollisionSolids.
@@ -90,6 +92,8 @@ public:
   EXTENSION(PyObject *get_owner() const);
   EXTENSION(void set_owner(PyObject *owner));
 
+  CPT(CollisionBVH) get_bvh(Thread *current_thread = Thread::get_current_thread()) const;
+
 PUBLISHED:
   MAKE_PROPERTY(owner, get_owner, set_owner);
 
@@ -113,6 +117,13 @@ private:
   void *_owner = nullptr;
   OwnerCallback *_owner_callback = nullptr;
 
+  // The hierarchy over the solids, built on demand by get_bvh().  It is
+  // rebuilt whenever the internal bounds are recomputed, which happens
+  // whenever the set of solids changes.
+  mutable LightMutex _bvh_lock;
+  mutable CPT(CollisionBVH) _bvh;
+  mutable CPT(BoundingVolume) _bvh_internal_bounds;
+
   friend class CollisionTraverser;
 
 public:
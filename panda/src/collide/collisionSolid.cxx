@@ -303,6 +303,8 @@ report_undefined_intersection_test(TypeHandle from_type, TypeHandle into_type) {
 #ifndef NDEBUG
   typedef pset<CollisionSolidUndefinedPair> Reported;
   static Reported reported;
+  static LightMutex lock;
+  LightMutexHolder holder(lock);
 
   if (reported.insert(CollisionSolidUndefinedPair(from_type, into_type)).second) {
     collide_cat.error()
@@ -328,6 +330,8 @@ report_undefined_from_intersection(TypeHandle from_type) {
 #ifndef NDEBUG
   typedef pset<TypeHandle> Reported;
   static Reported reported;
+  static LightMutex lock;
+  LightMutexHolder holder(lock);
 
   if (reported.insert(from_type).second) {
     collide_cat.error()
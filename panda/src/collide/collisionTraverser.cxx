@@ -24,6 +24,7 @@
 #include "collisionCapsule.h"
 #include "collisionPolygon.h"
 #include "collisionPlane.h"
+#include "collisionGeomBVH.h"
 #include "config_collide.h"
 #include "boundingSphere.h"
 #include "transformState.h"
@@ -36,6 +37,8 @@
 #include "nodePath.h"
 #include "pStatTimer.h"
 #include "indent.h"
+#include "asyncTaskManager.h"
+#include "asyncTaskChain.h"
 
 #include <algorithm>
 
@@ -66,6 +69,57 @@ public:
   const CollisionTraverser &_trav;
 };
 
+/**
+ * Stands in for the actual handler of a collider during a parallel traversal,
+ * collecting up the entries that are detected by a particular pass, so that
+ * they can be handed to the actual handler afterwards.  The collider is
+ * identified by its index among all of the colliders of the traversal.
+ */
+class CollisionTraverser::DeferredHandler : public CollisionHandler {
+public:
+  class Entry {
+  public:
+    CollisionHandler *_handler;
+    PT(CollisionEntry) _entry;
+    int _collider;
+  };
+  typedef pvector<Entry> Entries;
+
+  DeferredHandler(CollisionHandler *handler, int collider, Entries &entries) :
+    _handler(handler),
+    _collider(collider),
+    _entries(entries)
+  {
+    _wants_all_potential_collidees = handler->wants_all_potential_collidees();
+  }
+
+  virtual void add_entry(CollisionEntry *entry) {
+    _entries.push_back({_handler, entry, _collider});
+  }
+
+private:
+  CollisionHandler *_handler;
+  int _collider;
+  Entries &_entries;
+};
+
+/**
+ * Stores in order the index of each node of the path among the children of
+ * its parent, from the top of the path down, so that comparing the results
+ * for two paths tells which of the nodes a depth-first traversal visits
+ * first.
+ */
+static void
+get_traversal_order(const NodePath &path, pvector<int> &order) {
+  NodePath node_path = path;
+  while (node_path.has_parent()) {
+    NodePath parent = node_path.get_parent();
+    order.push_back(parent.node()->find_child(node_path.node()));
+    node_path = parent;
+  }
+  std::reverse(order.begin(), order.end());
+}
+
 /**
  *
  */
@@ -75,6 +129,8 @@ CollisionTraverser(std::string name) :
   _this_pcollector(_collisions_pcollector, get_name())
 {
   _respect_prev_transform = respect_prev_transform;
+  _use_bvh = collision_use_bvh;
+  _num_threads = collision_num_threads;
   #ifdef DO_COLLISION_RECORDING
   _recorder = nullptr;
   #endif
@@ -273,12 +329,37 @@ traverse(const NodePath &root) {
   }
 
   bool traversal_done = false;
-  if ((int)_colliders.size() <= CollisionLevelStateSingle::get_max_colliders() ||
-      !allow_collider_multiple) {
+
+  int num_threads = _num_threads;
+#ifdef DO_COLLISION_RECORDING
+  if (has_recorder()) {
+    // The recorder can't be told about tests from several threads at once.
+    num_threads = 0;
+  }
+#endif  // DO_COLLISION_RECORDING
+
+  if (num_threads > 0 && _colliders.size() > 1 &&
+      Thread::is_threading_supported()) {
+    // Split up the colliders into enough passes to keep all the threads busy,
+    // and traverse the passes in parallel.
+    int num_colliders = (int)_colliders.size();
+    int max_colliders = std::min(CollisionLevelStateSingle::get_max_colliders(),
+                                 (num_colliders + num_threads) / (num_threads + 1));
+
+    LevelStatesSingle level_states;
+    prepare_colliders_single(level_states, root, max_colliders);
+    traverse_parallel(level_states, num_threads);
+    traversal_done = true;
+  }
+
+  if (!traversal_done &&
+      ((int)_colliders.size() <= CollisionLevelStateSingle::get_max_colliders() ||
+       !allow_collider_multiple)) {
     // Use the single-word-at-a-time traverser, which might need to make lots
     // of passes.
     LevelStatesSingle level_states;
-    prepare_colliders_single(level_states, root);
+    prepare_colliders_single(level_states, root,
+                             CollisionLevelStateSingle::get_max_colliders());
 
     if (level_states.size() == 1 || !allow_collider_multiple) {
       traversal_done = true;
@@ -356,6 +437,7 @@ traverse(const NodePath &root) {
   CollisionPlane::flush_level();
   CollisionBox::flush_level();
   CollisionHeightfield::flush_level();
+  CollisionBVH::flush_level();
 }
 
 #if defined(DO_COLLISION_RECORDING) || !defined(CPPPARSER)
@@ -490,13 +572,15 @@ write(std::ostream &out, int indent_level) const {
  * use.
  *
  * This flavor uses a CollisionLevelStateSingle, which is limited to a certain
- * number of colliders per pass (typically 32).
+ * number of colliders per pass (typically 32).  The number of colliders per
+ * pass may be further limited by max_colliders.
  */
 void CollisionTraverser::
 prepare_colliders_single(CollisionTraverser::LevelStatesSingle &level_states,
-                         const NodePath &root) {
+                         const NodePath &root, int max_colliders) {
   int num_colliders = _colliders.size();
-  int max_colliders = CollisionLevelStateSingle::get_max_colliders();
+  nassertv(max_colliders > 0 &&
+           max_colliders <= CollisionLevelStateSingle::get_max_colliders());
 
   CollisionLevelStateSingle level_state(root);
   // This reserve() call is only correct if there is exactly one solid per
@@ -535,6 +619,7 @@ prepare_colliders_single(CollisionTraverser::LevelStatesSingle &level_states,
       CollisionLevelStateSingle::ColliderDef def;
       def._node = cnode;
       def._node_path = cnode_path;
+      def._handler = (*_colliders.find(cnode_path)).second;
 
       int num_solids = cnode->get_num_solids();
       for (int s = 0; s < num_solids; ++s) {
@@ -596,7 +681,7 @@ r_traverse_single(CollisionLevelStateSingle &level_state, size_t pass) {
           entry._from = level_state.get_collider(c);
 
           compare_collider_to_node(
-              entry,
+              entry, level_state.get_collider_handler(c),
               level_state.get_parent_bound(c),
               level_state.get_local_bound(c),
               level_state.get_node_bound());
@@ -635,7 +720,7 @@ r_traverse_single(CollisionLevelStateSingle &level_state, size_t pass) {
           entry._from = level_state.get_collider(c);
 
           compare_collider_to_geom_node(
-              entry,
+              entry, level_state.get_collider_handler(c),
               level_state.get_parent_bound(c),
               level_state.get_local_bound(c),
               level_state.get_node_bound());
@@ -695,6 +780,113 @@ r_traverse_single(CollisionLevelStateSingle &level_state, size_t pass) {
   }
 }
 
+/**
+ * Traverses the indicated passes in parallel, on the calling thread as well as
+ * the indicated number of worker threads.  The entries detected by each pass
+ * are collected up, and handed to the actual handlers once all of them have
+ * been traversed, in the same order in which the serial traversal would have
+ * detected them.
+ */
+void CollisionTraverser::
+traverse_parallel(CollisionTraverser::LevelStatesSingle &level_states,
+                  int num_threads) {
+  size_t num_passes = level_states.size();
+
+  // Substitute a DeferredHandler for the handler of each collider.
+  pvector<DeferredHandler::Entries> pass_entries(num_passes);
+  pvector<PT(DeferredHandler)> deferred_handlers;
+  int num_colliders = 0;
+
+  for (size_t pass = 0; pass < num_passes; ++pass) {
+    CollisionLevelStateSingle &level_state = level_states[pass];
+
+    int num_pass_colliders = level_state.get_num_colliders();
+    for (int c = 0; c < num_pass_colliders; ++c) {
+      CollisionHandler *&handler = level_state._colliders[c]._handler;
+      PT(DeferredHandler) deferred =
+        new DeferredHandler(handler, num_colliders++, pass_entries[pass]);
+      handler = deferred;
+      deferred_handlers.push_back(std::move(deferred));
+    }
+
+    // Make sure the collector for this pass exists before the threads go
+    // looking for it.
+    get_pass_collector(pass);
+  }
+
+  static PT(AsyncTaskChain) chain =
+    AsyncTaskManager::get_global_ptr()->make_task_chain("collision_traverser");
+  if (chain->get_num_threads() < num_threads) {
+    chain->set_num_threads(num_threads);
+  }
+
+  chain->parallel_for(num_passes, [&] (size_t pass) {
+#ifdef DO_PSTATS
+    PStatTimer pass_timer(_pass_collectors[pass]);
+#endif
+    if (level_states[pass].any_in_bounds()) {
+      r_traverse_single(level_states[pass], pass);
+    }
+  });
+
+  // The serial traversal makes a pass over the scene graph for each group of
+  // this many colliders; see traverse().  Within a pass, it reports the
+  // entries node by node, and the entries for each node in order of the
+  // colliders.  The entries of each of our passes are already in that order,
+  // so they only need to be merged.
+  int serial_pass_size;
+  int num_collider_nodes = (int)_colliders.size();
+  if (!allow_collider_multiple ||
+      (num_collider_nodes <= CollisionLevelStateSingle::get_max_colliders() &&
+       num_colliders <= CollisionLevelStateSingle::get_max_colliders())) {
+    serial_pass_size = CollisionLevelStateSingle::get_max_colliders();
+  } else if (num_collider_nodes <= CollisionLevelStateDouble::get_max_colliders() &&
+             num_colliders <= CollisionLevelStateDouble::get_max_colliders()) {
+    serial_pass_size = CollisionLevelStateDouble::get_max_colliders();
+  } else {
+    serial_pass_size = CollisionLevelStateQuad::get_max_colliders();
+  }
+
+  class SortEntry {
+  public:
+    int _serial_pass;
+    const pvector<int> *_node_order;
+    const DeferredHandler::Entry *_entry;
+  };
+  pvector<SortEntry> sort_entries;
+  pmap<NodePath, pvector<int> > node_orders;
+
+  for (const DeferredHandler::Entries &entries : pass_entries) {
+    for (const DeferredHandler::Entry &entry : entries) {
+      const NodePath &into_node_path = entry._entry->get_into_node_path();
+      auto it = node_orders.find(into_node_path);
+      if (it == node_orders.end()) {
+        it = node_orders.insert(std::make_pair(into_node_path, pvector<int>())).first;
+        get_traversal_order(into_node_path, it->second);
+      }
+      sort_entries.push_back({entry._collider / serial_pass_size, &it->second, &entry});
+    }
+  }
+
+  // A stable sort keeps the entries for the same node and collider in the
+  // order in which they were detected.
+  std::stable_sort(sort_entries.begin(), sort_entries.end(),
+                   [] (const SortEntry &a, const SortEntry &b) {
+    if (a._serial_pass != b._serial_pass) {
+      return a._serial_pass < b._serial_pass;
+    }
+    if (*a._node_order != *b._node_order) {
+      return *a._node_order < *b._node_order;
+    }
+    return a._entry->_collider < b._entry->_collider;
+  });
+
+  for (const SortEntry &sort_entry : sort_entries) {
+    const DeferredHandler::Entry &entry = *sort_entry._entry;
+    entry._handler->add_entry(entry._entry);
+  }
+}
+
 /**
  * Fills up the set of LevelStates corresponding to the active colliders in
  * use.
@@ -745,6 +937,7 @@ prepare_colliders_double(CollisionTraverser::LevelStatesDouble &level_states,
       CollisionLevelStateDouble::ColliderDef def;
       def._node = cnode;
       def._node_path = cnode_path;
+      def._handler = (*_colliders.find(cnode_path)).second;
 
       int num_solids = cnode->get_num_solids();
       for (int s = 0; s < num_solids; ++s) {
@@ -805,7 +998,7 @@ r_traverse_double(CollisionLevelStateDouble &level_state, size_t pass) {
           entry._from = level_state.get_collider(c);
 
           compare_collider_to_node(
-              entry,
+              entry, level_state.get_collider_handler(c),
               level_state.get_parent_bound(c),
               level_state.get_local_bound(c),
               level_state.get_node_bound());
@@ -844,7 +1037,7 @@ r_traverse_double(CollisionLevelStateDouble &level_state, size_t pass) {
           entry._from = level_state.get_collider(c);
 
           compare_collider_to_geom_node(
-              entry,
+              entry, level_state.get_collider_handler(c),
               level_state.get_parent_bound(c),
               level_state.get_local_bound(c),
               level_state.get_node_bound());
@@ -954,6 +1147,7 @@ prepare_colliders_quad(CollisionTraverser::LevelStatesQuad &level_states,
       CollisionLevelStateQuad::ColliderDef def;
       def._node = cnode;
       def._node_path = cnode_path;
+      def._handler = (*_colliders.find(cnode_path)).second;
 
       int num_solids = cnode->get_num_solids();
       for (int s = 0; s < num_solids; ++s) {
@@ -1014,7 +1208,7 @@ r_traverse_quad(CollisionLevelStateQuad &level_state, size_t pass) {
           entry._from = level_state.get_collider(c);
 
           compare_collider_to_node(
-              entry,
+              entry, level_state.get_collider_handler(c),
               level_state.get_parent_bound(c),
               level_state.get_local_bound(c),
               level_state.get_node_bound());
@@ -1053,7 +1247,7 @@ r_traverse_quad(CollisionLevelStateQuad &level_state, size_t pass) {
           entry._from = level_state.get_collider(c);
 
           compare_collider_to_geom_node(
-              entry,
+              entry, level_state.get_collider_handler(c),
               level_state.get_parent_bound(c),
               level_state.get_local_bound(c),
               level_state.get_node_bound());
@@ -1117,7 +1311,7 @@ r_traverse_quad(CollisionLevelStateQuad &level_state, size_t pass) {
  *
  */
 void CollisionTraverser::
-compare_collider_to_node(CollisionEntry &entry,
+compare_collider_to_node(CollisionEntry &entry, CollisionHandler *handler,
                          const GeometricBoundingVolume *from_parent_gbv,
                          const GeometricBoundingVolume *from_node_gbv,
                          const GeometricBoundingVolume *into_node_gbv) {
@@ -1147,11 +1341,26 @@ compare_collider_to_node(CollisionEntry &entry,
     // we just tested, is the same as the solid's bounding volume.)
     if (num_solids == 1) {
       entry._into = cnode->_solids[0].get_read_pointer(current_thread);
-      Colliders::const_iterator ci;
-      ci = _colliders.find(entry.get_from_node_path());
-      nassertv(ci != _colliders.end());
-      entry.test_intersection((*ci).second, this);
+      entry.test_intersection(handler, this);
     } else {
+      vector_int candidates;
+      if (_use_bvh && num_solids >= collision_bvh_threshold) {
+        // Let the hierarchy narrow down the solids we need to look at.  If
+        // it can't make sense of the collider's bounds, we test them all.
+        CPT(CollisionBVH) bvh = cnode->get_bvh(current_thread);
+        if (bvh->find_overlaps(from_node_gbv, candidates)) {
+          for (int n : candidates) {
+            entry._into = cnode->_solids[n].get_read_pointer(current_thread);
+
+            CPT(BoundingVolume) solid_bv = entry._into->get_bounds();
+            const GeometricBoundingVolume *solid_gbv = solid_bv->as_geometric_bounding_volume();
+
+            compare_collider_to_solid(entry, handler, from_node_gbv, solid_gbv);
+          }
+          return;
+        }
+      }
+
       CollisionNode::Solids::const_iterator si;
       for (si = cnode->_solids.begin(); si != cnode->_solids.end(); ++si) {
         entry._into = (*si).get_read_pointer(current_thread);
@@ -1163,7 +1372,7 @@ compare_collider_to_node(CollisionEntry &entry,
         CPT(BoundingVolume) solid_bv = entry._into->get_bounds();
         const GeometricBoundingVolume *solid_gbv = solid_bv->as_geometric_bounding_volume();
 
-        compare_collider_to_solid(entry, from_node_gbv, solid_gbv);
+        compare_collider_to_solid(entry, handler, from_node_gbv, solid_gbv);
       }
     }
   }
@@ -1173,7 +1382,7 @@ compare_collider_to_node(CollisionEntry &entry,
  *
  */
 void CollisionTraverser::
-compare_collider_to_geom_node(CollisionEntry &entry,
+compare_collider_to_geom_node(CollisionEntry &entry, CollisionHandler *handler,
                               const GeometricBoundingVolume *from_parent_gbv,
                               const GeometricBoundingVolume *from_node_gbv,
                               const GeometricBoundingVolume *into_node_gbv) {
@@ -1203,7 +1412,7 @@ compare_collider_to_geom_node(CollisionEntry &entry,
           geom_gbv = geom_bv->as_geometric_bounding_volume();
         }
 
-        compare_collider_to_geom(entry, geom, from_node_gbv, geom_gbv);
+        compare_collider_to_geom(entry, handler, geom, from_node_gbv, geom_gbv);
       }
     }
   }
@@ -1213,7 +1422,7 @@ compare_collider_to_geom_node(CollisionEntry &entry,
  *
  */
 void CollisionTraverser::
-compare_collider_to_solid(CollisionEntry &entry,
+compare_collider_to_solid(CollisionEntry &entry, CollisionHandler *handler,
                           const GeometricBoundingVolume *from_node_gbv,
                           const GeometricBoundingVolume *solid_gbv) {
   bool within_solid_bounds = true;
@@ -1233,10 +1442,7 @@ compare_collider_to_solid(CollisionEntry &entry,
 #endif  // NDEBUG
   }
   if (within_solid_bounds) {
-    Colliders::const_iterator ci;
-    ci = _colliders.find(entry.get_from_node_path());
-    nassertv(ci != _colliders.end());
-    entry.test_intersection((*ci).second, this);
+    entry.test_intersection(handler, this);
   }
 }
 
@@ -1244,7 +1450,8 @@ compare_collider_to_solid(CollisionEntry &entry,
  *
  */
 void CollisionTraverser::
-compare_collider_to_geom(CollisionEntry &entry, const Geom *geom,
+compare_collider_to_geom(CollisionEntry &entry, CollisionHandler *handler,
+                         const Geom *geom,
                          const GeometricBoundingVolume *from_node_gbv,
                          const GeometricBoundingVolume *geom_gbv) {
   bool within_geom_bounds = true;
@@ -1254,12 +1461,34 @@ compare_collider_to_geom(CollisionEntry &entry, const Geom *geom,
     _geom_volume_pcollector.add_level(1);
   }
   if (within_geom_bounds) {
-    Colliders::const_iterator ci;
-    ci = _colliders.find(entry.get_from_node_path());
-    nassertv(ci != _colliders.end());
 
     if (geom->get_primitive_type() == Geom::PT_polygons) {
       Thread *current_thread = Thread::get_current_thread();
+
+      if (_use_bvh && from_node_gbv != nullptr &&
+          geom->get_nested_vertices(current_thread) >= collision_bvh_threshold * 3) {
+        // Let the hierarchy narrow down the triangles we need to look at.
+        CPT(CollisionGeomBVH) bvh = CollisionGeomBVH::get_bvh(geom, current_thread);
+        vector_int candidates;
+        if (bvh != nullptr && bvh->find_overlaps(from_node_gbv, candidates)) {
+          for (int n : candidates) {
+            const LPoint3 *v = bvh->get_triangle(n);
+
+            BoundingSphere sphere;
+            sphere.around(v, v + 3);
+#ifdef DO_PSTATS
+            CollisionGeom::_volume_pcollector.add_level(1);
+#endif  // DO_PSTATS
+            if (sphere.contains(from_node_gbv) != 0) {
+              PT(CollisionGeom) cgeom = new CollisionGeom(v[0], v[1], v[2]);
+              entry._into = cgeom;
+              entry.test_intersection(handler, this);
+            }
+          }
+          return;
+        }
+      }
+
       CPT(GeomVertexData) data = geom->get_animated_vertex_data(true, current_thread);
       GeomVertexReader vertex(data, InternalName::get_vertex());
 
@@ -1297,7 +1526,7 @@ compare_collider_to_geom(CollisionEntry &entry, const Geom *geom,
               if (within_solid_bounds) {
                 PT(CollisionGeom) cgeom = new CollisionGeom(v[0], v[1], v[2]);
                 entry._into = cgeom;
-                entry.test_intersection((*ci).second, this);
+                entry.test_intersection(handler, this);
               }
             }
           }
@@ -1327,7 +1556,7 @@ compare_collider_to_geom(CollisionEntry &entry, const Geom *geom,
               if (within_solid_bounds) {
                 PT(CollisionGeom) cgeom = new CollisionGeom(v[0], v[1], v[2]);
                 entry._into = cgeom;
-                entry.test_intersection((*ci).second, this);
+                entry.test_intersection(handler, this);
               }
             }
           }
@@ -53,6 +53,14 @@ PUBLISHED:
   MAKE_PROPERTY(respect_prev_transform, get_respect_prev_transform,
                                         set_respect_prev_transform);
 
+  INLINE void set_use_bvh(bool flag);
+  INLINE bool get_use_bvh() const;
+  MAKE_PROPERTY(use_bvh, get_use_bvh, set_use_bvh);
+
+  INLINE void set_num_threads(int num_threads);
+  INLINE int get_num_threads() const;
+  MAKE_PROPERTY(num_threads, get_num_threads, set_num_threads);
+
   void add_collider(const NodePath &collider, CollisionHandler *handler);
   bool remove_collider(const NodePath &collider);
   bool has_collider(const NodePath &collider) const;
@@ -85,8 +93,10 @@ PUBLISHED:
 
 private:
   typedef pvector<CollisionLevelStateSingle> LevelStatesSingle;
-  void prepare_colliders_single(LevelStatesSingle &level_states, const NodePath &root);
+  void prepare_colliders_single(LevelStatesSingle &level_states, const NodePath &root,
+                                int max_colliders);
   void r_traverse_single(CollisionLevelStateSingle &level_state, size_t pass);
+  void traverse_parallel(LevelStatesSingle &level_states, int num_threads);
 
   typedef pvector<CollisionLevelStateDouble> LevelStatesDouble;
   void prepare_colliders_double(LevelStatesDouble &level_states, const NodePath &root);
@@ -96,18 +106,19 @@ private:
   void prepare_colliders_quad(LevelStatesQuad &level_states, const NodePath &root);
   void r_traverse_quad(CollisionLevelStateQuad &level_state, size_t pass);
 
-  void compare_collider_to_node(CollisionEntry &entry,
+  void compare_collider_to_node(CollisionEntry &entry, CollisionHandler *handler,
                                 const GeometricBoundingVolume *from_parent_gbv,
                                 const GeometricBoundingVolume *from_node_gbv,
                                 const GeometricBoundingVolume *into_node_gbv);
-  void compare_collider_to_geom_node(CollisionEntry &entry,
+  void compare_collider_to_geom_node(CollisionEntry &entry, CollisionHandler *handler,
                                      const GeometricBoundingVolume *from_parent_gbv,
                                      const GeometricBoundingVolume *from_node_gbv,
                                      const GeometricBoundingVolume *into_node_gbv);
-  void compare_collider_to_solid(CollisionEntry &entry,
+  void compare_collider_to_solid(CollisionEntry &entry, CollisionHandler *handler,
                                  const GeometricBoundingVolume *from_node_gbv,
                                  const GeometricBoundingVolume *solid_gbv);
-  void compare_collider_to_geom(CollisionEntry &entry, const Geom *geom,
+  void compare_collider_to_geom(CollisionEntry &entry, CollisionHandler *handler,
+                                const Geom *geom,
                                 const GeometricBoundingVolume *from_node_gbv,
                                 const GeometricBoundingVolume *solid_gbv);
 
@@ -132,7 +143,11 @@ private:
 
   Handlers::iterator remove_handler(Handlers::iterator hi);
 
+  class DeferredHandler;
+
   bool _respect_prev_transform;
+  bool _use_bvh;
+  int _num_threads;
 #ifdef DO_COLLISION_RECORDING
   CollisionRecorder *_recorder;
   NodePath _collision_visualizer_np;
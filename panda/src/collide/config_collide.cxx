@@ -112,6 +112,31 @@ ConfigVariableBool pushers_horizontal
           "set_horizontal() flag by default, false to let the move "
           "in three dimensions by default."));
 
+ConfigVariableBool collision_use_bvh
+("collision-use-bvh", false,
+ PRC_DESC("Set this true to have all CollisionTraversers use a bounding "
+          "volume hierarchy to find the collision solids in a CollisionNode, "
+          "or the triangles in a Geom, that a collider might intersect, "
+          "rather than testing them one at a time.  The hierarchy is built "
+          "the first time a node is encountered and rebuilt whenever it is "
+          "modified, so this is most useful for large, static collision "
+          "geometry.  It can also be enabled for a particular traverser with "
+          "CollisionTraverser::set_use_bvh()."));
+
+ConfigVariableInt collision_bvh_threshold
+("collision-bvh-threshold", 16,
+ PRC_DESC("This is the minimum number of solids in a CollisionNode, or "
+          "triangles in a Geom, for which a CollisionTraverser will use a "
+          "bounding volume hierarchy, when this is enabled.  Smaller nodes "
+          "are simply tested one solid at a time."));
+
+ConfigVariableInt collision_num_threads
+("collision-num-threads", 0,
+ PRC_DESC("This is the default number of worker threads over which each "
+          "CollisionTraverser distributes its colliders.  Set this to 0 to "
+          "perform all collision traversals on the calling thread.  See "
+          "CollisionTraverser::set_num_threads()."));
+
 /**
  * Initializes the library.  This must be called at least once before any of
  * the functions or classes in this library can be used.  Normally it will be
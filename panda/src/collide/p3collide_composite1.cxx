@@ -1,8 +1,10 @@
 #include "config_collide.cxx"
 #include "collisionBox.cxx"
+#include "collisionBVH.cxx"
 #include "collisionCapsule.cxx"
 #include "collisionEntry.cxx"
 #include "collisionGeom.cxx"
+#include "collisionGeomBVH.cxx"
 #include "collisionHandler.cxx"
 #include "collisionHandlerEvent.cxx"
 #include "collisionHandlerHighestEvent.cxx"
@@ -22,3 +22,13 @@ void BinCullHandler::
 record_object(CullableObject &&object, const CullTraverser *traverser) {
   _cull_result->add_object(std::move(object), traverser);
 }
+
+/**
+ * Called at the end of the traversal, this adds the instance batches that the
+ * CullResult has collected to the bins.
+ */
+void BinCullHandler::
+end_traverse(const CullTraverser *traverser) {
+  _cull_result->flush_instance_batches(traverser);
+  end_traverse();
+}
@@ -30,6 +30,8 @@ public:
 
   virtual void record_object(CullableObject &&object,
                              const CullTraverser *traverser);
+  using CullHandler::end_traverse;
+  virtual void end_traverse(const CullTraverser *traverser);
 
 private:
   PT(CullResult) _cull_result;
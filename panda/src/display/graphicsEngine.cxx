@@ -844,6 +844,7 @@ render_frame() {
     RenderState::flush_level();
     TransformState::flush_level();
     CullableObject::flush_level();
+    CullResult::flush_level();
 
     // Now cycle the pipeline and officially begin the next frame.
 #ifdef THREADED_PIPELINE
@@ -870,6 +871,9 @@ render_frame() {
     GeomCacheManager::_geom_cache_record_pcollector.clear_level();
     GeomCacheManager::_geom_cache_erase_pcollector.clear_level();
     GeomCacheManager::_geom_cache_evict_pcollector.clear_level();
+    VertexDataPage::_page_in_pcollector.clear_level();
+    VertexDataPage::_page_out_pcollector.clear_level();
+    VertexDataPage::_prefetch_pcollector.clear_level();
 
     GraphicsStateGuardian::init_frame_pstats();
 
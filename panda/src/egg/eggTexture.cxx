@@ -766,6 +766,8 @@ string_compression_mode(std::string_view string) {
     return CM_dxt4;
   } else if (cmp_nocase_uh(string, "dxt5") == 0) {
     return CM_dxt5;
+  } else if (cmp_nocase_uh(string, "bptc") == 0) {
+    return CM_bptc;
   } else {
     return CM_default;
   }
@@ -1225,6 +1227,8 @@ ostream &operator << (ostream &out, EggTexture::CompressionMode mode) {
     return out << "dxt4";
   case EggTexture::CM_dxt5:
     return out << "dxt5";
+  case EggTexture::CM_bptc:
+    return out << "bptc";
   }
 
   nassertr(false, out);
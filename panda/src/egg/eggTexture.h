@@ -69,6 +69,7 @@ PUBLISHED:
   enum CompressionMode {
     CM_default, CM_off, CM_on,
     CM_fxt1, CM_dxt1, CM_dxt2, CM_dxt3, CM_dxt4, CM_dxt5,
+    CM_bptc,
   };
   enum WrapMode {
     WM_unspecified, WM_clamp, WM_repeat,
@@ -24,6 +24,7 @@
 #include "animBundleNode.h"
 #include "animChannelMatrixXfmTable.h"
 #include "animChannelScalarTable.h"
+#include "config_chan.h"
 
 using std::min;
 
@@ -84,6 +85,11 @@ make_bundle() {
 
   bundle->sort_descendants();
 
+  if (quantize_channels) {
+    bundle->quantize_channels(quantize_chan_tolerance,
+                              quantize_chan_angle_tolerance);
+  }
+
   return bundle;
 }
 
@@ -1462,6 +1462,9 @@ convert_compression_mode(EggTexture::CompressionMode compression_mode) const {
   case EggTexture::CM_dxt5:
     return Texture::CM_dxt5;
 
+  case EggTexture::CM_bptc:
+    return Texture::CM_bptc;
+
   case EggTexture::CM_default:
     return Texture::CM_default;
   }
@@ -52,6 +52,7 @@
 #include "modelNode.h"
 #include "animBundleNode.h"
 #include "animChannelMatrixXfmTable.h"
+#include "animChannelMatrixQuantized.h"
 #include "characterJoint.h"
 #include "character.h"
 #include "string_utils.h"
@@ -307,6 +308,25 @@ EggGroupNode * EggSaver::convert_animGroup_node(AnimGroup *animGroup, double fps
       }
     }
     eggNode->add_child(egg_anim);
+
+  } else if (animGroup->is_of_type(AnimChannelMatrixQuantized::get_class_type())) {
+    // Expand the keys back into a table with one value per frame.
+    AnimChannelMatrixQuantized *channel = DCAST(AnimChannelMatrixQuantized, animGroup);
+    EggXfmSAnim *egg_anim = new EggXfmSAnim("xform");
+    egg_anim->set_fps(fps);
+    int num_frames = channel->get_num_frames();
+    for (int f = 0; f < num_frames; ++f) {
+      LVecBase3 components[4];
+      channel->get_scale(f, components[0]);
+      channel->get_shear(f, components[1]);
+      channel->get_hpr(f, components[2]);
+      channel->get_pos(f, components[3]);
+      for (int i = 0; i < num_matrix_components; i++) {
+        egg_anim->add_component_data(i, components[i / 3][i % 3]);
+      }
+    }
+    egg_anim->optimize();
+    eggNode->add_child(egg_anim);
   }
   for (int i = 0; i < num_children; i++) {
     AnimGroup *animChild = animGroup->get_child(i);
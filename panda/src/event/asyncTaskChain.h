@@ -25,6 +25,7 @@
 #include "pdeque.h"
 #include "pStatCollector.h"
 #include "clockObject.h"
+#include "patomic.h"
 
 class AsyncTaskManager;
 
@@ -82,6 +83,8 @@ PUBLISHED:
   template<class Callable>
   INLINE AsyncTask *add(Callable callable, std::string name,
                         int sort = 0, int priority = 0);
+  template<class Callable>
+  INLINE void parallel_for(size_t count, Callable callable);
 #endif
   bool has_task(AsyncTask *task) const;
 
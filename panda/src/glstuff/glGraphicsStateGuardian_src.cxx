@@ -1569,6 +1569,10 @@ reset() {
         has_extension("GL_EXT_texture_compression_rgtc")) {
       _compressed_texture_formats.set_bit(Texture::CM_rgtc);
     }
+    if (is_at_least_gl_version(4, 2) ||
+        has_extension("GL_ARB_texture_compression_bptc")) {
+      _compressed_texture_formats.set_bit(Texture::CM_bptc);
+    }
 #endif
   }
 
@@ -10961,6 +10965,19 @@ get_external_image_format(Texture *tex) const {
       }
       break;
 
+    case Texture::CM_bptc:
+#ifndef OPENGLES
+      if (tex->get_component_type() == Texture::T_float ||
+          tex->get_component_type() == Texture::T_half_float) {
+        return GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT;
+      } else if (format == Texture::F_srgb || format == Texture::F_srgb_alpha) {
+        return GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM;
+      } else {
+        return GL_COMPRESSED_RGBA_BPTC_UNORM;
+      }
+#endif
+      break;
+
     case Texture::CM_eac:
       if (Texture::is_unsigned(tex->get_component_type())) {
         if (tex->get_num_components() == 1) {
@@ -11477,6 +11494,19 @@ get_internal_image_format(Texture *tex, bool force_sized) const {
       }
       break;
 
+    case Texture::CM_bptc:
+#ifndef OPENGLES
+      if (component_type == Texture::T_float ||
+          component_type == Texture::T_half_float) {
+        return GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT;
+      } else if (format == Texture::F_srgb || format == Texture::F_srgb_alpha) {
+        return GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM;
+      } else {
+        return GL_COMPRESSED_RGBA_BPTC_UNORM;
+      }
+#endif
+      break;
+
     case Texture::CM_eac:
       if (Texture::is_unsigned(component_type)) {
         if (tex->get_num_components() == 1) {
@@ -11970,6 +12000,11 @@ is_compressed_format(GLenum format) {
   case GL_COMPRESSED_LUMINANCE_ALPHA_LATC2_EXT:
   case GL_COMPRESSED_SIGNED_LUMINANCE_ALPHA_LATC2_EXT:
 
+  case GL_COMPRESSED_RGBA_BPTC_UNORM:
+  case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+  case GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT:
+  case GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT:
+
   case GL_COMPRESSED_RGB:
   case GL_COMPRESSED_SRGB_EXT:
   case GL_COMPRESSED_RGBA:
@@ -14285,8 +14320,8 @@ upload_texture(CLP(TextureContext) *gtc, bool force, bool uses_mipmaps,
       image = tex->get_uncompressed_ram_image();
       image_compression = Texture::CM_off;
 
-      // If this triggers, Panda cannot decompress the texture.  Compile with
-      // libsquish support or precompress the texture.
+      // If this triggers, Panda cannot decompress the texture.  Precompress
+      // the texture in a format that Panda can decode.
       nassertr(!image.is_null(), false);
     }
   }
@@ -16399,6 +16434,19 @@ do_extract_texture_data(CLP(TextureContext) *gtc, int view) {
     format = Texture::F_rg;
     compression = Texture::CM_rgtc;
     break;
+  case GL_COMPRESSED_RGBA_BPTC_UNORM:
+    format = Texture::F_rgba;
+    compression = Texture::CM_bptc;
+    break;
+  case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+    format = Texture::F_srgb_alpha;
+    compression = Texture::CM_bptc;
+    break;
+  case GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT:
+    type = Texture::T_half_float;
+    format = Texture::F_rgb16;
+    compression = Texture::CM_bptc;
+    break;
 #endif
   default:
     GLCAT.warning()
@@ -0,0 +1,1694 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file blockCompressor.cxx
+ * @author rdb
+ * @date 2026-10-17
+ */
+
+#include "blockCompressor.h"
+
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+#if defined(__SSE2__) || (_M_IX86_FP >= 2) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define BLOCK_USE_SSE2
+#elif defined(__ARM_NEON) || defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define BLOCK_USE_NEON
+#endif
+
+using std::max;
+using std::min;
+
+// The interpolation weights of the 2-, 3- and 4-bit indices of BC6H and BC7,
+// out of 64.
+static const int bptc_weights2[4] = {
+  0, 21, 43, 64,
+};
+static const int bptc_weights3[8] = {
+  0, 9, 18, 27, 37, 46, 55, 64,
+};
+static const int bptc_weights4[16] = {
+  0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64,
+};
+static const int *const bptc_weights[5] = {
+  nullptr, nullptr, bptc_weights2, bptc_weights3, bptc_weights4,
+};
+
+// The subset that each pixel belongs to, for each of the partitions of a
+// block into two subsets, with one bit per pixel.  BC6H only uses the first
+// 32 of these.
+static const uint16_t bptc_partitions2[64] = {
+  0xcccc, 0x8888, 0xeeee, 0xecc8, 0xc880, 0xfeec, 0xfec8, 0xec80,
+  0xc800, 0xffec, 0xfe80, 0xe800, 0xffe8, 0xff00, 0xfff0, 0xf000,
+  0xf710, 0x008e, 0x7100, 0x08ce, 0x008c, 0x7310, 0x3100, 0x8cce,
+  0x088c, 0x3110, 0x6666, 0x366c, 0x17e8, 0x0ff0, 0x718e, 0x399c,
+  0xaaaa, 0xf0f0, 0x5a5a, 0x33cc, 0x3c3c, 0x55aa, 0x9696, 0xa55a,
+  0x73ce, 0x13c8, 0x324c, 0x3bdc, 0x6996, 0xc33c, 0x9966, 0x0660,
+  0x0272, 0x04e4, 0x4e40, 0x2720, 0xc936, 0x936c, 0x39c6, 0x639c,
+  0x9336, 0x9cc6, 0x817e, 0xe718, 0xccf0, 0x0fcc, 0x7744, 0xee22,
+};
+
+// The same for the partitions into three subsets, with two bits per pixel.
+static const uint32_t bptc_partitions3[64] = {
+  0xaa685050, 0x6a5a5040, 0x5a5a4200, 0x5450a0a8,
+  0xa5a50000, 0xa0a05050, 0x5555a0a0, 0x5a5a5050,
+  0xaa550000, 0xaa555500, 0xaaaa5500, 0x90909090,
+  0x94949494, 0xa4a4a4a4, 0xa9a59450, 0x2a0a4250,
+  0xa5945040, 0x0a425054, 0xa5a5a500, 0x55a0a0a0,
+  0xa8a85454, 0x6a6a4040, 0xa4a45000, 0x1a1a0500,
+  0x0050a4a4, 0xaaa59090, 0x14696914, 0x69691400,
+  0xa08585a0, 0xaa821414, 0x50a4a450, 0x6a5a0200,
+  0xa9a58000, 0x5090a0a8, 0xa8a09050, 0x24242424,
+  0x00aa5500, 0x24924924, 0x24499224, 0x50a50a50,
+  0x500aa550, 0xaaaa4444, 0x66660000, 0xa5a0a5a0,
+  0x50a050a0, 0x69286928, 0x44aaaa44, 0x66666600,
+  0xaa444444, 0x54a854a8, 0x95809580, 0x96969600,
+  0xa85454a8, 0x80959580, 0xaa141414, 0x96960000,
+  0xaaaa1414, 0xa05050a0, 0xa0a5a5a0, 0x96000000,
+  0x40804080, 0xa9a8a9a8, 0xaaaaaa44, 0x2a4a5254,
+};
+
+// The index of the pixel of the second subset whose index is stored with one
+// bit less, because its most significant bit is implied to be 0.  The first
+// subset always has this on pixel 0.
+static const unsigned char bptc_anchors2[64] = {
+  15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+  15,  2,  8,  2,  2,  8,  8, 15,  2,  8,  2,  2,  8,  8,  2,  2,
+  15, 15,  6,  8,  2,  8, 15, 15,  2,  8,  2,  2,  2, 15, 15,  6,
+   6,  2,  6,  8, 15, 15,  2,  2, 15, 15, 15, 15, 15,  2,  2, 15,
+};
+
+// The same for the second and the third subset of the partitions into three.
+static const unsigned char bptc_anchors3[2][64] = {
+  {
+     3,  3, 15, 15,  8,  3, 15, 15,  8,  8,  6,  6,  6,  5,  3,  3,
+     3,  3,  8, 15,  3,  3,  6, 10,  5,  8,  8,  6,  8,  5, 15, 15,
+     8, 15,  3,  5,  6, 10,  8, 15, 15,  3, 15,  5, 15, 15, 15, 15,
+     3, 15,  5,  5,  5,  8,  5, 10,  5, 10,  8, 13, 15, 12,  3,  3,
+  },
+  {
+    15,  8,  8,  3, 15, 15,  3,  8, 15, 15, 15, 15, 15, 15, 15,  8,
+    15,  8, 15,  3, 15,  8, 15,  8,  3, 15,  6, 10, 15, 15, 10,  8,
+    15,  3, 15, 10, 10,  8,  9, 10,  6, 15,  8, 15,  3,  6,  6,  8,
+    15,  3, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,  3, 15, 15,  8,
+  },
+};
+
+/**
+ * The layout of each of the eight modes of BC7.
+ */
+struct BC7Mode {
+  int _num_subsets;
+  int _partition_bits;
+  int _rotation_bits;
+  int _index_selection_bits;
+  int _color_bits;
+  int _alpha_bits;
+  bool _endpoint_pbits;
+  bool _shared_pbits;
+  int _index_bits;
+  int _index_bits2;
+};
+
+static const BC7Mode bc7_modes[8] = {
+  {3, 4, 0, 0, 4, 0, true, false, 3, 0},
+  {2, 6, 0, 0, 6, 0, false, true, 3, 0},
+  {3, 6, 0, 0, 5, 0, false, false, 2, 0},
+  {2, 6, 0, 0, 7, 0, true, false, 2, 0},
+  {1, 0, 2, 1, 5, 6, false, false, 2, 3},
+  {1, 0, 2, 0, 7, 8, false, false, 2, 2},
+  {1, 0, 0, 0, 7, 7, true, false, 4, 0},
+  {2, 6, 0, 0, 5, 5, true, false, 2, 0},
+};
+
+// The endpoint components of BC6H, named as in the specification: w and x
+// are the endpoints of the first subset, y and z those of the second.
+enum BC6HComponent {
+  RW, GW, BW, RX, GX, BX, RY, GY, BY, RZ, GZ, BZ,
+};
+
+/**
+ * A run of bits of a BC6H endpoint component, stored starting with the
+ * indicated bit of the component.
+ */
+struct BC6HField {
+  unsigned char _component;
+  unsigned char _shift;
+  unsigned char _num_bits;
+};
+
+/**
+ * The layout of each of the 14 modes of BC6H.  The endpoint components are
+ * stored in the listed runs of bits, following the mode bits.  In the
+ * transformed modes, all but the first endpoint are stored as a difference
+ * from the first, with fewer bits.
+ */
+struct BC6HMode {
+  unsigned int _mode;
+  bool _partitioned;
+  bool _transformed;
+  int _endpoint_bits;
+  int _delta_bits[3];
+  BC6HField _fields[25];
+};
+
+static const BC6HMode bc6h_modes[14] = {
+  {0x00, true, true, 10, {5, 5, 5}, {
+    {GY, 4, 1}, {BY, 4, 1}, {BZ, 4, 1}, {RW, 0, 10}, {GW, 0, 10}, {BW, 0, 10},
+    {RX, 0, 5}, {GZ, 4, 1}, {GY, 0, 4}, {GX, 0, 5}, {BZ, 0, 1}, {GZ, 0, 4},
+    {BX, 0, 5}, {BZ, 1, 1}, {BY, 0, 4}, {RY, 0, 5}, {BZ, 2, 1}, {RZ, 0, 5},
+    {BZ, 3, 1}}},
+  {0x01, true, true, 7, {6, 6, 6}, {
+    {GY, 5, 1}, {GZ, 4, 1}, {GZ, 5, 1}, {RW, 0, 7}, {BZ, 0, 1}, {BZ, 1, 1},
+    {BY, 4, 1}, {GW, 0, 7}, {BY, 5, 1}, {BZ, 2, 1}, {GY, 4, 1}, {BW, 0, 7},
+    {BZ, 3, 1}, {BZ, 5, 1}, {BZ, 4, 1}, {RX, 0, 6}, {GY, 0, 4}, {GX, 0, 6},
+    {GZ, 0, 4}, {BX, 0, 6}, {BY, 0, 4}, {RY, 0, 6}, {RZ, 0, 6}}},
+  {0x02, true, true, 11, {5, 4, 4}, {
+    {RW, 0, 10}, {GW, 0, 10}, {BW, 0, 10}, {RX, 0, 5}, {RW, 10, 1}, {GY, 0, 4},
+    {GX, 0, 4}, {GW, 10, 1}, {BZ, 0, 1}, {GZ, 0, 4}, {BX, 0, 4}, {BW, 10, 1},
+    {BZ, 1, 1}, {BY, 0, 4}, {RY, 0, 5}, {BZ, 2, 1}, {RZ, 0, 5}, {BZ, 3, 1}}},
+  {0x06, true, true, 11, {4, 5, 4}, {
+    {RW, 0, 10}, {GW, 0, 10}, {BW, 0, 10}, {RX, 0, 4}, {RW, 10, 1}, {GZ, 4, 1},
+    {GY, 0, 4}, {GX, 0, 5}, {GW, 10, 1}, {GZ, 0, 4}, {BX, 0, 4}, {BW, 10, 1},
+    {BZ, 1, 1}, {BY, 0, 4}, {RY, 0, 4}, {BZ, 0, 1}, {BZ, 2, 1}, {RZ, 0, 4},
+    {GY, 4, 1}, {BZ, 3, 1}}},
+  {0x0a, true, true, 11, {4, 4, 5}, {
+    {RW, 0, 10}, {GW, 0, 10}, {BW, 0, 10}, {RX, 0, 4}, {RW, 10, 1}, {BY, 4, 1},
+    {GY, 0, 4}, {GX, 0, 4}, {GW, 10, 1}, {BZ, 0, 1}, {GZ, 0, 4}, {BX, 0, 5},
+    {BW, 10, 1}, {BY, 0, 4}, {RY, 0, 4}, {BZ, 1, 1}, {BZ, 2, 1}, {RZ, 0, 4},
+    {BZ, 4, 1}, {BZ, 3, 1}}},
+  {0x0e, true, true, 9, {5, 5, 5}, {
+    {RW, 0, 9}, {BY, 4, 1}, {GW, 0, 9}, {GY, 4, 1}, {BW, 0, 9}, {BZ, 4, 1},
+    {RX, 0, 5}, {GZ, 4, 1}, {GY, 0, 4}, {GX, 0, 5}, {BZ, 0, 1}, {GZ, 0, 4},
+    {BX, 0, 5}, {BZ, 1, 1}, {BY, 0, 4}, {RY, 0, 5}, {BZ, 2, 1}, {RZ, 0, 5},
+    {BZ, 3, 1}}},
+  {0x12, true, true, 8, {6, 5, 5}, {
+    {RW, 0, 8}, {GZ, 4, 1}, {BY, 4, 1}, {GW, 0, 8}, {BZ, 2, 1}, {GY, 4, 1},
+    {BW, 0, 8}, {BZ, 3, 1}, {BZ, 4, 1}, {RX, 0, 6}, {GY, 0, 4}, {GX, 0, 5},
+    {BZ, 0, 1}, {GZ, 0, 4}, {BX, 0, 5}, {BZ, 1, 1}, {BY, 0, 4}, {RY, 0, 6},
+    {RZ, 0, 6}}},
+  {0x16, true, true, 8, {5, 6, 5}, {
+    {RW, 0, 8}, {BZ, 0, 1}, {BY, 4, 1}, {GW, 0, 8}, {GY, 5, 1}, {GY, 4, 1},
+    {BW, 0, 8}, {GZ, 5, 1}, {BZ, 4, 1}, {RX, 0, 5}, {GZ, 4, 1}, {GY, 0, 4},
+    {GX, 0, 6}, {GZ, 0, 4}, {BX, 0, 5}, {BZ, 1, 1}, {BY, 0, 4}, {RY, 0, 5},
+    {BZ, 2, 1}, {RZ, 0, 5}, {BZ, 3, 1}}},
+  {0x1a, true, true, 8, {5, 5, 6}, {
+    {RW, 0, 8}, {BZ, 1, 1}, {BY, 4, 1}, {GW, 0, 8}, {BY, 5, 1}, {GY, 4, 1},
+    {BW, 0, 8}, {BZ, 5, 1}, {BZ, 4, 1}, {RX, 0, 5}, {GZ, 4, 1}, {GY, 0, 4},
+    {GX, 0, 5}, {BZ, 0, 1}, {GZ, 0, 4}, {BX, 0, 6}, {BY, 0, 4}, {RY, 0, 5},
+    {BZ, 2, 1}, {RZ, 0, 5}, {BZ, 3, 1}}},
+  {0x1e, true, false, 6, {6, 6, 6}, {
+    {RW, 0, 6}, {GZ, 4, 1}, {BZ, 0, 1}, {BZ, 1, 1}, {BY, 4, 1}, {GW, 0, 6},
+    {GY, 5, 1}, {BY, 5, 1}, {BZ, 2, 1}, {GY, 4, 1}, {BW, 0, 6}, {GZ, 5, 1},
+    {BZ, 3, 1}, {BZ, 5, 1}, {BZ, 4, 1}, {RX, 0, 6}, {GY, 0, 4}, {GX, 0, 6},
+    {GZ, 0, 4}, {BX, 0, 6}, {BY, 0, 4}, {RY, 0, 6}, {RZ, 0, 6}}},
+  {0x03, false, false, 10, {10, 10, 10}, {
+    {RW, 0, 10}, {GW, 0, 10}, {BW, 0, 10}, {RX, 0, 10}, {GX, 0, 10},
+    {BX, 0, 10}}},
+  {0x07, false, true, 11, {9, 9, 9}, {
+    {RW, 0, 10}, {GW, 0, 10}, {BW, 0, 10}, {RX, 0, 9}, {RW, 10, 1}, {GX, 0, 9},
+    {GW, 10, 1}, {BX, 0, 9}, {BW, 10, 1}}},
+  // The most significant bits of the first endpoint are stored in reverse
+  // order in the last two modes.
+  {0x0b, false, true, 12, {8, 8, 8}, {
+    {RW, 0, 10}, {GW, 0, 10}, {BW, 0, 10}, {RX, 0, 8}, {RW, 11, 1},
+    {RW, 10, 1}, {GX, 0, 8}, {GW, 11, 1}, {GW, 10, 1}, {BX, 0, 8}, {BW, 11, 1},
+    {BW, 10, 1}}},
+  {0x0f, false, true, 16, {4, 4, 4}, {
+    {RW, 0, 10}, {GW, 0, 10}, {BW, 0, 10}, {RX, 0, 4}, {RW, 15, 1},
+    {RW, 14, 1}, {RW, 13, 1}, {RW, 12, 1}, {RW, 11, 1}, {RW, 10, 1},
+    {GX, 0, 4}, {GW, 15, 1}, {GW, 14, 1}, {GW, 13, 1}, {GW, 12, 1},
+    {GW, 11, 1}, {GW, 10, 1}, {BX, 0, 4}, {BW, 15, 1}, {BW, 14, 1},
+    {BW, 13, 1}, {BW, 12, 1}, {BW, 11, 1}, {BW, 10, 1}}},
+};
+
+/**
+ * Returns the subset to which the indicated pixel belongs in the indicated
+ * partition of a BC6H or BC7 block.
+ */
+static inline int
+bptc_subset(int num_subsets, int partition, int i) {
+  switch (num_subsets) {
+  case 2:
+    return (bptc_partitions2[partition] >> i) & 1;
+  case 3:
+    return (bptc_partitions3[partition] >> (i * 2)) & 3;
+  default:
+    return 0;
+  }
+}
+
+/**
+ * Returns true if the index of the indicated pixel is stored with one bit
+ * less, because it is the first pixel of its subset.
+ */
+static inline bool
+bptc_is_anchor(int num_subsets, int partition, int i) {
+  switch (num_subsets) {
+  case 2:
+    return i == 0 || i == bptc_anchors2[partition];
+  case 3:
+    return i == 0 || i == bptc_anchors3[0][partition] ||
+           i == bptc_anchors3[1][partition];
+  default:
+    return i == 0;
+  }
+}
+
+/**
+ * The pixels of a block that is being encoded, stored one channel at a time,
+ * so that the distances of four pixels to a palette entry can be computed at
+ * once.  Pixels with a weight of 0 do not count towards the fit.
+ */
+struct BlockPixels {
+  float _c[4][16];
+  float _weight[16];
+  int _num_channels;
+};
+
+/**
+ * Writes a bit stream into a 16-byte block, starting at the least significant
+ * bit of the first byte, as BC6H and BC7 are laid out.
+ */
+class BlockBitWriter {
+public:
+  BlockBitWriter(unsigned char *dest) : _dest(dest), _pos(0) {
+    memset(dest, 0, 16);
+  }
+
+  void write(unsigned int value, int num_bits) {
+    for (int i = 0; i < num_bits; ++i, ++_pos) {
+      if (value & (1u << i)) {
+        _dest[_pos >> 3] |= (unsigned char)(1u << (_pos & 7));
+      }
+    }
+  }
+
+private:
+  unsigned char *_dest;
+  int _pos;
+};
+
+/**
+ * Reads back a bit stream written by BlockBitWriter.
+ */
+class BlockBitReader {
+public:
+  BlockBitReader(const unsigned char *src) : _src(src), _pos(0) {}
+
+  unsigned int read(int num_bits) {
+    unsigned int value = 0;
+    for (int i = 0; i < num_bits; ++i, ++_pos) {
+      value |= (unsigned int)((_src[_pos >> 3] >> (_pos & 7)) & 1) << i;
+    }
+    return value;
+  }
+
+private:
+  const unsigned char *_src;
+  int _pos;
+};
+
+/**
+ * For each pixel of the block, finds the palette entry that is closest to it,
+ * and stores its index.  Returns the total weighted squared error.
+ */
+static float
+block_find_indices(const BlockPixels &pixels, const float (*palette)[4],
+                   int num_entries, int *indices) {
+  const int num_channels = pixels._num_channels;
+
+#if defined(BLOCK_USE_SSE2)
+  __m128 total = _mm_setzero_ps();
+  for (int i = 0; i < 16; i += 4) {
+    __m128 px[4] = {};
+    for (int c = 0; c < num_channels; ++c) {
+      px[c] = _mm_loadu_ps(&pixels._c[c][i]);
+    }
+    __m128 best_err = _mm_set1_ps(FLT_MAX);
+    __m128i best_index = _mm_setzero_si128();
+    for (int e = 0; e < num_entries; ++e) {
+      __m128 d = _mm_sub_ps(px[0], _mm_set1_ps(palette[e][0]));
+      __m128 err = _mm_mul_ps(d, d);
+      for (int c = 1; c < num_channels; ++c) {
+        d = _mm_sub_ps(px[c], _mm_set1_ps(palette[e][c]));
+        err = _mm_add_ps(err, _mm_mul_ps(d, d));
+      }
+      __m128i closer = _mm_castps_si128(_mm_cmplt_ps(err, best_err));
+      best_err = _mm_min_ps(err, best_err);
+      best_index = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(e)),
+                                _mm_andnot_si128(closer, best_index));
+    }
+    _mm_storeu_si128((__m128i *)&indices[i], best_index);
+    total = _mm_add_ps(total, _mm_mul_ps(best_err, _mm_loadu_ps(&pixels._weight[i])));
+  }
+  float sums[4];
+  _mm_storeu_ps(sums, total);
+  return (sums[0] + sums[1]) + (sums[2] + sums[3]);
+
+#elif defined(BLOCK_USE_NEON)
+  float32x4_t total = vdupq_n_f32(0.0f);
+  for (int i = 0; i < 16; i += 4) {
+    float32x4_t px[4] = {};
+    for (int c = 0; c < num_channels; ++c) {
+      px[c] = vld1q_f32(&pixels._c[c][i]);
+    }
+    float32x4_t best_err = vdupq_n_f32(FLT_MAX);
+    uint32x4_t best_index = vdupq_n_u32(0);
+    for (int e = 0; e < num_entries; ++e) {
+      float32x4_t d = vsubq_f32(px[0], vdupq_n_f32(palette[e][0]));
+      float32x4_t err = vmulq_f32(d, d);
+      for (int c = 1; c < num_channels; ++c) {
+        d = vsubq_f32(px[c], vdupq_n_f32(palette[e][c]));
+        err = vmlaq_f32(err, d, d);
+      }
+      uint32x4_t closer = vcltq_f32(err, best_err);
+      best_err = vminq_f32(err, best_err);
+      best_index = vbslq_u32(closer, vdupq_n_u32((uint32_t)e), best_index);
+    }
+    vst1q_s32(&indices[i], vreinterpretq_s32_u32(best_index));
+    total = vmlaq_f32(total, best_err, vld1q_f32(&pixels._weight[i]));
+  }
+  float sums[4];
+  vst1q_f32(sums, total);
+  return (sums[0] + sums[1]) + (sums[2] + sums[3]);
+
+#else
+  float total = 0.0f;
+  for (int i = 0; i < 16; ++i) {
+    float best_err = FLT_MAX;
+    int best_index = 0;
+    for (int e = 0; e < num_entries; ++e) {
+      float err = 0.0f;
+      for (int c = 0; c < num_channels; ++c) {
+        float d = pixels._c[c][i] - palette[e][c];
+        err += d * d;
+      }
+      if (err < best_err) {
+        best_err = err;
+        best_index = e;
+      }
+    }
+    indices[i] = best_index;
+    total += best_err * pixels._weight[i];
+  }
+  return total;
+#endif
+}
+
+/**
+ * Finds the line through the pixels of the block along which they vary the
+ * most, and returns the two extreme points on it.
+ */
+static void
+block_fit_line(const BlockPixels &pixels, float lo[4], float hi[4]) {
+  const int num_channels = pixels._num_channels;
+
+  float total_weight = 0.0f;
+  float mean[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+  for (int i = 0; i < 16; ++i) {
+    float w = pixels._weight[i];
+    total_weight += w;
+    for (int c = 0; c < num_channels; ++c) {
+      mean[c] += w * pixels._c[c][i];
+    }
+  }
+  if (total_weight <= 0.0f) {
+    for (int c = 0; c < num_channels; ++c) {
+      lo[c] = hi[c] = 0.0f;
+    }
+    return;
+  }
+  for (int c = 0; c < num_channels; ++c) {
+    mean[c] /= total_weight;
+  }
+
+  float cov[4][4] = {};
+  for (int i = 0; i < 16; ++i) {
+    float w = pixels._weight[i];
+    for (int a = 0; a < num_channels; ++a) {
+      float da = pixels._c[a][i] - mean[a];
+      for (int b = a; b < num_channels; ++b) {
+        cov[a][b] += w * da * (pixels._c[b][i] - mean[b]);
+      }
+    }
+  }
+  for (int a = 0; a < num_channels; ++a) {
+    for (int b = 0; b < a; ++b) {
+      cov[a][b] = cov[b][a];
+    }
+  }
+
+  // Find the principal axis by power iteration, starting from the row of the
+  // channel that varies the most.
+  int largest = 0;
+  for (int c = 1; c < num_channels; ++c) {
+    if (cov[c][c] > cov[largest][largest]) {
+      largest = c;
+    }
+  }
+  float axis[4];
+  for (int c = 0; c < num_channels; ++c) {
+    axis[c] = cov[largest][c];
+  }
+  for (int it = 0; it < 8; ++it) {
+    float next[4];
+    float scale = 0.0f;
+    for (int a = 0; a < num_channels; ++a) {
+      next[a] = 0.0f;
+      for (int b = 0; b < num_channels; ++b) {
+        next[a] += cov[a][b] * axis[b];
+      }
+      scale = max(scale, fabsf(next[a]));
+    }
+    if (scale <= 0.0f) {
+      break;
+    }
+    for (int a = 0; a < num_channels; ++a) {
+      axis[a] = next[a] / scale;
+    }
+  }
+
+  float length2 = 0.0f;
+  for (int c = 0; c < num_channels; ++c) {
+    length2 += axis[c] * axis[c];
+  }
+  if (length2 < 1.0e-12f) {
+    // All of the pixels have the same color.
+    for (int c = 0; c < num_channels; ++c) {
+      lo[c] = hi[c] = mean[c];
+    }
+    return;
+  }
+
+  float tmin = FLT_MAX;
+  float tmax = -FLT_MAX;
+  for (int i = 0; i < 16; ++i) {
+    if (pixels._weight[i] > 0.0f) {
+      float t = 0.0f;
+      for (int c = 0; c < num_channels; ++c) {
+        t += (pixels._c[c][i] - mean[c]) * axis[c];
+      }
+      tmin = min(tmin, t);
+      tmax = max(tmax, t);
+    }
+  }
+  for (int c = 0; c < num_channels; ++c) {
+    lo[c] = mean[c] + axis[c] * (tmin / length2);
+    hi[c] = mean[c] + axis[c] * (tmax / length2);
+  }
+}
+
+/**
+ * Given the palette index chosen for each pixel, and the position of each
+ * palette entry between the two endpoints, computes the endpoints that
+ * minimize the squared error with a least-squares fit.  Returns false if the
+ * indices do not determine the endpoints.
+ */
+static bool
+block_refit_line(const BlockPixels &pixels, const int *indices,
+                 const float *factors, float lo[4], float hi[4]) {
+  const int num_channels = pixels._num_channels;
+
+  float aa = 0.0f, bb = 0.0f, ab = 0.0f;
+  float ax[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+  float bx[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+  for (int i = 0; i < 16; ++i) {
+    float w = pixels._weight[i];
+    if (w <= 0.0f) {
+      continue;
+    }
+    float b = factors[indices[i]];
+    float a = 1.0f - b;
+    aa += w * a * a;
+    bb += w * b * b;
+    ab += w * a * b;
+    for (int c = 0; c < num_channels; ++c) {
+      ax[c] += w * a * pixels._c[c][i];
+      bx[c] += w * b * pixels._c[c][i];
+    }
+  }
+
+  float det = aa * bb - ab * ab;
+  if (fabsf(det) < 1.0e-6f) {
+    return false;
+  }
+  float inv_det = 1.0f / det;
+  for (int c = 0; c < num_channels; ++c) {
+    lo[c] = (ax[c] * bb - bx[c] * ab) * inv_det;
+    hi[c] = (bx[c] * aa - ax[c] * ab) * inv_det;
+  }
+  return true;
+}
+
+/**
+ * Returns the number of times the endpoints are refit to the chosen indices
+ * for the given quality level.
+ */
+static int
+block_num_refits(Texture::QualityLevel quality) {
+  switch (quality) {
+  case Texture::QL_fastest:
+    return 0;
+  case Texture::QL_best:
+    return 3;
+  default:
+    return 1;
+  }
+}
+
+/**
+ * Converts an RGB color to the 5:6:5 format of the BC1 endpoints.
+ */
+static unsigned int
+block_pack_565(const float color[4]) {
+  int r = (int)(min(max(color[0], 0.0f), 255.0f) * (31.0f / 255.0f) + 0.5f);
+  int g = (int)(min(max(color[1], 0.0f), 255.0f) * (63.0f / 255.0f) + 0.5f);
+  int b = (int)(min(max(color[2], 0.0f), 255.0f) * (31.0f / 255.0f) + 0.5f);
+  return (r << 11) | (g << 5) | b;
+}
+
+/**
+ * Computes the four colors that the indices of a BC1 block refer to.
+ */
+static void
+block_bc1_palette(unsigned int c0, unsigned int c1, bool four_color,
+                  int palette[4][4]) {
+  unsigned int colors[2] = {c0, c1};
+  for (int e = 0; e < 2; ++e) {
+    int r = (colors[e] >> 11) & 0x1f;
+    int g = (colors[e] >> 5) & 0x3f;
+    int b = colors[e] & 0x1f;
+    palette[e][0] = (r << 3) | (r >> 2);
+    palette[e][1] = (g << 2) | (g >> 4);
+    palette[e][2] = (b << 3) | (b >> 2);
+    palette[e][3] = 255;
+  }
+  for (int c = 0; c < 3; ++c) {
+    if (four_color) {
+      palette[2][c] = (palette[0][c] * 2 + palette[1][c]) / 3;
+      palette[3][c] = (palette[0][c] + palette[1][c] * 2) / 3;
+    } else {
+      palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+      palette[3][c] = 0;
+    }
+  }
+  palette[2][3] = 255;
+  palette[3][3] = four_color ? 255 : 0;
+}
+
+/**
+ * Computes the eight values that the indices of a BC4 block refer to.
+ */
+static void
+block_bc4_palette(int a0, int a1, int palette[8]) {
+  palette[0] = a0;
+  palette[1] = a1;
+  if (a0 > a1) {
+    for (int k = 1; k < 7; ++k) {
+      palette[k + 1] = (a0 * (7 - k) + a1 * k + 3) / 7;
+    }
+  } else {
+    for (int k = 1; k < 5; ++k) {
+      palette[k + 1] = (a0 * (5 - k) + a1 * k + 2) / 5;
+    }
+    palette[6] = 0;
+    palette[7] = 255;
+  }
+}
+
+/**
+ * Sign-extends the indicated number of low bits of the value.
+ */
+static inline int
+block_sign_extend(int value, int num_bits) {
+  int sign = 1 << (num_bits - 1);
+  return ((value & ((sign << 1) - 1)) ^ sign) - sign;
+}
+
+/**
+ * Returns the value that a BC6H endpoint with the indicated number of bits
+ * stands for, on the 16-bit scale (or the signed 15-bit scale) on which it is
+ * interpolated.
+ */
+static inline int
+block_bc6h_unquantize(int q, int num_bits, bool is_signed) {
+  if (!is_signed) {
+    if (num_bits >= 15 || q == 0) {
+      return q;
+    } else if (q == (1 << num_bits) - 1) {
+      return 0xffff;
+    } else {
+      return ((q << 16) + 0x8000) >> num_bits;
+    }
+  }
+
+  if (num_bits >= 16) {
+    return q;
+  }
+  int magnitude = (q < 0) ? -q : q;
+  int value;
+  if (magnitude == 0) {
+    value = 0;
+  } else if (magnitude >= (1 << (num_bits - 1)) - 1) {
+    value = 0x7fff;
+  } else {
+    value = ((magnitude << 15) + 0x4000) >> (num_bits - 1);
+  }
+  return (q < 0) ? -value : value;
+}
+
+/**
+ * Converts an interpolated BC6H value to the bits of a half-float.
+ */
+static inline uint16_t
+block_bc6h_finish(int value, bool is_signed) {
+  if (!is_signed) {
+    return (uint16_t)((value * 31) >> 6);
+  } else if (value < 0) {
+    return (uint16_t)(0x8000 | ((-value * 31) >> 5));
+  } else {
+    return (uint16_t)((value * 31) >> 5);
+  }
+}
+
+/**
+ * Returns the 10-bit BC6H endpoint that stands for the value closest to the
+ * indicated value on the 16-bit interpolation scale.
+ */
+static int
+block_bc6h_quantize(float value) {
+  int guess = (int)((value - 32.0f) * (1.0f / 64.0f) + 0.5f);
+  int best = 0;
+  float best_err = FLT_MAX;
+  for (int q = guess - 1; q <= guess + 1; ++q) {
+    int qc = min(max(q, 0), 1023);
+    float err = fabsf((float)block_bc6h_unquantize(qc, 10, false) - value);
+    if (err < best_err) {
+      best_err = err;
+      best = qc;
+    }
+  }
+  return best;
+}
+
+/**
+ * Fits a pair of BC7 endpoints with the indicated number of bits per channel,
+ * and without extra low bits, to the pixels, for use with 2-bit indices.
+ * Stores the endpoints, and the indices of the pixels, with the most
+ * significant bit of the first index cleared as the format requires.  Returns
+ * the squared error.
+ */
+static float
+block_fit_bptc_endpoints(const BlockPixels &pixels, int num_bits,
+                         Texture::QualityLevel quality, int v[2][4],
+                         int indices[16]) {
+  const int num_channels = pixels._num_channels;
+  const int max_value = (1 << num_bits) - 1;
+
+  float factors[4];
+  for (int k = 0; k < 4; ++k) {
+    factors[k] = bptc_weights2[k] * (1.0f / 64.0f);
+  }
+
+  float lo[4], hi[4];
+  block_fit_line(pixels, lo, hi);
+
+  int num_refits = block_num_refits(quality);
+  float best_err = FLT_MAX;
+  for (int it = 0; it <= num_refits; ++it) {
+    const float *ends[2] = {lo, hi};
+    int q[2][4] = {};
+    int values[2][4] = {};
+    for (int e = 0; e < 2; ++e) {
+      for (int c = 0; c < num_channels; ++c) {
+        float scaled = ends[e][c] * ((float)max_value / 255.0f);
+        q[e][c] = min(max((int)floorf(scaled + 0.5f), 0), max_value);
+        int value = q[e][c] << (8 - num_bits);
+        values[e][c] = value | (value >> num_bits);
+      }
+    }
+
+    float palette[4][4] = {};
+    for (int k = 0; k < 4; ++k) {
+      int w = bptc_weights2[k];
+      for (int c = 0; c < num_channels; ++c) {
+        palette[k][c] = (float)((values[0][c] * (64 - w) + values[1][c] * w + 32) >> 6);
+      }
+    }
+
+    int iter_indices[16];
+    float err = block_find_indices(pixels, palette, 4, iter_indices);
+    if (err < best_err) {
+      best_err = err;
+      memcpy(v, q, sizeof(q));
+      memcpy(indices, iter_indices, sizeof(iter_indices));
+    }
+    if (it == num_refits || err == 0.0f ||
+        !block_refit_line(pixels, iter_indices, factors, lo, hi)) {
+      break;
+    }
+  }
+
+  if (indices[0] & 2) {
+    for (int c = 0; c < 4; ++c) {
+      std::swap(v[0][c], v[1][c]);
+    }
+    for (int i = 0; i < 16; ++i) {
+      indices[i] = 3 - indices[i];
+    }
+  }
+  return best_err;
+}
+
+/**
+ * Encodes the indicated block of 16 RGBA pixels into the indicated format,
+ * writing get_block_size() bytes to dest.  Use compress_block_bc6h() for
+ * BC6H.
+ */
+void BlockCompressor::
+compress_block(BlockFormat format, const unsigned char *rgba,
+               unsigned char *dest, Texture::QualityLevel quality) {
+  switch (format) {
+  case BF_bc1:
+    compress_bc1(rgba, dest, true, quality);
+    break;
+
+  case BF_bc2:
+    for (int i = 0; i < 16; i += 2) {
+      int a0 = (rgba[i * 4 + 3] * 15 + 127) / 255;
+      int a1 = (rgba[i * 4 + 7] * 15 + 127) / 255;
+      dest[i >> 1] = (unsigned char)(a0 | (a1 << 4));
+    }
+    compress_bc1(rgba, dest + 8, false, quality);
+    break;
+
+  case BF_bc3:
+    compress_bc4(rgba + 3, 4, dest, quality);
+    compress_bc1(rgba, dest + 8, false, quality);
+    break;
+
+  case BF_bc4:
+    compress_bc4(rgba, 4, dest, quality);
+    break;
+
+  case BF_bc5:
+    compress_bc4(rgba, 4, dest, quality);
+    compress_bc4(rgba + 1, 4, dest + 8, quality);
+    break;
+
+  case BF_bc6h:
+    nassert_raise("use compress_block_bc6h() for BC6H");
+    break;
+
+  case BF_bc7:
+    compress_bc7(rgba, dest, quality);
+    break;
+  }
+}
+
+/**
+ * Encodes the indicated block of 16 RGB pixels, given as half-floats, into a
+ * BC6H block of 16 bytes.  Negative values are encoded as 0, and infinite
+ * values as the largest finite value.
+ */
+void BlockCompressor::
+compress_block_bc6h(const uint16_t *rgb, unsigned char *dest,
+                    Texture::QualityLevel quality) {
+  // BC6H interpolates the bit patterns of the half-floats, after scaling them
+  // up to 16 bits, so that is also the space in which we fit the endpoints.
+  BlockPixels pixels;
+  pixels._num_channels = 3;
+  for (int i = 0; i < 16; ++i) {
+    for (int c = 0; c < 3; ++c) {
+      int h = rgb[i * 3 + c];
+      if (h & 0x8000) {
+        h = 0;
+      } else if (h > 0x7bff) {
+        h = 0x7bff;
+      }
+      pixels._c[c][i] = (float)((h * 64 + 30) / 31);
+    }
+    pixels._c[3][i] = 0.0f;
+    pixels._weight[i] = 1.0f;
+  }
+
+  float factors[16];
+  for (int k = 0; k < 16; ++k) {
+    factors[k] = bptc_weights4[k] * (1.0f / 64.0f);
+  }
+
+  float lo[4], hi[4];
+  block_fit_line(pixels, lo, hi);
+
+  int num_refits = block_num_refits(quality);
+  float best_err = FLT_MAX;
+  int best_q[2][3];
+  int best_indices[16];
+  for (int it = 0; it <= num_refits; ++it) {
+    int q[2][3];
+    int ends[2][3];
+    for (int c = 0; c < 3; ++c) {
+      q[0][c] = block_bc6h_quantize(lo[c]);
+      q[1][c] = block_bc6h_quantize(hi[c]);
+      ends[0][c] = block_bc6h_unquantize(q[0][c], 10, false);
+      ends[1][c] = block_bc6h_unquantize(q[1][c], 10, false);
+    }
+
+    float palette[16][4];
+    for (int k = 0; k < 16; ++k) {
+      int w = bptc_weights4[k];
+      for (int c = 0; c < 3; ++c) {
+        palette[k][c] = (float)((ends[0][c] * (64 - w) + ends[1][c] * w + 32) >> 6);
+      }
+    }
+
+    int indices[16];
+    float err = block_find_indices(pixels, palette, 16, indices);
+    if (err < best_err) {
+      best_err = err;
+      memcpy(best_q, q, sizeof(q));
+      memcpy(best_indices, indices, sizeof(indices));
+    }
+    if (it == num_refits || err == 0.0f ||
+        !block_refit_line(pixels, indices, factors, lo, hi)) {
+      break;
+    }
+  }
+
+  // The most significant bit of the first index is implied to be 0.
+  if (best_indices[0] & 8) {
+    for (int c = 0; c < 3; ++c) {
+      std::swap(best_q[0][c], best_q[1][c]);
+    }
+    for (int i = 0; i < 16; ++i) {
+      best_indices[i] = 15 - best_indices[i];
+    }
+  }
+
+  // Mode 11: a single region with 10-bit endpoints, not delta-encoded.
+  BlockBitWriter writer(dest);
+  writer.write(0x03, 5);
+  for (int e = 0; e < 2; ++e) {
+    for (int c = 0; c < 3; ++c) {
+      writer.write(best_q[e][c], 10);
+    }
+  }
+  writer.write(best_indices[0], 3);
+  for (int i = 1; i < 16; ++i) {
+    writer.write(best_indices[i], 4);
+  }
+}
+
+/**
+ * Decodes a block of the indicated format into 16 RGBA pixels.  Channels that
+ * are not stored in the format are set to 0, or 255 for alpha.  Use
+ * decompress_block_bc6h() for BC6H.
+ *
+ * Returns false if the block uses a BC7 mode that cannot be decoded.
+ */
+bool BlockCompressor::
+decompress_block(BlockFormat format, const unsigned char *src,
+                 unsigned char *rgba) {
+  switch (format) {
+  case BF_bc1:
+    decompress_bc1(src, rgba, true);
+    return true;
+
+  case BF_bc2:
+    decompress_bc1(src + 8, rgba, false);
+    for (int i = 0; i < 16; ++i) {
+      rgba[i * 4 + 3] = (unsigned char)(((src[i >> 1] >> ((i & 1) * 4)) & 0xf) * 17);
+    }
+    return true;
+
+  case BF_bc3:
+    decompress_bc1(src + 8, rgba, false);
+    decompress_bc4(src, rgba + 3, 4);
+    return true;
+
+  case BF_bc4:
+    for (int i = 0; i < 16; ++i) {
+      rgba[i * 4 + 1] = 0;
+      rgba[i * 4 + 2] = 0;
+      rgba[i * 4 + 3] = 255;
+    }
+    decompress_bc4(src, rgba, 4);
+    return true;
+
+  case BF_bc5:
+    for (int i = 0; i < 16; ++i) {
+      rgba[i * 4 + 2] = 0;
+      rgba[i * 4 + 3] = 255;
+    }
+    decompress_bc4(src, rgba, 4);
+    decompress_bc4(src + 8, rgba + 1, 4);
+    return true;
+
+  case BF_bc6h:
+    nassert_raise("use decompress_block_bc6h() for BC6H");
+    return false;
+
+  case BF_bc7:
+    return decompress_bc7(src, rgba);
+  }
+
+  return false;
+}
+
+/**
+ * Decodes a BC6H block into 16 RGB pixels, given as half-floats.  If is_signed
+ * is true, the block is decoded as the signed variant of the format.
+ *
+ * Returns false if the block uses one of the reserved modes, in which case
+ * the pixels are set to 0.
+ */
+bool BlockCompressor::
+decompress_block_bc6h(const unsigned char *src, uint16_t *rgb, bool is_signed) {
+  BlockBitReader reader(src);
+  unsigned int mode_bits = reader.read(2);
+  if (mode_bits >= 2) {
+    mode_bits |= reader.read(3) << 2;
+  }
+
+  const BC6HMode *mode = nullptr;
+  for (const BC6HMode &candidate : bc6h_modes) {
+    if (candidate._mode == mode_bits) {
+      mode = &candidate;
+      break;
+    }
+  }
+  if (mode == nullptr) {
+    memset(rgb, 0, 48 * sizeof(uint16_t));
+    return false;
+  }
+
+  int comps[12] = {};
+  for (const BC6HField *field = mode->_fields; field->_num_bits != 0; ++field) {
+    comps[field->_component] |= (int)reader.read(field->_num_bits) << field->_shift;
+  }
+  int num_subsets = mode->_partitioned ? 2 : 1;
+  int partition = mode->_partitioned ? (int)reader.read(5) : 0;
+
+  // Undo the delta encoding, and bring the endpoints onto the scale on which
+  // they are interpolated.
+  int endpoint_bits = mode->_endpoint_bits;
+  int ends[4][3];
+  for (int c = 0; c < 3; ++c) {
+    int base = comps[c];
+    if (is_signed) {
+      base = block_sign_extend(base, endpoint_bits);
+    }
+    ends[0][c] = block_bc6h_unquantize(base, endpoint_bits, is_signed);
+
+    for (int e = 1; e < num_subsets * 2; ++e) {
+      int value = comps[e * 3 + c];
+      if (is_signed || mode->_transformed) {
+        value = block_sign_extend(value, mode->_delta_bits[c]);
+      }
+      if (mode->_transformed) {
+        value = (base + value) & ((1 << endpoint_bits) - 1);
+        if (is_signed) {
+          value = block_sign_extend(value, endpoint_bits);
+        }
+      }
+      ends[e][c] = block_bc6h_unquantize(value, endpoint_bits, is_signed);
+    }
+  }
+
+  int index_bits = mode->_partitioned ? 3 : 4;
+  const int *weights = bptc_weights[index_bits];
+  for (int i = 0; i < 16; ++i) {
+    bool anchor = bptc_is_anchor(num_subsets, partition, i);
+    int w = weights[reader.read(anchor ? index_bits - 1 : index_bits)];
+    int subset = bptc_subset(num_subsets, partition, i);
+    const int *e0 = ends[subset * 2];
+    const int *e1 = ends[subset * 2 + 1];
+    for (int c = 0; c < 3; ++c) {
+      int value = (e0[c] * (64 - w) + e1[c] * w + 32) >> 6;
+      rgb[i * 3 + c] = block_bc6h_finish(value, is_signed);
+    }
+  }
+  return true;
+}
+
+/**
+ * Converts a 32-bit float to the nearest half-float.
+ */
+uint16_t BlockCompressor::
+float_to_half(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+
+  uint32_t sign = (bits >> 16) & 0x8000;
+  uint32_t abs_bits = bits & 0x7fffffff;
+
+  if (abs_bits >= 0x7f800000) {
+    // Infinity or NaN.
+    return (uint16_t)(sign | 0x7c00 | ((abs_bits > 0x7f800000) ? 0x200 : 0));
+  }
+  if (abs_bits >= 0x477ff000) {
+    // Too large; rounds to infinity.
+    return (uint16_t)(sign | 0x7c00);
+  }
+  if (abs_bits < 0x38800000) {
+    // Becomes a denormal, or zero.
+    if (abs_bits < 0x33000000) {
+      return (uint16_t)sign;
+    }
+    uint32_t mantissa = (abs_bits & 0x7fffff) | 0x800000;
+    int shift = 126 - (int)(abs_bits >> 23);
+    uint32_t half = mantissa >> shift;
+    uint32_t rest = mantissa & ((1u << shift) - 1);
+    uint32_t halfway = 1u << (shift - 1);
+    if (rest > halfway || (rest == halfway && (half & 1))) {
+      ++half;
+    }
+    return (uint16_t)(sign | half);
+  }
+
+  uint32_t half = (abs_bits - 0x38000000) >> 13;
+  uint32_t rest = abs_bits & 0x1fff;
+  if (rest > 0x1000 || (rest == 0x1000 && (half & 1))) {
+    ++half;
+  }
+  return (uint16_t)(sign | half);
+}
+
+/**
+ * Converts a half-float to a 32-bit float.
+ */
+float BlockCompressor::
+half_to_float(uint16_t value) {
+  uint32_t sign = (uint32_t)(value & 0x8000) << 16;
+  uint32_t exponent = (value >> 10) & 0x1f;
+  uint32_t mantissa = value & 0x3ff;
+
+  uint32_t bits;
+  if (exponent == 0) {
+    float result = ldexpf((float)mantissa, -24);
+    return sign ? -result : result;
+  } else if (exponent == 31) {
+    bits = sign | 0x7f800000 | (mantissa << 13);
+  } else {
+    bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+  }
+
+  float result;
+  memcpy(&result, &bits, sizeof(result));
+  return result;
+}
+
+/**
+ * Encodes the color of the indicated RGBA block as a BC1 block of 8 bytes.
+ * If allow_alpha is true, pixels with an alpha value below 128 are made
+ * transparent; otherwise, the alpha channel is ignored, and the block is
+ * always encoded in four-color mode, as required for BC2 and BC3.
+ */
+void BlockCompressor::
+compress_bc1(const unsigned char *rgba, unsigned char *dest, bool allow_alpha,
+             Texture::QualityLevel quality) {
+  static const float factors4[4] = {0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f};
+  static const float factors3[4] = {0.0f, 1.0f, 0.5f, 0.0f};
+
+  BlockPixels pixels;
+  pixels._num_channels = 3;
+  bool four_color = true;
+  bool any_opaque = false;
+  for (int i = 0; i < 16; ++i) {
+    for (int c = 0; c < 4; ++c) {
+      pixels._c[c][i] = rgba[i * 4 + c];
+    }
+    if (allow_alpha && rgba[i * 4 + 3] < 128) {
+      pixels._weight[i] = 0.0f;
+      four_color = false;
+    } else {
+      pixels._weight[i] = 1.0f;
+      any_opaque = true;
+    }
+  }
+
+  if (!any_opaque) {
+    // The whole block is transparent.
+    memset(dest, 0, 4);
+    memset(dest + 4, 0xff, 4);
+    return;
+  }
+
+  float lo[4], hi[4];
+  block_fit_line(pixels, lo, hi);
+
+  int num_refits = block_num_refits(quality);
+  float best_err = FLT_MAX;
+  unsigned int best_c0 = 0, best_c1 = 0;
+  int best_indices[16];
+  for (int it = 0; it <= num_refits; ++it) {
+    unsigned int c0 = block_pack_565(lo);
+    unsigned int c1 = block_pack_565(hi);
+
+    int ipalette[4][4];
+    block_bc1_palette(c0, c1, four_color, ipalette);
+    float palette[4][4];
+    for (int e = 0; e < 4; ++e) {
+      for (int c = 0; c < 4; ++c) {
+        palette[e][c] = (float)ipalette[e][c];
+      }
+    }
+
+    // Transparent pixels don't count towards the error, and get index 3
+    // below, so the transparent entry of the palette is not searched.
+    int indices[16];
+    float err = block_find_indices(pixels, palette, four_color ? 4 : 3, indices);
+    if (err < best_err) {
+      best_err = err;
+      best_c0 = c0;
+      best_c1 = c1;
+      memcpy(best_indices, indices, sizeof(indices));
+    }
+    if (it == num_refits || err == 0.0f ||
+        !block_refit_line(pixels, indices, four_color ? factors4 : factors3, lo, hi)) {
+      break;
+    }
+  }
+
+  // The order of the endpoints selects the mode.  Swapping them reverses the
+  // order of the palette entries between them.
+  if (four_color) {
+    if (best_c0 < best_c1) {
+      std::swap(best_c0, best_c1);
+      for (int i = 0; i < 16; ++i) {
+        best_indices[i] ^= 1;
+      }
+    } else if (best_c0 == best_c1) {
+      for (int i = 0; i < 16; ++i) {
+        best_indices[i] = 0;
+      }
+    }
+  } else {
+    if (best_c0 > best_c1) {
+      std::swap(best_c0, best_c1);
+      for (int i = 0; i < 16; ++i) {
+        if (best_indices[i] < 2) {
+          best_indices[i] ^= 1;
+        }
+      }
+    }
+    for (int i = 0; i < 16; ++i) {
+      if (pixels._weight[i] == 0.0f) {
+        best_indices[i] = 3;
+      }
+    }
+  }
+
+  uint32_t bits = 0;
+  for (int i = 0; i < 16; ++i) {
+    bits |= (uint32_t)best_indices[i] << (i * 2);
+  }
+  dest[0] = (unsigned char)(best_c0 & 0xff);
+  dest[1] = (unsigned char)(best_c0 >> 8);
+  dest[2] = (unsigned char)(best_c1 & 0xff);
+  dest[3] = (unsigned char)(best_c1 >> 8);
+  dest[4] = (unsigned char)(bits & 0xff);
+  dest[5] = (unsigned char)((bits >> 8) & 0xff);
+  dest[6] = (unsigned char)((bits >> 16) & 0xff);
+  dest[7] = (unsigned char)(bits >> 24);
+}
+
+/**
+ * Encodes the 16 values found at the given stride as a BC4 block of 8 bytes.
+ */
+void BlockCompressor::
+compress_bc4(const unsigned char *values, int stride, unsigned char *dest,
+             Texture::QualityLevel quality) {
+  BlockPixels pixels;
+  pixels._num_channels = 1;
+  int minv = 255, maxv = 0;
+  int min6 = 255, max6 = 0;
+  for (int i = 0; i < 16; ++i) {
+    int v = values[i * stride];
+    pixels._c[0][i] = (float)v;
+    pixels._weight[i] = 1.0f;
+    minv = min(minv, v);
+    maxv = max(maxv, v);
+    if (v != 0 && v != 255) {
+      min6 = min(min6, v);
+      max6 = max(max6, v);
+    }
+  }
+
+  if (minv == maxv) {
+    dest[0] = (unsigned char)minv;
+    dest[1] = (unsigned char)minv;
+    memset(dest + 2, 0, 6);
+    return;
+  }
+
+  // In the eight-value mode, the first endpoint must be the larger one.
+  int best_a0 = maxv, best_a1 = minv;
+  int best_indices[16];
+  float best_err = FLT_MAX;
+
+  auto try_endpoints = [&] (int a0, int a1) {
+    int ipalette[8];
+    block_bc4_palette(a0, a1, ipalette);
+    float palette[8][4] = {};
+    for (int e = 0; e < 8; ++e) {
+      palette[e][0] = (float)ipalette[e];
+    }
+    int indices[16];
+    float err = block_find_indices(pixels, palette, 8, indices);
+    if (err < best_err) {
+      best_err = err;
+      best_a0 = a0;
+      best_a1 = a1;
+      memcpy(best_indices, indices, sizeof(indices));
+    }
+  };
+
+  try_endpoints(maxv, minv);
+
+  if (quality != Texture::QL_fastest) {
+    // The six-value mode has exact 0 and 255 entries, which helps when the
+    // other values are close together.
+    if (min6 > max6) {
+      min6 = max6 = 0;
+    }
+    try_endpoints(min6, max6);
+  }
+
+  if (quality == Texture::QL_best) {
+    // Try to shrink the range a little, so that the interpolated values
+    // line up better with the pixels.
+    for (int d0 = -2; d0 <= 0; ++d0) {
+      for (int d1 = 0; d1 <= 2; ++d1) {
+        int a0 = maxv + d0;
+        int a1 = minv + d1;
+        if ((d0 != 0 || d1 != 0) && a0 > a1) {
+          try_endpoints(a0, a1);
+        }
+      }
+    }
+  }
+
+  uint64_t bits = 0;
+  for (int i = 0; i < 16; ++i) {
+    bits |= (uint64_t)best_indices[i] << (i * 3);
+  }
+  dest[0] = (unsigned char)best_a0;
+  dest[1] = (unsigned char)best_a1;
+  for (int b = 0; b < 6; ++b) {
+    dest[b + 2] = (unsigned char)((bits >> (b * 8)) & 0xff);
+  }
+}
+
+/**
+ * Encodes the indicated RGBA block as a BC7 block of 16 bytes.  Each block is
+ * encoded in mode 6, and also in mode 5 if the alpha channel varies, or for
+ * the best quality level; whichever has the smaller error is kept.
+ */
+void BlockCompressor::
+compress_bc7(const unsigned char *rgba, unsigned char *dest,
+             Texture::QualityLevel quality) {
+  float best_err = compress_bc7_mode6(rgba, dest, quality);
+  if (best_err == 0.0f) {
+    return;
+  }
+
+  bool opaque = true;
+  for (int i = 0; i < 16; ++i) {
+    opaque = opaque && (rgba[i * 4 + 3] == 255);
+  }
+  if (opaque && quality != Texture::QL_best) {
+    return;
+  }
+
+  // For the best quality level, also try giving each of the color channels
+  // its own indices instead of the alpha channel.
+  int num_rotations = (quality == Texture::QL_best) ? 4 : 1;
+  for (int rotation = 0; rotation < num_rotations; ++rotation) {
+    unsigned char block[16];
+    float err = compress_bc7_mode5(rgba, block, rotation, quality);
+    if (err < best_err) {
+      best_err = err;
+      memcpy(dest, block, 16);
+    }
+  }
+}
+
+/**
+ * Encodes the indicated RGBA block as a BC7 block of 16 bytes, using mode 6,
+ * which has a single subset with 7-bit endpoints, each with its own extra
+ * low bit shared by all channels, and 4-bit indices.  Returns the squared
+ * error of the encoded block.
+ */
+float BlockCompressor::
+compress_bc7_mode6(const unsigned char *rgba, unsigned char *dest,
+                   Texture::QualityLevel quality) {
+  BlockPixels pixels;
+  pixels._num_channels = 4;
+  bool opaque = true;
+  for (int i = 0; i < 16; ++i) {
+    for (int c = 0; c < 4; ++c) {
+      pixels._c[c][i] = rgba[i * 4 + c];
+    }
+    pixels._weight[i] = 1.0f;
+    opaque = opaque && (rgba[i * 4 + 3] == 255);
+  }
+
+  float factors[16];
+  for (int k = 0; k < 16; ++k) {
+    factors[k] = bptc_weights4[k] * (1.0f / 64.0f);
+  }
+
+  float lo[4], hi[4];
+  block_fit_line(pixels, lo, hi);
+
+  int num_refits = block_num_refits(quality);
+  float best_err = FLT_MAX;
+  int best_v[2][4];
+  int best_p[2] = {1, 1};
+  int best_indices[16];
+  for (int it = 0; it <= num_refits; ++it) {
+    const float *ends[2] = {lo, hi};
+
+    // Decide which low bits to try for the two endpoints.  An opaque block
+    // needs them set to represent an alpha of 255 exactly.
+    int pbit_choices[4][2];
+    int num_choices = 0;
+    if (opaque) {
+      pbit_choices[num_choices][0] = 1;
+      pbit_choices[num_choices][1] = 1;
+      ++num_choices;
+
+    } else if (quality == Texture::QL_fastest) {
+      // Pick the bit that best fits each endpoint by itself.
+      for (int e = 0; e < 2; ++e) {
+        float err[2] = {0.0f, 0.0f};
+        for (int p = 0; p < 2; ++p) {
+          for (int c = 0; c < 4; ++c) {
+            int v = min(max((int)floorf((ends[e][c] - p) * 0.5f + 0.5f), 0), 127);
+            float d = (float)(v * 2 + p) - ends[e][c];
+            err[p] += d * d;
+          }
+        }
+        pbit_choices[0][e] = (err[1] < err[0]) ? 1 : 0;
+      }
+      num_choices = 1;
+
+    } else {
+      for (int p = 0; p < 4; ++p) {
+        pbit_choices[p][0] = p & 1;
+        pbit_choices[p][1] = p >> 1;
+      }
+      num_choices = 4;
+    }
+
+    float iter_err = FLT_MAX;
+    int iter_indices[16];
+    for (int choice = 0; choice < num_choices; ++choice) {
+      int v[2][4];
+      int values[2][4];
+      for (int e = 0; e < 2; ++e) {
+        int p = pbit_choices[choice][e];
+        for (int c = 0; c < 4; ++c) {
+          v[e][c] = min(max((int)floorf((ends[e][c] - p) * 0.5f + 0.5f), 0), 127);
+          values[e][c] = v[e][c] * 2 + p;
+        }
+      }
+
+      float palette[16][4];
+      for (int k = 0; k < 16; ++k) {
+        int w = bptc_weights4[k];
+        for (int c = 0; c < 4; ++c) {
+          palette[k][c] = (float)((values[0][c] * (64 - w) + values[1][c] * w + 32) >> 6);
+        }
+      }
+
+      int indices[16];
+      float err = block_find_indices(pixels, palette, 16, indices);
+      if (err < iter_err) {
+        iter_err = err;
+        memcpy(iter_indices, indices, sizeof(indices));
+      }
+      if (err < best_err) {
+        best_err = err;
+        memcpy(best_v, v, sizeof(v));
+        best_p[0] = pbit_choices[choice][0];
+        best_p[1] = pbit_choices[choice][1];
+        memcpy(best_indices, indices, sizeof(indices));
+      }
+    }
+
+    if (it == num_refits || iter_err == 0.0f ||
+        !block_refit_line(pixels, iter_indices, factors, lo, hi)) {
+      break;
+    }
+  }
+
+  // The most significant bit of the first index is implied to be 0.
+  if (best_indices[0] & 8) {
+    for (int c = 0; c < 4; ++c) {
+      std::swap(best_v[0][c], best_v[1][c]);
+    }
+    std::swap(best_p[0], best_p[1]);
+    for (int i = 0; i < 16; ++i) {
+      best_indices[i] = 15 - best_indices[i];
+    }
+  }
+
+  BlockBitWriter writer(dest);
+  writer.write(1 << 6, 7);
+  for (int c = 0; c < 4; ++c) {
+    writer.write(best_v[0][c], 7);
+    writer.write(best_v[1][c], 7);
+  }
+  writer.write(best_p[0], 1);
+  writer.write(best_p[1], 1);
+  writer.write(best_indices[0], 3);
+  for (int i = 1; i < 16; ++i) {
+    writer.write(best_indices[i], 4);
+  }
+  return best_err;
+}
+
+/**
+ * Encodes the indicated RGBA block as a BC7 block of 16 bytes, using mode 5,
+ * which has 7-bit color endpoints and 8-bit alpha endpoints, with separate
+ * 2-bit indices for the color and for the alpha channel.  This works well for
+ * blocks in which the alpha channel does not vary along with the color.  If
+ * rotation is not 0, the indicated color channel is swapped with the alpha
+ * channel instead.  Returns the squared error of the encoded block.
+ */
+float BlockCompressor::
+compress_bc7_mode5(const unsigned char *rgba, unsigned char *dest,
+                   int rotation, Texture::QualityLevel quality) {
+  BlockPixels color;
+  BlockPixels alpha;
+  color._num_channels = 3;
+  alpha._num_channels = 1;
+  for (int i = 0; i < 16; ++i) {
+    unsigned char pixel[4] = {rgba[i * 4], rgba[i * 4 + 1], rgba[i * 4 + 2], rgba[i * 4 + 3]};
+    if (rotation != 0) {
+      std::swap(pixel[rotation - 1], pixel[3]);
+    }
+    for (int c = 0; c < 3; ++c) {
+      color._c[c][i] = pixel[c];
+    }
+    color._c[3][i] = 0.0f;
+    color._weight[i] = 1.0f;
+    alpha._c[0][i] = pixel[3];
+    alpha._weight[i] = 1.0f;
+  }
+
+  int color_v[2][4];
+  int color_indices[16];
+  float err = block_fit_bptc_endpoints(color, 7, quality, color_v, color_indices);
+
+  int alpha_v[2][4];
+  int alpha_indices[16];
+  err += block_fit_bptc_endpoints(alpha, 8, quality, alpha_v, alpha_indices);
+
+  BlockBitWriter writer(dest);
+  writer.write(1 << 5, 6);
+  writer.write(rotation, 2);
+  for (int c = 0; c < 3; ++c) {
+    writer.write(color_v[0][c], 7);
+    writer.write(color_v[1][c], 7);
+  }
+  writer.write(alpha_v[0][0], 8);
+  writer.write(alpha_v[1][0], 8);
+  writer.write(color_indices[0], 1);
+  for (int i = 1; i < 16; ++i) {
+    writer.write(color_indices[i], 2);
+  }
+  writer.write(alpha_indices[0], 1);
+  for (int i = 1; i < 16; ++i) {
+    writer.write(alpha_indices[i], 2);
+  }
+  return err;
+}
+
+/**
+ * Decodes the color part of a BC1, BC2 or BC3 block.  If allow_alpha is
+ * false, the block is always decoded in four-color mode.
+ */
+void BlockCompressor::
+decompress_bc1(const unsigned char *src, unsigned char *rgba,
+               bool allow_alpha) {
+  unsigned int c0 = src[0] | (src[1] << 8);
+  unsigned int c1 = src[2] | (src[3] << 8);
+  uint32_t bits = src[4] | (src[5] << 8) | (src[6] << 16) | ((uint32_t)src[7] << 24);
+
+  int palette[4][4];
+  block_bc1_palette(c0, c1, !allow_alpha || c0 > c1, palette);
+  for (int i = 0; i < 16; ++i) {
+    const int *color = palette[(bits >> (i * 2)) & 3];
+    for (int c = 0; c < 4; ++c) {
+      rgba[i * 4 + c] = (unsigned char)color[c];
+    }
+  }
+}
+
+/**
+ * Decodes a BC4 block, writing the 16 values at the given stride.
+ */
+void BlockCompressor::
+decompress_bc4(const unsigned char *src, unsigned char *values, int stride) {
+  int palette[8];
+  block_bc4_palette(src[0], src[1], palette);
+
+  uint64_t bits = 0;
+  for (int b = 0; b < 6; ++b) {
+    bits |= (uint64_t)src[b + 2] << (b * 8);
+  }
+  for (int i = 0; i < 16; ++i) {
+    values[i * stride] = (unsigned char)palette[(bits >> (i * 3)) & 7];
+  }
+}
+
+/**
+ * Decodes a BC7 block.  Returns false if the block uses the reserved mode, in
+ * which case the pixels are set to 0.
+ */
+bool BlockCompressor::
+decompress_bc7(const unsigned char *src, unsigned char *rgba) {
+  BlockBitReader reader(src);
+  int mode_index = 0;
+  while (mode_index < 8 && reader.read(1) == 0) {
+    ++mode_index;
+  }
+  if (mode_index == 8) {
+    memset(rgba, 0, 64);
+    return false;
+  }
+
+  const BC7Mode &mode = bc7_modes[mode_index];
+  int num_subsets = mode._num_subsets;
+  int partition = (int)reader.read(mode._partition_bits);
+  int rotation = (int)reader.read(mode._rotation_bits);
+  int index_selection = (int)reader.read(mode._index_selection_bits);
+
+  // The endpoints are stored one channel at a time.
+  int num_endpoints = num_subsets * 2;
+  int num_channels = (mode._alpha_bits != 0) ? 4 : 3;
+  int ends[6][4];
+  for (int c = 0; c < num_channels; ++c) {
+    int num_bits = (c < 3) ? mode._color_bits : mode._alpha_bits;
+    for (int e = 0; e < num_endpoints; ++e) {
+      ends[e][c] = (int)reader.read(num_bits);
+    }
+  }
+
+  // Then the low bits that are shared by all channels of an endpoint, or of
+  // both endpoints of a subset.
+  int color_bits = mode._color_bits;
+  int alpha_bits = mode._alpha_bits;
+  if (mode._endpoint_pbits || mode._shared_pbits) {
+    int pbits[6];
+    if (mode._endpoint_pbits) {
+      for (int e = 0; e < num_endpoints; ++e) {
+        pbits[e] = (int)reader.read(1);
+      }
+    } else {
+      for (int s = 0; s < num_subsets; ++s) {
+        pbits[s * 2] = pbits[s * 2 + 1] = (int)reader.read(1);
+      }
+    }
+    for (int e = 0; e < num_endpoints; ++e) {
+      for (int c = 0; c < num_channels; ++c) {
+        ends[e][c] = (ends[e][c] << 1) | pbits[e];
+      }
+    }
+    ++color_bits;
+    if (alpha_bits != 0) {
+      ++alpha_bits;
+    }
+  }
+
+  // Expand the endpoints to 8 bits by repeating the high bits.
+  for (int e = 0; e < num_endpoints; ++e) {
+    for (int c = 0; c < 4; ++c) {
+      int num_bits = (c < 3) ? color_bits : alpha_bits;
+      if (num_bits == 0) {
+        ends[e][c] = 255;
+      } else {
+        int value = ends[e][c] << (8 - num_bits);
+        ends[e][c] = value | (value >> num_bits);
+      }
+    }
+  }
+
+  int indices[16];
+  for (int i = 0; i < 16; ++i) {
+    bool anchor = bptc_is_anchor(num_subsets, partition, i);
+    indices[i] = (int)reader.read(anchor ? mode._index_bits - 1 : mode._index_bits);
+  }
+
+  // Modes 4 and 5 have a second set of indices, for the alpha channel, unless
+  // the index selection bit swaps them around.
+  int indices2[16];
+  int color_index_bits = mode._index_bits;
+  int alpha_index_bits = mode._index_bits;
+  const int *color_indices = indices;
+  const int *alpha_indices = indices;
+  if (mode._index_bits2 != 0) {
+    for (int i = 0; i < 16; ++i) {
+      indices2[i] = (int)reader.read((i == 0) ? mode._index_bits2 - 1 : mode._index_bits2);
+    }
+    alpha_index_bits = mode._index_bits2;
+    alpha_indices = indices2;
+    if (index_selection) {
+      std::swap(color_index_bits, alpha_index_bits);
+      std::swap(color_indices, alpha_indices);
+    }
+  }
+
+  for (int i = 0; i < 16; ++i) {
+    int subset = bptc_subset(num_subsets, partition, i);
+    const int *e0 = ends[subset * 2];
+    const int *e1 = ends[subset * 2 + 1];
+    int wc = bptc_weights[color_index_bits][color_indices[i]];
+    int wa = bptc_weights[alpha_index_bits][alpha_indices[i]];
+    unsigned char *pixel = rgba + i * 4;
+    for (int c = 0; c < 4; ++c) {
+      int w = (c < 3) ? wc : wa;
+      pixel[c] = (unsigned char)((e0[c] * (64 - w) + e1[c] * w + 32) >> 6);
+    }
+
+    // The rotation swaps alpha with one of the color channels.
+    if (rotation != 0) {
+      std::swap(pixel[rotation - 1], pixel[3]);
+    }
+  }
+  return true;
+}
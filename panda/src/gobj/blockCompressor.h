@@ -0,0 +1,87 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file blockCompressor.h
+ * @author rdb
+ * @date 2026-10-17
+ */
+
+#ifndef BLOCKCOMPRESSOR_H
+#define BLOCKCOMPRESSOR_H
+
+#include "pandabase.h"
+#include "texture.h"
+
+/**
+ * Encodes and decodes individual 4x4 blocks of the BC1 through BC7 texture
+ * compression formats (also known as DXT1/3/5, RGTC and BPTC), so that
+ * textures can be compressed without the help of the graphics driver or of
+ * an external library.  See Texture::compress_ram_image() for the high-level
+ * interface.
+ *
+ * Each block is given as 16 pixels in row-major order.  All formats except
+ * BC6H take four 8-bit channels per pixel, in RGBA order; BC4 only uses the
+ * red channel and BC5 only the red and green channels.  BC6H takes three
+ * half-float channels per pixel, in RGB order.
+ *
+ * The encoders fit a line through the colors of each block, and then
+ * repeatedly refit the endpoints to the chosen indices for the higher quality
+ * levels.  BC6H blocks are encoded using mode 11, and BC7 blocks using mode 6
+ * or, if that fits the block better, mode 5.  The decoders accept all modes of
+ * both formats, including the partitioned ones and signed BC6H.
+ */
+class EXPCL_PANDA_GOBJ BlockCompressor {
+public:
+  enum BlockFormat {
+    BF_bc1,   // DXT1: RGB with optional binary alpha
+    BF_bc2,   // DXT3: RGB with explicit 4-bit alpha
+    BF_bc3,   // DXT5: RGB with interpolated alpha
+    BF_bc4,   // RGTC1: one channel
+    BF_bc5,   // RGTC2: two channels
+    BF_bc6h,  // BPTC float: unsigned HDR RGB
+    BF_bc7,   // BPTC: RGBA
+  };
+
+  INLINE static size_t get_block_size(BlockFormat format);
+
+  static void compress_block(BlockFormat format, const unsigned char *rgba,
+                             unsigned char *dest,
+                             Texture::QualityLevel quality);
+  static void compress_block_bc6h(const uint16_t *rgb, unsigned char *dest,
+                                  Texture::QualityLevel quality);
+
+  static bool decompress_block(BlockFormat format, const unsigned char *src,
+                               unsigned char *rgba);
+  static bool decompress_block_bc6h(const unsigned char *src, uint16_t *rgb,
+                                    bool is_signed = false);
+
+  static uint16_t float_to_half(float value);
+  static float half_to_float(uint16_t value);
+
+private:
+  static void compress_bc1(const unsigned char *rgba, unsigned char *dest,
+                           bool allow_alpha, Texture::QualityLevel quality);
+  static void compress_bc4(const unsigned char *values, int stride,
+                           unsigned char *dest, Texture::QualityLevel quality);
+  static void compress_bc7(const unsigned char *rgba, unsigned char *dest,
+                           Texture::QualityLevel quality);
+  static float compress_bc7_mode5(const unsigned char *rgba, unsigned char *dest,
+                                  int rotation, Texture::QualityLevel quality);
+  static float compress_bc7_mode6(const unsigned char *rgba, unsigned char *dest,
+                                  Texture::QualityLevel quality);
+
+  static void decompress_bc1(const unsigned char *src, unsigned char *rgba,
+                             bool allow_alpha);
+  static void decompress_bc4(const unsigned char *src, unsigned char *values,
+                             int stride);
+  static bool decompress_bc7(const unsigned char *src, unsigned char *rgba);
+};
+
+#include "blockCompressor.I"
+
+#endif
@@ -17,6 +17,7 @@
 #include "config_gobj.h"
 #include "geom.h"
 #include "geomCacheEntry.h"
+#include "geomClusters.h"
 #include "geomMunger.h"
 #include "geomPrimitive.h"
 #include "geomTriangles.h"
@@ -67,6 +68,7 @@
 #include "internalName.h"
 
 #include "dconfig.h"
+#include "pandaSystem.h"
 #include "string_utils.h"
 
 #if !defined(CPPPARSER) && !defined(LINK_ALL_STATIC) && !defined(BUILDING_PANDA_GOBJ)
@@ -127,10 +129,7 @@ ConfigVariableBool driver_compress_textures
           "or results by setting this true.  Setting it true may also "
           "allow you to take advantage of some exotic compression algorithm "
           "other than DXT1/3/5 that your graphics driver supports, but "
-          "which is unknown to Panda.  If the libsquish library is not "
-          "compiled into Panda, textures cannot be compressed in-memory, "
-          "and will always be handed to the graphics driver, regardless "
-          "of this setting."));
+          "which is unknown to Panda."));
 
 ConfigVariableBool driver_generate_mipmaps
 ("driver-generate-mipmaps", true,
@@ -300,6 +299,114 @@ ConfigVariableBool vertex_animation_align_16
           "impacts only vertex formats created within Panda subsystems; custom "
           "vertex formats are not affected."));
 
+ConfigVariableBool cpu_skinning_fast_path
+("cpu-skinning-fast-path", true,
+ PRC_DESC("When this is true, vertex animation on the CPU uses an optimized "
+          "path for the common case of vertex data without morphs, whose "
+          "vertices, normals and tangents are stored as 32-bit floats.  "
+          "This path applies all the blend matrices using SIMD instructions "
+          "where available, and only rewrites the animated columns each "
+          "frame, rather than copying the entire vertex data.  Set this "
+          "false to always use the general path."));
+
+ConfigVariableInt cpu_skinning_num_threads
+("cpu-skinning-num-threads", 0,
+ PRC_DESC("The number of threads to use for animating the vertices of a "
+          "single GeomVertexData on the CPU.  This only applies to the "
+          "path enabled by cpu-skinning-fast-path, and only to vertex "
+          "data with enough animated vertices to make it worthwhile.  Set "
+          "this to 0 to do all the work in the thread that renders the "
+          "model."));
+
+ConfigVariableInt geom_bounds_num_threads
+("geom-bounds-num-threads", 0,
+ PRC_DESC("The number of threads to use for computing the bounding volume of "
+          "a Geom with a very large number of vertices, such as a terrain "
+          "chunk.  The vertices are split into batches that are processed "
+          "in parallel.  Set this to 0 to compute the bounds entirely in "
+          "the thread that requests them."));
+
+ConfigVariableInt texture_compress_num_threads
+("texture-compress-num-threads", 0,
+ PRC_DESC("The number of threads to use for compressing a texture image in "
+          "RAM, as done by Texture::compress_ram_image().  The rows of 4x4 "
+          "blocks of all pages and mipmap levels are divided among these "
+          "threads.  Set this to 0 to compress the texture entirely in the "
+          "thread that requests it."));
+
+ConfigVariableInt texture_mipmap_num_threads
+("texture-mipmap-num-threads", 0,
+ PRC_DESC("The number of threads to use for generating the mipmap levels of "
+          "a texture image in RAM.  The rows of each level, including those "
+          "of all the faces of a cube map, are divided among these threads.  "
+          "Set this to 0 to generate the mipmaps entirely in the thread "
+          "that requests them."));
+
+ConfigVariableBool texture_mipmap_alpha_weighted
+("texture-mipmap-alpha-weighted", false,
+ PRC_DESC("Set this true to weight the color of each pixel by its alpha "
+          "when generating the mipmap levels of a texture image in RAM, so "
+          "that the color of fully transparent pixels does not bleed into "
+          "the visible pixels next to them in the smaller levels."));
+
+ConfigVariableInt async_geom_bounds_num_threads
+("async-geom-bounds-num-threads", 1,
+ PRC_DESC("The number of threads that will be started to compute bounding "
+          "volumes in the background, when Geom::async_compute_bounds() is "
+          "used.  These threads will only be started if the asynchronous "
+          "interface is used, and if threading support is compiled into "
+          "Panda."));
+
+ConfigVariableInt vertex_cache_size
+("vertex-cache-size", 16,
+ PRC_DESC("The number of vertices that the post-transform vertex cache of "
+          "the GPU is assumed to hold, for the purpose of "
+          "Geom::optimize_vertex_cache() and "
+          "SceneGraphReducer::optimize_vertex_cache().  Most hardware "
+          "behaves well with a value of 16; larger values may give better "
+          "results on recent hardware."));
+
+ConfigVariableDouble vertex_cache_overdraw_threshold
+("vertex-cache-overdraw-threshold", 1.05,
+ PRC_DESC("The factor by which Geom::optimize_vertex_cache() may increase "
+          "the number of vertex cache misses in exchange for drawing the "
+          "triangles facing away from the center of the mesh first, which "
+          "reduces overdraw.  Set this to 0 to order the triangles purely "
+          "for the vertex cache."));
+
+ConfigVariableDouble simplify_normal_weight
+("simplify-normal-weight", 0.5,
+ PRC_DESC("How strongly Geom::simplify() avoids collapsing edges between "
+          "vertices with different normals.  Set this to 0 to ignore the "
+          "normals, except at creases, where the vertices are duplicated."));
+
+ConfigVariableDouble simplify_texcoord_weight
+("simplify-texcoord-weight", 1.0,
+ PRC_DESC("How strongly Geom::simplify() avoids collapsing edges between "
+          "vertices with different texture coordinates, relative to the "
+          "size of the mesh.  Set this to 0 to ignore the texture "
+          "coordinates, except at UV seams."));
+
+ConfigVariableDouble simplify_color_weight
+("simplify-color-weight", 1.0,
+ PRC_DESC("How strongly Geom::simplify() avoids collapsing edges between "
+          "vertices with different vertex colors.  Set this to 0 to ignore "
+          "the vertex colors."));
+
+ConfigVariableInt geom_cluster_size
+("geom-cluster-size", 96,
+ PRC_DESC("The maximum number of triangles in each of the clusters made by "
+          "Geom::make_clusters() and SceneGraphReducer::make_clusters().  "
+          "Smaller clusters can be culled more precisely, but cost more "
+          "time to cull."));
+
+ConfigVariableDouble cluster_cull_min_fraction
+("cluster-cull-min-fraction", 0.2,
+ PRC_DESC("The minimum fraction of the triangles of a clustered Geom that "
+          "must be culled before a reduced index buffer is made for the "
+          "visible clusters.  Below this, the whole Geom is drawn, which "
+          "avoids uploading new indices for only a small saving."));
+
 ConfigVariableBool vertex_colors_prefer_packed
 ("vertex-colors-prefer-packed",
 #ifdef _WIN32
@@ -382,6 +489,32 @@ ConfigVariableEnum<ThreadPriority> texture_reload_thread_priority
            "asynchronous texture loading.  The default is 'normal'; you may "
            "also specify 'low', 'high', or 'urgent'."));
 
+ConfigVariableInt64 texture_streaming_budget
+ ("texture-streaming-budget", -1,
+  PRC_DESC("The maximum number of bytes of RAM image data that all streaming "
+           "textures together may hold.  When a texture needs a more "
+           "detailed mipmap level than fits, the largest levels of the "
+           "textures that have not been rendered recently are dropped.  "
+           "Set this to -1 for no limit."));
+
+ConfigVariableInt texture_streaming_min_size
+ ("texture-streaming-min-size", 64,
+  PRC_DESC("The mipmap levels of a streaming texture that are no larger than "
+           "this many pixels across are always kept in RAM.  The larger "
+           "levels are only loaded when an object that covers enough of the "
+           "screen to need them is rendered."));
+
+ConfigVariableInt texture_streaming_num_threads
+ ("texture-streaming-num-threads", 1,
+  PRC_DESC("The number of threads that are used to load the mipmap levels of "
+           "streaming textures from disk."));
+
+ConfigVariableEnum<ThreadPriority> texture_streaming_thread_priority
+ ("texture-streaming-thread-priority", TP_low,
+  PRC_DESC("The thread priority to assign to the threads that load the "
+           "mipmap levels of streaming textures.  The default is 'low'; you "
+           "may also specify 'normal', 'high', or 'urgent'."));
+
 ConfigVariableInt geom_cache_size
 ("geom-cache-size", 5000,
  PRC_DESC("Specifies the maximum number of entries in the cache "
@@ -580,6 +713,7 @@ ConfigureFn(config_gobj) {
   BufferContext::init_type();
   Geom::init_type();
   GeomCacheEntry::init_type();
+  GeomClusters::init_type();
   GeomPipelineReader::init_type();
   GeomContext::init_type();
   GeomLines::init_type();
@@ -640,6 +774,7 @@ ConfigureFn(config_gobj) {
   // Registration of writeable object's creation functions with BamReader's
   // factory
   Geom::register_with_read_factory();
+  GeomClusters::register_with_read_factory();
   GeomLines::register_with_read_factory();
   GeomLinesAdjacency::register_with_read_factory();
   GeomLinestrips::register_with_read_factory();
@@ -670,4 +805,16 @@ ConfigureFn(config_gobj) {
   TransformTable::register_with_read_factory();
   UserVertexSlider::register_with_read_factory();
   UserVertexTransform::register_with_read_factory();
+
+#if defined(HAVE_ZSTD) || defined(HAVE_BASISU)
+  {
+    PandaSystem *ps = PandaSystem::get_global_ptr();
+#ifdef HAVE_ZSTD
+    ps->add_system("zstd");
+#endif
+#ifdef HAVE_BASISU
+    ps->add_system("basisu");
+#endif
+  }
+#endif
 }
@@ -18,6 +18,7 @@
 #include "notifyCategoryProxy.h"
 #include "configVariableBool.h"
 #include "configVariableInt.h"
+#include "configVariableInt64.h"
 #include "configVariableEnum.h"
 #include "configVariableDouble.h"
 #include "configVariableFilename.h"
@@ -55,6 +56,20 @@ extern EXPCL_PANDA_GOBJ ConfigVariableBool cache_generated_shaders;
 extern EXPCL_PANDA_GOBJ ConfigVariableBool vertices_float64;
 extern EXPCL_PANDA_GOBJ ConfigVariableInt vertex_column_alignment;
 extern EXPCL_PANDA_GOBJ ConfigVariableBool vertex_animation_align_16;
+extern EXPCL_PANDA_GOBJ ConfigVariableBool cpu_skinning_fast_path;
+extern EXPCL_PANDA_GOBJ ConfigVariableInt cpu_skinning_num_threads;
+extern EXPCL_PANDA_GOBJ ConfigVariableInt geom_bounds_num_threads;
+extern EXPCL_PANDA_GOBJ ConfigVariableInt texture_compress_num_threads;
+extern EXPCL_PANDA_GOBJ ConfigVariableInt texture_mipmap_num_threads;
+extern EXPCL_PANDA_GOBJ ConfigVariableBool texture_mipmap_alpha_weighted;
+extern EXPCL_PANDA_GOBJ ConfigVariableInt async_geom_bounds_num_threads;
+extern EXPCL_PANDA_GOBJ ConfigVariableInt vertex_cache_size;
+extern EXPCL_PANDA_GOBJ ConfigVariableDouble vertex_cache_overdraw_threshold;
+extern EXPCL_PANDA_GOBJ ConfigVariableDouble simplify_normal_weight;
+extern EXPCL_PANDA_GOBJ ConfigVariableDouble simplify_texcoord_weight;
+extern EXPCL_PANDA_GOBJ ConfigVariableDouble simplify_color_weight;
+extern EXPCL_PANDA_GOBJ ConfigVariableInt geom_cluster_size;
+extern EXPCL_PANDA_GOBJ ConfigVariableDouble cluster_cull_min_fraction;
 extern EXPCL_PANDA_GOBJ ConfigVariableBool vertex_colors_prefer_packed;
 
 extern EXPCL_PANDA_GOBJ ConfigVariableEnum<AutoTextureScale> textures_power_2;
@@ -65,6 +80,10 @@ extern EXPCL_PANDA_GOBJ ConfigVariableInt simple_image_size;
 extern EXPCL_PANDA_GOBJ ConfigVariableDouble simple_image_threshold;
 extern EXPCL_PANDA_GOBJ ConfigVariableInt texture_reload_num_threads;
 extern EXPCL_PANDA_GOBJ ConfigVariableEnum<ThreadPriority> texture_reload_thread_priority;
+extern EXPCL_PANDA_GOBJ ConfigVariableInt64 texture_streaming_budget;
+extern EXPCL_PANDA_GOBJ ConfigVariableInt texture_streaming_min_size;
+extern EXPCL_PANDA_GOBJ ConfigVariableInt texture_streaming_num_threads;
+extern EXPCL_PANDA_GOBJ ConfigVariableEnum<ThreadPriority> texture_streaming_thread_priority;
 
 extern EXPCL_PANDA_GOBJ ConfigVariableInt geom_cache_size;
 extern EXPCL_PANDA_GOBJ ConfigVariableInt geom_cache_min_frames;
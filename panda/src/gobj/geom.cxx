@@ -13,6 +13,7 @@
 
 #include "geom.h"
 #include "geomPoints.h"
+#include "geomTriangles.h"
 #include "geomVertexReader.h"
 #include "geomVertexRewriter.h"
 #include "graphicsStateGuardianBase.h"
@@ -23,7 +24,14 @@
 #include "boundingSphere.h"
 #include "boundingBox.h"
 #include "lightMutexHolder.h"
+#include "indent.h"
 #include "config_mathutil.h"
+#include "config_gobj.h"
+#include "asyncTaskManager.h"
+#include "vertexCacheOptimizer.h"
+#include "meshSimplifier.h"
+
+#include <algorithm>
 
 using std::max;
 using std::min;
@@ -137,6 +145,7 @@ modify_vertex_data() {
   CDWriter cdata(_cycler, true, current_thread);
   clear_cache_stage(current_thread);
   mark_internal_bounds_stale(cdata);
+  cdata->_clusters.clear();
   return cdata->_data.get_write_pointer();
 }
 
@@ -153,6 +162,7 @@ set_vertex_data(const GeomVertexData *data) {
   nassertv(check_will_be_valid(data));
   CDWriter cdata(_cycler, true, current_thread);
   cdata->_data = (GeomVertexData *)data;
+  cdata->_clusters.clear();
   clear_cache_stage(current_thread);
   mark_internal_bounds_stale(cdata);
   reset_geom_rendering(cdata);
@@ -920,6 +930,375 @@ make_adjacency_in_place() {
   nassertv(all_is_valid);
 }
 
+/**
+ * Reorders the triangles of each GeomTriangles within this Geom for better
+ * use of the post-transform vertex cache of the GPU, whose size is given by
+ * the vertex-cache-size config variable.  Unless
+ * vertex-cache-overdraw-threshold is 0, the triangles facing away from the
+ * center of the mesh are then moved to the front, where this doesn't cost
+ * too many additional cache misses, to reduce overdraw.  Other primitive
+ * types are left alone.
+ *
+ * If reorder_vertices is true, the rows of the vertex data are also
+ * rearranged in the order in which they are first used by the primitives,
+ * which improves the locality of the vertex fetches.  This replaces the
+ * vertex data with a new one; if the vertex data is shared with other Geoms,
+ * it is better to pass false and use
+ * SceneGraphReducer::optimize_vertex_cache() instead.
+ *
+ * Don't call this in a downstream thread unless you don't mind it blowing
+ * away other changes you might have recently made in an upstream thread.
+ */
+void Geom::
+optimize_vertex_cache_in_place(bool reorder_vertices) {
+  Thread *current_thread = Thread::get_current_thread();
+  int cache_size = vertex_cache_size;
+  PN_stdfloat threshold = (PN_stdfloat)vertex_cache_overdraw_threshold;
+
+  CDWriter cdata(_cycler, true, current_thread);
+  CPT(GeomVertexData) vdata = cdata->_data.get_read_pointer(current_thread);
+  int num_vertices = vdata->get_num_rows();
+
+  // The overdraw optimization needs to know the vertex positions.
+  GeomVertexReader position_reader(vdata, InternalName::get_vertex(), current_thread);
+  pvector<LVecBase3> position_buffer;
+  const LVecBase3 *positions = nullptr;
+  if (threshold >= 1 && position_reader.has_column() && num_vertices > 0) {
+    positions = position_reader.get_data3_range(num_vertices, position_buffer);
+  }
+
+  bool any_changed = false;
+  pvector<int> indices;
+  for (COWPT(GeomPrimitive) &entry : cdata->_primitives) {
+    CPT(GeomPrimitive) prim = entry.get_read_pointer(current_thread);
+    if (!prim->is_exact_type(GeomTriangles::get_class_type()) ||
+        prim->get_num_primitives() < 2) {
+      continue;
+    }
+
+    indices.clear();
+    VertexCacheOptimizer::read_indices(prim, indices, current_thread);
+    nassertv((int)indices.size() == prim->get_num_vertices());
+    VertexCacheOptimizer::optimize_vertex_cache(indices.data(), indices.size(),
+                                                num_vertices, cache_size);
+    if (positions != nullptr) {
+      VertexCacheOptimizer::optimize_overdraw(indices.data(), indices.size(),
+                                              positions, num_vertices,
+                                              cache_size, threshold);
+    }
+
+    PT(GeomPrimitive) new_prim = prim->make_copy();
+    VertexCacheOptimizer::write_indices(new_prim, indices.data(), current_thread);
+    entry = new_prim;
+    any_changed = true;
+  }
+
+  if (reorder_vertices && num_vertices > 0) {
+    indices.clear();
+    for (const COWPT(GeomPrimitive) &entry : cdata->_primitives) {
+      VertexCacheOptimizer::read_indices(entry.get_read_pointer(current_thread),
+                                         indices, current_thread);
+    }
+
+    pvector<int> remap;
+    if (VertexCacheOptimizer::optimize_vertex_fetch(indices.data(), indices.size(),
+                                                    num_vertices, remap)) {
+      PT(GeomVertexData) new_vdata =
+        VertexCacheOptimizer::remap_vertices(vdata, remap, current_thread);
+      nassertv(new_vdata != nullptr);
+      cdata->_data = new_vdata;
+
+      for (COWPT(GeomPrimitive) &entry : cdata->_primitives) {
+        PT(GeomPrimitive) new_prim = entry.get_read_pointer(current_thread)->make_copy();
+        VertexCacheOptimizer::remap_indices(new_prim, remap, current_thread);
+        entry = new_prim;
+      }
+      any_changed = true;
+    }
+  }
+
+  if (any_changed) {
+    if (gobj_cat.is_debug()) {
+      gobj_cat.debug()
+        << "Optimized vertex cache of " << *this << "\n";
+    }
+    cdata->_modified = Geom::get_next_modified();
+    reset_geom_rendering(cdata);
+    clear_cache_stage(current_thread);
+  }
+}
+
+/**
+ * Returns the average number of vertices that are transformed per triangle
+ * (the ACMR, average cache miss ratio) when the triangles of this Geom are
+ * rendered in order with a FIFO post-transform vertex cache of the indicated
+ * size.  This ranges from 3 in the worst case down to about 0.5 for a large,
+ * well-ordered regular grid.  Triangle strips and fans are counted as the
+ * individual triangles they decompose into; other primitive types are
+ * ignored.
+ *
+ * If cache_size is 0, the value of the vertex-cache-size config variable is
+ * used.
+ */
+PN_stdfloat Geom::
+calc_acmr(int cache_size) const {
+  if (cache_size <= 0) {
+    cache_size = vertex_cache_size;
+  }
+
+  Thread *current_thread = Thread::get_current_thread();
+  CDReader cdata(_cycler, current_thread);
+  int num_vertices = cdata->_data.get_read_pointer(current_thread)->get_num_rows();
+
+  pvector<int> indices;
+  for (const COWPT(GeomPrimitive) &entry : cdata->_primitives) {
+    CPT(GeomPrimitive) prim = entry.get_read_pointer(current_thread)->decompose();
+    if (prim->is_exact_type(GeomTriangles::get_class_type())) {
+      VertexCacheOptimizer::read_indices(prim, indices, current_thread);
+    }
+  }
+  return VertexCacheOptimizer::calc_acmr(indices.data(), indices.size(),
+                                         num_vertices, cache_size);
+}
+
+/**
+ * Returns a copy of the indicated GeomTriangles with its vertices replaced by
+ * the indicated indices, using the smallest index type that can hold them.
+ */
+static PT(GeomPrimitive)
+make_triangle_list(const GeomPrimitive *orig_tris, const int *indices,
+                   size_t num_indices, int num_vertices, Thread *current_thread) {
+  PT(GeomPrimitive) new_tris = orig_tris->make_copy();
+  new_tris->clear_vertices();
+  new_tris->set_index_type(num_vertices < 0xffff ? GeomEnums::NT_uint16 : GeomEnums::NT_uint32);
+
+  PT(GeomVertexArrayData) vertices = new_tris->make_index_data();
+  vertices->unclean_set_num_rows((int)num_indices);
+  {
+    GeomVertexWriter writer(vertices, 0, current_thread);
+    for (size_t i = 0; i < num_indices; ++i) {
+      writer.set_data1i(indices[i]);
+    }
+  }
+  new_tris->set_vertices(vertices);
+  return new_tris;
+}
+
+/**
+ * Reduces the number of triangles of this Geom to at most
+ * target_num_triangles by collapsing edges, stopping early if that would make
+ * the surface deviate by more than max_error from the original, in the
+ * coordinate space of the vertices.  If max_error is negative, only the
+ * triangle count limits the simplification; if target_num_triangles is 0,
+ * only the error does.
+ *
+ * All of the triangles are combined into a single GeomTriangles primitive,
+ * decomposing strips and fans as necessary, and reordered for the vertex
+ * cache afterwards.  Other primitive types are left alone.  The vertex data
+ * is not modified; the remaining triangles reference a subset of the
+ * original vertices, so it can be shared with the original Geom.
+ *
+ * Returns the error that was reached.
+ */
+PN_stdfloat Geom::
+simplify_in_place(int target_num_triangles, PN_stdfloat max_error) {
+  Thread *current_thread = Thread::get_current_thread();
+  CDWriter cdata(_cycler, true, current_thread);
+  CPT(GeomVertexData) vdata = cdata->_data.get_read_pointer(current_thread);
+  int num_vertices = vdata->get_num_rows();
+
+  GeomVertexReader position_reader(vdata, InternalName::get_vertex(), current_thread);
+  if (!position_reader.has_column() || num_vertices == 0) {
+    return 0;
+  }
+
+  pvector<int> indices;
+  CPT(GeomPrimitive) orig_tris;
+  Primitives new_primitives;
+  for (const COWPT(GeomPrimitive) &entry : cdata->_primitives) {
+    CPT(GeomPrimitive) prim = entry.get_read_pointer(current_thread);
+    if (prim->get_primitive_type() == PT_polygons &&
+        !prim->is_exact_type(GeomTriangles::get_class_type())) {
+      prim = prim->decompose();
+    }
+    if (prim->is_exact_type(GeomTriangles::get_class_type())) {
+      if (orig_tris == nullptr) {
+        orig_tris = prim;
+      }
+      VertexCacheOptimizer::read_indices(prim, indices, current_thread);
+    } else {
+      new_primitives.push_back(entry);
+    }
+  }
+  if (orig_tris == nullptr) {
+    return 0;
+  }
+
+  pvector<LVecBase3> position_buffer;
+  const LVecBase3 *positions = position_reader.get_data3_range(num_vertices, position_buffer);
+  nassertr(positions != nullptr, 0);
+
+  pvector<PN_stdfloat> attributes, weights;
+  int num_attributes = MeshSimplifier::read_attributes(vdata, attributes, weights, current_thread);
+
+  PN_stdfloat error = 0;
+  size_t num_indices = MeshSimplifier::simplify
+    (indices.data(), indices.size(), positions, num_vertices,
+     attributes.empty() ? nullptr : attributes.data(), num_attributes,
+     weights.data(), (size_t)std::max(target_num_triangles, 0) * 3,
+     max_error, &error);
+  VertexCacheOptimizer::optimize_vertex_cache(indices.data(), num_indices,
+                                              num_vertices, vertex_cache_size);
+
+  if (num_indices > 0) {
+    PT(GeomPrimitive) new_tris = make_triangle_list(orig_tris, indices.data(), num_indices,
+                                                    num_vertices, current_thread);
+    new_primitives.insert(new_primitives.begin(), COWPT(GeomPrimitive)(new_tris));
+  }
+
+  if (gobj_cat.is_debug()) {
+    gobj_cat.debug()
+      << "Simplified " << *this << " from " << indices.size() / 3
+      << " to " << num_indices / 3 << " triangles, with an error of "
+      << error << "\n";
+  }
+
+  cdata->_primitives.swap(new_primitives);
+  cdata->_modified = Geom::get_next_modified();
+  mark_internal_bounds_stale(cdata);
+  reset_geom_rendering(cdata);
+  clear_cache_stage(current_thread);
+  return error;
+}
+
+/**
+ * Returns the number of triangles that are drawn by this Geom, counting the
+ * individual triangles of strips and fans.
+ */
+int Geom::
+get_num_triangles() const {
+  Thread *current_thread = Thread::get_current_thread();
+  CDReader cdata(_cycler, current_thread);
+  int num_triangles = 0;
+  for (const COWPT(GeomPrimitive) &entry : cdata->_primitives) {
+    CPT(GeomPrimitive) prim = entry.get_read_pointer(current_thread);
+    if (prim->get_primitive_type() == PT_polygons && prim->get_num_primitives() > 0) {
+      num_triangles += prim->get_num_faces();
+    }
+  }
+  return num_triangles;
+}
+
+/**
+ * Partitions the triangles of this Geom into clusters of at most
+ * max_triangles triangles each (or geom-cluster-size, if this is 0), and
+ * computes a bounding sphere and a cone containing the triangle normals for
+ * each cluster.  At cull time, the clusters that are outside the view
+ * frustum or facing entirely away from the camera are then left out of the
+ * draw call; see cull_clusters().  This is worthwhile for large meshes such as
+ * terrain or buildings, of which only a small part is usually visible.
+ *
+ * All of the triangles are combined into a single GeomTriangles primitive,
+ * which becomes the first primitive, decomposing strips and fans as
+ * necessary.  Other primitive types are left alone.  The vertex data is not
+ * modified.
+ *
+ * The clusters are discarded again when the Geom is subsequently modified,
+ * so this is best done after flattening.  Returns true if the clusters were
+ * made, or false if the Geom has no triangles or animated vertices.
+ */
+bool Geom::
+make_clusters_in_place(int max_triangles) {
+  if (max_triangles <= 0) {
+    max_triangles = geom_cluster_size;
+  }
+
+  Thread *current_thread = Thread::get_current_thread();
+  CDWriter cdata(_cycler, true, current_thread);
+  CPT(GeomVertexData) vdata = cdata->_data.get_read_pointer(current_thread);
+  int num_vertices = vdata->get_num_rows();
+
+  GeomVertexReader position_reader(vdata, InternalName::get_vertex(), current_thread);
+  if (!position_reader.has_column() || num_vertices == 0 ||
+      vdata->get_format()->get_animation().get_animation_type() != AT_none) {
+    return false;
+  }
+
+  pvector<int> indices;
+  CPT(GeomPrimitive) orig_tris;
+  Primitives new_primitives;
+  for (const COWPT(GeomPrimitive) &entry : cdata->_primitives) {
+    CPT(GeomPrimitive) prim = entry.get_read_pointer(current_thread);
+    if (prim->get_primitive_type() == PT_polygons &&
+        !prim->is_exact_type(GeomTriangles::get_class_type())) {
+      prim = prim->decompose();
+    }
+    if (prim->is_exact_type(GeomTriangles::get_class_type())) {
+      if (orig_tris == nullptr) {
+        orig_tris = prim;
+      }
+      VertexCacheOptimizer::read_indices(prim, indices, current_thread);
+    } else {
+      new_primitives.push_back(entry);
+    }
+  }
+  if (indices.empty()) {
+    return false;
+  }
+
+  pvector<LVecBase3> position_buffer;
+  const LVecBase3 *positions = position_reader.get_data3_range(num_vertices, position_buffer);
+  nassertr(positions != nullptr, false);
+
+  // Within each cluster, the triangles keep the order they are given in, so
+  // we optimize that first.
+  VertexCacheOptimizer::optimize_vertex_cache(indices.data(), indices.size(),
+                                              num_vertices, vertex_cache_size);
+  PT(GeomClusters) clusters = GeomClusters::make_clusters
+    (indices.data(), indices.size(), positions, num_vertices, max_triangles);
+
+  PT(GeomPrimitive) new_tris = make_triangle_list(orig_tris, indices.data(), indices.size(),
+                                                  num_vertices, current_thread);
+  new_primitives.insert(new_primitives.begin(), COWPT(GeomPrimitive)(new_tris));
+
+  if (gobj_cat.is_debug()) {
+    gobj_cat.debug()
+      << "Partitioned " << indices.size() / 3 << " triangles of " << *this
+      << " into " << clusters->get_num_clusters() << " clusters\n";
+  }
+
+  cdata->_primitives.swap(new_primitives);
+  cdata->_modified = Geom::get_next_modified();
+  cdata->_clusters = clusters;
+  cdata->_clusters_modified = cdata->_modified;
+  reset_geom_rendering(cdata);
+  clear_cache_stage(current_thread);
+  return true;
+}
+
+/**
+ * Returns the clusters made by make_clusters_in_place(), or nullptr if the
+ * Geom has no clusters, or has been modified since they were made.
+ */
+CPT(GeomClusters) Geom::
+get_clusters() const {
+  CDReader cdata(_cycler);
+  if (cdata->_clusters_modified != cdata->_modified) {
+    return nullptr;
+  }
+  return cdata->_clusters;
+}
+
+/**
+ * Removes the clusters made by make_clusters_in_place(), so that the Geom is
+ * again culled only as a whole.
+ */
+void Geom::
+clear_clusters() {
+  CDWriter cdata(_cycler, true);
+  cdata->_clusters.clear();
+}
+
 /**
  * Copies the primitives from the indicated Geom into this one.  This does
  * require that both Geoms contain the same fundamental type primitives, both
@@ -1012,6 +1391,35 @@ request_resident() const {
   return resident;
 }
 
+/**
+ * Like request_resident(), but for primitive arrays that are not needed yet,
+ * and are only expected to be needed soon.  If they are not resident, they
+ * will be brought back into memory when the paging threads have nothing more
+ * urgent to do.
+ *
+ * This does not also prefetch the Geom's associated GeomVertexData.  That
+ * must be requested separately.
+ */
+bool Geom::
+request_prefetch() const {
+  Thread *current_thread = Thread::get_current_thread();
+
+  CDReader cdata(_cycler, current_thread);
+
+  bool resident = true;
+
+  Primitives::const_iterator pi;
+  for (pi = cdata->_primitives.begin();
+       pi != cdata->_primitives.end();
+       ++pi) {
+    if (!(*pi).get_read_pointer(current_thread)->request_prefetch()) {
+      resident = false;
+    }
+  }
+
+  return resident;
+}
+
 /**
  * Applies the indicated transform to all of the vertices in the Geom.  If the
  * Geom happens to share a vertex table with another Geom, this operation will
@@ -1092,6 +1500,40 @@ get_bounds(Thread *current_thread) const {
   return cdata->_internal_bounds;
 }
 
+/**
+ * Schedules a background task that computes the bounding volume of the Geom,
+ * if it is not already known, so that a subsequent call to get_bounds() will
+ * not need to wait for it.  This is useful after loading or generating a
+ * large mesh, to avoid a stall the first time it is culled.
+ *
+ * Returns a future that is done when the bounds are available.  If
+ * get_bounds() is called in the meantime, it simply waits for the background
+ * computation to finish.
+ */
+PT(AsyncFuture) Geom::
+async_compute_bounds(int priority) const {
+  {
+    CDLockedReader cdata(_cycler);
+    if (cdata->_user_bounds != nullptr || !cdata->_internal_bounds_stale) {
+      // We already have the bounds.
+      PT(AsyncFuture) fut = new AsyncFuture;
+      fut->set_result(nullptr);
+      return fut;
+    }
+  }
+
+  AsyncTaskManager *task_mgr = AsyncTaskManager::get_global_ptr();
+  static PT(AsyncTaskChain) chain = task_mgr->make_task_chain("geom_bounds_async");
+  chain->set_num_threads(async_geom_bounds_num_threads);
+
+  CPT(Geom) geom = this;
+  AsyncTask *task = chain->add([=](AsyncTask *task) {
+    geom->get_bounds(Thread::get_current_thread());
+    return AsyncTask::DS_done;
+  }, "bounds:" + get_type().get_name(), 0, priority);
+  return (AsyncFuture *)task;
+}
+
 /**
  * Returns the number of vertices rendered by all primitives within the Geom.
  */
@@ -1147,6 +1589,10 @@ write(std::ostream &out, int indent_level) const {
        ++pi) {
     (*pi).get_read_pointer()->write(out, indent_level);
   }
+
+  if (cdata->_clusters != nullptr && cdata->_clusters_modified == cdata->_modified) {
+    indent(out, indent_level) << *cdata->_clusters << "\n";
+  }
 }
 
 /**
@@ -1166,6 +1612,7 @@ clear_cache() {
     entry->erase();
   }
   _cache.clear();
+  _cluster_subsets.clear();
 }
 
 /**
@@ -1310,6 +1757,139 @@ is_in_view(const BoundingVolume *view_frustum, Thread *current_thread) const {
   }
 }
 
+/**
+ * If this Geom has clusters (see make_clusters_in_place()), determines which
+ * of them are potentially visible within the view frustum and from the
+ * indicated camera position, and returns a Geom that draws only those.  This
+ * is a copy of this Geom sharing the same vertex data, with the first
+ * primitive replaced by one containing only the indices of the visible
+ * clusters.  The copy is kept and returned again for as long as the same
+ * clusters are visible, so that the new indices don't need to be uploaded
+ * again every frame.
+ *
+ * cache_key identifies the camera that is culling, so that the copies made
+ * for different cameras don't replace each other.  A copy is kept for each of
+ * the last few cameras.
+ *
+ * Returns this Geom itself if it has no clusters, or if too few triangles
+ * would be culled to be worth it (see cluster-cull-min-fraction), or nullptr
+ * if none of the clusters are visible.
+ *
+ * The view frustum and camera position are given in the coordinate space of
+ * the vertices.  Either may be nullptr to skip that test; the camera position
+ * should only be given if back faces are culled, and reverse should be true
+ * if the front faces are wound clockwise.
+ */
+CPT(Geom) Geom::
+cull_clusters(const GeometricBoundingVolume *view_frustum,
+              const LPoint3 *camera_pos, bool reverse,
+              const void *cache_key, Thread *current_thread) const {
+  CPT(GeomClusters) clusters;
+  CPT(GeomPrimitive) prim;
+  UpdateSeq modified;
+  {
+    CDReader cdata(_cycler, current_thread);
+    if (cdata->_clusters == nullptr ||
+        cdata->_clusters_modified != cdata->_modified ||
+        cdata->_primitives.empty()) {
+      return this;
+    }
+    clusters = cdata->_clusters;
+    prim = cdata->_primitives[0].get_read_pointer(current_thread);
+    modified = cdata->_modified;
+  }
+  int num_indices = prim->get_num_vertices();
+  if (!prim->is_indexed() || num_indices != clusters->get_total_num_indices()) {
+    return this;
+  }
+
+  BitArray visible;
+  int num_visible = clusters->get_visible(visible, view_frustum, camera_pos, reverse);
+  if (num_visible == 0) {
+    return nullptr;
+  }
+  if (num_visible > num_indices * (1.0 - cluster_cull_min_fraction)) {
+    return this;
+  }
+
+  {
+    LightMutexHolder holder(_cache_lock);
+    for (size_t i = 0; i < _cluster_subsets.size(); ++i) {
+      ClusterSubset &entry = _cluster_subsets[i];
+      if (entry._key == cache_key) {
+        if (entry._modified == modified && entry._visible == visible) {
+          CPT(Geom) subset = entry._subset;
+          std::rotate(_cluster_subsets.begin(), _cluster_subsets.begin() + i,
+                      _cluster_subsets.begin() + i + 1);
+          return subset;
+        }
+        break;
+      }
+    }
+  }
+
+  // Copy the index ranges of the visible clusters, merging adjacent ones.
+  PT(GeomPrimitive) new_prim = prim->make_copy();
+  PT(GeomVertexArrayData) new_vertices = new_prim->make_index_data();
+  new_vertices->unclean_set_num_rows(num_visible);
+  {
+    CPT(GeomVertexArrayDataHandle) from = prim->get_vertices()->get_handle(current_thread);
+    PT(GeomVertexArrayDataHandle) to = new_vertices->modify_handle(current_thread);
+    const unsigned char *src = from->get_read_pointer(true);
+    unsigned char *dest = to->get_write_pointer();
+    size_t stride = prim->get_index_stride();
+
+    size_t num_clusters = clusters->get_num_clusters();
+    size_t n = 0;
+    while (n < num_clusters) {
+      if (!visible.get_bit((int)n)) {
+        ++n;
+        continue;
+      }
+      int begin = clusters->get_first_index(n);
+      int end = begin + clusters->get_num_indices(n);
+      for (++n; n < num_clusters && visible.get_bit((int)n) &&
+                clusters->get_first_index(n) == end; ++n) {
+        end += clusters->get_num_indices(n);
+      }
+      size_t num_bytes = (size_t)(end - begin) * stride;
+      memcpy(dest, src + begin * stride, num_bytes);
+      dest += num_bytes;
+    }
+  }
+  new_prim->set_vertices(new_vertices, num_visible);
+
+  PT(Geom) subset = make_copy();
+  subset->set_primitive(0, new_prim);
+
+  // It is still sorted as though it were the whole Geom.
+  subset->set_bounds(get_bounds(current_thread));
+
+  // Replace this camera's previous subset, or else the least recently used
+  // one, and move it to the front.
+  LightMutexHolder holder(_cache_lock);
+  size_t i = 0;
+  while (i < _cluster_subsets.size() && _cluster_subsets[i]._key != cache_key) {
+    ++i;
+  }
+  if (i == _cluster_subsets.size()) {
+    if (i < max_cluster_subsets) {
+      _cluster_subsets.push_back(ClusterSubset());
+    } else {
+      --i;
+    }
+  }
+  std::rotate(_cluster_subsets.begin(), _cluster_subsets.begin() + i,
+              _cluster_subsets.begin() + i + 1);
+
+  ClusterSubset &entry = _cluster_subsets.front();
+  entry._key = cache_key;
+  entry._visible = std::move(visible);
+  entry._subset = subset;
+  entry._modified = modified;
+  return subset;
+}
+
 /**
  * Actually draws the Geom with the indicated GSG, using the indicated vertex
  * data (which might have been pre-munged to support the GSG's needs).
@@ -1803,6 +2383,14 @@ write_datagram(BamWriter *manager, Datagram &dg) const {
   dg.add_uint16(_geom_rendering);
 
   dg.add_uint8(_bounds_type);
+
+  if (manager->get_file_minor_ver() >= 47) {
+    if (_clusters_modified == _modified) {
+      manager->write_pointer(dg, _clusters);
+    } else {
+      manager->write_pointer(dg, nullptr);
+    }
+  }
 }
 
 /**
@@ -1820,6 +2408,10 @@ complete_pointers(TypedWritable **p_list, BamReader *manager) {
     (*pri) = DCAST(GeomPrimitive, p_list[pi++]);
   }
 
+  if (manager->get_file_minor_ver() >= 47) {
+    _clusters = DCAST(GeomClusters, p_list[pi++]);
+  }
+
   return pi;
 }
 
@@ -1851,6 +2443,11 @@ fillin(DatagramIterator &scan, BamReader *manager) {
   if (manager->get_file_minor_ver() >= 19) {
     _bounds_type = (BoundingVolume::BoundsType)scan.get_uint8();
   }
+
+  if (manager->get_file_minor_ver() >= 47) {
+    manager->read_pointer(scan);
+    _clusters_modified = _modified;
+  }
 }
 
 /**
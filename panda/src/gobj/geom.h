@@ -29,6 +29,7 @@
 #include "geomMunger.h"
 #include "geomEnums.h"
 #include "geomCacheEntry.h"
+#include "geomClusters.h"
 #include "textureStage.h"
 #include "updateSeq.h"
 #include "pointerTo.h"
@@ -39,6 +40,7 @@
 #include "pStatCollector.h"
 #include "deletedChain.h"
 #include "lightMutex.h"
+#include "asyncFuture.h"
 
 class GeomContext;
 class PreparedGraphicsObjects;
@@ -110,6 +112,9 @@ PUBLISHED:
   INLINE PT(Geom) make_lines() const;
   INLINE PT(Geom) make_patches() const;
   INLINE PT(Geom) make_adjacency() const;
+  INLINE PT(Geom) optimize_vertex_cache(bool reorder_vertices = true) const;
+  INLINE PT(Geom) simplify(int target_num_triangles, PN_stdfloat max_error = -1) const;
+  INLINE PT(Geom) make_clusters(int max_triangles = 0) const;
 
   void decompose_in_place();
   void doubleside_in_place();
@@ -120,6 +125,14 @@ PUBLISHED:
   void make_lines_in_place();
   void make_patches_in_place();
   void make_adjacency_in_place();
+  void optimize_vertex_cache_in_place(bool reorder_vertices = true);
+  PN_stdfloat calc_acmr(int cache_size = 0) const;
+  PN_stdfloat simplify_in_place(int target_num_triangles, PN_stdfloat max_error = -1);
+  int get_num_triangles() const;
+  bool make_clusters_in_place(int max_triangles = 0);
+  CPT(GeomClusters) get_clusters() const;
+  void clear_clusters();
+  MAKE_PROPERTY(clusters, get_clusters);
 
   virtual bool copy_primitives_from(const Geom *other);
 
@@ -129,12 +142,14 @@ PUBLISHED:
   MAKE_PROPERTY(modified, get_modified);
 
   bool request_resident() const;
+  bool request_prefetch() const;
 
   void transform_vertices(const LMatrix4 &mat);
   bool check_valid() const;
   bool check_valid(const GeomVertexData *vertex_data) const;
 
   CPT(BoundingVolume) get_bounds(Thread *current_thread = Thread::get_current_thread()) const;
+  PT(AsyncFuture) async_compute_bounds(int priority = 0) const;
   int get_nested_vertices(Thread *current_thread = Thread::get_current_thread()) const;
   INLINE void mark_bounds_stale() const;
   INLINE void set_bounds_type(BoundingVolume::BoundsType bounds_type);
@@ -159,6 +174,9 @@ PUBLISHED:
 
 public:
   bool is_in_view(const BoundingVolume *view_frustum, Thread *current_thread) const;
+  CPT(Geom) cull_clusters(const GeometricBoundingVolume *view_frustum,
+                          const LPoint3 *camera_pos, bool reverse,
+                          const void *cache_key, Thread *current_thread) const;
 
   bool draw(GraphicsStateGuardianBase *gsg,
             const GeomVertexData *vertex_data, size_t num_instances,
@@ -333,6 +351,11 @@ private:
     BoundingVolume::BoundsType _bounds_type;
     CPT(BoundingVolume) _user_bounds;
 
+    // The clusters are only valid as long as _modified still matches the
+    // value it had when they were made.
+    CPT(GeomClusters) _clusters;
+    UpdateSeq _clusters_modified;
+
   public:
     static TypeHandle get_class_type() {
       return _type_handle;
@@ -355,6 +378,20 @@ private:
   Cache _cache;
   LightMutex _cache_lock;
 
+  // The most recent results of cull_clusters() for each of the last few
+  // cameras, most recently used first.  Each is reused for as long as the same
+  // clusters are visible to that camera.  Also protected by _cache_lock.
+  class ClusterSubset {
+  public:
+    const void *_key;
+    BitArray _visible;
+    CPT(Geom) _subset;
+    UpdateSeq _modified;
+  };
+  typedef pvector<ClusterSubset> ClusterSubsets;
+  mutable ClusterSubsets _cluster_subsets;
+  static const size_t max_cluster_subsets = 4;
+
   // This works just like the Texture contexts: each Geom keeps a record of
   // all the PGO objects that hold the Geom, and vice-versa.
   typedef pmap<PreparedGraphicsObjects *, GeomContext *> Contexts;
@@ -0,0 +1,432 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file geomClusters.cxx
+ * @author rdb
+ * @date 2026-10-17
+ */
+
+#include "geomClusters.h"
+#include "bamReader.h"
+#include "bamWriter.h"
+#include "datagram.h"
+#include "datagramIterator.h"
+#include "indent.h"
+#include "mathNumbers.h"
+
+#include <algorithm>
+#include <limits>
+#include <math.h>
+
+// A cluster whose triangle normals deviate further than this from the cone
+// axis (expressed as the cosine of the angle) is so unlikely to be entirely
+// back-facing that we don't bother testing it.
+static const PN_stdfloat cluster_min_cone_dot = 0.1f;
+
+TypeHandle GeomClusters::_type_handle;
+
+/**
+ *
+ */
+GeomClusters::
+GeomClusters() :
+  _total_num_indices(0)
+{
+}
+
+/**
+ * Adds a new cluster covering the indicated range of vertex indices of the
+ * primitive.  The cone cutoff is the sine of the largest angle between the
+ * normal of one of the triangles and the cone axis, or 1 to indicate that the
+ * cluster should never be considered back-facing.
+ */
+void GeomClusters::
+add_cluster(int first_index, int num_indices,
+            const LPoint3 &center, PN_stdfloat radius,
+            const LVector3 &cone_axis, PN_stdfloat cone_cutoff) {
+  nassertv(first_index >= 0 && num_indices >= 0);
+
+  Cluster cluster;
+  cluster._first_index = first_index;
+  cluster._num_indices = num_indices;
+  cluster._center = center;
+  cluster._radius = radius;
+  cluster._cone_axis = cone_axis;
+  cluster._cone_cutoff = std::min(cone_cutoff, (PN_stdfloat)1);
+  _clusters.push_back(cluster);
+  _batch.add_sphere(center, radius);
+
+  _total_num_indices = std::max(_total_num_indices, first_index + num_indices);
+}
+
+/**
+ *
+ */
+void GeomClusters::
+output(std::ostream &out) const {
+  out << "GeomClusters, " << _clusters.size() << " clusters, "
+      << _total_num_indices / 3 << " triangles";
+}
+
+/**
+ *
+ */
+void GeomClusters::
+write(std::ostream &out, int indent_level) const {
+  indent(out, indent_level) << *this << ":\n";
+  for (const Cluster &cluster : _clusters) {
+    indent(out, indent_level + 2)
+      << cluster._first_index << " + " << cluster._num_indices
+      << ": center " << cluster._center << ", radius " << cluster._radius
+      << ", cone " << cluster._cone_axis << " cutoff " << cluster._cone_cutoff
+      << "\n";
+  }
+}
+
+/**
+ * Partitions the indicated triangles into clusters of at most max_triangles
+ * triangles each, rearranging the indices so that the triangles of each
+ * cluster are consecutive, and returns the resulting cluster table.
+ *
+ * Each cluster is grown from a seed triangle by repeatedly adding the
+ * neighboring triangle that introduces the fewest new vertices, and is
+ * closest to the center of the cluster and faces the same way as the rest of
+ * it, so that the clusters are compact and can be culled by their normal cone
+ * as often as possible.  Within a cluster, the triangles keep their original relative
+ * order, so the indices are best optimized for the vertex cache first.
+ */
+PT(GeomClusters) GeomClusters::
+make_clusters(int *indices, size_t num_indices, const LVecBase3 *positions,
+              int num_vertices, int max_triangles) {
+  PT(GeomClusters) clusters = new GeomClusters;
+  size_t num_triangles = num_indices / 3;
+  if (num_triangles == 0) {
+    return clusters;
+  }
+  max_triangles = std::max(max_triangles, 1);
+
+  pvector<LVector3> normals(num_triangles, LVector3::zero());
+  pvector<LPoint3> centroids(num_triangles, LPoint3::zero());
+  PN_stdfloat total_area = 0;
+  for (size_t t = 0; t < num_triangles; ++t) {
+    const int *tri = indices + t * 3;
+    LVector3 normal = (positions[tri[1]] - positions[tri[0]])
+      .cross(positions[tri[2]] - positions[tri[0]]);
+    total_area += normal.length() * 0.5f;
+    normal.normalize();
+    normals[t] = normal;
+    centroids[t] = (positions[tri[0]] + positions[tri[1]] + positions[tri[2]]) / 3;
+  }
+
+  // This is the radius a cluster would have if it were a disc made up of
+  // triangles of the average size.
+  PN_stdfloat expected_radius = csqrt(total_area / num_triangles * max_triangles / MathNumbers::pi);
+  if (expected_radius <= 0) {
+    expected_radius = 1;
+  }
+
+  // Build a table of the triangles using each vertex.
+  pvector<int> offsets(num_vertices + 1, 0);
+  for (size_t i = 0; i < num_indices; ++i) {
+    nassertr(indices[i] >= 0 && indices[i] < num_vertices, clusters);
+    ++offsets[indices[i] + 1];
+  }
+  for (int v = 0; v < num_vertices; ++v) {
+    offsets[v + 1] += offsets[v];
+  }
+  pvector<int> adjacency(num_indices);
+  {
+    pvector<int> fill(offsets);
+    for (size_t i = 0; i < num_indices; ++i) {
+      adjacency[fill[indices[i]]++] = (int)(i / 3);
+    }
+  }
+
+  // These record the cluster each triangle was assigned to, and the cluster
+  // that most recently used each vertex or considered each triangle.
+  pvector<int> triangle_cluster(num_triangles, -1);
+  pvector<int> vertex_stamp(num_vertices, -1);
+  pvector<int> candidate_stamp(num_triangles, -1);
+
+  pvector<int> order;
+  order.reserve(num_triangles);
+  pvector<int> cluster_ends;
+  pvector<int> candidates;
+  pvector<int> members;
+  LVector3 normal_sum;
+  LVector3 centroid_sum;
+  int cluster = 0;
+
+  auto add_triangle = [&] (int t) {
+    triangle_cluster[t] = cluster;
+    members.push_back(t);
+    normal_sum += normals[t];
+    centroid_sum += centroids[t];
+    for (int c = 0; c < 3; ++c) {
+      int v = indices[t * 3 + c];
+      if (vertex_stamp[v] == cluster) {
+        continue;
+      }
+      vertex_stamp[v] = cluster;
+      for (int a = offsets[v]; a < offsets[v + 1]; ++a) {
+        int u = adjacency[a];
+        if (triangle_cluster[u] < 0 && candidate_stamp[u] != cluster) {
+          candidate_stamp[u] = cluster;
+          candidates.push_back(u);
+        }
+      }
+    }
+  };
+
+  size_t next_seed = 0;
+  while (order.size() < num_triangles) {
+    // Continue next to where the previous cluster stopped, if possible, so
+    // that the triangles don't stray too far from their original order.
+    int seed = -1;
+    for (int u : candidates) {
+      if (triangle_cluster[u] < 0) {
+        seed = u;
+        break;
+      }
+    }
+    if (seed < 0) {
+      while (triangle_cluster[next_seed] >= 0) {
+        ++next_seed;
+      }
+      seed = (int)next_seed;
+    }
+
+    candidates.clear();
+    members.clear();
+    normal_sum = LVector3::zero();
+    centroid_sum = LVector3::zero();
+    add_triangle(seed);
+
+    while ((int)members.size() < max_triangles) {
+      LVector3 axis = normal_sum;
+      axis.normalize();
+      LPoint3 center = LPoint3(centroid_sum) / (PN_stdfloat)members.size();
+
+      int best = -1;
+      PN_stdfloat best_score = std::numeric_limits<PN_stdfloat>::max();
+      size_t num_candidates = 0;
+      for (int u : candidates) {
+        if (triangle_cluster[u] >= 0) {
+          continue;
+        }
+        candidates[num_candidates++] = u;
+
+        int new_vertices = 0;
+        for (int c = 0; c < 3; ++c) {
+          if (vertex_stamp[indices[u * 3 + c]] != cluster) {
+            ++new_vertices;
+          }
+        }
+        PN_stdfloat score = new_vertices +
+          2 * ((centroids[u] - center).length() / expected_radius +
+               (1 - normals[u].dot(axis)));
+        if (score < best_score) {
+          best_score = score;
+          best = u;
+        }
+      }
+      candidates.resize(num_candidates);
+      if (best < 0) {
+        break;
+      }
+      add_triangle(best);
+    }
+
+    std::sort(members.begin(), members.end());
+    order.insert(order.end(), members.begin(), members.end());
+    cluster_ends.push_back((int)order.size() * 3);
+    ++cluster;
+  }
+
+  pvector<int> new_indices(num_triangles * 3);
+  for (size_t i = 0; i < num_triangles; ++i) {
+    const int *tri = indices + order[i] * 3;
+    new_indices[i * 3 + 0] = tri[0];
+    new_indices[i * 3 + 1] = tri[1];
+    new_indices[i * 3 + 2] = tri[2];
+  }
+  std::copy(new_indices.begin(), new_indices.end(), indices);
+
+  int first_index = 0;
+  for (int end : cluster_ends) {
+    clusters->add_cluster(indices, first_index, end - first_index, positions);
+    first_index = end;
+  }
+  return clusters;
+}
+
+/**
+ * Determines which of the clusters are potentially visible: those that are
+ * at least partially within the view frustum, if it is not nullptr, and that
+ * have at least one triangle facing the camera at the indicated position, if
+ * it is not nullptr.  The view frustum and camera position are given in the
+ * coordinate space of the vertices.  If reverse is true, the front faces are
+ * taken to be wound clockwise rather than counter-clockwise.
+ *
+ * Sets the bits of the visible clusters, and returns the total number of
+ * vertex indices in them.
+ */
+int GeomClusters::
+get_visible(BitArray &visible, const GeometricBoundingVolume *view_frustum,
+            const LPoint3 *camera_pos, bool reverse) const {
+  size_t num_clusters = _clusters.size();
+  visible.clear();
+
+  pvector<int> in_view;
+  if (view_frustum != nullptr) {
+    in_view.resize(num_clusters);
+    _batch.contained_by(view_frustum, in_view.data());
+  }
+
+  int num_visible = 0;
+  for (size_t n = 0; n < num_clusters; ++n) {
+    const Cluster &cluster = _clusters[n];
+    if (!in_view.empty() && in_view[n] == BoundingVolume::IF_no_intersection) {
+      continue;
+    }
+    if (camera_pos != nullptr && cluster._cone_cutoff < 1) {
+      LVector3 offset = cluster._center - *camera_pos;
+      PN_stdfloat dot = offset.dot(cluster._cone_axis);
+      if (reverse) {
+        dot = -dot;
+      }
+      if (dot >= cluster._cone_cutoff * offset.length() + cluster._radius) {
+        continue;
+      }
+    }
+    visible.set_bit((int)n);
+    num_visible += cluster._num_indices;
+  }
+  return num_visible;
+}
+
+/**
+ * Adds a cluster for the indicated range of the index array, computing its
+ * bounding sphere and normal cone from the vertex positions.
+ */
+void GeomClusters::
+add_cluster(const int *indices, int first_index, int num_indices,
+            const LVecBase3 *positions) {
+  const int *begin = indices + first_index;
+  const int *end = begin + num_indices;
+
+  LPoint3 min_point(positions[*begin]);
+  LPoint3 max_point(min_point);
+  LVector3 normal_sum = LVector3::zero();
+  for (const int *tri = begin; tri + 3 <= end; tri += 3) {
+    for (int c = 0; c < 3; ++c) {
+      const LVecBase3 &point = positions[tri[c]];
+      min_point.set(std::min(min_point[0], point[0]),
+                    std::min(min_point[1], point[1]),
+                    std::min(min_point[2], point[2]));
+      max_point.set(std::max(max_point[0], point[0]),
+                    std::max(max_point[1], point[1]),
+                    std::max(max_point[2], point[2]));
+    }
+    normal_sum += (positions[tri[1]] - positions[tri[0]])
+      .cross(positions[tri[2]] - positions[tri[0]]);
+  }
+
+  LPoint3 center = (min_point + max_point) * 0.5f;
+  PN_stdfloat radius_squared = 0;
+  for (const int *index = begin; index != end; ++index) {
+    radius_squared = std::max(radius_squared, (positions[*index] - center).length_squared());
+  }
+
+  // The cone is made to contain the normals of all of the triangles, except
+  // the degenerate ones, which are never drawn anyway.
+  LVector3 axis = normal_sum;
+  PN_stdfloat cutoff = 1;
+  if (axis.normalize()) {
+    PN_stdfloat min_dot = 1;
+    for (const int *tri = begin; tri + 3 <= end; tri += 3) {
+      LVector3 normal = (positions[tri[1]] - positions[tri[0]])
+        .cross(positions[tri[2]] - positions[tri[0]]);
+      if (normal.normalize()) {
+        min_dot = std::min(min_dot, normal.dot(axis));
+      }
+    }
+    if (min_dot > cluster_min_cone_dot) {
+      cutoff = csqrt(1 - min_dot * min_dot);
+    }
+  }
+
+  add_cluster(first_index, num_indices, center, csqrt(radius_squared), axis, cutoff);
+}
+
+/**
+ * Tells the BamReader how to create objects of type GeomClusters.
+ */
+void GeomClusters::
+register_with_read_factory() {
+  BamReader::get_factory()->register_factory(get_class_type(), make_from_bam);
+}
+
+/**
+ * Writes the contents of this object to the datagram for shipping out to a
+ * Bam file.
+ */
+void GeomClusters::
+write_datagram(BamWriter *manager, Datagram &dg) {
+  TypedWritable::write_datagram(manager, dg);
+
+  dg.add_uint32(_clusters.size());
+  for (const Cluster &cluster : _clusters) {
+    dg.add_int32(cluster._first_index);
+    dg.add_int32(cluster._num_indices);
+    cluster._center.write_datagram(dg);
+    dg.add_stdfloat(cluster._radius);
+    cluster._cone_axis.write_datagram(dg);
+    dg.add_stdfloat(cluster._cone_cutoff);
+  }
+}
+
+/**
+ * This function is called by the BamReader's factory when a new object of
+ * type GeomClusters is encountered in the Bam file.  It should create the
+ * GeomClusters and extract its information from the file.
+ */
+TypedWritable *GeomClusters::
+make_from_bam(const FactoryParams &params) {
+  GeomClusters *object = new GeomClusters;
+  DatagramIterator scan;
+  BamReader *manager;
+
+  parse_params(params, scan, manager);
+  object->fillin(scan, manager);
+
+  return object;
+}
+
+/**
+ * This internal function is called by make_from_bam to read in all of the
+ * relevant data from the BamFile for the new GeomClusters.
+ */
+void GeomClusters::
+fillin(DatagramIterator &scan, BamReader *manager) {
+  TypedWritable::fillin(scan, manager);
+
+  size_t num_clusters = scan.get_uint32();
+  _clusters.reserve(num_clusters);
+  for (size_t i = 0; i < num_clusters; ++i) {
+    int first_index = scan.get_int32();
+    int num_indices = scan.get_int32();
+    LPoint3 center;
+    center.read_datagram(scan);
+    PN_stdfloat radius = scan.get_stdfloat();
+    LVector3 cone_axis;
+    cone_axis.read_datagram(scan);
+    PN_stdfloat cone_cutoff = scan.get_stdfloat();
+    add_cluster(first_index, num_indices, center, radius, cone_axis, cone_cutoff);
+  }
+}
@@ -0,0 +1,118 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file geomClusters.h
+ * @author rdb
+ * @date 2026-10-17
+ */
+
+#ifndef GEOMCLUSTERS_H
+#define GEOMCLUSTERS_H
+
+#include "pandabase.h"
+#include "typedWritableReferenceCount.h"
+#include "boundingVolumeBatch.h"
+#include "geometricBoundingVolume.h"
+#include "bitArray.h"
+#include "factoryParams.h"
+#include "luse.h"
+#include "pvector.h"
+
+/**
+ * Describes how the triangles of the first primitive of a Geom are
+ * partitioned into small clusters, each occupying a contiguous range of
+ * indices, along with a bounding sphere and a cone that bounds the normals of
+ * each cluster.  This allows the clusters that are outside the view frustum,
+ * or whose triangles are all facing away from the camera, to be skipped at
+ * cull time, even though the Geom as a whole is visible.
+ *
+ * See Geom::make_clusters() and SceneGraphReducer::make_clusters().
+ */
+class EXPCL_PANDA_GOBJ GeomClusters : public TypedWritableReferenceCount {
+PUBLISHED:
+  GeomClusters();
+
+  INLINE size_t get_num_clusters() const;
+  INLINE int get_first_index(size_t n) const;
+  INLINE int get_num_indices(size_t n) const;
+  INLINE const LPoint3 &get_center(size_t n) const;
+  INLINE PN_stdfloat get_radius(size_t n) const;
+  INLINE const LVector3 &get_cone_axis(size_t n) const;
+  INLINE PN_stdfloat get_cone_cutoff(size_t n) const;
+  INLINE int get_total_num_indices() const;
+
+  INLINE bool is_back_facing(size_t n, const LPoint3 &camera_pos) const;
+
+  void add_cluster(int first_index, int num_indices,
+                   const LPoint3 &center, PN_stdfloat radius,
+                   const LVector3 &cone_axis, PN_stdfloat cone_cutoff);
+
+  void output(std::ostream &out) const;
+  void write(std::ostream &out, int indent_level = 0) const;
+
+public:
+  static PT(GeomClusters) make_clusters(int *indices, size_t num_indices,
+                                        const LVecBase3 *positions,
+                                        int num_vertices, int max_triangles);
+
+  int get_visible(BitArray &visible,
+                  const GeometricBoundingVolume *view_frustum,
+                  const LPoint3 *camera_pos, bool reverse) const;
+
+private:
+  void add_cluster(const int *indices, int first_index, int num_indices,
+                   const LVecBase3 *positions);
+
+  class Cluster {
+  public:
+    int _first_index;
+    int _num_indices;
+    LPoint3 _center;
+    PN_stdfloat _radius;
+    LVector3 _cone_axis;
+    PN_stdfloat _cone_cutoff;
+  };
+  typedef pvector<Cluster> Clusters;
+  Clusters _clusters;
+  int _total_num_indices;
+
+  // The bounding spheres again, for testing them against the frustum in one
+  // go.
+  BoundingVolumeBatch _batch;
+
+public:
+  static void register_with_read_factory();
+  virtual void write_datagram(BamWriter *manager, Datagram &dg);
+
+protected:
+  static TypedWritable *make_from_bam(const FactoryParams &params);
+  void fillin(DatagramIterator &scan, BamReader *manager);
+
+public:
+  static TypeHandle get_class_type() {
+    return _type_handle;
+  }
+  static void init_type() {
+    TypedWritableReferenceCount::init_type();
+    register_type(_type_handle, "GeomClusters",
+                  TypedWritableReferenceCount::get_class_type());
+  }
+  virtual TypeHandle get_type() const {
+    return get_class_type();
+  }
+  virtual TypeHandle force_init_type() {init_type(); return get_class_type();}
+
+private:
+  static TypeHandle _type_handle;
+};
+
+INLINE std::ostream &operator << (std::ostream &out, const GeomClusters &obj);
+
+#include "geomClusters.I"
+
+#endif
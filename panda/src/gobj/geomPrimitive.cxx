@@ -30,10 +30,127 @@
 #include "ioPtaDatagramInt.h"
 #include "indent.h"
 #include "pStatTimer.h"
+#include "asyncTaskManager.h"
+#include "config_gobj.h"
 
 using std::max;
 using std::min;
 
+// The number of vertices handled by each task when computing the bounds of
+// a large primitive on multiple threads.
+static const size_t bounds_rows_per_task = 32768;
+
+/**
+ * The running result of calc_tight_bounds().
+ */
+struct TightBounds {
+  LPoint3 _min_point;
+  LPoint3 _max_point;
+  PN_stdfloat _sq_center_dist;
+  bool _found_any;
+};
+
+/**
+ * Expands the bounds to include the vertices returned by fetch(i) for each i
+ * in the range [begin, end).  Vertices containing NaN are skipped until the
+ * first valid vertex has been found; after that, the NaN components are
+ * ignored by min() and max().
+ *
+ * The inner loop keeps each component in its own accumulator, so that the
+ * compiler can turn it into packed min/max instructions.
+ */
+template<class Fetch>
+static void
+expand_tight_bounds(TightBounds &bounds, size_t begin, size_t end, Fetch fetch) {
+  size_t i = begin;
+  while (!bounds._found_any) {
+    if (i >= end) {
+      return;
+    }
+    LPoint3 vertex = fetch(i++);
+    if (!vertex.is_nan()) {
+      bounds._min_point = vertex;
+      bounds._max_point = vertex;
+      bounds._sq_center_dist = vertex.length_squared();
+      bounds._found_any = true;
+    }
+  }
+
+  PN_stdfloat min_x = bounds._min_point[0];
+  PN_stdfloat min_y = bounds._min_point[1];
+  PN_stdfloat min_z = bounds._min_point[2];
+  PN_stdfloat max_x = bounds._max_point[0];
+  PN_stdfloat max_y = bounds._max_point[1];
+  PN_stdfloat max_z = bounds._max_point[2];
+  PN_stdfloat sq_center_dist = bounds._sq_center_dist;
+
+  for (; i < end; ++i) {
+    LPoint3 vertex = fetch(i);
+    min_x = min(min_x, vertex[0]);
+    min_y = min(min_y, vertex[1]);
+    min_z = min(min_z, vertex[2]);
+    max_x = max(max_x, vertex[0]);
+    max_y = max(max_y, vertex[1]);
+    max_z = max(max_z, vertex[2]);
+    sq_center_dist = max(sq_center_dist, vertex.length_squared());
+  }
+
+  bounds._min_point.set(min_x, min_y, min_z);
+  bounds._max_point.set(max_x, max_y, max_z);
+  bounds._sq_center_dist = sq_center_dist;
+}
+
+/**
+ * Merges the bounds computed over a later range of vertices into the bounds.
+ */
+static void
+merge_tight_bounds(TightBounds &bounds, const TightBounds &other) {
+  if (!other._found_any) {
+    return;
+  }
+  if (!bounds._found_any) {
+    bounds = other;
+    return;
+  }
+  bounds._min_point = bounds._min_point.fmin(other._min_point);
+  bounds._max_point = bounds._max_point.fmax(other._max_point);
+  bounds._sq_center_dist = max(bounds._sq_center_dist, other._sq_center_dist);
+}
+
+/**
+ * Calls process(result, begin, end) over the range [0, count).  If the range
+ * is large enough and geom-bounds-num-threads is set, it is split into
+ * batches that are processed in parallel, each into its own copy of the
+ * initial result, and these are then combined in order using merge().
+ */
+template<class Result, class Process, class Merge>
+static void
+process_bounds(size_t count, Result &result, const Result &initial,
+               Process process, Merge merge) {
+  int num_threads = geom_bounds_num_threads;
+  size_t num_tasks = (count + bounds_rows_per_task - 1) / bounds_rows_per_task;
+  if (num_threads <= 0 || num_tasks < 2) {
+    process(result, 0, count);
+    return;
+  }
+
+  static PT(AsyncTaskChain) chain =
+    AsyncTaskManager::get_global_ptr()->make_task_chain("geom_bounds");
+  if (chain->get_num_threads() < num_threads) {
+    chain->set_num_threads(num_threads);
+  }
+
+  pvector<Result> results(num_tasks, initial);
+  chain->parallel_for(num_tasks, [&] (size_t ti) {
+    size_t begin = ti * bounds_rows_per_task;
+    process(results[ti], begin, min(begin + bounds_rows_per_task, count));
+  });
+
+  for (const Result &partial : results) {
+    merge(result, partial);
+  }
+}
+
 TypeHandle GeomPrimitive::_type_handle;
 TypeHandle GeomPrimitive::CData::_type_handle;
 TypeHandle GeomPrimitivePipelineReader::_type_handle;
@@ -1148,6 +1265,37 @@ request_resident(Thread *current_thread) const {
   return resident;
 }
 
+/**
+ * Like request_resident(), but for primitive data that is not needed yet, and
+ * is only expected to be needed soon.  If the data is not resident, it will
+ * be brought back into memory when the paging threads have nothing more
+ * urgent to do.
+ */
+bool GeomPrimitive::
+request_prefetch(Thread *current_thread) const {
+  CDReader cdata(_cycler, current_thread);
+
+  bool resident = true;
+
+  if (!cdata->_vertices.is_null() &&
+      !cdata->_vertices.get_read_pointer(current_thread)->request_prefetch(current_thread)) {
+    resident = false;
+  }
+
+  if (is_composite() && cdata->_got_minmax) {
+    if (!cdata->_mins.is_null() &&
+        !cdata->_mins.get_read_pointer(current_thread)->request_prefetch(current_thread)) {
+      resident = false;
+    }
+    if (!cdata->_maxs.is_null() &&
+        !cdata->_maxs.get_read_pointer(current_thread)->request_prefetch(current_thread)) {
+      resident = false;
+    }
+  }
+
+  return resident;
+}
+
 /**
  *
  */
@@ -1656,152 +1804,61 @@ calc_tight_bounds(LPoint3 &min_point, LPoint3 &max_point,
   }
 
   CDReader cdata(_cycler, current_thread);
-  int i = 0;
-
-  if (cdata->_vertices.is_null()) {
-    // Nonindexed case.
-    nassertv(cdata->_num_vertices != -1);
-    if (cdata->_num_vertices == 0) {
-      return;
-    }
-
-    if (got_mat) {
-      // Find the first non-NaN vertex.
-      while (!found_any && i < cdata->_num_vertices) {
-        reader.set_row(cdata->_first_vertex + i);
-        LPoint3 first_vertex = mat.xform_point_general(reader.get_data3());
-        if (!first_vertex.is_nan()) {
-          min_point = first_vertex;
-          max_point = first_vertex;
-          sq_center_dist = first_vertex.length_squared();
-          found_any = true;
-        }
-        ++i;
-      }
-
-      for (; i < cdata->_num_vertices; ++i) {
-        reader.set_row_unsafe(cdata->_first_vertex + i);
-        nassertv(!reader.is_at_end());
-
-        LPoint3 vertex = mat.xform_point_general(reader.get_data3());
+  pvector<LVecBase3> buffer;
+  pvector<int> indices;
+  int num_vertices;
+  const LVecBase3 *vertices =
+    read_vertices(reader, cdata, buffer, indices, num_vertices, current_thread);
+  if (vertices == nullptr) {
+    return;
+  }
 
-        min_point.set(min(min_point[0], vertex[0]),
-                      min(min_point[1], vertex[1]),
-                      min(min_point[2], vertex[2]));
-        max_point.set(max(max_point[0], vertex[0]),
-                      max(max_point[1], vertex[1]),
-                      max(max_point[2], vertex[2]));
-        sq_center_dist = max(sq_center_dist, vertex.length_squared());
+  TightBounds bounds;
+  bounds._min_point = min_point;
+  bounds._max_point = max_point;
+  bounds._sq_center_dist = sq_center_dist;
+  bounds._found_any = found_any;
+
+  TightBounds initial;
+  initial._min_point = LPoint3::zero();
+  initial._max_point = LPoint3::zero();
+  initial._sq_center_dist = 0.0f;
+  initial._found_any = false;
+
+  // The vertices and indices are only read, so the batches may safely be
+  // processed by other threads.
+  const int *index_data = indices.data();
+  process_bounds((size_t)num_vertices, bounds, initial,
+                 [&] (TightBounds &result, size_t begin, size_t end) {
+    if (indices.empty()) {
+      // Nonindexed case.
+      if (got_mat) {
+        expand_tight_bounds(result, begin, end, [&] (size_t i) {
+          return LPoint3(mat.xform_point_general(vertices[i]));
+        });
+      } else {
+        expand_tight_bounds(result, begin, end, [&] (size_t i) {
+          return LPoint3(vertices[i]);
+        });
       }
     } else {
-      // Find the first non-NaN vertex.
-      while (!found_any && i < cdata->_num_vertices) {
-        reader.set_row(cdata->_first_vertex + i);
-        LPoint3 first_vertex = reader.get_data3();
-        if (!first_vertex.is_nan()) {
-          min_point = first_vertex;
-          max_point = first_vertex;
-          sq_center_dist = first_vertex.length_squared();
-          found_any = true;
-        }
-        ++i;
+      // Indexed case.
+      if (got_mat) {
+        expand_tight_bounds(result, begin, end, [&] (size_t i) {
+          return LPoint3(mat.xform_point_general(vertices[index_data[i]]));
+        });
+      } else {
+        expand_tight_bounds(result, begin, end, [&] (size_t i) {
+          return LPoint3(vertices[index_data[i]]);
+        });
       }
-
-      for (; i < cdata->_num_vertices; ++i) {
-        reader.set_row_unsafe(cdata->_first_vertex + i);
-        nassertv(!reader.is_at_end());
-
-        const LVecBase3 &vertex = reader.get_data3();
-
-        min_point.set(min(min_point[0], vertex[0]),
-                      min(min_point[1], vertex[1]),
-                      min(min_point[2], vertex[2]));
-        max_point.set(max(max_point[0], vertex[0]),
-                      max(max_point[1], vertex[1]),
-                      max(max_point[2], vertex[2]));
-        sq_center_dist = max(sq_center_dist, vertex.length_squared());
-      }
-    }
-
-  } else {
-    // Indexed case.
-    GeomVertexReader index(cdata->_vertices.get_read_pointer(), 0, current_thread);
-    if (index.is_at_end()) {
-      return;
     }
+  }, merge_tight_bounds);
 
-    int strip_cut_index = get_strip_cut_index(cdata->_index_type);
-
-    if (got_mat) {
-      // Find the first non-NaN vertex.
-      while (!found_any && !index.is_at_end()) {
-        int ii = index.get_data1i();
-        if (ii != strip_cut_index) {
-          reader.set_row(ii);
-          LPoint3 first_vertex = mat.xform_point_general(reader.get_data3());
-          if (!first_vertex.is_nan()) {
-            min_point = first_vertex;
-            max_point = first_vertex;
-            sq_center_dist = first_vertex.length_squared();
-            found_any = true;
-          }
-        }
-      }
-
-      while (!index.is_at_end()) {
-        int ii = index.get_data1i();
-        if (ii == strip_cut_index) {
-          continue;
-        }
-        reader.set_row_unsafe(ii);
-        nassertv(!reader.is_at_end());
-
-        LPoint3 vertex = mat.xform_point_general(reader.get_data3());
-
-        min_point.set(min(min_point[0], vertex[0]),
-                      min(min_point[1], vertex[1]),
-                      min(min_point[2], vertex[2]));
-        max_point.set(max(max_point[0], vertex[0]),
-                      max(max_point[1], vertex[1]),
-                      max(max_point[2], vertex[2]));
-        sq_center_dist = max(sq_center_dist, vertex.length_squared());
-      }
-    } else {
-      // Find the first non-NaN vertex.
-      while (!found_any && !index.is_at_end()) {
-        int ii = index.get_data1i();
-        if (ii != strip_cut_index) {
-          reader.set_row(ii);
-          LVecBase3 first_vertex = reader.get_data3();
-          if (!first_vertex.is_nan()) {
-            min_point = first_vertex;
-            max_point = first_vertex;
-            sq_center_dist = first_vertex.length_squared();
-            found_any = true;
-          }
-        }
-      }
-
-      while (!index.is_at_end()) {
-        int ii = index.get_data1i();
-        if (ii == strip_cut_index) {
-          continue;
-        }
-        reader.set_row_unsafe(ii);
-        nassertv(!reader.is_at_end());
-
-        const LVecBase3 &vertex = reader.get_data3();
-
-        min_point.set(min(min_point[0], vertex[0]),
-                      min(min_point[1], vertex[1]),
-                      min(min_point[2], vertex[2]));
-        max_point.set(max(max_point[0], vertex[0]),
-                      max(max_point[1], vertex[1]),
-                      max(max_point[2], vertex[2]));
-        sq_center_dist = max(sq_center_dist, vertex.length_squared());
-      }
-    }
-  }
+  min_point = bounds._min_point;
+  max_point = bounds._max_point;
+  sq_center_dist = bounds._sq_center_dist;
+  found_any = bounds._found_any;
 }
 
 /**
@@ -1826,43 +1883,128 @@ calc_sphere_radius(const LPoint3 &center, PN_stdfloat &sq_radius,
   }
 
   CDReader cdata(_cycler, current_thread);
+  pvector<LVecBase3> buffer;
+  pvector<int> indices;
+  int num_vertices;
+  const LVecBase3 *vertices =
+    read_vertices(reader, cdata, buffer, indices, num_vertices, current_thread);
+  if (vertices == nullptr) {
+    return;
+  }
+  found_any = true;
+
+  const int *index_data = indices.data();
+  process_bounds((size_t)num_vertices, sq_radius, (PN_stdfloat)0,
+                 [&] (PN_stdfloat &result, size_t begin, size_t end) {
+    PN_stdfloat max_sq_radius = result;
+    if (indices.empty()) {
+      for (size_t i = begin; i < end; ++i) {
+        max_sq_radius = max(max_sq_radius, (vertices[i] - center).length_squared());
+      }
+    } else {
+      for (size_t i = begin; i < end; ++i) {
+        max_sq_radius = max(max_sq_radius, (vertices[index_data[i]] - center).length_squared());
+      }
+    }
+    result = max_sq_radius;
+  }, [] (PN_stdfloat &result, PN_stdfloat partial) {
+    result = max(result, partial);
+  });
+}
+
+/**
+ * Reads the vertices used by this primitive from the column that the reader
+ * is set to, in bulk, for the benefit of calc_tight_bounds() and
+ * calc_sphere_radius().
+ *
+ * For a nonindexed primitive, returns a pointer to its num_vertices
+ * consecutive vertices, and leaves indices empty.  For an indexed primitive,
+ * only the range of vertices referenced by the primitive is read, and indices
+ * is filled with the index of each referenced vertex relative to the returned
+ * pointer, omitting the strip-cut indices.  Returns NULL if there are no
+ * vertices.
+ */
+const LVecBase3 *GeomPrimitive::
+read_vertices(GeomVertexReader &reader, const CData *cdata,
+              pvector<LVecBase3> &buffer, pvector<int> &indices,
+              int &num_vertices, Thread *current_thread) const {
+  indices.clear();
+  num_vertices = 0;
 
   if (cdata->_vertices.is_null()) {
     // Nonindexed case.
-    nassertv(cdata->_num_vertices != -1);
+    nassertr(cdata->_num_vertices != -1, nullptr);
     if (cdata->_num_vertices == 0) {
-      return;
+      return nullptr;
     }
-    found_any = true;
-
-    for (int i = 0; i < cdata->_num_vertices; ++i) {
-      reader.set_row_unsafe(cdata->_first_vertex + i);
-      const LVecBase3 &vertex = reader.get_data3();
-
-      sq_radius = max(sq_radius, (vertex - center).length_squared());
+    reader.set_row(cdata->_first_vertex);
+    const LVecBase3 *vertices = reader.get_data3_range(cdata->_num_vertices, buffer);
+    if (vertices != nullptr) {
+      num_vertices = cdata->_num_vertices;
     }
+    return vertices;
+  }
 
-  } else {
-    // Indexed case.
-    GeomVertexReader index(cdata->_vertices.get_read_pointer(), 0, current_thread);
-    if (index.is_at_end()) {
-      return;
+  // Indexed case.  We read the index buffer directly, since we know what
+  // format it is in.
+  CPT(GeomVertexArrayData) index_data = cdata->_vertices.get_read_pointer(current_thread);
+  CPT(GeomVertexArrayDataHandle) handle = index_data->get_handle(current_thread);
+  const unsigned char *pointer = handle->get_read_pointer(true);
+  if (pointer == nullptr) {
+    return nullptr;
+  }
+  size_t num_bytes = handle->get_data_size_bytes();
+
+  int strip_cut_index = get_strip_cut_index(cdata->_index_type);
+  int min_index = INT_MAX;
+  int max_index = -1;
+  auto read_indices = [&] (auto *data, size_t count) {
+    indices.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+      int index = (int)data[i];
+      if (index != strip_cut_index) {
+        indices.push_back(index);
+        min_index = min(min_index, index);
+        max_index = max(max_index, index);
+      }
     }
-    found_any = true;
+  };
 
-    int strip_cut_index = get_strip_cut_index(cdata->_index_type);
+  switch (cdata->_index_type) {
+  case NT_uint8:
+    read_indices((const uint8_t *)pointer, num_bytes);
+    break;
+  case NT_uint16:
+    read_indices((const uint16_t *)pointer, num_bytes / sizeof(uint16_t));
+    break;
+  case NT_uint32:
+    read_indices((const uint32_t *)pointer, num_bytes / sizeof(uint32_t));
+    break;
+  default:
+    nassertr(false, nullptr);
+    return nullptr;
+  }
 
-    while (!index.is_at_end()) {
-      int ii = index.get_data1i();
-      if (ii == strip_cut_index) {
-        continue;
-      }
-      reader.set_row_unsafe(ii);
-      const LVecBase3 &vertex = reader.get_data3();
+  if (indices.empty()) {
+    return nullptr;
+  }
+  nassertr(min_index >= 0, nullptr);
 
-      sq_radius = max(sq_radius, (vertex - center).length_squared());
+  // Only decode the range of vertices that is actually referenced.
+  reader.set_row(min_index);
+  const LVecBase3 *vertices = reader.get_data3_range(max_index - min_index + 1, buffer);
+  if (vertices == nullptr) {
+    indices.clear();
+    return nullptr;
+  }
+
+  if (min_index != 0) {
+    for (int &index : indices) {
+      index -= min_index;
     }
   }
+  num_vertices = (int)indices.size();
+  return vertices;
 }
 
 /**
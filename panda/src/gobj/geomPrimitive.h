@@ -37,6 +37,7 @@ class IndexBufferContext;
 class GraphicsStateGuardianBase;
 class FactoryParams;
 class GeomPrimitivePipelineReader;
+class GeomVertexReader;
 
 /**
  * This is an abstract base class for a family of classes that represent the
@@ -145,6 +146,7 @@ PUBLISHED:
   MAKE_PROPERTY(modified, get_modified);
 
   bool request_resident(Thread *current_thread = Thread::get_current_thread()) const;
+  bool request_prefetch(Thread *current_thread = Thread::get_current_thread()) const;
 
   INLINE bool check_valid(const GeomVertexData *vertex_data) const;
   INLINE bool check_valid(const GeomVertexDataPipelineReader *data_reader) const;
@@ -250,6 +252,10 @@ private:
   void consider_elevate_index_type(CData *cdata, int vertex);
   void do_set_index_type(CData *cdata, NumericType index_type);
   PT(GeomVertexArrayData) do_modify_vertices(CData *cdata);
+  const LVecBase3 *read_vertices(GeomVertexReader &reader, const CData *cdata,
+                                 pvector<LVecBase3> &buffer,
+                                 pvector<int> &indices, int &num_vertices,
+                                 Thread *current_thread) const;
 
 private:
   // A GeomPrimitive keeps a list (actually, a map) of all the
@@ -97,6 +97,7 @@ PUBLISHED:
   void write(std::ostream &out, int indent_level = 0) const;
 
   INLINE bool request_resident(Thread *current_thread = Thread::get_current_thread()) const;
+  INLINE bool request_prefetch(Thread *current_thread = Thread::get_current_thread()) const;
 
   INLINE CPT(GeomVertexArrayDataHandle) get_handle(Thread *current_thread = Thread::get_current_thread()) const;
   INLINE PT(GeomVertexArrayDataHandle) modify_handle(Thread *current_thread = Thread::get_current_thread());
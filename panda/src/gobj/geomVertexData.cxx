@@ -21,6 +21,20 @@
 #include "bamWriter.h"
 #include "pset.h"
 #include "indent.h"
+#include "asyncTaskManager.h"
+#include "config_gobj.h"
+
+#include <cstring>
+
+#ifndef STDFLOAT_DOUBLE
+#if defined(__SSE2__) || (_M_IX86_FP >= 2) || defined(_M_X64) || defined(_M_AMD64)
+#include <xmmintrin.h>
+#define SKINNING_USE_SSE
+#elif defined(__ARM_NEON) || defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define SKINNING_USE_NEON
+#endif
+#endif
 
 using std::ostream;
 
@@ -36,6 +50,28 @@ PStatCollector GeomVertexData::_scale_color_pcollector("*:Munge:Scale color");
 PStatCollector GeomVertexData::_set_color_pcollector("*:Munge:Set color");
 PStatCollector GeomVertexData::_animation_pcollector("*:Animation");
 
+// The number of rows that do_fast_skinning() hands to each thread at a time.
+static const int skinning_rows_per_task = 2048;
+
+/**
+ * Describes one of the columns animated by do_fast_skinning().
+ */
+class SkinningColumn {
+public:
+  enum Kind {
+    K_point,
+    K_vector,
+    K_normal,
+  };
+
+  const unsigned char *_from;
+  size_t _from_stride;
+  unsigned char *_to;
+  size_t _to_stride;
+  int _num_values;
+  Kind _kind;
+};
+
 
 /**
  * Constructs an invalid object.  This is only used when reading from the bam
@@ -432,6 +468,30 @@ request_resident() const {
   return resident;
 }
 
+/**
+ * Like request_resident(), but for vertex data that is not needed yet, and is
+ * only expected to be needed soon.  If the data is not resident, it will be
+ * brought back into memory when the paging threads have nothing more urgent
+ * to do.
+ */
+bool GeomVertexData::
+request_prefetch() const {
+  CDReader cdata(_cycler);
+
+  bool resident = true;
+
+  Arrays::const_iterator ai;
+  for (ai = cdata->_arrays.begin();
+       ai != cdata->_arrays.end();
+       ++ai) {
+    if (!(*ai).get_read_pointer()->request_prefetch()) {
+      resident = false;
+    }
+  }
+
+  return resident;
+}
+
 /**
  * Copies all the data from the other array into the corresponding data types
  * in this array, by matching data types name-by-name.
@@ -1445,22 +1505,47 @@ update_animated_vertices(GeomVertexData::CData *cdata, Thread *current_thread) {
   const GeomVertexFormat *orig_format = cdata->_format;
   CPT(GeomVertexFormat) new_format = orig_format;
 
+  bool copied = false;
   if (cdata->_animated_vertices == nullptr) {
     new_format = orig_format->get_post_animated_format();
     cdata->_animated_vertices =
       new GeomVertexData(get_name(), new_format,
                          std::min(get_usage_hint(), UH_dynamic));
+    cdata->_animated_source_modified.clear();
   }
   PT(GeomVertexData) new_data = cdata->_animated_vertices;
 
-  // We have to make a complete copy of the data first so we can modify it.
-  // If we were clever, we could maybe just figure out the subset of the data
-  // that might have changed since last frame, but that's too much trouble
-  // (and isn't obviously faster than just copying the whole thing).
-  new_data->copy_from(this, true);
+  // The animated columns are always recomputed, but the rest of the data only
+  // needs to be copied again if it has changed since it was last copied.
+  UpdateSeq source_modified = cdata->_modified;
+  for (const COWPT(GeomVertexArrayData) &array : cdata->_arrays) {
+    UpdateSeq array_modified = array.get_read_pointer(current_thread)->get_modified();
+    if (source_modified < array_modified) {
+      source_modified = array_modified;
+    }
+  }
+  if (cdata->_animated_source_modified != source_modified ||
+      new_data->get_num_rows() != num_rows) {
+    new_data->copy_from(this, true);
+    cdata->_animated_source_modified = source_modified;
+    copied = true;
+  }
 
-  // First, apply all of the morphs.
   CPT(SliderTable) slider_table = cdata->_slider_table;
+  CPT(TransformBlendTable) tb_table = cdata->_transform_blend_table.get_read_pointer(current_thread);
+
+  if (slider_table == nullptr && tb_table != nullptr && cpu_skinning_fast_path &&
+      do_fast_skinning(cdata, new_data, tb_table, current_thread)) {
+    return;
+  }
+
+  if (!copied) {
+    // The code below modifies the animated columns in place, so we have to
+    // start with a complete copy of the data.
+    new_data->copy_from(this, true);
+  }
+
+  // First, apply all of the morphs.
   if (slider_table != nullptr) {
     PStatTimer timer2(_morphs_pcollector);
     int num_morphs = orig_format->get_num_morphs();
@@ -1543,7 +1628,6 @@ update_animated_vertices(GeomVertexData::CData *cdata, Thread *current_thread) {
   }
 
   // Then apply the transforms.
-  CPT(TransformBlendTable) tb_table = cdata->_transform_blend_table.get_read_pointer(current_thread);
   if (tb_table != nullptr) {
     // Recompute all the blends up front, so we don't have to test each one
     // for staleness at each vertex.
@@ -1751,6 +1835,333 @@ update_animated_vertices(GeomVertexData::CData *cdata, Thread *current_thread) {
   }
 }
 
+/**
+ * Applies the blend matrices indicated by the blend indices to the values of
+ * the indicated column, for the rows in the range [begin, end).  The values
+ * are read from the original vertex data and written to the animated vertex
+ * data.
+ */
+template<class Index>
+static void
+skin_column(const SkinningColumn &column, const LMatrix4f *palette,
+            const unsigned char *normalize, size_t num_blends,
+            const unsigned char *blendt, size_t blend_stride,
+            int begin, int end) {
+  const unsigned char *from = column._from + begin * column._from_stride;
+  unsigned char *to = column._to + begin * column._to_stride;
+  blendt += begin * blend_stride;
+
+  // A 4-component value is transformed by the whole matrix, as in
+  // table_xform_vecbase4f().  A 3-component point gets the translation added,
+  // but a 3-component vector does not.
+  int num_values = column._num_values;
+  bool add_translation = (num_values == 3 && column._kind == SkinningColumn::K_point);
+  size_t num_bytes = num_values * sizeof(float);
+
+  for (int i = begin; i < end; ++i) {
+    size_t bi = *(const Index *)blendt;
+    if (bi < num_blends) {
+      const float *v = (const float *)from;
+      const float *m = palette[bi].get_data();
+      float result[4];
+
+#if defined(SKINNING_USE_SSE)
+      __m128 acc = _mm_mul_ps(_mm_set1_ps(v[0]), _mm_loadu_ps(m));
+      acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(v[1]), _mm_loadu_ps(m + 4)));
+      acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(v[2]), _mm_loadu_ps(m + 8)));
+      if (num_values == 4) {
+        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(v[3]), _mm_loadu_ps(m + 12)));
+      } else if (add_translation) {
+        acc = _mm_add_ps(acc, _mm_loadu_ps(m + 12));
+      }
+      _mm_storeu_ps(result, acc);
+
+#elif defined(SKINNING_USE_NEON)
+      float32x4_t acc = vmulq_n_f32(vld1q_f32(m), v[0]);
+      acc = vmlaq_n_f32(acc, vld1q_f32(m + 4), v[1]);
+      acc = vmlaq_n_f32(acc, vld1q_f32(m + 8), v[2]);
+      if (num_values == 4) {
+        acc = vmlaq_n_f32(acc, vld1q_f32(m + 12), v[3]);
+      } else if (add_translation) {
+        acc = vaddq_f32(acc, vld1q_f32(m + 12));
+      }
+      vst1q_f32(result, acc);
+
+#else
+      for (int j = 0; j < 4; ++j) {
+        result[j] = v[0] * m[j] + v[1] * m[4 + j] + v[2] * m[8 + j];
+        if (num_values == 4) {
+          result[j] += v[3] * m[12 + j];
+        } else if (add_translation) {
+          result[j] += m[12 + j];
+        }
+      }
+#endif
+
+      if (normalize != nullptr && normalize[bi]) {
+        float length = csqrt(result[0] * result[0] + result[1] * result[1] + result[2] * result[2]);
+        if (length != 0.0f) {
+          result[0] /= length;
+          result[1] /= length;
+          result[2] /= length;
+        }
+      }
+
+      memcpy(to, result, num_bytes);
+    }
+
+    from += column._from_stride;
+    to += column._to_stride;
+    blendt += blend_stride;
+  }
+}
+
+/**
+ * A faster implementation of the skinning part of update_animated_vertices(),
+ * for the common case of vertex data without morphs whose animated columns
+ * are stored as 32-bit floats.  Rather than transforming the animated columns
+ * of new_data in place, this computes them from the columns of this object,
+ * so that the rest of new_data only has to be copied when it has changed.
+ * The rows may be divided among several threads; see
+ * cpu-skinning-num-threads.
+ *
+ * Returns true on success, or false if the format of the vertex data isn't
+ * supported by this path, in which case nothing has been modified.
+ */
+bool GeomVertexData::
+do_fast_skinning(const CData *cdata, GeomVertexData *new_data,
+                 const TransformBlendTable *tb_table, Thread *current_thread) {
+  const GeomVertexFormat *orig_format = cdata->_format;
+  const GeomVertexFormat *new_format = new_data->get_format();
+
+  int num_rows = get_num_rows();
+  if (new_data->get_num_rows() != num_rows) {
+    return false;
+  }
+
+  // The blend index must be a single unsigned integer.
+  int blend_array_index;
+  const GeomVertexColumn *blend_column;
+  if (!orig_format->get_array_info(InternalName::get_transform_blend(),
+                                   blend_array_index, blend_column) ||
+      blend_column->get_num_components() != 1) {
+    return false;
+  }
+  NumericType blend_type = blend_column->get_numeric_type();
+  if (blend_type != NT_uint8 && blend_type != NT_uint16 &&
+      blend_type != NT_uint32) {
+    return false;
+  }
+
+  // Find the columns to animate, and make sure they are all in a format we
+  // can handle.
+  struct ColumnInfo {
+    int _from_array;
+    int _to_array;
+    const GeomVertexColumn *_from_column;
+    const GeomVertexColumn *_to_column;
+    SkinningColumn::Kind _kind;
+  };
+  pvector<ColumnInfo> infos;
+  const GeomVertexColumn *normal_column = nullptr;
+
+  size_t num_points = new_format->get_num_points();
+  size_t num_vectors = new_format->get_num_vectors();
+  for (size_t ci = 0; ci < num_points + num_vectors; ++ci) {
+    const InternalName *name = (ci < num_points)
+      ? new_format->get_point(ci)
+      : new_format->get_vector(ci - num_points);
+
+    ColumnInfo info;
+    if (!orig_format->get_array_info(name, info._from_array, info._from_column) ||
+        !new_format->get_array_info(name, info._to_array, info._to_column)) {
+      return false;
+    }
+    int num_values = info._to_column->get_num_values();
+    if (info._from_column->get_numeric_type() != NT_float32 ||
+        info._to_column->get_numeric_type() != NT_float32 ||
+        info._from_column->get_num_values() != num_values ||
+        (num_values != 3 && num_values != 4)) {
+      return false;
+    }
+
+    if (ci < num_points) {
+      info._kind = SkinningColumn::K_point;
+    } else if (info._to_column->get_contents() == C_normal) {
+      info._kind = SkinningColumn::K_normal;
+      normal_column = info._to_column;
+    } else {
+      info._kind = SkinningColumn::K_vector;
+    }
+    infos.push_back(info);
+  }
+
+  // Compute the matrix of each blend up front.
+  size_t num_blends = tb_table->get_num_blends();
+  pvector<LMatrix4f> palette;
+  pvector<LMatrix4f> normal_palette;
+  pvector<unsigned char> normalize;
+  {
+    PStatTimer timer(_blends_pcollector, current_thread);
+    palette.reserve(num_blends);
+    if (normal_column != nullptr) {
+      normal_palette.reserve(num_blends);
+      normalize.reserve(num_blends);
+    }
+    for (size_t bi = 0; bi < num_blends; ++bi) {
+      const TransformBlend &blend = tb_table->get_blend(bi);
+      blend.update_blend(current_thread);
+
+      LMatrix4 mat;
+      blend.get_blend(mat, current_thread);
+      palette.push_back(LCAST(float, mat));
+
+      if (normal_column != nullptr) {
+        LMatrix4 xform;
+        normalize.push_back(get_vector_xform(normal_column, mat, xform));
+        normal_palette.push_back(LCAST(float, xform));
+      }
+    }
+  }
+
+  PStatTimer timer(_skinning_pcollector, current_thread);
+
+  // Get the pointers to the data.  We hold on to the handles until we're
+  // done, so that the arrays stay locked.
+  CPT(GeomVertexArrayDataHandle) blend_handle =
+    new GeomVertexArrayDataHandle(cdata->_arrays[blend_array_index].get_read_pointer(current_thread), current_thread);
+  const unsigned char *blend_data = blend_handle->get_read_pointer(true) + blend_column->get_start();
+  size_t blend_stride = orig_format->get_array(blend_array_index)->get_stride();
+
+  pvector<CPT(GeomVertexArrayDataHandle)> from_handles(orig_format->get_num_arrays());
+  pvector<PT(GeomVertexArrayDataHandle)> to_handles(new_format->get_num_arrays());
+  pvector<SkinningColumn> columns;
+  columns.reserve(infos.size());
+
+  for (const ColumnInfo &info : infos) {
+    CPT(GeomVertexArrayDataHandle) &from_handle = from_handles[info._from_array];
+    if (from_handle == nullptr) {
+      from_handle = new GeomVertexArrayDataHandle(cdata->_arrays[info._from_array].get_read_pointer(current_thread), current_thread);
+    }
+    PT(GeomVertexArrayDataHandle) &to_handle = to_handles[info._to_array];
+    if (to_handle == nullptr) {
+      to_handle = new_data->modify_array_handle(info._to_array);
+    }
+
+    SkinningColumn column;
+    column._from = from_handle->get_read_pointer(true) + info._from_column->get_start();
+    column._from_stride = orig_format->get_array(info._from_array)->get_stride();
+    column._to = to_handle->get_write_pointer() + info._to_column->get_start();
+    column._to_stride = new_format->get_array(info._to_array)->get_stride();
+    column._num_values = info._to_column->get_num_values();
+    column._kind = info._kind;
+    columns.push_back(column);
+  }
+
+  // Divide the animated rows into pieces that can be handed to the threads.
+  pvector<std::pair<int, int> > ranges;
+  const SparseArray &rows = tb_table->get_rows();
+  int num_subranges = rows.get_num_subranges();
+  for (int i = 0; i < num_subranges; ++i) {
+    int begin = rows.get_subrange_begin(i);
+    int end = std::min(rows.get_subrange_end(i), num_rows);
+    for (; begin < end; begin += skinning_rows_per_task) {
+      ranges.push_back(std::make_pair(begin, std::min(begin + skinning_rows_per_task, end)));
+    }
+  }
+
+  auto skin_range = [&] (size_t ri) {
+    int begin = ranges[ri].first;
+    int end = ranges[ri].second;
+    for (const SkinningColumn &column : columns) {
+      const LMatrix4f *column_palette = palette.data();
+      const unsigned char *column_normalize = nullptr;
+      if (column._kind == SkinningColumn::K_normal) {
+        column_palette = normal_palette.data();
+        column_normalize = normalize.data();
+      }
+
+      switch (blend_type) {
+      case NT_uint8:
+        skin_column<uint8_t>(column, column_palette, column_normalize, num_blends,
+                             blend_data, blend_stride, begin, end);
+        break;
+      case NT_uint16:
+        skin_column<uint16_t>(column, column_palette, column_normalize, num_blends,
+                              blend_data, blend_stride, begin, end);
+        break;
+      default:
+        skin_column<uint32_t>(column, column_palette, column_normalize, num_blends,
+                              blend_data, blend_stride, begin, end);
+        break;
+      }
+    }
+  };
+
+  // The threads only touch the arrays through the pointers we obtained above,
+  // so they don't need to be concerned with the pipeline.
+  int num_threads = cpu_skinning_num_threads;
+  if (num_threads > 0 && ranges.size() > 1) {
+    static PT(AsyncTaskChain) chain =
+      AsyncTaskManager::get_global_ptr()->make_task_chain("skinning");
+    if (chain->get_num_threads() < num_threads) {
+      chain->set_num_threads(num_threads);
+    }
+    chain->parallel_for(ranges.size(), skin_range);
+  } else {
+    for (size_t ri = 0; ri < ranges.size(); ++ri) {
+      skin_range(ri);
+    }
+  }
+
+  return true;
+}
+
+/**
+ * Computes the matrix with which the values of the indicated column should
+ * be transformed, when the vertices are transformed by the indicated matrix.
+ * For a normal, this takes the scale out of the matrix, or uses the inverse
+ * transpose in the case of a non-uniform scale, to preserve perpendicularity
+ * to the surface.
+ *
+ * Returns true if the transformed values need to be normalized afterwards.
+ */
+bool GeomVertexData::
+get_vector_xform(const GeomVertexColumn *column, const LMatrix4 &mat,
+                 LMatrix4 &xform) {
+  if (column == nullptr || column->get_contents() != C_normal) {
+    xform = mat;
+    return false;
+  }
+
+  // This is to preserve perpendicularity to the surface.
+  LVecBase3 scale_sq(mat.get_row3(0).length_squared(),
+                     mat.get_row3(1).length_squared(),
+                     mat.get_row3(2).length_squared());
+  if (IS_THRESHOLD_EQUAL(scale_sq[0], scale_sq[1], 2.0e-3f) &&
+      IS_THRESHOLD_EQUAL(scale_sq[0], scale_sq[2], 2.0e-3f)) {
+    // There is a uniform scale.
+    LVecBase3 scale, shear, hpr;
+    if (IS_THRESHOLD_EQUAL(scale_sq[0], 1, 2.0e-3f)) {
+      // No scale to worry about.
+      xform = mat;
+      return false;
+    } else if (decompose_matrix(mat.get_upper_3(), scale, shear, hpr)) {
+      // Make a new matrix with scale/translate taken out of the equation.
+      compose_matrix(xform, LVecBase3(1, 1, 1), shear, hpr, LVecBase3::zero());
+      return false;
+    } else {
+      xform = mat;
+      return true;
+    }
+  } else {
+    // There is a non-uniform scale, so we need to do all this to preserve
+    // orthogonality to the surface.
+    xform.invert_from(mat);
+    xform.transpose_in_place();
+    return true;
+  }
+}
 
 /**
  * Transforms a range of vertices for one particular column, as a point.
@@ -1809,35 +2220,7 @@ do_transform_vector_column(const GeomVertexFormat *format, GeomVertexRewriter &d
   int num_values = data_column->get_num_values();
 
   LMatrix4 xform;
-  bool normalize = false;
-  if (data_column->get_contents() == C_normal) {
-    // This is to preserve perpendicularity to the surface.
-    LVecBase3 scale_sq(mat.get_row3(0).length_squared(),
-                       mat.get_row3(1).length_squared(),
-                       mat.get_row3(2).length_squared());
-    if (IS_THRESHOLD_EQUAL(scale_sq[0], scale_sq[1], 2.0e-3f) &&
-        IS_THRESHOLD_EQUAL(scale_sq[0], scale_sq[2], 2.0e-3f)) {
-      // There is a uniform scale.
-      LVecBase3 scale, shear, hpr;
-      if (IS_THRESHOLD_EQUAL(scale_sq[0], 1, 2.0e-3f)) {
-        // No scale to worry about.
-        xform = mat;
-      } else if (decompose_matrix(mat.get_upper_3(), scale, shear, hpr)) {
-        // Make a new matrix with scale/translate taken out of the equation.
-        compose_matrix(xform, LVecBase3(1, 1, 1), shear, hpr, LVecBase3::zero());
-      } else {
-        normalize = true;
-      }
-    } else {
-      // There is a non-uniform scale, so we need to do all this to preserve
-      // orthogonality to the surface.
-      xform.invert_from(mat);
-      xform.transpose_in_place();
-      normalize = true;
-    }
-  } else {
-    xform = mat;
-  }
+  bool normalize = get_vector_xform(data_column, mat, xform);
 
   if ((num_values == 3 || num_values == 4) &&
       data_column->get_numeric_type() == NT_float32) {
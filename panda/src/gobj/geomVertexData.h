@@ -138,6 +138,7 @@ PUBLISHED:
   MAKE_PROPERTY(modified, get_modified);
 
   bool request_resident() const;
+  bool request_prefetch() const;
 
   void copy_from(const GeomVertexData *source, bool keep_data_objects,
                  Thread *current_thread = Thread::get_current_thread());
@@ -312,6 +313,7 @@ private:
     CPT(SliderTable) _slider_table;
     PT(GeomVertexData) _animated_vertices;
     UpdateSeq _animated_vertices_modified;
+    UpdateSeq _animated_source_modified;
     UpdateSeq _modified;
 
   public:
@@ -338,6 +340,11 @@ private:
 
 private:
   void update_animated_vertices(CData *cdata, Thread *current_thread);
+  bool do_fast_skinning(const CData *cdata, GeomVertexData *new_data,
+                        const TransformBlendTable *tb_table,
+                        Thread *current_thread);
+  static bool get_vector_xform(const GeomVertexColumn *column,
+                               const LMatrix4 &mat, LMatrix4 &xform);
   void do_transform_point_column(const GeomVertexFormat *format, GeomVertexRewriter &data,
                                  const LMatrix4 &mat, int begin_row, int end_row);
   void do_transform_vector_column(const GeomVertexFormat *format, GeomVertexRewriter &data,
@@ -13,12 +13,60 @@
 
 #include "geomVertexReader.h"
 
+#include <type_traits>
+
 #ifdef _DEBUG
 // This is defined just for the benefit of having something non-NULL to
 // return from a nassertr() call.
 const unsigned char GeomVertexReader::empty_buffer[100] = { 0 };
 #endif
 
+/**
+ * Reads num_rows consecutive rows of the column, starting at the read row, as
+ * 3-component values, and advances the read row past them.  This is much
+ * faster than calling get_data3f() for each row.
+ *
+ * Returns a pointer to num_rows contiguous values.  If the column is already
+ * stored as tightly packed values of the requested type, this points
+ * directly into the vertex data, and the buffer is not touched.  Otherwise,
+ * the values are decoded into the buffer, which is resized as needed.  In
+ * either case, the pointer is only valid as long as the buffer is, and until
+ * the vertex data is modified.
+ *
+ * It is an error to read past the end of the data.
+ */
+const LVecBase3f *GeomVertexReader::
+get_data3f_range(int num_rows, pvector<LVecBase3f> &buffer) {
+  return get_range(num_rows, buffer, &GeomVertexColumn::Packer::get_data3f);
+}
+
+/**
+ * Reads num_rows consecutive rows of the column as 4-component values.  See
+ * get_data3f_range().
+ */
+const LVecBase4f *GeomVertexReader::
+get_data4f_range(int num_rows, epvector<LVecBase4f> &buffer) {
+  return get_range(num_rows, buffer, &GeomVertexColumn::Packer::get_data4f);
+}
+
+/**
+ * Reads num_rows consecutive rows of the column as 3-component values.  See
+ * get_data3f_range().
+ */
+const LVecBase3d *GeomVertexReader::
+get_data3d_range(int num_rows, pvector<LVecBase3d> &buffer) {
+  return get_range(num_rows, buffer, &GeomVertexColumn::Packer::get_data3d);
+}
+
+/**
+ * Reads num_rows consecutive rows of the column as 4-component values.  See
+ * get_data3f_range().
+ */
+const LVecBase4d *GeomVertexReader::
+get_data4d_range(int num_rows, epvector<LVecBase4d> &buffer) {
+  return get_range(num_rows, buffer, &GeomVertexColumn::Packer::get_data4d);
+}
+
 /**
  * Sets up the reader to use the indicated column description on the given
  * array.
@@ -131,3 +179,72 @@ set_array_column(const GeomVertexColumn *column) {
   _packer = column->_packer;
   return set_pointer(_start_row);
 }
+
+/**
+ * The implementation of get_data3f_range() and friends.  The values are
+ * copied directly if the column stores floating-point values that need no
+ * further conversion, or else decoded one at a time with the indicated
+ * Packer method.
+ */
+template<class Vector, class Buffer>
+const Vector *GeomVertexReader::
+get_range(int num_rows, Buffer &buffer,
+          const Vector &(GeomVertexColumn::Packer::*unpack)(const unsigned char *)) {
+  typedef typename Vector::numeric_type Float;
+  static const int num_components = Vector::num_components;
+
+  nassertr(has_column() && num_rows >= 0, nullptr);
+  if (num_rows == 0) {
+    buffer.clear();
+    return buffer.data();
+  }
+#ifdef _DEBUG
+  nassertr(_pointer_begin == _handle->get_read_pointer(true), nullptr);
+#endif
+  nassertr(_pointer + (size_t)_stride * (num_rows - 1) < _pointer_end, nullptr);
+
+  const unsigned char *pointer = _pointer;
+  _pointer += (size_t)_stride * num_rows;
+
+  // Homogeneous points are divided by w when read with three components, so
+  // those can't be copied directly.
+  const GeomVertexColumn *column = _packer->_column;
+  int column_components = column->get_num_components();
+  bool direct = column_components >= num_components &&
+    !(column->get_contents() == C_point && column_components == 4 && num_components < 4);
+
+  if (direct && column->get_numeric_type() == (sizeof(Float) == sizeof(float) ? NT_float32 : NT_float64)) {
+    if (_stride == (int)sizeof(Vector) &&
+        ((uintptr_t)pointer % alignof(Vector)) == 0) {
+      // The data is already in the right format.
+      return (const Vector *)pointer;
+    }
+
+    buffer.resize(num_rows);
+    for (int i = 0; i < num_rows; ++i) {
+      const Float *data = (const Float *)(pointer + (size_t)_stride * i);
+      for (int c = 0; c < num_components; ++c) {
+        buffer[i][c] = data[c];
+      }
+    }
+    return buffer.data();
+  }
+
+  if (direct && column->get_numeric_type() == (sizeof(Float) == sizeof(float) ? NT_float64 : NT_float32)) {
+    typedef typename std::conditional<sizeof(Float) == sizeof(float), double, float>::type Other;
+    buffer.resize(num_rows);
+    for (int i = 0; i < num_rows; ++i) {
+      const Other *data = (const Other *)(pointer + (size_t)_stride * i);
+      for (int c = 0; c < num_components; ++c) {
+        buffer[i][c] = (Float)data[c];
+      }
+    }
+    return buffer.data();
+  }
+
+  buffer.resize(num_rows);
+  for (int i = 0; i < num_rows; ++i) {
+    buffer[i] = (_packer->*unpack)(pointer + (size_t)_stride * i);
+  }
+  return buffer.data();
+}
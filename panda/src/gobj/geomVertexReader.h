@@ -20,6 +20,8 @@
 #include "internalName.h"
 #include "luse.h"
 #include "pointerTo.h"
+#include "pvector.h"
+#include "epvector.h"
 
 /**
  * This object provides a high-level interface for quickly reading a sequence
@@ -121,6 +123,14 @@ PUBLISHED:
 
   void output(std::ostream &out) const;
 
+public:
+  const LVecBase3f *get_data3f_range(int num_rows, pvector<LVecBase3f> &buffer);
+  const LVecBase4f *get_data4f_range(int num_rows, epvector<LVecBase4f> &buffer);
+  const LVecBase3d *get_data3d_range(int num_rows, pvector<LVecBase3d> &buffer);
+  const LVecBase4d *get_data4d_range(int num_rows, epvector<LVecBase4d> &buffer);
+  INLINE const LVecBase3 *get_data3_range(int num_rows, pvector<LVecBase3> &buffer);
+  INLINE const LVecBase4 *get_data4_range(int num_rows, epvector<LVecBase4> &buffer);
+
 protected:
   INLINE GeomVertexColumn::Packer *get_packer() const;
 
@@ -131,6 +141,12 @@ private:
   INLINE void quick_set_pointer(int row);
   INLINE const unsigned char *inc_pointer();
 
+#ifndef CPPPARSER
+  template<class Vector, class Buffer>
+  const Vector *get_range(int num_rows, Buffer &buffer,
+                          const Vector &(GeomVertexColumn::Packer::*unpack)(const unsigned char *));
+#endif
+
   bool set_vertex_column(int array, const GeomVertexColumn *column,
                          const GeomVertexDataPipelineReader *data_reader);
   bool set_array_column(const GeomVertexColumn *column);
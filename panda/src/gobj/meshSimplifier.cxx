@@ -0,0 +1,682 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file meshSimplifier.cxx
+ * @author rdb
+ * @date 2026-10-17
+ */
+
+#include "meshSimplifier.h"
+#include "geomVertexReader.h"
+#include "config_gobj.h"
+#include "vector_uchar.h"
+
+#include <algorithm>
+#include <limits>
+#include <math.h>
+
+// The planes through border and seam edges are weighted by this factor times
+// the squared length of the edge, which keeps the border from shrinking.
+static const double simplify_edge_weight = 10.0;
+
+// A collapse is rejected if it would rotate one of the remaining triangles by
+// more than (almost) 90 degrees.
+static const double simplify_flip_threshold = 1.0e-2;
+
+/**
+ * Describes how a vertex is allowed to move.  A seam vertex is one that is
+ * duplicated because the attributes differ on either side of it, and a locked
+ * vertex is one at a corner of a seam or border or in a nonmanifold part of
+ * the mesh, which is not allowed to move at all.
+ */
+enum SimplifyVertexKind {
+  SVK_manifold,
+  SVK_border,
+  SVK_seam,
+  SVK_locked,
+};
+
+/**
+ * A symmetric matrix representing the sum of the squared distances to a set
+ * of weighted planes.
+ */
+struct SimplifyQuadric {
+  double _a00, _a11, _a22, _a10, _a20, _a21;
+  double _b0, _b1, _b2, _c;
+  double _w;
+
+  void add_plane(const LVecBase3d &n, double d, double w) {
+    _a00 += w * n[0] * n[0];
+    _a11 += w * n[1] * n[1];
+    _a22 += w * n[2] * n[2];
+    _a10 += w * n[1] * n[0];
+    _a20 += w * n[2] * n[0];
+    _a21 += w * n[2] * n[1];
+    _b0 += w * n[0] * d;
+    _b1 += w * n[1] * d;
+    _b2 += w * n[2] * d;
+    _c += w * d * d;
+    _w += w;
+  }
+
+  void add(const SimplifyQuadric &other) {
+    _a00 += other._a00;
+    _a11 += other._a11;
+    _a22 += other._a22;
+    _a10 += other._a10;
+    _a20 += other._a20;
+    _a21 += other._a21;
+    _b0 += other._b0;
+    _b1 += other._b1;
+    _b2 += other._b2;
+    _c += other._c;
+    _w += other._w;
+  }
+
+  // Returns the weighted mean of the squared distances of the point to the
+  // planes.
+  double eval(const LVecBase3d &p) const {
+    double rx = _a00 * p[0] + _a10 * p[1] + _a20 * p[2];
+    double ry = _a10 * p[0] + _a11 * p[1] + _a21 * p[2];
+    double rz = _a20 * p[0] + _a21 * p[1] + _a22 * p[2];
+    double r = rx * p[0] + ry * p[1] + rz * p[2];
+    r += 2.0 * (_b0 * p[0] + _b1 * p[1] + _b2 * p[2]) + _c;
+    return (_w > 0.0) ? fabs(r) / _w : 0.0;
+  }
+};
+
+/**
+ * A candidate edge collapse, moving vertex _v onto vertex _t.  If _v is on a
+ * seam, its other wedge _s is moved onto _t2.  The collapses are ordered by
+ * _cost, which includes the attribute differences, but limited by the
+ * geometric _error.
+ */
+struct SimplifyCollapse {
+  int _v, _t;
+  int _s, _t2;
+  double _error;
+  double _cost;
+
+  bool operator < (const SimplifyCollapse &other) const {
+    return _cost < other._cost;
+  }
+};
+
+/**
+ * The state of the simplification, which is rebuilt at the beginning of each
+ * pass from the remaining triangles.
+ */
+class SimplifyMesh {
+public:
+  void build_adjacency();
+  bool has_edge(int a, int b) const;
+  bool has_pos_edge(int a, int b) const;
+  int find_seam_wedge(int s, int t) const;
+  bool would_flip(int v, int t) const;
+  double get_attribute_cost(int a, int b) const;
+  bool make_collapse(int v, int t, SimplifyCollapse &collapse) const;
+
+  int *_indices;
+  size_t _num_tris;
+  int _num_vertices;
+  const PN_stdfloat *_attributes;
+  int _num_attributes;
+  const PN_stdfloat *_attribute_weights;
+
+  pvector<LVecBase3d> _pos;
+  pvector<int> _rep;
+  pvector<int> _wedge;
+  vector_uchar _kind;
+  pvector<SimplifyQuadric> _quadrics;
+
+  pvector<int> _offsets;
+  pvector<int> _adjacency;
+};
+
+/**
+ * Rebuilds the table of triangles using each vertex.
+ */
+void SimplifyMesh::
+build_adjacency() {
+  _offsets.assign(_num_vertices + 1, 0);
+  for (size_t i = 0; i < _num_tris * 3; ++i) {
+    ++_offsets[_indices[i] + 1];
+  }
+  for (int v = 0; v < _num_vertices; ++v) {
+    _offsets[v + 1] += _offsets[v];
+  }
+
+  _adjacency.resize(_num_tris * 3);
+  pvector<int> fill(_offsets);
+  for (size_t t = 0; t < _num_tris; ++t) {
+    for (int k = 0; k < 3; ++k) {
+      _adjacency[fill[_indices[t * 3 + k]]++] = (int)t;
+    }
+  }
+}
+
+/**
+ * Returns true if one of the triangles has the directed edge from vertex a to
+ * vertex b.
+ */
+bool SimplifyMesh::
+has_edge(int a, int b) const {
+  for (int i = _offsets[a]; i < _offsets[a + 1]; ++i) {
+    const int *tri = _indices + _adjacency[i] * 3;
+    int k = (tri[0] == a) ? 0 : (tri[1] == a) ? 1 : 2;
+    if (tri[(k + 1) % 3] == b) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Returns true if one of the triangles has a directed edge from the position
+ * of vertex a to the position of vertex b, regardless of which wedge is
+ * referenced at either end.
+ */
+bool SimplifyMesh::
+has_pos_edge(int a, int b) const {
+  int rb = _rep[b];
+  int w = a;
+  do {
+    for (int i = _offsets[w]; i < _offsets[w + 1]; ++i) {
+      const int *tri = _indices + _adjacency[i] * 3;
+      int k = (tri[0] == w) ? 0 : (tri[1] == w) ? 1 : 2;
+      if (_rep[tri[(k + 1) % 3]] == rb) {
+        return true;
+      }
+    }
+    w = _wedge[w];
+  } while (w != a);
+  return false;
+}
+
+/**
+ * Given the other wedge s of a seam vertex that is being collapsed onto
+ * vertex t, returns the wedge of t that s should be collapsed onto, or -1 if
+ * the seam does not continue to t on the other side.
+ */
+int SimplifyMesh::
+find_seam_wedge(int s, int t) const {
+  for (int w = _wedge[t]; w != t; w = _wedge[w]) {
+    bool forward = has_edge(s, w);
+    bool backward = has_edge(w, s);
+    if (forward != backward) {
+      return w;
+    }
+  }
+  return -1;
+}
+
+/**
+ * Returns true if moving vertex v to the position of vertex t would flip one
+ * of the triangles around v that remain afterwards.
+ */
+bool SimplifyMesh::
+would_flip(int v, int t) const {
+  int rt = _rep[t];
+  const LVecBase3d &old_pos = _pos[v];
+  const LVecBase3d &new_pos = _pos[t];
+
+  for (int i = _offsets[v]; i < _offsets[v + 1]; ++i) {
+    const int *tri = _indices + _adjacency[i] * 3;
+    int k = (tri[0] == v) ? 0 : (tri[1] == v) ? 1 : 2;
+    int o1 = tri[(k + 1) % 3];
+    int o2 = tri[(k + 2) % 3];
+    if (_rep[o1] == rt || _rep[o2] == rt) {
+      // This triangle collapses away.
+      continue;
+    }
+
+    const LVecBase3d &p1 = _pos[o1];
+    const LVecBase3d &p2 = _pos[o2];
+    LVecBase3d n0 = (p1 - old_pos).cross(p2 - old_pos);
+    LVecBase3d n1 = (p1 - new_pos).cross(p2 - new_pos);
+    if (n0.dot(n1) <= simplify_flip_threshold * n0.length() * n1.length()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Returns the weighted squared difference between the attributes of the two
+ * vertices.
+ */
+double SimplifyMesh::
+get_attribute_cost(int a, int b) const {
+  double cost = 0.0;
+  const PN_stdfloat *aa = _attributes + (size_t)a * _num_attributes;
+  const PN_stdfloat *ba = _attributes + (size_t)b * _num_attributes;
+  for (int i = 0; i < _num_attributes; ++i) {
+    double d = (double)(aa[i] - ba[i]) * (double)_attribute_weights[i];
+    cost += d * d;
+  }
+  return cost;
+}
+
+/**
+ * Fills in the collapse of vertex v onto vertex t and returns true if the
+ * kinds of the vertices allow it, or returns false otherwise.
+ */
+bool SimplifyMesh::
+make_collapse(int v, int t, SimplifyCollapse &collapse) const {
+  collapse._v = v;
+  collapse._t = t;
+  collapse._s = -1;
+  collapse._t2 = -1;
+
+  switch ((SimplifyVertexKind)_kind[v]) {
+  case SVK_manifold:
+    break;
+
+  case SVK_border:
+    // Only along the border.
+    if (_kind[t] == SVK_manifold ||
+        (has_pos_edge(v, t) && has_pos_edge(t, v))) {
+      return false;
+    }
+    break;
+
+  case SVK_seam:
+    // Only along the seam, and both wedges at once.
+    if ((_kind[t] != SVK_seam && _kind[t] != SVK_locked) ||
+        (has_edge(v, t) && has_edge(t, v))) {
+      return false;
+    }
+    collapse._s = _wedge[v];
+    collapse._t2 = find_seam_wedge(collapse._s, t);
+    if (collapse._t2 < 0) {
+      return false;
+    }
+    break;
+
+  default:
+    return false;
+  }
+
+  collapse._error = _quadrics[_rep[v]].eval(_pos[t]);
+  collapse._cost = collapse._error;
+  if (_num_attributes > 0) {
+    double attribute_cost = get_attribute_cost(v, t);
+    if (collapse._s >= 0) {
+      attribute_cost = std::max(attribute_cost, get_attribute_cost(collapse._s, collapse._t2));
+    }
+    collapse._cost += attribute_cost;
+  }
+  return true;
+}
+
+/**
+ * Simplifies the indicated triangle list in place until at most
+ * target_num_indices indices remain, or until the next collapse would cause
+ * an error greater than max_error, whichever comes first.  If max_error is
+ * negative, only the target count limits the simplification.
+ *
+ * The attributes array, if not null, contains num_attributes values per
+ * vertex.  Their differences, scaled by the corresponding value in
+ * attribute_weights, are added to the error of each collapse, relative to
+ * the size of the mesh, to determine the order in which the edges are
+ * collapsed.  They don't count towards max_error, which is purely a measure
+ * of the geometric deviation.
+ *
+ * Returns the new number of indices.  If result_error is not null, it is
+ * filled in with the error that was reached, in the same units as positions.
+ */
+size_t MeshSimplifier::
+simplify(int *indices, size_t num_indices, const LVecBase3 *positions,
+         int num_vertices, const PN_stdfloat *attributes, int num_attributes,
+         const PN_stdfloat *attribute_weights, size_t target_num_indices,
+         PN_stdfloat max_error, PN_stdfloat *result_error) {
+  if (result_error != nullptr) {
+    *result_error = 0;
+  }
+  num_indices -= num_indices % 3;
+  if (num_indices == 0) {
+    return 0;
+  }
+
+  SimplifyMesh mesh;
+  mesh._indices = indices;
+  mesh._num_tris = num_indices / 3;
+  mesh._num_vertices = num_vertices;
+  mesh._attributes = attributes;
+  mesh._num_attributes = (attributes != nullptr) ? num_attributes : 0;
+  mesh._attribute_weights = attribute_weights;
+
+  // Normalize the positions to the unit cube, so that the error and the
+  // attribute weights don't depend on the size of the mesh.
+  vector_uchar used(num_vertices, 0);
+  for (size_t i = 0; i < num_indices; ++i) {
+    nassertr(indices[i] >= 0 && indices[i] < num_vertices, num_indices);
+    used[indices[i]] = 1;
+  }
+
+  LVecBase3d min_point(std::numeric_limits<double>::max());
+  LVecBase3d max_point(-std::numeric_limits<double>::max());
+  for (int v = 0; v < num_vertices; ++v) {
+    if (used[v]) {
+      LVecBase3d p = LCAST(double, positions[v]);
+      min_point = min_point.fmin(p);
+      max_point = max_point.fmax(p);
+    }
+  }
+  LVecBase3d size = max_point - min_point;
+  double extent = std::max(size[0], std::max(size[1], size[2]));
+  double scale = (extent > 0.0) ? 1.0 / extent : 1.0;
+
+  mesh._pos.resize(num_vertices);
+  for (int v = 0; v < num_vertices; ++v) {
+    if (used[v]) {
+      mesh._pos[v] = (LCAST(double, positions[v]) - min_point) * scale;
+    }
+  }
+
+  // Link together the vertices that share a position into a ring of wedges,
+  // represented by the lowest-numbered vertex.
+  mesh._rep.resize(num_vertices);
+  mesh._wedge.resize(num_vertices);
+  {
+    pvector<int> order;
+    for (int v = 0; v < num_vertices; ++v) {
+      mesh._rep[v] = v;
+      mesh._wedge[v] = v;
+      if (used[v]) {
+        order.push_back(v);
+      }
+    }
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+      int cmp = positions[a].compare_to(positions[b]);
+      return (cmp != 0) ? (cmp < 0) : (a < b);
+    });
+
+    size_t begin = 0;
+    while (begin < order.size()) {
+      size_t end = begin + 1;
+      while (end < order.size() &&
+             positions[order[end]] == positions[order[begin]]) {
+        ++end;
+      }
+      for (size_t i = begin; i < end; ++i) {
+        mesh._rep[order[i]] = order[begin];
+        mesh._wedge[order[i]] = order[(i + 1 < end) ? i + 1 : begin];
+      }
+      begin = end;
+    }
+  }
+
+  // Remove the triangles that are already degenerate.
+  {
+    size_t num_tris = 0;
+    for (size_t t = 0; t < mesh._num_tris; ++t) {
+      const int *tri = indices + t * 3;
+      int r0 = mesh._rep[tri[0]], r1 = mesh._rep[tri[1]], r2 = mesh._rep[tri[2]];
+      if (r0 != r1 && r1 != r2 && r2 != r0) {
+        std::copy(tri, tri + 3, indices + num_tris * 3);
+        ++num_tris;
+      }
+    }
+    mesh._num_tris = num_tris;
+  }
+  mesh.build_adjacency();
+
+  // Classify the vertices.
+  mesh._kind.assign(num_vertices, SVK_locked);
+  for (int v = 0; v < num_vertices; ++v) {
+    if (!used[v] || mesh._rep[v] != v) {
+      continue;
+    }
+
+    int num_wedges = 0;
+    int pos_open_out = 0, pos_open_in = 0;
+    bool seam_edges = true;
+    int w = v;
+    do {
+      ++num_wedges;
+      int open_out = 0, open_in = 0;
+      for (int i = mesh._offsets[w]; i < mesh._offsets[w + 1]; ++i) {
+        const int *tri = indices + mesh._adjacency[i] * 3;
+        int k = (tri[0] == w) ? 0 : (tri[1] == w) ? 1 : 2;
+        int next = tri[(k + 1) % 3];
+        int prev = tri[(k + 2) % 3];
+        open_out += !mesh.has_edge(next, w);
+        open_in += !mesh.has_edge(w, prev);
+        pos_open_out += !mesh.has_pos_edge(next, w);
+        pos_open_in += !mesh.has_pos_edge(w, prev);
+      }
+      if (open_out != 1 || open_in != 1) {
+        seam_edges = false;
+      }
+      w = mesh._wedge[w];
+    } while (w != v);
+
+    SimplifyVertexKind kind = SVK_locked;
+    if (num_wedges == 1) {
+      if (pos_open_out == 0 && pos_open_in == 0) {
+        kind = SVK_manifold;
+      } else if (pos_open_out == 1 && pos_open_in == 1) {
+        kind = SVK_border;
+      }
+    } else if (num_wedges == 2 && pos_open_out == 0 && pos_open_in == 0 &&
+               seam_edges) {
+      kind = SVK_seam;
+    }
+
+    w = v;
+    do {
+      mesh._kind[w] = kind;
+      w = mesh._wedge[w];
+    } while (w != v);
+  }
+
+  // Accumulate the planes of the triangles into the quadrics of their
+  // vertices, as well as planes perpendicular to the border and seam edges.
+  mesh._quadrics.assign(num_vertices, SimplifyQuadric());
+  for (size_t t = 0; t < mesh._num_tris; ++t) {
+    const int *tri = indices + t * 3;
+    const LVecBase3d &p0 = mesh._pos[tri[0]];
+    LVecBase3d normal = (mesh._pos[tri[1]] - p0).cross(mesh._pos[tri[2]] - p0);
+    double area = normal.length();
+    if (area <= 0.0) {
+      continue;
+    }
+    normal /= area;
+    double d = -normal.dot(p0);
+    for (int k = 0; k < 3; ++k) {
+      mesh._quadrics[mesh._rep[tri[k]]].add_plane(normal, d, area * 0.5);
+    }
+
+    for (int k = 0; k < 3; ++k) {
+      int a = tri[k];
+      int b = tri[(k + 1) % 3];
+      if (mesh.has_edge(b, a)) {
+        continue;
+      }
+      LVecBase3d edge = mesh._pos[b] - mesh._pos[a];
+      LVecBase3d edge_normal = edge.cross(normal);
+      double length = edge_normal.length();
+      if (length > 0.0) {
+        edge_normal /= length;
+        double edge_d = -edge_normal.dot(mesh._pos[a]);
+        double weight = edge.length_squared() * simplify_edge_weight;
+        mesh._quadrics[mesh._rep[a]].add_plane(edge_normal, edge_d, weight);
+        mesh._quadrics[mesh._rep[b]].add_plane(edge_normal, edge_d, weight);
+      }
+    }
+  }
+
+  size_t target_num_tris = target_num_indices / 3;
+  double error_limit = std::numeric_limits<double>::max();
+  if (max_error >= 0) {
+    error_limit = (double)max_error * scale;
+    error_limit *= error_limit;
+  }
+  double result_sq_error = 0.0;
+
+  // Each pass collapses the cheapest edges whose vertices have not been
+  // touched yet by another collapse in the same pass.
+  pvector<SimplifyCollapse> collapses;
+  pvector<int> collapse_remap(num_vertices);
+  vector_uchar collapse_locked(num_vertices);
+  while (mesh._num_tris > target_num_tris) {
+    collapses.clear();
+    for (size_t t = 0; t < mesh._num_tris; ++t) {
+      const int *tri = indices + t * 3;
+      for (int k = 0; k < 3; ++k) {
+        int a = tri[k];
+        int b = tri[(k + 1) % 3];
+        // Consider each edge only once.
+        if (a > b && mesh.has_edge(b, a)) {
+          continue;
+        }
+
+        SimplifyCollapse ab, ba;
+        bool has_ab = mesh.make_collapse(a, b, ab);
+        bool has_ba = mesh.make_collapse(b, a, ba);
+        if (has_ab && (!has_ba || ab._cost <= ba._cost)) {
+          collapses.push_back(ab);
+        } else if (has_ba) {
+          collapses.push_back(ba);
+        }
+      }
+    }
+    std::sort(collapses.begin(), collapses.end());
+
+    for (int v = 0; v < num_vertices; ++v) {
+      collapse_remap[v] = v;
+    }
+    std::fill(collapse_locked.begin(), collapse_locked.end(), 0);
+
+    size_t num_removed = 0;
+    size_t num_collapses = 0;
+    for (const SimplifyCollapse &collapse : collapses) {
+      if (mesh._num_tris - num_removed <= target_num_tris) {
+        break;
+      }
+      if (collapse._error > error_limit) {
+        continue;
+      }
+      int rv = mesh._rep[collapse._v];
+      int rt = mesh._rep[collapse._t];
+      if (collapse_locked[rv] || collapse_locked[rt]) {
+        continue;
+      }
+      if (mesh.would_flip(collapse._v, collapse._t) ||
+          (collapse._s >= 0 && mesh.would_flip(collapse._s, collapse._t2))) {
+        continue;
+      }
+
+      collapse_remap[collapse._v] = collapse._t;
+      if (collapse._s >= 0) {
+        collapse_remap[collapse._s] = collapse._t2;
+      }
+      mesh._quadrics[rt].add(mesh._quadrics[rv]);
+      collapse_locked[rv] = 1;
+      collapse_locked[rt] = 1;
+
+      // This is an estimate, since the mesh need not be manifold.
+      num_removed += (mesh._kind[collapse._v] == SVK_border) ? 1 : 2;
+      result_sq_error = std::max(result_sq_error, collapse._error);
+      ++num_collapses;
+    }
+
+    if (num_collapses == 0) {
+      break;
+    }
+
+    size_t num_tris = 0;
+    for (size_t t = 0; t < mesh._num_tris; ++t) {
+      int i0 = collapse_remap[indices[t * 3 + 0]];
+      int i1 = collapse_remap[indices[t * 3 + 1]];
+      int i2 = collapse_remap[indices[t * 3 + 2]];
+      int r0 = mesh._rep[i0], r1 = mesh._rep[i1], r2 = mesh._rep[i2];
+      if (r0 != r1 && r1 != r2 && r2 != r0) {
+        indices[num_tris * 3 + 0] = i0;
+        indices[num_tris * 3 + 1] = i1;
+        indices[num_tris * 3 + 2] = i2;
+        ++num_tris;
+      }
+    }
+    mesh._num_tris = num_tris;
+    mesh.build_adjacency();
+  }
+
+  if (result_error != nullptr) {
+    *result_error = (PN_stdfloat)(sqrt(result_sq_error) / scale);
+  }
+  return mesh._num_tris * 3;
+}
+
+/**
+ * Reads the vertex attributes that should be preserved by simplify() from
+ * the vertex data into the attributes array, with the weights given by the
+ * simplify-*-weight config variables.  Returns the number of attributes per
+ * vertex.
+ */
+int MeshSimplifier::
+read_attributes(const GeomVertexData *vdata, pvector<PN_stdfloat> &attributes,
+                pvector<PN_stdfloat> &weights, Thread *current_thread) {
+  attributes.clear();
+  weights.clear();
+
+  pvector<const GeomVertexColumn *> columns;
+  const GeomVertexFormat *format = vdata->get_format();
+  for (size_t ci = 0; ci < format->get_num_columns(); ++ci) {
+    const GeomVertexColumn *column = format->get_column(ci);
+    int num_components;
+    PN_stdfloat weight;
+    switch (column->get_contents()) {
+    case GeomEnums::C_normal:
+      num_components = 3;
+      weight = (PN_stdfloat)simplify_normal_weight;
+      break;
+
+    case GeomEnums::C_texcoord:
+      num_components = 2;
+      weight = (PN_stdfloat)simplify_texcoord_weight;
+      break;
+
+    case GeomEnums::C_color:
+      num_components = 4;
+      weight = (PN_stdfloat)simplify_color_weight;
+      break;
+
+    default:
+      continue;
+    }
+    if (weight > 0) {
+      columns.push_back(column);
+      weights.insert(weights.end(), num_components, weight);
+    }
+  }
+
+  int num_attributes = (int)weights.size();
+  int num_rows = vdata->get_num_rows();
+  if (num_attributes == 0 || num_rows == 0) {
+    return num_attributes;
+  }
+
+  attributes.resize((size_t)num_rows * num_attributes);
+  int offset = 0;
+  for (const GeomVertexColumn *column : columns) {
+    GeomVertexReader reader(vdata, column->get_name(), current_thread);
+    int num_components = (column->get_contents() == GeomEnums::C_normal) ? 3 :
+                         (column->get_contents() == GeomEnums::C_texcoord) ? 2 : 4;
+    for (int row = 0; row < num_rows; ++row) {
+      const LVecBase4 &value = reader.get_data4();
+      PN_stdfloat *dest = attributes.data() + (size_t)row * num_attributes + offset;
+      for (int i = 0; i < num_components; ++i) {
+        dest[i] = value[i];
+      }
+    }
+    offset += num_components;
+  }
+  return num_attributes;
+}
@@ -0,0 +1,53 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file meshSimplifier.h
+ * @author rdb
+ * @date 2026-10-17
+ */
+
+#ifndef MESHSIMPLIFIER_H
+#define MESHSIMPLIFIER_H
+
+#include "pandabase.h"
+#include "geomVertexData.h"
+#include "luse.h"
+#include "pvector.h"
+
+/**
+ * Reduces the number of triangles of a mesh by repeatedly collapsing the
+ * edge that introduces the least error, as measured by the quadric error
+ * metric of Garland and Heckbert.  Each collapse moves a vertex onto one of
+ * its neighbors, so the simplified triangles reference a subset of the
+ * original vertices, and can share the original vertex data.
+ *
+ * Vertices at which the attributes are discontinuous, such as at UV seams or
+ * creases in the normals, are only moved along the seam, and vertices on the
+ * border of an open mesh only along the border.  Edges across which the
+ * other vertex attributes differ more are collapsed later, according to the
+ * simplify-normal-weight, simplify-texcoord-weight and simplify-color-weight
+ * config variables.
+ *
+ * See Geom::simplify() and LODGenerator for the high-level interface.
+ */
+class EXPCL_PANDA_GOBJ MeshSimplifier {
+public:
+  static size_t simplify(int *indices, size_t num_indices,
+                         const LVecBase3 *positions, int num_vertices,
+                         const PN_stdfloat *attributes, int num_attributes,
+                         const PN_stdfloat *attribute_weights,
+                         size_t target_num_indices, PN_stdfloat max_error,
+                         PN_stdfloat *result_error = nullptr);
+
+  static int read_attributes(const GeomVertexData *vdata,
+                             pvector<PN_stdfloat> &attributes,
+                             pvector<PN_stdfloat> &weights,
+                             Thread *current_thread);
+};
+
+#endif
@@ -1,11 +1,13 @@
 #include "adaptiveLru.cxx"
 #include "animateVerticesRequest.cxx"
+#include "blockCompressor.cxx"
 #include "bufferContext.cxx"
 #include "bufferContextChain.cxx"
 #include "bufferResidencyTracker.cxx"
 #include "config_gobj.cxx"
 #include "geom.cxx"
 #include "geomCacheEntry.cxx"
+#include "geomClusters.cxx"
 #include "geomCacheManager.cxx"
 #include "geomContext.cxx"
 #include "geomEnums.cxx"
@@ -37,5 +39,6 @@
 #include "material.cxx"
 #include "materialPool.cxx"
 #include "matrixLens.cxx"
+#include "meshSimplifier.cxx"
 #include "occlusionQueryContext.cxx"
 #include "orthographicLens.cxx"
@@ -20,12 +20,14 @@
 #include "textureReloadRequest.cxx"
 #include "textureStage.cxx"
 #include "textureStagePool.cxx"
+#include "textureStreamingManager.cxx"
 #include "transformBlend.cxx"
 #include "transformBlendTable.cxx"
 #include "transformTable.cxx"
 #include "userVertexSlider.cxx"
 #include "userVertexTransform.cxx"
 #include "vertexBufferContext.cxx"
+#include "vertexCacheOptimizer.cxx"
 #include "vertexDataBlock.cxx"
 #include "vertexDataBook.cxx"
 #include "vertexDataPage.cxx"
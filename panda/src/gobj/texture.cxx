@@ -19,6 +19,7 @@
 #include "config_putil.h"
 #include "texturePool.h"
 #include "textureContext.h"
+#include "textureStreamingManager.h"
 #include "bamCache.h"
 #include "bamCacheRecord.h"
 #include "datagram.h"
@@ -44,13 +45,27 @@
 #include "texturePeeker.h"
 #include "convert_srgb.h"
 #include "asyncTaskManager.h"
-
-#ifdef HAVE_SQUISH
-#include <squish.h>
-#endif  // HAVE_SQUISH
+#include "blockCompressor.h"
+#include "compress_string.h"
 
 #include <stddef.h>
 
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#ifdef HAVE_BASISU
+#include "basisu_transcoder.h"
+#endif
+
+#if defined(__SSE2__) || (_M_IX86_FP >= 2) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define TEXTURE_USE_SSE2
+#elif defined(__ARM_NEON) || defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define TEXTURE_USE_NEON
+#endif
+
 using std::endl;
 using std::istream;
 using std::max;
@@ -69,6 +84,15 @@ ConfigVariableEnum<Texture::QualityLevel> texture_quality_level
           "it has little or no effect on normal, hardware-accelerated "
           "renderers.  See Texture::set_quality_level()."));
 
+ConfigVariableEnum<Texture::MipmapFilter> texture_mipmap_filter
+("texture-mipmap-filter", Texture::MF_box,
+ PRC_DESC("The filter that is used to generate the mipmap levels of a "
+          "texture image in RAM.  This may be box, kaiser, or lanczos.  "
+          "The box filter averages each 2x2 block of pixels, and is the "
+          "fastest.  The kaiser and lanczos filters are windowed sinc "
+          "filters, which keep more of the detail of the larger level, but "
+          "take longer."));
+
 PStatCollector Texture::_texture_read_pcollector("*:Texture:Read");
 PStatCollector Texture::_texture_write_pcollector("*:Texture:Write");
 TypeHandle Texture::_type_handle;
@@ -368,6 +392,775 @@ enum KTXCompressedFormat {
   KTX_ETC1_SRGB8 = 0x88EE,
 };
 
+// Stuff to read KTX2 files.  KTX2 identifies formats by their VkFormat value.
+enum KTX2Format {
+  KTX2_UNDEFINED = 0,
+  KTX2_R8_UNORM = 9,
+  KTX2_R8_SNORM = 10,
+  KTX2_R8_UINT = 13,
+  KTX2_R8_SINT = 14,
+  KTX2_R8G8_UNORM = 16,
+  KTX2_R8G8_SNORM = 17,
+  KTX2_R8G8_UINT = 20,
+  KTX2_R8G8_SINT = 21,
+  KTX2_R8G8B8_UNORM = 23,
+  KTX2_R8G8B8_UINT = 27,
+  KTX2_R8G8B8_SRGB = 29,
+  KTX2_B8G8R8_UNORM = 30,
+  KTX2_B8G8R8_SRGB = 36,
+  KTX2_R8G8B8A8_UNORM = 37,
+  KTX2_R8G8B8A8_UINT = 41,
+  KTX2_R8G8B8A8_SRGB = 43,
+  KTX2_B8G8R8A8_UNORM = 44,
+  KTX2_B8G8R8A8_SRGB = 50,
+  KTX2_R16_UNORM = 70,
+  KTX2_R16_UINT = 74,
+  KTX2_R16_SFLOAT = 76,
+  KTX2_R16G16_UNORM = 77,
+  KTX2_R16G16_UINT = 81,
+  KTX2_R16G16_SFLOAT = 83,
+  KTX2_R16G16B16_UNORM = 84,
+  KTX2_R16G16B16_SFLOAT = 90,
+  KTX2_R16G16B16A16_UNORM = 91,
+  KTX2_R16G16B16A16_SFLOAT = 97,
+  KTX2_R32_UINT = 98,
+  KTX2_R32_SFLOAT = 100,
+  KTX2_R32G32_UINT = 101,
+  KTX2_R32G32_SFLOAT = 103,
+  KTX2_R32G32B32_UINT = 104,
+  KTX2_R32G32B32_SFLOAT = 106,
+  KTX2_R32G32B32A32_UINT = 107,
+  KTX2_R32G32B32A32_SFLOAT = 109,
+  KTX2_D16_UNORM = 124,
+  KTX2_D32_SFLOAT = 126,
+  KTX2_BC1_RGB_UNORM_BLOCK = 131,
+  KTX2_BC1_RGB_SRGB_BLOCK = 132,
+  KTX2_BC1_RGBA_UNORM_BLOCK = 133,
+  KTX2_BC1_RGBA_SRGB_BLOCK = 134,
+  KTX2_BC2_UNORM_BLOCK = 135,
+  KTX2_BC2_SRGB_BLOCK = 136,
+  KTX2_BC3_UNORM_BLOCK = 137,
+  KTX2_BC3_SRGB_BLOCK = 138,
+  KTX2_BC4_UNORM_BLOCK = 139,
+  KTX2_BC5_UNORM_BLOCK = 141,
+  KTX2_BC6H_UFLOAT_BLOCK = 143,
+  KTX2_BC7_UNORM_BLOCK = 145,
+  KTX2_BC7_SRGB_BLOCK = 146,
+  KTX2_ETC2_R8G8B8_UNORM_BLOCK = 147,
+  KTX2_ETC2_R8G8B8_SRGB_BLOCK = 148,
+  KTX2_ETC2_R8G8B8A1_UNORM_BLOCK = 149,
+  KTX2_ETC2_R8G8B8A8_UNORM_BLOCK = 151,
+  KTX2_ETC2_R8G8B8A8_SRGB_BLOCK = 152,
+  KTX2_EAC_R11_UNORM_BLOCK = 153,
+  KTX2_EAC_R11G11_UNORM_BLOCK = 155,
+};
+
+enum KTX2Supercompression {
+  KTX2_SS_none = 0,
+  KTX2_SS_basis_lz = 1,
+  KTX2_SS_zstd = 2,
+  KTX2_SS_zlib = 3,
+};
+
+// The color model of UASTC data, in the data format descriptor.
+static const uint32_t KTX2_DF_MODEL_UASTC = 166;
+
+/**
+ * Undoes the supercompression of one mipmap level of a KTX2 file, writing
+ * exactly size bytes to dest.  Returns false if the data is invalid or the
+ * scheme is not supported by this build.
+ */
+static bool
+ktx2_decompress_level(uint32_t scheme, const vector_uchar &data,
+                      unsigned char *dest, size_t size) {
+  switch (scheme) {
+#ifdef HAVE_ZSTD
+  case KTX2_SS_zstd:
+    {
+      size_t result = ZSTD_decompress(dest, size, data.data(), data.size());
+      return !ZSTD_isError(result) && result == size;
+    }
+#endif
+
+#ifdef HAVE_ZLIB
+  case KTX2_SS_zlib:
+    {
+      string result = decompress_string(string((const char *)data.data(), data.size()));
+      if (result.size() != size) {
+        return false;
+      }
+      memcpy(dest, result.data(), size);
+      return true;
+    }
+#endif
+
+  default:
+    break;
+  }
+  return false;
+}
+
+#ifdef HAVE_BASISU
+/**
+ * Initializes the global tables of the Basis Universal transcoder, the first
+ * time this is called.  Returns true.
+ */
+static bool
+ktx2_init_basis() {
+  static bool initialized = (basist::basisu_transcoder_init(), true);
+  return initialized;
+}
+
+/**
+ * Chooses the format to transcode Basis Universal data to: the best of the
+ * compressed formats that the default GSG supports, or uncompressed RGBA if
+ * there is no GSG yet, or it supports none of them.  Sets format and
+ * compression accordingly.
+ */
+static basist::transcoder_texture_format
+ktx2_choose_basis_format(bool has_alpha, bool srgb, Texture::Format &format,
+                         Texture::CompressionMode &compression) {
+  Texture::Format rgb_format = srgb ? Texture::F_srgb : Texture::F_rgb;
+  Texture::Format rgba_format = srgb ? Texture::F_srgb_alpha : Texture::F_rgba;
+
+  GraphicsStateGuardianBase *gsg = GraphicsStateGuardianBase::get_default_gsg();
+  if (gsg != nullptr) {
+    if (gsg->get_supports_compressed_texture_format(Texture::CM_bptc)) {
+      format = rgba_format;
+      compression = Texture::CM_bptc;
+      return basist::transcoder_texture_format::cTFBC7_RGBA;
+    }
+    if (has_alpha && gsg->get_supports_compressed_texture_format(Texture::CM_dxt5)) {
+      format = rgba_format;
+      compression = Texture::CM_dxt5;
+      return basist::transcoder_texture_format::cTFBC3_RGBA;
+    }
+    if (!has_alpha && gsg->get_supports_compressed_texture_format(Texture::CM_dxt1)) {
+      format = rgb_format;
+      compression = Texture::CM_dxt1;
+      return basist::transcoder_texture_format::cTFBC1_RGB;
+    }
+    if (gsg->get_supports_compressed_texture_format(Texture::CM_etc2)) {
+      // ETC1 is a subset of ETC2, for the opaque case.
+      format = has_alpha ? rgba_format : rgb_format;
+      compression = Texture::CM_etc2;
+      return has_alpha ? basist::transcoder_texture_format::cTFETC2_RGBA
+                       : basist::transcoder_texture_format::cTFETC1_RGB;
+    }
+    if (!has_alpha && gsg->get_supports_compressed_texture_format(Texture::CM_etc1)) {
+      format = rgb_format;
+      compression = Texture::CM_etc1;
+      return basist::transcoder_texture_format::cTFETC1_RGB;
+    }
+  }
+
+  format = srgb ? Texture::F_srgb_alpha : Texture::F_rgba8;
+  compression = Texture::CM_off;
+  return basist::transcoder_texture_format::cTFRGBA32;
+}
+
+/**
+ * Transcodes one mipmap level of a KTX2 file with Basis Universal data to the
+ * indicated format, storing the layers and faces one page after the other.
+ * Returns false if the data is invalid.
+ */
+static bool
+ktx2_transcode_basis_level(basist::ktx2_transcoder &transcoder, uint32_t n,
+                           basist::transcoder_texture_format target,
+                           PTA_uchar &image, size_t &page_size) {
+  basist::ktx2_image_level_info info;
+  if (!transcoder.get_image_level_info(info, n, 0, 0)) {
+    return false;
+  }
+
+  // The size of an uncompressed image is given in pixels rather than blocks.
+  uint32_t size = basist::basis_transcoder_format_is_uncompressed(target)
+    ? info.m_orig_width * info.m_orig_height : info.m_total_blocks;
+  page_size = (size_t)size * basist::basis_get_bytes_per_block_or_pixel(target);
+
+  uint32_t num_layers = std::max(transcoder.get_layers(), (uint32_t)1);
+  uint32_t num_faces = transcoder.get_faces();
+  image = PTA_uchar::empty_array(page_size * num_layers * num_faces);
+
+  unsigned char *dest = image.p();
+  for (uint32_t layer = 0; layer < num_layers; ++layer) {
+    for (uint32_t face = 0; face < num_faces; ++face) {
+      if (!transcoder.transcode_image_level(n, layer, face, dest, size, target)) {
+        return false;
+      }
+      dest += page_size;
+    }
+  }
+  return true;
+}
+#endif  // HAVE_BASISU
+
+// Stuff to compress images into 4x4 blocks with the BlockCompressor.
+
+// One row of 4x4 blocks of a single page of a single mipmap level.
+struct TextureBlockRow {
+  const unsigned char *_src;
+  unsigned char *_dest;
+  int _x_size;
+  int _y_size;
+  int _y;
+};
+
+/**
+ * Determines which block format should be used to store an image with the
+ * indicated properties using the indicated compression mode.  Returns false
+ * if the BlockCompressor cannot handle this combination.
+ */
+static bool
+get_block_format(Texture::CompressionMode compression, int num_components,
+                 Texture::ComponentType component_type,
+                 BlockCompressor::BlockFormat &format) {
+  if (compression == Texture::CM_bptc && num_components == 3 &&
+      (component_type == Texture::T_float ||
+       component_type == Texture::T_half_float)) {
+    format = BlockCompressor::BF_bc6h;
+    return true;
+  }
+  if (component_type != Texture::T_unsigned_byte) {
+    return false;
+  }
+
+  switch (compression) {
+  case Texture::CM_dxt1:
+    format = BlockCompressor::BF_bc1;
+    return true;
+
+  case Texture::CM_dxt2:
+  case Texture::CM_dxt3:
+    format = BlockCompressor::BF_bc2;
+    return true;
+
+  case Texture::CM_dxt4:
+  case Texture::CM_dxt5:
+    format = BlockCompressor::BF_bc3;
+    return true;
+
+  case Texture::CM_rgtc:
+    if (num_components == 1) {
+      format = BlockCompressor::BF_bc4;
+      return true;
+    } else if (num_components == 2) {
+      format = BlockCompressor::BF_bc5;
+      return true;
+    }
+    return false;
+
+  case Texture::CM_bptc:
+    format = BlockCompressor::BF_bc7;
+    return true;
+
+  default:
+    return false;
+  }
+}
+
+/**
+ * Copies the pixels of the bx'th block of the indicated row into the RGBA
+ * order expected by the BlockCompressor.  Pixels beyond the edge of the image
+ * are filled in by repeating the last row and column.
+ */
+static void
+gather_texture_block(const TextureBlockRow &row, int bx, int num_components,
+                     bool rgtc, unsigned char rgba[64]) {
+  unsigned char *t = rgba;
+  for (int i = 0; i < 16; ++i) {
+    int xi = std::min(bx * 4 + (i & 3), row._x_size - 1);
+    int yi = std::min(row._y * 4 + (i >> 2), row._y_size - 1);
+    const unsigned char *s = row._src + ((size_t)yi * row._x_size + xi) * num_components;
+    if (rgtc) {
+      t[0] = s[0];
+      t[1] = (num_components > 1) ? s[1] : 0;
+      t[2] = 0;
+      t[3] = 255;
+    } else {
+      switch (num_components) {
+      case 1:
+        t[0] = s[0];   // r
+        t[1] = s[0];   // g
+        t[2] = s[0];   // b
+        t[3] = 255;    // a
+        break;
+
+      case 2:
+        t[0] = s[0];   // r
+        t[1] = s[0];   // g
+        t[2] = s[0];   // b
+        t[3] = s[1];   // a
+        break;
+
+      case 3:
+        t[0] = s[2];   // r
+        t[1] = s[1];   // g
+        t[2] = s[0];   // b
+        t[3] = 255;    // a
+        break;
+
+      default:
+        t[0] = s[2];   // r
+        t[1] = s[1];   // g
+        t[2] = s[0];   // b
+        t[3] = s[3];   // a
+        break;
+      }
+    }
+    t += 4;
+  }
+}
+
+/**
+ * The inverse of gather_texture_block(): copies the decoded pixels of a block
+ * back into the image, skipping those that lie beyond its edge.
+ */
+static void
+scatter_texture_block(const TextureBlockRow &row, int bx, int num_components,
+                      bool rgtc, const unsigned char rgba[64]) {
+  const unsigned char *t = rgba;
+  for (int i = 0; i < 16; ++i, t += 4) {
+    int xi = bx * 4 + (i & 3);
+    int yi = row._y * 4 + (i >> 2);
+    if (xi >= row._x_size || yi >= row._y_size) {
+      continue;
+    }
+    unsigned char *d = row._dest + ((size_t)yi * row._x_size + xi) * num_components;
+    if (rgtc) {
+      d[0] = t[0];
+      if (num_components > 1) {
+        d[1] = t[1];
+      }
+    } else {
+      switch (num_components) {
+      case 1:
+        d[0] = t[1];   // g
+        break;
+
+      case 2:
+        d[0] = t[1];   // g
+        d[1] = t[3];   // a
+        break;
+
+      case 3:
+        d[2] = t[0];   // r
+        d[1] = t[1];   // g
+        d[0] = t[2];   // b
+        break;
+
+      default:
+        d[2] = t[0];   // r
+        d[1] = t[1];   // g
+        d[0] = t[2];   // b
+        d[3] = t[3];   // a
+        break;
+      }
+    }
+  }
+}
+
+/**
+ * Like gather_texture_block(), but for a three-component floating-point
+ * image, which is converted to half-floats for BC6H.
+ */
+static void
+gather_texture_block_hdr(const TextureBlockRow &row, int bx,
+                         Texture::ComponentType component_type,
+                         uint16_t rgb[48]) {
+  uint16_t *t = rgb;
+  for (int i = 0; i < 16; ++i) {
+    int xi = std::min(bx * 4 + (i & 3), row._x_size - 1);
+    int yi = std::min(row._y * 4 + (i >> 2), row._y_size - 1);
+    size_t pixel = (size_t)yi * row._x_size + xi;
+    if (component_type == Texture::T_half_float) {
+      const uint16_t *s = (const uint16_t *)row._src + pixel * 3;
+      t[0] = s[2];
+      t[1] = s[1];
+      t[2] = s[0];
+    } else {
+      const float *s = (const float *)row._src + pixel * 3;
+      t[0] = BlockCompressor::float_to_half(s[2]);
+      t[1] = BlockCompressor::float_to_half(s[1]);
+      t[2] = BlockCompressor::float_to_half(s[0]);
+    }
+    t += 3;
+  }
+}
+
+/**
+ * The inverse of gather_texture_block_hdr().
+ */
+static void
+scatter_texture_block_hdr(const TextureBlockRow &row, int bx,
+                          Texture::ComponentType component_type,
+                          const uint16_t rgb[48]) {
+  const uint16_t *t = rgb;
+  for (int i = 0; i < 16; ++i, t += 3) {
+    int xi = bx * 4 + (i & 3);
+    int yi = row._y * 4 + (i >> 2);
+    if (xi >= row._x_size || yi >= row._y_size) {
+      continue;
+    }
+    size_t pixel = (size_t)yi * row._x_size + xi;
+    if (component_type == Texture::T_half_float) {
+      uint16_t *d = (uint16_t *)row._dest + pixel * 3;
+      d[2] = t[0];
+      d[1] = t[1];
+      d[0] = t[2];
+    } else {
+      float *d = (float *)row._dest + pixel * 3;
+      d[2] = BlockCompressor::half_to_float(t[0]);
+      d[1] = BlockCompressor::half_to_float(t[1]);
+      d[0] = BlockCompressor::half_to_float(t[2]);
+    }
+  }
+}
+
+/**
+ * Calls process(i) for each i in [0, count), dividing the work among the
+ * threads of the indicated task chain if num_threads is greater than 0.
+ * Otherwise, does all the work in the current thread.
+ */
+template<class Process>
+static void
+process_texture_rows(const char *chain_name, int num_threads, size_t count,
+                     Process process) {
+  if (num_threads <= 0 || count < 2) {
+    for (size_t i = 0; i < count; ++i) {
+      process(i);
+      Thread::consider_yield();
+    }
+    return;
+  }
+
+  PT(AsyncTaskChain) chain =
+    AsyncTaskManager::get_global_ptr()->make_task_chain(chain_name);
+  if (chain->get_num_threads() < num_threads) {
+    chain->set_num_threads(num_threads);
+  }
+  chain->parallel_for(count, process);
+}
+
+// Filter kernels for generating mipmap levels with a filter other than the
+// box filter.
+
+/**
+ * Returns the zeroth-order modified Bessel function of the first kind, which
+ * shapes the Kaiser window.
+ */
+static float
+mipmap_bessel_i0(float x) {
+  float sum = 1.0f;
+  float term = 1.0f;
+  float half_x = x * 0.5f;
+  for (int k = 1; k < 32 && term > sum * 1.0e-7f; ++k) {
+    term *= (half_x / k) * (half_x / k);
+    sum += term;
+  }
+  return sum;
+}
+
+/**
+ * Returns the weight of the indicated mipmap filter at a distance of t pixels
+ * of the new level from the center of a pixel.
+ */
+static float
+eval_mipmap_filter(Texture::MipmapFilter filter, float t) {
+  static const float pi = 3.14159265358979f;
+  static const float kaiser_alpha = 4.0f;
+
+  t = cabs(t);
+  switch (filter) {
+  case Texture::MF_box:
+    return (t < 0.5f) ? 1.0f : 0.0f;
+
+  case Texture::MF_kaiser:
+    if (t < 3.0f) {
+      float r = t / 3.0f;
+      return csin_over_x(pi * t) *
+        mipmap_bessel_i0(kaiser_alpha * csqrt(1.0f - r * r)) /
+        mipmap_bessel_i0(kaiser_alpha);
+    }
+    break;
+
+  case Texture::MF_lanczos:
+    if (t < 3.0f) {
+      return csin_over_x(pi * t) * csin_over_x(pi * t / 3.0f);
+    }
+    break;
+  }
+  return 0.0f;
+}
+
+/**
+ * The pixels of the previous mipmap level that make up one pixel of the next
+ * level along one axis, and how much each of them contributes.
+ */
+struct MipmapTaps {
+  int _first;
+  pvector<float> _weights;
+};
+typedef pvector<MipmapTaps> MipmapTapList;
+
+/**
+ * Computes the taps of the indicated filter for each of the to_size pixels of
+ * a new mipmap level along one axis, from a level that is from_size pixels
+ * long.  Taps that fall past the edge are folded onto the edge pixel.
+ */
+static void
+compute_mipmap_taps(MipmapTapList &taps, Texture::MipmapFilter filter,
+                    int from_size, int to_size) {
+  // The box filter samples the same 2x2 blocks as the other box filters,
+  // dropping the last pixel of an odd size.  The others cover the whole level.
+  float scale;
+  float radius;
+  if (filter == Texture::MF_box) {
+    scale = (from_size > 1) ? 2.0f : 1.0f;
+    radius = 0.5f * scale;
+  } else {
+    scale = (float)from_size / (float)to_size;
+    radius = 3.0f * scale;
+  }
+
+  taps.resize(to_size);
+  for (int i = 0; i < to_size; ++i) {
+    float center = (i + 0.5f) * scale;
+    int begin = (int)cfloor(center - radius);
+    int end = (int)cceil(center + radius);
+
+    MipmapTaps &tap = taps[i];
+    tap._first = max(begin, 0);
+    tap._weights.assign(min(end, from_size) - tap._first, 0.0f);
+    float total = 0.0f;
+    for (int j = begin; j < end; ++j) {
+      float weight = eval_mipmap_filter(filter, (j + 0.5f - center) / scale);
+      int k = min(max(j, 0), from_size - 1);
+      tap._weights[k - tap._first] += weight;
+      total += weight;
+    }
+    for (float &weight : tap._weights) {
+      weight /= total;
+    }
+  }
+}
+
+/**
+ * Converts a row of pixels of a mipmap level to linear floating-point
+ * components.  alpha_index is the index of the alpha component, or -1 if
+ * there is none.  If alpha_weighted is true, the color components are
+ * multiplied by the alpha component.
+ */
+static void
+decode_mipmap_row(float *to, const unsigned char *from, size_t num_pixels,
+                  int num_components, Texture::ComponentType component_type,
+                  bool srgb, int alpha_index, bool alpha_weighted) {
+  size_t num_values = num_pixels * num_components;
+  for (size_t i = 0; i < num_values; ++i) {
+    float value;
+    switch (component_type) {
+    case Texture::T_unsigned_byte:
+      value = from[i] / 255.0f;
+      break;
+    case Texture::T_unsigned_short:
+      value = ((const uint16_t *)from)[i] / 65535.0f;
+      break;
+    case Texture::T_half_float:
+      value = BlockCompressor::half_to_float(((const uint16_t *)from)[i]);
+      break;
+    default:
+      value = ((const float *)from)[i];
+      break;
+    }
+    if (srgb && (int)(i % num_components) != alpha_index) {
+      value = decode_sRGB_float(value);
+    }
+    to[i] = value;
+  }
+
+  if (alpha_weighted && alpha_index >= 0) {
+    for (size_t i = 0; i < num_values; i += num_components) {
+      float alpha = to[i + alpha_index];
+      for (int c = 0; c < num_components; ++c) {
+        if (c != alpha_index) {
+          to[i + c] *= alpha;
+        }
+      }
+    }
+  }
+}
+
+/**
+ * The reverse of decode_mipmap_row().  Modifies the components in from.
+ */
+static void
+encode_mipmap_row(unsigned char *to, float *from, size_t num_pixels,
+                  int num_components, Texture::ComponentType component_type,
+                  bool srgb, int alpha_index, bool alpha_weighted) {
+  size_t num_values = num_pixels * num_components;
+  if (alpha_weighted && alpha_index >= 0) {
+    // Pixels that ended up (nearly) fully transparent keep their weighted
+    // color, since it hardly matters.
+    for (size_t i = 0; i < num_values; i += num_components) {
+      float alpha = from[i + alpha_index];
+      if (alpha > 1.0f / 4096.0f) {
+        for (int c = 0; c < num_components; ++c) {
+          if (c != alpha_index) {
+            from[i + c] /= alpha;
+          }
+        }
+      }
+    }
+  }
+
+  for (size_t i = 0; i < num_values; ++i) {
+    float value = from[i];
+    if (component_type == Texture::T_unsigned_byte ||
+        component_type == Texture::T_unsigned_short) {
+      // The negative lobes of the filter may overshoot.
+      value = min(max(value, 0.0f), 1.0f);
+    }
+    bool is_color = srgb && (int)(i % num_components) != alpha_index;
+    switch (component_type) {
+    case Texture::T_unsigned_byte:
+      if (is_color) {
+        to[i] = encode_sRGB_uchar(value);
+      } else {
+        to[i] = (unsigned char)(value * 255.0f + 0.5f);
+      }
+      break;
+    case Texture::T_unsigned_short:
+      if (is_color) {
+        value = encode_sRGB_float(value);
+      }
+      ((uint16_t *)to)[i] = (uint16_t)(value * 65535.0f + 0.5f);
+      break;
+    case Texture::T_half_float:
+      if (is_color) {
+        value = encode_sRGB_float(value);
+      }
+      ((uint16_t *)to)[i] = BlockCompressor::float_to_half(value);
+      break;
+    default:
+      if (is_color) {
+        value = encode_sRGB_float(value);
+      }
+      ((float *)to)[i] = value;
+      break;
+    }
+  }
+}
+
+// Vectorized filters for generating mipmap levels of the most common formats.
+
+/**
+ * Averages the 2x2 blocks of a row of four-component unsigned byte pixels,
+ * or, if page_step is given, the 2x2x2 blocks, writing count pixels to p.
+ * row_step and page_step are 0 for an image that is only one pixel high or
+ * deep.  The results are identical to those of filter_2d_unsigned_byte and
+ * filter_3d_unsigned_byte.
+ *
+ * Returns the number of pixels that were filtered, which may be less than
+ * count; the caller should filter the remaining pixels.
+ */
+static int
+filter_mipmap_row_rgba8(unsigned char *p, const unsigned char *q, int count,
+                        size_t row_step, size_t page_step, bool three_d) {
+  int x = 0;
+#if defined(TEXTURE_USE_SSE2)
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i shift = _mm_cvtsi32_si128(three_d ? 3 : 2);
+  for (; x + 2 <= count; x += 2) {
+    // Load four source pixels from each of the rows, and widen them to 16
+    // bits, so that the sums can't overflow.
+    const unsigned char *r = q + x * 8;
+    __m128i a = _mm_loadu_si128((const __m128i *)r);
+    __m128i b = _mm_loadu_si128((const __m128i *)(r + row_step));
+    __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+    __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+    if (three_d) {
+      a = _mm_loadu_si128((const __m128i *)(r + page_step));
+      b = _mm_loadu_si128((const __m128i *)(r + page_step + row_step));
+      lo = _mm_add_epi16(lo, _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero)));
+      hi = _mm_add_epi16(hi, _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero)));
+    }
+
+    // lo holds the first two pixels and hi the last two; add the pairs.
+    __m128i sum = _mm_add_epi16(_mm_unpacklo_epi64(lo, hi), _mm_unpackhi_epi64(lo, hi));
+    sum = _mm_srl_epi16(sum, shift);
+    _mm_storel_epi64((__m128i *)(p + x * 4), _mm_packus_epi16(sum, sum));
+  }
+#elif defined(TEXTURE_USE_NEON)
+  for (; x + 2 <= count; x += 2) {
+    const unsigned char *r = q + x * 8;
+    uint8x16_t a = vld1q_u8(r);
+    uint8x16_t b = vld1q_u8(r + row_step);
+    uint16x8_t lo = vaddl_u8(vget_low_u8(a), vget_low_u8(b));
+    uint16x8_t hi = vaddl_u8(vget_high_u8(a), vget_high_u8(b));
+    if (three_d) {
+      a = vld1q_u8(r + page_step);
+      b = vld1q_u8(r + page_step + row_step);
+      lo = vaddq_u16(lo, vaddl_u8(vget_low_u8(a), vget_low_u8(b)));
+      hi = vaddq_u16(hi, vaddl_u8(vget_high_u8(a), vget_high_u8(b)));
+    }
+
+    uint16x8_t sum = vaddq_u16(vcombine_u16(vget_low_u16(lo), vget_low_u16(hi)),
+                               vcombine_u16(vget_high_u16(lo), vget_high_u16(hi)));
+    sum = three_d ? vshrq_n_u16(sum, 3) : vshrq_n_u16(sum, 2);
+    vst1_u8(p + x * 4, vmovn_u16(sum));
+  }
+#endif
+  return x;
+}
+
+/**
+ * Like filter_mipmap_row_rgba8, but for four-component float pixels.  The
+ * samples are added in the same order as filter_2d_float and filter_3d_float
+ * do, so the results are identical to theirs.
+ */
+static int
+filter_mipmap_row_rgba32f(unsigned char *p, const unsigned char *q, int count,
+                          size_t row_step, size_t page_step, bool three_d) {
+  int x = 0;
+#if defined(TEXTURE_USE_SSE2)
+  const __m128 scale = _mm_set1_ps(three_d ? 0.125f : 0.25f);
+  for (; x < count; ++x) {
+    const unsigned char *r = q + x * 32;
+    __m128 sum = _mm_add_ps(_mm_loadu_ps((const float *)r),
+                            _mm_loadu_ps((const float *)(r + 16)));
+    sum = _mm_add_ps(sum, _mm_loadu_ps((const float *)(r + row_step)));
+    sum = _mm_add_ps(sum, _mm_loadu_ps((const float *)(r + row_step + 16)));
+    if (three_d) {
+      r += page_step;
+      sum = _mm_add_ps(sum, _mm_loadu_ps((const float *)r));
+      sum = _mm_add_ps(sum, _mm_loadu_ps((const float *)(r + 16)));
+      sum = _mm_add_ps(sum, _mm_loadu_ps((const float *)(r + row_step)));
+      sum = _mm_add_ps(sum, _mm_loadu_ps((const float *)(r + row_step + 16)));
+    }
+    _mm_storeu_ps((float *)(p + x * 16), _mm_mul_ps(sum, scale));
+  }
+#elif defined(TEXTURE_USE_NEON)
+  float scale = three_d ? 0.125f : 0.25f;
+  for (; x < count; ++x) {
+    const float *r = (const float *)(q + x * 32);
+    const float *r2 = (const float *)(q + x * 32 + row_step);
+    float32x4_t sum = vaddq_f32(vld1q_f32(r), vld1q_f32(r + 4));
+    sum = vaddq_f32(sum, vld1q_f32(r2));
+    sum = vaddq_f32(sum, vld1q_f32(r2 + 4));
+    if (three_d) {
+      r = (const float *)(q + x * 32 + page_step);
+      r2 = (const float *)(q + x * 32 + page_step + row_step);
+      sum = vaddq_f32(sum, vld1q_f32(r));
+      sum = vaddq_f32(sum, vld1q_f32(r + 4));
+      sum = vaddq_f32(sum, vld1q_f32(r2));
+      sum = vaddq_f32(sum, vld1q_f32(r2 + 4));
+    }
+    vst1q_f32((float *)(p + x * 16), vmulq_n_f32(sum, scale));
+  }
+#endif
+  return x;
+}
+
 /**
  * Constructs an empty texture.  The default is to set up the texture as an
  * empty 2-d texture; follow up with one of the variants of setup_texture() if
@@ -380,6 +1173,7 @@ Texture(std::string name) :
   _cvar(_lock)
 {
   _reloading = false;
+  _streaming = false;
 
   CDWriter cdata(_cycler, true);
   cdata->inc_properties_modified();
@@ -396,6 +1190,7 @@ Texture(const Texture &copy) :
   _cvar(_lock)
 {
   _reloading = false;
+  _streaming = false;
 }
 
 /**
@@ -412,6 +1207,9 @@ operator = (const Texture &copy) {
  */
 Texture::
 ~Texture() {
+  if (_streaming) {
+    TextureStreamingManager::get_global_ptr()->remove_texture(this);
+  }
   release_all();
   nassertv(!_reloading);
 }
@@ -963,6 +1761,9 @@ read_dds(istream &in, std::string_view filename, bool header_only) {
  * on.
  *
  * As with read_dds, the filename is just for reference.
+ *
+ * Both KTX 1 and KTX2 files are accepted.  KTX2 files may use Zstandard or
+ * zlib supercompression, if Panda was built with support for these.
  */
 bool Texture::
 read_ktx(istream &in, std::string_view filename, bool header_only) {
@@ -2566,6 +3367,8 @@ format_compression_mode(CompressionMode cm) {
     return "etc2";
   case CM_eac:
     return "eac";
+  case CM_bptc:
+    return "bptc";
   }
 
   return "**invalid**";
@@ -2607,6 +3410,8 @@ string_compression_mode(std::string_view str) {
     return CM_etc2;
   } else if (cmp_nocase_uh(str, "eac") == 0) {
     return CM_eac;
+  } else if (cmp_nocase_uh(str, "bptc") == 0) {
+    return CM_bptc;
   }
 
   gobj_cat->error()
@@ -2655,6 +3460,42 @@ string_quality_level(std::string_view str) {
   return QL_default;
 }
 
+/**
+ * Returns the indicated MipmapFilter converted to a string word.
+ */
+string Texture::
+format_mipmap_filter(MipmapFilter mf) {
+  switch (mf) {
+  case MF_box:
+    return "box";
+  case MF_kaiser:
+    return "kaiser";
+  case MF_lanczos:
+    return "lanczos";
+  }
+
+  return "**invalid**";
+}
+
+/**
+ * Returns the MipmapFilter value associated with the given string
+ * representation.
+ */
+Texture::MipmapFilter Texture::
+string_mipmap_filter(std::string_view str) {
+  if (cmp_nocase(str, "box") == 0) {
+    return MF_box;
+  } else if (cmp_nocase(str, "kaiser") == 0) {
+    return MF_kaiser;
+  } else if (cmp_nocase(str, "lanczos") == 0) {
+    return MF_lanczos;
+  }
+
+  gobj_cat->error()
+    << "Invalid Texture::MipmapFilter value: " << str << "\n";
+  return MF_box;
+}
+
 /**
  * This method is called by the GraphicsEngine at the beginning of the frame
  * *after* a texture has been successfully uploaded to graphics memory.  It is
@@ -4466,7 +5307,11 @@ do_read_ktx(CData *cdata, istream &in, std::string_view filename, bool header_on
   StreamReader ktx(in);
 
   unsigned char magic[12];
-  if (ktx.extract_bytes(magic, 12) != 12 ||
+  if (ktx.extract_bytes(magic, 12) == 12 &&
+      memcmp(magic, "\xABKTX 20\xBB\r\n\x1A\n", 12) == 0) {
+    return do_read_ktx2(cdata, in, filename, header_only);
+  }
+  if (in.fail() ||
       memcmp(magic, "\xABKTX 11\xBB\r\n\x1A\n", 12) != 0) {
     gobj_cat.error()
       << filename << " is not a KTX file.\n";
@@ -4678,9 +5523,22 @@ do_read_ktx(CData *cdata, istream &in, std::string_view filename, bool header_on
       compression = CM_pvr1_4bpp;
       break;
     case KTX_COMPRESSED_RGBA_BPTC_UNORM:
+      format = F_rgba;
+      base_format = KTX_RGBA;
+      compression = CM_bptc;
+      break;
     case KTX_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
-    case KTX_COMPRESSED_RGB_BPTC_SIGNED_FLOAT:
+      format = F_srgb_alpha;
+      base_format = KTX_SRGB_ALPHA;
+      compression = CM_bptc;
+      break;
     case KTX_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT:
+      type = T_half_float;
+      format = F_rgb16;
+      base_format = KTX_RGB;
+      compression = CM_bptc;
+      break;
+    case KTX_COMPRESSED_RGB_BPTC_SIGNED_FLOAT:
     default:
       gobj_cat.error()
         << filename << " has unsupported compressed internal format " << internal_format << "\n";
@@ -5199,6 +6057,591 @@ do_read_ktx(CData *cdata, istream &in, std::string_view filename, bool header_on
   return true;
 }
 
+/**
+ * Called by do_read_ktx() when it detects a KTX2 file, after the identifier
+ * has been read.  Assumes the lock is already held.
+ *
+ * The mipmap levels are stored smallest first, so they are read in that order,
+ * without seeking back in the stream.
+ */
+bool Texture::
+do_read_ktx2(CData *cdata, istream &in, std::string_view filename, bool header_only) {
+  StreamReader ktx(in);
+
+  // The header is kept in memory as it is read, since the Basis Universal
+  // transcoder needs to be given the whole file.
+  Datagram header(ktx.extract_bytes(68));
+  if (header.get_length() != 68) {
+    gobj_cat.error()
+      << filename << ": truncated KTX2 file.\n";
+    return false;
+  }
+
+  // See: https://registry.khronos.org/KTX/specs/2.0/ktxspec.v2.html
+  DatagramIterator scan(header);
+  uint32_t vk_format = scan.get_uint32();
+  /*uint32_t type_size = */scan.get_uint32();
+  uint32_t width = scan.get_uint32();
+  uint32_t height = scan.get_uint32();
+  uint32_t depth = scan.get_uint32();
+  uint32_t num_layers = scan.get_uint32();
+  uint32_t num_faces = scan.get_uint32();
+  uint32_t num_mipmap_levels = scan.get_uint32();
+  uint32_t supercompression = scan.get_uint32();
+
+  uint32_t dfd_offset = scan.get_uint32();
+  uint32_t dfd_size = scan.get_uint32();
+  /*uint32_t kvd_offset = */scan.get_uint32();
+  /*uint32_t kvd_size = */scan.get_uint32();
+  /*uint64_t sgd_offset = */scan.get_uint64();
+  /*uint64_t sgd_size = */scan.get_uint64();
+
+  struct LevelIndex {
+    uint64_t _offset;
+    uint64_t _size;
+    uint64_t _uncompressed_size;
+  };
+  pvector<LevelIndex> levels(std::max(num_mipmap_levels, (uint32_t)1));
+  vector_uchar level_index = ktx.extract_bytes(levels.size() * 24);
+  if (level_index.size() != levels.size() * 24) {
+    gobj_cat.error()
+      << filename << ": truncated KTX2 file.\n";
+    return false;
+  }
+  header.append_data(level_index);
+  for (LevelIndex &level : levels) {
+    level._offset = scan.get_uint64();
+    level._size = scan.get_uint64();
+    level._uncompressed_size = scan.get_uint64();
+  }
+  uint64_t pos = 80 + levels.size() * 24;
+
+  // Basis Universal data is identified by the supercompression scheme for
+  // ETC1S, or by the color model in the data format descriptor for UASTC.
+  bool basis = (supercompression == KTX2_SS_basis_lz);
+  if (vk_format == KTX2_UNDEFINED && !basis && dfd_size >= 16 && dfd_offset >= pos) {
+    header.append_data(ktx.extract_bytes((size_t)(dfd_offset - pos) + 16));
+    pos = dfd_offset + 16;
+    if (header.get_length() + 12 == pos) {
+      const unsigned char *dfd = (const unsigned char *)header.get_data() + header.get_length() - 16;
+      basis = (dfd[12] == KTX2_DF_MODEL_UASTC);
+    }
+  }
+
+  ComponentType type = T_unsigned_byte;
+  Format format = F_rgba;
+  CompressionMode compression = CM_off;
+  bool swap_bgr = false;
+
+#ifdef HAVE_BASISU
+  Datagram basis_file;
+  basist::ktx2_transcoder basis_transcoder;
+  basist::transcoder_texture_format basis_format = basist::transcoder_texture_format::cTFRGBA32;
+  if (basis) {
+    // The transcoder needs the whole file in memory, so read the rest of it,
+    // up to the end of the mipmap levels, which are stored last.
+    uint64_t end = pos;
+    for (const LevelIndex &level : levels) {
+      end = std::max(end, level._offset + level._size);
+    }
+    basis_file.append_data("\xABKTX 20\xBB\r\n\x1A\n", 12);
+    basis_file.append_data(header.get_data(), header.get_length());
+    basis_file.append_data(ktx.extract_bytes((size_t)(end - pos)));
+    if (basis_file.get_length() != end) {
+      gobj_cat.error()
+        << filename << ": truncated KTX2 file.\n";
+      return false;
+    }
+    pos = end;
+
+    ktx2_init_basis();
+    if (!basis_transcoder.init(basis_file.get_data(), (uint32_t)basis_file.get_length())) {
+      gobj_cat.error()
+        << filename << " contains invalid Basis Universal data.\n";
+      return false;
+    }
+    bool srgb = (basis_transcoder.get_dfd_transfer_func() == basist::KTX2_KHR_DF_TRANSFER_SRGB);
+    basis_format = ktx2_choose_basis_format(basis_transcoder.get_has_alpha(), srgb,
+                                            format, compression);
+
+    // The transcoder writes uncompressed pixels in RGBA order.
+    swap_bgr = (compression == CM_off);
+  }
+#else
+  if (basis) {
+    gobj_cat.error()
+      << filename << " contains Basis Universal data, which cannot be "
+         "transcoded because Panda3D was built without Basis Universal "
+         "support.\n";
+    return false;
+  }
+#endif  // HAVE_BASISU
+
+  switch ((KTX2Format)vk_format) {
+  case KTX2_R8_UNORM:
+    format = F_red;
+    break;
+  case KTX2_R8_SNORM:
+    type = T_byte;
+    format = F_red;
+    break;
+  case KTX2_R8_UINT:
+    format = F_r8i;
+    break;
+  case KTX2_R8_SINT:
+    type = T_byte;
+    format = F_r8i;
+    break;
+  case KTX2_R8G8_UNORM:
+    format = F_rg;
+    break;
+  case KTX2_R8G8_SNORM:
+    type = T_byte;
+    format = F_rg;
+    break;
+  case KTX2_R8G8_UINT:
+    format = F_rg8i;
+    break;
+  case KTX2_R8G8_SINT:
+    type = T_byte;
+    format = F_rg8i;
+    break;
+  case KTX2_R8G8B8_UNORM:
+    swap_bgr = true;
+  case KTX2_B8G8R8_UNORM:
+    format = F_rgb8;
+    break;
+  case KTX2_R8G8B8_SRGB:
+    swap_bgr = true;
+  case KTX2_B8G8R8_SRGB:
+    format = F_srgb;
+    break;
+  case KTX2_R8G8B8_UINT:
+    swap_bgr = true;
+    format = F_rgb8i;
+    break;
+  case KTX2_R8G8B8A8_UNORM:
+    swap_bgr = true;
+  case KTX2_B8G8R8A8_UNORM:
+    format = F_rgba8;
+    break;
+  case KTX2_R8G8B8A8_SRGB:
+    swap_bgr = true;
+  case KTX2_B8G8R8A8_SRGB:
+    format = F_srgb_alpha;
+    break;
+  case KTX2_R8G8B8A8_UINT:
+    swap_bgr = true;
+    format = F_rgba8i;
+    break;
+  case KTX2_R16_UNORM:
+    type = T_unsigned_short;
+    format = F_r16;
+    break;
+  case KTX2_R16_UINT:
+    type = T_unsigned_short;
+    format = F_r16i;
+    break;
+  case KTX2_R16_SFLOAT:
+    type = T_half_float;
+    format = F_r16;
+    break;
+  case KTX2_R16G16_UNORM:
+    type = T_unsigned_short;
+    format = F_rg16;
+    break;
+  case KTX2_R16G16_UINT:
+    type = T_unsigned_short;
+    format = F_rg16i;
+    break;
+  case KTX2_R16G16_SFLOAT:
+    type = T_half_float;
+    format = F_rg16;
+    break;
+  case KTX2_R16G16B16_UNORM:
+    swap_bgr = true;
+    type = T_unsigned_short;
+    format = F_rgb16;
+    break;
+  case KTX2_R16G16B16_SFLOAT:
+    swap_bgr = true;
+    type = T_half_float;
+    format = F_rgb16;
+    break;
+  case KTX2_R16G16B16A16_UNORM:
+    swap_bgr = true;
+    type = T_unsigned_short;
+    format = F_rgba16;
+    break;
+  case KTX2_R16G16B16A16_SFLOAT:
+    swap_bgr = true;
+    type = T_half_float;
+    format = F_rgba16;
+    break;
+  case KTX2_R32_UINT:
+    type = T_unsigned_int;
+    format = F_r32i;
+    break;
+  case KTX2_R32_SFLOAT:
+    type = T_float;
+    format = F_r32;
+    break;
+  case KTX2_R32G32_UINT:
+    type = T_unsigned_int;
+    format = F_rg32i;
+    break;
+  case KTX2_R32G32_SFLOAT:
+    type = T_float;
+    format = F_rg32;
+    break;
+  case KTX2_R32G32B32_UINT:
+    swap_bgr = true;
+    type = T_unsigned_int;
+    format = F_rgb32i;
+    break;
+  case KTX2_R32G32B32_SFLOAT:
+    swap_bgr = true;
+    type = T_float;
+    format = F_rgb32;
+    break;
+  case KTX2_R32G32B32A32_UINT:
+    swap_bgr = true;
+    type = T_unsigned_int;
+    format = F_rgba32i;
+    break;
+  case KTX2_R32G32B32A32_SFLOAT:
+    swap_bgr = true;
+    type = T_float;
+    format = F_rgba32;
+    break;
+  case KTX2_D16_UNORM:
+    type = T_unsigned_short;
+    format = F_depth_component16;
+    break;
+  case KTX2_D32_SFLOAT:
+    type = T_float;
+    format = F_depth_component32;
+    break;
+
+  case KTX2_BC1_RGB_UNORM_BLOCK:
+    format = F_rgb;
+    compression = CM_dxt1;
+    break;
+  case KTX2_BC1_RGB_SRGB_BLOCK:
+    format = F_srgb;
+    compression = CM_dxt1;
+    break;
+  case KTX2_BC1_RGBA_UNORM_BLOCK:
+    format = F_rgbm;
+    compression = CM_dxt1;
+    break;
+  case KTX2_BC1_RGBA_SRGB_BLOCK:
+    format = F_srgb_alpha;
+    compression = CM_dxt1;
+    break;
+  case KTX2_BC2_UNORM_BLOCK:
+    compression = CM_dxt3;
+    break;
+  case KTX2_BC2_SRGB_BLOCK:
+    format = F_srgb_alpha;
+    compression = CM_dxt3;
+    break;
+  case KTX2_BC3_UNORM_BLOCK:
+    compression = CM_dxt5;
+    break;
+  case KTX2_BC3_SRGB_BLOCK:
+    format = F_srgb_alpha;
+    compression = CM_dxt5;
+    break;
+  case KTX2_BC4_UNORM_BLOCK:
+    format = F_red;
+    compression = CM_rgtc;
+    break;
+  case KTX2_BC5_UNORM_BLOCK:
+    format = F_rg;
+    compression = CM_rgtc;
+    break;
+  case KTX2_BC6H_UFLOAT_BLOCK:
+    type = T_half_float;
+    format = F_rgb16;
+    compression = CM_bptc;
+    break;
+  case KTX2_BC7_UNORM_BLOCK:
+    compression = CM_bptc;
+    break;
+  case KTX2_BC7_SRGB_BLOCK:
+    format = F_srgb_alpha;
+    compression = CM_bptc;
+    break;
+  case KTX2_ETC2_R8G8B8_UNORM_BLOCK:
+    format = F_rgb;
+    compression = CM_etc2;
+    break;
+  case KTX2_ETC2_R8G8B8_SRGB_BLOCK:
+    format = F_srgb;
+    compression = CM_etc2;
+    break;
+  case KTX2_ETC2_R8G8B8A1_UNORM_BLOCK:
+    format = F_rgbm;
+    compression = CM_etc2;
+    break;
+  case KTX2_ETC2_R8G8B8A8_UNORM_BLOCK:
+    compression = CM_etc2;
+    break;
+  case KTX2_ETC2_R8G8B8A8_SRGB_BLOCK:
+    format = F_srgb_alpha;
+    compression = CM_etc2;
+    break;
+  case KTX2_EAC_R11_UNORM_BLOCK:
+    format = F_red;
+    compression = CM_eac;
+    break;
+  case KTX2_EAC_R11G11_UNORM_BLOCK:
+    format = F_rg;
+    compression = CM_eac;
+    break;
+
+  case KTX2_UNDEFINED:
+    if (basis) {
+      // The format was chosen above.
+      break;
+    }
+    // fall through
+
+  default:
+    gobj_cat.error()
+      << filename << " has unsupported format " << vk_format << "\n";
+    return false;
+  }
+
+  TextureType texture_type;
+  int num_pages;
+  if (depth > 0) {
+    if (num_layers > 0 || num_faces > 1) {
+      gobj_cat.error()
+        << filename << " is an array of 3-D textures, which is not supported\n";
+      return false;
+    }
+    texture_type = TT_3d_texture;
+    num_pages = depth;
+
+  } else if (num_faces > 1) {
+    if (num_faces != 6) {
+      gobj_cat.error()
+        << filename << " has " << num_faces << " cube map faces, expected 6\n";
+      return false;
+    }
+    if (width != height) {
+      gobj_cat.error()
+        << filename << " is cube map, but does not have square dimensions\n";
+      return false;
+    }
+    if (num_layers > 0) {
+      depth = num_layers * 6;
+      texture_type = TT_cube_map_array;
+    } else {
+      depth = 6;
+      texture_type = TT_cube_map;
+    }
+    num_pages = depth;
+
+  } else if (height > 0) {
+    if (num_layers > 0) {
+      depth = num_layers;
+      texture_type = TT_2d_texture_array;
+    } else {
+      depth = 1;
+      texture_type = TT_2d_texture;
+    }
+    num_pages = depth;
+
+  } else if (width > 0) {
+    depth = 1;
+    if (num_layers > 0) {
+      height = num_layers;
+      texture_type = TT_1d_texture_array;
+    } else {
+      height = 1;
+      texture_type = TT_1d_texture;
+    }
+    num_pages = 1;
+
+  } else {
+    gobj_cat.error()
+      << filename << " has zero size\n";
+    return false;
+  }
+
+  do_setup_texture(cdata, texture_type, width, height, depth, type, format);
+
+  cdata->_orig_file_x_size = cdata->_x_size;
+  cdata->_orig_file_y_size = cdata->_y_size;
+  cdata->_compression = compression;
+  cdata->_ram_image_compression = compression;
+
+  if (!header_only && basis) {
+#ifdef HAVE_BASISU
+    if (!basis_transcoder.start_transcoding()) {
+      gobj_cat.error()
+        << filename << " contains invalid Basis Universal data.\n";
+      return false;
+    }
+    for (size_t n = 0; n < levels.size(); ++n) {
+      PTA_uchar image;
+      size_t page_size;
+      if (!ktx2_transcode_basis_level(basis_transcoder, (uint32_t)n,
+                                      basis_format, image, page_size)) {
+        gobj_cat.error()
+          << filename << " has invalid Basis Universal data for mipmap level "
+          << n << "\n";
+        return false;
+      }
+      if (swap_bgr) {
+        unsigned char *end = image.p() + image.size();
+        for (unsigned char *p = image.p(); p < end; p += 4) {
+          swap(p[0], p[2]);
+        }
+      }
+      do_set_ram_mipmap_image(cdata, (int)n, std::move(image), page_size);
+    }
+#endif  // HAVE_BASISU
+
+  } else if (!header_only) {
+    switch (supercompression) {
+    case KTX2_SS_none:
+      break;
+
+#ifdef HAVE_ZSTD
+    case KTX2_SS_zstd:
+      break;
+#endif
+
+#ifdef HAVE_ZLIB
+    case KTX2_SS_zlib:
+      break;
+#endif
+
+    default:
+      gobj_cat.error()
+        << filename << " uses unsupported supercompression scheme "
+        << supercompression << "\n";
+      return false;
+    }
+
+    // The levels are stored smallest first.  Read them in file order, so
+    // that we never need to seek back in the stream.
+    pvector<int> order(levels.size());
+    for (size_t n = 0; n < levels.size(); ++n) {
+      order[n] = (int)n;
+    }
+    std::sort(order.begin(), order.end(), [&] (int a, int b) {
+      return levels[a]._offset < levels[b]._offset;
+    });
+
+    for (int n : order) {
+      const LevelIndex &level = levels[n];
+      if (level._offset < pos) {
+        gobj_cat.error()
+          << filename << " has overlapping data for mipmap level " << n << "\n";
+        return false;
+      }
+      ktx.skip_bytes(level._offset - pos);
+      pos = level._offset + level._size;
+
+      size_t image_size = (size_t)level._size;
+      if (supercompression != KTX2_SS_none) {
+        image_size = (size_t)level._uncompressed_size;
+      }
+
+      // The pages of a mipmap level are stored one after the other, with
+      // tightly packed rows, just as we store them.
+      size_t level_pages = (texture_type == TT_3d_texture)
+        ? (size_t)do_get_expected_mipmap_z_size(cdata, n) : (size_t)num_pages;
+      size_t page_size = image_size / level_pages;
+      if (compression == CM_off) {
+        page_size = do_get_expected_ram_mipmap_page_size(cdata, n);
+      }
+      if (image_size == 0 || page_size * level_pages != image_size) {
+        gobj_cat.error()
+          << filename << " has invalid image size " << image_size
+          << " for mipmap level " << n << "\n";
+        return false;
+      }
+
+      PTA_uchar image = PTA_uchar::empty_array(image_size);
+      if (supercompression == KTX2_SS_none) {
+        if (ktx.extract_bytes(image.p(), image_size) != image_size) {
+          break;
+        }
+      } else {
+        vector_uchar data = ktx.extract_bytes((size_t)level._size);
+        if (data.size() != level._size) {
+          break;
+        }
+        if (!ktx2_decompress_level(supercompression, data, image.p(), image_size)) {
+          gobj_cat.error()
+            << filename << " has invalid supercompressed data for mipmap level "
+            << n << "\n";
+          return false;
+        }
+      }
+
+      if (swap_bgr) {
+        // Swap red and blue channels to match Panda conventions.
+        unsigned char *begin = image.p();
+        const unsigned char *end = image.p() + image.size();
+        size_t skip = cdata->_num_components;
+        nassertr(skip == 3 || skip == 4, false);
+
+        switch (cdata->_component_width) {
+        case 1:
+          for (unsigned char *p = begin; p < end; p += skip) {
+            swap(p[0], p[2]);
+          }
+          break;
+        case 2:
+          for (short *p = (short *)begin; p < (short *)end; p += skip) {
+            swap(p[0], p[2]);
+          }
+          break;
+        case 4:
+          for (int *p = (int *)begin; p < (int *)end; p += skip) {
+            swap(p[0], p[2]);
+          }
+          break;
+        default:
+          nassert_raise("unexpected channel count");
+          return false;
+        }
+      }
+
+      do_set_ram_mipmap_image(cdata, n, std::move(image), page_size);
+    }
+  }
+
+  if (!header_only) {
+    cdata->_has_read_pages = true;
+    cdata->_has_read_mipmaps = true;
+    cdata->_num_mipmap_levels_read = cdata->_ram_images.size();
+
+    if (num_mipmap_levels == 0 && compression == CM_off && !in.fail()) {
+      // The file asks for the mipmaps to be generated.
+      do_generate_ram_mipmap_images(cdata, false);
+    }
+  }
+
+  if (in.fail()) {
+    gobj_cat.error()
+      << filename << ": truncated KTX2 file.\n";
+    return false;
+  }
+
+  cdata->_loaded_from_image = true;
+  cdata->_loaded_from_txo = true;
+
+  return true;
+}
+
 /**
  * Internal method to write a series of pages and/or mipmap levels to disk
  * files.
@@ -6065,7 +7508,14 @@ do_compress_ram_image(CData *cdata, Texture::CompressionMode compression,
     return false;
   }
 
-  if (compression == CM_on) {
+  if (compression == CM_on && cdata->_num_components == 3 &&
+      (cdata->_component_type == T_float || cdata->_component_type == T_half_float)) {
+    // Only BC6H can hold floating-point colors.
+    if (gsg == nullptr || gsg->get_supports_compressed_texture_format(CM_bptc)) {
+      compression = CM_bptc;
+    }
+
+  } else if (compression == CM_on) {
     // Select an appropriate compression mode automatically.
     switch (cdata->_format) {
     case Texture::F_rgbm:
@@ -6127,78 +7577,6 @@ do_compress_ram_image(CData *cdata, Texture::CompressionMode compression,
     }
   }
 
-  if (compression == CM_rgtc) {
-    // We should compress RGTC ourselves, as squish does not support it.
-    if (cdata->_component_type != T_unsigned_byte) {
-      return false;
-    }
-
-    if (!do_has_all_ram_mipmap_images(cdata)) {
-      // If we're about to compress the RAM image, we should ensure that we
-      // have all of the mipmap levels first.
-      do_generate_ram_mipmap_images(cdata, false);
-    }
-
-    RamImages compressed_ram_images;
-    compressed_ram_images.resize(cdata->_ram_images.size());
-
-    for (size_t n = 0; n < cdata->_ram_images.size(); ++n) {
-      const RamImage *uncompressed_image = &cdata->_ram_images[n];
-
-      int x_size = do_get_expected_mipmap_x_size(cdata, n);
-      int y_size = do_get_expected_mipmap_y_size(cdata, n);
-      int num_pages = do_get_expected_mipmap_num_pages(cdata, n);
-
-      // It is important that we handle image sizes that aren't a multiple of
-      // the block size, since this method may be used to compress mipmaps,
-      // which go all the way to 1x1.  Pad the image if necessary.
-      RamImage temp_image;
-      if ((x_size | y_size) & 0x3) {
-        int virtual_x_size = x_size;
-        int virtual_y_size = y_size;
-        x_size = (x_size + 3) & ~0x3;
-        y_size = (y_size + 3) & ~0x3;
-
-        temp_image._page_size = x_size * y_size * cdata->_num_components;
-        temp_image._image = PTA_uchar::empty_array(temp_image._page_size * num_pages);
-
-        for (int z = 0; z < num_pages; ++z) {
-          unsigned char *dest = temp_image._image.p() + z * temp_image._page_size;
-          unsigned const char *src = uncompressed_image->_image.p() + z * uncompressed_image->_page_size;
-
-          for (int y = 0; y < virtual_y_size; ++y) {
-            memcpy(dest, src, virtual_x_size);
-            src += virtual_x_size;
-            dest += x_size;
-          }
-        }
-
-        uncompressed_image = &temp_image;
-      }
-
-      // Create a new image to hold the compressed texture pages.
-      RamImage &compressed_image = compressed_ram_images[n];
-      compressed_image._page_size = (x_size * y_size * cdata->_num_components) >> 1;
-      compressed_image._image = PTA_uchar::empty_array(compressed_image._page_size * num_pages);
-
-      if (cdata->_num_components == 1) {
-        do_compress_ram_image_bc4(*uncompressed_image, compressed_image,
-                                  x_size, y_size, num_pages);
-      } else if (cdata->_num_components == 2) {
-        do_compress_ram_image_bc5(*uncompressed_image, compressed_image,
-                                  x_size, y_size, num_pages);
-      } else {
-        // Invalid.
-        return false;
-      }
-    }
-
-    cdata->_ram_images.swap(compressed_ram_images);
-    cdata->_ram_image_compression = CM_rgtc;
-    return true;
-  }
-
-#ifdef HAVE_SQUISH
   // Choose an appropriate quality level.
   if (quality_level == Texture::QL_default) {
     quality_level = cdata->_quality_level;
@@ -6207,56 +7585,7 @@ do_compress_ram_image(CData *cdata, Texture::CompressionMode compression,
     quality_level = texture_quality_level;
   }
 
-  if (cdata->_texture_type != TT_3d_texture &&
-      cdata->_texture_type != TT_2d_texture_array &&
-      cdata->_component_type == T_unsigned_byte) {
-    int squish_flags = 0;
-    switch (compression) {
-    case CM_dxt1:
-      squish_flags |= squish::kDxt1;
-      break;
-
-    case CM_dxt3:
-      squish_flags |= squish::kDxt3;
-      break;
-
-    case CM_dxt5:
-      squish_flags |= squish::kDxt5;
-      break;
-
-    default:
-      break;
-    }
-
-    if (squish_flags != 0) {
-      // This compression mode is supported by squish; use it.
-      switch (quality_level) {
-      case QL_fastest:
-        squish_flags |= squish::kColourRangeFit;
-        break;
-
-      case QL_normal:
-        // ColourClusterFit is just too slow for everyday use.
-        squish_flags |= squish::kColourRangeFit;
-        // squish_flags |= squish::kColourClusterFit;
-        break;
-
-      case QL_best:
-        squish_flags |= squish::kColourIterativeClusterFit;
-        break;
-
-      default:
-        break;
-      }
-
-      if (do_squish(cdata, compression, squish_flags)) {
-        return true;
-      }
-    }
-  }
-#endif  // HAVE_SQUISH
-
-  return false;
+  return do_compress_ram_image_bc(cdata, compression, quality_level);
 }
 
 /**
@@ -6266,496 +7595,183 @@ bool Texture::
 do_uncompress_ram_image(CData *cdata) {
   nassertr(!cdata->_ram_images.empty(), false);
 
-  if (cdata->_ram_image_compression == CM_rgtc) {
-    // We should decompress RGTC ourselves, as squish doesn't support it.
-    RamImages uncompressed_ram_images;
-    uncompressed_ram_images.resize(cdata->_ram_images.size());
-
-    for (size_t n = 0; n < cdata->_ram_images.size(); ++n) {
-      const RamImage &compressed_image = cdata->_ram_images[n];
-
-      int x_size = do_get_expected_mipmap_x_size(cdata, n);
-      int y_size = do_get_expected_mipmap_y_size(cdata, n);
-      int num_pages = do_get_expected_mipmap_num_pages(cdata, n);
-
-      RamImage &uncompressed_image = uncompressed_ram_images[n];
-      uncompressed_image._page_size = do_get_expected_ram_mipmap_page_size(cdata, n);
-      uncompressed_image._image = PTA_uchar::empty_array(uncompressed_image._page_size * num_pages);
+  return do_uncompress_ram_image_bc(cdata);
+}
 
-      if (cdata->_num_components == 1) {
-        do_uncompress_ram_image_bc4(compressed_image, uncompressed_image,
-                                    x_size, y_size, num_pages);
-      } else if (cdata->_num_components == 2) {
-        do_uncompress_ram_image_bc5(compressed_image, uncompressed_image,
-                                    x_size, y_size, num_pages);
-      } else {
-        // Invalid.
-        return false;
-      }
-    }
-    cdata->_ram_images.swap(uncompressed_ram_images);
-    cdata->_ram_image_compression = CM_off;
-    return true;
+/**
+ * Compresses the RAM image(s) using the BlockCompressor.  Each row of blocks
+ * is compressed independently, so that the work can be spread across several
+ * threads; see texture-compress-num-threads.  Returns false if the indicated
+ * compression mode is not supported for this texture.
+ */
+bool Texture::
+do_compress_ram_image_bc(CData *cdata, CompressionMode compression,
+                         QualityLevel quality_level) {
+  BlockCompressor::BlockFormat format;
+  if (compression == CM_dxt2 || compression == CM_dxt4 ||
+      !get_block_format(compression, cdata->_num_components,
+                        cdata->_component_type, format)) {
+    return false;
+  }
+  if (cdata->_texture_type == TT_3d_texture && compression != CM_rgtc) {
+    // Graphics cards don't generally support these formats for 3-D textures.
+    return false;
   }
 
-#ifdef HAVE_SQUISH
-  if (cdata->_texture_type != TT_3d_texture &&
-      cdata->_texture_type != TT_2d_texture_array &&
-      cdata->_component_type == T_unsigned_byte) {
-    int squish_flags = 0;
-    switch (cdata->_ram_image_compression) {
-    case CM_dxt1:
-      squish_flags |= squish::kDxt1;
-      break;
+  if (!do_has_all_ram_mipmap_images(cdata)) {
+    // If we're about to compress the RAM image, we should ensure that we have
+    // all of the mipmap levels first.
+    do_generate_ram_mipmap_images(cdata, false);
+  }
 
-    case CM_dxt3:
-      squish_flags |= squish::kDxt3;
-      break;
+  size_t block_size = BlockCompressor::get_block_size(format);
+  int num_components = cdata->_num_components;
+  ComponentType component_type = cdata->_component_type;
+  bool rgtc = (compression == CM_rgtc);
 
-    case CM_dxt5:
-      squish_flags |= squish::kDxt5;
-      break;
+  RamImages compressed_ram_images(cdata->_ram_images.size());
+  pvector<TextureBlockRow> rows;
+  for (size_t n = 0; n < cdata->_ram_images.size(); ++n) {
+    const RamImage &uncompressed_image = cdata->_ram_images[n];
+    int x_size = do_get_expected_mipmap_x_size(cdata, n);
+    int y_size = do_get_expected_mipmap_y_size(cdata, n);
+    int num_pages = do_get_expected_mipmap_num_pages(cdata, n);
+    int x_blocks = (x_size + 3) >> 2;
+    int y_blocks = (y_size + 3) >> 2;
 
-    default:
-      break;
-    }
+    RamImage &compressed_image = compressed_ram_images[n];
+    compressed_image._page_size = (size_t)x_blocks * y_blocks * block_size;
+    compressed_image._image = PTA_uchar::empty_array(compressed_image._page_size * num_pages);
 
-    if (squish_flags != 0) {
-      // This compression mode is supported by squish; use it.
-      if (do_unsquish(cdata, squish_flags)) {
-        return true;
+    for (int z = 0; z < num_pages; ++z) {
+      for (int y = 0; y < y_blocks; ++y) {
+        TextureBlockRow row;
+        row._src = uncompressed_image._image.p() + z * uncompressed_image._page_size;
+        row._dest = compressed_image._image.p() + z * compressed_image._page_size +
+                    (size_t)y * x_blocks * block_size;
+        row._x_size = x_size;
+        row._y_size = y_size;
+        row._y = y;
+        rows.push_back(row);
+      }
+    }
+  }
+
+  process_texture_rows("texture_compress", texture_compress_num_threads,
+                       rows.size(), [&] (size_t i) {
+    const TextureBlockRow &row = rows[i];
+    int x_blocks = (row._x_size + 3) >> 2;
+    unsigned char *dest = row._dest;
+    for (int bx = 0; bx < x_blocks; ++bx) {
+      if (format == BlockCompressor::BF_bc6h) {
+        uint16_t rgb[48];
+        gather_texture_block_hdr(row, bx, component_type, rgb);
+        BlockCompressor::compress_block_bc6h(rgb, dest, quality_level);
+      } else {
+        unsigned char rgba[64];
+        gather_texture_block(row, bx, num_components, rgtc, rgba);
+        BlockCompressor::compress_block(format, rgba, dest, quality_level);
       }
+      dest += block_size;
     }
-  }
-#endif  // HAVE_SQUISH
-  return false;
-}
+  });
 
-/**
- * Compresses a RAM image using BC4 compression.
- */
-void Texture::
-do_compress_ram_image_bc4(const RamImage &uncompressed_image,
-                          RamImage &compressed_image,
-                          int x_size, int y_size, int num_pages) {
-  int x_blocks = (x_size >> 2);
-  int y_blocks = (y_size >> 2);
-
-  // NB. This algorithm isn't fully optimal, since it doesn't try to make use
-  // of the secondary interpolation mode supported by BC4.  This is not
-  // important for most textures, but it may be added in the future.
-
-  nassertv((size_t)x_blocks * (size_t)y_blocks * 4 * 4 <= uncompressed_image._page_size);
-  nassertv((size_t)x_size * (size_t)y_size == uncompressed_image._page_size);
-
-  static const int remap[] = {1, 7, 6, 5, 4, 3, 2, 0};
-
-  for (int z = 0; z < num_pages; ++z) {
-    unsigned char *dest = compressed_image._image.p() + z * compressed_image._page_size;
-    unsigned const char *src = uncompressed_image._image.p() + z * uncompressed_image._page_size;
-
-    // Convert one 4 x 4 block at a time.
-    for (int y = 0; y < y_blocks; ++y) {
-      for (int x = 0; x < x_blocks; ++x) {
-        int a, b, c, d;
-        float fac, add;
-        unsigned char minv, maxv;
-        unsigned const char *blk = src;
-
-        // Find the minimum and maximum value in the block.
-        minv = blk[0];
-        maxv = blk[0];
-        minv = min(blk[1], minv); maxv = max(blk[1], maxv);
-        minv = min(blk[2], minv); maxv = max(blk[2], maxv);
-        minv = min(blk[3], minv); maxv = max(blk[3], maxv);
-        blk += x_size;
-        minv = min(blk[0], minv); maxv = max(blk[0], maxv);
-        minv = min(blk[1], minv); maxv = max(blk[1], maxv);
-        minv = min(blk[2], minv); maxv = max(blk[2], maxv);
-        minv = min(blk[3], minv); maxv = max(blk[3], maxv);
-        blk += x_size;
-        minv = min(blk[0], minv); maxv = max(blk[0], maxv);
-        minv = min(blk[1], minv); maxv = max(blk[1], maxv);
-        minv = min(blk[2], minv); maxv = max(blk[2], maxv);
-        minv = min(blk[3], minv); maxv = max(blk[3], maxv);
-        blk += x_size;
-        minv = min(blk[0], minv); maxv = max(blk[0], maxv);
-        minv = min(blk[1], minv); maxv = max(blk[1], maxv);
-        minv = min(blk[2], minv); maxv = max(blk[2], maxv);
-        minv = min(blk[3], minv); maxv = max(blk[3], maxv);
-
-        // Now calculate the index for each pixel.
-        blk = src;
-        if (maxv > minv) {
-          fac = 7.5f / (maxv - minv);
-        } else {
-          fac = 0;
-        }
-        add = -minv * fac;
-        a = (remap[(int)(blk[0] * fac + add)])
-          | (remap[(int)(blk[1] * fac + add)] << 3)
-          | (remap[(int)(blk[2] * fac + add)] << 6)
-          | (remap[(int)(blk[3] * fac + add)] << 9);
-        blk += x_size;
-        b = (remap[(int)(blk[0] * fac + add)] << 4)
-          | (remap[(int)(blk[1] * fac + add)] << 7)
-          | (remap[(int)(blk[2] * fac + add)] << 10)
-          | (remap[(int)(blk[3] * fac + add)] << 13);
-        blk += x_size;
-        c = (remap[(int)(blk[0] * fac + add)])
-          | (remap[(int)(blk[1] * fac + add)] << 3)
-          | (remap[(int)(blk[2] * fac + add)] << 6)
-          | (remap[(int)(blk[3] * fac + add)] << 9);
-        blk += x_size;
-        d = (remap[(int)(blk[0] * fac + add)] << 4)
-          | (remap[(int)(blk[1] * fac + add)] << 7)
-          | (remap[(int)(blk[2] * fac + add)] << 10)
-          | (remap[(int)(blk[3] * fac + add)] << 13);
-
-        *(dest++) = maxv;
-        *(dest++) = minv;
-        *(dest++) = a & 0xff;
-        *(dest++) = (a >> 8) | (b & 0xf0);
-        *(dest++) = b >> 8;
-        *(dest++) = c & 0xff;
-        *(dest++) = (c >> 8) | (d & 0xf0);
-        *(dest++) = d >> 8;
-
-        // Advance to the beginning of the next 4x4 block.
-        src += 4;
-      }
-      src += x_size * 3;
-    }
-    Thread::consider_yield();
-  }
+  cdata->_ram_images.swap(compressed_ram_images);
+  cdata->_ram_image_compression = compression;
+  return true;
 }
 
 /**
- * Compresses a RAM image using BC5 compression.
+ * Decompresses a RAM image that was compressed in one of the formats
+ * supported by the BlockCompressor.  Returns false if the image is in another
+ * format, or if it could not be decoded.
  */
-void Texture::
-do_compress_ram_image_bc5(const RamImage &uncompressed_image,
-                          RamImage &compressed_image,
-                          int x_size, int y_size, int num_pages) {
-  int x_blocks = (x_size >> 2);
-  int y_blocks = (y_size >> 2);
-  int stride = x_size * 2;
-
-  // BC5 uses the same compression algorithm as BC4, except repeated for two
-  // channels.
-
-  nassertv((size_t)x_blocks * (size_t)y_blocks * 4 * 4 * 2 <= uncompressed_image._page_size);
-  nassertv((size_t)stride * (size_t)y_size == uncompressed_image._page_size);
-
-  static const int remap[] = {1, 7, 6, 5, 4, 3, 2, 0};
-
-  for (int z = 0; z < num_pages; ++z) {
-    unsigned char *dest = compressed_image._image.p() + z * compressed_image._page_size;
-    unsigned const char *src = uncompressed_image._image.p() + z * uncompressed_image._page_size;
-
-    // Convert one 4 x 4 block at a time.
-    for (int y = 0; y < y_blocks; ++y) {
-      for (int x = 0; x < x_blocks; ++x) {
-        int a, b, c, d;
-        float fac, add;
-        unsigned char minv, maxv;
-        unsigned const char *blk = src;
-
-        // Find the minimum and maximum red value in the block.
-        minv = blk[0];
-        maxv = blk[0];
-        minv = min(blk[2], minv); maxv = max(blk[2], maxv);
-        minv = min(blk[4], minv); maxv = max(blk[4], maxv);
-        minv = min(blk[6], minv); maxv = max(blk[6], maxv);
-        blk += stride;
-        minv = min(blk[0], minv); maxv = max(blk[0], maxv);
-        minv = min(blk[2], minv); maxv = max(blk[2], maxv);
-        minv = min(blk[4], minv); maxv = max(blk[4], maxv);
-        minv = min(blk[6], minv); maxv = max(blk[6], maxv);
-        blk += stride;
-        minv = min(blk[0], minv); maxv = max(blk[0], maxv);
-        minv = min(blk[2], minv); maxv = max(blk[2], maxv);
-        minv = min(blk[4], minv); maxv = max(blk[4], maxv);
-        minv = min(blk[6], minv); maxv = max(blk[6], maxv);
-        blk += stride;
-        minv = min(blk[0], minv); maxv = max(blk[0], maxv);
-        minv = min(blk[2], minv); maxv = max(blk[2], maxv);
-        minv = min(blk[4], minv); maxv = max(blk[4], maxv);
-        minv = min(blk[6], minv); maxv = max(blk[6], maxv);
-
-        // Now calculate the index for each pixel.
-        if (maxv > minv) {
-          fac = 7.5f / (maxv - minv);
-        } else {
-          fac = 0;
-        }
-        add = -minv * fac;
-        blk = src;
-        a = (remap[(int)(blk[0] * fac + add)])
-          | (remap[(int)(blk[2] * fac + add)] << 3)
-          | (remap[(int)(blk[4] * fac + add)] << 6)
-          | (remap[(int)(blk[6] * fac + add)] << 9);
-        blk += stride;
-        b = (remap[(int)(blk[0] * fac + add)] << 4)
-          | (remap[(int)(blk[2] * fac + add)] << 7)
-          | (remap[(int)(blk[4] * fac + add)] << 10)
-          | (remap[(int)(blk[6] * fac + add)] << 13);
-        blk += stride;
-        c = (remap[(int)(blk[0] * fac + add)])
-          | (remap[(int)(blk[2] * fac + add)] << 3)
-          | (remap[(int)(blk[4] * fac + add)] << 6)
-          | (remap[(int)(blk[6] * fac + add)] << 9);
-        blk += stride;
-        d = (remap[(int)(blk[0] * fac + add)] << 4)
-          | (remap[(int)(blk[2] * fac + add)] << 7)
-          | (remap[(int)(blk[4] * fac + add)] << 10)
-          | (remap[(int)(blk[6] * fac + add)] << 13);
-
-        *(dest++) = maxv;
-        *(dest++) = minv;
-        *(dest++) = a & 0xff;
-        *(dest++) = (a >> 8) | (b & 0xf0);
-        *(dest++) = b >> 8;
-        *(dest++) = c & 0xff;
-        *(dest++) = (c >> 8) | (d & 0xf0);
-        *(dest++) = d >> 8;
-
-        // Find the minimum and maximum green value in the block.
-        blk = src + 1;
-        minv = blk[0];
-        maxv = blk[0];
-        minv = min(blk[2], minv); maxv = max(blk[2], maxv);
-        minv = min(blk[4], minv); maxv = max(blk[4], maxv);
-        minv = min(blk[6], minv); maxv = max(blk[6], maxv);
-        blk += stride;
-        minv = min(blk[0], minv); maxv = max(blk[0], maxv);
-        minv = min(blk[2], minv); maxv = max(blk[2], maxv);
-        minv = min(blk[4], minv); maxv = max(blk[4], maxv);
-        minv = min(blk[6], minv); maxv = max(blk[6], maxv);
-        blk += stride;
-        minv = min(blk[0], minv); maxv = max(blk[0], maxv);
-        minv = min(blk[2], minv); maxv = max(blk[2], maxv);
-        minv = min(blk[4], minv); maxv = max(blk[4], maxv);
-        minv = min(blk[6], minv); maxv = max(blk[6], maxv);
-        blk += stride;
-        minv = min(blk[0], minv); maxv = max(blk[0], maxv);
-        minv = min(blk[2], minv); maxv = max(blk[2], maxv);
-        minv = min(blk[4], minv); maxv = max(blk[4], maxv);
-        minv = min(blk[6], minv); maxv = max(blk[6], maxv);
-
-        // Now calculate the index for each pixel.
-        if (maxv > minv) {
-          fac = 7.5f / (maxv - minv);
-        } else {
-          fac = 0;
-        }
-        add = -minv * fac;
-        blk = src + 1;
-        a = (remap[(int)(blk[0] * fac + add)])
-          | (remap[(int)(blk[2] * fac + add)] << 3)
-          | (remap[(int)(blk[4] * fac + add)] << 6)
-          | (remap[(int)(blk[6] * fac + add)] << 9);
-        blk += stride;
-        b = (remap[(int)(blk[0] * fac + add)] << 4)
-          | (remap[(int)(blk[2] * fac + add)] << 7)
-          | (remap[(int)(blk[4] * fac + add)] << 10)
-          | (remap[(int)(blk[6] * fac + add)] << 13);
-        blk += stride;
-        c = (remap[(int)(blk[0] * fac + add)])
-          | (remap[(int)(blk[2] * fac + add)] << 3)
-          | (remap[(int)(blk[4] * fac + add)] << 6)
-          | (remap[(int)(blk[6] * fac + add)] << 9);
-        blk += stride;
-        d = (remap[(int)(blk[0] * fac + add)] << 4)
-          | (remap[(int)(blk[2] * fac + add)] << 7)
-          | (remap[(int)(blk[4] * fac + add)] << 10)
-          | (remap[(int)(blk[6] * fac + add)] << 13);
-
-        *(dest++) = maxv;
-        *(dest++) = minv;
-        *(dest++) = a & 0xff;
-        *(dest++) = (a >> 8) | (b & 0xf0);
-        *(dest++) = b >> 8;
-        *(dest++) = c & 0xff;
-        *(dest++) = (c >> 8) | (d & 0xf0);
-        *(dest++) = d >> 8;
-
-        // Advance to the beginning of the next 4x4 block.
-        src += 8;
-      }
-      src += stride * 3;
-    }
-    Thread::consider_yield();
+bool Texture::
+do_uncompress_ram_image_bc(CData *cdata) {
+  BlockCompressor::BlockFormat format;
+  if (!get_block_format(cdata->_ram_image_compression, cdata->_num_components,
+                        cdata->_component_type, format)) {
+    return false;
   }
-}
 
-/**
- * Decompresses a RAM image compressed using BC4.
- */
-void Texture::
-do_uncompress_ram_image_bc4(const RamImage &compressed_image,
-                            RamImage &uncompressed_image,
-                            int x_size, int y_size, int num_pages) {
-  int x_blocks = (x_size >> 2);
-  int y_blocks = (y_size >> 2);
-
-  for (int z = 0; z < num_pages; ++z) {
-    unsigned char *dest = uncompressed_image._image.p() + z * uncompressed_image._page_size;
-    unsigned const char *src = compressed_image._image.p() + z * compressed_image._page_size;
-
-    // Unconvert one 4 x 4 block at a time.
-    uint8_t tbl[8];
-    for (int y = 0; y < y_blocks; ++y) {
-      for (int x = 0; x < x_blocks; ++x) {
-        unsigned char *blk = dest;
-        tbl[0] = src[0];
-        tbl[1] = src[1];
-        if (tbl[0] > tbl[1]) {
-          tbl[2] = (tbl[0] * 6 + tbl[1] * 1) / 7.0f;
-          tbl[3] = (tbl[0] * 5 + tbl[1] * 2) / 7.0f;
-          tbl[4] = (tbl[0] * 4 + tbl[1] * 3) / 7.0f;
-          tbl[5] = (tbl[0] * 3 + tbl[1] * 4) / 7.0f;
-          tbl[6] = (tbl[0] * 2 + tbl[1] * 5) / 7.0f;
-          tbl[7] = (tbl[0] * 1 + tbl[1] * 6) / 7.0f;
-        } else {
-          tbl[2] = (tbl[0] * 4 + tbl[1] * 1) / 5.0f;
-          tbl[3] = (tbl[0] * 3 + tbl[1] * 2) / 5.0f;
-          tbl[4] = (tbl[0] * 2 + tbl[1] * 3) / 5.0f;
-          tbl[5] = (tbl[0] * 1 + tbl[1] * 4) / 5.0f;
-          tbl[6] = 0;
-          tbl[7] = 255;
-        }
-        int v = src[2] + (src[3] << 8) + (src[4] << 16);
-        blk[0] = tbl[v & 0x7];
-        blk[1] = tbl[(v & 0x000038) >> 3];
-        blk[2] = tbl[(v & 0x0001c0) >> 6];
-        blk[3] = tbl[(v & 0x000e00) >> 9];
-        blk += x_size;
-        blk[0] = tbl[(v & 0x007000) >> 12];
-        blk[1] = tbl[(v & 0x038000) >> 15];
-        blk[2] = tbl[(v & 0x1c0000) >> 18];
-        blk[3] = tbl[(v & 0xe00000) >> 21];
-        blk += x_size;
-        v = src[5] + (src[6] << 8) + (src[7] << 16);
-        blk[0] = tbl[v & 0x7];
-        blk[1] = tbl[(v & 0x000038) >> 3];
-        blk[2] = tbl[(v & 0x0001c0) >> 6];
-        blk[3] = tbl[(v & 0x000e00) >> 9];
-        blk += x_size;
-        blk[0] = tbl[(v & 0x007000) >> 12];
-        blk[1] = tbl[(v & 0x038000) >> 15];
-        blk[2] = tbl[(v & 0x1c0000) >> 18];
-        blk[3] = tbl[(v & 0xe00000) >> 21];
-        src += 8;
-        dest += 4;
-      }
-      dest += x_size * 3;
+  size_t block_size = BlockCompressor::get_block_size(format);
+  int num_components = cdata->_num_components;
+  ComponentType component_type = cdata->_component_type;
+  bool rgtc = (cdata->_ram_image_compression == CM_rgtc);
+
+  RamImages uncompressed_ram_images(cdata->_ram_images.size());
+  pvector<TextureBlockRow> rows;
+  for (size_t n = 0; n < cdata->_ram_images.size(); ++n) {
+    const RamImage &compressed_image = cdata->_ram_images[n];
+    int x_size = do_get_expected_mipmap_x_size(cdata, n);
+    int y_size = do_get_expected_mipmap_y_size(cdata, n);
+    int num_pages = do_get_expected_mipmap_num_pages(cdata, n);
+    int x_blocks = (x_size + 3) >> 2;
+    int y_blocks = (y_size + 3) >> 2;
+    if (compressed_image._page_size < (size_t)x_blocks * y_blocks * block_size ||
+        compressed_image._image.size() < compressed_image._page_size * num_pages) {
+      gobj_cat.error()
+        << "Compressed RAM image of " << get_name() << " is too small\n";
+      return false;
     }
-    Thread::consider_yield();
-  }
-}
 
-/**
- * Decompresses a RAM image compressed using BC5.
- */
-void Texture::
-do_uncompress_ram_image_bc5(const RamImage &compressed_image,
-                            RamImage &uncompressed_image,
-                            int x_size, int y_size, int num_pages) {
-  int x_blocks = (x_size >> 2);
-  int y_blocks = (y_size >> 2);
-  int stride = x_size * 2;
-
-  for (int z = 0; z < num_pages; ++z) {
-    unsigned char *dest = uncompressed_image._image.p() + z * uncompressed_image._page_size;
-    unsigned const char *src = compressed_image._image.p() + z * compressed_image._page_size;
-
-    // Unconvert one 4 x 4 block at a time.
-    uint8_t red[8];
-    uint8_t grn[8];
-    for (int y = 0; y < y_blocks; ++y) {
-      for (int x = 0; x < x_blocks; ++x) {
-        unsigned char *blk = dest;
-        red[0] = src[0];
-        red[1] = src[1];
-        if (red[0] > red[1]) {
-          red[2] = (red[0] * 6 + red[1] * 1) / 7.0f;
-          red[3] = (red[0] * 5 + red[1] * 2) / 7.0f;
-          red[4] = (red[0] * 4 + red[1] * 3) / 7.0f;
-          red[5] = (red[0] * 3 + red[1] * 4) / 7.0f;
-          red[6] = (red[0] * 2 + red[1] * 5) / 7.0f;
-          red[7] = (red[0] * 1 + red[1] * 6) / 7.0f;
-        } else {
-          red[2] = (red[0] * 4 + red[1] * 1) / 5.0f;
-          red[3] = (red[0] * 3 + red[1] * 2) / 5.0f;
-          red[4] = (red[0] * 2 + red[1] * 3) / 5.0f;
-          red[5] = (red[0] * 1 + red[1] * 4) / 5.0f;
-          red[6] = 0;
-          red[7] = 255;
+    RamImage &uncompressed_image = uncompressed_ram_images[n];
+    uncompressed_image._page_size = do_get_expected_ram_mipmap_page_size(cdata, n);
+    uncompressed_image._image = PTA_uchar::empty_array(uncompressed_image._page_size * num_pages);
+
+    for (int z = 0; z < num_pages; ++z) {
+      for (int y = 0; y < y_blocks; ++y) {
+        TextureBlockRow row;
+        row._src = compressed_image._image.p() + z * compressed_image._page_size +
+                   (size_t)y * x_blocks * block_size;
+        row._dest = uncompressed_image._image.p() + z * uncompressed_image._page_size;
+        row._x_size = x_size;
+        row._y_size = y_size;
+        row._y = y;
+        rows.push_back(row);
+      }
+    }
+  }
+
+  // Each row records whether all of its blocks could be decoded.
+  pvector<unsigned char> row_ok(rows.size(), 1);
+  process_texture_rows("texture_compress", texture_compress_num_threads,
+                       rows.size(), [&] (size_t i) {
+    const TextureBlockRow &row = rows[i];
+    int x_blocks = (row._x_size + 3) >> 2;
+    const unsigned char *src = row._src;
+    for (int bx = 0; bx < x_blocks; ++bx) {
+      if (format == BlockCompressor::BF_bc6h) {
+        uint16_t rgb[48];
+        if (!BlockCompressor::decompress_block_bc6h(src, rgb)) {
+          row_ok[i] = 0;
+          return;
         }
-        grn[0] = src[8];
-        grn[1] = src[9];
-        if (grn[0] > grn[1]) {
-          grn[2] = (grn[0] * 6 + grn[1] * 1) / 7.0f;
-          grn[3] = (grn[0] * 5 + grn[1] * 2) / 7.0f;
-          grn[4] = (grn[0] * 4 + grn[1] * 3) / 7.0f;
-          grn[5] = (grn[0] * 3 + grn[1] * 4) / 7.0f;
-          grn[6] = (grn[0] * 2 + grn[1] * 5) / 7.0f;
-          grn[7] = (grn[0] * 1 + grn[1] * 6) / 7.0f;
-        } else {
-          grn[2] = (grn[0] * 4 + grn[1] * 1) / 5.0f;
-          grn[3] = (grn[0] * 3 + grn[1] * 2) / 5.0f;
-          grn[4] = (grn[0] * 2 + grn[1] * 3) / 5.0f;
-          grn[5] = (grn[0] * 1 + grn[1] * 4) / 5.0f;
-          grn[6] = 0;
-          grn[7] = 255;
+        scatter_texture_block_hdr(row, bx, component_type, rgb);
+      } else {
+        unsigned char rgba[64];
+        if (!BlockCompressor::decompress_block(format, src, rgba)) {
+          row_ok[i] = 0;
+          return;
         }
-        int r = src[2] + (src[3] << 8) + (src[4] << 16);
-        int g = src[10] + (src[11] << 8) + (src[12] << 16);
-        blk[0] = red[r & 0x7];
-        blk[1] = grn[g & 0x7];
-        blk[2] = red[(r & 0x000038) >> 3];
-        blk[3] = grn[(g & 0x000038) >> 3];
-        blk[4] = red[(r & 0x0001c0) >> 6];
-        blk[5] = grn[(g & 0x0001c0) >> 6];
-        blk[6] = red[(r & 0x000e00) >> 9];
-        blk[7] = grn[(g & 0x000e00) >> 9];
-        blk += stride;
-        blk[0] = red[(r & 0x007000) >> 12];
-        blk[1] = grn[(g & 0x007000) >> 12];
-        blk[2] = red[(r & 0x038000) >> 15];
-        blk[3] = grn[(g & 0x038000) >> 15];
-        blk[4] = red[(r & 0x1c0000) >> 18];
-        blk[5] = grn[(g & 0x1c0000) >> 18];
-        blk[6] = red[(r & 0xe00000) >> 21];
-        blk[7] = grn[(g & 0xe00000) >> 21];
-        blk += stride;
-        r = src[5] + (src[6] << 8) + (src[7] << 16);
-        g = src[13] + (src[14] << 8) + (src[15] << 16);
-        blk[0] = red[r & 0x7];
-        blk[1] = grn[g & 0x7];
-        blk[2] = red[(r & 0x000038) >> 3];
-        blk[3] = grn[(g & 0x000038) >> 3];
-        blk[4] = red[(r & 0x0001c0) >> 6];
-        blk[5] = grn[(g & 0x0001c0) >> 6];
-        blk[6] = red[(r & 0x000e00) >> 9];
-        blk[7] = grn[(g & 0x000e00) >> 9];
-        blk += stride;
-        blk[0] = red[(r & 0x007000) >> 12];
-        blk[1] = grn[(g & 0x007000) >> 12];
-        blk[2] = red[(r & 0x038000) >> 15];
-        blk[3] = grn[(g & 0x038000) >> 15];
-        blk[4] = red[(r & 0x1c0000) >> 18];
-        blk[5] = grn[(g & 0x1c0000) >> 18];
-        blk[6] = red[(r & 0xe00000) >> 21];
-        blk[7] = grn[(g & 0xe00000) >> 21];
-        src += 16;
-        dest += 8;
-      }
-      dest += stride * 3;
+        scatter_texture_block(row, bx, num_components, rgtc, rgba);
+      }
+      src += block_size;
+    }
+  });
+
+  for (unsigned char ok : row_ok) {
+    if (!ok) {
+      gobj_cat.warning()
+        << "Cannot decompress " << get_name() << ": it contains "
+        << cdata->_ram_image_compression << " blocks with a reserved mode\n";
+      return false;
     }
-    Thread::consider_yield();
   }
+
+  cdata->_ram_images.swap(uncompressed_ram_images);
+  cdata->_ram_image_compression = CM_off;
+  return true;
 }
 
 /**
@@ -7892,6 +8908,11 @@ do_generate_ram_mipmap_images(CData *cdata, bool allow_recompress) {
       << "Generating mipmap levels for " << *this << "\n";
   }
 
+  // The box filter without alpha weighting has its own, faster filters.
+  MipmapFilter filter = texture_mipmap_filter;
+  bool alpha_weighted = texture_mipmap_alpha_weighted && has_alpha(cdata->_format);
+  bool resample = (filter != MF_box || alpha_weighted);
+
   if (cdata->_texture_type == Texture::TT_3d_texture && cdata->_z_size != 1) {
     // Eek, a 3-D texture.
     int x_size = cdata->_x_size;
@@ -7900,8 +8921,13 @@ do_generate_ram_mipmap_images(CData *cdata, bool allow_recompress) {
     int n = 0;
     while (x_size > 1 || y_size > 1 || z_size > 1) {
       cdata->_ram_images.push_back(RamImage());
-      do_filter_3d_mipmap_level(cdata, cdata->_ram_images[n + 1], cdata->_ram_images[n],
-                                x_size, y_size, z_size);
+      if (resample) {
+        do_resample_mipmap_level(cdata, cdata->_ram_images[n + 1], cdata->_ram_images[n],
+                                 x_size, y_size, z_size, filter, alpha_weighted);
+      } else {
+        do_filter_3d_mipmap_level(cdata, cdata->_ram_images[n + 1], cdata->_ram_images[n],
+                                  x_size, y_size, z_size);
+      }
       x_size = max(x_size >> 1, 1);
       y_size = max(y_size >> 1, 1);
       z_size = max(z_size >> 1, 1);
@@ -7915,8 +8941,13 @@ do_generate_ram_mipmap_images(CData *cdata, bool allow_recompress) {
     int n = 0;
     while (x_size > 1 || y_size > 1) {
       cdata->_ram_images.push_back(RamImage());
-      do_filter_2d_mipmap_pages(cdata, cdata->_ram_images[n + 1], cdata->_ram_images[n],
-                                x_size, y_size);
+      if (resample) {
+        do_resample_mipmap_level(cdata, cdata->_ram_images[n + 1], cdata->_ram_images[n],
+                                 x_size, y_size, 1, filter, alpha_weighted);
+      } else {
+        do_filter_2d_mipmap_pages(cdata, cdata->_ram_images[n + 1], cdata->_ram_images[n],
+                                  x_size, y_size);
+      }
       x_size = max(x_size >> 1, 1);
       y_size = max(y_size >> 1, 1);
       ++n;
@@ -8007,6 +9038,59 @@ do_reload(CData *cdata) {
   return false;
 }
 
+/**
+ * Called by the TextureStreamingManager to replace the RAM image of this
+ * texture with the mipmap levels of the source texture starting at level n,
+ * shrinking the texture to the size of that level.  The source may be this
+ * texture itself, in which case its n largest levels are dropped.  Returns
+ * the number of bytes in the new RAM image.
+ */
+size_t Texture::
+stream_ram_mipmap_images(const Texture *source, int n) {
+  RamImages ram_images;
+  CompressionMode compression;
+  int x_size, y_size, z_size;
+  int num_components, component_width;
+  ComponentType component_type;
+  Format format;
+  {
+    CDReader cdata_source(source->_cycler);
+    n = std::max(std::min(n, (int)cdata_source->_ram_images.size() - 1), 0);
+    ram_images.assign(cdata_source->_ram_images.begin() + n,
+                      cdata_source->_ram_images.end());
+    compression = cdata_source->_ram_image_compression;
+    x_size = source->do_get_expected_mipmap_x_size(cdata_source, n);
+    y_size = source->do_get_expected_mipmap_y_size(cdata_source, n);
+    z_size = source->do_get_expected_mipmap_z_size(cdata_source, n);
+    num_components = cdata_source->_num_components;
+    component_width = cdata_source->_component_width;
+    component_type = cdata_source->_component_type;
+    format = cdata_source->_format;
+  }
+
+  CDWriter cdata(_cycler, true);
+  cdata->_x_size = x_size;
+  cdata->_y_size = y_size;
+  cdata->_z_size = z_size;
+  cdata->_pad_x_size = 0;
+  cdata->_pad_y_size = 0;
+  cdata->_pad_z_size = 0;
+  cdata->_num_components = num_components;
+  cdata->_component_width = component_width;
+  cdata->_component_type = component_type;
+  cdata->_format = format;
+  cdata->_ram_image_compression = compression;
+  cdata->_ram_images.swap(ram_images);
+  cdata->inc_properties_modified();
+  cdata->inc_image_modified();
+
+  size_t size = 0;
+  for (const RamImage &ram_image : cdata->_ram_images) {
+    size += ram_image._image.size();
+  }
+  return size;
+}
+
 /**
  * Returns true if there is a rawdata image that we have available to write to
  * the bam stream.  For a normal Texture, this is the same thing as
@@ -9362,7 +10446,8 @@ compare_images(const PNMImage &a, const PNMImage &b) {
 
 /**
  * Generates the next mipmap level from the previous one.  If there are
- * multiple pages (e.g.  a cube map), generates each page independently.
+ * multiple pages (e.g.  a cube map), generates each page independently.  The
+ * rows of all pages are divided among texture-mipmap-num-threads threads.
  *
  * x_size and y_size are the size of the previous level.  They need not be a
  * power of 2, or even a multiple of 2.
@@ -9404,6 +10489,10 @@ do_filter_2d_mipmap_pages(const CData *cdata,
       filter_component = &filter_2d_float;
       break;
 
+    case T_half_float:
+      filter_component = &filter_2d_half_float;
+      break;
+
     default:
       gobj_cat.error()
         << "Unable to generate mipmaps for 2D texture with component type "
@@ -9429,92 +10518,61 @@ do_filter_2d_mipmap_pages(const CData *cdata,
     --num_color_components;
   }
 
-  int num_pages = cdata->_z_size * cdata->_num_views;
-  for (int z = 0; z < num_pages; ++z) {
-    // For each level.
-    unsigned char *p = to._image.p() + z * to._page_size;
-    nassertv(p <= to._image.p() + to._image.size() + to._page_size);
-    const unsigned char *q = from._image.p() + z * from._page_size;
-    nassertv(q <= from._image.p() + from._image.size() + from._page_size);
-    if (y_size != 1) {
-      int y;
-      for (y = 0; y < y_size - 1; y += 2) {
-        // For each row.
-        nassertv(p == to._image.p() + z * to._page_size + (y / 2) * to_row_size);
-        nassertv(q == from._image.p() + z * from._page_size + y * row_size);
-        if (x_size != 1) {
-          int x;
-          for (x = 0; x < x_size - 1; x += 2) {
-            // For each pixel.
-            for (int c = 0; c < num_color_components; ++c) {
-              // For each component.
-              filter_component(p, q, pixel_size, row_size);
-            }
-            if (alpha) {
-              filter_alpha(p, q, pixel_size, row_size);
-            }
-            q += pixel_size;
-          }
-          if (x < x_size) {
-            // Skip the last odd pixel.
-            q += pixel_size;
-          }
-        } else {
-          // Just one pixel.
-          for (int c = 0; c < num_color_components; ++c) {
-            // For each component.
-            filter_component(p, q, 0, row_size);
-          }
-          if (alpha) {
-            filter_alpha(p, q, 0, row_size);
-          }
-        }
-        q += row_size;
-        Thread::consider_yield();
-      }
-      if (y < y_size) {
-        // Skip the last odd row.
-        q += row_size;
+  // When the previous level is only one pixel wide or high, the same pixel
+  // or row is used twice.
+  size_t pixel_step = (x_size != 1) ? pixel_size : 0;
+  size_t row_step = (y_size != 1) ? row_size : 0;
+
+  // The most common formats have a vectorized filter, which does most of
+  // each row; the per-component filter does the rest.
+  bool rgba8 = (filter_component == &filter_2d_unsigned_byte &&
+                pixel_size == 4 && x_size != 1);
+  bool rgba32f = (filter_component == &filter_2d_float &&
+                  pixel_size == 16 && x_size != 1);
+
+  // Every row of every page can be generated independently.
+  unsigned char *to_image = to._image.p();
+  size_t to_page_size = to._page_size;
+  const unsigned char *from_image = from._image.p();
+  size_t from_page_size = from._page_size;
+  nassertv(from._image.size() >= from_page_size * cdata->_z_size * cdata->_num_views);
+  nassertv(from_page_size >= (size_t)y_size * row_size);
+
+  size_t num_rows = (size_t)to_y_size * cdata->_z_size * cdata->_num_views;
+  process_texture_rows("texture_mipmap", texture_mipmap_num_threads,
+                       num_rows, [&] (size_t i) {
+    size_t z = i / to_y_size;
+    size_t y = i % to_y_size;
+    unsigned char *p = to_image + z * to_page_size + y * to_row_size;
+    const unsigned char *q = from_image + z * from_page_size + y * 2 * row_step;
+
+    int x = 0;
+    if (rgba8) {
+      x = filter_mipmap_row_rgba8(p, q, to_x_size, row_step, 0, false);
+    } else if (rgba32f) {
+      x = filter_mipmap_row_rgba32f(p, q, to_x_size, row_step, 0, false);
+    }
+    p += x * pixel_size;
+    q += x * 2 * pixel_size;
+
+    for (; x < to_x_size; ++x) {
+      // For each pixel.
+      for (int c = 0; c < num_color_components; ++c) {
+        // For each component.
+        filter_component(p, q, pixel_step, row_step);
       }
-    } else {
-      // Just one row.
-      if (x_size != 1) {
-        int x;
-        for (x = 0; x < x_size - 1; x += 2) {
-          // For each pixel.
-          for (int c = 0; c < num_color_components; ++c) {
-            // For each component.
-            filter_component(p, q, pixel_size, 0);
-          }
-          if (alpha) {
-            filter_alpha(p, q, pixel_size, 0);
-          }
-          q += pixel_size;
-        }
-        if (x < x_size) {
-          // Skip the last odd pixel.
-          q += pixel_size;
-        }
-      } else {
-        // Just one pixel.
-        for (int c = 0; c < num_color_components; ++c) {
-          // For each component.
-          filter_component(p, q, 0, 0);
-        }
-        if (alpha) {
-          filter_alpha(p, q, pixel_size, 0);
-        }
+      if (alpha) {
+        filter_alpha(p, q, pixel_step, row_step);
       }
+      q += pixel_step;
     }
-
-    nassertv(p == to._image.p() + (z + 1) * to._page_size);
-    nassertv(q == from._image.p() + (z + 1) * from._page_size);
-  }
+  });
 }
 
 /**
  * Generates the next mipmap level from the previous one, treating all the
- * pages of the level as a single 3-d block of pixels.
+ * pages of the level as a single 3-d block of pixels.  The rows of the new
+ * level are divided among texture-mipmap-num-threads threads.
  *
  * x_size, y_size, and z_size are the size of the previous level.  They need
  * not be a power of 2, or even a multiple of 2.
@@ -9556,6 +10614,10 @@ do_filter_3d_mipmap_level(const CData *cdata,
       filter_component = &filter_3d_float;
       break;
 
+    case T_half_float:
+      filter_component = &filter_3d_half_float;
+      break;
+
     default:
       gobj_cat.error()
         << "Unable to generate mipmaps for 3D texture with component type "
@@ -9586,172 +10648,186 @@ do_filter_3d_mipmap_level(const CData *cdata,
     --num_color_components;
   }
 
-  for (int view = 0; view < cdata->_num_views; ++view) {
-    unsigned char *start_to = to._image.p() + view * to_view_size;
-    const unsigned char *start_from = from._image.p() + view * view_size;
-    nassertv(start_to + to_view_size <= to._image.p() + to._image.size());
-    nassertv(start_from + view_size <= from._image.p() + from._image.size());
-    unsigned char *p = start_to;
-    const unsigned char *q = start_from;
-    if (z_size != 1) {
-      int z;
-      for (z = 0; z < z_size - 1; z += 2) {
-        // For each level.
-        nassertv(p == start_to + (z / 2) * to_page_size);
-        nassertv(q == start_from + z * page_size);
-        if (y_size != 1) {
-          int y;
-          for (y = 0; y < y_size - 1; y += 2) {
-            // For each row.
-            nassertv(p == start_to + (z / 2) * to_page_size + (y / 2) * to_row_size);
-            nassertv(q == start_from + z * page_size + y * row_size);
-            if (x_size != 1) {
-              int x;
-              for (x = 0; x < x_size - 1; x += 2) {
-                // For each pixel.
-                for (int c = 0; c < num_color_components; ++c) {
-                  // For each component.
-                  filter_component(p, q, pixel_size, row_size, page_size);
-                }
-                if (alpha) {
-                  filter_alpha(p, q, pixel_size, row_size, page_size);
-                }
-                q += pixel_size;
-              }
-              if (x < x_size) {
-                // Skip the last odd pixel.
-                q += pixel_size;
-              }
-            } else {
-              // Just one pixel.
-              for (int c = 0; c < num_color_components; ++c) {
-                // For each component.
-                filter_component(p, q, 0, row_size, page_size);
-              }
-              if (alpha) {
-                filter_alpha(p, q, 0, row_size, page_size);
-              }
-            }
-            q += row_size;
-            Thread::consider_yield();
-          }
-          if (y < y_size) {
-            // Skip the last odd row.
-            q += row_size;
-          }
-        } else {
-          // Just one row.
-          if (x_size != 1) {
-            int x;
-            for (x = 0; x < x_size - 1; x += 2) {
-              // For each pixel.
-              for (int c = 0; c < num_color_components; ++c) {
-                // For each component.
-                filter_component(p, q, pixel_size, 0, page_size);
-              }
-              if (alpha) {
-                filter_alpha(p, q, pixel_size, 0, page_size);
-              }
-              q += pixel_size;
-            }
-            if (x < x_size) {
-              // Skip the last odd pixel.
-              q += pixel_size;
-            }
-          } else {
-            // Just one pixel.
-            for (int c = 0; c < num_color_components; ++c) {
-              // For each component.
-              filter_component(p, q, 0, 0, page_size);
-            }
-            if (alpha) {
-              filter_alpha(p, q, 0, 0, page_size);
-            }
-          }
-        }
-        q += page_size;
+  // When the previous level is only one pixel wide, high or deep, the same
+  // pixel, row or page is used twice.
+  size_t pixel_step = (x_size != 1) ? pixel_size : 0;
+  size_t row_step = (y_size != 1) ? row_size : 0;
+  size_t page_step = (z_size != 1) ? page_size : 0;
+
+  bool rgba8 = (filter_component == &filter_3d_unsigned_byte &&
+                pixel_size == 4 && x_size != 1);
+  bool rgba32f = (filter_component == &filter_3d_float &&
+                  pixel_size == 16 && x_size != 1);
+
+  // Every row of every page of every view can be generated independently.
+  unsigned char *to_image = to._image.p();
+  const unsigned char *from_image = from._image.p();
+  nassertv(from._image.size() >= view_size * cdata->_num_views);
+
+  size_t rows_per_view = (size_t)to_z_size * to_y_size;
+  process_texture_rows("texture_mipmap", texture_mipmap_num_threads,
+                       rows_per_view * cdata->_num_views, [&] (size_t i) {
+    size_t view = i / rows_per_view;
+    size_t z = (i % rows_per_view) / to_y_size;
+    size_t y = i % to_y_size;
+    unsigned char *p = to_image + view * to_view_size + z * to_page_size + y * to_row_size;
+    const unsigned char *q = from_image + view * view_size + z * 2 * page_step + y * 2 * row_step;
+
+    int x = 0;
+    if (rgba8) {
+      x = filter_mipmap_row_rgba8(p, q, to_x_size, row_step, page_step, true);
+    } else if (rgba32f) {
+      x = filter_mipmap_row_rgba32f(p, q, to_x_size, row_step, page_step, true);
+    }
+    p += x * pixel_size;
+    q += x * 2 * pixel_size;
+
+    for (; x < to_x_size; ++x) {
+      // For each pixel.
+      for (int c = 0; c < num_color_components; ++c) {
+        // For each component.
+        filter_component(p, q, pixel_step, row_step, page_step);
       }
-      if (z < z_size) {
-        // Skip the last odd page.
-        q += page_size;
+      if (alpha) {
+        filter_alpha(p, q, pixel_step, row_step, page_step);
       }
-    } else {
-      // Just one page.
-      if (y_size != 1) {
-        int y;
-        for (y = 0; y < y_size - 1; y += 2) {
-          // For each row.
-          nassertv(p == start_to + (y / 2) * to_row_size);
-          nassertv(q == start_from + y * row_size);
-          if (x_size != 1) {
-            int x;
-            for (x = 0; x < x_size - 1; x += 2) {
-              // For each pixel.
-              for (int c = 0; c < num_color_components; ++c) {
-                // For each component.
-                filter_component(p, q, pixel_size, row_size, 0);
-              }
-              if (alpha) {
-                filter_alpha(p, q, pixel_size, row_size, 0);
-              }
-              q += pixel_size;
-            }
-            if (x < x_size) {
-              // Skip the last odd pixel.
-              q += pixel_size;
-            }
-          } else {
-            // Just one pixel.
-            for (int c = 0; c < num_color_components; ++c) {
-              // For each component.
-              filter_component(p, q, 0, row_size, 0);
-            }
-            if (alpha) {
-              filter_alpha(p, q, 0, row_size, 0);
-            }
-          }
-          q += row_size;
-          Thread::consider_yield();
-        }
-        if (y < y_size) {
-          // Skip the last odd row.
-          q += row_size;
-        }
-      } else {
-        // Just one row.
-        if (x_size != 1) {
-          int x;
-          for (x = 0; x < x_size - 1; x += 2) {
-            // For each pixel.
-            for (int c = 0; c < num_color_components; ++c) {
-              // For each component.
-              filter_component(p, q, pixel_size, 0, 0);
-            }
-            if (alpha) {
-              filter_alpha(p, q, pixel_size, 0, 0);
-            }
-            q += pixel_size;
-          }
-          if (x < x_size) {
-            // Skip the last odd pixel.
-            q += pixel_size;
-          }
-        } else {
-          // Just one pixel.
-          for (int c = 0; c < num_color_components; ++c) {
-            // For each component.
-            filter_component(p, q, 0, 0, 0);
-          }
-          if (alpha) {
-            filter_alpha(p, q, 0, 0, 0);
-          }
+      q += pixel_step;
+    }
+  });
+}
+
+/**
+ * Generates the next mipmap level from the previous one by resampling it with
+ * the indicated filter, separately along each axis.  This is slower than the
+ * box filters above, but supports the wider kernels, as well as weighting the
+ * color components by their alpha, so that the color of transparent pixels
+ * does not bleed into the opaque ones.
+ *
+ * x_size, y_size, and z_size are the size of the previous level.  z_size
+ * should be 1 unless this is a 3-D texture, in which case each view is
+ * filtered as a single 3-d block of pixels; otherwise each page is filtered
+ * by itself.
+ *
+ * Assumes the lock is already held.
+ */
+void Texture::
+do_resample_mipmap_level(const CData *cdata,
+                         Texture::RamImage &to, const Texture::RamImage &from,
+                         int x_size, int y_size, int z_size,
+                         MipmapFilter filter, bool alpha_weighted) const {
+  ComponentType component_type = cdata->_component_type;
+  switch (component_type) {
+  case T_unsigned_byte:
+  case T_unsigned_short:
+  case T_float:
+  case T_half_float:
+    break;
+
+  default:
+    gobj_cat.error()
+      << "Unable to generate mipmaps for texture with component type "
+      << component_type << " using mipmap filter " << filter << "!\n";
+    return;
+  }
+
+  int num_components = cdata->_num_components;
+  size_t pixel_size = num_components * cdata->_component_width;
+  size_t row_size = (size_t)x_size * pixel_size;
+  bool srgb = is_srgb(cdata->_format);
+  int alpha_index = has_alpha(cdata->_format) ? num_components - 1 : -1;
+
+  int to_x_size = max(x_size >> 1, 1);
+  int to_y_size = max(y_size >> 1, 1);
+  int to_z_size = max(z_size >> 1, 1);
+
+  // A block is a view of a 3-D texture, or a single page of any other.
+  size_t num_blocks = (size_t)cdata->_num_views;
+  if (cdata->_texture_type != TT_3d_texture) {
+    num_blocks *= cdata->_z_size;
+  }
+
+  size_t to_row_size = (size_t)to_x_size * pixel_size;
+  to._page_size = (size_t)to_y_size * to_row_size;
+  to._image = PTA_uchar::empty_array(to._page_size * to_z_size * num_blocks, get_class_type());
+
+  const unsigned char *from_image = from._image.p();
+  size_t from_page_size = from._page_size;
+  nassertv(from._image.size() >= from_page_size * z_size * num_blocks);
+  nassertv(from_page_size >= (size_t)y_size * row_size);
+
+  MipmapTapList x_taps, y_taps, z_taps;
+  compute_mipmap_taps(x_taps, filter, x_size, to_x_size);
+  compute_mipmap_taps(y_taps, filter, y_size, to_y_size);
+  compute_mipmap_taps(z_taps, filter, z_size, to_z_size);
+
+  // First resample each row of the previous level horizontally.
+  size_t to_row_values = (size_t)to_x_size * num_components;
+  pvector<float> horizontal((size_t)y_size * z_size * num_blocks * to_row_values);
+  process_texture_rows("texture_mipmap", texture_mipmap_num_threads,
+                       (size_t)y_size * z_size * num_blocks, [&] (size_t i) {
+    size_t page = i / y_size;
+    size_t y = i % y_size;
+    pvector<float> row((size_t)x_size * num_components);
+    decode_mipmap_row(row.data(), from_image + page * from_page_size + y * row_size,
+                      x_size, num_components, component_type, srgb,
+                      alpha_index, alpha_weighted);
+
+    float *p = &horizontal[i * to_row_values];
+    for (const MipmapTaps &tap : x_taps) {
+      for (int c = 0; c < num_components; ++c) {
+        const float *q = &row[(size_t)tap._first * num_components + c];
+        float value = 0.0f;
+        for (float weight : tap._weights) {
+          value += *q * weight;
+          q += num_components;
         }
+        *p++ = value;
       }
     }
+  });
 
-    nassertv(p == start_to + to_z_size * to_page_size);
-    nassertv(q == start_from + z_size * page_size);
-  }
+  // Then those vertically.
+  pvector<float> vertical((size_t)to_y_size * z_size * num_blocks * to_row_values);
+  process_texture_rows("texture_mipmap", texture_mipmap_num_threads,
+                       (size_t)to_y_size * z_size * num_blocks, [&] (size_t i) {
+    size_t page = i / to_y_size;
+    const MipmapTaps &tap = y_taps[i % to_y_size];
+    float *p = &vertical[i * to_row_values];
+    const float *q = &horizontal[(page * y_size + tap._first) * to_row_values];
+    for (size_t v = 0; v < to_row_values; ++v) {
+      float value = 0.0f;
+      for (size_t t = 0; t < tap._weights.size(); ++t) {
+        value += q[t * to_row_values + v] * tap._weights[t];
+      }
+      p[v] = value;
+    }
+  });
+
+  // And finally those across the pages of a 3-D texture, after which the
+  // rows are ready to be stored.
+  unsigned char *to_image = to._image.p();
+  size_t block_rows = (size_t)to_y_size * z_size;
+  process_texture_rows("texture_mipmap", texture_mipmap_num_threads,
+                       (size_t)to_y_size * to_z_size * num_blocks, [&] (size_t i) {
+    size_t block = i / ((size_t)to_y_size * to_z_size);
+    size_t z = (i / to_y_size) % to_z_size;
+    size_t y = i % to_y_size;
+    const MipmapTaps &tap = z_taps[z];
+    const float *q = &vertical[(block * block_rows + (size_t)tap._first * to_y_size + y) * to_row_values];
+    size_t page_values = (size_t)to_y_size * to_row_values;
+
+    pvector<float> row(to_row_values);
+    for (size_t v = 0; v < to_row_values; ++v) {
+      float value = 0.0f;
+      for (size_t t = 0; t < tap._weights.size(); ++t) {
+        value += q[t * page_values + v] * tap._weights[t];
+      }
+      row[v] = value;
+    }
+    encode_mipmap_row(to_image + i * to_row_size, row.data(), to_x_size,
+                      num_components, component_type, srgb,
+                      alpha_index, alpha_weighted);
+  });
 }
 
 /**
@@ -9834,6 +10910,22 @@ filter_2d_float(unsigned char *&p, const unsigned char *&q,
   q += 4;
 }
 
+/**
+ * Averages a 2x2 block of pixel components into a single pixel component, for
+ * producing the next mipmap level.  Increments p and q to the next component.
+ */
+void Texture::
+filter_2d_half_float(unsigned char *&p, const unsigned char *&q,
+                     size_t pixel_size, size_t row_size) {
+  float result = (BlockCompressor::half_to_float(*(uint16_t *)&q[0]) +
+                  BlockCompressor::half_to_float(*(uint16_t *)&q[pixel_size]) +
+                  BlockCompressor::half_to_float(*(uint16_t *)&q[row_size]) +
+                  BlockCompressor::half_to_float(*(uint16_t *)&q[pixel_size + row_size]));
+  *(uint16_t *)p = BlockCompressor::float_to_half(result * 0.25f);
+  p += 2;
+  q += 2;
+}
+
 /**
  * Averages a 2x2x2 block of pixel components into a single pixel component,
  * for producing the next mipmap level.  Increments p and q to the next
@@ -9941,172 +11033,24 @@ filter_3d_float(unsigned char *&p, const unsigned char *&q,
 }
 
 /**
- * Invokes the squish library to compress the RAM image(s).
- */
-bool Texture::
-do_squish(CData *cdata, Texture::CompressionMode compression, int squish_flags) {
-#ifdef HAVE_SQUISH
-  if (!do_has_all_ram_mipmap_images(cdata)) {
-    // If we're about to compress the RAM image, we should ensure that we have
-    // all of the mipmap levels first.
-    do_generate_ram_mipmap_images(cdata, false);
-  }
-
-  RamImages compressed_ram_images;
-  compressed_ram_images.reserve(cdata->_ram_images.size());
-  for (size_t n = 0; n < cdata->_ram_images.size(); ++n) {
-    RamImage compressed_image;
-    int x_size = do_get_expected_mipmap_x_size(cdata, n);
-    int y_size = do_get_expected_mipmap_y_size(cdata, n);
-    int num_pages = do_get_expected_mipmap_num_pages(cdata, n);
-    int page_size = squish::GetStorageRequirements(x_size, y_size, squish_flags);
-    int cell_size = squish::GetStorageRequirements(4, 4, squish_flags);
-
-    compressed_image._page_size = page_size;
-    compressed_image._image = PTA_uchar::empty_array(page_size * num_pages);
-    for (int z = 0; z < num_pages; ++z) {
-      unsigned char *dest_page = compressed_image._image.p() + z * page_size;
-      unsigned const char *source_page = cdata->_ram_images[n]._image.p() + z * cdata->_ram_images[n]._page_size;
-      unsigned const char *source_page_end = source_page + cdata->_ram_images[n]._page_size;
-      // Convert one 4 x 4 cell at a time.
-      unsigned char *d = dest_page;
-      for (int y = 0; y < y_size; y += 4) {
-        for (int x = 0; x < x_size; x += 4) {
-          unsigned char tb[16 * 4];
-          int mask = 0;
-          unsigned char *t = tb;
-          for (int i = 0; i < 16; ++i) {
-            int xi = x + i % 4;
-            int yi = y + i / 4;
-            unsigned const char *s = source_page + (yi * x_size + xi) * cdata->_num_components;
-            if (s < source_page_end) {
-              switch (cdata->_num_components) {
-              case 1:
-                t[0] = s[0];   // r
-                t[1] = s[0];   // g
-                t[2] = s[0];   // b
-                t[3] = 255;    // a
-                break;
-
-              case 2:
-                t[0] = s[0];   // r
-                t[1] = s[0];   // g
-                t[2] = s[0];   // b
-                t[3] = s[1];   // a
-                break;
-
-              case 3:
-                t[0] = s[2];   // r
-                t[1] = s[1];   // g
-                t[2] = s[0];   // b
-                t[3] = 255;    // a
-                break;
-
-              case 4:
-                t[0] = s[2];   // r
-                t[1] = s[1];   // g
-                t[2] = s[0];   // b
-                t[3] = s[3];   // a
-                break;
-              }
-              mask |= (1 << i);
-            }
-            t += 4;
-          }
-          squish::CompressMasked(tb, mask, d, squish_flags);
-          d += cell_size;
-          Thread::consider_yield();
-        }
-      }
-    }
-    compressed_ram_images.push_back(compressed_image);
-  }
-  cdata->_ram_images.swap(compressed_ram_images);
-  cdata->_ram_image_compression = compression;
-  return true;
-
-#else  // HAVE_SQUISH
-  return false;
-
-#endif  // HAVE_SQUISH
-}
-
-/**
- * Invokes the squish library to uncompress the RAM image(s).
+ * Averages a 2x2x2 block of pixel components into a single pixel component,
+ * for producing the next mipmap level.  Increments p and q to the next
+ * component.
  */
-bool Texture::
-do_unsquish(CData *cdata, int squish_flags) {
-#ifdef HAVE_SQUISH
-  RamImages uncompressed_ram_images;
-  uncompressed_ram_images.reserve(cdata->_ram_images.size());
-  for (size_t n = 0; n < cdata->_ram_images.size(); ++n) {
-    RamImage uncompressed_image;
-    int x_size = do_get_expected_mipmap_x_size(cdata, n);
-    int y_size = do_get_expected_mipmap_y_size(cdata, n);
-    int num_pages = do_get_expected_mipmap_num_pages(cdata, n);
-    int page_size = squish::GetStorageRequirements(x_size, y_size, squish_flags);
-    int cell_size = squish::GetStorageRequirements(4, 4, squish_flags);
-
-    uncompressed_image._page_size = do_get_expected_ram_mipmap_page_size(cdata, n);
-    uncompressed_image._image = PTA_uchar::empty_array(uncompressed_image._page_size * num_pages);
-    for (int z = 0; z < num_pages; ++z) {
-      unsigned char *dest_page = uncompressed_image._image.p() + z * uncompressed_image._page_size;
-      unsigned char *dest_page_end = dest_page + uncompressed_image._page_size;
-      unsigned const char *source_page = cdata->_ram_images[n]._image.p() + z * page_size;
-      // Unconvert one 4 x 4 cell at a time.
-      unsigned const char *s = source_page;
-      for (int y = 0; y < y_size; y += 4) {
-        for (int x = 0; x < x_size; x += 4) {
-          unsigned char tb[16 * 4];
-          squish::Decompress(tb, s, squish_flags);
-          s += cell_size;
-
-          unsigned char *t = tb;
-          for (int i = 0; i < 16; ++i) {
-            int xi = x + i % 4;
-            int yi = y + i / 4;
-            unsigned char *d = dest_page + (yi * x_size + xi) * cdata->_num_components;
-            if (d < dest_page_end) {
-              switch (cdata->_num_components) {
-              case 1:
-                d[0] = t[1];   // g
-                break;
-
-              case 2:
-                d[0] = t[1];   // g
-                d[1] = t[3];   // a
-                break;
-
-              case 3:
-                d[2] = t[0];   // r
-                d[1] = t[1];   // g
-                d[0] = t[2];   // b
-                break;
-
-              case 4:
-                d[2] = t[0];   // r
-                d[1] = t[1];   // g
-                d[0] = t[2];   // b
-                d[3] = t[3];   // a
-                break;
-              }
-            }
-            t += 4;
-          }
-        }
-        Thread::consider_yield();
-      }
-    }
-    uncompressed_ram_images.push_back(uncompressed_image);
-  }
-  cdata->_ram_images.swap(uncompressed_ram_images);
-  cdata->_ram_image_compression = CM_off;
-  return true;
-
-#else  // HAVE_SQUISH
-  return false;
-
-#endif  // HAVE_SQUISH
+void Texture::
+filter_3d_half_float(unsigned char *&p, const unsigned char *&q,
+                     size_t pixel_size, size_t row_size, size_t page_size) {
+  float result = (BlockCompressor::half_to_float(*(uint16_t *)&q[0]) +
+                  BlockCompressor::half_to_float(*(uint16_t *)&q[pixel_size]) +
+                  BlockCompressor::half_to_float(*(uint16_t *)&q[row_size]) +
+                  BlockCompressor::half_to_float(*(uint16_t *)&q[pixel_size + row_size]) +
+                  BlockCompressor::half_to_float(*(uint16_t *)&q[page_size]) +
+                  BlockCompressor::half_to_float(*(uint16_t *)&q[pixel_size + page_size]) +
+                  BlockCompressor::half_to_float(*(uint16_t *)&q[row_size + page_size]) +
+                  BlockCompressor::half_to_float(*(uint16_t *)&q[pixel_size + row_size + page_size]));
+  *(uint16_t *)p = BlockCompressor::float_to_half(result * 0.125f);
+  p += 2;
+  q += 2;
 }
 
 /**
@@ -11014,3 +11958,23 @@ operator >> (istream &in, Texture::QualityLevel &tql) {
   tql = Texture::string_quality_level(word);
   return in;
 }
+
+/**
+ *
+ */
+ostream &
+operator << (ostream &out, Texture::MipmapFilter mf) {
+  return out << Texture::format_mipmap_filter(mf);
+}
+
+/**
+ *
+ */
+istream &
+operator >> (istream &in, Texture::MipmapFilter &mf) {
+  string word;
+  in >> word;
+
+  mf = Texture::string_mipmap_filter(word);
+  return in;
+}
@@ -222,6 +222,7 @@ PUBLISHED:
     CM_etc1,
     CM_etc2,
     CM_eac, // EAC: 1 or 2 channels.
+    CM_bptc, // BC6H/BC7: HDR RGB or high-quality RGBA.
   };
 
   enum QualityLevel {
@@ -231,6 +232,12 @@ PUBLISHED:
     QL_best,
   };
 
+  enum MipmapFilter {
+    MF_box,       // average each 2x2 block; the fastest
+    MF_kaiser,    // Kaiser-windowed sinc, three pixels of the new level wide
+    MF_lanczos,   // Lanczos-windowed sinc, three pixels wide
+  };
+
 PUBLISHED:
   explicit Texture(std::string name = "");
 
@@ -470,10 +477,12 @@ PUBLISHED:
   INLINE void set_keep_ram_image(bool keep_ram_image);
   virtual bool get_keep_ram_image() const;
   virtual bool is_cacheable() const;
+  INLINE bool is_streaming() const;
 
   MAKE_PROPERTY(ram_image_compression, get_ram_image_compression);
   MAKE_PROPERTY(keep_ram_image, get_keep_ram_image, set_keep_ram_image);
   MAKE_PROPERTY(cacheable, is_cacheable);
+  MAKE_PROPERTY(streaming, is_streaming);
 
   PY_EXTENSION(PT(Texture) __deepcopy__(PyObject *memo) const);
 
@@ -629,6 +638,9 @@ PUBLISHED:
   static std::string format_quality_level(QualityLevel tql);
   static QualityLevel string_quality_level(std::string_view str);
 
+  static std::string format_mipmap_filter(MipmapFilter mf);
+  static MipmapFilter string_mipmap_filter(std::string_view str);
+
 public:
   void texture_uploaded();
   INLINE int get_num_async_transfer_buffers() const;
@@ -694,6 +706,7 @@ protected:
   bool do_read_dds(CData *cdata, std::istream &in, std::string_view filename, bool header_only);
   bool do_read_ktx_file(CData *cdata, const Filename &fullpath, bool header_only);
   bool do_read_ktx(CData *cdata, std::istream &in, std::string_view filename, bool header_only);
+  bool do_read_ktx2(CData *cdata, std::istream &in, std::string_view filename, bool header_only);
 
   bool do_write(CData *cdata, const Filename &fullpath, int z, int n,
                 bool write_pages, bool write_mipmaps);
@@ -723,14 +736,9 @@ protected:
                              GraphicsStateGuardianBase *gsg);
   bool do_uncompress_ram_image(CData *cdata);
 
-  static void do_compress_ram_image_bc4(const RamImage &src, RamImage &dest,
-                                        int x_size, int y_size, int z_size);
-  static void do_compress_ram_image_bc5(const RamImage &src, RamImage &dest,
-                                        int x_size, int y_size, int z_size);
-  static void do_uncompress_ram_image_bc4(const RamImage &src, RamImage &dest,
-                                          int x_size, int y_size, int z_size);
-  static void do_uncompress_ram_image_bc5(const RamImage &src, RamImage &dest,
-                                          int x_size, int y_size, int z_size);
+  bool do_compress_ram_image_bc(CData *cdata, CompressionMode compression,
+                                QualityLevel quality_level);
+  bool do_uncompress_ram_image_bc(CData *cdata);
   bool do_has_all_ram_mipmap_images(const CData *cdata) const;
 
   bool do_reconsider_z_size(CData *cdata, int z, const LoaderOptions &options);
@@ -814,6 +822,8 @@ protected:
   };
 
 private:
+  size_t stream_ram_mipmap_images(const Texture *source, int n);
+
   static void convert_from_pnmimage(PTA_uchar &image, size_t page_size,
                                     int row_stride, int x, int y, int z,
                                     const PNMImage &pnmimage,
@@ -895,6 +905,11 @@ private:
                                  RamImage &to, const RamImage &from,
                                  int x_size, int y_size, int z_size) const;
 
+  void do_resample_mipmap_level(const CData *cdata,
+                                RamImage &to, const RamImage &from,
+                                int x_size, int y_size, int z_size,
+                                MipmapFilter filter, bool alpha_weighted) const;
+
   typedef void Filter2DComponent(unsigned char *&p,
                                  const unsigned char *&q,
                                  size_t pixel_size, size_t row_size);
@@ -918,6 +933,8 @@ private:
                                        size_t pixel_size, size_t row_size);
   static void filter_2d_float(unsigned char *&p, const unsigned char *&q,
                               size_t pixel_size, size_t row_size);
+  static void filter_2d_half_float(unsigned char *&p, const unsigned char *&q,
+                                   size_t pixel_size, size_t row_size);
 
   static void filter_3d_unsigned_byte(unsigned char *&p,
                                       const unsigned char *&q,
@@ -937,9 +954,9 @@ private:
                                        size_t page_size);
   static void filter_3d_float(unsigned char *&p, const unsigned char *&q,
                               size_t pixel_size, size_t row_size, size_t page_size);
-
-  bool do_squish(CData *cdata, CompressionMode compression, int squish_flags);
-  bool do_unsquish(CData *cdata, int squish_flags);
+  static void filter_3d_half_float(unsigned char *&p, const unsigned char *&q,
+                                   size_t pixel_size, size_t row_size,
+                                   size_t page_size);
 
 protected:
   typedef pvector<RamImage> RamImages;
@@ -1089,6 +1106,10 @@ protected:
   // The TexturePool finds this useful.
   Filename _texture_pool_key;
 
+  // Set while the TextureStreamingManager is streaming this texture.  This is
+  // read by the cull threads while the manager changes it.
+  patomic<bool> _streaming;
+
 private:
   // The auxiliary data is not recorded to a bam file.
   typedef pmap<std::string, PT(TypedReferenceCount), std::less<>> AuxData;
@@ -1139,9 +1160,11 @@ private:
   friend class PreparedGraphicsObjects;
   friend class TexturePool;
   friend class TexturePeeker;
+  friend class TextureStreamingManager;
 };
 
 extern EXPCL_PANDA_GOBJ ConfigVariableEnum<Texture::QualityLevel> texture_quality_level;
+extern EXPCL_PANDA_GOBJ ConfigVariableEnum<Texture::MipmapFilter> texture_mipmap_filter;
 
 EXPCL_PANDA_GOBJ std::ostream &operator << (std::ostream &out, Texture::TextureType tt);
 EXPCL_PANDA_GOBJ std::ostream &operator << (std::ostream &out, Texture::ComponentType ct);
@@ -1151,6 +1174,9 @@ EXPCL_PANDA_GOBJ std::ostream &operator << (std::ostream &out, Texture::Compress
 EXPCL_PANDA_GOBJ std::ostream &operator << (std::ostream &out, Texture::QualityLevel tql);
 EXPCL_PANDA_GOBJ std::istream &operator >> (std::istream &in, Texture::QualityLevel &tql);
 
+EXPCL_PANDA_GOBJ std::ostream &operator << (std::ostream &out, Texture::MipmapFilter mf);
+EXPCL_PANDA_GOBJ std::istream &operator >> (std::istream &in, Texture::MipmapFilter &mf);
+
 #include "texture.I"
 
 #endif // !TEXTURE_H
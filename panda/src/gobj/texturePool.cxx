@@ -23,10 +23,12 @@
 #include "bamCacheRecord.h"
 #include "pnmFileTypeRegistry.h"
 #include "texturePoolFilter.h"
+#include "textureStreamingManager.h"
 #include "configVariableList.h"
 #include "load_dso.h"
 #include "mutexHolder.h"
 #include "dcast.h"
+#include "thread.h"
 
 #include <algorithm>
 
@@ -174,7 +176,8 @@ get_texture_type(std::string_view extension) const {
   // Check the PNM type registry.
   PNMFileTypeRegistry *pnm_reg = PNMFileTypeRegistry::get_global_ptr();
   PNMFileType *type = pnm_reg->get_type_from_extension(c);
-  if (type != nullptr || c == "txo" || c == "dds" || c == "ktx") {
+  if (type != nullptr || c == "txo" || c == "dds" || c == "ktx" ||
+      c == "ktx2") {
     // This is a known image type; create an ordinary Texture.
     ((TexturePool *)this)->_type_registry[c] = Texture::make_texture;
     return Texture::make_texture;
@@ -255,11 +258,10 @@ TexturePool() {
  */
 bool TexturePool::
 ns_has_texture(const Filename &orig_filename) {
-  MutexHolder holder(_lock);
-
   LookupKey key;
   resolve_filename(key._fullpath, orig_filename, false, LoaderOptions());
 
+  MutexHolder holder(_lock);
   Textures::const_iterator ti;
   ti = _textures.find(key);
   if (ti != _textures.end()) {
@@ -285,10 +287,9 @@ ns_get_texture(const Filename &orig_filename, int primary_file_num_channels,
                bool read_mipmaps) {
   LookupKey key;
   key._primary_file_num_channels = primary_file_num_channels;
+  resolve_filename(key._fullpath, orig_filename, read_mipmaps, LoaderOptions());
   {
     MutexHolder holder(_lock);
-    resolve_filename(key._fullpath, orig_filename, read_mipmaps, LoaderOptions());
-
     Textures::const_iterator ti;
     ti = _textures.find(key);
     if (ti != _textures.end()) {
@@ -314,12 +315,12 @@ ns_get_texture(const Filename &orig_filename,
   LookupKey key;
   key._primary_file_num_channels = primary_file_num_channels;
   key._alpha_file_channel = alpha_file_channel;
+
+  LoaderOptions options;
+  resolve_filename(key._fullpath, orig_filename, read_mipmaps, options);
+  resolve_filename(key._alpha_fullpath, orig_alpha_filename, read_mipmaps, options);
   {
     MutexHolder holder(_lock);
-    LoaderOptions options;
-    resolve_filename(key._fullpath, orig_filename, read_mipmaps, options);
-    resolve_filename(key._alpha_fullpath, orig_alpha_filename, read_mipmaps, options);
-
     Textures::const_iterator ti;
     ti = _textures.find(key);
     if (ti != _textures.end()) {
@@ -334,16 +335,22 @@ ns_get_texture(const Filename &orig_filename,
 }
 
 /**
- * The nonstatic implementation of load_texture().
+ * Returns the texture with the indicated key from the pool.  If it has not
+ * yet been loaded, calls the given function to load it, without holding the
+ * lock, so that different textures can be loaded in parallel.  If another
+ * thread is already loading the same texture, waits for it to finish instead,
+ * so that each texture is only read once.
  */
+template<class LoadFunc>
 Texture *TexturePool::
-ns_load_texture(const Filename &orig_filename, int primary_file_num_channels,
-                bool read_mipmaps, const LoaderOptions &options, const SamplerState &sampler) {
-
-  LookupKey key(Texture::TT_2d_texture, primary_file_num_channels, 0, options, sampler);
+load_once(const LookupKey &key, LoadFunc load) {
+  Thread *current_thread = Thread::get_current_thread();
+  std::thread::id current_thread_id = std::this_thread::get_id();
+  PendingLoads::iterator pi;
+  PT(AsyncFuture) future;
+  bool loading = false;
   {
     MutexHolder holder(_lock);
-    resolve_filename(key._fullpath, orig_filename, read_mipmaps, options);
 
     Textures::const_iterator ti;
     ti = _textures.find(key);
@@ -353,8 +360,71 @@ ns_load_texture(const Filename &orig_filename, int primary_file_num_channels,
       nassertr(!tex->get_fullpath().empty(), tex);
       return tex;
     }
+
+    std::pair<PendingLoads::iterator, bool> result =
+      _pending_loads.insert(PendingLoads::value_type(key, PendingLoad()));
+    pi = result.first;
+    if (result.second) {
+      // Nobody is loading this texture yet, so we will.  Other threads that
+      // ask for it in the meantime will wait on this future.
+      (*pi).second._future = new AsyncFuture;
+      (*pi).second._thread = current_thread;
+      (*pi).second._thread_id = current_thread_id;
+      loading = true;
+
+    } else if ((*pi).second._thread != current_thread ||
+               (*pi).second._thread_id != current_thread_id) {
+      future = (*pi).second._future;
+
+    } else {
+      // This thread is already loading it further up the stack, eg. from
+      // within a texture filter.  Waiting would deadlock, so just load it.
+    }
+  }
+
+  if (future != nullptr) {
+    // Another thread is loading it.  This returns null if that failed.
+    future->wait();
+    return DCAST(Texture, future->get_result());
+  }
+
+  PT(Texture) tex = load();
+
+  if (loading) {
+    {
+      MutexHolder holder(_lock);
+      future = std::move((*pi).second._future);
+      _pending_loads.erase(pi);
+    }
+    future->set_result(tex.p());
   }
+  return tex;
+}
+
+/**
+ * The nonstatic implementation of load_texture().
+ */
+Texture *TexturePool::
+ns_load_texture(const Filename &orig_filename, int primary_file_num_channels,
+                bool read_mipmaps, const LoaderOptions &options, const SamplerState &sampler) {
+
+  LookupKey key(Texture::TT_2d_texture, primary_file_num_channels, 0, options, sampler);
+  resolve_filename(key._fullpath, orig_filename, read_mipmaps, options);
+
+  return load_once(key, [&] () {
+    return do_load_texture(key, orig_filename, primary_file_num_channels,
+                           read_mipmaps, options, sampler);
+  });
+}
 
+/**
+ * Loads the texture with the indicated key, which is not yet in the pool, and
+ * adds it.  Called by load_once(), without holding the lock.
+ */
+PT(Texture) TexturePool::
+do_load_texture(LookupKey &key, const Filename &orig_filename,
+                int primary_file_num_channels, bool read_mipmaps,
+                const LoaderOptions &options, const SamplerState &sampler) {
   // The texture was not found in the pool.
   PT(Texture) tex;
   PT(BamCacheRecord) record;
@@ -429,11 +499,7 @@ ns_load_texture(const Filename &orig_filename, int primary_file_num_channels,
   }
 
   if (cache->get_cache_compressed_textures() && tex->has_compression()) {
-#ifndef HAVE_SQUISH
-    bool needs_driver_compression = true;
-#else
     bool needs_driver_compression = driver_compress_textures;
-#endif // HAVE_SQUISH
     if (needs_driver_compression) {
       // We don't want to save the uncompressed version; we'll save the
       // compressed version when it becomes available.
@@ -468,7 +534,7 @@ ns_load_texture(const Filename &orig_filename, int primary_file_num_channels,
       return tex;
     }
 
-    _textures[std::move(key)] = tex;
+    _textures[key] = tex;
   }
 
   if (store_record && tex->is_cacheable()) {
@@ -477,7 +543,12 @@ ns_load_texture(const Filename &orig_filename, int primary_file_num_channels,
     cache->store(record);
   }
 
-  if (!(options.get_texture_flags() & LoaderOptions::TF_preload)) {
+  if (options.get_texture_flags() & LoaderOptions::TF_streaming) {
+    // Keep only the smallest mipmap levels in RAM; the rest are loaded when
+    // they are needed.
+    TextureStreamingManager::get_global_ptr()->add_texture(tex);
+
+  } else if (!(options.get_texture_flags() & LoaderOptions::TF_preload)) {
     // And now drop the RAM until we need it.
     tex->clear_ram_image();
   }
@@ -507,21 +578,26 @@ ns_load_texture(const Filename &orig_filename,
   }
 
   LookupKey key(Texture::TT_2d_texture, primary_file_num_channels, alpha_file_channel, options, sampler);
-  {
-    MutexHolder holder(_lock);
-    resolve_filename(key._fullpath, orig_filename, read_mipmaps, options);
-    resolve_filename(key._alpha_fullpath, orig_alpha_filename, read_mipmaps, options);
+  resolve_filename(key._fullpath, orig_filename, read_mipmaps, options);
+  resolve_filename(key._alpha_fullpath, orig_alpha_filename, read_mipmaps, options);
 
-    Textures::const_iterator ti;
-    ti = _textures.find(key);
-    if (ti != _textures.end()) {
-      // This texture was previously loaded.
-      Texture *tex = (*ti).second;
-      nassertr(!tex->get_fullpath().empty(), tex);
-      return tex;
-    }
-  }
+  return load_once(key, [&] () {
+    return do_load_texture(key, orig_filename, orig_alpha_filename,
+                           primary_file_num_channels, alpha_file_channel,
+                           read_mipmaps, options, sampler);
+  });
+}
 
+/**
+ * Loads the texture with the indicated key, which is not yet in the pool, and
+ * adds it.  Called by load_once(), without holding the lock.
+ */
+PT(Texture) TexturePool::
+do_load_texture(LookupKey &key, const Filename &orig_filename,
+                const Filename &orig_alpha_filename,
+                int primary_file_num_channels, int alpha_file_channel,
+                bool read_mipmaps, const LoaderOptions &options,
+                const SamplerState &sampler) {
   PT(Texture) tex;
   PT(BamCacheRecord) record;
   bool store_record = false;
@@ -561,11 +637,7 @@ ns_load_texture(const Filename &orig_filename,
   }
 
   if (cache->get_cache_compressed_textures() && tex->has_compression()) {
-#ifndef HAVE_SQUISH
-    bool needs_driver_compression = true;
-#else
     bool needs_driver_compression = driver_compress_textures;
-#endif // HAVE_SQUISH
     if (needs_driver_compression) {
       // We don't want to save the uncompressed version; we'll save the
       // compressed version when it becomes available.
@@ -601,7 +673,7 @@ ns_load_texture(const Filename &orig_filename,
       return tex;
     }
 
-    _textures[std::move(key)] = tex;
+    _textures[key] = tex;
   }
 
   if (store_record && tex->is_cacheable()) {
@@ -610,7 +682,12 @@ ns_load_texture(const Filename &orig_filename,
     cache->store(record);
   }
 
-  if (!(options.get_texture_flags() & LoaderOptions::TF_preload)) {
+  if (options.get_texture_flags() & LoaderOptions::TF_streaming) {
+    // Keep only the smallest mipmap levels in RAM; the rest are loaded when
+    // they are needed.
+    TextureStreamingManager::get_global_ptr()->add_texture(tex);
+
+  } else if (!(options.get_texture_flags() & LoaderOptions::TF_preload)) {
     // And now drop the RAM until we need it.
     tex->clear_ram_image();
   }
@@ -635,20 +712,22 @@ ns_load_3d_texture(const Filename &filename_pattern,
   orig_filename.set_pattern(true);
 
   LookupKey key(Texture::TT_3d_texture, 0, 0, options, sampler);
-  {
-    MutexHolder holder(_lock);
-    resolve_filename(key._fullpath, orig_filename, read_mipmaps, options);
+  resolve_filename(key._fullpath, orig_filename, read_mipmaps, options);
 
-    Textures::const_iterator ti;
-    ti = _textures.find(key);
-    if (ti != _textures.end()) {
-      // This texture was previously loaded.
-      Texture *tex = (*ti).second;
-      nassertr(!tex->get_fullpath().empty(), tex);
-      return tex;
-    }
-  }
+  return load_once(key, [&] () {
+    return do_load_3d_texture(key, filename_pattern, read_mipmaps,
+                              options, sampler);
+  });
+}
 
+/**
+ * Loads the 3-D texture with the indicated key, which is not yet in the pool,
+ * and adds it.  Called by load_once(), without holding the lock.
+ */
+PT(Texture) TexturePool::
+do_load_3d_texture(LookupKey &key, const Filename &filename_pattern,
+                   bool read_mipmaps, const LoaderOptions &options,
+                   const SamplerState &sampler) {
   PT(Texture) tex;
   PT(BamCacheRecord) record;
   bool store_record = false;
@@ -675,11 +754,7 @@ ns_load_3d_texture(const Filename &filename_pattern,
   }
 
   if (cache->get_cache_compressed_textures() && tex->has_compression()) {
-#ifndef HAVE_SQUISH
-    bool needs_driver_compression = true;
-#else
     bool needs_driver_compression = driver_compress_textures;
-#endif // HAVE_SQUISH
     if (needs_driver_compression) {
       // We don't want to save the uncompressed version; we'll save the
       // compressed version when it becomes available.
@@ -713,7 +788,7 @@ ns_load_3d_texture(const Filename &filename_pattern,
       return tex;
     }
 
-    _textures[std::move(key)] = tex;
+    _textures[key] = tex;
   }
 
   if (store_record && tex->is_cacheable()) {
@@ -737,20 +812,22 @@ ns_load_2d_texture_array(const Filename &filename_pattern,
   orig_filename.set_pattern(true);
 
   LookupKey key(Texture::TT_2d_texture_array, 0, 0, options, sampler);
-  {
-    MutexHolder holder(_lock);
-    resolve_filename(key._fullpath, orig_filename, read_mipmaps, options);
+  resolve_filename(key._fullpath, orig_filename, read_mipmaps, options);
 
-    Textures::const_iterator ti;
-    ti = _textures.find(key);
-    if (ti != _textures.end()) {
-      // This texture was previously loaded.
-      Texture *tex = (*ti).second;
-      nassertr(!tex->get_fullpath().empty(), tex);
-      return tex;
-    }
-  }
+  return load_once(key, [&] () {
+    return do_load_2d_texture_array(key, filename_pattern, read_mipmaps,
+                                    options, sampler);
+  });
+}
 
+/**
+ * Loads the 2-D texture array with the indicated key, which is not yet in the
+ * pool, and adds it.  Called by load_once(), without holding the lock.
+ */
+PT(Texture) TexturePool::
+do_load_2d_texture_array(LookupKey &key, const Filename &filename_pattern,
+                         bool read_mipmaps, const LoaderOptions &options,
+                         const SamplerState &sampler) {
   PT(Texture) tex;
   PT(BamCacheRecord) record;
   bool store_record = false;
@@ -777,11 +854,7 @@ ns_load_2d_texture_array(const Filename &filename_pattern,
   }
 
   if (cache->get_cache_compressed_textures() && tex->has_compression()) {
-#ifndef HAVE_SQUISH
-    bool needs_driver_compression = true;
-#else
     bool needs_driver_compression = driver_compress_textures;
-#endif // HAVE_SQUISH
     if (needs_driver_compression) {
       // We don't want to save the uncompressed version; we'll save the
       // compressed version when it becomes available.
@@ -815,7 +888,7 @@ ns_load_2d_texture_array(const Filename &filename_pattern,
       return tex;
     }
 
-    _textures[std::move(key)] = tex;
+    _textures[key] = tex;
   }
 
   if (store_record && tex->is_cacheable()) {
@@ -839,20 +912,22 @@ ns_load_cube_map(const Filename &filename_pattern, bool read_mipmaps,
   orig_filename.set_pattern(true);
 
   LookupKey key(Texture::TT_cube_map, 0, 0, options, sampler);
-  {
-    MutexHolder holder(_lock);
-    resolve_filename(key._fullpath, orig_filename, read_mipmaps, options);
+  resolve_filename(key._fullpath, orig_filename, read_mipmaps, options);
 
-    Textures::const_iterator ti;
-    ti = _textures.find(key);
-    if (ti != _textures.end()) {
-      // This texture was previously loaded.
-      Texture *tex = (*ti).second;
-      nassertr(!tex->get_fullpath().empty(), tex);
-      return tex;
-    }
-  }
+  return load_once(key, [&] () {
+    return do_load_cube_map(key, filename_pattern, read_mipmaps,
+                            options, sampler);
+  });
+}
 
+/**
+ * Loads the cube map with the indicated key, which is not yet in the pool, and
+ * adds it.  Called by load_once(), without holding the lock.
+ */
+PT(Texture) TexturePool::
+do_load_cube_map(LookupKey &key, const Filename &filename_pattern,
+                 bool read_mipmaps, const LoaderOptions &options,
+                 const SamplerState &sampler) {
   PT(Texture) tex;
   PT(BamCacheRecord) record;
   bool store_record = false;
@@ -879,11 +954,7 @@ ns_load_cube_map(const Filename &filename_pattern, bool read_mipmaps,
   }
 
   if (cache->get_cache_compressed_textures() && tex->has_compression()) {
-#ifndef HAVE_SQUISH
-    bool needs_driver_compression = true;
-#else
     bool needs_driver_compression = driver_compress_textures;
-#endif // HAVE_SQUISH
     if (needs_driver_compression) {
       // We don't want to save the uncompressed version; we'll save the
       // compressed version when it becomes available.
@@ -917,7 +988,7 @@ ns_load_cube_map(const Filename &filename_pattern, bool read_mipmaps,
       return tex;
     }
 
-    _textures[std::move(key)] = tex;
+    _textures[key] = tex;
   }
 
   if (store_record && tex->is_cacheable()) {
@@ -1219,7 +1290,7 @@ ns_make_texture(std::string_view extension) const {
 /**
  * Searches for the indicated filename along the model path.  If the filename
  * was previously searched for, doesn't search again, as an optimization.
- * Assumes _lock is held.
+ * Assumes _lock is not held; it is released during the search.
  */
 void TexturePool::
 resolve_filename(Filename &new_filename, const Filename &orig_filename,
@@ -1229,10 +1300,13 @@ resolve_filename(Filename &new_filename, const Filename &orig_filename,
     return;
   }
 
-  RelpathLookup::iterator rpi = _relpath_lookup.find(orig_filename);
-  if (rpi != _relpath_lookup.end()) {
-    new_filename = (*rpi).second;
-    return;
+  {
+    MutexHolder holder(_lock);
+    RelpathLookup::iterator rpi = _relpath_lookup.find(orig_filename);
+    if (rpi != _relpath_lookup.end()) {
+      new_filename = (*rpi).second;
+      return;
+    }
   }
 
   new_filename = orig_filename;
@@ -1243,6 +1317,7 @@ resolve_filename(Filename &new_filename, const Filename &orig_filename,
   VirtualFileSystem *vfs = VirtualFileSystem::get_global_ptr();
   vfs->resolve_filename(new_filename, get_model_path());
 
+  MutexHolder holder(_lock);
   _relpath_lookup[orig_filename] = new_filename;
 }
 
@@ -22,9 +22,12 @@
 #include "config_gobj.h"
 #include "loaderOptions.h"
 #include "pmutex.h"
+#include "asyncFuture.h"
 #include "pmap.h"
 #include "textureCollection.h"
 
+#include <thread>
+
 class TexturePoolFilter;
 class BamCache;
 class BamCacheRecord;
@@ -220,8 +223,53 @@ private:
     INLINE bool operator < (const LookupKey &other) const;
   };
 
+  template<class LoadFunc>
+  Texture *load_once(const LookupKey &key, LoadFunc load);
+
+  PT(Texture) do_load_texture(LookupKey &key, const Filename &orig_filename,
+                              int primary_file_num_channels,
+                              bool read_mipmaps,
+                              const LoaderOptions &options,
+                              const SamplerState &sampler);
+  PT(Texture) do_load_texture(LookupKey &key, const Filename &orig_filename,
+                              const Filename &orig_alpha_filename,
+                              int primary_file_num_channels,
+                              int alpha_file_channel,
+                              bool read_mipmaps,
+                              const LoaderOptions &options,
+                              const SamplerState &sampler);
+  PT(Texture) do_load_3d_texture(LookupKey &key,
+                                 const Filename &filename_pattern,
+                                 bool read_mipmaps,
+                                 const LoaderOptions &options,
+                                 const SamplerState &sampler);
+  PT(Texture) do_load_2d_texture_array(LookupKey &key,
+                                       const Filename &filename_pattern,
+                                       bool read_mipmaps,
+                                       const LoaderOptions &options,
+                                       const SamplerState &sampler);
+  PT(Texture) do_load_cube_map(LookupKey &key,
+                               const Filename &filename_pattern,
+                               bool read_mipmaps,
+                               const LoaderOptions &options,
+                               const SamplerState &sampler);
+
   typedef pmap<LookupKey, PT(Texture)> Textures;
   Textures _textures;
+
+  // The textures that are being loaded right now, by the thread that is
+  // loading them.  Other threads asking for the same texture wait on the
+  // future rather than reading it again.  Both the Thread and the system
+  // thread id are kept, since threads not created by Panda share a null
+  // Thread pointer, while simple threads all share the same id.
+  struct PendingLoad {
+    PT(AsyncFuture) _future;
+    Thread *_thread = nullptr;
+    std::thread::id _thread_id;
+  };
+  typedef pmap<LookupKey, PendingLoad> PendingLoads;
+  PendingLoads _pending_loads;
+
   typedef pmap<Filename, Filename> RelpathLookup;
   RelpathLookup _relpath_lookup;
 
@@ -0,0 +1,489 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file textureStreamingManager.cxx
+ * @author rdb
+ * @date 2026-10-17
+ */
+
+#include "textureStreamingManager.h"
+#include "asyncTaskManager.h"
+#include "asyncTaskChain.h"
+#include "lightMutexHolder.h"
+#include "clockObject.h"
+
+TextureStreamingManager *TextureStreamingManager::_global_ptr = nullptr;
+patomic<unsigned int> TextureStreamingManager::_add_epoch(0);
+
+PStatCollector TextureStreamingManager::_resident_pcollector("Texture streaming:Resident");
+PStatCollector TextureStreamingManager::_pending_pcollector("Texture stream requests:Pending");
+
+/**
+ *
+ */
+TextureStreamingManager::
+TextureStreamingManager() :
+  _lock("TextureStreamingManager"),
+  _resident_bytes(0),
+  _num_pending(0)
+{
+  _chain = AsyncTaskManager::get_global_ptr()->make_task_chain("texture_streaming");
+  _chain->set_num_threads(texture_streaming_num_threads);
+  _chain->set_thread_priority(texture_streaming_thread_priority);
+}
+
+/**
+ *
+ */
+TextureStreamingManager::
+~TextureStreamingManager() {
+  // Shouldn't be deleting this global object.
+  nassert_raise("attempt to delete TextureStreamingManager");
+}
+
+/**
+ * Starts streaming the indicated texture.  Its mipmap levels larger than
+ * texture-streaming-min-size are dropped from RAM right away, to be loaded
+ * again when they are requested.  The texture must have been read from a file
+ * on disk, since that is where the dropped levels come from.
+ *
+ * Mipmaps are generated for the texture if it is uncompressed and doesn't
+ * have them yet.  A compressed texture without mipmaps cannot be streamed,
+ * and is kept as it is.
+ */
+void TextureStreamingManager::
+add_texture(Texture *tex) {
+  nassertv(tex != nullptr);
+  if (!tex->get_fullpath().empty() && !tex->has_ram_image()) {
+    tex->get_ram_image();
+  }
+  if (!tex->has_ram_image()) {
+    gobj_cat.error()
+      << "Cannot stream texture " << tex->get_name()
+      << ", since it has no RAM image.\n";
+    return;
+  }
+  if (tex->get_ram_image_compression() == Texture::CM_off &&
+      !tex->has_all_ram_mipmap_images()) {
+    tex->generate_ram_mipmap_images();
+  }
+
+  // We hold the only copy of the resident levels, so they should not be
+  // released after they are uploaded.
+  tex->set_keep_ram_image(true);
+
+  int full_size = std::max(tex->get_x_size(), tex->get_y_size());
+  if (tex->get_texture_type() == Texture::TT_3d_texture) {
+    full_size = std::max(full_size, tex->get_z_size());
+  }
+  int num_levels = tex->get_num_ram_mipmap_images();
+  int min_size = std::max((int)texture_streaming_min_size, 1);
+  int min_level = 0;
+  while (min_level + 1 < num_levels && (full_size >> min_level) > min_size) {
+    ++min_level;
+  }
+
+  LightMutexHolder holder(_lock);
+  Entries::iterator ei = _entries.find(tex);
+  if (ei != _entries.end()) {
+    // Already streaming.
+    return;
+  }
+
+  Entry &entry = _entries[tex];
+  entry._texture = tex;
+  entry._full_size = full_size;
+  entry._num_levels = num_levels;
+  entry._min_level = min_level;
+  entry._resident_level = min_level;
+  entry._target_level = min_level;
+  entry._priority = 0;
+  entry._last_frame = ClockObject::get_global_clock()->get_frame_count();
+  entry._resident_bytes = 0;
+
+  if (min_level > 0) {
+    entry._resident_bytes = tex->stream_ram_mipmap_images(tex, min_level);
+  } else {
+    entry._resident_bytes = get_levels_size(tex, 0);
+  }
+  tex->_streaming = true;
+  _add_epoch.fetch_add(1);
+
+  if (gobj_cat.is_debug()) {
+    gobj_cat.debug()
+      << "Streaming texture " << tex->get_name() << " of size " << full_size
+      << ", keeping " << (num_levels - min_level) << " of " << num_levels
+      << " mipmap levels resident\n";
+  }
+
+  // The smallest levels stay resident even if that exceeds the budget.
+  _resident_bytes += entry._resident_bytes;
+  do_make_room(&entry, 0);
+  update_pstats();
+}
+
+/**
+ * Stops streaming the indicated texture.  The levels it has resident are
+ * kept, but no more levels will be loaded, nor will they be dropped to make
+ * room for other textures.
+ */
+void TextureStreamingManager::
+remove_texture(Texture *tex) {
+  LightMutexHolder holder(_lock);
+  Entries::iterator ei = _entries.find(tex);
+  if (ei == _entries.end()) {
+    return;
+  }
+
+  Entry &entry = (*ei).second;
+  if (entry._task != nullptr) {
+    entry._task->remove();
+    --_num_pending;
+  }
+  _resident_bytes -= entry._resident_bytes;
+  _entries.erase(ei);
+  tex->_streaming = false;
+  update_pstats();
+}
+
+/**
+ * Returns true if the indicated texture is being streamed by this manager.
+ */
+bool TextureStreamingManager::
+has_texture(const Texture *tex) const {
+  LightMutexHolder holder(_lock);
+  return _entries.find(tex) != _entries.end();
+}
+
+/**
+ * Specifies the number of bytes that the streaming textures may hold in RAM
+ * together, or -1 for no limit.  If the current usage exceeds the new
+ * budget, the largest levels of the least recently used textures are dropped
+ * immediately.
+ *
+ * The smallest levels of each texture, up to texture-streaming-min-size, are
+ * always kept, and may by themselves exceed the budget.
+ */
+void TextureStreamingManager::
+set_budget(int64_t budget) {
+  // We directly change the config variable.
+  texture_streaming_budget = budget;
+  evict_to_budget();
+}
+
+/**
+ * Returns the mipmap level of the indicated texture that is currently the
+ * most detailed one in RAM, counting from the full-size image, or -1 if the
+ * texture is not being streamed.
+ */
+int TextureStreamingManager::
+get_resident_level(const Texture *tex) const {
+  LightMutexHolder holder(_lock);
+  Entries::const_iterator ei = _entries.find(tex);
+  if (ei == _entries.end()) {
+    return -1;
+  }
+  return (*ei).second._resident_level;
+}
+
+/**
+ * Returns the mipmap level of the indicated texture that always stays in
+ * RAM, counting from the full-size image, or -1 if the texture is not being
+ * streamed.
+ */
+int TextureStreamingManager::
+get_min_level(const Texture *tex) const {
+  LightMutexHolder holder(_lock);
+  Entries::const_iterator ei = _entries.find(tex);
+  if (ei == _entries.end()) {
+    return -1;
+  }
+  return (*ei).second._min_level;
+}
+
+/**
+ * Asks for the indicated mipmap level of the texture, and all the levels
+ * below it, to be brought into RAM.  Requests with a higher priority are
+ * serviced first.  Returns a future that is done when the level has been
+ * loaded (or could not be, for lack of room), or nullptr if the texture is
+ * not being streamed.
+ */
+PT(AsyncFuture) TextureStreamingManager::
+request_level(Texture *tex, int level, int priority) {
+  LightMutexHolder holder(_lock);
+  Entries::iterator ei = _entries.find(tex);
+  if (ei == _entries.end()) {
+    return nullptr;
+  }
+  return do_request_level((*ei).second, level, priority);
+}
+
+/**
+ * Called during the cull traversal for a streaming texture that is applied to
+ * an object that covers about the indicated number of pixels across on the
+ * screen.  Requests the smallest mipmap level that still has at least as
+ * many texels across, on the assumption that the texture is mapped once over
+ * the object.
+ */
+void TextureStreamingManager::
+request_screen_size(Texture *tex, PN_stdfloat size) {
+  if (!(size > 0)) {
+    return;
+  }
+
+  LightMutexHolder holder(_lock);
+  Entries::iterator ei = _entries.find(tex);
+  if (ei == _entries.end()) {
+    return;
+  }
+
+  Entry &entry = (*ei).second;
+  int level = 0;
+  while (level < entry._min_level && (entry._full_size >> (level + 1)) >= size) {
+    ++level;
+  }
+  do_request_level(entry, level, (int)std::min(size, (PN_stdfloat)0x7fffffff));
+}
+
+/**
+ * Drops the largest mipmap levels of the least recently used textures until
+ * the resident bytes fit within the budget again, or until all textures are
+ * down to their smallest levels.
+ */
+void TextureStreamingManager::
+evict_to_budget() {
+  LightMutexHolder holder(_lock);
+  do_make_room(nullptr, 0);
+  update_pstats();
+}
+
+/**
+ * Returns the global streaming manager pointer.
+ */
+TextureStreamingManager *TextureStreamingManager::
+get_global_ptr() {
+  if (_global_ptr == nullptr) {
+    _global_ptr = new TextureStreamingManager;
+  }
+  return _global_ptr;
+}
+
+/**
+ * The implementation of request_level().  Assumes the lock is held.
+ */
+PT(AsyncFuture) TextureStreamingManager::
+do_request_level(Entry &entry, int level, int priority) {
+  level = std::max(std::min(level, entry._min_level), 0);
+
+  // The requests of one frame are combined; those of an earlier frame are
+  // forgotten.
+  int frame = ClockObject::get_global_clock()->get_frame_count();
+  if (frame != entry._last_frame) {
+    entry._last_frame = frame;
+    entry._priority = priority;
+    entry._target_level = level;
+  } else {
+    entry._priority = std::max(entry._priority, priority);
+    entry._target_level = std::min(entry._target_level, level);
+  }
+
+  if (level >= entry._resident_level) {
+    // We already have this level.
+    PT(AsyncFuture) fut = new AsyncFuture;
+    fut->set_result(nullptr);
+    return fut;
+  }
+
+  if (entry._task != nullptr) {
+    // It's already queued to be loaded.  Just make sure the priority is
+    // updated.
+    entry._task->set_priority(std::max(entry._task->get_priority(), priority));
+    return (AsyncFuture *)entry._task.p();
+  }
+
+  PT(Texture) tex = entry._texture.lock();
+  if (tex == nullptr) {
+    // It is being deleted, and will be removed shortly.
+    return nullptr;
+  }
+
+  const Texture *key = tex;
+  entry._task = _chain->add([this, key](AsyncTask *task) {
+    do_load_level(key, task);
+    return AsyncTask::DS_done;
+  }, "stream:" + tex->get_name(), 0, priority);
+  ++_num_pending;
+  update_pstats();
+  return (AsyncFuture *)entry._task.p();
+}
+
+/**
+ * Runs in a streaming thread to load the target level of the indicated
+ * texture from disk.
+ */
+void TextureStreamingManager::
+do_load_level(const Texture *key, AsyncTask *task) {
+  PT(Texture) tex;
+  {
+    LightMutexHolder holder(_lock);
+    Entries::iterator ei = _entries.find(key);
+    if (ei == _entries.end() || (*ei).second._task != task) {
+      return;
+    }
+    tex = (*ei).second._texture.lock();
+    if (tex == nullptr) {
+      return;
+    }
+  }
+
+  // The full image is read into a copy of the texture, so that the texture
+  // itself can still be rendered in the meantime.
+  PT(Texture) source = tex->make_copy();
+  bool success = source->reload();
+  if (success && source->get_ram_image_compression() == Texture::CM_off &&
+      !source->has_all_ram_mipmap_images()) {
+    source->generate_ram_mipmap_images();
+  }
+
+  LightMutexHolder holder(_lock);
+  Entries::iterator ei = _entries.find(key);
+  if (ei == _entries.end() || (*ei).second._task != task) {
+    // The texture was removed while we were loading it.
+    return;
+  }
+
+  Entry &entry = (*ei).second;
+  entry._task = nullptr;
+  --_num_pending;
+
+  if (!success) {
+    gobj_cat.error()
+      << "Could not stream in texture " << tex->get_name() << "\n";
+    update_pstats();
+    return;
+  }
+
+  // Take the most recent request into account, and make room for it,
+  // settling for a smaller level if we can't.
+  int level = entry._target_level;
+  level = std::min(level, source->get_num_ram_mipmap_images() - 1);
+  while (level < entry._resident_level) {
+    size_t size = get_levels_size(source, level);
+    if (size <= entry._resident_bytes ||
+        do_make_room(&entry, size - entry._resident_bytes)) {
+      break;
+    }
+    ++level;
+  }
+
+  if (level < entry._resident_level) {
+    size_t bytes = tex->stream_ram_mipmap_images(source, level);
+    _resident_bytes += bytes;
+    _resident_bytes -= entry._resident_bytes;
+    entry._resident_bytes = bytes;
+    entry._resident_level = level;
+
+    if (gobj_cat.is_debug()) {
+      gobj_cat.debug()
+        << "Streamed in level " << level << " of texture " << tex->get_name()
+        << ", " << _resident_bytes << " bytes resident\n";
+    }
+  }
+  update_pstats();
+}
+
+/**
+ * Drops levels of other textures until there are at least the indicated
+ * number of bytes left in the budget.  If keep is not null, only textures
+ * that are less important than it are considered.  Returns true if enough
+ * room was made.  Assumes the lock is held.
+ */
+bool TextureStreamingManager::
+do_make_room(const Entry *keep, size_t needed) {
+  int64_t budget = texture_streaming_budget;
+  if (budget < 0) {
+    return true;
+  }
+
+  while (_resident_bytes + needed > (uint64_t)budget) {
+    // Find the least recently used texture, with the lowest priority, that
+    // still has a level that it can give up.
+    Entry *victim = nullptr;
+    PT(Texture) victim_tex;
+    for (Entries::iterator ei = _entries.begin(); ei != _entries.end(); ++ei) {
+      Entry &entry = (*ei).second;
+      if (&entry == keep || entry._resident_level >= entry._min_level) {
+        continue;
+      }
+      if (keep != nullptr &&
+          (entry._last_frame > keep->_last_frame ||
+           (entry._last_frame == keep->_last_frame && entry._priority >= keep->_priority))) {
+        continue;
+      }
+      if (victim != nullptr &&
+          (entry._last_frame > victim->_last_frame ||
+           (entry._last_frame == victim->_last_frame && entry._priority >= victim->_priority))) {
+        continue;
+      }
+      PT(Texture) tex = entry._texture.lock();
+      if (tex != nullptr) {
+        victim = &entry;
+        victim_tex = std::move(tex);
+      }
+    }
+
+    if (victim == nullptr) {
+      return false;
+    }
+    do_drop_level(*victim, victim_tex);
+  }
+
+  return true;
+}
+
+/**
+ * Drops the largest resident mipmap level of the indicated texture.  Assumes
+ * the lock is held.
+ */
+void TextureStreamingManager::
+do_drop_level(Entry &entry, Texture *tex) {
+  size_t bytes = tex->stream_ram_mipmap_images(tex, 1);
+  _resident_bytes += bytes;
+  _resident_bytes -= entry._resident_bytes;
+  entry._resident_bytes = bytes;
+  ++entry._resident_level;
+
+  if (gobj_cat.is_debug()) {
+    gobj_cat.debug()
+      << "Dropped texture " << tex->get_name() << " to level "
+      << entry._resident_level << "\n";
+  }
+}
+
+/**
+ * Updates the PStats levels.  Assumes the lock is held.
+ */
+void TextureStreamingManager::
+update_pstats() {
+  _resident_pcollector.set_level((double)_resident_bytes);
+  _pending_pcollector.set_level(_num_pending);
+}
+
+/**
+ * Returns the number of bytes in the RAM images of the indicated texture,
+ * from the given mipmap level down to the smallest.
+ */
+size_t TextureStreamingManager::
+get_levels_size(const Texture *tex, int first_level) {
+  size_t size = 0;
+  int num_levels = tex->get_num_ram_mipmap_images();
+  for (int n = first_level; n < num_levels; ++n) {
+    size += tex->get_ram_mipmap_image(n).size();
+  }
+  return size;
+}
@@ -0,0 +1,123 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file textureStreamingManager.h
+ * @author rdb
+ * @date 2026-10-17
+ */
+
+#ifndef TEXTURESTREAMINGMANAGER_H
+#define TEXTURESTREAMINGMANAGER_H
+
+#include "pandabase.h"
+#include "config_gobj.h"
+#include "texture.h"
+#include "asyncTask.h"
+#include "asyncFuture.h"
+#include "lightMutex.h"
+#include "pStatCollector.h"
+#include "weakPointerTo.h"
+#include "pmap.h"
+#include "patomic.h"
+
+/**
+ * Keeps track of the textures that are streamed in, one mipmap level at a
+ * time, as they are needed for rendering.
+ *
+ * A streaming texture keeps only its smallest mipmap levels in RAM at first,
+ * up to texture-streaming-min-size, and behaves as though it were a smaller
+ * texture.  When the cull traversal finds it on an object that covers enough
+ * of the screen to need a more detailed level, it asks for it here.  The
+ * image is then reloaded from disk in a background thread, and the texture is
+ * grown to include the levels that were asked for, after which the GSG
+ * uploads it again.  Requests for objects that cover more of the screen are
+ * serviced first.
+ *
+ * When the bytes held by all streaming textures would exceed the budget, the
+ * largest levels of the textures that have gone unused the longest are
+ * dropped again to make room.
+ */
+class EXPCL_PANDA_GOBJ TextureStreamingManager {
+protected:
+  TextureStreamingManager();
+  ~TextureStreamingManager();
+
+PUBLISHED:
+  void add_texture(Texture *tex);
+  void remove_texture(Texture *tex);
+  bool has_texture(const Texture *tex) const;
+
+  void set_budget(int64_t budget);
+  INLINE int64_t get_budget() const;
+  MAKE_PROPERTY(budget, get_budget, set_budget);
+
+  INLINE size_t get_resident_bytes() const;
+  INLINE int get_num_pending_requests() const;
+  MAKE_PROPERTY(resident_bytes, get_resident_bytes);
+  MAKE_PROPERTY(num_pending_requests, get_num_pending_requests);
+
+  int get_resident_level(const Texture *tex) const;
+  int get_min_level(const Texture *tex) const;
+
+  PT(AsyncFuture) request_level(Texture *tex, int level, int priority = 0);
+  void request_screen_size(Texture *tex, PN_stdfloat size);
+
+  void evict_to_budget();
+
+  static TextureStreamingManager *get_global_ptr();
+
+public:
+  INLINE static unsigned int get_add_epoch();
+
+private:
+  class Entry {
+  public:
+    WeakPointerTo<Texture> _texture;
+    int _full_size;
+    int _num_levels;
+    int _min_level;
+    int _resident_level;
+    int _target_level;
+    int _priority;
+    int _last_frame;
+    size_t _resident_bytes;
+    PT(AsyncTask) _task;
+  };
+  typedef pmap<const Texture *, Entry> Entries;
+
+  PT(AsyncFuture) do_request_level(Entry &entry, int level, int priority);
+  void do_load_level(const Texture *key, AsyncTask *task);
+  bool do_make_room(const Entry *keep, size_t needed);
+  void do_drop_level(Entry &entry, Texture *tex);
+  void update_pstats();
+
+  static size_t get_levels_size(const Texture *tex, int first_level);
+
+private:
+  // Protects the entries and the totals below.
+  mutable LightMutex _lock;
+
+  Entries _entries;
+  size_t _resident_bytes;
+  int _num_pending;
+
+  PT(AsyncTaskChain) _chain;
+
+  static TextureStreamingManager *_global_ptr;
+
+  // This is incremented each time a texture starts streaming.
+  static patomic<unsigned int> _add_epoch;
+
+public:
+  static PStatCollector _resident_pcollector;
+  static PStatCollector _pending_pcollector;
+};
+
+#include "textureStreamingManager.I"
+
+#endif
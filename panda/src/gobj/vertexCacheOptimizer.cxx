@@ -0,0 +1,520 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file vertexCacheOptimizer.cxx
+ * @author rdb
+ * @date 2026-10-17
+ */
+
+#include "vertexCacheOptimizer.h"
+#include "geomVertexReader.h"
+#include "geomVertexWriter.h"
+#include "geomVertexRewriter.h"
+#include "transformBlendTable.h"
+#include "sliderTable.h"
+#include "vector_uchar.h"
+
+#include <algorithm>
+#include <math.h>
+
+// These are the tuning parameters suggested by Forsyth.
+static const float cache_decay_power = 1.5f;
+static const float last_tri_score = 0.75f;
+static const float valence_boost_scale = 2.0f;
+static const float valence_boost_power = 0.5f;
+
+/**
+ * Returns the score of a vertex with the indicated position in the simulated
+ * LRU cache (or -1 if it isn't in the cache), and the indicated number of
+ * triangles still to be emitted that use it.
+ */
+static float
+calc_vertex_score(int cache_pos, int num_live_tris, int cache_size) {
+  if (num_live_tris == 0) {
+    // No triangle needs this vertex anymore.
+    return -1.0f;
+  }
+
+  float score = 0.0f;
+  if (cache_pos >= 0) {
+    if (cache_pos < 3) {
+      // This vertex was used in the last triangle, so it has a fixed score,
+      // to avoid favoring one of the last triangle's edges over another.
+      score = last_tri_score;
+    } else {
+      // The older the vertex, the lower the score.
+      float scaler = 1.0f / (float)(cache_size - 3);
+      score = powf(1.0f - (float)(cache_pos - 3) * scaler, cache_decay_power);
+    }
+  }
+
+  // Give a boost to vertices with only a few triangles left, to get rid of
+  // lone triangles before they become expensive to pick up later.
+  score += valence_boost_scale * powf((float)num_live_tris, -valence_boost_power);
+  return score;
+}
+
+/**
+ * Reorders the triangles for better use of the post-transform vertex cache of
+ * the GPU, which is assumed to hold the indicated number of vertices.  The
+ * indices must all be less than num_vertices.
+ */
+void VertexCacheOptimizer::
+optimize_vertex_cache(int *indices, size_t num_indices, int num_vertices,
+                      int cache_size) {
+  size_t num_tris = num_indices / 3;
+  if (num_tris < 2) {
+    return;
+  }
+  cache_size = std::max(cache_size, 4);
+
+  // Build the table of triangles using each vertex.  The first num_live
+  // entries in each vertex's range are the triangles that have not yet been
+  // emitted.
+  pvector<int> num_live(num_vertices, 0);
+  for (size_t i = 0; i < num_tris * 3; ++i) {
+    nassertv(indices[i] >= 0 && indices[i] < num_vertices);
+    ++num_live[indices[i]];
+  }
+
+  pvector<int> offsets(num_vertices + 1);
+  offsets[0] = 0;
+  for (int v = 0; v < num_vertices; ++v) {
+    offsets[v + 1] = offsets[v] + num_live[v];
+  }
+
+  pvector<int> adjacency(num_tris * 3);
+  {
+    pvector<int> fill(offsets);
+    for (size_t t = 0; t < num_tris; ++t) {
+      for (int k = 0; k < 3; ++k) {
+        adjacency[fill[indices[t * 3 + k]]++] = (int)t;
+      }
+    }
+  }
+
+  pvector<int> cache_pos(num_vertices, -1);
+  pvector<float> vertex_score(num_vertices);
+  for (int v = 0; v < num_vertices; ++v) {
+    vertex_score[v] = calc_vertex_score(-1, num_live[v], cache_size);
+  }
+
+  // Start with the best-scoring triangle overall.
+  int best_tri = -1;
+  float best_score = -1.0f;
+  for (size_t t = 0; t < num_tris; ++t) {
+    const int *tri = indices + t * 3;
+    float score = vertex_score[tri[0]] + vertex_score[tri[1]] + vertex_score[tri[2]];
+    if (score > best_score) {
+      best_score = score;
+      best_tri = (int)t;
+    }
+  }
+
+  vector_uchar emitted(num_tris, 0);
+  size_t next_unemitted = 0;
+  pvector<int> output;
+  output.reserve(num_tris * 3);
+
+  // The simulated cache holds up to three more vertices than cache_size
+  // while it is being updated.
+  pvector<int> cache;
+  pvector<int> new_cache;
+  cache.reserve(cache_size + 3);
+  new_cache.reserve(cache_size + 3);
+
+  for (size_t n = 0; n < num_tris; ++n) {
+    if (best_tri < 0) {
+      // None of the vertices in the cache are used by any of the remaining
+      // triangles, so just move on to the next one in the original order.
+      while (emitted[next_unemitted]) {
+        ++next_unemitted;
+      }
+      best_tri = (int)next_unemitted;
+    }
+
+    const int *tri = indices + best_tri * 3;
+    output.insert(output.end(), tri, tri + 3);
+    emitted[best_tri] = 1;
+
+    // Remove the triangle from the live triangles of its vertices, and move
+    // the vertices to the front of the cache.
+    new_cache.clear();
+    for (int k = 0; k < 3; ++k) {
+      int v = tri[k];
+      int *begin = &adjacency[offsets[v]];
+      int *end = begin + num_live[v];
+      int *found = std::find(begin, end, best_tri);
+      if (found != end) {
+        *found = *(end - 1);
+        --num_live[v];
+      }
+      if (std::find(new_cache.begin(), new_cache.end(), v) == new_cache.end()) {
+        new_cache.push_back(v);
+      }
+    }
+    for (int v : cache) {
+      if (v != tri[0] && v != tri[1] && v != tri[2]) {
+        new_cache.push_back(v);
+      }
+    }
+
+    // Update the scores of the vertices in the cache, including the ones
+    // that have just been pushed out of it.
+    for (size_t i = 0; i < new_cache.size(); ++i) {
+      int v = new_cache[i];
+      cache_pos[v] = (i < (size_t)cache_size) ? (int)i : -1;
+      vertex_score[v] = calc_vertex_score(cache_pos[v], num_live[v], cache_size);
+    }
+    if (new_cache.size() > (size_t)cache_size) {
+      new_cache.resize(cache_size);
+    }
+    cache.swap(new_cache);
+
+    // The next triangle is the best-scoring one that shares a vertex with
+    // the cache.
+    best_tri = -1;
+    best_score = -1.0f;
+    for (int v : cache) {
+      const int *live = &adjacency[offsets[v]];
+      for (int j = 0; j < num_live[v]; ++j) {
+        const int *other = indices + live[j] * 3;
+        float score = vertex_score[other[0]] + vertex_score[other[1]] + vertex_score[other[2]];
+        if (score > best_score) {
+          best_score = score;
+          best_tri = live[j];
+        }
+      }
+    }
+  }
+
+  std::copy(output.begin(), output.end(), indices);
+}
+
+/**
+ * Reorders the triangles, which should already have been optimized for the
+ * vertex cache, to reduce overdraw.  The triangles are divided into clusters
+ * at the points where the cache would be flushed anyway, or where splitting
+ * them increases the ACMR of the cluster by no more than the given factor
+ * (eg. 1.05); then the clusters that face outward from the center of the
+ * mesh are moved to the front, so that they occlude the others.
+ */
+void VertexCacheOptimizer::
+optimize_overdraw(int *indices, size_t num_indices, const LVecBase3 *positions,
+                  int num_vertices, int cache_size, PN_stdfloat threshold) {
+  size_t num_tris = num_indices / 3;
+  if (num_tris < 2 || positions == nullptr) {
+    return;
+  }
+  cache_size = std::max(cache_size, 1);
+
+  // This simulates a FIFO cache, which is what most GPUs implement.
+  pvector<unsigned int> cache_time(num_vertices, 0);
+  unsigned int time = cache_size + 1;
+  auto count_misses = [&] (const int *tri) {
+    int misses = 0;
+    for (int k = 0; k < 3; ++k) {
+      int v = tri[k];
+      nassertr(v >= 0 && v < num_vertices, 0);
+      if (time - cache_time[v] > (unsigned int)cache_size) {
+        cache_time[v] = time++;
+        ++misses;
+      }
+    }
+    return misses;
+  };
+  auto flush_cache = [&] () {
+    time += cache_size + 1;
+  };
+
+  // First find the points where all three vertices of a triangle miss the
+  // cache.  Reordering the triangles at those points costs nothing.
+  pvector<size_t> hard_clusters;
+  for (size_t t = 0; t < num_tris; ++t) {
+    if (count_misses(indices + t * 3) == 3 || t == 0) {
+      hard_clusters.push_back(t);
+    }
+  }
+  hard_clusters.push_back(num_tris);
+
+  // Then subdivide those, wherever the ACMR so far is already within the
+  // threshold of the ACMR of the cluster as a whole.
+  pvector<size_t> clusters;
+  for (size_t c = 0; c + 1 < hard_clusters.size(); ++c) {
+    size_t start = hard_clusters[c];
+    size_t end = hard_clusters[c + 1];
+
+    flush_cache();
+    int cluster_misses = 0;
+    for (size_t t = start; t < end; ++t) {
+      cluster_misses += count_misses(indices + t * 3);
+    }
+    float limit = (float)cluster_misses / (float)(end - start) * (float)threshold;
+
+    flush_cache();
+    size_t begin = start;
+    int misses = 0;
+    clusters.push_back(start);
+    for (size_t t = start; t + 1 < end; ++t) {
+      misses += count_misses(indices + t * 3);
+      if ((float)misses <= limit * (float)(t + 1 - begin)) {
+        clusters.push_back(t + 1);
+        begin = t + 1;
+        misses = 0;
+        flush_cache();
+      }
+    }
+  }
+  size_t num_clusters = clusters.size();
+  clusters.push_back(num_tris);
+
+  if (num_clusters < 2) {
+    return;
+  }
+
+  LPoint3 mesh_center(0);
+  for (size_t i = 0; i < num_tris * 3; ++i) {
+    mesh_center += positions[indices[i]];
+  }
+  mesh_center /= (PN_stdfloat)(num_tris * 3);
+
+  // Sort the clusters by how much they face away from the center.
+  pvector<std::pair<PN_stdfloat, size_t> > sort_keys;
+  sort_keys.reserve(num_clusters);
+  for (size_t c = 0; c < num_clusters; ++c) {
+    LPoint3 center(0);
+    LVector3 normal(0);
+    PN_stdfloat total_area = 0;
+    for (size_t t = clusters[c]; t < clusters[c + 1]; ++t) {
+      const LVecBase3 &p0 = positions[indices[t * 3]];
+      const LVecBase3 &p1 = positions[indices[t * 3 + 1]];
+      const LVecBase3 &p2 = positions[indices[t * 3 + 2]];
+      LVector3 tri_normal = (p1 - p0).cross(p2 - p0);
+      PN_stdfloat area = tri_normal.length();
+      center += (p0 + p1 + p2) * (area / 3);
+      normal += tri_normal;
+      total_area += area;
+    }
+    if (total_area > 0) {
+      center /= total_area;
+    } else {
+      center = positions[indices[clusters[c] * 3]];
+    }
+    normal.normalize();
+    sort_keys.push_back(std::make_pair(-(center - mesh_center).dot(normal), c));
+  }
+  std::stable_sort(sort_keys.begin(), sort_keys.end(),
+    [] (const std::pair<PN_stdfloat, size_t> &a, const std::pair<PN_stdfloat, size_t> &b) {
+      return a.first < b.first;
+    });
+
+  pvector<int> output;
+  output.reserve(num_tris * 3);
+  for (const auto &key : sort_keys) {
+    size_t c = key.second;
+    output.insert(output.end(), indices + clusters[c] * 3, indices + clusters[c + 1] * 3);
+  }
+  std::copy(output.begin(), output.end(), indices);
+}
+
+/**
+ * Computes a new order for the vertices, in which they appear in the order in
+ * which they are first referenced by the indices, followed by the vertices
+ * that are not referenced at all.  This improves the locality of vertex
+ * fetches.  Fills remap with the new index of each original vertex, and
+ * returns true if this is different from the current order.
+ */
+bool VertexCacheOptimizer::
+optimize_vertex_fetch(const int *indices, size_t num_indices, int num_vertices,
+                      pvector<int> &remap) {
+  remap.assign(num_vertices, -1);
+  int next_index = 0;
+  for (size_t i = 0; i < num_indices; ++i) {
+    int v = indices[i];
+    nassertr(v >= 0 && v < num_vertices, false);
+    if (remap[v] < 0) {
+      remap[v] = next_index++;
+    }
+  }
+
+  bool changed = false;
+  for (int v = 0; v < num_vertices; ++v) {
+    if (remap[v] < 0) {
+      remap[v] = next_index++;
+    }
+    if (remap[v] != v) {
+      changed = true;
+    }
+  }
+  return changed;
+}
+
+/**
+ * Returns the average number of cache misses per triangle (the ACMR) when
+ * rendering the indicated triangles with a FIFO vertex cache of the indicated
+ * size.  This ranges from 3 in the worst case down to about 0.5 for a large
+ * regular grid.
+ */
+PN_stdfloat VertexCacheOptimizer::
+calc_acmr(const int *indices, size_t num_indices, int num_vertices,
+          int cache_size) {
+  size_t num_tris = num_indices / 3;
+  if (num_tris == 0) {
+    return 0;
+  }
+  cache_size = std::max(cache_size, 1);
+
+  pvector<unsigned int> cache_time(num_vertices, 0);
+  unsigned int time = cache_size + 1;
+  size_t misses = 0;
+  for (size_t i = 0; i < num_tris * 3; ++i) {
+    int v = indices[i];
+    nassertr(v >= 0 && v < num_vertices, 0);
+    if (time - cache_time[v] > (unsigned int)cache_size) {
+      cache_time[v] = time++;
+      ++misses;
+    }
+  }
+  return (PN_stdfloat)misses / (PN_stdfloat)num_tris;
+}
+
+/**
+ * Appends the vertex indices used by the primitive to the indicated vector,
+ * leaving out the strip-cut indices.
+ */
+void VertexCacheOptimizer::
+read_indices(const GeomPrimitive *prim, pvector<int> &indices,
+             Thread *current_thread) {
+  int num_vertices = prim->get_num_vertices();
+  indices.reserve(indices.size() + num_vertices);
+  if (!prim->is_indexed()) {
+    int first_vertex = prim->get_first_vertex();
+    for (int i = 0; i < num_vertices; ++i) {
+      indices.push_back(first_vertex + i);
+    }
+    return;
+  }
+
+  int strip_cut_index = prim->get_strip_cut_index();
+  GeomVertexReader reader(prim->get_vertices(), 0, current_thread);
+  while (!reader.is_at_end()) {
+    int index = reader.get_data1i();
+    if (index != strip_cut_index) {
+      indices.push_back(index);
+    }
+  }
+}
+
+/**
+ * Replaces the vertex indices of the primitive, which must not contain any
+ * strip-cut indices, with the indicated indices, of which there must be as
+ * many as the primitive already has.
+ */
+void VertexCacheOptimizer::
+write_indices(GeomPrimitive *prim, const int *indices, Thread *current_thread) {
+  int num_vertices = prim->get_num_vertices();
+  PT(GeomVertexArrayData) vertices = prim->modify_vertices();
+  GeomVertexWriter writer(vertices, 0, current_thread);
+  for (int i = 0; i < num_vertices; ++i) {
+    writer.set_data1i(indices[i]);
+  }
+}
+
+/**
+ * Replaces each vertex index of the primitive with the corresponding entry
+ * in the remap table.
+ */
+void VertexCacheOptimizer::
+remap_indices(GeomPrimitive *prim, const pvector<int> &remap,
+              Thread *current_thread) {
+  int strip_cut_index = prim->get_strip_cut_index();
+  PT(GeomVertexArrayData) vertices = prim->modify_vertices();
+  GeomVertexRewriter rewriter(vertices, 0, current_thread);
+  while (!rewriter.is_at_end()) {
+    int index = rewriter.get_data1i();
+    if (index != strip_cut_index) {
+      nassertv(index >= 0 && index < (int)remap.size());
+      rewriter.set_data1i(remap[index]);
+    } else {
+      rewriter.set_data1i(index);
+    }
+  }
+}
+
+/**
+ * Returns a copy of the vertex data in which each row has been moved to the
+ * position given by the corresponding entry in the remap table, which must
+ * be a permutation of the rows.  The rows of the animation tables, if any,
+ * are remapped accordingly.
+ */
+PT(GeomVertexData) VertexCacheOptimizer::
+remap_vertices(const GeomVertexData *vdata, const pvector<int> &remap,
+               Thread *current_thread) {
+  int num_rows = vdata->get_num_rows();
+  nassertr((int)remap.size() == num_rows, nullptr);
+
+  PT(GeomVertexData) new_vdata = new GeomVertexData(*vdata);
+  {
+    GeomVertexDataPipelineReader reader(vdata, current_thread);
+    reader.check_array_readers();
+    GeomVertexDataPipelineWriter writer(new_vdata, true, current_thread);
+    writer.check_array_writers();
+
+    size_t num_arrays = vdata->get_num_arrays();
+    for (size_t a = 0; a < num_arrays; ++a) {
+      const GeomVertexArrayDataHandle *array_reader = reader.get_array_reader(a);
+      GeomVertexArrayDataHandle *array_writer = writer.get_array_writer(a);
+
+      size_t stride = array_reader->get_array_format()->get_stride();
+      nassertr(stride == (size_t)array_writer->get_array_format()->get_stride(), nullptr);
+
+      const unsigned char *source = array_reader->get_read_pointer(true);
+      unsigned char *dest = array_writer->get_write_pointer();
+      nassertr(source != dest, nullptr);
+      for (int i = 0; i < num_rows; ++i) {
+        memcpy(dest + (size_t)remap[i] * stride, source + (size_t)i * stride, stride);
+      }
+    }
+  }
+
+  PT(TransformBlendTable) tbtable = new_vdata->modify_transform_blend_table();
+  if (tbtable != nullptr) {
+    tbtable->set_rows(remap_rows(tbtable->get_rows(), remap));
+  }
+
+  const SliderTable *sliders = vdata->get_slider_table();
+  if (sliders != nullptr) {
+    PT(SliderTable) new_sliders = new SliderTable(*sliders);
+    size_t num_sliders = sliders->get_num_sliders();
+    for (size_t n = 0; n < num_sliders; ++n) {
+      new_sliders->set_slider_rows(n, remap_rows(sliders->get_slider_rows(n), remap));
+    }
+    new_vdata->set_slider_table(SliderTable::register_table(new_sliders));
+  }
+
+  return new_vdata;
+}
+
+/**
+ * Returns the set of rows that the indicated rows are moved to by the remap
+ * table.
+ */
+SparseArray VertexCacheOptimizer::
+remap_rows(const SparseArray &rows, const pvector<int> &remap) {
+  SparseArray new_rows;
+  int num_rows = (int)remap.size();
+  size_t num_subranges = rows.get_num_subranges();
+  for (size_t si = 0; si < num_subranges; ++si) {
+    int begin = rows.get_subrange_begin(si);
+    int end = std::min(rows.get_subrange_end(si), num_rows);
+    for (int row = begin; row < end; ++row) {
+      new_rows.set_bit(remap[row]);
+    }
+  }
+  return new_rows;
+}
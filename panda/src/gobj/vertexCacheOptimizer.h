@@ -0,0 +1,63 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file vertexCacheOptimizer.h
+ * @author rdb
+ * @date 2026-10-17
+ */
+
+#ifndef VERTEXCACHEOPTIMIZER_H
+#define VERTEXCACHEOPTIMIZER_H
+
+#include "pandabase.h"
+#include "geomVertexData.h"
+#include "geomPrimitive.h"
+#include "sparseArray.h"
+#include "luse.h"
+#include "pvector.h"
+
+/**
+ * A collection of algorithms that reorder the triangles and vertices of a
+ * mesh for more efficient rendering.  The triangle-level functions operate on
+ * plain arrays of vertex indices, three per triangle.  See
+ * Geom::optimize_vertex_cache() and SceneGraphReducer::optimize_vertex_cache()
+ * for the high-level interface.
+ *
+ * The triangle ordering follows Tom Forsyth's "Linear-Speed Vertex Cache
+ * Optimisation", and the overdraw ordering follows the cluster sorting
+ * described in Sander, Nehab and Barczak's "Fast Triangle Reordering for
+ * Vertex Locality and Reduced Overdraw".
+ */
+class EXPCL_PANDA_GOBJ VertexCacheOptimizer {
+public:
+  static void optimize_vertex_cache(int *indices, size_t num_indices,
+                                    int num_vertices, int cache_size);
+  static void optimize_overdraw(int *indices, size_t num_indices,
+                                const LVecBase3 *positions, int num_vertices,
+                                int cache_size, PN_stdfloat threshold);
+  static bool optimize_vertex_fetch(const int *indices, size_t num_indices,
+                                    int num_vertices, pvector<int> &remap);
+  static PN_stdfloat calc_acmr(const int *indices, size_t num_indices,
+                               int num_vertices, int cache_size);
+
+  static void read_indices(const GeomPrimitive *prim, pvector<int> &indices,
+                           Thread *current_thread);
+  static void write_indices(GeomPrimitive *prim, const int *indices,
+                            Thread *current_thread);
+  static void remap_indices(GeomPrimitive *prim, const pvector<int> &remap,
+                            Thread *current_thread);
+  static PT(GeomVertexData) remap_vertices(const GeomVertexData *vdata,
+                                           const pvector<int> &remap,
+                                           Thread *current_thread);
+
+private:
+  static SparseArray remap_rows(const SparseArray &rows,
+                                const pvector<int> &remap);
+};
+
+#endif
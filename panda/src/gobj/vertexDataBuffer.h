@@ -59,6 +59,7 @@ public:
 
   INLINE const unsigned char *get_read_pointer(bool force) const RETURNS_ALIGNED(MEMORY_HOOK_ALIGNMENT);
   INLINE unsigned char *get_write_pointer() RETURNS_ALIGNED(MEMORY_HOOK_ALIGNMENT);
+  INLINE bool request_prefetch() const;
 
   INLINE size_t get_size() const;
   INLINE size_t get_reserved_size() const;
@@ -13,6 +13,7 @@
 
 #include "vertexDataPage.h"
 #include "configVariableInt.h"
+#include "configVariableBool.h"
 #include "vertexDataSaveFile.h"
 #include "vertexDataBook.h"
 #include "vertexDataBlock.h"
@@ -47,6 +48,15 @@ ConfigVariableInt vertex_data_compression_level
           "vertex data.  The number should be in the range 1 to 9, where "
           "larger values are slower but give better compression."));
 
+ConfigVariableBool vertex_data_compress_on_disk
+("vertex-data-compress-on-disk", true,
+ PRC_DESC("Set this true to compress vertex data pages before they are "
+          "written to disk, even if they are not kept compressed in RAM "
+          "(see max-compressed-vertex-data).  This uses less disk space, and "
+          "the pages can usually be read back in more quickly, at the cost "
+          "of compressing them first.  This has no effect if Panda was "
+          "compiled without zlib."));
+
 ConfigVariableInt max_disk_vertex_data
 ("max-disk-vertex-data", -1,
  PRC_DESC("Specifies the maximum number of bytes of vertex data "
@@ -81,6 +91,10 @@ PStatCollector VertexDataPage::_vdata_decompress_pcollector("*:Vertex Data:Decom
 PStatCollector VertexDataPage::_vdata_save_pcollector("*:Vertex Data:Save");
 PStatCollector VertexDataPage::_vdata_restore_pcollector("*:Vertex Data:Restore");
 PStatCollector VertexDataPage::_thread_wait_pcollector("Wait:Idle");
+PStatCollector VertexDataPage::_stall_pcollector("Wait:Vertex data");
+PStatCollector VertexDataPage::_page_in_pcollector("Vertex pages:In");
+PStatCollector VertexDataPage::_page_out_pcollector("Vertex pages:Out");
+PStatCollector VertexDataPage::_prefetch_pcollector("Vertex pages:Prefetched");
 PStatCollector VertexDataPage::_alloc_pages_pcollector("System memory:MMap:Vertex data");
 
 TypeHandle VertexDataPage::_type_handle;
@@ -116,6 +130,7 @@ VertexDataPage(size_t book_size) :
   _uncompressed_size = 0;
   _ram_class = RC_resident;
   _pending_ram_class = RC_resident;
+  _pending_prefetch = false;
 }
 
 /**
@@ -135,6 +150,7 @@ VertexDataPage(VertexDataBook *book, size_t page_size, size_t block_size) :
 
   _uncompressed_size = _size;
   _pending_ram_class = RC_resident;
+  _pending_prefetch = false;
   set_ram_class(RC_resident);
 }
 
@@ -319,14 +335,18 @@ do_alloc(size_t size) {
  */
 void VertexDataPage::
 make_resident_now() {
+  PStatTimer timer(_stall_pcollector);
+
   MutexHolder holder(_tlock);
   if (_pending_ram_class != _ram_class) {
     nassertv(_thread_mgr != nullptr);
     _thread_mgr->remove_page(this);
   }
 
+  RamClass orig_ram_class = _ram_class;
   make_resident();
   _pending_ram_class = RC_resident;
+  record_ram_class_change(orig_ram_class, _ram_class, false);
 }
 
 /**
@@ -563,6 +583,15 @@ make_disk() {
     return;
   }
 
+#ifdef HAVE_ZLIB
+  if (_ram_class == RC_resident && _saved_block == nullptr &&
+      vertex_data_compress_on_disk) {
+    // Compress the page first, so that there is less to write now and to
+    // read back in later.
+    make_compressed();
+  }
+#endif
+
   if (_ram_class == RC_resident || _ram_class == RC_compressed) {
     if (!do_save_to_disk()) {
       // Can't save it to disk for some reason.
@@ -599,9 +628,12 @@ do_save_to_disk() {
           << "Storing page, " << _size << " bytes, to disk\n";
       }
 
+      // A compressed page is usually much smaller than the buffer it was
+      // allocated in, so there is no need to write out the whole buffer.
       bool compressed = (_ram_class == RC_compressed);
+      size_t size = compressed ? _size : _allocated_size;
 
-      _saved_block = get_save_file()->write_data(_page_data, _allocated_size, compressed);
+      _saved_block = get_save_file()->write_data(_page_data, size, compressed);
       if (_saved_block == nullptr) {
         // Can't write it to disk.  Too bad.
         return false;
@@ -639,7 +671,7 @@ do_restore_from_disk() {
 
     size_t new_allocated_size = round_up(buffer_size);
     unsigned char *new_data = alloc_page_data(new_allocated_size);
-    if (!get_save_file()->read_data(new_data, new_allocated_size, _saved_block)) {
+    if (!get_save_file()->read_data(new_data, buffer_size, _saved_block)) {
       nassert_raise("read error");
     }
 
@@ -685,13 +717,23 @@ adjust_book_size() {
  * using threading).  The page will be enqueued in the thread, which will
  * eventually be responsible for setting the requested ram class.
  *
+ * If prefetch is true, the request is only serviced when the thread has
+ * nothing else to do, and it is ignored altogether if there are no threads.
+ *
  * Assumes the page's lock is already held.
  */
 void VertexDataPage::
-request_ram_class(RamClass ram_class) {
+request_ram_class(RamClass ram_class, bool prefetch) {
   int num_threads = vertex_data_page_threads;
   if (num_threads == 0 || !Thread::is_threading_supported()) {
+    if (prefetch) {
+      // There's no sense in doing this in the main thread before it is
+      // actually needed.
+      return;
+    }
+
     // No threads.  Do it immediately.
+    RamClass orig_ram_class = _ram_class;
     switch (ram_class) {
     case RC_resident:
       make_resident();
@@ -709,6 +751,7 @@ request_ram_class(RamClass ram_class) {
       break;
     }
     _pending_ram_class = ram_class;
+    record_ram_class_change(orig_ram_class, _ram_class, false);
     return;
   }
 
@@ -720,7 +763,7 @@ request_ram_class(RamClass ram_class) {
     _thread_mgr = new PageThreadManager(num_threads);
   }
 
-  _thread_mgr->add_page(this, ram_class);
+  _thread_mgr->add_page(this, ram_class, prefetch);
 }
 
 /**
@@ -735,6 +778,26 @@ make_save_file() {
                                       vertex_save_file_prefix, max_size);
 }
 
+/**
+ * Counts a page that has changed from one ram class to another in PStats.
+ * Assumes _tlock is held, or that there are no paging threads.
+ */
+void VertexDataPage::
+record_ram_class_change(RamClass from, RamClass to, bool prefetch) {
+  if (to == from) {
+    return;
+  }
+  if (to == RC_resident) {
+    if (prefetch) {
+      _prefetch_pcollector.add_level_now(1);
+    } else {
+      _page_in_pcollector.add_level_now(1);
+    }
+  } else if (to > from) {
+    _page_out_pcollector.add_level_now(1);
+  }
+}
+
 /**
  * Allocates and returns a freshly-allocated buffer of at least the indicated
  * size for holding vertex data.
@@ -767,18 +830,29 @@ PageThreadManager(int num_threads) :
 
 /**
  * Enqueues the indicated page on the thread queue to convert it to the
- * specified ram class.
+ * specified ram class.  If prefetch is true, the page is put on the queue of
+ * reads that are serviced only when there is nothing else to do.
  *
  * It is assumed the page's lock is already held, and that _tlock is already
  * held.
  */
 void VertexDataPage::PageThreadManager::
-add_page(VertexDataPage *page, RamClass ram_class) {
+add_page(VertexDataPage *page, RamClass ram_class, bool prefetch) {
   nassertv(!_shutdown);
 
   if (page->_pending_ram_class == ram_class) {
     // It's already queued.
     nassertv(page->get_lru() == &_pending_lru);
+    if (page->_pending_prefetch && !prefetch) {
+      // It was queued as a prefetch, but now it is needed right away.  Move
+      // it over to the regular reads.
+      PendingPages::iterator pi =
+        find(_pending_prefetches.begin(), _pending_prefetches.end(), page);
+      nassertv(pi != _pending_prefetches.end());
+      _pending_prefetches.erase(pi);
+      _pending_reads.push_back(page);
+      page->_pending_prefetch = false;
+    }
     return;
   }
 
@@ -795,10 +869,13 @@ add_page(VertexDataPage *page, RamClass ram_class) {
     page->mark_used_lru(&_pending_lru);
 
     page->_pending_ram_class = ram_class;
-    if (ram_class == RC_resident) {
-      _pending_reads.push_back(page);
-    } else {
+    if (ram_class != RC_resident) {
       _pending_writes.push_back(page);
+    } else if (prefetch) {
+      _pending_prefetches.push_back(page);
+      page->_pending_prefetch = true;
+    } else {
+      _pending_reads.push_back(page);
     }
     _pending_cvar.notify();
   }
@@ -830,10 +907,12 @@ remove_page(VertexDataPage *page) {
   }
 
   if (page->_pending_ram_class == RC_resident) {
-    PendingPages::iterator pi =
-      find(_pending_reads.begin(), _pending_reads.end(), page);
-    nassertv(pi != _pending_reads.end());
-    _pending_reads.erase(pi);
+    PendingPages &pending =
+      page->_pending_prefetch ? _pending_prefetches : _pending_reads;
+    PendingPages::iterator pi = find(pending.begin(), pending.end(), page);
+    nassertv(pi != pending.end());
+    pending.erase(pi);
+    page->_pending_prefetch = false;
   } else {
     PendingPages::iterator pi =
       find(_pending_writes.begin(), _pending_writes.end(), page);
@@ -874,6 +953,15 @@ get_num_pending_writes() const {
   return (int)_pending_writes.size();
 }
 
+/**
+ * Returns the number of prefetch requests waiting on the queue.  Assumes
+ * _tlock is held.
+ */
+int VertexDataPage::PageThreadManager::
+get_num_pending_prefetches() const {
+  return (int)_pending_prefetches.size();
+}
+
 /**
  * Adds the indicated of threads to the list of active threads.  Assumes
  * _tlock is held.
@@ -912,7 +1000,8 @@ stop_threads() {
     thread->join();
   }
 
-  nassertv(_pending_reads.empty() && _pending_writes.empty());
+  nassertv(_pending_reads.empty() && _pending_writes.empty() &&
+           _pending_prefetches.empty());
 }
 
 /**
@@ -937,7 +1026,8 @@ thread_main() {
     PStatClient::thread_tick();
 
     while (_manager->_pending_reads.empty() &&
-           _manager->_pending_writes.empty()) {
+           _manager->_pending_writes.empty() &&
+           _manager->_pending_prefetches.empty()) {
       if (_manager->_shutdown) {
         _tlock.release();
         return;
@@ -946,20 +1036,28 @@ thread_main() {
       _manager->_pending_cvar.wait();
     }
 
-    // Reads always have priority.
+    // Reads always have priority.  Prefetches come last, since they would
+    // only take up memory that the writes are trying to free up.
     if (!_manager->_pending_reads.empty()) {
       _working_page = _manager->_pending_reads.front();
       _manager->_pending_reads.pop_front();
-    } else {
+    } else if (!_manager->_pending_writes.empty()) {
       _working_page = _manager->_pending_writes.front();
       _manager->_pending_writes.pop_front();
+    } else {
+      _working_page = _manager->_pending_prefetches.front();
+      _manager->_pending_prefetches.pop_front();
     }
 
     RamClass ram_class = _working_page->_pending_ram_class;
+    bool prefetch = _working_page->_pending_prefetch;
+    _working_page->_pending_prefetch = false;
     _tlock.release();
 
+    RamClass orig_ram_class, new_ram_class;
     {
       MutexHolder holder(_working_page->_lock);
+      orig_ram_class = _working_page->_ram_class;
       switch (ram_class) {
       case RC_resident:
         _working_page->make_resident();
@@ -976,9 +1074,11 @@ thread_main() {
       case RC_end_of_list:
         break;
       }
+      new_ram_class = _working_page->_ram_class;
     }
 
     _tlock.acquire();
+    record_ram_class_change(orig_ram_class, new_ram_class, prefetch);
 
     _working_page = nullptr;
     _working_cvar.notify();
@@ -54,6 +54,7 @@ PUBLISHED:
   INLINE RamClass get_ram_class() const;
   INLINE RamClass get_pending_ram_class() const;
   INLINE void request_resident();
+  INLINE bool request_prefetch();
 
   INLINE VertexDataBlock *alloc(size_t size);
   INLINE VertexDataBlock *get_first_block() const;
@@ -70,6 +71,7 @@ PUBLISHED:
   INLINE static int get_num_threads();
   INLINE static int get_num_pending_reads();
   INLINE static int get_num_pending_writes();
+  INLINE static int get_num_pending_prefetches();
   static void stop_threads();
   static void flush_threads();
 
@@ -80,6 +82,12 @@ public:
   INLINE unsigned char *get_page_data(bool force);
   INLINE bool operator < (const VertexDataPage &other) const;
 
+  // These count the pages that change residency, and are reset by the
+  // GraphicsEngine at the start of each frame.
+  static PStatCollector _page_in_pcollector;
+  static PStatCollector _page_out_pcollector;
+  static PStatCollector _prefetch_pcollector;
+
 protected:
   virtual SimpleAllocatorBlock *make_block(size_t start, size_t size);
   virtual void changed_contiguous();
@@ -100,9 +108,10 @@ private:
 
   void adjust_book_size();
 
-  void request_ram_class(RamClass ram_class);
+  void request_ram_class(RamClass ram_class, bool prefetch = false);
   INLINE void set_ram_class(RamClass ram_class);
   static void make_save_file();
+  static void record_ram_class_change(RamClass from, RamClass to, bool prefetch);
 
   INLINE size_t round_up(size_t page_size) const;
   unsigned char *alloc_page_data(size_t page_size) const;
@@ -131,17 +140,22 @@ private:
   class EXPCL_PANDA_GOBJ PageThreadManager : public ReferenceCount {
   public:
     PageThreadManager(int num_threads);
-    void add_page(VertexDataPage *page, RamClass ram_class);
+    void add_page(VertexDataPage *page, RamClass ram_class, bool prefetch);
     void remove_page(VertexDataPage *page);
     int get_num_threads() const;
     int get_num_pending_reads() const;
     int get_num_pending_writes() const;
+    int get_num_pending_prefetches() const;
     void start_threads(int num_threads);
     void stop_threads();
 
   private:
     PendingPages _pending_writes;
     PendingPages _pending_reads;
+
+    // Reads that aren't needed right away, and are only serviced when there
+    // is nothing else to do.
+    PendingPages _pending_prefetches;
     bool _shutdown;
 
     // Signaled when anything new is added to either of the above queues, or
@@ -164,6 +178,7 @@ private:
 
   // Mutex _lock;   Inherited from SimpleAllocator.  Protects above members.
   RamClass _pending_ram_class;  // Protected by _tlock.
+  bool _pending_prefetch;  // Protected by _tlock.
 
   VertexDataBook *_book;  // never changes.
 
@@ -210,6 +225,7 @@ private:
   static PStatCollector _vdata_save_pcollector;
   static PStatCollector _vdata_restore_pcollector;
   static PStatCollector _thread_wait_pcollector;
+  static PStatCollector _stall_pcollector;
   static PStatCollector _alloc_pages_pcollector;
 
 public:
@@ -207,6 +207,7 @@ set_scene(SceneSetup *scene_setup, GraphicsStateGuardianBase *gsgbase,
 void PipeOcclusionCullTraverser::
 end_traverse() {
   if (!_live) {
+    CullTraverser::end_traverse();
     return;
   }
 
@@ -232,6 +233,10 @@ end_traverse() {
     }
   }
   _pending_objects.clear();
+
+  // Give the default cull handler back, so that it receives the end of the
+  // traversal.
+  set_cull_handler(_true_cull_handler);
   CullTraverser::end_traverse();
 
   gsg->end_scene();
@@ -0,0 +1,215 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file boundingVolumeBatch.cxx
+ * @author rdb
+ * @date 2026-10-17
+ */
+
+#include "boundingVolumeBatch.h"
+#include "boundingSphere.h"
+#include "boundingHexahedron.h"
+
+#ifndef STDFLOAT_DOUBLE
+#if defined(__SSE2__) || (_M_IX86_FP >= 2) || defined(_M_X64) || defined(_M_AMD64)
+#include <xmmintrin.h>
+#include <emmintrin.h>
+#define BATCH_USE_SSE2
+#elif defined(__ARM_NEON) || defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define BATCH_USE_NEON
+#endif
+#endif
+
+/**
+ * Reserves room for the indicated number of volumes.
+ */
+void BoundingVolumeBatch::
+reserve(size_t num_volumes) {
+  _x.reserve(num_volumes);
+  _y.reserve(num_volumes);
+  _z.reserve(num_volumes);
+  _r.reserve(num_volumes);
+  _volumes.reserve(num_volumes);
+}
+
+/**
+ * Adds a new volume to the end of the batch.  Its result will be stored at
+ * the corresponding index of the array passed to contained_by().
+ */
+void BoundingVolumeBatch::
+add_volume(const GeometricBoundingVolume *volume) {
+  nassertv(volume != nullptr);
+
+  const BoundingSphere *sphere = volume->as_bounding_sphere();
+  if (sphere != nullptr && !sphere->is_empty() && !sphere->is_infinite()) {
+    const LPoint3 &center = sphere->get_center();
+    _x.push_back(center[0]);
+    _y.push_back(center[1]);
+    _z.push_back(center[2]);
+    _r.push_back(sphere->get_radius());
+  } else {
+    _x.push_back(0);
+    _y.push_back(0);
+    _z.push_back(0);
+    _r.push_back(0);
+    _others.push_back(_volumes.size());
+  }
+  _volumes.push_back(volume);
+}
+
+/**
+ * Adds a new sphere with the indicated center and radius to the end of the
+ * batch.  This is equivalent to adding a BoundingSphere with add_volume(),
+ * but does not require one to be kept around.
+ */
+void BoundingVolumeBatch::
+add_sphere(const LPoint3 &center, PN_stdfloat radius) {
+  _x.push_back(center[0]);
+  _y.push_back(center[1]);
+  _z.push_back(center[2]);
+  _r.push_back(radius);
+  _volumes.push_back(nullptr);
+}
+
+/**
+ * Fills in results with the intersection flags of each volume in the batch
+ * against the indicated frustum, as frustum->contains(volume) would return
+ * them.  The results array must have room for get_num_volumes() entries.
+ */
+void BoundingVolumeBatch::
+contained_by(const GeometricBoundingVolume *frustum, int *results) const {
+  size_t num_volumes = _volumes.size();
+  if (num_volumes == 0) {
+    return;
+  }
+
+  const BoundingHexahedron *hexahedron = frustum->as_bounding_hexahedron();
+  if (hexahedron == nullptr || frustum->is_empty() || frustum->is_infinite() ||
+      _others.size() == num_volumes) {
+    // There's nothing to be gained here, so just test them one by one.
+    for (size_t i = 0; i < num_volumes; ++i) {
+      results[i] = contained_by_one(frustum, i);
+    }
+    return;
+  }
+
+  LPlane planes[6];
+  for (int p = 0; p < 6; ++p) {
+    planes[p] = hexahedron->get_plane(p);
+  }
+  contain_spheres(planes, results);
+
+  for (size_t i : _others) {
+    results[i] = frustum->contains(_volumes[i]);
+  }
+}
+
+/**
+ * Returns the intersection flags of the indicated volume of the batch against
+ * the frustum, testing it on its own.
+ */
+int BoundingVolumeBatch::
+contained_by_one(const GeometricBoundingVolume *frustum, size_t i) const {
+  if (_volumes[i] != nullptr) {
+    return frustum->contains(_volumes[i]);
+  }
+  BoundingSphere sphere(LPoint3(_x[i], _y[i], _z[i]), _r[i]);
+  return frustum->contains(&sphere);
+}
+
+/**
+ * Tests all of the spheres against the six planes of a hexahedron.  This
+ * follows BoundingHexahedron::contains_sphere() exactly: a sphere that is
+ * entirely in front of any plane is outside, and one that is not entirely
+ * behind all of them is only partially inside.
+ */
+void BoundingVolumeBatch::
+contain_spheres(const LPlane *planes, int *results) const {
+  static const int all = BoundingVolume::IF_possible | BoundingVolume::IF_some | BoundingVolume::IF_all;
+  static const int some = BoundingVolume::IF_possible | BoundingVolume::IF_some;
+
+  size_t num_volumes = _volumes.size();
+  size_t i = 0;
+
+#if defined(BATCH_USE_SSE2)
+  for (; i + 4 <= num_volumes; i += 4) {
+    __m128 x = _mm_loadu_ps(&_x[i]);
+    __m128 y = _mm_loadu_ps(&_y[i]);
+    __m128 z = _mm_loadu_ps(&_z[i]);
+    __m128 r = _mm_loadu_ps(&_r[i]);
+    __m128 neg_r = _mm_sub_ps(_mm_setzero_ps(), r);
+    __m128 outside = _mm_setzero_ps();
+    __m128 partial = _mm_setzero_ps();
+
+    for (int p = 0; p < 6; ++p) {
+      const LPlane &plane = planes[p];
+      __m128 dist = _mm_mul_ps(_mm_set1_ps(plane[0]), x);
+      dist = _mm_add_ps(dist, _mm_mul_ps(_mm_set1_ps(plane[1]), y));
+      dist = _mm_add_ps(dist, _mm_mul_ps(_mm_set1_ps(plane[2]), z));
+      dist = _mm_add_ps(dist, _mm_set1_ps(plane[3]));
+      outside = _mm_or_ps(outside, _mm_cmpgt_ps(dist, r));
+      partial = _mm_or_ps(partial, _mm_cmpgt_ps(dist, neg_r));
+    }
+
+    int outside_bits = _mm_movemask_ps(outside);
+    int partial_bits = _mm_movemask_ps(partial);
+    for (int j = 0; j < 4; ++j) {
+      results[i + j] = ((outside_bits >> j) & 1) ? 0 : ((partial_bits >> j) & 1) ? some : all;
+    }
+  }
+
+#elif defined(BATCH_USE_NEON)
+  for (; i + 4 <= num_volumes; i += 4) {
+    float32x4_t x = vld1q_f32(&_x[i]);
+    float32x4_t y = vld1q_f32(&_y[i]);
+    float32x4_t z = vld1q_f32(&_z[i]);
+    float32x4_t r = vld1q_f32(&_r[i]);
+    float32x4_t neg_r = vnegq_f32(r);
+    uint32x4_t outside = vdupq_n_u32(0);
+    uint32x4_t partial = vdupq_n_u32(0);
+
+    for (int p = 0; p < 6; ++p) {
+      // Multiplies and adds are kept separate, rather than fused, so that the
+      // result is rounded the same way as in contains_sphere().
+      const LPlane &plane = planes[p];
+      float32x4_t dist = vmulq_f32(vdupq_n_f32(plane[0]), x);
+      dist = vaddq_f32(dist, vmulq_f32(vdupq_n_f32(plane[1]), y));
+      dist = vaddq_f32(dist, vmulq_f32(vdupq_n_f32(plane[2]), z));
+      dist = vaddq_f32(dist, vdupq_n_f32(plane[3]));
+      outside = vorrq_u32(outside, vcgtq_f32(dist, r));
+      partial = vorrq_u32(partial, vcgtq_f32(dist, neg_r));
+    }
+
+    uint32_t outside_lanes[4], partial_lanes[4];
+    vst1q_u32(outside_lanes, outside);
+    vst1q_u32(partial_lanes, partial);
+    for (int j = 0; j < 4; ++j) {
+      results[i + j] = outside_lanes[j] ? 0 : partial_lanes[j] ? some : all;
+    }
+  }
+#endif
+
+  // Take care of the remainder, or all of them if we have no SIMD support.
+  for (; i < num_volumes; ++i) {
+    LPoint3 center(_x[i], _y[i], _z[i]);
+    PN_stdfloat radius = _r[i];
+    int result = all;
+
+    for (int p = 0; p < 6; ++p) {
+      PN_stdfloat dist = planes[p].dist_to_plane(center);
+      if (dist > radius) {
+        result = BoundingVolume::IF_no_intersection;
+        break;
+      } else if (dist > -radius) {
+        result = some;
+      }
+    }
+    results[i] = result;
+  }
+}
@@ -0,0 +1,66 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file boundingVolumeBatch.h
+ * @author rdb
+ * @date 2026-10-17
+ */
+
+#ifndef BOUNDINGVOLUMEBATCH_H
+#define BOUNDINGVOLUMEBATCH_H
+
+#include "pandabase.h"
+#include "geometricBoundingVolume.h"
+#include "plane.h"
+#include "pvector.h"
+
+/**
+ * A set of bounding volumes that are to be tested against the same
+ * (typically frustum) volume all at once.  The bounding spheres in the set are
+ * stored as separate arrays of coordinates, so that they can be tested four
+ * at a time with SIMD instructions where available; any other kind of volume
+ * is tested individually.
+ *
+ * The results are always exactly those that would be returned by calling
+ * contains() on the frustum for each volume in turn.
+ *
+ * This class does not hold a reference to the volumes that are added to it;
+ * the caller must ensure they are kept alive until the batch is cleared.
+ */
+class EXPCL_PANDA_MATHUTIL BoundingVolumeBatch {
+public:
+  INLINE_MATHUTIL BoundingVolumeBatch();
+
+  INLINE_MATHUTIL void clear();
+  void reserve(size_t num_volumes);
+  void add_volume(const GeometricBoundingVolume *volume);
+  void add_sphere(const LPoint3 &center, PN_stdfloat radius);
+  INLINE_MATHUTIL size_t get_num_volumes() const;
+
+  void contained_by(const GeometricBoundingVolume *frustum, int *results) const;
+
+private:
+  int contained_by_one(const GeometricBoundingVolume *frustum, size_t i) const;
+  void contain_spheres(const LPlane *planes, int *results) const;
+
+  // The centers and radii of the spheres, padded to a multiple of four.
+  // Volumes that aren't spheres occupy a slot with a radius of zero, whose
+  // result is overwritten afterwards.
+  pvector<PN_stdfloat> _x;
+  pvector<PN_stdfloat> _y;
+  pvector<PN_stdfloat> _z;
+  pvector<PN_stdfloat> _r;
+
+  // This is nullptr for the spheres added with add_sphere().
+  pvector<const GeometricBoundingVolume *> _volumes;
+  pvector<size_t> _others;
+};
+
+#include "boundingVolumeBatch.I"
+
+#endif
@@ -4,6 +4,7 @@
 #include "boundingPlane.cxx"
 #include "boundingSphere.cxx"
 #include "boundingVolume.cxx"
+#include "boundingVolumeBatch.cxx"
 #include "finiteBoundingVolume.cxx"
 #include "geometricBoundingVolume.cxx"
 #include "intersectionBoundingVolume.cxx"
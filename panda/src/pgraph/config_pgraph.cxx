@@ -138,6 +138,71 @@ ConfigVariableBool show_occluder_volumes
  PRC_DESC("Set this true to enable debug visualization of the volumes used "
           "to cull objects behind an occluder."));
 
+ConfigVariableInt cull_num_threads
+("cull-num-threads", 0,
+ PRC_DESC("This is the default number of worker threads that each "
+          "CullTraverser may use to traverse large groups of sibling nodes "
+          "in parallel.  Set this to 0 to perform the whole cull traversal "
+          "on the cull thread.  Only enable this if the cull callbacks of "
+          "the nodes in your scene graph are thread-safe.  See "
+          "CullTraverser::set_num_threads()."));
+
+ConfigVariableInt cull_parallel_min_children
+("cull-parallel-min-children", 8,
+ PRC_DESC("When cull-num-threads is nonzero, this is the minimum number of "
+          "children that a node must have for its children to be traversed "
+          "in parallel."));
+
+ConfigVariableBool cull_instance_batching
+("cull-instance-batching", false,
+ PRC_DESC("Set this true to combine the objects in a state-sorted cull bin "
+          "that share the same Geom and the same state into a single "
+          "instanced draw call, with one instance per object.  This only "
+          "applies to objects whose state includes a ShaderAttrib with the "
+          "F_hardware_instancing flag set, which indicates that the shader "
+          "reads the per-instance transforms from the vertex data, as it "
+          "would for an InstancedNode."));
+
+ConfigVariableInt cull_batch_min_volumes
+("cull-batch-min-volumes", 8,
+ PRC_DESC("This is the minimum number of children of a node, or Geoms of a "
+          "GeomNode, for which the bounding volumes are tested against the "
+          "view frustum all at once, using SIMD instructions where "
+          "available, rather than one at a time.  Set this to 0 to disable "
+          "batched culling altogether."));
+
+ConfigVariableBool cluster_cull
+("cluster-cull", true,
+ PRC_DESC("Set this false to disable culling the individual clusters of "
+          "Geoms that have been partitioned with Geom::make_clusters() or "
+          "SceneGraphReducer::make_clusters(), drawing them as a whole "
+          "instead."));
+
+ConfigVariableInt occlusion_buffer_size
+("occlusion-buffer-size", 0,
+ PRC_DESC("Set this to a nonzero value to have each CullTraverser rasterize "
+          "the occluders that are applied to the root of the scene into a "
+          "software depth buffer of this many pixels wide, and skip any "
+          "node that is found to be hidden behind them.  This allows "
+          "occlusion culling without any help from the GPU.  A value of "
+          "256 or so is usually sufficient.  See "
+          "CullTraverser::set_occlusion_buffer()."));
+
+ConfigVariableDouble vertex_data_prefetch_time
+("vertex-data-prefetch-time", 0.5,
+ PRC_DESC("When vertex data paging is enabled, the CullTraverser predicts "
+          "where the view frustum will be this many seconds from now, based "
+          "on the recent motion of the camera, and asks the vertex data "
+          "page threads to read in the Geoms that fall within it, so that "
+          "they are resident by the time they come into view.  Set this "
+          "to 0 to disable prefetching."));
+
+ConfigVariableInt vertex_data_prefetch_max_nodes
+("vertex-data-prefetch-max-nodes", 500,
+ PRC_DESC("This is the maximum number of culled nodes that the "
+          "CullTraverser will visit each frame while looking for vertex "
+          "data to prefetch; see vertex-data-prefetch-time."));
+
 ConfigVariableBool unambiguous_graph
 ("unambiguous-graph", false,
  PRC_DESC("Set this true to make ambiguous path warning messages generate an "
@@ -207,6 +272,16 @@ ConfigVariableDouble garbage_collect_states_rate
           "performance if states accumulate faster than they can be "
           "cleaned up."));
 
+ConfigVariableInt garbage_collect_states_budget
+("garbage-collect-states-budget", 0,
+ PRC_DESC("The maximum amount of time, in microseconds, that each call to "
+          "TransformState::garbage_collect() or RenderState::garbage_collect() "
+          "may spend.  If the time runs out before the fraction of states "
+          "indicated by garbage-collect-states-rate has been processed, the "
+          "remaining states are processed during the next call instead.  "
+          "This keeps the cost of garbage collection predictable when there "
+          "are very many states.  Set this to 0 to impose no limit."));
+
 ConfigVariableBool transform_cache
 ("transform-cache", true,
  PRC_DESC("Set this true to enable the cache of TransformState objects.  "
@@ -220,6 +295,18 @@ ALIGN_16BYTE ConfigVariableBool state_cache
           "similar to the TransformState cache controlled via "
           "transform-cache."));
 
+ConfigVariableInt state_thread_cache_size
+("state-thread-cache-size", 256,
+ PRC_DESC("The number of recent compositions of RenderStates, and also of "
+          "TransformStates, that each thread remembers on its own.  These "
+          "can be looked up without grabbing the lock that protects the "
+          "state cache, which reduces contention when several threads "
+          "(such as the cull thread and any task chain threads) are "
+          "composing states at the same time.  The states in these caches "
+          "are kept alive until the next garbage collection of states, or "
+          "the next call to clear_cache(), which empties the caches of all "
+          "threads.  Set this to 0 to disable the per-thread caches."));
+
 ConfigVariableBool uniquify_transforms
 ("uniquify-transforms", true,
  PRC_DESC("Set this true to ensure that equivalent TransformStates "
@@ -302,6 +389,15 @@ ConfigVariableBool preserve_geom_nodes
           "be flattened, so setting this true effectively disables the "
           "use of flatten to combine GeomNodes."));
 
+ConfigVariableInt flatten_num_threads
+("flatten-num-threads", 0,
+ PRC_DESC("This is the default number of worker threads that a "
+          "SceneGraphReducer may use to flatten independent subgraphs and "
+          "to combine independent groups of vertex data in parallel.  The "
+          "result is the same as when flattening on a single thread.  Set "
+          "this to 0 to do all of the work on the calling thread.  See "
+          "SceneGraphReducer::set_num_threads()."));
+
 ConfigVariableBool flatten_geoms
 ("flatten-geoms", true,
  PRC_DESC("When this is true (the default), NodePath::flatten_strong() and "
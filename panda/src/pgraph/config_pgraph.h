@@ -35,6 +35,14 @@ extern ConfigVariableBool clip_plane_cull;
 extern ConfigVariableBool allow_portal_cull;
 extern ConfigVariableBool debug_portal_cull;
 extern ConfigVariableBool show_occluder_volumes;
+extern ConfigVariableInt cull_num_threads;
+extern ConfigVariableInt cull_parallel_min_children;
+extern ConfigVariableBool cull_instance_batching;
+extern ConfigVariableInt cull_batch_min_volumes;
+extern ConfigVariableBool cluster_cull;
+extern ConfigVariableInt occlusion_buffer_size;
+extern ConfigVariableDouble vertex_data_prefetch_time;
+extern ConfigVariableInt vertex_data_prefetch_max_nodes;
 extern ConfigVariableBool unambiguous_graph;
 extern ConfigVariableBool detect_graph_cycles;
 extern ConfigVariableBool no_unsupported_copy;
@@ -45,8 +53,10 @@ extern ConfigVariableBool paranoid_const;
 extern ConfigVariableBool auto_break_cycles;
 extern EXPCL_PANDA_PGRAPH ConfigVariableBool garbage_collect_states;
 extern ConfigVariableDouble garbage_collect_states_rate;
+extern ConfigVariableInt garbage_collect_states_budget;
 extern ConfigVariableBool transform_cache;
 extern ALIGN_16BYTE EXPCL_PANDA_PGRAPH ConfigVariableBool state_cache;
+extern ConfigVariableInt state_thread_cache_size;
 extern ConfigVariableBool uniquify_transforms;
 extern EXPCL_PANDA_PGRAPH ConfigVariableBool uniquify_states;
 extern ALIGN_16BYTE EXPCL_PANDA_PGRAPH ConfigVariableBool uniquify_attribs;
@@ -57,6 +67,7 @@ extern ConfigVariableInt max_collect_indices;
 extern EXPCL_PANDA_PGRAPH ConfigVariableBool premunge_data;
 extern ConfigVariableBool premunge_remove_unused_vertices;
 extern ConfigVariableBool preserve_geom_nodes;
+extern ConfigVariableInt flatten_num_threads;
 extern ConfigVariableBool flatten_geoms;
 extern EXPCL_PANDA_PGRAPH ConfigVariableInt max_lenses;
 
@@ -52,3 +52,15 @@ record_object(CullableObject &&object, const CullTraverser *traverser) {
 void CullHandler::
 end_traverse() {
 }
+
+/**
+ * This variant is called by the CullTraverser at the end of the traversal,
+ * with the traverser that found the objects.  The default implementation
+ * calls the above.  A derived class that overrides this should make sure that
+ * end_traverse() is still called, so that classes derived from it in turn
+ * may continue to override that instead.
+ */
+void CullHandler::
+end_traverse(const CullTraverser *traverser) {
+  end_traverse();
+}
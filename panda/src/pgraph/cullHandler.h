@@ -33,6 +33,7 @@ public:
   virtual void record_object(CullableObject &&object,
                              const CullTraverser *traverser);
   virtual void end_traverse();
+  virtual void end_traverse(const CullTraverser *traverser);
 
   INLINE static void draw(CullableObject *object,
                           GraphicsStateGuardianBase *gsg,
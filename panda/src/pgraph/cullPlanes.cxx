@@ -139,8 +139,15 @@ apply_state(CPT(CullPlanes) &planes,
       new_planes = new CullPlanes;
     }
 
+    const OcclusionBuffer *buffer = trav->get_occlusion_buffer();
+
     for (int i = 0; i < num_on_occluders; ++i) {
       NodePath occluder = node_effect->get_on_occluder(i);
+      if (buffer != nullptr && buffer->has_occluder(occluder)) {
+        // This occluder has already been rendered into the occlusion buffer,
+        // so there's no need to test against its volume as well.
+        continue;
+      }
       Occluders::const_iterator oi = new_planes->_occluders.find(occluder);
       if (oi == new_planes->_occluders.end()) {
         // Here's a new occluder; consider adding it to the list.
@@ -29,9 +29,13 @@
 #include "depthOffsetAttrib.h"
 #include "colorBlendAttrib.h"
 #include "shaderAttrib.h"
+#include "instanceList.h"
 
 TypeHandle CullResult::_type_handle;
 
+PStatCollector CullResult::_instance_batches_pcollector("Instance batches");
+PStatCollector CullResult::_batched_objects_pcollector("Instanced objects");
+
 /*
  * This value is used instead of 1.0 to represent the alpha level of a pixel
  * that is to be considered "opaque" for the purposes of M_dual.  Ideally, 1.0
@@ -73,6 +77,7 @@ CullResult(GraphicsStateGuardianBase *gsg,
 #ifndef NDEBUG
   _show_transparency = show_transparency.get_value();
 #endif
+  _instance_batching = cull_instance_batching.get_value();
 }
 
 /**
@@ -247,14 +252,84 @@ add_object(CullableObject &&object, const CullTraverser *traverser) {
   nassertv(bin != nullptr);
   check_flash_bin(object._state, bin_manager, bin_index);
 
-  // Munge vertices as needed for the GSG's requirements, and the object's
-  // current state.
-  if (object.munge_geom(_gsg, _gsg->get_geom_munger(object._state, current_thread), traverser, force)) {
-    // The object may or may not now be fully resident, but this may not
-    // matter, since the GSG may have the necessary buffers already loaded.
-    // We'll let the GSG ultimately decide whether to render it.
-    bin->add_object(alloc_object(std::move(object)), current_thread);
+  if (_instance_batching && object._draw_callback == nullptr &&
+      object._instances == nullptr &&
+      bin->get_bin_type() == CullBinEnums::BT_state_sorted) {
+    // If the shader can handle instancing, hold on to the object until the
+    // end of the traversal, so that we can draw all of the objects with the
+    // same Geom and state at once.
+    const ShaderAttrib *sattr;
+    if (object._state->get_attrib(sattr) &&
+        sattr->get_flag(ShaderAttrib::F_hardware_instancing)) {
+      InstanceBatchKey key;
+      key._bin_index = bin_index;
+      key._geom = object._geom;
+      key._state = object._state;
+
+      InstanceBatch &batch = _instance_batches[key];
+      batch._transforms.push_back(object._internal_transform);
+      if (batch._transforms.size() == 1) {
+        batch._object = std::move(object);
+      }
+      return;
+    }
   }
+
+  add_munged_object(bin, std::move(object), traverser, force);
+}
+
+/**
+ * Adds the objects that were held back by add_object() for the purpose of
+ * instancing to their bins, combining each set of objects that share the same
+ * Geom and state into a single object with an InstanceList.
+ *
+ * This is called by the BinCullHandler at the end of the cull traversal, with
+ * the traverser that found the objects.
+ */
+void CullResult::
+flush_instance_batches(const CullTraverser *traverser) {
+  if (_instance_batches.empty()) {
+    return;
+  }
+
+  bool force = !traverser->get_effective_incomplete_render();
+
+  for (InstanceBatches::value_type &item : _instance_batches) {
+    CullBin *bin = get_bin(item.first._bin_index);
+    nassertd(bin != nullptr) continue;
+
+    InstanceBatch &batch = item.second;
+    CullableObject &object = batch._object;
+    size_t num_objects = batch._transforms.size();
+
+    if (num_objects > 1 && !object._internal_transform->is_singular()) {
+      // The instance transforms are relative to the transform of the first
+      // object.
+      const TransformState *base_transform = object._internal_transform;
+      PT(InstanceList) instances = new InstanceList;
+      instances->reserve(num_objects);
+      for (const TransformState *transform : batch._transforms) {
+        instances->append(base_transform->invert_compose(transform));
+      }
+      object._instances = std::move(instances);
+
+      _instance_batches_pcollector.add_level(1);
+      _batched_objects_pcollector.add_level(num_objects);
+
+    } else {
+      // We can't express the other transforms relative to this one, so draw
+      // each object separately.
+      for (size_t i = 1; i < num_objects; ++i) {
+        CullableObject copy(object);
+        copy._internal_transform = batch._transforms[i];
+        add_munged_object(bin, std::move(copy), traverser, force);
+      }
+    }
+
+    add_munged_object(bin, std::move(object), traverser, force);
+  }
+
+  _instance_batches.clear();
 }
 
 /**
@@ -266,6 +341,11 @@ void CullResult::
 finish_cull(SceneSetup *scene_setup, Thread *current_thread) {
   CullBinManager *bin_manager = CullBinManager::get_global_ptr();
 
+  // These should have been flushed at the end of the traversal.
+  nassertd(_instance_batches.empty()) {
+    _instance_batches.clear();
+  }
+
   for (size_t i = 0; i < _bins.size(); ++i) {
     if (!bin_manager->get_bin_active(i)) {
       // If the bin isn't active, don't sort it, and don't draw it.  In fact,
@@ -369,6 +449,25 @@ make_new_bin(int bin_index) {
   return bin_ptr;
 }
 
+/**
+ * Munges the vertices of the indicated object as needed for the GSG's
+ * requirements and the object's state, and adds it to the indicated bin.
+ */
+void CullResult::
+add_munged_object(CullBin *bin, CullableObject &&object,
+                  const CullTraverser *traverser, bool force) {
+  Thread *current_thread = traverser->get_current_thread();
+
+  // Munge vertices as needed for the GSG's requirements, and the object's
+  // current state.
+  if (object.munge_geom(_gsg, _gsg->get_geom_munger(object._state, current_thread), traverser, force)) {
+    // The object may or may not now be fully resident, but this may not
+    // matter, since the GSG may have the necessary buffers already loaded.
+    // We'll let the GSG ultimately decide whether to render it.
+    bin->add_object(alloc_object(std::move(object)), current_thread);
+  }
+}
+
 /**
  * Creates a new AllocationPage replacing the old one.
  */
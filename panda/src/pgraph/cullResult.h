@@ -26,6 +26,7 @@
 #include "pset.h"
 #include "pmap.h"
 #include "rescaleNormalAttrib.h"
+#include "pStatCollector.h"
 
 class CullTraverser;
 class GraphicsStateGuardianBase;
@@ -54,6 +55,7 @@ PUBLISHED:
   INLINE CullBin *get_bin(int bin_index);
 
   void add_object(CullableObject &&object, const CullTraverser *traverser);
+  void flush_instance_batches(const CullTraverser *traverser);
   void finish_cull(SceneSetup *scene_setup, Thread *current_thread);
   void draw(Thread *current_thread);
 
@@ -61,9 +63,12 @@ PUBLISHED:
 
 public:
   static void bin_removed(int bin_index);
+  INLINE static void flush_level();
 
 private:
   CullBin *make_new_bin(int bin_index);
+  void add_munged_object(CullBin *bin, CullableObject &&object,
+                         const CullTraverser *traverser, bool force);
 
   struct AllocationPage;
   AllocationPage *new_page();
@@ -94,6 +99,28 @@ private:
 
   bool _show_transparency = false;
 
+  // The objects that are candidates for being drawn with a single instanced
+  // draw call, keyed by bin, Geom and state.
+  class InstanceBatchKey {
+  public:
+    INLINE bool operator < (const InstanceBatchKey &other) const;
+
+    int _bin_index;
+    const Geom *_geom;
+    const RenderState *_state;
+  };
+  class InstanceBatch {
+  public:
+    CullableObject _object;
+    pvector<CPT(TransformState)> _transforms;
+  };
+  typedef pmap<InstanceBatchKey, InstanceBatch> InstanceBatches;
+  InstanceBatches _instance_batches;
+  bool _instance_batching = false;
+
+  static PStatCollector _instance_batches_pcollector;
+  static PStatCollector _batched_objects_pcollector;
+
   // Arena allocator for CullableObjects.
   struct AllocationPage {
     AllocationPage *_next = nullptr;
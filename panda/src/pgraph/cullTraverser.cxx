@@ -35,15 +35,40 @@
 #include "geomLinestrips.h"
 #include "geomLines.h"
 #include "geomVertexWriter.h"
+#include "asyncTaskManager.h"
+#include "occluderEffect.h"
+#include "pStatTimer.h"
+#include "lightReMutexHolder.h"
+#include "vertexDataPage.h"
+#include "clockObject.h"
+#include "config_gobj.h"
 
 PStatCollector CullTraverser::_nodes_pcollector("Nodes");
 PStatCollector CullTraverser::_geom_nodes_pcollector("Nodes:GeomNodes");
 PStatCollector CullTraverser::_pgui_nodes_pcollector("Nodes:GUI");
 PStatCollector CullTraverser::_geoms_pcollector("Geoms");
 PStatCollector CullTraverser::_geoms_occluded_pcollector("Geoms:Occluded");
+PStatCollector CullTraverser::_nodes_occluded_pcollector("Nodes:Occluded");
+PStatCollector CullTraverser::_occlusion_buffer_pcollector("Cull:Occlusion buffer");
 
 TypeHandle CullTraverser::_type_handle;
 
+/**
+ * Stands in for the actual CullHandler while a child of a node is being
+ * traversed on a worker thread, collecting up the objects that are found, so
+ * that they can be handed to the actual CullHandler afterwards.
+ */
+class CullTraverser::DeferredHandler : public CullHandler {
+public:
+  virtual void record_object(CullableObject &&object,
+                             const CullTraverser *traverser) {
+    _objects.push_back(std::move(object));
+  }
+
+  typedef pvector<CullableObject> Objects;
+  Objects _objects;
+};
+
 /**
  *
  */
@@ -57,7 +82,14 @@ CullTraverser() :
   _initial_state(RenderState::make_empty()),
   _cull_handler(nullptr),
   _portal_clipper(nullptr),
-  _effective_incomplete_render(false)
+  _effective_incomplete_render(false),
+  _num_threads(cull_num_threads),
+  _parallel(false),
+  _auto_occlusion_buffer(true),
+  _prefetch_budget(0),
+  _has_last_camera_pos(false),
+  _last_frame_time(0.0),
+  _camera_velocity(LVector3::zero())
 {
 }
 
@@ -77,7 +109,17 @@ CullTraverser(const CullTraverser &copy) :
   _view_frustum(copy._view_frustum),
   _cull_handler(copy._cull_handler),
   _portal_clipper(copy._portal_clipper),
-  _effective_incomplete_render(copy._effective_incomplete_render)
+  _effective_incomplete_render(copy._effective_incomplete_render),
+  _num_threads(copy._num_threads),
+  _parallel(false),
+  _occlusion_buffer(copy._occlusion_buffer),
+  _auto_occlusion_buffer(copy._auto_occlusion_buffer),
+  _scene_snapshot(copy._scene_snapshot),
+  _prefetch_volume(copy._prefetch_volume),
+  _prefetch_budget(copy._prefetch_budget),
+  _has_last_camera_pos(false),
+  _last_frame_time(0.0),
+  _camera_velocity(LVector3::zero())
 {
 }
 
@@ -102,8 +144,14 @@ set_scene(SceneSetup *scene_setup, GraphicsStateGuardianBase *gsg,
 
   _effective_incomplete_render = _gsg->get_incomplete_render() && dr_incomplete_render;
 
+  // Textures that have started streaming since the last frame need the cull
+  // callback of the states that apply them.
+  RenderState::check_cull_callbacks();
+
   _view_frustum = scene_setup->get_view_frustum();
 
+  update_prefetch_volume();
+
 #ifndef NDEBUG
   _fake_view_frustum_cull = fake_view_frustum_cull;
 #endif
@@ -117,7 +165,31 @@ traverse(const NodePath &root) {
   nassertv(_cull_handler != nullptr);
   nassertv(_scene_setup != nullptr);
 
-  if (allow_portal_cull) {
+  // The copies of the traverser that are made for the worker threads can't
+  // be of a derived type, so only the basic traverser can use them.
+  _parallel = (_num_threads > 0 && !allow_portal_cull &&
+               get_type() == CullTraverser::get_class_type() &&
+               Thread::is_threading_supported());
+  if (_parallel) {
+    // Make sure these exist before the threads go looking for them.
+    get_bounds_outer_viz_state();
+    get_bounds_inner_viz_state();
+    get_depth_offset_state();
+  }
+
+  if (_auto_occlusion_buffer) {
+    update_occlusion_buffer();
+  }
+  if (_occlusion_buffer != nullptr) {
+    fill_occlusion_buffer(root);
+  }
+
+  if (_scene_snapshot != nullptr && _scene_snapshot->get_root() == root &&
+      !allow_portal_cull && !_fake_view_frustum_cull &&
+      get_type() == CullTraverser::get_class_type()) {
+    traverse_snapshot(_scene_snapshot);
+
+  } else if (allow_portal_cull) {
     // This _view_frustum is in cull_center space Erik: obsolete?
     // PT(GeometricBoundingVolume) vf = _view_frustum;
 
@@ -169,6 +241,8 @@ traverse(const NodePath &root) {
       do_traverse(data);
     }
   }
+
+  _parallel = false;
 }
 
 /**
@@ -234,6 +308,15 @@ do_traverse(CullTraverserData &data) {
   PandaNode::Children children = node_reader->get_children();
   node_reader->release();
   int num_children = children.get_num_children();
+  if (_parallel && num_children >= cull_parallel_min_children) {
+    traverse_children_parallel(data, children);
+    return;
+  }
+  if (data._view_frustum != nullptr && cull_batch_min_volumes > 0 &&
+      num_children >= cull_batch_min_volumes) {
+    traverse_children_batched(data, children);
+    return;
+  }
   for (int i = 0; i < num_children; ++i) {
     const PandaNode::DownConnection &child = children.get_child_connection(i);
     traverse_down(data, child, data._state);
@@ -246,7 +329,7 @@ do_traverse(CullTraverserData &data) {
  */
 void CullTraverser::
 end_traverse() {
-  _cull_handler->end_traverse();
+  _cull_handler->end_traverse(this);
 }
 
 /**
@@ -289,6 +372,466 @@ do_fake_cull(const CullTraverserData &data, PandaNode *child,
 #endif
 }
 
+/**
+ * Calls the indicated function count times on the worker threads, passing it
+ * a copy of this traverser for the thread and the index of the call.  The
+ * objects found by each call are passed on to the CullHandler in order of
+ * the calls once all of them are done.
+ */
+template<class Callable>
+void CullTraverser::
+traverse_parallel(size_t count, Callable callable) {
+  pvector<DeferredHandler> handlers(count);
+
+  static PT(AsyncTaskChain) chain =
+    AsyncTaskManager::get_global_ptr()->make_task_chain("cull_traverser");
+  if (chain->get_num_threads() < _num_threads) {
+    chain->set_num_threads(_num_threads);
+  }
+
+  int pipeline_stage = _current_thread->get_pipeline_stage();
+
+  chain->parallel_for(count, [&] (size_t i) {
+    // The worker thread must read the scene graph from the same pipeline
+    // stage as this thread.
+    Thread *current_thread = Thread::get_current_thread();
+    if (current_thread->get_pipeline_stage() != pipeline_stage) {
+      current_thread->set_pipeline_stage(pipeline_stage);
+    }
+
+    CullTraverser trav(*this);
+    trav._current_thread = current_thread;
+    trav._cull_handler = &handlers[i];
+    callable(trav, i);
+  });
+
+  for (DeferredHandler &handler : handlers) {
+    for (CullableObject &object : handler._objects) {
+      _cull_handler->record_object(std::move(object), this);
+    }
+  }
+}
+
+/**
+ * Traverses the indicated children of the node, distributing them over the
+ * worker threads.  Each child is traversed by its own copy of this
+ * traverser, and the objects it finds are passed on to the CullHandler in
+ * order of the children once all of them are done.
+ */
+void CullTraverser::
+traverse_children_parallel(const CullTraverserData &data,
+                           const PandaNode::Children &children) {
+  size_t num_children = (size_t)children.get_num_children();
+
+  traverse_parallel(num_children, [&] (CullTraverser &trav, size_t i) {
+    CullTraverserData thread_data(data, trav._current_thread);
+    trav.traverse_down(thread_data, children.get_child_connection((int)i),
+                       thread_data._state);
+  });
+}
+
+/**
+ * Creates the OcclusionBuffer if occlusion-buffer-size is set, or recreates
+ * it if the aspect ratio of the viewport or the lens has changed since it was
+ * created, so that its pixels stay square on the screen.
+ */
+void CullTraverser::
+update_occlusion_buffer() {
+  int width = occlusion_buffer_size;
+  if (width <= 0) {
+    _occlusion_buffer = nullptr;
+    return;
+  }
+
+  int height = width;
+  if (_scene_setup->get_viewport_width() > 0) {
+    height = std::max(1, width * _scene_setup->get_viewport_height() /
+                         _scene_setup->get_viewport_width());
+  } else {
+    PN_stdfloat aspect_ratio = _scene_setup->get_lens()->get_aspect_ratio();
+    if (aspect_ratio > 0) {
+      height = std::max(1, (int)(width / aspect_ratio + 0.5f));
+    }
+  }
+
+  if (_occlusion_buffer == nullptr ||
+      _occlusion_buffer->get_width() != width ||
+      _occlusion_buffer->get_height() != height) {
+    _occlusion_buffer = new OcclusionBuffer(width, height);
+  }
+}
+
+/**
+ * Rasterizes the occluders that have been applied to the root of the scene
+ * into the occlusion buffer, and builds its hierarchy, in preparation for the
+ * traversal.
+ */
+void CullTraverser::
+fill_occlusion_buffer(const NodePath &root) {
+  PStatTimer timer(_occlusion_buffer_pcollector, _current_thread);
+
+  _occlusion_buffer->clear(_scene_setup->get_world_transform()->get_mat(),
+                           _scene_setup->get_lens()->get_projection_mat());
+
+  CPT(RenderEffect) effect_p = root.node()->get_effect(OccluderEffect::get_class_type());
+  if (effect_p != nullptr) {
+    const OccluderEffect *effect = (const OccluderEffect *)effect_p.p();
+    int num_occluders = effect->get_num_on_occluders();
+    for (int i = 0; i < num_occluders; ++i) {
+      _occlusion_buffer->add_occluder(effect->get_on_occluder(i), root);
+    }
+  }
+
+  _occlusion_buffer->update_hierarchy();
+}
+
+/**
+ * Estimates the velocity of the camera from its motion since the previous
+ * frame, and if vertex data paging is in effect, moves a copy of the view
+ * frustum to where the camera is expected to be vertex-data-prefetch-time
+ * seconds from now.  Nodes that are culled this frame but fall within that
+ * volume have their vertex data queued for reading in ahead of time.
+ */
+void CullTraverser::
+update_prefetch_volume() {
+  _prefetch_volume = nullptr;
+  _prefetch_budget = 0;
+
+  LPoint3 camera_pos = _scene_setup->get_camera_transform()->get_pos();
+  double frame_time = ClockObject::get_global_clock()->get_frame_time(_current_thread);
+  double dt = frame_time - _last_frame_time;
+
+  if (!_has_last_camera_pos || dt > 1.0) {
+    // Don't extrapolate across a pause or a teleport.
+    _camera_velocity = LVector3::zero();
+
+  } else if (dt > 0.0) {
+    // Smooth it a little, so that a single jittery frame does not send the
+    // prefetch volume flying off.
+    LVector3 velocity = (camera_pos - _last_camera_pos) / dt;
+    _camera_velocity = (_camera_velocity + velocity) * 0.5f;
+  }
+  _has_last_camera_pos = true;
+  _last_camera_pos = camera_pos;
+  _last_frame_time = frame_time;
+
+  if (_view_frustum == nullptr || vertex_data_prefetch_time <= 0.0 ||
+      vertex_data_prefetch_max_nodes <= 0 ||
+      vertex_data_page_threads <= 0 || !Thread::is_threading_supported()) {
+    return;
+  }
+
+  // There is nothing to prefetch if nothing has been paged out.
+  if (VertexDataPage::get_global_lru(VertexDataPage::RC_compressed)->get_total_size() == 0 &&
+      VertexDataPage::get_global_lru(VertexDataPage::RC_disk)->get_total_size() == 0) {
+    return;
+  }
+
+  LVector3 offset = _camera_velocity * (PN_stdfloat)vertex_data_prefetch_time;
+  if (offset.almost_equal(LVector3::zero())) {
+    return;
+  }
+
+  PT(BoundingVolume) volume = _view_frustum->make_copy();
+  _prefetch_volume = volume->as_geometric_bounding_volume();
+  nassertv(_prefetch_volume != nullptr);
+  _prefetch_volume->xform(LMatrix4::translate_mat(offset));
+  _prefetch_budget = vertex_data_prefetch_max_nodes;
+}
+
+/**
+ * Called for a node that was culled because it is outside the view frustum.
+ * If it is within the prefetch volume, asks the page threads to read in the
+ * vertex data of its Geoms and of those below it, without waiting for them.
+ * The bounds are in the coordinate space of the node's parent, whose net
+ * transform is given.
+ */
+void CullTraverser::
+prefetch_vertex_data(PandaNode *node, const TransformState *net_transform,
+                     const BoundingVolume *bounds) {
+  if (_prefetch_budget <= 0) {
+    return;
+  }
+  --_prefetch_budget;
+
+  if (bounds == nullptr || bounds->is_infinite() || bounds->is_empty()) {
+    return;
+  }
+  const GeometricBoundingVolume *gbv = bounds->as_geometric_bounding_volume();
+  if (gbv == nullptr) {
+    return;
+  }
+
+  int result;
+  if (net_transform->is_identity()) {
+    result = _prefetch_volume->contains(gbv);
+  } else {
+    PT(GeometricBoundingVolume) net_gbv = (GeometricBoundingVolume *)gbv->make_copy();
+    net_gbv->xform(net_transform->get_mat());
+    result = _prefetch_volume->contains(net_gbv);
+  }
+  if (result == BoundingVolume::IF_no_intersection) {
+    return;
+  }
+
+  if (node->is_geom_node()) {
+    GeomNode::Geoms geoms = ((GeomNode *)node)->get_geoms(_current_thread);
+    int num_geoms = geoms.get_num_geoms();
+    for (int i = 0; i < num_geoms; ++i) {
+      CPT(Geom) geom = geoms.get_geom(i);
+      geom->request_prefetch();
+      geom->get_vertex_data(_current_thread)->request_prefetch();
+    }
+  }
+
+  CPT(TransformState) child_transform = net_transform->compose(node->get_transform(_current_thread));
+  PandaNode::Children children = node->get_children(_current_thread);
+  size_t num_children = children.get_num_children();
+  for (size_t i = 0; i < num_children && _prefetch_budget > 0; ++i) {
+    const PandaNode::DownConnection &child = children.get_child_connection(i);
+    prefetch_vertex_data(child.get_child(), child_transform, child.get_bounds());
+  }
+}
+
+/**
+ * Performs the traversal using the indicated snapshot of the scene, rather
+ * than the scene graph itself.  The nodes that the snapshot could not
+ * represent are traversed the usual way.
+ */
+void CullTraverser::
+traverse_snapshot(SceneSnapshot *snapshot) {
+  LightReMutexHolder holder(snapshot->get_lock());
+  snapshot->update(_current_thread);
+
+  size_t num_records = snapshot->get_num_records();
+  if (num_records == 0) {
+    return;
+  }
+
+  {
+    // The root is checked the usual way, which takes care of the camera mask.
+    CullTraverserData data(snapshot->get_root(), TransformState::make_identity(),
+                           _initial_state, _view_frustum, _current_thread);
+    if (!data.is_in_view(_camera_mask)) {
+      return;
+    }
+  }
+
+  traverse_snapshot_records(snapshot, 0, num_records, false);
+}
+
+/**
+ * Visits the indicated range of records of the snapshot in order, which must
+ * consist of whole subtrees, skipping over the subtrees that are outside the
+ * view frustum.  If inside is true, the records are all known to be within
+ * the view frustum.
+ */
+void CullTraverser::
+traverse_snapshot_records(const SceneSnapshot *snapshot, size_t begin,
+                          size_t end, bool inside) {
+  // All records before this index are known to be within the view frustum.
+  size_t inside_end = inside ? end : begin;
+
+  size_t i = begin;
+  while (i < end) {
+    const SceneSnapshot::Record &record = snapshot->get_record(i);
+
+    if (_view_frustum != nullptr && i >= inside_end) {
+      int result = _view_frustum->contains(record._bounds);
+      if (result == BoundingVolume::IF_no_intersection) {
+        if (_prefetch_volume != nullptr && _prefetch_budget > 0) {
+          prefetch_vertex_data(record._node, get_snapshot_parent_transform(snapshot, i),
+                               record._node->get_bounds(_current_thread));
+        }
+        i = record._skip;
+        continue;
+      }
+      if ((result & BoundingVolume::IF_all) != 0) {
+        inside_end = record._skip;
+      }
+    }
+    bool record_inside = (_view_frustum == nullptr || i < inside_end);
+
+    if (_occlusion_buffer != nullptr && i != 0 &&
+        _occlusion_buffer->is_occluded(record._bounds)) {
+      _nodes_occluded_pcollector.add_level(1);
+      i = record._skip;
+      continue;
+    }
+
+    bool opaque = (record._flags & SceneSnapshot::RF_opaque) != 0 ||
+      ((record._flags & SceneSnapshot::RF_tagged) != 0 && _has_tag_state_key);
+
+    CPT(RenderState) state;
+    if (!opaque && (record._flags & SceneSnapshot::RF_geom_node) != 0) {
+      // If any of the states have a cull callback, we need to go through
+      // GeomNode::add_for_draw() after all.
+      state = _initial_state->compose(record._net_state);
+      opaque = state->has_cull_callback();
+      int num_geoms = record._geoms.get_num_geoms();
+      for (int gi = 0; gi < num_geoms && !opaque; ++gi) {
+        opaque = record._geoms.get_geom_state(gi)->has_cull_callback();
+      }
+    }
+
+    if (opaque) {
+      traverse_snapshot_node(snapshot, i, record_inside);
+      i = record._skip;
+      continue;
+    }
+
+    _nodes_pcollector.add_level(1);
+    if (state != nullptr) {
+      add_snapshot_geoms(snapshot, i, state, record_inside);
+    }
+
+    if ((record._flags & SceneSnapshot::RF_final) != 0 && inside_end < record._skip) {
+      inside_end = record._skip;
+    }
+
+    if (_parallel && record._skip - i > 1) {
+      // Distribute the subtrees of the children over the threads, as
+      // do_traverse() would.
+      pvector<size_t> children;
+      for (size_t ci = i + 1; ci < record._skip; ci = snapshot->get_record(ci)._skip) {
+        children.push_back(ci);
+      }
+      if ((int)children.size() >= cull_parallel_min_children) {
+        bool children_inside = (_view_frustum == nullptr || record._skip <= inside_end);
+        traverse_parallel(children.size(), [&] (CullTraverser &trav, size_t ci) {
+          size_t child = children[ci];
+          trav.traverse_snapshot_records(snapshot, child,
+                                         snapshot->get_record(child)._skip,
+                                         children_inside);
+        });
+        i = record._skip;
+        continue;
+      }
+    }
+    ++i;
+  }
+}
+
+/**
+ * Returns the net transform of the parent of the indicated record of the
+ * snapshot, relative to the root.
+ */
+const TransformState *CullTraverser::
+get_snapshot_parent_transform(const SceneSnapshot *snapshot, size_t n) {
+  int parent = snapshot->get_record(n)._parent;
+  if (parent >= 0) {
+    return snapshot->get_record(parent)._net_transform;
+  } else {
+    return TransformState::make_identity();
+  }
+}
+
+/**
+ * Traverses the node of the indicated record of the snapshot, and the nodes
+ * below it, the usual way.
+ */
+void CullTraverser::
+traverse_snapshot_node(const SceneSnapshot *snapshot, size_t n, bool inside) {
+  const SceneSnapshot::Record &record = snapshot->get_record(n);
+
+  const TransformState *parent_transform = get_snapshot_parent_transform(snapshot, n);
+  CPT(RenderState) parent_state;
+  if (record._parent >= 0) {
+    parent_state = _initial_state->compose(snapshot->get_record(record._parent)._net_state);
+  } else {
+    parent_state = _initial_state;
+  }
+
+  // The view frustum needs to be moved into the parent's coordinate space.
+  PT(GeometricBoundingVolume) view_frustum;
+  if (!inside) {
+    view_frustum = make_snapshot_view_frustum(parent_transform);
+  }
+
+  CullTraverserData data(snapshot->get_node_path(n), parent_transform,
+                         parent_state, view_frustum, _current_thread);
+  if (data.is_in_view(_camera_mask)) {
+    do_traverse(data);
+  }
+}
+
+/**
+ * Returns the view frustum, moved into the coordinate space with the given
+ * net transform, or nullptr if the transform can't be inverted.
+ */
+PT(GeometricBoundingVolume) CullTraverser::
+make_snapshot_view_frustum(const TransformState *net_transform) const {
+  if (net_transform->is_identity()) {
+    return _view_frustum;
+  }
+  const LMatrix4 *inverse_mat = net_transform->get_inverse_mat();
+  if (inverse_mat == nullptr) {
+    return nullptr;
+  }
+  PT(GeometricBoundingVolume) view_frustum =
+    _view_frustum->make_copy()->as_geometric_bounding_volume();
+  view_frustum->xform(*inverse_mat);
+  return view_frustum;
+}
+
+/**
+ * Passes the Geoms of the GeomNode of the indicated snapshot record to the
+ * CullHandler, in the same way as GeomNode::add_for_draw().
+ */
+void CullTraverser::
+add_snapshot_geoms(const SceneSnapshot *snapshot, size_t n,
+                   const RenderState *state, bool inside) {
+  const SceneSnapshot::Record &record = snapshot->get_record(n);
+  _geom_nodes_pcollector.add_level(1);
+
+  // The Geoms are culled individually, or by cluster, against the view
+  // frustum, which we need in the node's coordinate space for that.  With a
+  // single Geom without clusters, the node's own test is all there is.
+  const GeomNode::Geoms &geoms = record._geoms;
+  int num_geoms = geoms.get_num_geoms();
+  PT(GeometricBoundingVolume) view_frustum;
+  if (!inside && (record._flags & SceneSnapshot::RF_final) == 0 &&
+      (num_geoms > 1 || (num_geoms == 1 && geoms.get_geom(0)->get_clusters() != nullptr))) {
+    view_frustum = make_snapshot_view_frustum(record._net_transform);
+  }
+
+  CullTraverserData data(snapshot->get_node_path(n), record._net_transform,
+                         state, view_frustum, _current_thread);
+  ((const GeomNode *)record._node)->add_geoms_for_draw(geoms, this, data);
+}
+
+/**
+ * Traverses the indicated children of the node, testing all of their bounding
+ * volumes against the view frustum in one go first.
+ */
+void CullTraverser::
+traverse_children_batched(const CullTraverserData &data,
+                          const PandaNode::Children &children) {
+  int num_children = children.get_num_children();
+
+  _bounds_batch.clear();
+  _bounds_batch.reserve(num_children);
+  for (int i = 0; i < num_children; ++i) {
+    _bounds_batch.add_volume(children.get_child_connection(i).get_bounds());
+  }
+
+  pvector<int> results(num_children);
+  _bounds_batch.contained_by(data._view_frustum, &results[0]);
+
+  // The batch is reused further down the traversal, so we can't hold on to
+  // the volumes in it, but the Children object keeps them alive anyway.
+  _bounds_batch.clear();
+
+  for (int i = 0; i < num_children; ++i) {
+    const PandaNode::DownConnection &child = children.get_child_connection(i);
+    int result = results[i];
+    if (!child.compare_draw_mask(data._draw_mask, _camera_mask)) {
+      result = BoundingVolume::IF_no_intersection;
+    }
+    do_traverse_down(data, child, data._state, result);
+  }
+}
+
 /**
  * Draws an appropriate visualization of the node's external bounding volume.
  */
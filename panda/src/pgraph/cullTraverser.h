@@ -21,6 +21,9 @@
 #include "renderState.h"
 #include "transformState.h"
 #include "geometricBoundingVolume.h"
+#include "boundingVolumeBatch.h"
+#include "occlusionBuffer.h"
+#include "sceneSnapshot.h"
 #include "pointerTo.h"
 #include "camera.h"
 #include "drawMask.h"
@@ -78,6 +81,15 @@ PUBLISHED:
   INLINE bool get_effective_incomplete_render() const;
   INLINE bool get_fake_view_frustum_cull() const;
 
+  INLINE void set_num_threads(int num_threads);
+  INLINE int get_num_threads() const;
+
+  INLINE void set_occlusion_buffer(OcclusionBuffer *buffer);
+  INLINE OcclusionBuffer *get_occlusion_buffer() const;
+
+  INLINE void set_scene_snapshot(SceneSnapshot *snapshot);
+  INLINE SceneSnapshot *get_scene_snapshot() const;
+
   INLINE static void flush_level();
 
   void traverse(const NodePath &root);
@@ -111,8 +123,36 @@ public:
   static PStatCollector _pgui_nodes_pcollector;
   static PStatCollector _geoms_pcollector;
   static PStatCollector _geoms_occluded_pcollector;
+  static PStatCollector _nodes_occluded_pcollector;
+  static PStatCollector _occlusion_buffer_pcollector;
 
 private:
+  INLINE void do_traverse_down(const CullTraverserData &data,
+                               const PandaNode::DownConnection &child,
+                               const RenderState *state, int result);
+  void traverse_children_parallel(const CullTraverserData &data,
+                                  const PandaNode::Children &children);
+  template<class Callable>
+  void traverse_parallel(size_t count, Callable callable);
+  void traverse_children_batched(const CullTraverserData &data,
+                                 const PandaNode::Children &children);
+  void update_occlusion_buffer();
+  void fill_occlusion_buffer(const NodePath &root);
+  void update_prefetch_volume();
+  void prefetch_vertex_data(PandaNode *node,
+                            const TransformState *net_transform,
+                            const BoundingVolume *bounds);
+  void traverse_snapshot(SceneSnapshot *snapshot);
+  void traverse_snapshot_records(const SceneSnapshot *snapshot, size_t begin,
+                                 size_t end, bool inside);
+  static const TransformState *
+  get_snapshot_parent_transform(const SceneSnapshot *snapshot, size_t n);
+  void traverse_snapshot_node(const SceneSnapshot *snapshot, size_t n,
+                              bool inside);
+  PT(GeometricBoundingVolume)
+  make_snapshot_view_frustum(const TransformState *net_transform) const;
+  void add_snapshot_geoms(const SceneSnapshot *snapshot, size_t n,
+                          const RenderState *state, bool inside);
   void show_bounds(CullTraverserData &data, bool tight);
   static PT(Geom) make_bounds_viz(const BoundingVolume *vol);
   PT(Geom) make_tight_bounds_viz(PandaNode *node) const;
@@ -134,6 +174,24 @@ private:
   CullHandler *_cull_handler;
   PortalClipper *_portal_clipper;
   bool _effective_incomplete_render;
+  int _num_threads;
+  bool _parallel;
+  BoundingVolumeBatch _bounds_batch;
+  PT(OcclusionBuffer) _occlusion_buffer;
+  bool _auto_occlusion_buffer;
+  PT(SceneSnapshot) _scene_snapshot;
+
+  // The view frustum, moved to where the camera is expected to be a short
+  // while from now, and the number of culled nodes that may still be tested
+  // against it this frame.  See prefetch_vertex_data().
+  PT(GeometricBoundingVolume) _prefetch_volume;
+  int _prefetch_budget;
+  bool _has_last_camera_pos;
+  LPoint3 _last_camera_pos;
+  double _last_frame_time;
+  LVector3 _camera_velocity;
+
+  class DeferredHandler;
 
 public:
   static TypeHandle get_class_type() {
@@ -37,9 +37,12 @@
 #include "graphicsStateGuardianBase.h"
 #include "boundingBox.h"
 #include "boundingSphere.h"
+#include "boundingVolumeBatch.h"
 #include "config_mathutil.h"
 #include "preparedGraphicsObjects.h"
 #include "instanceList.h"
+#include "sceneSetup.h"
+#include "lens.h"
 
 
 bool allow_flatten_color = ConfigVariableBool
@@ -522,10 +525,19 @@ add_for_draw(CullTraverser *trav, CullTraverserData &data) {
       << " draw_mask = " << data._draw_mask << "\n";
   }
 
-  Thread *current_thread = trav->get_current_thread();
-
   // Get all the Geoms, with no decalling.
-  Geoms geoms = get_geoms(current_thread);
+  add_geoms_for_draw(get_geoms(trav->get_current_thread()), trav, data);
+}
+
+/**
+ * Passes the indicated Geoms of this node to the CullHandler.  This does the
+ * work of add_for_draw(); the CullTraverser also calls it directly for the
+ * Geoms that a SceneSnapshot has recorded for this node.
+ */
+void GeomNode::
+add_geoms_for_draw(const Geoms &geoms, CullTraverser *trav,
+                   CullTraverserData &data) const {
+  Thread *current_thread = trav->get_current_thread();
   int num_geoms = geoms.get_num_geoms();
   trav->_geoms_pcollector.add_level(num_geoms);
   CPT(TransformState) internal_transform = data.get_internal_transform(trav);
@@ -537,7 +549,8 @@ add_for_draw(CullTraverser *trav, CullTraverserData &data) {
     CPT(Geom) geom = geoms.get_geom(0);
     if (!geom->is_empty()) {
       CPT(RenderState) state = data._state->compose(geoms.get_geom_state(0));
-      if (!state->has_cull_callback() || state->cull_callback(trav, data)) {
+      if ((!state->has_cull_callback() || state->cull_callback(trav, data)) &&
+          cull_clusters(geom, state, trav, data)) {
         CullableObject object(std::move(geom), std::move(state), std::move(internal_transform));
         object._instances = data._instances;
         trav->get_cull_handler()->record_object(std::move(object), trav);
@@ -545,7 +558,23 @@ add_for_draw(CullTraverser *trav, CullTraverserData &data) {
     }
   }
   else {
-    // More than one Geom.
+    // More than one Geom.  If there are many of them, test their bounding
+    // volumes against the view frustum all at once, up front.
+    pvector<int> in_view;
+    if (data._view_frustum != nullptr && data._instances == nullptr &&
+        cull_batch_min_volumes > 0 && num_geoms >= cull_batch_min_volumes) {
+      pvector<CPT(BoundingVolume)> volumes;
+      volumes.reserve(num_geoms);
+      BoundingVolumeBatch batch;
+      batch.reserve(num_geoms);
+      for (int i = 0; i < num_geoms; i++) {
+        volumes.push_back(geoms.get_geom(i)->get_bounds(current_thread));
+        batch.add_volume(volumes.back()->as_geometric_bounding_volume());
+      }
+      in_view.resize(num_geoms);
+      batch.contained_by(data._view_frustum, &in_view[0]);
+    }
+
     for (int i = 0; i < num_geoms; i++) {
       CPT(Geom) geom = geoms.get_geom(i);
       if (geom->is_empty()) {
@@ -568,8 +597,14 @@ add_for_draw(CullTraverser *trav, CullTraverserData &data) {
       }
 
       // Cull the individual Geom against the view frustum.
-      if (data._view_frustum != nullptr &&
-          !geom->is_in_view(data._view_frustum, current_thread)) {
+      if (!in_view.empty()) {
+        if (in_view[i] == BoundingVolume::IF_no_intersection) {
+          // Cull this Geom.
+          continue;
+        }
+      }
+      else if (data._view_frustum != nullptr &&
+               !geom->is_in_view(data._view_frustum, current_thread)) {
         // Cull this Geom.
         continue;
       }
@@ -586,12 +621,69 @@ add_for_draw(CullTraverser *trav, CullTraverserData &data) {
         }
       }
 
+      if (!cull_clusters(geom, state, trav, data)) {
+        // All of its clusters are culled.
+        continue;
+      }
+
       trav->get_cull_handler()->record_object(CullableObject(
         std::move(geom), std::move(state), internal_transform), trav);
     }
   }
 }
 
+/**
+ * If the indicated Geom has been partitioned into clusters, replaces it with
+ * a version that draws only the clusters that are within the view frustum and
+ * not facing entirely away from the camera.  Returns false if none of them
+ * are visible.  See Geom::cull_clusters().
+ */
+bool GeomNode::
+cull_clusters(CPT(Geom) &geom, const RenderState *state,
+              CullTraverser *trav, CullTraverserData &data) const {
+  if (!cluster_cull || data._instances != nullptr ||
+      geom->get_clusters() == nullptr) {
+    return true;
+  }
+
+  // The back faces can only be culled if we know which way they are facing.
+  // This test requires a perspective lens; a mirroring transform reverses
+  // the winding on screen.
+  LPoint3 camera_pos;
+  bool has_camera_pos = false;
+  bool reverse = false;
+  const CullFaceAttrib *cfa;
+  state->get_attrib_def(cfa);
+  CullFaceAttrib::Mode mode = cfa->get_effective_mode();
+  const Lens *lens = trav->get_scene()->get_lens();
+  if (mode != CullFaceAttrib::M_cull_none && lens != nullptr && lens->is_perspective()) {
+    CPT(TransformState) modelview = data.get_modelview_transform(trav);
+    const LMatrix4 &mat = modelview->get_mat();
+    reverse = (mode == CullFaceAttrib::M_cull_counter_clockwise);
+    if (mat.get_upper_3().determinant() < 0) {
+      reverse = !reverse;
+    }
+    camera_pos = modelview->get_inverse()->get_pos();
+    has_camera_pos = true;
+  }
+
+  if (data._view_frustum == nullptr && !has_camera_pos) {
+    return true;
+  }
+
+  // Each display region keeps its own subset, since each sees different
+  // clusters.
+  const SceneSetup *scene = trav->get_scene();
+  const void *cache_key = scene->get_display_region();
+  if (cache_key == nullptr) {
+    cache_key = scene->get_camera_node();
+  }
+  geom = geom->cull_clusters(data._view_frustum,
+                             has_camera_pos ? &camera_pos : nullptr, reverse,
+                             cache_key, trav->get_current_thread());
+  return geom != nullptr;
+}
+
 /**
  * Returns the subset of CollideMask bits that may be set for this particular
  * type of PandaNode.  For most nodes, this is 0; it doesn't make sense to set
@@ -740,9 +832,23 @@ decompose() {
  */
 void GeomNode::
 unify(int max_indices, bool preserve_order) {
+  if (do_unify(max_indices, preserve_order, Thread::get_current_thread())) {
+    mark_internal_bounds_stale();
+  }
+}
+
+/**
+ * The implementation of unify().  This does not mark the bounding volume of
+ * the node stale; instead, it returns true if the Geoms were changed, in
+ * which case the caller must call mark_internal_bounds_stale().
+ *
+ * Since this only modifies the node itself, this may be called for different
+ * nodes on different threads at the same time, even if they share ancestors.
+ */
+bool GeomNode::
+do_unify(int max_indices, bool preserve_order, Thread *current_thread) {
   bool any_changed = false;
 
-  Thread *current_thread = Thread::get_current_thread();
   OPEN_ITERATE_CURRENT_AND_UPSTREAM(_cycler, current_thread) {
     CDStageWriter cdata(_cycler, pipeline_stage, current_thread);
 
@@ -794,16 +900,14 @@ unify(int max_indices, bool preserve_order) {
     GeomList::iterator wgi;
     for (wgi = new_geoms->begin(); wgi != new_geoms->end(); ++wgi) {
       GeomEntry &entry = (*wgi);
-      nassertv(entry._geom.test_ref_count_integrity());
+      nassertr(entry._geom.test_ref_count_integrity(), any_changed);
       PT(Geom) geom = entry._geom.get_write_pointer();
       geom->unify_in_place(max_indices, preserve_order);
     }
   }
   CLOSE_ITERATE_CURRENT_AND_UPSTREAM(_cycler);
 
-  if (any_changed) {
-    mark_internal_bounds_stale();
-  }
+  return any_changed;
 }
 
 /**
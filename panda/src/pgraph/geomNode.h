@@ -98,6 +98,8 @@ public:
   void do_premunge(GraphicsStateGuardianBase *gsg,
                    const RenderState *node_state,
                    GeomTransformer &transformer);
+  bool do_unify(int max_indices, bool preserve_order,
+                Thread *current_thread);
 
 protected:
   virtual void r_mark_geom_bounds_stale(Thread *current_thread);
@@ -126,6 +128,9 @@ private:
   INLINE void count_name(NameCount &name_count, const InternalName *name);
   INLINE int get_name_count(const NameCount &name_count, const InternalName *name);
 
+  bool cull_clusters(CPT(Geom) &geom, const RenderState *state,
+                     CullTraverser *trav, CullTraverserData &data) const;
+
   // This is the data that must be cycled between pipeline stages.
   class EXPCL_PANDA_PGRAPH CData : public CycleData {
   public:
@@ -177,6 +182,8 @@ public:
   };
 
   INLINE Geoms get_geoms(Thread *current_thread = Thread::get_current_thread()) const;
+  void add_geoms_for_draw(const Geoms &geoms, CullTraverser *trav,
+                          CullTraverserData &data) const;
 
   // This data is only needed when reading from a bam file.
   class BamAuxData : public BamReader::AuxData {
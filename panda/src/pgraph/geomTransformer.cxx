@@ -30,6 +30,8 @@
 #include "textureAttrib.h"
 #include "colorAttrib.h"
 #include "config_pgraph.h"
+#include "asyncTaskManager.h"
+#include "vertexCacheOptimizer.h"
 
 PStatCollector GeomTransformer::_apply_vertex_collector("*:Flatten:apply:vertex");
 PStatCollector GeomTransformer::_apply_texcoord_collector("*:Flatten:apply:texcoord");
@@ -45,8 +47,9 @@ TypeHandle GeomTransformer::NewCollectedData::_type_handle;
  */
 GeomTransformer::
 GeomTransformer() :
-  // The default value here comes from the Config file.
-  _max_collect_vertices(max_collect_vertices)
+  // The default values here come from the Config file.
+  _max_collect_vertices(max_collect_vertices),
+  _num_threads(flatten_num_threads)
 {
 }
 
@@ -55,7 +58,8 @@ GeomTransformer() :
  */
 GeomTransformer::
 GeomTransformer(const GeomTransformer &copy) :
-  _max_collect_vertices(copy._max_collect_vertices)
+  _max_collect_vertices(copy._max_collect_vertices),
+  _num_threads(copy._num_threads)
 {
 }
 
@@ -940,6 +944,83 @@ finish_apply() {
   _reversed_normals.clear();
 }
 
+/**
+ * Reorders the triangles of each of the Geoms of the node for better use of
+ * the vertex cache.  See Geom::optimize_vertex_cache_in_place().  The
+ * vertices themselves are not rearranged, since the vertex data may be shared
+ * with Geoms in other nodes; use register_vertices() and reorder_vertices()
+ * for that.  Returns true if any Geom was changed.
+ *
+ * Since this only modifies the node itself, this may be called for different
+ * nodes on different threads at the same time.
+ */
+bool GeomTransformer::
+optimize_vertex_cache(GeomNode *node) {
+  bool any_changed = false;
+
+  Thread *current_thread = Thread::get_current_thread();
+  OPEN_ITERATE_CURRENT_AND_UPSTREAM(node->_cycler, current_thread) {
+    GeomNode::CDStageWriter cdata(node->_cycler, pipeline_stage, current_thread);
+    for (GeomNode::GeomEntry &entry : *cdata->modify_geoms()) {
+      PT(Geom) geom = entry._geom.get_write_pointer();
+      UpdateSeq modified = geom->get_modified(current_thread);
+      geom->optimize_vertex_cache_in_place(false);
+      if (geom->get_modified(current_thread) != modified) {
+        any_changed = true;
+      }
+    }
+  }
+  CLOSE_ITERATE_CURRENT_AND_UPSTREAM(node->_cycler);
+
+  return any_changed;
+}
+
+/**
+ * Partitions the triangles of each of the Geoms of the node into clusters
+ * that can be culled individually.  See Geom::make_clusters_in_place().
+ * Returns the number of Geoms that were partitioned.
+ *
+ * Since this only modifies the node itself, this may be called for different
+ * nodes on different threads at the same time.
+ */
+int GeomTransformer::
+make_clusters(GeomNode *node, int max_triangles) {
+  int num_clustered = 0;
+
+  Thread *current_thread = Thread::get_current_thread();
+  OPEN_ITERATE_CURRENT_AND_UPSTREAM(node->_cycler, current_thread) {
+    GeomNode::CDStageWriter cdata(node->_cycler, pipeline_stage, current_thread);
+    num_clustered = 0;
+    for (GeomNode::GeomEntry &entry : *cdata->modify_geoms()) {
+      PT(Geom) geom = entry._geom.get_write_pointer();
+      if (geom->make_clusters_in_place(max_triangles)) {
+        ++num_clustered;
+      }
+    }
+  }
+  CLOSE_ITERATE_CURRENT_AND_UPSTREAM(node->_cycler);
+
+  return num_clustered;
+}
+
+/**
+ * Rearranges the rows of each GeomVertexData registered with
+ * register_vertices() in the order in which they are first used by the Geoms
+ * that share it, for better locality of the vertex fetches.  Returns the
+ * number of GeomVertexDatas that were replaced.
+ */
+int GeomTransformer::
+reorder_vertices() {
+  int num_changed = 0;
+  for (VertexDataAssocMap::value_type &item : _vdata_assoc) {
+    if (item.second.reorder_vertices(item.first)) {
+      ++num_changed;
+    }
+  }
+  _vdata_assoc.clear();
+  return num_changed;
+}
+
 /**
  * Collects together GeomVertexDatas from different geoms into one big (or
  * several big) GeomVertexDatas.  Returns the number of unique GeomVertexDatas
@@ -1103,17 +1184,22 @@ int GeomTransformer::
 finish_collect(bool format_only) {
   int num_adjusted = 0;
 
-  NewCollectedList::iterator nci;
-  for (nci = _new_collected_list.begin();
-       nci != _new_collected_list.end();
-       ++nci) {
-    NewCollectedData *ncd = (*nci);
+  // Each NewCollectedData involves a different set of GeomVertexDatas and
+  // Geoms, so they can be applied in parallel.
+  size_t num_collected = _new_collected_list.size();
+  vector_int counts(num_collected, 0);
+  parallel_for(num_collected, [&] (size_t i) {
+    NewCollectedData *ncd = _new_collected_list[i];
     if (format_only) {
-      num_adjusted += ncd->apply_format_only_changes();
+      counts[i] = ncd->apply_format_only_changes();
     } else {
-      num_adjusted += ncd->apply_collect_changes();
+      counts[i] = ncd->apply_collect_changes();
     }
-    delete ncd;
+  });
+
+  for (size_t i = 0; i < num_collected; ++i) {
+    num_adjusted += counts[i];
+    delete _new_collected_list[i];
   }
 
   _new_collected_list.clear();
@@ -1123,6 +1209,20 @@ finish_collect(bool format_only) {
   return num_adjusted;
 }
 
+/**
+ * Returns the task chain that is used to distribute work over the indicated
+ * number of threads.
+ */
+AsyncTaskChain *GeomTransformer::
+get_task_chain(int num_threads) {
+  static PT(AsyncTaskChain) chain =
+    AsyncTaskManager::get_global_ptr()->make_task_chain("flatten");
+  if (chain->get_num_threads() < num_threads) {
+    chain->set_num_threads(num_threads);
+  }
+  return chain;
+}
+
 /**
  * Uses the indicated munger to premunge the given Geom to optimize it for
  * eventual rendering.  See SceneGraphReducer::premunge().
@@ -1565,3 +1665,57 @@ remove_unused_vertices(const GeomVertexData *vdata) {
     geom->set_vertex_data(new_vdata);
   }
 }
+
+/**
+ * Rearranges the rows of the indicated GeomVertexData in the order in which
+ * they are first used by the associated Geoms, and makes the Geoms use the
+ * new vertex data.  Returns true if the vertex data was replaced, or false if
+ * it was already in the right order.
+ */
+bool GeomTransformer::VertexDataAssoc::
+reorder_vertices(const GeomVertexData *vdata) {
+  int num_vertices = vdata->get_num_rows();
+  if (_geoms.empty() || num_vertices <= 0) {
+    return false;
+  }
+
+  Thread *current_thread = Thread::get_current_thread();
+
+  // The same Geom may have been registered more than once.
+  pvector<Geom *> geoms;
+  pset<Geom *> visited;
+  for (Geom *geom : _geoms) {
+    if (geom->get_vertex_data() == vdata && visited.insert(geom).second) {
+      geoms.push_back(geom);
+    }
+  }
+
+  pvector<int> indices;
+  for (Geom *geom : geoms) {
+    size_t num_primitives = geom->get_num_primitives();
+    for (size_t i = 0; i < num_primitives; ++i) {
+      VertexCacheOptimizer::read_indices(geom->get_primitive(i), indices,
+                                         current_thread);
+    }
+  }
+
+  pvector<int> remap;
+  if (!VertexCacheOptimizer::optimize_vertex_fetch(indices.data(), indices.size(),
+                                                   num_vertices, remap)) {
+    return false;
+  }
+
+  PT(GeomVertexData) new_vdata =
+    VertexCacheOptimizer::remap_vertices(vdata, remap, current_thread);
+  nassertr(new_vdata != nullptr, false);
+
+  for (Geom *geom : geoms) {
+    size_t num_primitives = geom->get_num_primitives();
+    for (size_t i = 0; i < num_primitives; ++i) {
+      PT(GeomPrimitive) prim = geom->modify_primitive(i);
+      VertexCacheOptimizer::remap_indices(prim, remap, current_thread);
+    }
+    geom->set_vertex_data(new_vdata);
+  }
+  return true;
+}
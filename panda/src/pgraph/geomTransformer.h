@@ -20,6 +20,7 @@
 #include "geom.h"
 #include "geomVertexData.h"
 #include "texMatrixAttrib.h"
+#include "asyncTaskChain.h"
 
 class GeomNode;
 class RenderState;
@@ -48,6 +49,9 @@ public:
   INLINE int get_max_collect_vertices() const;
   INLINE void set_max_collect_vertices(int max_collect_vertices);
 
+  INLINE int get_num_threads() const;
+  INLINE void set_num_threads(int num_threads);
+
   void register_vertices(PT(Geom) geom, bool might_have_unused);
   void register_vertices(GeomNode *node, bool might_have_unused);
 
@@ -84,14 +88,26 @@ public:
 
   void finish_apply();
 
+  bool optimize_vertex_cache(GeomNode *node);
+  int make_clusters(GeomNode *node, int max_triangles);
+  int reorder_vertices();
+
   int collect_vertex_data(Geom *geom, int collect_bits, bool format_only);
   int collect_vertex_data(GeomNode *node, int collect_bits, bool format_only);
   int finish_collect(bool format_only);
 
   PT(Geom) premunge_geom(const Geom *geom, GeomMunger *munger);
 
+#ifndef CPPPARSER
+  template<class Callable>
+  INLINE void parallel_for(size_t count, Callable callable) const;
+#endif
+
 private:
+  static AsyncTaskChain *get_task_chain(int num_threads);
+
   int _max_collect_vertices;
+  int _num_threads;
 
   typedef pvector<PT(Geom) > GeomList;
 
@@ -104,6 +120,7 @@ private:
     bool _might_have_unused;
     GeomList _geoms;
     void remove_unused_vertices(const GeomVertexData *vdata);
+    bool reorder_vertices(const GeomVertexData *vdata);
   };
   typedef pmap<CPT(GeomVertexData), VertexDataAssoc> VertexDataAssocMap;
   VertexDataAssocMap _vdata_assoc;
@@ -0,0 +1,85 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file localCompositionCache.h
+ * @author rdb
+ * @date 2026-10-17
+ */
+
+#ifndef LOCALCOMPOSITIONCACHE_H
+#define LOCALCOMPOSITIONCACHE_H
+
+#include "pandabase.h"
+#include "pointerTo.h"
+#include "pvector.h"
+#include "lightMutex.h"
+#include "lightMutexHolder.h"
+
+#include <algorithm>
+
+/**
+ * A small, direct-mapped cache of recent compositions of RenderStates or
+ * TransformStates, of which each thread keeps its own copy.  It sits in front
+ * of the composition cache stored on the states themselves, which can only be
+ * consulted while holding the global _states_lock; when many threads are
+ * composing states at the same time, most of their compositions can be
+ * answered from here without touching that lock at all.  Each cache has a
+ * lock of its own, but it is only contended while the cache is being flushed.
+ *
+ * Each entry holds a reference to both operands as well as to the result, so
+ * the pointers it stores can never be reused by a different state while the
+ * entry exists.  This means that an entry never becomes wrong.  It also means
+ * that the states in the cache are kept alive, even if the thread owning the
+ * cache never composes another state, so the owning class flushes the caches
+ * of all threads with flush_all() whenever it collects garbage or clears its
+ * state cache.  A state that is no longer used is therefore released by the
+ * next call to garbage_collect() at the latest.
+ *
+ * The entries are only ever accessed by the owning thread and by flush_all(),
+ * so this is intended to be stored in a thread_local variable.
+ */
+template<class State>
+class LocalCompositionCache {
+public:
+  explicit LocalCompositionCache(size_t size);
+  ~LocalCompositionCache();
+
+  INLINE CPT(State) find(const State *a, const State *b, bool invert);
+  INLINE void store(const State *a, const State *b, bool invert,
+                    const State *result);
+
+  static void flush_all();
+
+private:
+  INLINE size_t get_slot(const State *a, const State *b, bool invert) const;
+
+  class Entry {
+  public:
+    CPT(State) _a;
+    CPT(State) _b;
+    CPT(State) _result;
+    bool _invert = false;
+  };
+  typedef pvector<Entry> Entries;
+  Entries _entries;
+  size_t _mask;
+  LightMutex _lock;
+
+  // All of the caches that currently exist, one for each thread that has
+  // composed a state.
+  class Registry {
+  public:
+    LightMutex _lock;
+    pvector<LocalCompositionCache<State> *> _caches;
+  };
+  static Registry &get_registry();
+};
+
+#include "localCompositionCache.I"
+
+#endif
@@ -0,0 +1,460 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file occlusionBuffer.cxx
+ * @author rdb
+ * @date 2026-10-17
+ */
+
+#include "occlusionBuffer.h"
+#include "occluderNode.h"
+#include "finiteBoundingVolume.h"
+#include "plane.h"
+
+#include <algorithm>
+
+#if defined(__SSE2__) || (_M_IX86_FP >= 2) || defined(_M_X64) || defined(_M_AMD64)
+#include <xmmintrin.h>
+#include <emmintrin.h>
+#define OCCLUSION_USE_SSE2
+#elif defined(__ARM_NEON) || defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define OCCLUSION_USE_NEON
+#endif
+
+/**
+ * Creates a new buffer of the indicated size.  The size should typically be
+ * much smaller than that of the window; a width of 256 pixels or so is usually
+ * a good balance between the cost of rasterizing the occluders and the number
+ * of nodes that can be culled.
+ */
+OcclusionBuffer::
+OcclusionBuffer(int width, int height) :
+  _width(std::max(width, 1)),
+  _height(std::max(height, 1)),
+  _hierarchy_stale(true),
+  _view_mat(LMatrix4::ident_mat()),
+  _projection_mat(LMatrix4::ident_mat()),
+  _clip_mat(LMatrix4::ident_mat())
+{
+  // The rows of the full-size buffer are padded to a multiple of four pixels,
+  // so that the rasterizer can always write four pixels at a time.
+  _stride = (_width + 3) & ~3;
+
+  Level level;
+  level._width = _width;
+  level._height = _height;
+  level._stride = _stride;
+  level._depths.resize((size_t)_stride * _height, 1.0f);
+  _levels.push_back(std::move(level));
+
+  while (level._width > 1 || level._height > 1) {
+    level._width = (level._width + 1) / 2;
+    level._height = (level._height + 1) / 2;
+    level._stride = level._width;
+    level._depths.clear();
+    level._depths.resize((size_t)level._width * level._height, 1.0f);
+    _levels.push_back(level);
+  }
+}
+
+/**
+ * Empties the buffer, and prepares it for rendering occluders with the
+ * indicated camera.  The view matrix transforms from the coordinate space in
+ * which occluders and volumes will be given into the space of the lens, and
+ * the projection matrix is the lens's projection matrix.
+ */
+void OcclusionBuffer::
+clear(const LMatrix4 &view_mat, const LMatrix4 &projection_mat) {
+  _view_mat = view_mat;
+  _projection_mat = projection_mat;
+  _clip_mat = view_mat * projection_mat;
+
+  for (Level &level : _levels) {
+    std::fill(level._depths.begin(), level._depths.end(), 1.0f);
+  }
+  _occluders.clear();
+  _hierarchy_stale = true;
+}
+
+/**
+ * Rasterizes the indicated OccluderNode into the buffer.  The root is the
+ * node relative to which the view matrix was given to clear().  Returns true
+ * if the occluder was drawn, false if it was facing away from the camera or
+ * was not visible.
+ *
+ * Either way, the occluder is remembered, and has_occluder() will return true
+ * for it.
+ */
+bool OcclusionBuffer::
+add_occluder(const NodePath &occluder, const NodePath &root) {
+  nassertr(!occluder.is_empty() &&
+           occluder.node()->is_of_type(OccluderNode::get_class_type()), false);
+
+  OccluderNode *occluder_node = (OccluderNode *)occluder.node();
+  nassertr(occluder_node->get_num_vertices() == 4, false);
+  _occluders.insert(occluder);
+
+  CPT(TransformState) transform = occluder.get_transform(root);
+  const LMatrix4 &mat = transform->get_mat();
+  return add_quad(occluder_node->get_vertex(0) * mat,
+                  occluder_node->get_vertex(1) * mat,
+                  occluder_node->get_vertex(2) * mat,
+                  occluder_node->get_vertex(3) * mat,
+                  occluder_node->is_double_sided());
+}
+
+/**
+ * Rasterizes the indicated convex quadrilateral into the buffer.  Like an
+ * OccluderNode, the quad only occludes when seen from the front, unless
+ * double_sided is true.  Returns true if the quad was drawn.
+ */
+bool OcclusionBuffer::
+add_quad(const LPoint3 &v0, const LPoint3 &v1, const LPoint3 &v2,
+         const LPoint3 &v3, bool double_sided) {
+  LPoint3 points[4] = {
+    v0 * _view_mat,
+    v1 * _view_mat,
+    v2 * _view_mat,
+    v3 * _view_mat,
+  };
+
+  // This is the same test that CullPlanes uses to decide whether an occluder
+  // is facing the camera.
+  LPlane plane(points[0], points[1], points[2]);
+  if (!double_sided && plane.get_normal().dot(LVector3::forward()) >= 0) {
+    return false;
+  }
+
+  // Clip the quad against the near plane; the rest of the clipping is taken
+  // care of by the rasterizer.
+  LVecBase4 clip[4];
+  for (int i = 0; i < 4; ++i) {
+    clip[i] = _projection_mat.xform(LVecBase4(points[i], 1));
+  }
+
+  LVecBase4 poly[8];
+  int num_points = 0;
+  for (int i = 0; i < 4; ++i) {
+    const LVecBase4 &a = clip[i];
+    const LVecBase4 &b = clip[(i + 1) % 4];
+    PN_stdfloat da = a[2] + a[3];
+    PN_stdfloat db = b[2] + b[3];
+    if (da >= 0) {
+      poly[num_points++] = a;
+    }
+    if ((da >= 0) != (db >= 0)) {
+      poly[num_points++] = a + (b - a) * (da / (da - db));
+    }
+  }
+  if (num_points < 3) {
+    return false;
+  }
+
+  Vertex verts[8];
+  for (int i = 0; i < num_points; ++i) {
+    PN_stdfloat w = poly[i][3];
+    if (!(w > 0)) {
+      return false;
+    }
+    verts[i]._x = (poly[i][0] / w * 0.5f + 0.5f) * _width;
+    verts[i]._y = (poly[i][1] / w * 0.5f + 0.5f) * _height;
+    verts[i]._z = poly[i][2] / w * 0.5f + 0.5f;
+  }
+
+  draw_polygon(verts, num_points);
+  _hierarchy_stale = true;
+  return true;
+}
+
+/**
+ * Rebuilds the smaller levels of the hierarchy from the full-size buffer.
+ * This must be called after the occluders have been added, before any volumes
+ * are tested.
+ */
+void OcclusionBuffer::
+update_hierarchy() {
+  for (size_t li = 1; li < _levels.size(); ++li) {
+    const Level &prev = _levels[li - 1];
+    Level &level = _levels[li];
+
+    for (int y = 0; y < level._height; ++y) {
+      const float *row0 = &prev._depths[(size_t)(y * 2) * prev._stride];
+      const float *row1 = &prev._depths[(size_t)std::min(y * 2 + 1, prev._height - 1) * prev._stride];
+      float *out = &level._depths[(size_t)y * level._stride];
+
+      for (int x = 0; x < level._width; ++x) {
+        int x0 = x * 2;
+        int x1 = std::min(x0 + 1, prev._width - 1);
+        out[x] = std::max(std::max(row0[x0], row0[x1]),
+                          std::max(row1[x0], row1[x1]));
+      }
+    }
+  }
+  _hierarchy_stale = false;
+}
+
+/**
+ * Returns the depth stored at the indicated pixel of the indicated level of
+ * the hierarchy, as a value between 0 (the near plane) and 1 (the far plane).
+ * This is mostly useful for debugging.
+ */
+PN_stdfloat OcclusionBuffer::
+get_depth(int x, int y, int level) const {
+  nassertr(level >= 0 && level < (int)_levels.size(), 1);
+  const Level &lvl = _levels[level];
+  nassertr(x >= 0 && x < lvl._width && y >= 0 && y < lvl._height, 1);
+  return lvl._depths[(size_t)y * lvl._stride + x];
+}
+
+/**
+ * Returns true if the indicated bounding volume is entirely hidden behind the
+ * occluders that have been added to the buffer.  The matrix transforms the
+ * volume into the coordinate space in which the occluders were given.
+ *
+ * A volume that is partly off-screen, or that crosses the near plane, is
+ * never considered occluded; it is assumed that the view frustum test will
+ * have dealt with those.
+ */
+bool OcclusionBuffer::
+is_occluded(const BoundingVolume *volume, const LMatrix4 &mat) const {
+  nassertr(!_hierarchy_stale, false);
+
+  if (volume->is_empty() || volume->is_infinite()) {
+    return false;
+  }
+  const FiniteBoundingVolume *fbv = volume->as_finite_bounding_volume();
+  if (fbv == nullptr) {
+    return false;
+  }
+
+  LPoint3 min_point = fbv->get_min();
+  LPoint3 max_point = fbv->get_max();
+  LMatrix4 clip_mat = mat * _clip_mat;
+
+  PN_stdfloat min_x = 1, min_y = 1, min_z = 1;
+  PN_stdfloat max_x = -1, max_y = -1;
+  for (int i = 0; i < 8; ++i) {
+    LPoint3 corner((i & 1) ? max_point[0] : min_point[0],
+                   (i & 2) ? max_point[1] : min_point[1],
+                   (i & 4) ? max_point[2] : min_point[2]);
+    LVecBase4 clip = clip_mat.xform(LVecBase4(corner, 1));
+    if (!(clip[3] > 0) || clip[2] < -clip[3]) {
+      // This corner is in front of the near plane.
+      return false;
+    }
+
+    PN_stdfloat x = clip[0] / clip[3];
+    PN_stdfloat y = clip[1] / clip[3];
+    PN_stdfloat z = clip[2] / clip[3];
+    min_x = std::min(min_x, x);
+    min_y = std::min(min_y, y);
+    min_z = std::min(min_z, z);
+    max_x = std::max(max_x, x);
+    max_y = std::max(max_y, y);
+  }
+
+  if (min_x < -1 || min_y < -1 || max_x > 1 || max_y > 1) {
+    return false;
+  }
+
+  // Find the range of pixels that the volume overlaps.
+  int px0 = std::max((int)floor((min_x * 0.5f + 0.5f) * _width), 0);
+  int py0 = std::max((int)floor((min_y * 0.5f + 0.5f) * _height), 0);
+  int px1 = std::min((int)floor((max_x * 0.5f + 0.5f) * _width), _width - 1);
+  int py1 = std::min((int)floor((max_y * 0.5f + 0.5f) * _height), _height - 1);
+  float depth = (float)(min_z * 0.5f + 0.5f);
+
+  // Choose the level at which the volume overlaps no more than 4x4 texels.
+  size_t li = 0;
+  while (li + 1 < _levels.size() &&
+         ((px1 >> li) - (px0 >> li) >= 4 || (py1 >> li) - (py0 >> li) >= 4)) {
+    ++li;
+  }
+
+  const Level &level = _levels[li];
+  for (int y = py0 >> li; y <= (py1 >> li); ++y) {
+    const float *row = &level._depths[(size_t)y * level._stride];
+    for (int x = px0 >> li; x <= (px1 >> li); ++x) {
+      if (row[x] >= depth) {
+        // The volume may be in front of the occluders here.
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/**
+ * Rasterizes a convex polygon of up to eight vertices, given in pixel
+ * coordinates, into the full-size buffer.  Only the pixels that are entirely
+ * covered by the polygon are written, and each receives the farthest depth of
+ * the polygon within that pixel.
+ *
+ * The polygon is drawn in one go rather than as a fan of triangles, since the
+ * pixels straddling the edges shared by the triangles would not be entirely
+ * covered by either of them, and would leave a crack in the occluder.
+ */
+void OcclusionBuffer::
+draw_polygon(const Vertex *verts, int num_verts) {
+  nassertv(num_verts >= 3 && num_verts <= 8);
+
+  // The setup is done in double precision, relative to the corner of the
+  // bounding rectangle, so that the edge functions stay accurate even when
+  // the vertices are far off-screen.
+  double xs[8], ys[8], zs[8];
+  double area = 0;
+  for (int i = 0; i < num_verts; ++i) {
+    xs[i] = verts[i]._x;
+    ys[i] = verts[i]._y;
+    zs[i] = verts[i]._z;
+  }
+  for (int i = 0; i < num_verts; ++i) {
+    int j = (i + 1) % num_verts;
+    area += xs[i] * ys[j] - xs[j] * ys[i];
+  }
+  if (!(area != 0)) {
+    return;
+  }
+  if (area < 0) {
+    std::reverse(xs, xs + num_verts);
+    std::reverse(ys, ys + num_verts);
+    std::reverse(zs, zs + num_verts);
+  }
+
+  double fmin_x = xs[0], fmin_y = ys[0], fmax_x = xs[0], fmax_y = ys[0];
+  double fmax_z = zs[0];
+  for (int i = 1; i < num_verts; ++i) {
+    fmin_x = std::min(fmin_x, xs[i]);
+    fmin_y = std::min(fmin_y, ys[i]);
+    fmax_x = std::max(fmax_x, xs[i]);
+    fmax_y = std::max(fmax_y, ys[i]);
+    fmax_z = std::max(fmax_z, zs[i]);
+  }
+  fmin_x = std::max(fmin_x, 0.0);
+  fmin_y = std::max(fmin_y, 0.0);
+  fmax_x = std::min(fmax_x, (double)_width);
+  fmax_y = std::min(fmax_y, (double)_height);
+  if (!(fmin_x < fmax_x && fmin_y < fmax_y)) {
+    return;
+  }
+  int min_x = (int)floor(fmin_x);
+  int min_y = (int)floor(fmin_y);
+  int max_x = std::min((int)ceil(fmax_x) - 1, _width - 1);
+  int max_y = std::min((int)ceil(fmax_y) - 1, _height - 1);
+
+  // Each edge function is positive inside the polygon.  It is evaluated at
+  // the pixel centers, relative to the center of the first pixel of the first
+  // row, and is offset by half a pixel so that it is only positive for pixels
+  // that are entirely inside the edge.
+  double ox = min_x + 0.5;
+  double oy = min_y + 0.5;
+  float ea[8], eb[8], ec[8];
+  for (int i = 0; i < num_verts; ++i) {
+    int j = (i + 1) % num_verts;
+    double a = ys[i] - ys[j];
+    double b = xs[j] - xs[i];
+    double c = a * (ox - xs[i]) + b * (oy - ys[i]);
+    ea[i] = (float)a;
+    eb[i] = (float)b;
+    ec[i] = (float)(c - 0.5 * (fabs(a) + fabs(b)));
+  }
+
+  // The polygon is planar, so the depth plane can be derived from any three
+  // of its vertices; we take the largest triangle of the fan for accuracy.
+  // It is offset towards the far plane by half a pixel, and clamped to the
+  // farthest vertex.
+  int best = 2;
+  double best_area = 0;
+  for (int i = 2; i < num_verts; ++i) {
+    double tri_area = (xs[i - 1] - xs[0]) * (ys[i] - ys[0]) -
+                      (xs[i] - xs[0]) * (ys[i - 1] - ys[0]);
+    if (fabs(tri_area) > fabs(best_area)) {
+      best = i;
+      best_area = tri_area;
+    }
+  }
+  if (!(best_area != 0)) {
+    return;
+  }
+  double x0 = xs[0], y0 = ys[0], z0 = zs[0];
+  double x1 = xs[best - 1], y1 = ys[best - 1], z1 = zs[best - 1];
+  double x2 = xs[best], y2 = ys[best], z2 = zs[best];
+  double dzdx = ((z1 - z0) * (y2 - y0) - (z2 - z0) * (y1 - y0)) / best_area;
+  double dzdy = ((z2 - z0) * (x1 - x0) - (z1 - z0) * (x2 - x0)) / best_area;
+  float za = (float)dzdx;
+  float zb = (float)dzdy;
+  float zc = (float)(z0 + dzdx * (ox - x0) + dzdy * (oy - y0) +
+                     0.5 * (fabs(dzdx) + fabs(dzdy)));
+  float zmax = (float)fmax_z;
+
+  Level &level = _levels[0];
+  int start_x = min_x & ~3;
+
+  for (int y = min_y; y <= max_y; ++y) {
+    float *row = &level._depths[(size_t)y * level._stride];
+    float fy = (float)(y - min_y);
+    float e[8];
+    for (int i = 0; i < num_verts; ++i) {
+      e[i] = ec[i] + eb[i] * fy;
+    }
+    float z = zc + zb * fy;
+
+    int x = start_x;
+#if defined(OCCLUSION_USE_SSE2)
+    const __m128 steps = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+    const __m128 zero = _mm_setzero_ps();
+    for (; x <= max_x; x += 4) {
+      __m128 fx = _mm_add_ps(_mm_set1_ps((float)(x - min_x)), steps);
+      __m128 mask = _mm_cmpge_ps(_mm_add_ps(_mm_set1_ps(e[0]), _mm_mul_ps(_mm_set1_ps(ea[0]), fx)), zero);
+      for (int i = 1; i < num_verts; ++i) {
+        __m128 in = _mm_cmpge_ps(_mm_add_ps(_mm_set1_ps(e[i]), _mm_mul_ps(_mm_set1_ps(ea[i]), fx)), zero);
+        mask = _mm_and_ps(mask, in);
+      }
+      if (_mm_movemask_ps(mask) == 0) {
+        continue;
+      }
+      __m128 depth = _mm_add_ps(_mm_set1_ps(z), _mm_mul_ps(_mm_set1_ps(za), fx));
+      depth = _mm_min_ps(depth, _mm_set1_ps(zmax));
+      __m128 old = _mm_loadu_ps(row + x);
+      __m128 result = _mm_min_ps(old, depth);
+      result = _mm_or_ps(_mm_and_ps(mask, result), _mm_andnot_ps(mask, old));
+      _mm_storeu_ps(row + x, result);
+    }
+#elif defined(OCCLUSION_USE_NEON)
+    static const float step_values[4] = {0.0f, 1.0f, 2.0f, 3.0f};
+    const float32x4_t steps = vld1q_f32(step_values);
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    for (; x <= max_x; x += 4) {
+      float32x4_t fx = vaddq_f32(vdupq_n_f32((float)(x - min_x)), steps);
+      uint32x4_t mask = vcgeq_f32(vaddq_f32(vdupq_n_f32(e[0]), vmulq_n_f32(fx, ea[0])), zero);
+      for (int i = 1; i < num_verts; ++i) {
+        uint32x4_t in = vcgeq_f32(vaddq_f32(vdupq_n_f32(e[i]), vmulq_n_f32(fx, ea[i])), zero);
+        mask = vandq_u32(mask, in);
+      }
+      float32x4_t depth = vaddq_f32(vdupq_n_f32(z), vmulq_n_f32(fx, za));
+      depth = vminq_f32(depth, vdupq_n_f32(zmax));
+      float32x4_t old = vld1q_f32(row + x);
+      vst1q_f32(row + x, vbslq_f32(mask, vminq_f32(old, depth), old));
+    }
+#endif
+
+    // Without SIMD support, we do one pixel at a time.
+    for (; x <= max_x; ++x) {
+      float fx = (float)(x - min_x);
+      bool inside = true;
+      for (int i = 0; i < num_verts && inside; ++i) {
+        inside = (e[i] + ea[i] * fx >= 0);
+      }
+      if (inside) {
+        float depth = std::min(z + za * fx, zmax);
+        row[x] = std::min(row[x], depth);
+      }
+    }
+  }
+}
@@ -0,0 +1,104 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file occlusionBuffer.h
+ * @author rdb
+ * @date 2026-10-17
+ */
+
+#ifndef OCCLUSIONBUFFER_H
+#define OCCLUSIONBUFFER_H
+
+#include "pandabase.h"
+#include "referenceCount.h"
+#include "nodePath.h"
+#include "boundingVolume.h"
+#include "luse.h"
+#include "pvector.h"
+#include "ordered_vector.h"
+
+/**
+ * A low-resolution depth buffer into which the OccluderNodes in the scene are
+ * rasterized on the CPU, along with a hierarchy of successively smaller
+ * versions of it, each of which stores the farthest depth of the four texels
+ * it covers in the level above.  The CullTraverser can test the bounding
+ * volume of each node against this hierarchy, and skip any node that is
+ * entirely hidden behind the occluders, without requiring any occlusion
+ * queries to be issued to the GPU.
+ *
+ * The buffer is conservative: a pixel only receives the depth of an occluder
+ * if it is entirely covered by it, and it receives the farthest depth of the
+ * occluder within that pixel.  This means that a node is never culled unless
+ * it is really hidden.
+ *
+ * To use it, call clear() with the view and projection matrices of the
+ * camera, then add the occluders, then call update_hierarchy() before testing
+ * any volumes.  Once the hierarchy is built, the buffer may be queried from
+ * several threads at once.
+ */
+class EXPCL_PANDA_PGRAPH OcclusionBuffer : public ReferenceCount {
+PUBLISHED:
+  explicit OcclusionBuffer(int width, int height);
+
+  INLINE int get_width() const;
+  INLINE int get_height() const;
+  MAKE_PROPERTY(width, get_width);
+  MAKE_PROPERTY(height, get_height);
+
+  void clear(const LMatrix4 &view_mat, const LMatrix4 &projection_mat);
+
+  bool add_occluder(const NodePath &occluder, const NodePath &root);
+  bool add_quad(const LPoint3 &v0, const LPoint3 &v1, const LPoint3 &v2,
+                const LPoint3 &v3, bool double_sided = false);
+  INLINE bool has_occluder(const NodePath &occluder) const;
+  INLINE size_t get_num_occluders() const;
+
+  void update_hierarchy();
+
+  INLINE int get_num_levels() const;
+  PN_stdfloat get_depth(int x, int y, int level = 0) const;
+
+  bool is_occluded(const BoundingVolume *volume,
+                   const LMatrix4 &mat = LMatrix4::ident_mat()) const;
+
+private:
+  typedef pvector<float> Depths;
+
+  class Vertex {
+  public:
+    PN_stdfloat _x, _y, _z;
+  };
+
+  void draw_polygon(const Vertex *verts, int num_verts);
+
+  int _width;
+  int _height;
+  int _stride;
+
+  class Level {
+  public:
+    int _width;
+    int _height;
+    int _stride;
+    Depths _depths;
+  };
+  typedef pvector<Level> Levels;
+  Levels _levels;
+  bool _hierarchy_stale;
+
+  LMatrix4 _view_mat;
+  LMatrix4 _projection_mat;
+  LMatrix4 _clip_mat;
+
+  typedef ov_set<NodePath> Occluders;
+  Occluders _occluders;
+};
+
+#include "occlusionBuffer.I"
+
+#endif
@@ -7,6 +7,7 @@
 #include "rescaleNormalAttrib.cxx"
 #include "sceneGraphReducer.cxx"
 #include "sceneSetup.cxx"
+#include "sceneSnapshot.cxx"
 #include "scissorAttrib.cxx"
 #include "scissorEffect.cxx"
 #include "shadeModelAttrib.cxx"
@@ -25,6 +25,7 @@
 #include "texGenAttrib.h"
 #include "shaderAttrib.h"
 #include "pStatTimer.h"
+#include "trueClock.h"
 #include "config_pgraph.h"
 #include "bamReader.h"
 #include "bamWriter.h"
@@ -35,10 +36,12 @@
 #include "lightMutexHolder.h"
 #include "thread.h"
 #include "renderAttribRegistry.h"
+#include "textureStreamingManager.h"
 
 using std::ostream;
 
 LightReMutex *RenderState::_states_lock = nullptr;
+patomic<unsigned int> RenderState::_cull_callback_epoch(0);
 RenderState::States RenderState::_states;
 const RenderState *RenderState::_empty_state = nullptr;
 UpdateSeq RenderState::_last_cycle_detect;
@@ -50,6 +53,8 @@ PStatCollector RenderState::_state_compose_pcollector("*:State Cache:Compose Sta
 PStatCollector RenderState::_state_invert_pcollector("*:State Cache:Invert State");
 PStatCollector RenderState::_node_counter("RenderStates:On nodes");
 PStatCollector RenderState::_cache_counter("RenderStates:Cached");
+PStatCollector RenderState::_gc_examined_pcollector("States examined:RenderStates");
+PStatCollector RenderState::_gc_freed_pcollector("States freed:RenderStates");
 PStatCollector RenderState::_state_break_cycles_pcollector("*:State Cache:Break Cycles");
 PStatCollector RenderState::_state_validate_pcollector("*:State Cache:Validate");
 
@@ -354,6 +359,30 @@ compose(const RenderState *other) const {
     return do_compose(other);
   }
 
+#if defined(HAVE_THREADS) && !defined(SIMPLE_THREADS)
+  // First check the cache kept by the current thread, which can be done
+  // without grabbing the lock.
+  LocalCompositionCache<RenderState> &local_cache = get_local_cache();
+  CPT(RenderState) local_result = local_cache.find(this, other, false);
+  if (local_result != nullptr) {
+    return local_result;
+  }
+
+  CPT(RenderState) result = locked_compose(other);
+  local_cache.store(this, other, false, result);
+  return result;
+#else
+  return locked_compose(other);
+#endif
+}
+
+/**
+ * The part of compose() that looks up the result in the composition cache
+ * stored on this object, computing and storing it if it is not already there.
+ * This grabs the _states_lock.
+ */
+CPT(RenderState) RenderState::
+locked_compose(const RenderState *other) const {
   LightReMutexHolder holder(*_states_lock);
 
   // Is this composition already cached?
@@ -443,6 +472,30 @@ invert_compose(const RenderState *other) const {
     return do_invert_compose(other);
   }
 
+#if defined(HAVE_THREADS) && !defined(SIMPLE_THREADS)
+  // First check the cache kept by the current thread, which can be done
+  // without grabbing the lock.
+  LocalCompositionCache<RenderState> &local_cache = get_local_cache();
+  CPT(RenderState) local_result = local_cache.find(this, other, true);
+  if (local_result != nullptr) {
+    return local_result;
+  }
+
+  CPT(RenderState) result = locked_invert_compose(other);
+  local_cache.store(this, other, true, result);
+  return result;
+#else
+  return locked_invert_compose(other);
+#endif
+}
+
+/**
+ * The part of invert_compose() that looks up the result in the inverse
+ * composition cache stored on this object, computing and storing it if it is
+ * not already there.  This grabs the _states_lock.
+ */
+CPT(RenderState) RenderState::
+locked_invert_compose(const RenderState *other) const {
   LightReMutexHolder holder(*_states_lock);
 
   // Is this composition already cached?
@@ -500,6 +553,18 @@ invert_compose(const RenderState *other) const {
   return result;
 }
 
+#if defined(HAVE_THREADS) && !defined(SIMPLE_THREADS)
+/**
+ * Returns the LocalCompositionCache belonging to the current thread.
+ */
+LocalCompositionCache<RenderState> &RenderState::
+get_local_cache() {
+  static thread_local LocalCompositionCache<RenderState>
+    local_cache((size_t)std::max(0, state_thread_cache_size.get_value()));
+  return local_cache;
+}
+#endif
+
 /**
  * Returns a new RenderState object that represents the same as the source
  * state, with the new RenderAttrib added.  If there is already a RenderAttrib
@@ -819,6 +884,11 @@ get_num_unused_states() {
  */
 int RenderState::
 clear_cache() {
+#if defined(HAVE_THREADS) && !defined(SIMPLE_THREADS)
+  // Release the states held in the local caches of all threads.
+  LocalCompositionCache<RenderState>::flush_all();
+#endif
+
   LightReMutexHolder holder(*_states_lock);
 
   PStatTimer timer(_cache_update_pcollector);
@@ -890,6 +960,13 @@ int RenderState::
 garbage_collect() {
   int num_attribs = RenderAttrib::garbage_collect();
 
+#if defined(HAVE_THREADS) && !defined(SIMPLE_THREADS)
+  // The local caches of the threads may hold the last references to some
+  // states, which would otherwise survive until those threads compose another
+  // state, or forever if they never do.
+  LocalCompositionCache<RenderState>::flush_all();
+#endif
+
   if (!garbage_collect_states) {
     return num_attribs;
   }
@@ -916,6 +993,17 @@ garbage_collect() {
   num_this_pass = std::min(num_this_pass, size);
   size_t stop_at_element = (si + num_this_pass) % size;
 
+  // If there is a time budget, we check the clock every so often and stop
+  // early when it runs out.  The next pass will resume where this one left
+  // off, so the whole table is still visited eventually.
+  TrueClock *clock = TrueClock::get_global_ptr();
+  double stop_time = 0.0;
+  if (garbage_collect_states_budget > 0) {
+    stop_time = clock->get_short_time() +
+      garbage_collect_states_budget * 0.000001;
+  }
+  size_t num_examined = 0;
+
   do {
     RenderState *state = (RenderState *)_states.get_key(si);
     if (break_and_uniquify) {
@@ -953,9 +1041,18 @@ garbage_collect() {
     }
 
     si = (si + 1) % size;
+    ++num_examined;
+
+    if (stop_time != 0.0 && (num_examined % 32) == 0 &&
+        clock->get_short_time() >= stop_time) {
+      break;
+    }
   } while (si != stop_at_element);
   _garbage_index = si;
 
+  _gc_examined_pcollector.set_level(num_examined);
+  _gc_freed_pcollector.set_level(orig_size - size);
+
   nassertr(_states.get_num_entries() == size, 0);
 
 #ifdef _DEBUG
@@ -1173,6 +1270,34 @@ bin_removed(int bin_index) {
   nassertv(false);
 }
 
+/**
+ * Called by the CullTraverser before each traversal.  If a texture has
+ * started streaming since the last call, this makes all the RenderStates in
+ * the world check again whether they have a cull callback, since a
+ * TextureAttrib that applies a streaming texture needs one to request its
+ * mipmap levels.
+ */
+void RenderState::
+check_cull_callbacks() {
+  unsigned int epoch = TextureStreamingManager::get_add_epoch();
+  if (_cull_callback_epoch.load(std::memory_order_relaxed) == epoch) {
+    return;
+  }
+
+  LightReMutexHolder holder(*_states_lock);
+  if (_cull_callback_epoch.exchange(epoch) == epoch) {
+    // Another thread got here first.
+    return;
+  }
+
+  size_t size = _states.get_num_entries();
+  for (size_t si = 0; si < size; ++si) {
+    RenderState *state = (RenderState *)_states.get_key(si);
+    LightMutexHolder state_holder(state->_lock);
+    state->_flags &= ~(F_checked_cull_callback | F_has_cull_callback);
+  }
+}
+
 /**
  * Returns true if the _filled_slots bitmask is consistent with the table of
  * RenderAttrib pointers, false otherwise.
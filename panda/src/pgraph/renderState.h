@@ -27,6 +27,8 @@
 #include "geomMunger.h"
 #include "weakPointerTo.h"
 #include "lightReMutex.h"
+#include "localCompositionCache.h"
+#include "patomic.h"
 #include "lightMutex.h"
 #include "deletedChain.h"
 #include "simpleHashMap.h"
@@ -160,6 +162,7 @@ PUBLISHED:
 
 public:
   static void bin_removed(int bin_index);
+  static void check_cull_callbacks();
 
   INLINE static void flush_level();
 
@@ -203,6 +206,9 @@ private:
   static CPT(RenderState) return_unique(RenderState *state);
   CPT(RenderState) do_compose(const RenderState *other) const;
   CPT(RenderState) do_invert_compose(const RenderState *other) const;
+  CPT(RenderState) locked_compose(const RenderState *other) const;
+  CPT(RenderState) locked_invert_compose(const RenderState *other) const;
+  static LocalCompositionCache<RenderState> &get_local_cache();
   void detect_and_break_cycles();
   static bool r_detect_cycles(const RenderState *start_state,
                               const RenderState *current_state,
@@ -241,6 +247,11 @@ private:
   // cache, which is encoded in _composition_cache and
   // _invert_composition_cache.
   static LightReMutex *_states_lock;
+
+  // The TextureStreamingManager's add epoch when the states were last told to
+  // check again for a cull callback.
+  static patomic<unsigned int> _cull_callback_epoch;
+
   typedef SimpleHashMap<const RenderState *, std::nullptr_t, indirect_compare_to_hash<const RenderState *> > States;
   static States _states;
   static const RenderState *_empty_state;
@@ -301,6 +312,8 @@ private:
 
   static PStatCollector _node_counter;
   static PStatCollector _cache_counter;
+  static PStatCollector _gc_examined_pcollector;
+  static PStatCollector _gc_freed_pcollector;
 
 private:
   // This is the actual data within the RenderState: a set of max_slots
@@ -22,6 +22,8 @@
 #include "geomNode.h"
 #include "config_gobj.h"
 #include "thread.h"
+#include "vector_int.h"
+#include "vector_uchar.h"
 
 PStatCollector SceneGraphReducer::_flatten_collector("*:Flatten:flatten");
 PStatCollector SceneGraphReducer::_apply_collector("*:Flatten:apply");
@@ -31,6 +33,8 @@ PStatCollector SceneGraphReducer::_collect_collector("*:Flatten:collect");
 PStatCollector SceneGraphReducer::_make_nonindexed_collector("*:Flatten:make nonindexed");
 PStatCollector SceneGraphReducer::_unify_collector("*:Flatten:unify");
 PStatCollector SceneGraphReducer::_remove_unused_collector("*:Flatten:remove unused vertices");
+PStatCollector SceneGraphReducer::_optimize_vertex_cache_collector("*:Flatten:optimize vertex cache");
+PStatCollector SceneGraphReducer::_make_clusters_collector("*:Flatten:make clusters");
 PStatCollector SceneGraphReducer::_premunge_collector("*:Premunge");
 
 /**
@@ -92,15 +96,23 @@ flatten(PandaNode *root, int combine_siblings_bits) {
   do {
     num_pass_nodes = 0;
 
-    // Get a copy of the children list, so we don't have to worry about self-
-    // modifications.
-    PandaNode::Children cr = root->get_children();
+    if (get_num_threads() > 0 && root->get_num_children() >= 2 &&
+        !root->is_under_scene_root() && r_is_tree(root)) {
+      // The children don't share any nodes, so we can flatten them on
+      // separate threads.
+      num_pass_nodes += flatten_children_parallel(root, combine_siblings_bits);
 
-    // Now visit each of the children in turn.
-    int num_children = cr.get_num_children();
-    for (int i = 0; i < num_children; i++) {
-      PT(PandaNode) child_node = cr.get_child(i);
-      num_pass_nodes += r_flatten(root, child_node, combine_siblings_bits);
+    } else {
+      // Get a copy of the children list, so we don't have to worry about
+      // self-modifications.
+      PandaNode::Children cr = root->get_children();
+
+      // Now visit each of the children in turn.
+      int num_children = cr.get_num_children();
+      for (int i = 0; i < num_children; i++) {
+        PT(PandaNode) child_node = cr.get_child(i);
+        num_pass_nodes += r_flatten(root, child_node, combine_siblings_bits);
+      }
     }
 
     if (combine_siblings_bits != 0 &&
@@ -183,7 +195,30 @@ unify(PandaNode *root, bool preserve_order) {
   if (_gsg != nullptr) {
     max_indices = std::min(max_indices, _gsg->get_max_vertices_per_primitive());
   }
-  r_unify(root, max_indices, preserve_order);
+
+  if (get_num_threads() > 0) {
+    // Each GeomNode can be unified independently.  However, marking the
+    // bounding volumes stale touches the ancestors, which may be shared, so
+    // that is left to this thread.
+    pvector<GeomNode *> geom_nodes;
+    pset<GeomNode *> visited;
+    r_collect_geom_nodes(root, geom_nodes, visited);
+
+    size_t num_geom_nodes = geom_nodes.size();
+    vector_uchar changed(num_geom_nodes, 0);
+    _transformer.parallel_for(num_geom_nodes, [&] (size_t i) {
+      changed[i] = geom_nodes[i]->do_unify(max_indices, preserve_order,
+                                          Thread::get_current_thread());
+    });
+
+    for (size_t i = 0; i < num_geom_nodes; ++i) {
+      if (changed[i]) {
+        geom_nodes[i]->mark_internal_bounds_stale();
+      }
+    }
+  } else {
+    r_unify(root, max_indices, preserve_order);
+  }
 }
 
 /**
@@ -202,6 +237,120 @@ remove_unused_vertices(PandaNode *root) {
   Thread::consider_yield();
 }
 
+/**
+ * Reorders the triangles of all of the Geoms at this level and below for
+ * better use of the post-transform vertex cache of the GPU, and to reduce
+ * overdraw, and then rearranges the rows of each GeomVertexData in the order
+ * in which they are used.  See Geom::optimize_vertex_cache_in_place().  This
+ * is best done after flattening, once the Geoms have been combined.
+ *
+ * The average cache miss ratio (ACMR) of the triangles before and after the
+ * operation is reported at the info level.  Returns the number of GeomNodes
+ * whose Geoms were changed.
+ */
+int SceneGraphReducer::
+optimize_vertex_cache(PandaNode *root) {
+  nassertr(check_live_flatten(root), 0);
+  PStatTimer timer(_optimize_vertex_cache_collector);
+
+  pvector<GeomNode *> geom_nodes;
+  pset<GeomNode *> visited;
+  r_collect_geom_nodes(root, geom_nodes, visited);
+
+  // Each GeomNode's triangles can be reordered independently.  The ACMR of
+  // each Geom is weighted by its number of vertices.
+  size_t num_geom_nodes = geom_nodes.size();
+  vector_uchar changed(num_geom_nodes, 0);
+  pvector<double> acmr_before(num_geom_nodes, 0.0);
+  pvector<double> acmr_after(num_geom_nodes, 0.0);
+  pvector<double> weight(num_geom_nodes, 0.0);
+  _transformer.parallel_for(num_geom_nodes, [&] (size_t i) {
+    GeomNode *node = geom_nodes[i];
+    Thread *current_thread = Thread::get_current_thread();
+    int num_geoms = node->get_num_geoms();
+    for (int gi = 0; gi < num_geoms; ++gi) {
+      CPT(Geom) geom = node->get_geom(gi);
+      double num_vertices = geom->get_nested_vertices(current_thread);
+      acmr_before[i] += geom->calc_acmr() * num_vertices;
+      weight[i] += num_vertices;
+    }
+
+    changed[i] = _transformer.optimize_vertex_cache(node);
+
+    for (int gi = 0; gi < num_geoms; ++gi) {
+      CPT(Geom) geom = node->get_geom(gi);
+      acmr_after[i] += geom->calc_acmr() * geom->get_nested_vertices(current_thread);
+    }
+  });
+
+  // The vertex data may be shared between nodes, so that part is done for
+  // all of them at once.
+  int num_changed = 0;
+  double total_before = 0.0;
+  double total_after = 0.0;
+  double total_weight = 0.0;
+  for (size_t i = 0; i < num_geom_nodes; ++i) {
+    _transformer.register_vertices(geom_nodes[i], false);
+    if (changed[i]) {
+      ++num_changed;
+    }
+    total_before += acmr_before[i];
+    total_after += acmr_after[i];
+    total_weight += weight[i];
+  }
+  _transformer.reorder_vertices();
+
+  if (pgraph_cat.is_info() && total_weight > 0.0) {
+    pgraph_cat.info()
+      << "Optimized " << num_changed << " of " << num_geom_nodes
+      << " GeomNodes for a vertex cache of size " << vertex_cache_size
+      << "; ACMR went from " << total_before / total_weight << " to "
+      << total_after / total_weight << "\n";
+  }
+
+  Thread::consider_yield();
+  return num_changed;
+}
+
+/**
+ * Partitions the triangles of all of the Geoms at this level and below into
+ * clusters of at most max_triangles triangles (or geom-cluster-size, if this
+ * is 0), each of which is culled individually against the view frustum and
+ * the camera direction.  See Geom::make_clusters_in_place().  This should be
+ * done after flattening, since modifying the Geoms discards the clusters.
+ *
+ * Returns the number of Geoms that were partitioned.
+ */
+int SceneGraphReducer::
+make_clusters(PandaNode *root, int max_triangles) {
+  nassertr(check_live_flatten(root), 0);
+  PStatTimer timer(_make_clusters_collector);
+
+  pvector<GeomNode *> geom_nodes;
+  pset<GeomNode *> visited;
+  r_collect_geom_nodes(root, geom_nodes, visited);
+
+  size_t num_geom_nodes = geom_nodes.size();
+  pvector<int> num_clustered(num_geom_nodes, 0);
+  _transformer.parallel_for(num_geom_nodes, [&] (size_t i) {
+    num_clustered[i] = _transformer.make_clusters(geom_nodes[i], max_triangles);
+  });
+
+  int total_clustered = 0;
+  for (int count : num_clustered) {
+    total_clustered += count;
+  }
+
+  if (pgraph_cat.is_info()) {
+    pgraph_cat.info()
+      << "Partitioned " << total_clustered << " Geoms in " << num_geom_nodes
+      << " GeomNodes into clusters\n";
+  }
+
+  Thread::consider_yield();
+  return total_clustered;
+}
+
 /**
  * In a non-release build, returns false if the node is correctly not in a
  * live scene graph.  (Calling flatten on a node that is part of a live scene
@@ -381,105 +530,135 @@ r_flatten(PandaNode *grandparent_node, PandaNode *parent_node,
       << ")\n";
   }
 
+  int num_nodes = 0;
+
+  if (begin_flatten(parent_node, combine_siblings_bits)) {
+    // First, recurse on each of the children.
+    {
+      PandaNode::Children cr = parent_node->get_children();
+      int num_children = cr.get_num_children();
+      for (int i = 0; i < num_children; i++) {
+        PT(PandaNode) child_node = cr.get_child(i);
+        num_nodes += r_flatten(parent_node, child_node, combine_siblings_bits);
+      }
+    }
+
+    num_nodes += finish_flatten(grandparent_node, parent_node,
+                                combine_siblings_bits);
+  }
+
+  return num_nodes;
+}
+
+/**
+ * The first part of r_flatten(), which is performed before the children of
+ * the parent node are flattened.  Adjusts combine_siblings_bits as
+ * appropriate for the children of the node, and returns true if the node
+ * allows flattening below it, or false if it doesn't.
+ */
+bool SceneGraphReducer::
+begin_flatten(PandaNode *parent_node, int &combine_siblings_bits) {
   if ((combine_siblings_bits & (CS_geom_node | CS_other | CS_recurse)) != 0) {
     // Unset CS_within_radius, since we're going to flatten everything anyway.
     // This avoids needlessly calculating the bounding volume.
     combine_siblings_bits &= ~CS_within_radius;
   }
 
-  int num_nodes = 0;
-
   if (!parent_node->safe_to_flatten_below()) {
     if (pgraph_cat.is_spam()) {
       pgraph_cat.spam()
         << "Not traversing further; " << *parent_node
         << " doesn't allow flattening below itself.\n";
     }
+    return false;
+  }
 
-  } else {
-    if ((combine_siblings_bits & CS_within_radius) != 0) {
-      CPT(BoundingVolume) bv = parent_node->get_bounds();
-      if (bv->is_of_type(BoundingSphere::get_class_type())) {
-        const BoundingSphere *bs = DCAST(BoundingSphere, bv);
+  if ((combine_siblings_bits & CS_within_radius) != 0) {
+    CPT(BoundingVolume) bv = parent_node->get_bounds();
+    if (bv->is_of_type(BoundingSphere::get_class_type())) {
+      const BoundingSphere *bs = DCAST(BoundingSphere, bv);
+      if (pgraph_cat.is_spam()) {
+        pgraph_cat.spam()
+          << "considering radius of " << *parent_node
+          << ": " << *bs << " vs. " << _combine_radius << "\n";
+      }
+      if (!bs->is_infinite() && (bs->is_empty() || bs->get_radius() <= _combine_radius)) {
+        // This node fits within the specified radius; from here on down, we
+        // will have CS_other set, instead of CS_within_radius.
         if (pgraph_cat.is_spam()) {
           pgraph_cat.spam()
-            << "considering radius of " << *parent_node
-            << ": " << *bs << " vs. " << _combine_radius << "\n";
-        }
-        if (!bs->is_infinite() && (bs->is_empty() || bs->get_radius() <= _combine_radius)) {
-          // This node fits within the specified radius; from here on down, we
-          // will have CS_other set, instead of CS_within_radius.
-          if (pgraph_cat.is_spam()) {
-            pgraph_cat.spam()
-              << "node fits within radius; flattening tighter.\n";
-          }
-          combine_siblings_bits &= ~CS_within_radius;
-          combine_siblings_bits |= (CS_geom_node | CS_other | CS_recurse);
+            << "node fits within radius; flattening tighter.\n";
         }
+        combine_siblings_bits &= ~CS_within_radius;
+        combine_siblings_bits |= (CS_geom_node | CS_other | CS_recurse);
       }
     }
+  }
 
-    // First, recurse on each of the children.
-    {
-      PandaNode::Children cr = parent_node->get_children();
-      int num_children = cr.get_num_children();
-      for (int i = 0; i < num_children; i++) {
-        PT(PandaNode) child_node = cr.get_child(i);
-        num_nodes += r_flatten(parent_node, child_node, combine_siblings_bits);
-      }
-    }
+  return true;
+}
 
-    // Now that the above loop has removed some children, the child list saved
-    // above is no longer accurate, so hereafter we must ask the node for its
-    // real child list.
+/**
+ * The last part of r_flatten(), which is performed after the children of the
+ * parent node have been flattened.  Combines the children of the parent node
+ * where possible, and possibly collapses the parent node with its remaining
+ * child.  Returns the number of nodes removed.
+ */
+int SceneGraphReducer::
+finish_flatten(PandaNode *grandparent_node, PandaNode *parent_node,
+               int combine_siblings_bits) {
+  int num_nodes = 0;
 
-    // If we have CS_recurse set, then we flatten siblings before trying to
-    // flatten children.  Otherwise, we flatten children first, and then
-    // flatten siblings, which avoids overly enthusiastic flattening.
-    if ((combine_siblings_bits & CS_recurse) != 0 &&
-        parent_node->get_num_children() >= 2 &&
-        parent_node->safe_to_combine_children()) {
-      num_nodes += flatten_siblings(parent_node, combine_siblings_bits);
-    }
+  // The child list saved by the caller is no longer accurate, since the
+  // children may have been flattened, so hereafter we must ask the node for
+  // its real child list.
+
+  // If we have CS_recurse set, then we flatten siblings before trying to
+  // flatten children.  Otherwise, we flatten children first, and then
+  // flatten siblings, which avoids overly enthusiastic flattening.
+  if ((combine_siblings_bits & CS_recurse) != 0 &&
+      parent_node->get_num_children() >= 2 &&
+      parent_node->safe_to_combine_children()) {
+    num_nodes += flatten_siblings(parent_node, combine_siblings_bits);
+  }
 
-    if (parent_node->get_num_children() == 1) {
-      // If we now have exactly one child, consider flattening the node out.
-      PT(PandaNode) child_node = parent_node->get_child(0);
-      int child_sort = parent_node->get_child_sort(0);
+  if (parent_node->get_num_children() == 1) {
+    // If we now have exactly one child, consider flattening the node out.
+    PT(PandaNode) child_node = parent_node->get_child(0);
+    int child_sort = parent_node->get_child_sort(0);
 
-      if (consider_child(grandparent_node, parent_node, child_node)) {
-        // Ok, do it.
-        parent_node->remove_child(child_node);
+    if (consider_child(grandparent_node, parent_node, child_node)) {
+      // Ok, do it.
+      parent_node->remove_child(child_node);
 
-        if (do_flatten_child(grandparent_node, parent_node, child_node)) {
-          // Done!
-          num_nodes++;
-        } else {
-          // Chicken out.
-          parent_node->add_child(child_node, child_sort);
-        }
+      if (do_flatten_child(grandparent_node, parent_node, child_node)) {
+        // Done!
+        num_nodes++;
+      } else {
+        // Chicken out.
+        parent_node->add_child(child_node, child_sort);
       }
     }
+  }
 
-    if ((combine_siblings_bits & CS_recurse) == 0 &&
-        (combine_siblings_bits & ~CS_recurse) != 0 &&
-        parent_node->get_num_children() >= 2 &&
-        parent_node->safe_to_combine_children()) {
-      num_nodes += flatten_siblings(parent_node, combine_siblings_bits);
-    }
-
-    // Finally, if any of our remaining children are plain PandaNodes with no
-    // children, just remove them.
-    if (parent_node->safe_to_combine_children()) {
-      for (int i = parent_node->get_num_children() - 1; i >= 0; --i) {
-        PandaNode *child_node = parent_node->get_child(i);
-        if (child_node->is_exact_type(PandaNode::get_class_type()) &&
-            child_node->get_num_children() == 0 &&
-            child_node->get_transform()->is_identity() &&
-            child_node->get_effects()->is_empty()) {
-          parent_node->remove_child(child_node);
-          ++num_nodes;
-        }
+  if ((combine_siblings_bits & CS_recurse) == 0 &&
+      (combine_siblings_bits & ~CS_recurse) != 0 &&
+      parent_node->get_num_children() >= 2 &&
+      parent_node->safe_to_combine_children()) {
+    num_nodes += flatten_siblings(parent_node, combine_siblings_bits);
+  }
+
+  // Finally, if any of our remaining children are plain PandaNodes with no
+  // children, just remove them.
+  if (parent_node->safe_to_combine_children()) {
+    for (int i = parent_node->get_num_children() - 1; i >= 0; --i) {
+      PandaNode *child_node = parent_node->get_child(i);
+      if (child_node->is_exact_type(PandaNode::get_class_type()) &&
+          child_node->get_num_children() == 0 &&
+          child_node->get_transform()->is_identity() &&
+          child_node->get_effects()->is_empty()) {
+        parent_node->remove_child(child_node);
+        ++num_nodes;
       }
     }
   }
@@ -487,6 +666,57 @@ r_flatten(PandaNode *grandparent_node, PandaNode *parent_node,
   return num_nodes;
 }
 
+/**
+ * Flattens the subgraphs below each of the children of the indicated root
+ * node on separate threads, and then finishes flattening each child on this
+ * thread, in order.  This gives the same result as calling r_flatten() on
+ * each child in turn, as long as none of the nodes below the root are
+ * instanced; see r_is_tree().  Returns the number of nodes removed.
+ */
+int SceneGraphReducer::
+flatten_children_parallel(PandaNode *root, int combine_siblings_bits) {
+  PandaNode::Children cr = root->get_children();
+  size_t num_children = cr.get_num_children();
+
+  // Temporarily detach the children from the root.  Otherwise, each change
+  // made by the different threads would have to be propagated up to the
+  // root, which is not safe to do from several threads at once.
+  for (size_t i = num_children; i > 0; --i) {
+    root->remove_child((int)(i - 1));
+  }
+
+  vector_int bits(num_children, combine_siblings_bits);
+  vector_int num_nodes(num_children, 0);
+  vector_uchar flatten_below(num_children, 0);
+
+  _transformer.parallel_for(num_children, [&] (size_t i) {
+    PandaNode *child_node = cr.get_child(i);
+    if (begin_flatten(child_node, bits[i])) {
+      flatten_below[i] = 1;
+
+      PandaNode::Children gcr = child_node->get_children();
+      int num_grandchildren = gcr.get_num_children();
+      for (int j = 0; j < num_grandchildren; ++j) {
+        PT(PandaNode) grandchild_node = gcr.get_child(j);
+        num_nodes[i] += r_flatten(child_node, grandchild_node, bits[i]);
+      }
+    }
+  });
+
+  for (size_t i = 0; i < num_children; ++i) {
+    root->add_child(cr.get_child(i), cr.get_child_sort(i));
+  }
+
+  int total_nodes = 0;
+  for (size_t i = 0; i < num_children; ++i) {
+    total_nodes += num_nodes[i];
+    if (flatten_below[i]) {
+      total_nodes += finish_flatten(root, cr.get_child(i), bits[i]);
+    }
+  }
+  return total_nodes;
+}
+
 class SortByState {
 public:
   INLINE bool
@@ -913,6 +1143,54 @@ r_unify(PandaNode *node, int max_indices, bool preserve_order) {
   Thread::consider_yield();
 }
 
+/**
+ * Appends each of the GeomNodes at the indicated node and below to the
+ * indicated list, once each, in the order in which they are encountered.
+ */
+void SceneGraphReducer::
+r_collect_geom_nodes(PandaNode *node, pvector<GeomNode *> &geom_nodes,
+                     pset<GeomNode *> &visited) {
+  if (node->is_geom_node()) {
+    GeomNode *geom_node = DCAST(GeomNode, node);
+    if (visited.insert(geom_node).second) {
+      geom_nodes.push_back(geom_node);
+    }
+  }
+
+  PandaNode::Children children = node->get_children();
+  int num_children = children.get_num_children();
+  for (int i = 0; i < num_children; ++i) {
+    r_collect_geom_nodes(children.get_child(i), geom_nodes, visited);
+  }
+}
+
+/**
+ * Returns true if none of the nodes below the indicated node, including
+ * stashed nodes, has more than one parent.  This means that the subgraphs
+ * below the different children of the node are entirely independent.
+ */
+bool SceneGraphReducer::
+r_is_tree(PandaNode *node) {
+  PandaNode::Children children = node->get_children();
+  int num_children = children.get_num_children();
+  for (int i = 0; i < num_children; ++i) {
+    PandaNode *child = children.get_child(i);
+    if (child->get_num_parents() != 1 || !r_is_tree(child)) {
+      return false;
+    }
+  }
+
+  PandaNode::Stashed stashed = node->get_stashed();
+  int num_stashed = stashed.get_num_stashed();
+  for (int i = 0; i < num_stashed; ++i) {
+    PandaNode *child = stashed.get_stashed(i);
+    if (child->get_num_parents() != 1 || !r_is_tree(child)) {
+      return false;
+    }
+  }
+  return true;
+}
+
 /**
  * Recursively calls GeomTransformer::register_vertices() on all GeomNodes at
  * the indicated root and below.
@@ -25,8 +25,11 @@
 #include "typedObject.h"
 #include "pointerTo.h"
 #include "graphicsStateGuardianBase.h"
+#include "pvector.h"
+#include "pset.h"
 
 class PandaNode;
+class GeomNode;
 
 /**
  * An interface for simplifying ("flattening") scene graphs by eliminating
@@ -120,6 +123,9 @@ PUBLISHED:
   INLINE void set_combine_radius(PN_stdfloat combine_radius);
   INLINE PN_stdfloat get_combine_radius() const;
 
+  INLINE void set_num_threads(int num_threads);
+  INLINE int get_num_threads() const;
+
   INLINE void apply_attribs(PandaNode *node, int attrib_types = ~(TT_clip_plane | TT_cull_face | TT_apply_texture_color));
   INLINE void apply_attribs(PandaNode *node, const AccumulatedAttribs &attribs,
                             int attrib_types, GeomTransformer &transformer);
@@ -137,6 +143,8 @@ PUBLISHED:
   INLINE int make_nonindexed(PandaNode *root, int nonindexed_bits = ~0);
   void unify(PandaNode *root, bool preserve_order);
   void remove_unused_vertices(PandaNode *root);
+  int optimize_vertex_cache(PandaNode *root);
+  int make_clusters(PandaNode *root, int max_triangles = 0);
 
   INLINE void premunge(PandaNode *root, const RenderState *initial_state);
   bool check_live_flatten(PandaNode *node);
@@ -147,6 +155,10 @@ protected:
 
   int r_flatten(PandaNode *grandparent_node, PandaNode *parent_node,
                 int combine_siblings_bits);
+  bool begin_flatten(PandaNode *parent_node, int &combine_siblings_bits);
+  int finish_flatten(PandaNode *grandparent_node, PandaNode *parent_node,
+                     int combine_siblings_bits);
+  int flatten_children_parallel(PandaNode *root, int combine_siblings_bits);
   int flatten_siblings(PandaNode *parent_node,
                        int combine_siblings_bits);
 
@@ -175,6 +187,9 @@ protected:
                             GeomTransformer &transformer, bool format_only);
   int r_make_nonindexed(PandaNode *node, int collect_bits);
   void r_unify(PandaNode *node, int max_indices, bool preserve_order);
+  void r_collect_geom_nodes(PandaNode *node, pvector<GeomNode *> &geom_nodes,
+                            pset<GeomNode *> &visited);
+  static bool r_is_tree(PandaNode *node);
   void r_register_vertices(PandaNode *node, GeomTransformer &transformer);
   void r_decompose(PandaNode *node);
 
@@ -193,6 +208,8 @@ private:
   static PStatCollector _make_nonindexed_collector;
   static PStatCollector _unify_collector;
   static PStatCollector _remove_unused_collector;
+  static PStatCollector _optimize_vertex_cache_collector;
+  static PStatCollector _make_clusters_collector;
   static PStatCollector _premunge_collector;
 };
 
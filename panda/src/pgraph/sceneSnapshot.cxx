@@ -0,0 +1,327 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file sceneSnapshot.cxx
+ * @author rdb
+ * @date 2026-10-17
+ */
+
+#include "sceneSnapshot.h"
+#include "clipPlaneAttrib.h"
+#include "fogAttrib.h"
+#include "lightReMutexHolder.h"
+#include "pStatTimer.h"
+
+PStatCollector SceneSnapshot::_update_pcollector("Cull:Snapshot");
+
+static const size_t no_record = (size_t)-1;
+
+/**
+ * Creates a snapshot of the hierarchy under the indicated root.  The snapshot
+ * is empty until update() is first called.
+ */
+SceneSnapshot::
+SceneSnapshot(const NodePath &root) :
+  _root(root),
+  _all_dirty(true),
+  _any_dirty(false),
+  _num_rebuilt(0)
+{
+}
+
+/**
+ * Brings the snapshot up-to-date with the current state of the scene graph,
+ * as seen from the indicated thread.  Only the subtrees that have changed
+ * since the last update are rebuilt.
+ */
+void SceneSnapshot::
+update(Thread *current_thread) {
+  LightReMutexHolder holder(_lock);
+  PStatTimer timer(_update_pcollector, current_thread);
+
+  _num_rebuilt = 0;
+  if (_root.is_empty()) {
+    _records.clear();
+    _paths.clear();
+    return;
+  }
+
+  PandaNode *root_node = _root.node();
+  size_t old_index = _records.empty() ? no_record : 0;
+
+  if (!_all_dirty && !_any_dirty && old_index != no_record &&
+      _records[0]._node == root_node) {
+    // If nothing has changed under the root, we don't need to do anything.
+    UpdateSeq seq;
+    root_node->get_bounds(seq, current_thread);
+    if (seq == _records[0]._bounds_seq) {
+      return;
+    }
+  }
+
+  if (_all_dirty) {
+    old_index = no_record;
+  }
+
+  Records records;
+  pvector<NodePath> paths;
+  records.reserve(_records.size());
+  paths.reserve(_paths.size());
+
+  r_update(records, paths, root_node, _root, -1, old_index, false,
+           current_thread);
+
+  _records.swap(records);
+  _paths.swap(paths);
+  _all_dirty = false;
+  _any_dirty = false;
+}
+
+/**
+ * Indicates that the entire snapshot should be rebuilt on the next update.
+ */
+void SceneSnapshot::
+mark_dirty() {
+  LightReMutexHolder holder(_lock);
+  _all_dirty = true;
+}
+
+/**
+ * Indicates that the records for the indicated node and the nodes below it
+ * should be rebuilt on the next update, even if their bounding volumes have
+ * not changed.
+ */
+void SceneSnapshot::
+mark_dirty(const NodePath &subtree) {
+  LightReMutexHolder holder(_lock);
+  nassertv(!subtree.is_empty());
+
+  PandaNode *node = subtree.node();
+  for (Record &record : _records) {
+    if (record._node == node) {
+      record._flags |= RF_dirty;
+      _any_dirty = true;
+    }
+  }
+}
+
+/**
+ * The recursive implementation of update().  Appends the records for the
+ * indicated node and the nodes below it.  If old_index is not no_record, it
+ * indicates the record of the same node in the previous snapshot, which may
+ * be reused.
+ */
+void SceneSnapshot::
+r_update(Records &records, pvector<NodePath> &paths, PandaNode *node,
+         const NodePath &path, int parent, size_t old_index,
+         bool parent_changed, Thread *current_thread) {
+  UpdateSeq seq;
+  CPT(BoundingVolume) bounds = node->get_bounds(seq, current_thread);
+
+  if (old_index != no_record && _records[old_index]._node != node) {
+    old_index = no_record;
+  }
+
+  if (old_index != no_record && !parent_changed &&
+      _records[old_index]._bounds_seq == seq &&
+      !(_any_dirty && is_subtree_dirty(old_index))) {
+    // Nothing has changed in this subtree.
+    move_subtree(records, paths, old_index, parent);
+    return;
+  }
+
+  ++_num_rebuilt;
+  PandaNodePipelineReader reader(node, current_thread);
+
+  const TransformState *parent_transform;
+  const RenderState *parent_state;
+  if (parent >= 0) {
+    parent_transform = records[parent]._net_transform;
+    parent_state = records[parent]._net_state;
+  } else {
+    parent_transform = TransformState::make_identity();
+    parent_state = RenderState::make_empty();
+  }
+
+  Record record;
+  record._node = node;
+  record._net_transform = parent_transform->compose(reader.get_transform());
+  record._net_state = parent_state->compose(reader.get_state());
+  record._bounds_seq = seq;
+  record._parent = parent;
+  record._skip = 0;
+  record._flags = 0;
+
+  // The node's bounding volume is in the coordinate space of its parent.
+  const GeometricBoundingVolume *gbv = bounds->as_geometric_bounding_volume();
+  nassertv(gbv != nullptr);
+  if (parent_transform->is_identity()) {
+    record._bounds = gbv;
+  } else {
+    PT(GeometricBoundingVolume) xformed = gbv->make_copy()->as_geometric_bounding_volume();
+    xformed->xform(parent_transform->get_mat());
+    record._bounds = std::move(xformed);
+  }
+
+  if (node->is_geom_node()) {
+    record._flags |= RF_geom_node;
+    record._geoms = ((GeomNode *)node)->get_geoms(current_thread);
+  }
+  if (is_opaque_node(node, reader)) {
+    record._flags |= RF_opaque;
+  }
+  if (reader.get_fancy_bits() & PandaNode::FB_tag) {
+    record._flags |= RF_tagged;
+  }
+  if (reader.is_final()) {
+    record._flags |= RF_final;
+  }
+
+  // If the net transform and state haven't changed, we may still be able to
+  // reuse the records of some of the children, unless this node was marked
+  // dirty.
+  bool changed = true;
+  if (old_index != no_record) {
+    const Record &old_record = _records[old_index];
+    changed = (old_record._net_transform != record._net_transform ||
+               old_record._net_state != record._net_state ||
+               (old_record._flags & (RF_opaque | RF_dirty)) != 0);
+  }
+
+  size_t index = records.size();
+  bool opaque = (record._flags & RF_opaque) != 0;
+  records.push_back(std::move(record));
+  paths.push_back(path);
+
+  if (!opaque) {
+    PandaNode::Children children = reader.get_children();
+    reader.release();
+
+    size_t old_end = 0;
+    size_t old_cursor = 0;
+    if (old_index != no_record) {
+      old_end = _records[old_index]._skip;
+      old_cursor = old_index + 1;
+    }
+
+    int num_children = children.get_num_children();
+    for (int i = 0; i < num_children; ++i) {
+      PandaNode *child = children.get_child(i);
+
+      // Find the record of this child in the previous snapshot.  Usually,
+      // the children are in the same order as before.
+      size_t old_child = no_record;
+      if (old_cursor < old_end && _records[old_cursor]._node == child) {
+        old_child = old_cursor;
+      } else if (old_index != no_record) {
+        for (size_t oi = old_index + 1; oi < old_end; oi = _records[oi]._skip) {
+          if (_records[oi]._node == child) {
+            old_child = oi;
+            break;
+          }
+        }
+      }
+
+      if (old_child != no_record) {
+        old_cursor = _records[old_child]._skip;
+        NodePath child_path = _paths[old_child];
+        r_update(records, paths, child, child_path, (int)index, old_child,
+                 changed, current_thread);
+      } else {
+        r_update(records, paths, child, NodePath(path, child, current_thread),
+                 (int)index, no_record, changed, current_thread);
+      }
+    }
+  }
+
+  records[index]._skip = records.size();
+}
+
+/**
+ * Moves the records of an unchanged subtree from the previous snapshot to the
+ * end of the new one, adjusting the indices they contain.
+ */
+void SceneSnapshot::
+move_subtree(Records &records, pvector<NodePath> &paths, size_t old_index,
+             int parent) {
+  size_t old_end = _records[old_index]._skip;
+  size_t new_index = records.size();
+
+  for (size_t oi = old_index; oi < old_end; ++oi) {
+    // Note that we leave the node pointer and the skip index behind, since
+    // those may still be needed to find the records of other nodes.
+    Record &old_record = _records[oi];
+    Record record;
+    record._node = old_record._node;
+    record._net_transform = std::move(old_record._net_transform);
+    record._net_state = std::move(old_record._net_state);
+    record._bounds = std::move(old_record._bounds);
+    record._geoms = std::move(old_record._geoms);
+    record._bounds_seq = old_record._bounds_seq;
+    record._skip = old_record._skip - old_index + new_index;
+    record._flags = old_record._flags & ~RF_dirty;
+    if (oi == old_index) {
+      record._parent = parent;
+    } else {
+      record._parent = (int)(old_record._parent - old_index + new_index);
+    }
+    records.push_back(std::move(record));
+    paths.push_back(std::move(_paths[oi]));
+  }
+}
+
+/**
+ * Returns true if mark_dirty() was called on any of the nodes in the subtree
+ * of the indicated record of the previous snapshot.
+ */
+bool SceneSnapshot::
+is_subtree_dirty(size_t old_index) const {
+  size_t old_end = _records[old_index]._skip;
+  for (size_t oi = old_index; oi < old_end; ++oi) {
+    if (_records[oi]._flags & RF_dirty) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Returns true if the indicated node does anything during the cull traversal
+ * that the snapshot can't represent, meaning that it must be traversed the
+ * usual way.
+ */
+bool SceneSnapshot::
+is_opaque_node(PandaNode *node, const PandaNodePipelineReader &reader) {
+  static const int opaque_bits =
+    PandaNode::FB_effects | PandaNode::FB_draw_mask |
+    PandaNode::FB_cull_callback | PandaNode::FB_decal |
+    PandaNode::FB_show_bounds | PandaNode::FB_show_tight_bounds;
+
+  int fancy_bits = reader.get_fancy_bits();
+  if (fancy_bits & opaque_bits) {
+    return true;
+  }
+  if ((fancy_bits & PandaNode::FB_renderable) != 0 && !node->is_geom_node()) {
+    // We only know how to render GeomNodes.
+    return true;
+  }
+
+  const TransformState *transform = reader.get_transform();
+  if (transform->is_invalid() ||
+      (!transform->is_identity() && transform->get_inverse_mat() == nullptr)) {
+    return true;
+  }
+
+  // These attributes require special treatment by the CullTraverser.
+  const RenderState *state = reader.get_state();
+  if (state->has_attrib(ClipPlaneAttrib::get_class_slot()) ||
+      state->has_attrib(FogAttrib::get_class_slot())) {
+    return true;
+  }
+  return false;
+}
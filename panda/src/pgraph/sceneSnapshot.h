@@ -0,0 +1,142 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file sceneSnapshot.h
+ * @author rdb
+ * @date 2026-10-17
+ */
+
+#ifndef SCENESNAPSHOT_H
+#define SCENESNAPSHOT_H
+
+#include "pandabase.h"
+#include "referenceCount.h"
+#include "nodePath.h"
+#include "geomNode.h"
+#include "transformState.h"
+#include "renderState.h"
+#include "geometricBoundingVolume.h"
+#include "updateSeq.h"
+#include "lightReMutex.h"
+#include "pStatCollector.h"
+#include "pvector.h"
+
+/**
+ * A flattened, read-only copy of a scene graph hierarchy, stored as one
+ * contiguous array of records in depth-first order.  Each record holds the
+ * net transform and state of its node relative to the root, and its bounding
+ * volume in the coordinate space of the root, as well as the index of the
+ * first record past its subtree, so that an entire subtree can be skipped by
+ * jumping ahead in the array.
+ *
+ * A traversal over the snapshot therefore needs neither to follow pointers
+ * from node to node nor to lock any nodes, and it doesn't need to compose any
+ * transforms or states on the way down.  This makes it much cheaper to cull a
+ * large, mostly static hierarchy every frame; see
+ * CullTraverser::set_scene_snapshot().
+ *
+ * Nodes that do anything special during the cull traversal, such as nodes
+ * with a cull callback, effects, a draw mask or a clip plane, are recorded
+ * without their children, and are flagged so that the traverser can traverse
+ * them the usual way.
+ *
+ * update() brings the snapshot up-to-date with the scene graph.  It uses the
+ * bounding volume sequence numbers of the nodes to find the subtrees that have
+ * changed since the last update, and only rebuilds the records of those; the
+ * records of the unchanged subtrees are carried over as they are.  Changes
+ * that don't affect the bounding volumes, such as changes in tags, are not
+ * noticed automatically; call mark_dirty() after making such a change.
+ */
+class EXPCL_PANDA_PGRAPH SceneSnapshot : public ReferenceCount {
+PUBLISHED:
+  explicit SceneSnapshot(const NodePath &root);
+
+  INLINE const NodePath &get_root() const;
+
+  void update(Thread *current_thread = Thread::get_current_thread());
+  void mark_dirty();
+  void mark_dirty(const NodePath &subtree);
+
+  INLINE size_t get_num_records() const;
+  INLINE PandaNode *get_node(size_t n) const;
+  INLINE const NodePath &get_node_path(size_t n) const;
+  INLINE const TransformState *get_net_transform(size_t n) const;
+  INLINE const RenderState *get_net_state(size_t n) const;
+  INLINE const GeometricBoundingVolume *get_bounds(size_t n) const;
+  INLINE int get_parent(size_t n) const;
+  INLINE size_t get_skip(size_t n) const;
+  INLINE bool is_opaque(size_t n) const;
+  INLINE size_t get_num_rebuilt() const;
+
+  MAKE_PROPERTY(root, get_root);
+  MAKE_PROPERTY(num_rebuilt, get_num_rebuilt);
+
+public:
+  enum RecordFlags {
+    // The node must be traversed the usual way; its children are not
+    // recorded.
+    RF_opaque       = 0x01,
+
+    // The node is a GeomNode whose Geoms are stored in the record.
+    RF_geom_node    = 0x02,
+
+    // The node has tags, which may be of interest to a camera with a tag
+    // state key.
+    RF_tagged       = 0x04,
+
+    // The node is flagged final, so its children need not be tested against
+    // the view frustum.
+    RF_final        = 0x08,
+
+    // mark_dirty() was called on this node.
+    RF_dirty        = 0x10,
+  };
+
+  class Record {
+  public:
+    PandaNode *_node;
+    CPT(TransformState) _net_transform;
+    CPT(RenderState) _net_state;
+    CPT(GeometricBoundingVolume) _bounds;
+    GeomNode::Geoms _geoms;
+    UpdateSeq _bounds_seq;
+    int _parent;
+    size_t _skip;
+    int _flags;
+  };
+  typedef pvector<Record> Records;
+
+  INLINE const Record &get_record(size_t n) const;
+  INLINE LightReMutex &get_lock();
+
+private:
+  void r_update(Records &records, pvector<NodePath> &paths,
+                PandaNode *node, const NodePath &path, int parent,
+                size_t old_index, bool parent_changed,
+                Thread *current_thread);
+  void move_subtree(Records &records, pvector<NodePath> &paths,
+                    size_t old_index, int parent);
+  bool is_subtree_dirty(size_t old_index) const;
+  static bool is_opaque_node(PandaNode *node,
+                             const PandaNodePipelineReader &reader);
+
+  NodePath _root;
+  Records _records;
+  pvector<NodePath> _paths;
+  bool _all_dirty;
+  bool _any_dirty;
+  size_t _num_rebuilt;
+
+  LightReMutex _lock;
+
+  static PStatCollector _update_pcollector;
+};
+
+#include "sceneSnapshot.I"
+
+#endif
@@ -20,6 +20,12 @@
 #include "datagramIterator.h"
 #include "dcast.h"
 #include "textureStagePool.h"
+#include "textureStreamingManager.h"
+#include "cullTraverser.h"
+#include "cullTraverserData.h"
+#include "sceneSetup.h"
+#include "lens.h"
+#include "finiteBoundingVolume.h"
 
 CPT(RenderAttrib) TextureAttrib::_empty_attrib;
 CPT(RenderAttrib) TextureAttrib::_all_off_attrib;
@@ -441,7 +447,7 @@ has_cull_callback() const {
   Stages::const_iterator si;
   for (si = _on_stages.begin(); si != _on_stages.end(); ++si) {
     Texture *texture = (*si)._texture;
-    if (texture->has_cull_callback()) {
+    if (texture->has_cull_callback() || texture->is_streaming()) {
       return true;
     }
   }
@@ -460,9 +466,19 @@ has_cull_callback() const {
  */
 bool TextureAttrib::
 cull_callback(CullTraverser *trav, const CullTraverserData &data) const {
+  PN_stdfloat screen_size = -1;
+
   Stages::const_iterator si;
   for (si = _on_stages.begin(); si != _on_stages.end(); ++si) {
     Texture *texture = (*si)._texture;
+    if (texture->is_streaming()) {
+      // Ask for the mipmap level that matches the size of the object on the
+      // screen.
+      if (screen_size < 0) {
+        screen_size = get_screen_size(trav, data);
+      }
+      TextureStreamingManager::get_global_ptr()->request_screen_size(texture, screen_size);
+    }
     if (!texture->cull_callback(trav, data)) {
       return false;
     }
@@ -471,6 +487,58 @@ cull_callback(CullTraverser *trav, const CullTraverserData &data) const {
   return true;
 }
 
+/**
+ * Estimates how many pixels across the node being traversed covers on the
+ * screen, from the bounding volume of the node.  Returns 0 if this can't be
+ * determined.
+ */
+PN_stdfloat TextureAttrib::
+get_screen_size(CullTraverser *trav, const CullTraverserData &data) {
+  const SceneSetup *scene = trav->get_scene();
+  const Lens *lens = scene->get_lens();
+  if (lens == nullptr) {
+    return 0;
+  }
+
+  CPT(BoundingVolume) bounds = data.node_reader()->get_bounds();
+  const FiniteBoundingVolume *fbv = bounds->as_finite_bounding_volume();
+  if (fbv == nullptr || fbv->is_empty()) {
+    return 0;
+  }
+
+  LPoint3 min_point = fbv->get_min();
+  LPoint3 max_point = fbv->get_max();
+  PN_stdfloat radius = (max_point - min_point).length() * 0.5f;
+
+  // Bring the bounding sphere into the space of the lens.
+  CPT(TransformState) modelview = data.get_modelview_transform(trav);
+  const LMatrix4 &mat = modelview->get_mat();
+  LPoint3 center = mat.xform_point((min_point + max_point) * 0.5f);
+  PN_stdfloat scale = std::max(mat.get_row3(0).length(),
+                               std::max(mat.get_row3(1).length(),
+                                        mat.get_row3(2).length()));
+  radius *= scale;
+
+  PN_stdfloat height = (PN_stdfloat)scene->get_viewport_height();
+
+  // Project the center, and a point one radius above it.  If either is
+  // behind the lens, the object is so close that we assume that it fills the
+  // screen.
+  const LMatrix4 &proj_mat = lens->get_projection_mat();
+  LVector3 up = LVector3::up(lens->get_coordinate_system());
+  LVecBase4 center_4d = LVecBase4(center, 1) * proj_mat;
+  LVecBase4 top_4d = LVecBase4(center + up * radius, 1) * proj_mat;
+  if (center_4d[3] <= 0 || top_4d[3] <= 0) {
+    return height;
+  }
+
+  // The film spans from -1 to 1, so the distance between the two points is
+  // half the diameter as a fraction of the full height of the film.
+  LPoint2 center_2d(center_4d[0] / center_4d[3], center_4d[1] / center_4d[3]);
+  LPoint2 top_2d(top_4d[0] / top_4d[3], top_4d[1] / top_4d[3]);
+  return (top_2d - center_2d).length() * height;
+}
+
 /**
  * Intended to be overridden by derived TextureAttrib types to return a unique
  * number indicating whether this TextureAttrib is equivalent to the other
@@ -115,6 +115,9 @@ private:
   INLINE void check_sorted() const;
   void sort_on_stages();
 
+  static PN_stdfloat get_screen_size(CullTraverser *trav,
+                                     const CullTraverserData &data);
+
 private:
   class StageNode {
   public:
@@ -19,6 +19,7 @@
 #include "indent.h"
 #include "compareTo.h"
 #include "pStatTimer.h"
+#include "trueClock.h"
 #include "config_pgraph.h"
 #include "lightReMutexHolder.h"
 #include "lightMutexHolder.h"
@@ -45,6 +46,8 @@ PStatCollector TransformState::_transform_validate_pcollector("*:State Cache:Val
 PStatCollector TransformState::_transform_hash_pcollector("*:State Cache:Calc Hash");
 PStatCollector TransformState::_node_counter("TransformStates:On nodes");
 PStatCollector TransformState::_cache_counter("TransformStates:Cached");
+PStatCollector TransformState::_gc_examined_pcollector("States examined:TransformStates");
+PStatCollector TransformState::_gc_freed_pcollector("States freed:TransformStates");
 
 CacheStats TransformState::_cache_stats;
 
@@ -569,6 +572,30 @@ compose(const TransformState *other) const {
     return do_compose(other);
   }
 
+#if defined(HAVE_THREADS) && !defined(SIMPLE_THREADS)
+  // First check the cache kept by the current thread, which can be done
+  // without grabbing the lock.
+  LocalCompositionCache<TransformState> &local_cache = get_local_cache();
+  CPT(TransformState) local_result = local_cache.find(this, other, false);
+  if (local_result != nullptr) {
+    return local_result;
+  }
+
+  CPT(TransformState) result = locked_compose(other);
+  local_cache.store(this, other, false, result);
+  return result;
+#else
+  return locked_compose(other);
+#endif
+}
+
+/**
+ * The part of compose() that looks up the result in the composition cache
+ * stored on this object, computing and storing it if it is not already there.
+ * This grabs the _states_lock.
+ */
+CPT(TransformState) TransformState::
+locked_compose(const TransformState *other) const {
   LightReMutexHolder holder(*_states_lock);
 
   // Is this composition already cached?
@@ -676,6 +703,30 @@ invert_compose(const TransformState *other) const {
     return do_invert_compose(other);
   }
 
+#if defined(HAVE_THREADS) && !defined(SIMPLE_THREADS)
+  // First check the cache kept by the current thread, which can be done
+  // without grabbing the lock.
+  LocalCompositionCache<TransformState> &local_cache = get_local_cache();
+  CPT(TransformState) local_result = local_cache.find(this, other, true);
+  if (local_result != nullptr) {
+    return local_result;
+  }
+
+  CPT(TransformState) result = locked_invert_compose(other);
+  local_cache.store(this, other, true, result);
+  return result;
+#else
+  return locked_invert_compose(other);
+#endif
+}
+
+/**
+ * The part of invert_compose() that looks up the result in the inverse
+ * composition cache stored on this object, computing and storing it if it is
+ * not already there.  This grabs the _states_lock.
+ */
+CPT(TransformState) TransformState::
+locked_invert_compose(const TransformState *other) const {
   LightReMutexHolder holder(*_states_lock);
 
   int index = _invert_composition_cache.find(other);
@@ -743,6 +794,18 @@ invert_compose(const TransformState *other) const {
   return result;
 }
 
+#if defined(HAVE_THREADS) && !defined(SIMPLE_THREADS)
+/**
+ * Returns the LocalCompositionCache belonging to the current thread.
+ */
+LocalCompositionCache<TransformState> &TransformState::
+get_local_cache() {
+  static thread_local LocalCompositionCache<TransformState>
+    local_cache((size_t)std::max(0, state_thread_cache_size.get_value()));
+  return local_cache;
+}
+#endif
+
 /**
  * This method overrides ReferenceCount::unref() to check whether the
  * remaining reference count is entirely in the cache, and if so, it checks
@@ -1064,6 +1127,11 @@ get_num_unused_states() {
  */
 int TransformState::
 clear_cache() {
+#if defined(HAVE_THREADS) && !defined(SIMPLE_THREADS)
+  // Release the states held in the local caches of all threads.
+  LocalCompositionCache<TransformState>::flush_all();
+#endif
+
   LightReMutexHolder holder(*_states_lock);
 
   PStatTimer timer(_cache_update_pcollector);
@@ -1131,6 +1199,13 @@ clear_cache() {
  */
 int TransformState::
 garbage_collect() {
+#if defined(HAVE_THREADS) && !defined(SIMPLE_THREADS)
+  // The local caches of the threads may hold the last references to some
+  // states, which would otherwise survive until those threads compose another
+  // state, or forever if they never do.
+  LocalCompositionCache<TransformState>::flush_all();
+#endif
+
   if (!garbage_collect_states) {
     return 0;
   }
@@ -1157,6 +1232,17 @@ garbage_collect() {
   num_this_pass = std::min(num_this_pass, size);
   size_t stop_at_element = (si + num_this_pass) % size;
 
+  // If there is a time budget, we check the clock every so often and stop
+  // early when it runs out.  The next pass will resume where this one left
+  // off, so the whole table is still visited eventually.
+  TrueClock *clock = TrueClock::get_global_ptr();
+  double stop_time = 0.0;
+  if (garbage_collect_states_budget > 0) {
+    stop_time = clock->get_short_time() +
+      garbage_collect_states_budget * 0.000001;
+  }
+  size_t num_examined = 0;
+
   do {
     TransformState *state = (TransformState *)_states.get_key(si);
     if (break_and_uniquify) {
@@ -1193,9 +1279,18 @@ garbage_collect() {
     }
 
     si = (si + 1) % size;
+    ++num_examined;
+
+    if (stop_time != 0.0 && (num_examined % 32) == 0 &&
+        clock->get_short_time() >= stop_time) {
+      break;
+    }
   } while (si != stop_at_element);
   _garbage_index = si;
 
+  _gc_examined_pcollector.set_level(num_examined);
+  _gc_freed_pcollector.set_level(orig_size - size);
+
   nassertr(_states.get_num_entries() == size, 0);
 
 #ifdef _DEBUG
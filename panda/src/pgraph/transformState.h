@@ -24,6 +24,8 @@
 #include "pStatCollector.h"
 #include "geomEnums.h"
 #include "lightReMutex.h"
+#include "localCompositionCache.h"
+#include "patomic.h"
 #include "lightReMutexHolder.h"
 #include "lightMutex.h"
 #include "lightMutexHolder.h"
@@ -254,6 +256,9 @@ private:
 
   CPT(TransformState) do_compose(const TransformState *other) const;
   CPT(TransformState) do_invert_compose(const TransformState *other) const;
+  CPT(TransformState) locked_compose(const TransformState *other) const;
+  CPT(TransformState) locked_invert_compose(const TransformState *other) const;
+  static LocalCompositionCache<TransformState> &get_local_cache();
   void detect_and_break_cycles();
   static bool r_detect_cycles(const TransformState *start_state,
                               const TransformState *current_state,
@@ -272,6 +277,7 @@ private:
   // cache, which is encoded in _composition_cache and
   // _invert_composition_cache.
   static LightReMutex *_states_lock;
+
   typedef SimpleHashMap<const TransformState *, std::nullptr_t, indirect_equals_hash<const TransformState *> > States;
   static States _states;
   static CPT(TransformState) _identity_state;
@@ -325,6 +331,8 @@ private:
 
   static PStatCollector _node_counter;
   static PStatCollector _cache_counter;
+  static PStatCollector _gc_examined_pcollector;
+  static PStatCollector _gc_freed_pcollector;
 
 private:
   // This is the actual data within the TransformState.
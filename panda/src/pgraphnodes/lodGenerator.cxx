@@ -0,0 +1,175 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file lodGenerator.cxx
+ * @author rdb
+ * @date 2026-10-17
+ */
+
+#include "lodGenerator.h"
+#include "fadeLodNode.h"
+#include "geomNode.h"
+#include "config_pgraphnodes.h"
+
+#include <limits>
+#include <math.h>
+
+/**
+ *
+ */
+LODGenerator::
+LODGenerator() :
+  _far_distance(std::numeric_limits<PN_stdfloat>::max()),
+  _fade(false)
+{
+}
+
+/**
+ * Adds a level of detail that is shown from the indicated distance, which
+ * must be greater than that of the previous level.  Each Geom is simplified
+ * to the indicated fraction of its triangles, or until the surface would
+ * deviate from the original by more than max_error, whichever comes first.
+ * Pass a fraction of 0 to simplify only up to max_error, or a negative
+ * max_error to simplify only up to the fraction.
+ */
+void LODGenerator::
+add_level(PN_stdfloat distance, PN_stdfloat fraction, PN_stdfloat max_error) {
+  nassertv(_levels.empty() || distance > _levels.back()._distance);
+  Level level;
+  level._distance = distance;
+  level._fraction = std::max(fraction, (PN_stdfloat)0);
+  level._num_triangles = -1;
+  level._max_error = max_error;
+  level._result_num_triangles = 0;
+  level._result_error = 0;
+  _levels.push_back(level);
+}
+
+/**
+ * Adds a level of detail that is shown from the indicated distance, with at
+ * most the indicated number of triangles in total.  This is distributed over
+ * the Geoms in proportion to their number of triangles.  See add_level().
+ */
+void LODGenerator::
+add_level_triangles(PN_stdfloat distance, int num_triangles,
+                    PN_stdfloat max_error) {
+  add_level(distance, 0, max_error);
+  _levels.back()._num_triangles = std::max(num_triangles, 0);
+}
+
+/**
+ * Returns a new LODNode with the indicated model as its first child, and a
+ * simplified copy of it for each level that has been added.
+ */
+PT(LODNode) LODGenerator::
+generate(PandaNode *model) {
+  Thread *current_thread = Thread::get_current_thread();
+
+  PT(LODNode) lod;
+  if (_fade) {
+    lod = new FadeLODNode(model->get_name());
+  } else {
+    lod = new LODNode(model->get_name());
+  }
+
+  int total_triangles = count_triangles(model, current_thread);
+
+  for (size_t li = 0; li <= _levels.size(); ++li) {
+    PN_stdfloat out = (li == 0) ? 0 : _levels[li - 1]._distance;
+    PN_stdfloat in = (li < _levels.size()) ? _levels[li]._distance : _far_distance;
+    lod->add_switch(in, out);
+
+    if (li == 0) {
+      lod->add_child(model, 0, current_thread);
+      continue;
+    }
+
+    Level &level = _levels[li - 1];
+    PN_stdfloat fraction = level._fraction;
+    if (level._num_triangles >= 0) {
+      fraction = (total_triangles > 0) ? (PN_stdfloat)level._num_triangles / (PN_stdfloat)total_triangles : 0;
+    }
+
+    PT(PandaNode) copy = model->copy_subgraph(current_thread);
+    SimplifiedGeoms geoms;
+    level._result_error = 0;
+    r_simplify(copy, fraction, level._max_error, geoms, level._result_error,
+               current_thread);
+    level._result_num_triangles = count_triangles(copy, current_thread);
+
+    if (pgraphnodes_cat.is_debug()) {
+      pgraphnodes_cat.debug()
+        << "Generated level " << li << " of " << *model << " with "
+        << level._result_num_triangles << " of " << total_triangles
+        << " triangles, with an error of " << level._result_error << "\n";
+    }
+
+    lod->add_child(copy, 0, current_thread);
+  }
+
+  return lod;
+}
+
+/**
+ * Returns the number of triangles drawn by the GeomNodes at or below the
+ * indicated node, counting each instance separately.
+ */
+int LODGenerator::
+count_triangles(PandaNode *node, Thread *current_thread) {
+  int num_triangles = 0;
+  if (node->is_geom_node()) {
+    GeomNode *gnode = (GeomNode *)node;
+    int num_geoms = gnode->get_num_geoms();
+    for (int i = 0; i < num_geoms; ++i) {
+      num_triangles += gnode->get_geom(i)->get_num_triangles();
+    }
+  }
+
+  PandaNode::Children children = node->get_children(current_thread);
+  size_t num_children = children.get_num_children();
+  for (size_t i = 0; i < num_children; ++i) {
+    num_triangles += count_triangles(children.get_child(i), current_thread);
+  }
+  return num_triangles;
+}
+
+/**
+ * Replaces the Geoms at or below the indicated node with simplified versions.
+ * Geoms that occur more than once are simplified only once.
+ */
+void LODGenerator::
+r_simplify(PandaNode *node, PN_stdfloat fraction, PN_stdfloat max_error,
+           SimplifiedGeoms &geoms, PN_stdfloat &result_error,
+           Thread *current_thread) {
+  if (node->is_geom_node()) {
+    GeomNode *gnode = (GeomNode *)node;
+    int num_geoms = gnode->get_num_geoms();
+    for (int i = 0; i < num_geoms; ++i) {
+      CPT(Geom) geom = gnode->get_geom(i);
+      SimplifiedGeoms::iterator gi = geoms.find(geom);
+      if (gi == geoms.end()) {
+        int num_triangles = geom->get_num_triangles();
+        PT(Geom) new_geom = geom->make_copy();
+        if (num_triangles > 0 && (fraction < 1 || max_error >= 0)) {
+          int target = (int)ceil(num_triangles * std::min(fraction, (PN_stdfloat)1));
+          PN_stdfloat error = new_geom->simplify_in_place(target, max_error);
+          result_error = std::max(result_error, error);
+        }
+        gi = geoms.insert(SimplifiedGeoms::value_type(geom, new_geom)).first;
+      }
+      gnode->set_geom(i, (*gi).second);
+    }
+  }
+
+  PandaNode::Children children = node->get_children(current_thread);
+  size_t num_children = children.get_num_children();
+  for (size_t i = 0; i < num_children; ++i) {
+    r_simplify(children.get_child(i), fraction, max_error, geoms,
+               result_error, current_thread);
+  }
+}
@@ -0,0 +1,87 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file lodGenerator.h
+ * @author rdb
+ * @date 2026-10-17
+ */
+
+#ifndef LODGENERATOR_H
+#define LODGENERATOR_H
+
+#include "pandabase.h"
+#include "lodNode.h"
+#include "geom.h"
+#include "pmap.h"
+#include "pvector.h"
+
+/**
+ * Builds an LODNode (or FadeLODNode) from a single high-detail model, by
+ * adding progressively simplified copies of it as the lower levels of detail.
+ * The copies share the vertex data of the original model.  See
+ * Geom::simplify().
+ *
+ * The original model is shown from the camera up to the distance of the
+ * first level that has been added, each level is shown from its distance up
+ * to the distance of the next level, and the last level from its distance up
+ * to the far distance.
+ */
+class EXPCL_PANDA_PGRAPHNODES LODGenerator {
+PUBLISHED:
+  LODGenerator();
+
+  void add_level(PN_stdfloat distance, PN_stdfloat fraction,
+                 PN_stdfloat max_error = -1);
+  void add_level_triangles(PN_stdfloat distance, int num_triangles,
+                           PN_stdfloat max_error = -1);
+  INLINE void clear_levels();
+
+  INLINE size_t get_num_levels() const;
+  INLINE PN_stdfloat get_level_distance(size_t n) const;
+  INLINE int get_level_num_triangles(size_t n) const;
+  INLINE PN_stdfloat get_level_error(size_t n) const;
+
+  INLINE void set_far_distance(PN_stdfloat far_distance);
+  INLINE PN_stdfloat get_far_distance() const;
+  MAKE_PROPERTY(far_distance, get_far_distance, set_far_distance);
+
+  INLINE void set_fade(bool fade);
+  INLINE bool get_fade() const;
+  MAKE_PROPERTY(fade, get_fade, set_fade);
+
+  PT(LODNode) generate(PandaNode *model);
+
+private:
+  typedef pmap<const Geom *, PT(Geom) > SimplifiedGeoms;
+
+  static int count_triangles(PandaNode *node, Thread *current_thread);
+  void r_simplify(PandaNode *node, PN_stdfloat fraction, PN_stdfloat max_error,
+                  SimplifiedGeoms &geoms, PN_stdfloat &result_error,
+                  Thread *current_thread);
+
+  class Level {
+  public:
+    PN_stdfloat _distance;
+    PN_stdfloat _fraction;
+    int _num_triangles;
+    PN_stdfloat _max_error;
+
+    // These are filled in by generate().
+    int _result_num_triangles;
+    PN_stdfloat _result_error;
+  };
+  typedef pvector<Level> Levels;
+  Levels _levels;
+
+  PN_stdfloat _far_distance;
+  bool _fade;
+};
+
+#include "lodGenerator.I"
+
+#endif
@@ -7,5 +7,6 @@
 #include "fadeLodNodeData.cxx"
 #include "lightLensNode.cxx"
 #include "lightNode.cxx"
+#include "lodGenerator.cxx"
 #include "lodNode.cxx"
 #include "lodNodeType.cxx"
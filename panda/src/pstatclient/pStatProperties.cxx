@@ -106,6 +106,7 @@ static TimeCollectorProperties time_properties[] = {
   { 1, "Wait:Flip",                        { 1.0, 0.6, 0.3 } },
   { 1, "Wait:Flip:Begin",                  { 0.3, 0.3, 0.9 } },
   { 1, "Wait:Flip:End",                    { 0.9, 0.3, 0.6 } },
+  { 1, "Wait:Vertex data",                 { 0.7, 0.2, 0.2 } },
   { 1, "App",                              { 0.0, 0.4, 0.8 },  1.0 / 30.0 },
   { 1, "App:Collisions",                   { 1.0, 0.5, 0.0 } },
   { 1, "App:Collisions:Reset",             { 0.0, 0.0, 0.5 } },
@@ -114,6 +115,8 @@ static TimeCollectorProperties time_properties[] = {
   { 1, "Cull",                             { 0.21, 0.68, 0.37 },  1.0 / 30.0 },
   { 1, "Cull:Setup",                       { 0.7, 0.4, 0.5 } },
   { 1, "Cull:Sort",                        { 0.3, 0.3, 0.6 } },
+  { 1, "Cull:Occlusion buffer",            { 0.5, 0.5, 0.2 } },
+  { 1, "Cull:Snapshot",                    { 0.2, 0.6, 0.6 } },
   { 1, "*",                                { 0.1, 0.1, 0.5 } },
   { 1, "*:Show fps",                       { 0.5, 0.8, 1.0 } },
   { 1, "*:Munge",                          { 0.3, 0.3, 0.9 } },
@@ -157,6 +160,10 @@ static LevelCollectorProperties level_properties[] = {
   { 1, "Geom cache operations:record",     { 0.2, 0.4, 0.8 } },
   { 1, "Geom cache operations:erase",      { 0.4, 0.8, 0.2 } },
   { 1, "Geom cache operations:evict",      { 0.8, 0.2, 0.4 } },
+  { 1, "Vertex pages",                     { 0.4, 0.6, 0.9 },  "", 100 },
+  { 1, "Vertex pages:In",                  { 0.9, 0.3, 0.3 } },
+  { 1, "Vertex pages:Out",                 { 0.3, 0.3, 0.9 } },
+  { 1, "Vertex pages:Prefetched",          { 0.3, 0.9, 0.3 } },
   { 1, "Data transferred",                 { 0.0, 0.2, 0.4 },  "MB", 12, 1048576 },
   { 1, "Primitive batches",                { 0.2, 0.5, 0.9 },  "", 500 },
   { 1, "Primitive batches:Other",          { 0.2, 0.2, 0.2 } },
@@ -164,6 +171,8 @@ static LevelCollectorProperties level_properties[] = {
   { 1, "Primitive batches:Triangle fans",  { 0.8, 0.5, 0.2 } },
   { 1, "Primitive batches:Triangle strips",{ 0.2, 0.5, 0.8 } },
   { 1, "Primitive batches:Display lists",  { 0.8, 0.5, 1.0 } },
+  { 1, "Instance batches",                 { 0.9, 0.6, 0.2 },  "", 500 },
+  { 1, "Instanced objects",                { 0.6, 0.9, 0.2 },  "", 500 },
   { 1, "SW Sprites",                       { 0.2, 0.7, 0.3 },  "K", 10, 1000 },
   { 1, "Vertices",                         { 0.5, 0.2, 0.0 },  "K", 10, 1000 },
   { 1, "Vertices:Other",                   { 0.2, 0.2, 0.2 } },
@@ -176,6 +185,7 @@ static LevelCollectorProperties level_properties[] = {
   { 1, "Pixels",                           { 0.8, 0.3, 0.7 },  "M", 5, 1000000 },
   { 1, "Nodes",                            { 0.4, 0.2, 0.8 },  "", 500.0 },
   { 1, "Nodes:GeomNodes",                  { 0.8, 0.2, 0.0 } },
+  { 1, "Nodes:Occluded",                   { 0.2, 0.6, 0.6 } },
   { 1, "Geoms",                            { 0.4, 0.8, 0.3 },  "", 500.0 },
   { 1, "Cull volumes",                     { 0.7, 0.6, 0.9 },  "", 500.0 },
   { 1, "Cull volumes:Transforms",          { 0.9, 0.6, 0.0 } },
@@ -202,6 +212,10 @@ static LevelCollectorProperties level_properties[] = {
   { 1, "Vertex Data:Disk",                 { 0.6, 0.9, 0.1 } },
   { 1, "Vertex Data:Disk:Unused",          { 0.8, 0.4, 0.5 } },
   { 1, "Vertex Data:Disk:Used",            { 0.2, 0.1, 0.6 } },
+  { 1, "Texture streaming",                { 0.4, 0.6, 1.0 },  "MB", 64, 1048576 },
+  { 1, "Texture streaming:Resident",       { 0.9, 0.8, 0.3 } },
+  { 1, "Texture stream requests",          { 0.8, 0.4, 0.9 },  "", 50 },
+  { 1, "Texture stream requests:Pending",  { 0.3, 0.9, 0.6 } },
   { 1, "TransformStates",                  { 1.0, 0.5, 0.5 },  "", 5000 },
   { 1, "TransformStates:On nodes",         { 0.2, 0.8, 1.0 } },
   { 1, "TransformStates:Cached",           { 1.0, 0.0, 0.2 } },
@@ -210,6 +224,12 @@ static LevelCollectorProperties level_properties[] = {
   { 1, "RenderStates:On nodes",            { 0.2, 0.8, 1.0 } },
   { 1, "RenderStates:Cached",              { 1.0, 0.0, 0.2 } },
   { 1, "RenderStates:Unused",              { 0.2, 0.2, 0.2 } },
+  { 1, "States examined",                  { 0.6, 0.6, 0.2 },  "", 5000 },
+  { 1, "States examined:TransformStates",  { 1.0, 0.5, 0.5 } },
+  { 1, "States examined:RenderStates",     { 0.5, 0.5, 1.0 } },
+  { 1, "States freed",                     { 0.8, 0.3, 0.1 },  "", 500 },
+  { 1, "States freed:TransformStates",     { 1.0, 0.5, 0.5 } },
+  { 1, "States freed:RenderStates",        { 0.5, 0.5, 1.0 } },
   { 1, "PipelineCyclers",                  { 0.5, 0.5, 1.0 },  "", 50000 },
   { 1, "PipelineCyclers:Dirty",            { 0.2, 0.2, 0.2 },  "", 5000 },
   { 1, "Collision Volumes",                { 1.0, 0.8, 0.5 },  "", 500 },
@@ -161,6 +161,13 @@ ConfigVariableBool compressed_textures
           "changes the meaning of set_compression(Texture::CM_default) to "
           "Texture::CM_on."));
 
+ConfigVariableBool stream_textures
+("stream-textures", false,
+ PRC_DESC("Set this to true to stream in the larger mipmap levels of the "
+          "textures that are loaded, only when an object that is rendered "
+          "needs them.  See texture-streaming-budget and "
+          "texture-streaming-min-size."));
+
 ConfigVariableBool cache_check_timestamps
 ("cache-check-timestamps", true,
  PRC_DESC("Set this true to check the timestamps on disk (when possible) "
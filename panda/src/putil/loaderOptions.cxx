@@ -34,6 +34,7 @@ LoaderOptions(int flags) :
   static ConfigVariableBool *preload_textures;
   static ConfigVariableBool *preload_simple_textures;
   static ConfigVariableBool *compressed_textures;
+  static ConfigVariableBool *stream_textures;
   if (preload_textures == nullptr) {
     preload_textures = new ConfigVariableBool("preload-textures", true);
   }
@@ -43,6 +44,9 @@ LoaderOptions(int flags) :
   if (compressed_textures == nullptr) {
     compressed_textures = new ConfigVariableBool("compressed-textures", false);
   }
+  if (stream_textures == nullptr) {
+    stream_textures = new ConfigVariableBool("stream-textures", false);
+  }
 
   if (*preload_textures) {
     _texture_flags |= TF_preload;
@@ -53,6 +57,9 @@ LoaderOptions(int flags) :
   if (*compressed_textures) {
     _texture_flags |= TF_allow_compression;
   }
+  if (*stream_textures) {
+    _texture_flags |= TF_streaming;
+  }
 }
 
 /**
@@ -91,6 +98,7 @@ output(std::ostream &out) const {
   write_texture_flag(out, sep, "TF_generate_mipmaps", TF_generate_mipmaps);
   write_texture_flag(out, sep, "TF_allow_compression", TF_allow_compression);
   write_texture_flag(out, sep, "TF_no_filters", TF_no_filters);
+  write_texture_flag(out, sep, "TF_streaming", TF_streaming);
   if (sep.empty()) {
     out << "0";
   }
@@ -48,6 +48,7 @@ PUBLISHED:
     TF_allow_compression = 0x0200,  // Consider compressing RAM image
     TF_no_filters        = 0x0400,  // disallow using texture pool filters
     TF_force_srgb        = 0x0800,  // Force the texture to have an sRGB format
+    TF_streaming         = 0x1000,  // Stream in the mipmap levels as needed
   };
 
   explicit LoaderOptions(int flags = LF_search | LF_report_errors);
@@ -31,6 +31,9 @@
 #include "load_prc_file.h"
 #include "windowProperties.h"
 #include "frameBufferProperties.h"
+#include "lodGenerator.h"
+#include "sceneGraphReducer.h"
+#include "string_utils.h"
 
 /**
  *
@@ -88,6 +91,32 @@ EggToBam() :
      "file has been loaded, showing the nodes that will be written out.",
      &EggToBam::dispatch_none, &_ls);
 
+  add_option
+    ("lod", "distance,fraction[,error]", 0,
+     "Generates levels of detail from the model, by simplifying the "
+     "triangle meshes.  Specify this once for each level, with the distance "
+     "from which it is shown, and the fraction of the triangles to keep.  "
+     "If error is given, the meshes are not simplified further than the "
+     "point where they deviate from the original by that distance, in model "
+     "units.  A fraction of 0 simplifies only up to the error.  The "
+     "original model is shown up to the distance of the first level.",
+     &EggToBam::dispatch_vector_string, nullptr, &_lod_levels);
+
+  add_option
+    ("lod-fade", "", 0,
+     "Generates a FadeLODNode instead of an LODNode with -lod, which "
+     "cross-fades between the levels of detail.",
+     &EggToBam::dispatch_none, &_lod_fade);
+
+  add_option
+    ("clusters", "", 0,
+     "Partitions the triangle meshes into small clusters, each of which is "
+     "culled individually at runtime when it is outside the view frustum or "
+     "facing away from the camera.  This helps large meshes, such as "
+     "terrain, of which only part is usually visible.  The size of the "
+     "clusters is controlled by the geom-cluster-size config variable.",
+     &EggToBam::dispatch_none, &_clusters);
+
   add_option
     ("C", "quality", 0,
      "Specify the quality level for lossy channel compression.  If this "
@@ -142,13 +171,7 @@ EggToBam() :
 
   add_option
     ("ctex", "", 0,
-#ifdef HAVE_SQUISH
-     "Pre-compress the texture images using the libsquish library, when "
-     "using -rawtex or -txo.  "
-#else
-     "Asks the graphics card to pre-compress the texture images when using "
-     "-rawtex or -txo.  "
-#endif  // HAVE_SQUISH
+     "Pre-compress the texture images when using -rawtex or -txo.  "
 #ifdef HAVE_ZLIB
      "This is unrelated to the on-disk compression achieved "
      "via -txopz (and it may be used in conjunction with that parameter).  "
@@ -158,13 +181,8 @@ EggToBam() :
      "effect can be achieved at load time by setting compressed-textures in "
      "your Config.prc file; but -ctex pre-compresses the "
      "textures so that they do not need to be compressed at load time.  "
-#ifndef HAVE_SQUISH
-     "Note that, since your Panda is not compiled with the libsquish "
-     "library, using -ctex will make .txo files that are only guaranteed "
-     "to load on the particular graphics card that was used to "
-     "generate them."
-#endif  // HAVE_SQUISH
-     ,
+     "The S3TC, RGTC and BPTC formats are compressed by Panda itself; see "
+     "-load-display to ask the graphics card to do it instead.",
      &EggToBam::dispatch_none, &_tex_ctex);
 
   add_option
@@ -189,14 +207,12 @@ EggToBam() :
 
   add_option
     ("load-display", "display name", 0,
-     "Specifies the particular display module to load to perform the texture "
-     "compression requested by -ctex.  If this is omitted, the default is "
-     "taken from the Config.prc file."
-#ifdef HAVE_SQUISH
-     "  Since your Panda has libsquish compiled in, this is not necessary; "
-     "Panda can compress textures without loading a display module."
-#endif  // HAVE_SQUISH
-     ,
+     "Specifies a display module to load to perform the texture "
+     "compression requested by -ctex.  This is not normally necessary, "
+     "since Panda can compress textures without a display module, but it "
+     "allows the use of other formats supported by the graphics card.  Note "
+     "that this may make .txo files that are only guaranteed to load on the "
+     "particular graphics card that was used to generate them.",
      &EggToBam::dispatch_string, nullptr, &_load_display);
 
   redescribe_option
@@ -210,8 +226,13 @@ EggToBam() :
   _egg_flatten = 0;
   _egg_combine_geoms = 0;
   _egg_suppress_hidden = 1;
+  _lod_fade = false;
+  _clusters = false;
   _tex_txopz = false;
   _ctex_quality = "best";
+  _gsg = nullptr;
+  _engine = nullptr;
+  _buffer = nullptr;
 }
 
 /**
@@ -262,13 +283,24 @@ run() {
     exit(1);
   }
 
-  if (_tex_ctex) {
-#ifndef HAVE_SQUISH
+  if (!_lod_levels.empty()) {
+    root = make_lods(root);
+    if (root == nullptr) {
+      exit(1);
+    }
+  }
+
+  if (_clusters) {
+    SceneGraphReducer gr;
+    int num_clustered = gr.make_clusters(root);
+    nout << "Partitioned " << num_clustered << " Geoms into clusters.\n";
+  }
+
+  if (_tex_ctex && !_load_display.empty()) {
     if (!make_buffer()) {
       nout << "Unable to initialize graphics context; cannot compress textures.\n";
       exit(1);
     }
-#endif  // HAVE_SQUISH
   }
 
   if (_tex_txo || _tex_txopz || (_tex_ctex && _tex_rawdata)) {
@@ -283,13 +315,13 @@ run() {
   tex->generate_ram_mipmap_images();
       }
 
-      if (_tex_ctex) {
-#ifdef HAVE_SQUISH
+      if (_tex_ctex && _gsg == nullptr) {
         if (!tex->compress_ram_image()) {
           nout << "  couldn't compress " << tex->get_name() << "\n";
         }
         tex->set_compression(Texture::CM_on);
-#else  // HAVE_SQUISH
+
+      } else if (_tex_ctex) {
         tex->set_keep_ram_image(true);
   bool has_mipmap_levels = (tex->get_num_ram_mipmap_images() > 1);
         if (!_engine->extract_texture_data(tex, _gsg)) {
@@ -301,7 +333,6 @@ run() {
     tex->clear_ram_mipmap_images();
   }
         tex->set_keep_ram_image(false);
-#endif  // HAVE_SQUISH
       }
 
       if (_tex_txo || _tex_txopz) {
@@ -358,6 +389,47 @@ handle_args(ProgramBase::Args &args) {
   return EggToSomething::handle_args(args);
 }
 
+/**
+ * Replaces the children of the root with an LODNode that contains them as
+ * the first level of detail, followed by the simplified levels requested
+ * with -lod.  Returns the new root, or nullptr if one of the levels could not
+ * be parsed.
+ */
+PT(PandaNode) EggToBam::
+make_lods(PandaNode *root) {
+  LODGenerator generator;
+  generator.set_fade(_lod_fade);
+
+  for (const std::string &level : _lod_levels) {
+    vector_string words;
+    tokenize(level, words, ",");
+    PN_stdfloat distance, fraction, error = -1;
+    if (words.size() < 2 || words.size() > 3 ||
+        !string_to_stdfloat(words[0], distance) ||
+        !string_to_stdfloat(words[1], fraction) ||
+        (words.size() == 3 && !string_to_stdfloat(words[2], error))) {
+      nout << "Invalid -lod parameter: " << level << "\n";
+      return nullptr;
+    }
+    if (generator.get_num_levels() > 0 &&
+        distance <= generator.get_level_distance(generator.get_num_levels() - 1)) {
+      nout << "The -lod distances must be increasing.\n";
+      return nullptr;
+    }
+    generator.add_level(distance, fraction, error);
+  }
+
+  PT(PandaNode) model = new PandaNode(root->get_name());
+  model->steal_children(root);
+  root->add_child(generator.generate(model));
+
+  for (size_t i = 0; i < generator.get_num_levels(); ++i) {
+    nout << "LOD level " << i + 1 << ": " << generator.get_level_num_triangles(i)
+         << " triangles, error " << generator.get_level_error(i) << "\n";
+  }
+  return root;
+}
+
 /**
  * Recursively walks the scene graph, looking for Texture references.
  */
@@ -18,6 +18,7 @@
 
 #include "eggToSomething.h"
 #include "pset.h"
+#include "vector_string.h"
 #include "graphicsPipe.h"
 
 class PandaNode;
@@ -45,6 +46,7 @@ private:
   void convert_txo(Texture *tex);
 
   bool make_buffer();
+  PT(PandaNode) make_lods(PandaNode *root);
 
 private:
   typedef pset<Texture *> Textures;
@@ -56,6 +58,9 @@ private:
   int _egg_combine_geoms;
   bool _egg_suppress_hidden;
   bool _ls;
+  vector_string _lod_levels;
+  bool _lod_fade;
+  bool _clusters;
   bool _has_compression_quality;
   int _compression_quality;
   bool _compression_off;
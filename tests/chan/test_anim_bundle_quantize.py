@@ -0,0 +1,84 @@
+from panda3d.core import AnimBundle, AnimGroup, AnimChannelMatrixXfmTable
+from panda3d.core import AnimChannelMatrixQuantized, Character, CharacterJoint
+from panda3d.core import PartGroup, PTA_stdfloat, LMatrix4, LQuaternion
+from math import sin, cos, atan2, degrees
+import pytest
+
+NUM_FRAMES = 120
+
+
+def make_table(parent, name, phase):
+    # Adds a table with smoothly varying rotation and translation, a constant
+    # scale, and a stretch in the middle where nothing moves.
+    table = AnimChannelMatrixXfmTable(parent, name)
+    h, p, r, x, y, z = [], [], [], [], [], []
+    for f in range(NUM_FRAMES):
+        # Hold still between frames 40 and 60.
+        t = (f if f < 40 else 40 if f < 60 else f - 20) / 10.0 + phase
+        h.append(170 * sin(t))
+        p.append(30 * cos(t * 0.5))
+        r.append(5 * t)
+        x.append(sin(t))
+        y.append(2 * t)
+        z.append(0 if f < 10 else 1)
+
+    for table_id, values in zip("hprxyz", (h, p, r, x, y, z)):
+        table.set_table(table_id, PTA_stdfloat(values))
+    table.set_table('i', PTA_stdfloat([2.0]))
+    return table
+
+
+def get_angle_between(a, b):
+    # Returns the angle between the rotations of the two matrices, in degrees.
+    qa = LQuaternion()
+    qb = LQuaternion()
+    qa.set_from_matrix(a.get_upper_3())
+    qb.set_from_matrix(b.get_upper_3())
+    qa.normalize()
+    qb.normalize()
+
+    # Taking the acos of the dot product is too imprecise for small angles.
+    diff = qa.conjugate() * qb
+    return degrees(2 * atan2(diff.get_axis().length(), abs(diff.get_r())))
+
+
+@pytest.mark.parametrize("bam", [False, True])
+def test_anim_bundle_quantize_channels(bam):
+    bundle = AnimBundle("char", 24, NUM_FRAMES)
+    skeleton = AnimGroup(bundle, "<skeleton>")
+    root = make_table(skeleton, "root", 0.0)
+    make_table(root, "child", 1.0)
+    make_table(skeleton, "other", 2.0)
+
+    original = bundle.copy_bundle()
+    assert bundle.quantize_channels() == 3
+
+    if bam:
+        bundle = AnimBundle.decode_from_bam_stream(bundle.encode_to_bam_stream())
+        assert bundle is not None
+
+    # The hierarchy is preserved.
+    new_root = bundle.find_child("root")
+    assert type(new_root) is AnimChannelMatrixQuantized
+    assert new_root.get_num_children() == 1
+    assert new_root.get_child(0).get_name() == "child"
+    assert type(new_root.get_child(0)) is AnimChannelMatrixQuantized
+
+    # The bundle still binds to a matching skeleton, and poses it.
+    character = Character("char")
+    part = character.get_bundle(0)
+    part_skeleton = PartGroup(part, "<skeleton>")
+    part_root = CharacterJoint(character, part, part_skeleton, "root", LMatrix4.ident_mat())
+    CharacterJoint(character, part, part_root, "child", LMatrix4.ident_mat())
+    CharacterJoint(character, part, part_skeleton, "other", LMatrix4.ident_mat())
+
+    control = part.bind_anim(bundle, 0)
+    assert control is not None
+    control.pose(25)
+    part.force_update()
+
+    expected = LMatrix4()
+    original.find_child("child").get_value(25, expected)
+    actual = character.find_joint("child").get_value()
+    assert get_angle_between(expected, actual) < 0.02
+    assert expected.get_row3(3).almost_equal(actual.get_row3(3), 0.002)
@@ -0,0 +1,151 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file test_anim_channel_quantized.cxx
+ * @author rdb
+ * @date 2026-10-17
+ */
+
+#include "animBundle.h"
+#include "animChannelMatrixQuantized.h"
+#include "animChannelMatrixXfmTable.h"
+
+#include "catch_amalgamated.hpp"
+
+static const int num_frames = 120;
+
+/**
+ * Adds a table with smoothly varying rotation and translation, a constant
+ * scale, and a stretch in the middle where nothing moves.
+ */
+static AnimChannelMatrixXfmTable *
+make_table(AnimGroup *parent, const std::string &name, PN_stdfloat phase) {
+  AnimChannelMatrixXfmTable *table = new AnimChannelMatrixXfmTable(parent, name);
+  PTA_stdfloat h, p, r, x, y, z;
+  for (int f = 0; f < num_frames; ++f) {
+    // Hold still between frames 40 and 60.
+    PN_stdfloat t = (PN_stdfloat)((f < 40) ? f : (f < 60) ? 40 : f - 20) / 10.0f + phase;
+    h.push_back(170.0f * csin(t));
+    p.push_back(30.0f * ccos(t * 0.5f));
+    r.push_back(5.0f * t);
+    x.push_back(csin(t));
+    y.push_back(2.0f * t);
+    z.push_back(f < 10 ? 0.0f : 1.0f);
+  }
+  table->set_table('h', h);
+  table->set_table('p', p);
+  table->set_table('r', r);
+  table->set_table('x', x);
+  table->set_table('y', y);
+  table->set_table('z', z);
+
+  PTA_stdfloat s;
+  s.push_back(2.0f);
+  table->set_table('i', s);
+  return table;
+}
+
+/**
+ * Returns the angle between the rotations of the two matrices, in degrees.
+ */
+static PN_stdfloat
+get_angle_between(const LMatrix4 &a, const LMatrix4 &b) {
+  LQuaternion qa, qb;
+  qa.set_from_matrix(a.get_upper_3());
+  qb.set_from_matrix(b.get_upper_3());
+  qa.normalize();
+  qb.normalize();
+
+  // Taking the acos of the dot product is too imprecise for small angles.
+  LQuaternion diff = qa.conjugate() * qb;
+  return rad_2_deg(2.0f * catan2(diff.get_axis().length(), cabs(diff.get_r())));
+}
+
+TEST_CASE("Quantized channel stays within tolerance", "[chan]") {
+  PT(AnimBundle) bundle = new AnimBundle("anim", 24, num_frames);
+  AnimChannelMatrixXfmTable *table = make_table(bundle, "joint", 0.0f);
+
+  PN_stdfloat tolerance = GENERATE(0.01f, 0.001f);
+  PN_stdfloat angle_tolerance = tolerance * 10.0f;
+  PT(AnimChannelMatrixQuantized) quantized =
+    new AnimChannelMatrixQuantized(nullptr, *table, tolerance, angle_tolerance);
+
+  CHECK(quantized->get_name() == "joint");
+  CHECK(quantized->get_num_frames() == num_frames);
+  // There should be far fewer keys than there were values.
+  CHECK(quantized->get_num_keys() < num_frames * 2);
+
+  for (int f = 0; f < num_frames; ++f) {
+    CAPTURE(f);
+    LMatrix4 expected, actual;
+    table->get_value(f, expected);
+    quantized->get_value(f, actual);
+    CHECK(get_angle_between(expected, actual) <= angle_tolerance * 1.01f + 0.001f);
+
+    LVecBase3 expected_pos, actual_pos, actual_scale, actual_shear;
+    table->get_pos(f, expected_pos);
+    quantized->get_pos(f, actual_pos);
+    CHECK(expected_pos.almost_equal(actual_pos, tolerance * 1.01f));
+    CHECK(actual.get_row3(3).almost_equal(actual_pos, 1.0e-5f));
+
+    quantized->get_scale(f, actual_scale);
+    CHECK(actual_scale.almost_equal(LVecBase3(2, 1, 1), 1.0e-5f));
+    quantized->get_shear(f, actual_shear);
+    CHECK(actual_shear == LVecBase3::zero());
+  }
+}
+
+TEST_CASE("Quantized channel reports changes", "[chan]") {
+  PT(AnimBundle) bundle = new AnimBundle("anim", 24, num_frames);
+  AnimChannelMatrixXfmTable *table = make_table(bundle, "joint", 0.0f);
+  PT(AnimChannelMatrixQuantized) quantized =
+    new AnimChannelMatrixQuantized(nullptr, *table, 0.001f, 0.01f);
+
+  CHECK(quantized->has_changed(0, 0.0, 1, 0.0));
+  CHECK(quantized->has_changed(10, 0.0, 30, 0.0));
+  CHECK_FALSE(quantized->has_changed(5, 0.0, 5, 0.0));
+
+  // Whenever no change is reported, the value must in fact be the same.
+  for (int a = 0; a < num_frames; ++a) {
+    for (int b = a + 1; b < num_frames; ++b) {
+      if (!quantized->has_changed(a, 0.0, b, 0.0)) {
+        CAPTURE(a, b);
+        LMatrix4 mat_a, mat_b;
+        quantized->get_value(a, mat_a);
+        quantized->get_value(b, mat_b);
+        CHECK(mat_a.almost_equal(mat_b, 1.0e-5f));
+      }
+    }
+  }
+
+  // A table holding the same value in every frame never changes.
+  AnimChannelMatrixXfmTable *still = new AnimChannelMatrixXfmTable(bundle, "still");
+  PTA_stdfloat h;
+  for (int f = 0; f < num_frames; ++f) {
+    h.push_back(45.0f);
+  }
+  still->set_table('h', h);
+  PT(AnimChannelMatrixQuantized) still_quantized =
+    new AnimChannelMatrixQuantized(nullptr, *still);
+  CHECK(still_quantized->get_num_keys() <= 1);
+  CHECK_FALSE(still_quantized->has_changed(0, 0.0, 50, 0.5));
+}
+
+TEST_CASE("Quantized channel of an empty table", "[chan]") {
+  PT(AnimBundle) bundle = new AnimBundle("anim", 24, num_frames);
+  AnimChannelMatrixXfmTable *table = new AnimChannelMatrixXfmTable(bundle, "joint");
+  PT(AnimChannelMatrixQuantized) quantized =
+    new AnimChannelMatrixQuantized(nullptr, *table);
+
+  CHECK(quantized->get_num_keys() == 0);
+  CHECK_FALSE(quantized->has_changed(0, 0.0, 10, 0.5));
+
+  LMatrix4 mat;
+  quantized->get_value(7, mat);
+  CHECK(mat.almost_equal(LMatrix4::ident_mat()));
+}
@@ -0,0 +1,367 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file test_part_bundle_update.cxx
+ * @author rdb
+ * @date 2026-10-17
+ */
+
+#include "partBundle.h"
+#include "movingPartMatrix.h"
+#include "animBundle.h"
+#include "animChannelMatrixXfmTable.h"
+#include "animControl.h"
+#include "clockObject.h"
+#include "config_chan.h"
+
+#include "catch_amalgamated.hpp"
+
+static const int num_update_frames = 10;
+
+/**
+ * Adds a chain of joints of the indicated length under the indicated parent,
+ * named with the given prefix.
+ */
+static void
+add_joints(PartGroup *parent, const std::string &prefix, int depth) {
+  for (int i = 0; i < depth; ++i) {
+    parent = new MovingPartMatrix(parent, prefix + std::to_string(i),
+                                  LMatrix4::translate_mat(0, 0, i + 1));
+  }
+}
+
+/**
+ * Adds a chain of animation channels matching add_joints().  Each channel
+ * gets a different set of tables, depending on the seed.
+ */
+static void
+add_channels(AnimGroup *parent, const std::string &prefix, int depth, int seed) {
+  for (int i = 0; i < depth; ++i) {
+    AnimChannelMatrixXfmTable *table = new AnimChannelMatrixXfmTable(parent, prefix + std::to_string(i));
+    PTA_stdfloat h, p, x, z, s;
+    for (int f = 0; f < num_update_frames; ++f) {
+      h.push_back((PN_stdfloat)(seed * 10 + f * 17 + i * 5));
+      p.push_back((PN_stdfloat)(f * 3 - i));
+      x.push_back((PN_stdfloat)(f * 0.5 + seed));
+      s.push_back(1.0f + 0.1f * seed + 0.05f * (f % 4));
+    }
+    z.push_back((PN_stdfloat)(i + 1));
+    table->set_table('h', h);
+    table->set_table('p', p);
+    table->set_table('x', x);
+    table->set_table('z', z);
+    if (i % 2 == 1) {
+      table->set_table('i', s);
+    }
+    parent = table;
+  }
+}
+
+static PT(PartBundle)
+make_bundle() {
+  PT(PartBundle) bundle = new PartBundle("char");
+  PartGroup *skeleton = new PartGroup(bundle, "<skeleton>");
+  add_joints(skeleton, "a", 4);
+  add_joints(skeleton, "b", 3);
+  return bundle;
+}
+
+static PT(AnimBundle)
+make_anim(int seed) {
+  PT(AnimBundle) anim = new AnimBundle("char", 24, num_update_frames);
+  AnimGroup *skeleton = new AnimGroup(anim, "<skeleton>");
+  add_channels(skeleton, "a", 4, seed);
+  add_channels(skeleton, "b", 3, seed);
+  return anim;
+}
+
+/**
+ * Returns the values of all of the joints in the bundle.
+ */
+static pvector<LMatrix4>
+get_values(PartGroup *group) {
+  pvector<LMatrix4> values;
+  if (group->is_of_type(MovingPartMatrix::get_class_type())) {
+    values.push_back(DCAST(MovingPartMatrix, group)->get_value());
+  }
+  for (int i = 0; i < group->get_num_children(); ++i) {
+    pvector<LMatrix4> child_values = get_values(group->get_child(i));
+    values.insert(values.end(), child_values.begin(), child_values.end());
+  }
+  return values;
+}
+
+static void
+check_values(PartGroup *a, PartGroup *b) {
+  pvector<LMatrix4> va = get_values(a);
+  pvector<LMatrix4> vb = get_values(b);
+  REQUIRE(va.size() == vb.size());
+  for (size_t i = 0; i < va.size(); ++i) {
+    if (!va[i].almost_equal(vb[i], 1.0e-4f)) {
+      CAPTURE(i, va[i], vb[i]);
+      FAIL_CHECK("joint values differ");
+    }
+  }
+}
+
+/**
+ * Maintains two identical bundles, one of which is updated using the update
+ * plan, the other using the recursive update.
+ */
+struct BundlePair {
+  BundlePair() : _plan(make_bundle()), _recursive(make_bundle()) {}
+
+  void bind(AnimBundle *anim) {
+    _plan_controls.push_back(_plan->bind_anim(anim, 0));
+    _recursive_controls.push_back(_recursive->bind_anim(anim, 0));
+    REQUIRE(_plan_controls.back() != nullptr);
+    REQUIRE(_recursive_controls.back() != nullptr);
+  }
+
+  template<class Func>
+  void apply(Func func) {
+    func(_plan, _plan_controls);
+    func(_recursive, _recursive_controls);
+  }
+
+  bool update(bool force) {
+    part_bundle_update_plan = true;
+    bool plan_changed = force ? _plan->force_update() : _plan->update();
+    part_bundle_update_plan = false;
+    bool recursive_changed = force ? _recursive->force_update() : _recursive->update();
+    part_bundle_update_plan.clear_local_value();
+    CHECK(plan_changed == recursive_changed);
+    check_values(_plan, _recursive);
+    return plan_changed;
+  }
+
+  PT(PartBundle) _plan;
+  PT(PartBundle) _recursive;
+  pvector<PT(AnimControl)> _plan_controls;
+  pvector<PT(AnimControl)> _recursive_controls;
+};
+
+typedef pvector<PT(AnimControl)> Controls;
+
+/**
+ * Advances the global clock, so that PartBundle::update() will consider
+ * updating the bundle again.
+ */
+static void
+next_frame() {
+  ClockObject *clock = ClockObject::get_global_clock();
+  clock->set_mode(ClockObject::M_slave);
+  clock->set_frame_time(clock->get_frame_time() + 1.0);
+}
+
+TEST_CASE("PartBundle update plan matches the recursive update", "[chan]") {
+  auto blend_type = GENERATE(PartBundle::BT_linear,
+                             PartBundle::BT_normalized_linear,
+                             PartBundle::BT_componentwise,
+                             PartBundle::BT_componentwise_quat);
+  bool frame_blend = GENERATE(false, true);
+
+  BundlePair pair;
+  PT(AnimBundle) anim0 = make_anim(0);
+  PT(AnimBundle) anim1 = make_anim(1);
+  pair.bind(anim0);
+  pair.bind(anim1);
+
+  pair.apply([&] (PartBundle *bundle, Controls &controls) {
+    bundle->set_blend_type(blend_type);
+    bundle->set_frame_blend_flag(frame_blend);
+    controls[0]->pose(2.25);
+  });
+  pair.update(true);
+
+  SECTION("single animation") {
+    for (double frame : {3.0, 3.5, 3.5, 7.75, 9.5}) {
+      next_frame();
+      pair.apply([&] (PartBundle *bundle, Controls &controls) {
+        controls[0]->pose(frame);
+      });
+      pair.update(false);
+    }
+  }
+
+  SECTION("blended animations") {
+    pair.apply([&] (PartBundle *bundle, Controls &controls) {
+      bundle->set_anim_blend_flag(true);
+      bundle->set_control_effect(controls[0], 0.25f);
+      bundle->set_control_effect(controls[1], 0.75f);
+      controls[1]->pose(5.5);
+    });
+    pair.update(false);
+
+    for (double frame : {1.0, 1.0, 4.5, 8.0}) {
+      next_frame();
+      pair.apply([&] (PartBundle *bundle, Controls &controls) {
+        controls[1]->pose(frame);
+      });
+      pair.update(false);
+    }
+
+    // Dropping the effect of one animation changes the active controls.
+    next_frame();
+    pair.apply([&] (PartBundle *bundle, Controls &controls) {
+      bundle->set_control_effect(controls[0], 0.0f);
+    });
+    pair.update(false);
+  }
+
+  SECTION("no animation") {
+    pair.apply([&] (PartBundle *bundle, Controls &controls) {
+      bundle->set_anim_blend_flag(true);
+      bundle->set_control_effect(controls[0], 0.0f);
+    });
+    pair.update(false);
+  }
+
+  SECTION("forced channel") {
+    pair.apply([&] (PartBundle *bundle, Controls &controls) {
+      bundle->freeze_joint("a1", LVecBase3(1, 2, 3), LVecBase3(90, 0, 0), LVecBase3(1, 1, 1));
+    });
+    pair.update(false);
+    next_frame();
+    pair.apply([&] (PartBundle *bundle, Controls &controls) {
+      controls[0]->pose(6);
+    });
+    pair.update(false);
+  }
+
+  SECTION("update subset") {
+    PartSubset subset;
+    subset.add_exclude_joint(GlobPattern("a2"));
+    subset.add_exclude_joint(GlobPattern("b*"));
+    pair.apply([&] (PartBundle *bundle, Controls &controls) {
+      CHECK(bundle->set_update_subset(subset) == 2);
+    });
+    LMatrix4 a2_value = DCAST(MovingPartMatrix, pair._plan->find_child("a2"))->get_value();
+
+    next_frame();
+    pair.apply([&] (PartBundle *bundle, Controls &controls) {
+      controls[0]->pose(7);
+    });
+    pair.update(false);
+    CHECK(DCAST(MovingPartMatrix, pair._plan->find_child("a2"))->get_value() == a2_value);
+
+    next_frame();
+    pair.apply([&] (PartBundle *bundle, Controls &controls) {
+      CHECK(bundle->clear_update_subset() == 7);
+    });
+    pair.update(false);
+    CHECK(DCAST(MovingPartMatrix, pair._plan->find_child("a2"))->get_value() != a2_value);
+  }
+
+  SECTION("hierarchy change") {
+    // Adding a joint after binding must cause the plan to be rebuilt.
+    pair.apply([&] (PartBundle *bundle, Controls &controls) {
+      add_joints(bundle->find_child("a2"), "c", 2);
+    });
+    pair.update(true);
+    next_frame();
+    pair.apply([&] (PartBundle *bundle, Controls &controls) {
+      controls[0]->pose(8);
+    });
+    pair.update(false);
+  }
+
+  ClockObject::get_global_clock()->set_mode(ClockObject::M_normal);
+}
+
+TEST_CASE("PartBundle update skips unchanged bundles", "[chan]") {
+  BundlePair pair;
+  PT(AnimBundle) anim = make_anim(0);
+  pair.bind(anim);
+  pair.apply([&] (PartBundle *bundle, Controls &controls) {
+    controls[0]->pose(1);
+  });
+  CHECK(pair.update(true));
+
+  // Posing the same frame again doesn't change anything.
+  next_frame();
+  pair.apply([&] (PartBundle *bundle, Controls &controls) {
+    controls[0]->pose(1);
+  });
+  CHECK_FALSE(pair.update(false));
+
+  ClockObject::get_global_clock()->set_mode(ClockObject::M_normal);
+}
+
+TEST_CASE("PartBundle::update_bundles with threads", "[chan]") {
+  PT(AnimBundle) anim = make_anim(2);
+  pvector<PT(PartBundle)> serial, parallel;
+  pvector<PT(AnimControl)> controls;
+  pvector<PartBundle *> serial_ptrs, parallel_ptrs;
+  for (int i = 0; i < 16; ++i) {
+    serial.push_back(make_bundle());
+    parallel.push_back(make_bundle());
+    serial_ptrs.push_back(serial.back());
+    parallel_ptrs.push_back(parallel.back());
+    controls.push_back(serial.back()->bind_anim(anim, 0));
+    controls.push_back(parallel.back()->bind_anim(anim, 0));
+    controls[controls.size() - 2]->pose(i * 0.5);
+    controls[controls.size() - 1]->pose(i * 0.5);
+  }
+
+  CHECK(PartBundle::update_bundles(serial_ptrs, true, 0));
+  CHECK(PartBundle::update_bundles(parallel_ptrs, true, 4));
+  for (int i = 0; i < 16; ++i) {
+    check_values(parallel[i], serial[i]);
+  }
+}
+
+// This measures the cost of updating a crowd of animated characters.  Run it
+// explicitly with: run_cxx_tests "[benchmark]"
+TEST_CASE("PartBundle update", "[.][benchmark][chan]") {
+  static const int num_bundles = 200;
+
+  PT(AnimBundle) anim0 = make_anim(0);
+  PT(AnimBundle) anim1 = make_anim(1);
+  pvector<PT(PartBundle)> bundles;
+  pvector<PartBundle *> bundle_ptrs;
+  pvector<PT(AnimControl)> controls;
+  for (int i = 0; i < num_bundles; ++i) {
+    PT(PartBundle) bundle = new PartBundle("char");
+    PartGroup *skeleton = new PartGroup(bundle, "<skeleton>");
+    add_joints(skeleton, "a", 4);
+    add_joints(skeleton, "b", 3);
+    bundle->set_anim_blend_flag(true);
+    bundle->set_frame_blend_flag(true);
+    PT(AnimControl) c0 = bundle->bind_anim(anim0, 0);
+    PT(AnimControl) c1 = bundle->bind_anim(anim1, 0);
+    bundle->set_control_effect(c0, 0.5f);
+    bundle->set_control_effect(c1, 0.5f);
+    controls.push_back(c0);
+    controls.push_back(c1);
+    bundles.push_back(bundle);
+    bundle_ptrs.push_back(bundle);
+  }
+
+  double frame = 0.0;
+  auto pose_all = [&] () {
+    frame += 0.3;
+    for (AnimControl *control : controls) {
+      control->pose(frame);
+    }
+  };
+
+  BENCHMARK("recursive update") {
+    part_bundle_update_plan = false;
+    pose_all();
+    return PartBundle::update_bundles(bundle_ptrs, true, 0);
+  };
+  part_bundle_update_plan.clear_local_value();
+
+  for (int num_threads : {0, 2, 4}) {
+    BENCHMARK("update plan with " + std::to_string(num_threads) + " threads") {
+      pose_all();
+      return PartBundle::update_bundles(bundle_ptrs, true, num_threads);
+    };
+  }
+}
@@ -0,0 +1,188 @@
+from panda3d.core import Character, CharacterJoint, CharacterLodManager
+from panda3d.core import AnimBundle, AnimGroup, AnimChannelMatrixXfmTable
+from panda3d.core import PartGroup, PartSubset, GlobPattern, PTA_stdfloat
+from panda3d.core import ClockObject, TransformState, LMatrix4
+import pytest
+
+NUM_FRAMES = 10
+CHAINS = (("a", 4), ("b", 2))
+
+
+@pytest.fixture
+def anim():
+    # An animation in which every joint rotates with the frame number.
+    anim = AnimBundle("char", 24, NUM_FRAMES)
+    skeleton = AnimGroup(anim, "<skeleton>")
+    for prefix, length in CHAINS:
+        parent = skeleton
+        for i in range(length):
+            table = AnimChannelMatrixXfmTable(parent, prefix + str(i))
+            table.set_table('h', PTA_stdfloat([f * 10 for f in range(NUM_FRAMES)]))
+            parent = table
+    return anim
+
+
+@pytest.fixture
+def clock():
+    # Runs the global clock in slave mode, so that frames can be stepped.
+    clock = ClockObject.get_global_clock()
+    clock.set_mode(ClockObject.M_slave)
+    yield clock
+    clock.set_mode(ClockObject.M_normal)
+
+
+def make_character(anim, controls):
+    # A character with two chains of joints, a0-a3 and b0-b1.
+    character = Character("char")
+    bundle = character.get_bundle(0)
+    skeleton = PartGroup(bundle, "<skeleton>")
+    for prefix, length in CHAINS:
+        parent = skeleton
+        for i in range(length):
+            parent = CharacterJoint(character, bundle, parent, prefix + str(i),
+                                    LMatrix4.ident_mat())
+
+    control = bundle.bind_anim(anim, 0)
+    assert control is not None
+    controls.append(control)
+    return character
+
+
+def get_heading(character, name):
+    joint = character.find_joint(name)
+    assert joint is not None
+    return TransformState.make_mat(joint.get_value()).get_hpr()[0]
+
+
+def next_frame(clock):
+    clock.set_frame_count(clock.get_frame_count() + 1)
+    clock.set_frame_time(clock.get_frame_time() + 0.1)
+
+
+def test_character_lod_levels(anim, clock):
+    controls = []
+    near_char = make_character(anim, controls)
+    mid_char = make_character(anim, controls)
+    far_char = make_character(anim, controls)
+    hidden_char = make_character(anim, controls)
+    characters = (near_char, mid_char, far_char, hidden_char)
+
+    subset = PartSubset()
+    subset.add_include_joint(GlobPattern("a0"))
+    subset.add_exclude_joint(GlobPattern("a2"))
+
+    mgr = CharacterLodManager()
+    assert mgr.add_level(0.1, 0.0, subset) == 0
+    assert mgr.add_level(0.5, 0.0) == 0
+    assert mgr.add_level(0.0, 0.0) == 2
+    mgr.set_level_rigid(2, True)
+    assert mgr.get_num_levels() == 3
+    assert mgr.get_level_for_screen_size(0.7) == 0
+    assert mgr.get_level_for_screen_size(0.3) == 1
+    assert mgr.get_level_for_screen_size(0.01) == 2
+
+    for character in characters:
+        mgr.add_character(character)
+        assert character.get_lod_manager() == mgr
+    assert mgr.num_characters == 4
+
+    # Pose everything at frame 1, so that the rigid one has a pose to hold.
+    for control in controls:
+        control.pose(1)
+    for character in characters:
+        character.force_update()
+
+    # Report what the cull traversal would have seen.
+    next_frame(clock)
+    assert not near_char.record_lod_view(0.2)
+    assert not near_char.record_lod_view(0.8)
+    assert not mid_char.record_lod_view(0.3)
+    assert not far_char.record_lod_view(0.01)
+    assert near_char.get_lod_screen_size() == pytest.approx(0.8)
+
+    next_frame(clock)
+    for control in controls:
+        control.pose(5)
+    mgr.update()
+
+    assert near_char.get_lod_level() == 0
+    assert mid_char.get_lod_level() == 1
+    assert far_char.get_lod_level() == 2
+    assert hidden_char.get_lod_level() == -1
+    assert mgr.get_num_updated_characters() == 2
+    assert mgr.get_num_updated_joints() == 6 + 2
+
+    # The cull traversal leaves the handled characters alone.
+    assert near_char.record_lod_view(0.8)
+    assert far_char.record_lod_view(0.01)
+    assert not hidden_char.record_lod_view(0.5)
+
+    for name in ("a0", "a1", "a2", "a3", "b0", "b1"):
+        assert get_heading(near_char, name) == pytest.approx(50)
+        assert get_heading(far_char, name) == pytest.approx(10)
+
+    # a0 and a1 are included, but a2 and a3 are excluded.
+    assert get_heading(mid_char, "a0") == pytest.approx(50)
+    assert get_heading(mid_char, "a1") == pytest.approx(50)
+    assert get_heading(mid_char, "a2") == pytest.approx(10)
+    assert get_heading(mid_char, "a3") == pytest.approx(10)
+    assert get_heading(mid_char, "b0") == pytest.approx(10)
+
+    # Removing the character restores all of its joints.
+    assert mgr.remove_character(mid_char)
+    assert not mgr.remove_character(mid_char)
+    assert mid_char.get_lod_manager() is None
+    next_frame(clock)
+    mid_char.update()
+    assert get_heading(mid_char, "a3") == pytest.approx(50)
+    assert get_heading(mid_char, "b1") == pytest.approx(50)
+
+
+def test_character_lod_joint_budget(anim, clock):
+    num_characters = 10
+
+    controls = []
+    mgr = CharacterLodManager()
+    mgr.joint_budget = 20
+    characters = [make_character(anim, controls) for i in range(num_characters)]
+    for character in characters:
+        mgr.add_character(character)
+
+    num_updates = [0] * num_characters
+    for frame in range(20):
+        # Every frame poses a different frame of the animation than the last.
+        anim_frame = frame % (NUM_FRAMES - 1) + 1
+        next_frame(clock)
+        for i, character in enumerate(characters):
+            character.record_lod_view(0.1 * (i + 1))
+        next_frame(clock)
+        for control in controls:
+            control.pose(anim_frame)
+        mgr.update()
+
+        # Each character has six joints, so three fit in the budget.
+        assert mgr.get_num_updated_characters() == 3
+        assert mgr.get_num_updated_joints() == 18
+        assert mgr.get_num_deferred_characters() == num_characters - 3
+
+        for i, character in enumerate(characters):
+            if get_heading(character, "a0") == pytest.approx(anim_frame * 10):
+                num_updates[i] += 1
+
+    # The characters that were kept waiting eventually get their turn, though
+    # the larger ones are updated more often.
+    assert all(num_updates)
+    assert num_updates[-1] >= num_updates[0]
+
+
+def test_character_lod_deleted(anim):
+    controls = []
+    mgr = CharacterLodManager()
+    character = make_character(anim, controls)
+    mgr.add_character(character)
+    assert mgr.num_characters == 1
+
+    del character
+    controls.clear()
+    assert mgr.num_characters == 0
+    mgr.update()
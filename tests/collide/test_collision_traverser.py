@@ -29,3 +29,129 @@ def test_collision_traverser_pickle():
     # Two colliders must still be the same object; this only works with our own
     # version of the pickle module, in direct.stdpy.pickle.
     assert trav.get_handler(collider1) == trav.get_handler(collider2)
+
+
+def _make_grid_node(size):
+    # Makes a CollisionNode holding a size x size grid of small spheres.
+    from panda3d.core import CollisionSphere
+
+    cnode = CollisionNode("grid")
+    for y in range(size):
+        for x in range(size):
+            cnode.add_solid(CollisionSphere(x, y, 0, 0.25))
+    return cnode
+
+
+def _make_grid_geom_node(size):
+    # Makes a GeomNode holding a size x size grid of unit quads.
+    from panda3d.core import GeomNode, Geom, GeomTriangles, GeomVertexData
+    from panda3d.core import GeomVertexFormat, GeomVertexWriter
+
+    vdata = GeomVertexData("grid", GeomVertexFormat.get_v3(), Geom.UH_static)
+    vertex = GeomVertexWriter(vdata, "vertex")
+    for y in range(size + 1):
+        for x in range(size + 1):
+            vertex.add_data3(x, y, 0)
+
+    tris = GeomTriangles(Geom.UH_static)
+    for y in range(size):
+        for x in range(size):
+            i = y * (size + 1) + x
+            tris.add_vertices(i, i + 1, i + size + 2)
+            tris.add_vertices(i, i + size + 2, i + size + 1)
+
+    geom = Geom(vdata)
+    geom.add_primitive(tris)
+    gnode = GeomNode("grid")
+    gnode.add_geom(geom)
+    return gnode
+
+
+def _traverse_entries(root, collider, use_bvh):
+    trav = CollisionTraverser()
+    trav.use_bvh = use_bvh
+    queue = CollisionHandlerQueue()
+    trav.add_collider(collider, queue)
+    trav.traverse(root)
+    return [(entry.into_node_path, entry.get_surface_point(root))
+            for entry in queue.entries]
+
+
+def test_collision_traverser_bvh_solids():
+    from panda3d.core import CollisionSphere, CollisionRay
+
+    root = NodePath("root")
+    into = root.attach_new_node(_make_grid_node(20))
+
+    sphere = root.attach_new_node(CollisionNode("sphere"))
+    sphere.node().add_solid(CollisionSphere(5.1, 7.2, 0, 0.5))
+
+    ray = root.attach_new_node(CollisionNode("ray"))
+    ray.node().add_solid(CollisionRay((12, 3, 10), (0, 0, -1)))
+
+    for collider in (sphere, ray):
+        expected = _traverse_entries(root, collider, False)
+        assert len(expected) > 0
+        assert _traverse_entries(root, collider, True) == expected
+
+    # Moving a solid must be picked up by the traverser.
+    into.node().modify_solid(0).set_center((12, 3, 0))
+    entries = _traverse_entries(root, ray, True)
+    assert entries == _traverse_entries(root, ray, False)
+    assert len(entries) == 2
+
+
+def test_collision_traverser_bvh_geom():
+    from panda3d.core import CollisionSphere, CollisionRay, GeomNode
+
+    root = NodePath("root")
+    into = root.attach_new_node(_make_grid_geom_node(20))
+    into.set_collide_mask(GeomNode.get_default_collide_mask())
+
+    sphere = root.attach_new_node(CollisionNode("sphere"))
+    sphere.node().add_solid(CollisionSphere(5.5, 7.5, 0.1, 0.5))
+    sphere.node().set_from_collide_mask(GeomNode.get_default_collide_mask())
+
+    ray = root.attach_new_node(CollisionNode("ray"))
+    ray.node().add_solid(CollisionRay((12.25, 3.75, 10), (0, 0, -1)))
+    ray.node().set_from_collide_mask(GeomNode.get_default_collide_mask())
+
+    for collider in (sphere, ray):
+        expected = _traverse_entries(root, collider, False)
+        assert len(expected) > 0
+        assert _traverse_entries(root, collider, True) == expected
+
+
+def test_collision_traverser_threads():
+    from panda3d.core import CollisionSphere
+
+    root = NodePath("root")
+    root.attach_new_node(_make_grid_node(10))
+
+    # A second grid further down, so that each collider hits several nodes.
+    root.attach_new_node("parent").attach_new_node(_make_grid_node(10)).set_z(0.25)
+
+    handler = CollisionHandlerQueue()
+    trav = CollisionTraverser()
+    for i in range(100):
+        collider = root.attach_new_node(CollisionNode("collider%d" % (i)))
+        collider.node().add_solid(CollisionSphere(i % 10, i // 10, 0, 0.5))
+        trav.add_collider(collider, handler)
+
+    def traverse(num_threads):
+        trav.num_threads = num_threads
+        trav.traverse(root)
+        return [(entry.from_node_path.name, str(entry.into_node_path),
+                 tuple(entry.into_solid.center))
+                for entry in handler.entries]
+
+    expected = traverse(0)
+    assert len(expected) > 0
+
+    # The entries are reported in the same order as by the serial traversal.
+    threaded = traverse(4)
+    assert threaded == expected
+
+    # The order in which the entries are reported must not depend on the
+    # timing of the threads.
+    assert traverse(4) == threaded
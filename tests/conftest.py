@@ -105,6 +105,82 @@ def gsg(graphics_pipe, graphics_engine):
         graphics_engine.remove_window(buffer)
 
 
+@pytest.fixture(scope='session')
+def make_sphere():
+    """Returns a function that makes a closed unit sphere Geom out of
+    latitude-longitude quads, with the front faces pointing outward.  If
+    texcoords is true, the sphere has texture coordinates, with a UV seam
+    along one of its meridians; otherwise, the vertices are all shared."""
+    from math import pi, sin, cos
+    from panda3d.core import Geom, GeomVertexData, GeomVertexFormat
+    from panda3d.core import GeomVertexWriter, GeomTriangles
+
+    def make_sphere(num_rings, num_segments, texcoords=False):
+        if texcoords:
+            format = GeomVertexFormat.get_v3n3t2()
+        else:
+            format = GeomVertexFormat.get_v3n3()
+        vdata = GeomVertexData("sphere", format, Geom.UH_static)
+        vertex = GeomVertexWriter(vdata, "vertex")
+        normal = GeomVertexWriter(vdata, "normal")
+        tris = GeomTriangles(Geom.UH_static)
+
+        if texcoords:
+            texcoord = GeomVertexWriter(vdata, "texcoord")
+            for r in range(num_rings + 1):
+                theta = pi * r / num_rings
+                for s in range(num_segments + 1):
+                    # The vertices on the seam and at the poles have exactly
+                    # the same position.
+                    phi = pi * 2 * (s % num_segments) / num_segments
+                    if r == 0 or r == num_rings:
+                        point = (0, 0, 1 if r == 0 else -1)
+                    else:
+                        point = (sin(theta) * cos(phi), sin(theta) * sin(phi), cos(theta))
+                    vertex.add_data3(point)
+                    normal.add_data3(point)
+                    texcoord.add_data2(s / num_segments, r / num_rings)
+
+            for r in range(num_rings):
+                for s in range(num_segments):
+                    a = r * (num_segments + 1) + s
+                    c = a + num_segments + 1
+                    if r < num_rings - 1:
+                        tris.add_vertices(a, c, c + 1)
+                    if r > 0:
+                        tris.add_vertices(a, c + 1, a + 1)
+        else:
+            vertex.add_data3(0, 0, 1)
+            normal.add_data3(0, 0, 1)
+            for r in range(1, num_rings):
+                theta = pi * r / num_rings
+                for s in range(num_segments):
+                    phi = pi * 2 * s / num_segments
+                    point = (sin(theta) * cos(phi), sin(theta) * sin(phi), cos(theta))
+                    vertex.add_data3(point)
+                    normal.add_data3(point)
+            vertex.add_data3(0, 0, -1)
+            normal.add_data3(0, 0, -1)
+
+            bottom = (num_rings - 1) * num_segments + 1
+            for s in range(num_segments):
+                s1 = (s + 1) % num_segments
+                tris.add_vertices(0, 1 + s, 1 + s1)
+                for r in range(1, num_rings - 1):
+                    a = 1 + (r - 1) * num_segments
+                    c = a + num_segments
+                    tris.add_vertices(a + s, c + s, c + s1)
+                    tris.add_vertices(a + s, c + s1, a + s1)
+                a = 1 + (num_rings - 2) * num_segments
+                tris.add_vertices(a + s, bottom, a + s1)
+
+        geom = Geom(vdata)
+        geom.add_primitive(tris)
+        return geom
+
+    return make_sphere
+
+
 # C++ test suite integration.  Collects tests/<package>/test_*.cxx files and
 # exposes each Catch2 TEST_CASE in the run_cxx_tests binary as a pytest item
 # anchored to its source file, so that directory and file selection, -k
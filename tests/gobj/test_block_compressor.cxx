@@ -0,0 +1,494 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file test_block_compressor.cxx
+ * @author rdb
+ * @date 2026-10-17
+ */
+
+#include "blockCompressor.h"
+#include "texture.h"
+#include "config_gobj.h"
+
+#include "catch_amalgamated.hpp"
+
+#include <cmath>
+#include <cstring>
+
+/**
+ * Fills a block with a slightly noisy gradient between two colors, which is
+ * the kind of block that the single-line formats can represent well.
+ */
+static void
+make_gradient_block(unsigned char rgba[64]) {
+  for (int i = 0; i < 16; ++i) {
+    int noise = (i * 7) & 3;
+    rgba[i * 4 + 0] = (unsigned char)(40 + i * 6 + noise);
+    rgba[i * 4 + 1] = (unsigned char)(200 - i * 5 - noise);
+    rgba[i * 4 + 2] = (unsigned char)(90 + i * 3);
+    rgba[i * 4 + 3] = (unsigned char)(255 - i * 10);
+  }
+}
+
+/**
+ * Returns the largest difference between the given channels of two blocks.
+ */
+static int
+max_block_error(const unsigned char *a, const unsigned char *b,
+                int first_channel, int num_channels) {
+  int max_error = 0;
+  for (int i = 0; i < 16; ++i) {
+    for (int c = first_channel; c < first_channel + num_channels; ++c) {
+      max_error = std::max(max_error, std::abs((int)a[i * 4 + c] - (int)b[i * 4 + c]));
+    }
+  }
+  return max_error;
+}
+
+TEST_CASE("BlockCompressor round-trips LDR blocks", "[gobj]") {
+  Texture::QualityLevel quality = GENERATE(Texture::QL_fastest, Texture::QL_normal, Texture::QL_best);
+  CAPTURE(quality);
+
+  unsigned char rgba[64];
+  make_gradient_block(rgba);
+
+  unsigned char block[16];
+  unsigned char result[64];
+
+  SECTION("BC1") {
+    // Transparency is tested separately.
+    for (int i = 0; i < 16; ++i) {
+      rgba[i * 4 + 3] = 255;
+    }
+    BlockCompressor::compress_block(BlockCompressor::BF_bc1, rgba, block, quality);
+    REQUIRE(BlockCompressor::decompress_block(BlockCompressor::BF_bc1, block, result));
+    CHECK(max_block_error(rgba, result, 0, 3) <= 16);
+  }
+
+  SECTION("BC2") {
+    BlockCompressor::compress_block(BlockCompressor::BF_bc2, rgba, block, quality);
+    REQUIRE(BlockCompressor::decompress_block(BlockCompressor::BF_bc2, block, result));
+    CHECK(max_block_error(rgba, result, 0, 3) <= 16);
+    CHECK(max_block_error(rgba, result, 3, 1) <= 8);
+  }
+
+  SECTION("BC3") {
+    BlockCompressor::compress_block(BlockCompressor::BF_bc3, rgba, block, quality);
+    REQUIRE(BlockCompressor::decompress_block(BlockCompressor::BF_bc3, block, result));
+    CHECK(max_block_error(rgba, result, 0, 3) <= 16);
+    CHECK(max_block_error(rgba, result, 3, 1) <= 12);
+  }
+
+  SECTION("BC4") {
+    BlockCompressor::compress_block(BlockCompressor::BF_bc4, rgba, block, quality);
+    REQUIRE(BlockCompressor::decompress_block(BlockCompressor::BF_bc4, block, result));
+    CHECK(max_block_error(rgba, result, 0, 1) <= 6);
+  }
+
+  SECTION("BC5") {
+    BlockCompressor::compress_block(BlockCompressor::BF_bc5, rgba, block, quality);
+    REQUIRE(BlockCompressor::decompress_block(BlockCompressor::BF_bc5, block, result));
+    CHECK(max_block_error(rgba, result, 0, 2) <= 6);
+  }
+
+  SECTION("BC7") {
+    BlockCompressor::compress_block(BlockCompressor::BF_bc7, rgba, block, quality);
+    REQUIRE(BlockCompressor::decompress_block(BlockCompressor::BF_bc7, block, result));
+    CHECK(max_block_error(rgba, result, 0, 4) <= 12);
+  }
+}
+
+TEST_CASE("BlockCompressor encodes solid blocks exactly", "[gobj]") {
+  unsigned char rgba[64];
+  for (int i = 0; i < 16; ++i) {
+    rgba[i * 4 + 0] = 255;
+    rgba[i * 4 + 1] = 0;
+    rgba[i * 4 + 2] = 255;
+    rgba[i * 4 + 3] = 128;
+  }
+
+  unsigned char block[16];
+  unsigned char result[64];
+  BlockCompressor::compress_block(BlockCompressor::BF_bc3, rgba, block, Texture::QL_normal);
+  REQUIRE(BlockCompressor::decompress_block(BlockCompressor::BF_bc3, block, result));
+  CHECK(max_block_error(rgba, result, 0, 4) == 0);
+
+  BlockCompressor::compress_block(BlockCompressor::BF_bc7, rgba, block, Texture::QL_normal);
+  REQUIRE(BlockCompressor::decompress_block(BlockCompressor::BF_bc7, block, result));
+  CHECK(max_block_error(rgba, result, 0, 4) <= 1);
+}
+
+TEST_CASE("BlockCompressor keeps BC1 transparency", "[gobj]") {
+  unsigned char rgba[64];
+  make_gradient_block(rgba);
+  rgba[3] = 0;
+  rgba[7 * 4 + 3] = 0;
+  for (int i = 0; i < 16; ++i) {
+    if (i != 0 && i != 7) {
+      rgba[i * 4 + 3] = 255;
+    }
+  }
+
+  unsigned char block[8];
+  unsigned char result[64];
+  BlockCompressor::compress_block(BlockCompressor::BF_bc1, rgba, block, Texture::QL_normal);
+  REQUIRE(BlockCompressor::decompress_block(BlockCompressor::BF_bc1, block, result));
+  for (int i = 0; i < 16; ++i) {
+    CAPTURE(i);
+    CHECK(result[i * 4 + 3] == rgba[i * 4 + 3]);
+  }
+}
+
+TEST_CASE("BlockCompressor round-trips HDR blocks", "[gobj]") {
+  uint16_t rgb[48];
+  for (int i = 0; i < 16; ++i) {
+    rgb[i * 3 + 0] = BlockCompressor::float_to_half(0.5f * powf(1.15f, (float)i));
+    rgb[i * 3 + 1] = BlockCompressor::float_to_half(4.0f * powf(0.95f, (float)i));
+    rgb[i * 3 + 2] = BlockCompressor::float_to_half(1.0f * powf(1.05f, (float)i));
+  }
+
+  unsigned char block[16];
+  BlockCompressor::compress_block_bc6h(rgb, block, Texture::QL_best);
+
+  uint16_t result[48];
+  REQUIRE(BlockCompressor::decompress_block_bc6h(block, result));
+  for (int i = 0; i < 48; ++i) {
+    CAPTURE(i);
+    float expected = BlockCompressor::half_to_float(rgb[i]);
+    float actual = BlockCompressor::half_to_float(result[i]);
+    CHECK(std::fabs(actual - expected) <= expected * 0.1f + 0.05f);
+  }
+}
+
+TEST_CASE("BlockCompressor converts half-floats", "[gobj]") {
+  CHECK(BlockCompressor::float_to_half(0.0f) == 0x0000);
+  CHECK(BlockCompressor::float_to_half(1.0f) == 0x3c00);
+  CHECK(BlockCompressor::float_to_half(-2.0f) == 0xc000);
+  CHECK(BlockCompressor::float_to_half(65504.0f) == 0x7bff);
+  CHECK(BlockCompressor::float_to_half(1.0e6f) == 0x7c00);
+
+  CHECK(BlockCompressor::half_to_float(0x3c00) == 1.0f);
+  CHECK(BlockCompressor::half_to_float(0x3555) == Catch::Approx(0.333251953f));
+  CHECK(BlockCompressor::half_to_float(0x0001) == Catch::Approx(5.96046448e-8f));
+
+  for (float value : {0.1f, 0.5f, 3.75f, 1000.0f}) {
+    CAPTURE(value);
+    float result = BlockCompressor::half_to_float(BlockCompressor::float_to_half(value));
+    CHECK(result == Catch::Approx(value).epsilon(0.001));
+  }
+
+  // Denormals have a fixed absolute precision.
+  float denormal = BlockCompressor::half_to_float(BlockCompressor::float_to_half(1.0e-5f));
+  CHECK(denormal == Catch::Approx(1.0e-5f).margin(3.0e-8f));
+}
+
+/**
+ * Writes the fields of a hand-made block, starting at the least significant
+ * bit of the first byte.  The remaining bits are left 0.
+ */
+class TestBitWriter {
+public:
+  TestBitWriter(unsigned char *dest) : _dest(dest), _pos(0) {
+    memset(dest, 0, 16);
+  }
+
+  void write(unsigned int value, int num_bits) {
+    for (int i = 0; i < num_bits; ++i, ++_pos) {
+      if (value & (1u << i)) {
+        _dest[_pos >> 3] |= (unsigned char)(1u << (_pos & 7));
+      }
+    }
+  }
+
+  void skip_to(int pos) {
+    _pos = pos;
+  }
+
+private:
+  unsigned char *_dest;
+  int _pos;
+};
+
+/**
+ * Expands an endpoint value with the indicated number of bits to 8 bits, the
+ * way BC7 does.
+ */
+static int
+bc7_expand(int value, int num_bits) {
+  value <<= (8 - num_bits);
+  return value | (value >> num_bits);
+}
+
+TEST_CASE("BlockCompressor decodes all BC7 modes", "[gobj]") {
+  // The subsets, color bits, alpha bits and the kind of extra low bits (none,
+  // one per endpoint or one per subset) of each mode, and the number of
+  // partition bits, rotation bits and index selection bits.
+  struct Mode {
+    int num_subsets, color_bits, alpha_bits, pbits;
+    int partition_bits, rotation_bits, index_selection_bits;
+  };
+  static const Mode modes[8] = {
+    {3, 4, 0, 1, 4, 0, 0},
+    {2, 6, 0, 2, 6, 0, 0},
+    {3, 5, 0, 0, 6, 0, 0},
+    {2, 7, 0, 1, 6, 0, 0},
+    {1, 5, 6, 0, 0, 2, 1},
+    {1, 7, 8, 0, 0, 2, 0},
+    {1, 7, 7, 1, 0, 0, 0},
+    {2, 5, 5, 1, 6, 0, 0},
+  };
+
+  // The subset of each pixel in partition 0, with two and with three subsets.
+  static const int subsets2[16] = {0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1};
+  static const int subsets3[16] = {0, 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 1, 2, 2, 2, 2};
+
+  int mode_index = GENERATE(range(0, 8));
+  CAPTURE(mode_index);
+  const Mode &mode = modes[mode_index];
+
+  // Give both endpoints of each subset the same color, so that the block is
+  // solid within each subset regardless of the indices, which are all 0.
+  int values[3][4];
+  int expected[3][4];
+  for (int s = 0; s < mode.num_subsets; ++s) {
+    for (int c = 0; c < 4; ++c) {
+      int num_bits = (c < 3) ? mode.color_bits : mode.alpha_bits;
+      values[s][c] = (s * 37 + c * 11 + 5) & ((1 << num_bits) - 1);
+      if (num_bits == 0) {
+        expected[s][c] = 255;
+      } else if (mode.pbits != 0) {
+        expected[s][c] = bc7_expand(values[s][c] * 2 + 1, num_bits + 1);
+      } else {
+        expected[s][c] = bc7_expand(values[s][c], num_bits);
+      }
+    }
+  }
+
+  unsigned char block[16];
+  TestBitWriter writer(block);
+  writer.write(1 << mode_index, mode_index + 1);
+  writer.write(0, mode.partition_bits + mode.rotation_bits + mode.index_selection_bits);
+  for (int c = 0; c < 4; ++c) {
+    int num_bits = (c < 3) ? mode.color_bits : mode.alpha_bits;
+    for (int s = 0; s < mode.num_subsets; ++s) {
+      writer.write(values[s][c], num_bits);
+      writer.write(values[s][c], num_bits);
+    }
+  }
+  if (mode.pbits == 1) {
+    writer.write(0xff, mode.num_subsets * 2);
+  } else if (mode.pbits == 2) {
+    writer.write(0xff, mode.num_subsets);
+  }
+
+  unsigned char result[64];
+  REQUIRE(BlockCompressor::decompress_block(BlockCompressor::BF_bc7, block, result));
+  for (int i = 0; i < 16; ++i) {
+    int s = (mode.num_subsets == 3) ? subsets3[i] : (mode.num_subsets == 2) ? subsets2[i] : 0;
+    for (int c = 0; c < 4; ++c) {
+      CAPTURE(i, c);
+      CHECK((int)result[i * 4 + c] == expected[s][c]);
+    }
+  }
+
+  if (mode_index == 5) {
+    // Rotation 1 swaps the red channel with the alpha channel.
+    block[0] |= 1 << 6;
+    REQUIRE(BlockCompressor::decompress_block(BlockCompressor::BF_bc7, block, result));
+    CHECK((int)result[0] == expected[0][3]);
+    CHECK((int)result[3] == expected[0][0]);
+  }
+}
+
+TEST_CASE("BlockCompressor interpolates partitioned BC7 blocks", "[gobj]") {
+  // Mode 3, partition 0, with a gray ramp for the first subset and a ramp
+  // from red to green for the second.  The anchors are pixel 0 and 15, whose
+  // indices are stored with one bit less.
+  static const int ends[2][2][3] = {
+    {{0x00, 0x00, 0x00}, {0x7f, 0x7f, 0x7f}},
+    {{0x7f, 0x00, 0x00}, {0x00, 0x7f, 0x00}},
+  };
+  static const int weights[4] = {0, 21, 43, 64};
+  static const int subsets[16] = {0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1};
+  int indices[16];
+  for (int i = 0; i < 16; ++i) {
+    indices[i] = (i == 15) ? 1 : (i & 3);
+  }
+
+  unsigned char block[16];
+  TestBitWriter writer(block);
+  writer.write(1 << 3, 4);
+  writer.write(0, 6);
+  for (int c = 0; c < 3; ++c) {
+    for (int s = 0; s < 2; ++s) {
+      writer.write(ends[s][0][c], 7);
+      writer.write(ends[s][1][c], 7);
+    }
+  }
+  writer.write(0x5, 4);
+  for (int i = 0; i < 16; ++i) {
+    writer.write(indices[i], (i == 0 || i == 15) ? 1 : 2);
+  }
+
+  unsigned char result[64];
+  REQUIRE(BlockCompressor::decompress_block(BlockCompressor::BF_bc7, block, result));
+  for (int i = 0; i < 16; ++i) {
+    int s = subsets[i];
+    int w = weights[indices[i]];
+    for (int c = 0; c < 3; ++c) {
+      CAPTURE(i, c);
+      // The first endpoint of each subset has its extra low bit set.
+      int e0 = ends[s][0][c] * 2 + 1;
+      int e1 = ends[s][1][c] * 2;
+      CHECK((int)result[i * 4 + c] == ((e0 * (64 - w) + e1 * w + 32) >> 6));
+    }
+    CHECK((int)result[i * 4 + 3] == 255);
+  }
+
+  // Mode 8 is reserved.
+  memset(block, 0, 16);
+  CHECK_FALSE(BlockCompressor::decompress_block(BlockCompressor::BF_bc7, block, result));
+}
+
+TEST_CASE("BlockCompressor picks BC7 mode 5 for separate alpha", "[gobj]") {
+  // Four shades of gray, with alpha values that do not follow them, which
+  // does not fit on a single line through RGBA space.
+  unsigned char rgba[64];
+  for (int i = 0; i < 16; ++i) {
+    rgba[i * 4 + 0] = rgba[i * 4 + 1] = rgba[i * 4 + 2] = (unsigned char)((i >> 2) * 60);
+    rgba[i * 4 + 3] = (unsigned char)(((i * 5) & 3) * 85);
+  }
+
+  Texture::QualityLevel quality = GENERATE(Texture::QL_normal, Texture::QL_best);
+  CAPTURE(quality);
+
+  unsigned char block[16];
+  unsigned char result[64];
+  BlockCompressor::compress_block(BlockCompressor::BF_bc7, rgba, block, quality);
+  CHECK((block[0] & 0x3f) == 0x20);
+  REQUIRE(BlockCompressor::decompress_block(BlockCompressor::BF_bc7, block, result));
+  CHECK(max_block_error(rgba, result, 0, 4) <= 3);
+
+  // An opaque block is encoded in mode 6, unless the best quality is asked.
+  for (int i = 0; i < 16; ++i) {
+    rgba[i * 4 + 3] = 255;
+  }
+  BlockCompressor::compress_block(BlockCompressor::BF_bc7, rgba, block, Texture::QL_normal);
+  CHECK((block[0] & 0x7f) == 0x40);
+}
+
+/**
+ * Returns the half-float that an unsigned BC6H endpoint with the indicated
+ * number of bits decodes to.
+ */
+static uint16_t
+bc6h_expected(int value, int num_bits) {
+  int max_value = (1 << num_bits) - 1;
+  int unq = (value == 0) ? 0 : (value == max_value) ? 0xffff : ((value << 16) + 0x8000) >> num_bits;
+  return (uint16_t)((unq * 31) >> 6);
+}
+
+TEST_CASE("BlockCompressor decodes all BC6H modes", "[gobj]") {
+  // Each mode decodes an all-zero block as black, and the reserved modes are
+  // rejected.
+  static const unsigned int valid_modes[14] = {
+    0x00, 0x01, 0x02, 0x06, 0x0a, 0x0e, 0x12, 0x16, 0x1a, 0x1e,
+    0x03, 0x07, 0x0b, 0x0f,
+  };
+  unsigned char block[16];
+  uint16_t result[48];
+  for (unsigned int mode : valid_modes) {
+    CAPTURE(mode);
+    TestBitWriter writer(block);
+    writer.write(mode, (mode < 2) ? 2 : 5);
+    REQUIRE(BlockCompressor::decompress_block_bc6h(block, result));
+    for (int i = 0; i < 48; ++i) {
+      CHECK(result[i] == 0);
+    }
+  }
+  for (unsigned int mode : {0x13, 0x17, 0x1b, 0x1f}) {
+    CAPTURE(mode);
+    TestBitWriter writer(block);
+    writer.write(mode, 5);
+    CHECK_FALSE(BlockCompressor::decompress_block_bc6h(block, result));
+  }
+
+  SECTION("mode 1") {
+    // Two subsets in partition 0, with 10-bit base endpoints, and 5-bit
+    // deltas for the others.  The indices are all 0, so each pixel takes the
+    // first endpoint of its subset.
+    TestBitWriter writer(block);
+    writer.write(0x00, 2);
+    writer.skip_to(5);
+    writer.write(100, 10);  // rw
+    writer.write(200, 10);  // gw
+    writer.write(300, 10);  // bw
+    writer.skip_to(41);
+    writer.write(5, 4);     // gy[3:0]
+    writer.skip_to(65);
+    writer.write(0x1d, 5);  // ry = -3
+
+    REQUIRE(BlockCompressor::decompress_block_bc6h(block, result));
+    for (int i = 0; i < 16; ++i) {
+      CAPTURE(i);
+      if (i & 2) {
+        CHECK(result[i * 3 + 0] == bc6h_expected(97, 10));
+        CHECK(result[i * 3 + 1] == bc6h_expected(205, 10));
+      } else {
+        CHECK(result[i * 3 + 0] == bc6h_expected(100, 10));
+        CHECK(result[i * 3 + 1] == bc6h_expected(200, 10));
+      }
+      CHECK(result[i * 3 + 2] == bc6h_expected(300, 10));
+    }
+  }
+
+  SECTION("signed mode 11") {
+    // The same bits mean something else for the signed variant.
+    TestBitWriter writer(block);
+    writer.write(0x03, 5);
+    writer.write(0x3ff, 10);  // rw
+    writer.write(0x001, 10);  // gw
+
+    REQUIRE(BlockCompressor::decompress_block_bc6h(block, result));
+    CHECK(result[0] == 0x7bff);
+    CHECK(result[1] == bc6h_expected(1, 10));
+
+    REQUIRE(BlockCompressor::decompress_block_bc6h(block, result, true));
+    CHECK(BlockCompressor::half_to_float(result[0]) < 0.0f);
+    CHECK(BlockCompressor::half_to_float(result[1]) > 0.0f);
+    CHECK(result[0] == (result[1] | 0x8000));
+    CHECK(result[2] == 0);
+  }
+}
+
+// This measures the cost of compressing a large texture.  Run it explicitly
+// with: run_cxx_tests "[benchmark]"
+TEST_CASE("Texture compression", "[.][benchmark][gobj]") {
+  PT(Texture) tex = new Texture("benchmark");
+  tex->setup_2d_texture(1024, 1024, Texture::T_unsigned_byte, Texture::F_rgba);
+  tex->set_minfilter(SamplerState::FT_linear);
+  PTA_uchar image = tex->modify_ram_image();
+  for (size_t i = 0; i < image.size(); ++i) {
+    image[i] = (unsigned char)((i * 7 + (i >> 12) * 13) & 0xff);
+  }
+  CPTA_uchar original = tex->get_ram_image();
+
+  for (Texture::CompressionMode compression : {Texture::CM_dxt1, Texture::CM_dxt5, Texture::CM_bptc}) {
+    for (int num_threads : {0, 4}) {
+      std::ostringstream name;
+      name << compression << " with " << num_threads << " threads";
+      BENCHMARK(name.str()) {
+        texture_compress_num_threads = num_threads;
+        tex->set_ram_image(original);
+        return tex->compress_ram_image(compression, Texture::QL_normal);
+      };
+    }
+  }
+
+  texture_compress_num_threads.clear_local_value();
+}
@@ -0,0 +1,144 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file test_cpu_skinning.cxx
+ * @author rdb
+ * @date 2026-10-17
+ */
+
+#include "geomVertexData.h"
+#include "geomVertexReader.h"
+#include "geomVertexWriter.h"
+#include "transformBlendTable.h"
+#include "userVertexTransform.h"
+#include "config_gobj.h"
+
+#include "catch_amalgamated.hpp"
+
+/**
+ * Makes an animated vertex data with the indicated number of rows, a vertex,
+ * normal and texcoord column, and blend indices of the indicated type, with
+ * each row assigned to one of the blends in the table.
+ */
+static PT(GeomVertexData)
+make_skinned_data(int num_rows, GeomEnums::NumericType blend_type,
+                  UserVertexTransform *t0, UserVertexTransform *t1) {
+  PT(GeomVertexArrayFormat) array = new GeomVertexArrayFormat;
+  array->add_column(InternalName::get_vertex(), 3, GeomEnums::NT_float32, GeomEnums::C_point);
+  array->add_column(InternalName::get_normal(), 3, GeomEnums::NT_float32, GeomEnums::C_normal);
+  array->add_column(InternalName::get_texcoord(), 2, GeomEnums::NT_float32, GeomEnums::C_texcoord);
+
+  PT(GeomVertexArrayFormat) blend_array = new GeomVertexArrayFormat;
+  blend_array->add_column(InternalName::get_transform_blend(), 1, blend_type, GeomEnums::C_index);
+
+  PT(GeomVertexFormat) format = new GeomVertexFormat(array);
+  format->add_array(blend_array);
+  GeomVertexAnimationSpec animation;
+  animation.set_panda();
+  format->set_animation(animation);
+
+  PT(TransformBlendTable) table = new TransformBlendTable;
+  table->add_blend(TransformBlend(t0, 1));
+  table->add_blend(TransformBlend(t1, 1));
+  table->add_blend(TransformBlend(t0, 0.25f, t1, 0.75f));
+  table->set_rows(SparseArray::range(0, num_rows));
+
+  PT(GeomVertexData) vdata = new GeomVertexData
+    ("skinned", GeomVertexFormat::register_format(format), GeomEnums::UH_static);
+  vdata->set_transform_blend_table(table);
+  vdata->unclean_set_num_rows(num_rows);
+
+  GeomVertexWriter vertex(vdata, InternalName::get_vertex());
+  GeomVertexWriter normal(vdata, InternalName::get_normal());
+  GeomVertexWriter texcoord(vdata, InternalName::get_texcoord());
+  GeomVertexWriter blend(vdata, InternalName::get_transform_blend());
+  for (int i = 0; i < num_rows; ++i) {
+    vertex.set_data3(i * 0.1f, 1, -i * 0.2f);
+    normal.set_data3(normalize(LVector3(1, i % 7, 2)));
+    texcoord.set_data2(i, 0.5f);
+    blend.set_data1i((i / 5) % 3);
+  }
+  return vdata;
+}
+
+/**
+ * Returns the animated vertices computed by either the general or the fast
+ * skinning path.
+ */
+static CPT(GeomVertexData)
+animate(const GeomVertexData *vdata, bool fast, int num_threads = 0) {
+  cpu_skinning_fast_path = fast;
+  cpu_skinning_num_threads = num_threads;
+  ((GeomVertexData *)vdata)->clear_animated_vertices();
+  CPT(GeomVertexData) result = vdata->animate_vertices(true, Thread::get_current_thread());
+  cpu_skinning_fast_path.clear_local_value();
+  cpu_skinning_num_threads.clear_local_value();
+  return result;
+}
+
+/**
+ * Checks that the indicated column has the same values in both vertex datas.
+ */
+static void
+check_column(const GeomVertexData *a, const GeomVertexData *b,
+             const InternalName *name) {
+  REQUIRE(a->get_num_rows() == b->get_num_rows());
+  GeomVertexReader ra(a, name);
+  GeomVertexReader rb(b, name);
+  for (int i = 0; i < a->get_num_rows(); ++i) {
+    LVecBase3 va = ra.get_data3();
+    LVecBase3 vb = rb.get_data3();
+    if (!va.almost_equal(vb, 1.0e-4f)) {
+      CAPTURE(name->get_name(), i, va, vb);
+      FAIL_CHECK("animated values differ");
+      return;
+    }
+  }
+}
+
+TEST_CASE("Fast CPU skinning with threads", "[gobj]") {
+  PT(UserVertexTransform) t0 = new UserVertexTransform("t0");
+  PT(UserVertexTransform) t1 = new UserVertexTransform("t1");
+  t0->set_matrix(LMatrix4::rotate_mat(60, LVector3::forward()));
+  t1->set_matrix(LMatrix4::translate_mat(5, 0, 0));
+
+  PT(GeomVertexData) vdata = make_skinned_data(20000, GeomEnums::NT_uint16, t0, t1);
+  CPT(GeomVertexData) serial = animate(vdata, true, 0);
+  CPT(GeomVertexData) parallel = animate(vdata, true, 4);
+  REQUIRE(parallel != serial);
+  check_column(parallel, serial, InternalName::get_vertex());
+  check_column(parallel, serial, InternalName::get_normal());
+}
+
+// This measures the cost of animating the vertices of a character.  Run it
+// explicitly with: run_cxx_tests "[benchmark]"
+TEST_CASE("CPU skinning", "[.][benchmark][gobj]") {
+  PT(UserVertexTransform) t0 = new UserVertexTransform("t0");
+  PT(UserVertexTransform) t1 = new UserVertexTransform("t1");
+  PT(GeomVertexData) vdata = make_skinned_data(20000, GeomEnums::NT_uint16, t0, t1);
+
+  int frame = 0;
+  auto run = [&] (bool fast, int num_threads) {
+    cpu_skinning_fast_path = fast;
+    cpu_skinning_num_threads = num_threads;
+    t0->set_matrix(LMatrix4::rotate_mat(++frame, LVector3::up()));
+    return vdata->animate_vertices(true, Thread::get_current_thread());
+  };
+
+  BENCHMARK("general path") {
+    return run(false, 0);
+  };
+  for (int num_threads : {0, 2, 4}) {
+    BENCHMARK("fast path with " + std::to_string(num_threads) + " threads") {
+      return run(true, num_threads);
+    };
+  }
+
+  cpu_skinning_fast_path.clear_local_value();
+  cpu_skinning_num_threads.clear_local_value();
+}
@@ -0,0 +1,119 @@
+from panda3d.core import GeomVertexData, GeomVertexFormat, GeomVertexArrayFormat
+from panda3d.core import GeomVertexAnimationSpec, GeomVertexReader, GeomVertexWriter
+from panda3d.core import TransformBlendTable, TransformBlend, UserVertexTransform
+from panda3d.core import Geom, InternalName, SparseArray, LMatrix4, LVector3, Thread
+from panda3d.core import load_prc_file_data, unload_prc_file
+from contextlib import contextmanager
+import pytest
+
+
+@contextmanager
+def prc(data):
+    page = load_prc_file_data("test_cpu_skinning", data)
+    try:
+        yield
+    finally:
+        unload_prc_file(page)
+
+
+def make_skinned_data(num_rows, blend_type, t0, t1):
+    # Makes an animated vertex data with a vertex, normal and texcoord column,
+    # and blend indices of the indicated type, with each row assigned to one of
+    # the blends in the table.
+    array = GeomVertexArrayFormat()
+    array.add_column(InternalName.get_vertex(), 3, Geom.NT_float32, Geom.C_point)
+    array.add_column(InternalName.get_normal(), 3, Geom.NT_float32, Geom.C_normal)
+    array.add_column(InternalName.get_texcoord(), 2, Geom.NT_float32, Geom.C_texcoord)
+
+    blend_array = GeomVertexArrayFormat()
+    blend_array.add_column(InternalName.get_transform_blend(), 1, blend_type, Geom.C_index)
+
+    format = GeomVertexFormat(array)
+    format.add_array(blend_array)
+    animation = GeomVertexAnimationSpec()
+    animation.set_panda()
+    format.set_animation(animation)
+
+    table = TransformBlendTable()
+    table.add_blend(TransformBlend(t0, 1))
+    table.add_blend(TransformBlend(t1, 1))
+    table.add_blend(TransformBlend(t0, 0.25, t1, 0.75))
+    table.set_rows(SparseArray.range(0, num_rows))
+
+    vdata = GeomVertexData("skinned", GeomVertexFormat.register_format(format), Geom.UH_static)
+    vdata.set_transform_blend_table(table)
+    vdata.unclean_set_num_rows(num_rows)
+
+    vertex = GeomVertexWriter(vdata, InternalName.get_vertex())
+    normal = GeomVertexWriter(vdata, InternalName.get_normal())
+    texcoord = GeomVertexWriter(vdata, InternalName.get_texcoord())
+    blend = GeomVertexWriter(vdata, InternalName.get_transform_blend())
+    for i in range(num_rows):
+        vertex.set_data3(i * 0.1, 1, -i * 0.2)
+        normal.set_data3(LVector3(1, i % 7, 2).normalized())
+        texcoord.set_data2(i, 0.5)
+        blend.set_data1i((i // 5) % 3)
+    return vdata
+
+
+def animate(vdata, fast):
+    # Returns the animated vertices computed by either the general or the fast
+    # skinning path.
+    with prc("cpu-skinning-fast-path " + ("true" if fast else "false")):
+        vdata.clear_animated_vertices()
+        return vdata.animate_vertices(True, Thread.get_current_thread())
+
+
+def check_column(a, b, name):
+    assert a.get_num_rows() == b.get_num_rows()
+    reader_a = GeomVertexReader(a, name)
+    reader_b = GeomVertexReader(b, name)
+    for i in range(a.get_num_rows()):
+        value_a = reader_a.get_data3()
+        value_b = reader_b.get_data3()
+        assert value_a.almost_equal(value_b, 1e-4), (name, i)
+
+
+@pytest.mark.parametrize("blend_type", [Geom.NT_uint8, Geom.NT_uint16])
+@pytest.mark.parametrize("t1_matrix", [
+    LMatrix4.scale_mat(2) * LMatrix4.translate_mat(0, -1, 0),
+    LMatrix4.scale_mat(1, 3, 0.5) * LMatrix4.rotate_mat(45, LVector3.right()),
+], ids=["uniform scale", "non-uniform scale"])
+def test_cpu_skinning_fast_path(blend_type, t1_matrix):
+    t0 = UserVertexTransform("t0")
+    t1 = UserVertexTransform("t1")
+    t0.set_matrix(LMatrix4.translate_mat(1, 2, 3) * LMatrix4.rotate_mat(30, LVector3.up()))
+    t1.set_matrix(t1_matrix)
+    vdata = make_skinned_data(500, blend_type, t0, t1)
+
+    slow = animate(vdata, False)
+    fast = animate(vdata, True)
+    assert fast.get_format() == slow.get_format()
+    check_column(fast, slow, InternalName.get_vertex())
+    check_column(fast, slow, InternalName.get_normal())
+    check_column(fast, slow, InternalName.get_texcoord())
+
+
+def test_cpu_skinning_source_changes():
+    t0 = UserVertexTransform("t0")
+    t1 = UserVertexTransform("t1")
+    vdata = make_skinned_data(100, Geom.NT_uint16, t0, t1)
+    thread = Thread.get_current_thread()
+
+    with prc("cpu-skinning-fast-path true"):
+        animated = vdata.animate_vertices(True, thread)
+        assert GeomVertexReader(animated, InternalName.get_vertex()).get_data3() == (0, 1, 0)
+
+        # Only the transforms change; the vertex data is reused.
+        t0.set_matrix(LMatrix4.translate_mat(0, 0, 10))
+        animated2 = vdata.animate_vertices(True, thread)
+        assert animated2 == animated
+        assert GeomVertexReader(animated2, InternalName.get_vertex()).get_data3() == (0, 1, 10)
+        assert GeomVertexReader(animated2, InternalName.get_texcoord()).get_data2() == (0, 0.5)
+
+        # Modifying an unanimated column in the source is reflected as well.
+        GeomVertexWriter(vdata, InternalName.get_texcoord()).set_data2(7, 8)
+        t0.set_matrix(LMatrix4.translate_mat(0, 0, 20))
+        animated3 = vdata.animate_vertices(True, thread)
+        assert GeomVertexReader(animated3, InternalName.get_vertex()).get_data3() == (0, 1, 20)
+        assert GeomVertexReader(animated3, InternalName.get_texcoord()).get_data2() == (7, 8)
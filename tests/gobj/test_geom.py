@@ -1,4 +1,7 @@
 from panda3d import core
+from math import sin, cos
+import random
+import pytest
 
 empty_format = core.GeomVertexFormat.get_empty()
 
@@ -82,3 +85,160 @@ def test_geom_calc_box_bounds():
     assert isinstance(bounds, core.BoundingBox)
     assert bounds.get_min() == (1, 1, 1)
     assert bounds.get_max() == (1, 1, 2)
+
+
+def make_shuffled_grid(size):
+    # Makes a grid of size x size quads, whose triangles are listed in a random
+    # order, to simulate a badly ordered mesh.
+    data = core.GeomVertexData("grid", core.GeomVertexFormat.get_v3n3(), core.Geom.UH_static)
+    vertex = core.GeomVertexWriter(data, "vertex")
+    normal = core.GeomVertexWriter(data, "normal")
+    for y in range(size + 1):
+        for x in range(size + 1):
+            vertex.add_data3(x, y, sin(x * 0.3) + cos(y * 0.2))
+            normal.add_data3(0, 0, 1)
+
+    triangles = []
+    for y in range(size):
+        for x in range(size):
+            v = y * (size + 1) + x
+            triangles.append((v, v + 1, v + size + 2))
+            triangles.append((v, v + size + 2, v + size + 1))
+    random.Random(42).shuffle(triangles)
+
+    prim = core.GeomTriangles(core.Geom.UH_static)
+    for triangle in triangles:
+        prim.add_vertices(*triangle)
+
+    geom = core.Geom(data)
+    geom.add_primitive(prim)
+    return geom
+
+
+def get_sorted_triangles(geom):
+    # Returns the triangles as a sorted list of vertex positions, each rotated
+    # to start with its smallest vertex, so that they can be compared
+    # regardless of the order of the triangles and vertices.
+    prim = geom.get_primitive(0)
+    vertex = core.GeomVertexReader(geom.get_vertex_data(), "vertex")
+    triangles = []
+    for i in range(0, prim.get_num_vertices(), 3):
+        points = []
+        for j in range(3):
+            vertex.set_row(prim.get_vertex(i + j))
+            points.append(tuple(vertex.get_data3()))
+        first = points.index(min(points))
+        triangles.append(tuple(points[first:] + points[:first]))
+    return sorted(triangles)
+
+
+@pytest.mark.parametrize("reorder_vertices", [False, True])
+def test_geom_optimize_vertex_cache(reorder_vertices):
+    geom = make_shuffled_grid(64)
+    orig_triangles = get_sorted_triangles(geom)
+    orig_acmr = geom.calc_acmr()
+    assert orig_acmr > 1.5
+
+    orig_data = geom.get_vertex_data()
+    orig_modified = geom.get_modified()
+    geom.optimize_vertex_cache_in_place(reorder_vertices)
+
+    assert geom.get_modified() != orig_modified
+    assert geom.get_num_primitives() == 1
+    assert geom.get_primitive(0).get_num_primitives() == 64 * 64 * 2
+    assert (geom.get_vertex_data() != orig_data) == reorder_vertices
+    assert geom.calc_acmr() < 1.0
+
+    # The same triangles, facing the same way, are still there.
+    assert get_sorted_triangles(geom) == orig_triangles
+
+    if reorder_vertices:
+        # The vertices are now stored in the order in which they are used.
+        next_vertex = 0
+        for vertex in geom.get_primitive(0).get_vertex_list():
+            assert vertex <= next_vertex
+            if vertex == next_vertex:
+                next_vertex += 1
+        assert next_vertex == geom.get_vertex_data().get_num_rows()
+
+
+def test_geom_optimize_vertex_cache_strips():
+    geom = make_shuffled_grid(4)
+    strips = core.GeomTristrips(core.Geom.UH_static)
+    for y in range(4):
+        for x in range(5):
+            strips.add_vertex((y + 1) * 5 + x)
+            strips.add_vertex(y * 5 + x)
+        strips.close_primitive()
+    geom.set_primitive(0, strips)
+    prim = geom.get_primitive(0)
+    orig_modified = geom.get_modified()
+
+    # Strips are left alone.
+    geom.optimize_vertex_cache_in_place(False)
+    assert geom.get_primitive(0) == prim
+    assert geom.get_modified() == orig_modified
+
+    # They are still counted towards the ACMR, though.
+    assert geom.calc_acmr() > 0
+
+
+def make_terrain(num_rows, indexed):
+    # Makes a Geom with a grid of num_rows vertices on a bumpy surface, drawn
+    # with a single (indexed or nonindexed) triangle list.
+    data = core.GeomVertexData("terrain", core.GeomVertexFormat.get_v3(), core.Geom.UH_static)
+    data.unclean_set_num_rows(num_rows)
+    vertex = core.GeomVertexWriter(data, "vertex")
+    for i in range(num_rows):
+        x = i % 256
+        y = i // 256
+        vertex.set_data3(x, y, sin(x * 0.1) * cos(y * 0.07) * 20 + 5)
+
+    prim = core.GeomTriangles(core.Geom.UH_static)
+    num_vertices = num_rows - num_rows % 3
+    if indexed:
+        # Reference the vertices backwards, to be different from the
+        # nonindexed case.
+        prim.set_index_type(core.Geom.NT_uint32)
+        for i in reversed(range(num_vertices)):
+            prim.add_vertex(i)
+    else:
+        prim.add_consecutive_vertices(0, num_vertices)
+    prim.close_primitive()
+
+    geom = core.Geom(data)
+    geom.add_primitive(prim)
+    return geom
+
+
+def test_geom_calc_tight_bounds_nan():
+    # Ensure that a NaN in the first vertex doesn't end up in the bounds
+    geom = make_terrain(100, False)
+    vertex = core.GeomVertexWriter(geom.modify_vertex_data(), "vertex")
+    vertex.set_data3(float("NaN"), 0, 0)
+
+    node = core.GeomNode("terrain")
+    node.add_geom(geom)
+    min_point = core.LPoint3()
+    max_point = core.LPoint3()
+    assert core.NodePath(node).calc_tight_bounds(min_point, max_point)
+    assert not min_point.is_nan()
+    assert not max_point.is_nan()
+    assert min_point.x == 1
+    assert max_point.x == 98
+
+
+def test_geom_async_compute_bounds():
+    geom = make_terrain(50000, True)
+    future = geom.async_compute_bounds()
+    assert future is not None
+    future.wait()
+    assert future.done()
+
+    bounds = geom.get_bounds()
+    assert bounds is not None
+    assert not bounds.is_empty()
+
+    # Now that the bounds are known, the future is done right away.
+    assert geom.async_compute_bounds().done()
+    assert geom.get_bounds() == bounds
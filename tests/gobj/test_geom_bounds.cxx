@@ -0,0 +1,130 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file test_geom_bounds.cxx
+ * @author rdb
+ * @date 2026-10-17
+ */
+
+#include "geom.h"
+#include "geomTriangles.h"
+#include "geomVertexData.h"
+#include "geomVertexWriter.h"
+#include "boundingBox.h"
+#include "boundingSphere.h"
+#include "config_gobj.h"
+
+#include "catch_amalgamated.hpp"
+
+/**
+ * Makes a Geom with a grid of num_rows vertices on a bumpy surface, drawn
+ * with a single (indexed or nonindexed) triangle list.
+ */
+static PT(Geom)
+make_terrain(int num_rows, bool indexed) {
+  PT(GeomVertexData) vdata = new GeomVertexData
+    ("terrain", GeomVertexFormat::get_v3n3(), GeomEnums::UH_static);
+  vdata->unclean_set_num_rows(num_rows);
+
+  GeomVertexWriter vertex(vdata, InternalName::get_vertex());
+  for (int i = 0; i < num_rows; ++i) {
+    PN_stdfloat x = (PN_stdfloat)(i % 256);
+    PN_stdfloat y = (PN_stdfloat)(i / 256);
+    vertex.set_data3(x, y, csin(x * 0.1f) * ccos(y * 0.07f) * 20.0f + 5.0f);
+  }
+
+  PT(GeomTriangles) tris = new GeomTriangles(GeomEnums::UH_static);
+  int num_vertices = num_rows - num_rows % 3;
+  if (indexed) {
+    // Reference the vertices backwards, to be different from the
+    // nonindexed case.
+    tris->set_index_type(GeomEnums::NT_uint32);
+    for (int i = num_vertices - 1; i >= 0; --i) {
+      tris->add_vertex(i);
+    }
+  } else {
+    tris->add_consecutive_vertices(0, num_vertices);
+  }
+  tris->close_primitive();
+
+  PT(Geom) geom = new Geom(vdata);
+  geom->add_primitive(tris);
+  return geom;
+}
+
+/**
+ * Checks that the two bounding volumes are of the same type and size.
+ */
+static void
+check_same_bounds(const BoundingVolume *a, const BoundingVolume *b) {
+  REQUIRE(a->get_type() == b->get_type());
+  if (a->as_bounding_box() != nullptr) {
+    CHECK(a->as_bounding_box()->get_minq() == b->as_bounding_box()->get_minq());
+    CHECK(a->as_bounding_box()->get_maxq() == b->as_bounding_box()->get_maxq());
+  } else {
+    REQUIRE(a->as_bounding_sphere() != nullptr);
+    CHECK(a->as_bounding_sphere()->get_center() == b->as_bounding_sphere()->get_center());
+    CHECK(a->as_bounding_sphere()->get_radius() == b->as_bounding_sphere()->get_radius());
+  }
+}
+
+TEST_CASE("Geom bounds computed on multiple threads", "[gobj]") {
+  bool indexed = GENERATE(false, true);
+  CAPTURE(indexed);
+  PT(Geom) geom = make_terrain(200000, indexed);
+
+  LPoint3 serial_min, serial_max;
+  bool serial_found = false;
+  geom_bounds_num_threads = 0;
+  geom->calc_tight_bounds(serial_min, serial_max, serial_found, Thread::get_current_thread());
+  REQUIRE(serial_found);
+  CPT(BoundingVolume) serial_bounds = geom->get_bounds();
+
+  LPoint3 parallel_min, parallel_max;
+  bool parallel_found = false;
+  geom_bounds_num_threads = 4;
+  geom->calc_tight_bounds(parallel_min, parallel_max, parallel_found, Thread::get_current_thread());
+  geom->mark_bounds_stale();
+  CPT(BoundingVolume) parallel_bounds = geom->get_bounds();
+  geom_bounds_num_threads.clear_local_value();
+
+  REQUIRE(parallel_found);
+  CHECK(parallel_min == serial_min);
+  CHECK(parallel_max == serial_max);
+  CHECK(parallel_bounds != serial_bounds);
+  check_same_bounds(parallel_bounds, serial_bounds);
+
+  // The terrain is offset from the origin, so this tests the sphere radius
+  // computation as well.
+  geom->set_bounds_type(BoundingVolume::BT_sphere);
+  geom_bounds_num_threads = 0;
+  serial_bounds = geom->get_bounds();
+  geom_bounds_num_threads = 4;
+  geom->mark_bounds_stale();
+  parallel_bounds = geom->get_bounds();
+  geom_bounds_num_threads.clear_local_value();
+
+  REQUIRE(serial_bounds->as_bounding_sphere() != nullptr);
+  check_same_bounds(parallel_bounds, serial_bounds);
+}
+
+// This measures the cost of computing the bounds of a large mesh.  Run it
+// explicitly with: run_cxx_tests "[benchmark]"
+TEST_CASE("Geom bounds", "[.][benchmark][gobj]") {
+  PT(Geom) geom = make_terrain(1 << 20, true);
+
+  for (int num_threads : {0, 2, 4}) {
+    BENCHMARK("compute bounds with " + std::to_string(num_threads) + " threads") {
+      geom_bounds_num_threads = num_threads;
+      geom->mark_bounds_stale();
+      return geom->get_bounds();
+    };
+  }
+
+  geom_bounds_num_threads.clear_local_value();
+}
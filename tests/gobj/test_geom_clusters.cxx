@@ -0,0 +1,210 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file test_geom_clusters.cxx
+ * @author rdb
+ * @date 2026-10-17
+ */
+
+#include "geom.h"
+#include "geomClusters.h"
+#include "geomTriangles.h"
+#include "geomVertexReader.h"
+#include "geomVertexWriter.h"
+#include "boundingBox.h"
+
+#include "catch_amalgamated.hpp"
+
+#include <array>
+
+/**
+ * Returns a closed unit sphere made of latitude-longitude quads, with the
+ * front faces pointing outward.
+ */
+static PT(Geom)
+make_clustered_sphere(int num_rings, int num_segments) {
+  PT(GeomVertexData) vdata = new GeomVertexData
+    ("sphere", GeomVertexFormat::get_v3(), GeomEnums::UH_static);
+  vdata->unclean_set_num_rows((num_rings - 1) * num_segments + 2);
+
+  GeomVertexWriter vertex(vdata, InternalName::get_vertex());
+  vertex.add_data3(0, 0, 1);
+  for (int r = 1; r < num_rings; ++r) {
+    PN_stdfloat theta = MathNumbers::pi * r / num_rings;
+    for (int s = 0; s < num_segments; ++s) {
+      PN_stdfloat phi = MathNumbers::pi * 2 * s / num_segments;
+      vertex.add_data3(csin(theta) * ccos(phi), csin(theta) * csin(phi), ccos(theta));
+    }
+  }
+  vertex.add_data3(0, 0, -1);
+
+  int bottom = (num_rings - 1) * num_segments + 1;
+  PT(GeomTriangles) tris = new GeomTriangles(GeomEnums::UH_static);
+  for (int s = 0; s < num_segments; ++s) {
+    int s1 = (s + 1) % num_segments;
+    tris->add_vertices(0, 1 + s, 1 + s1);
+    for (int r = 1; r < num_rings - 1; ++r) {
+      int a = 1 + (r - 1) * num_segments;
+      int c = a + num_segments;
+      tris->add_vertices(a + s, c + s, c + s1);
+      tris->add_vertices(a + s, c + s1, a + s1);
+    }
+    int a = 1 + (num_rings - 2) * num_segments;
+    tris->add_vertices(a + s, bottom, a + s1);
+  }
+
+  PT(Geom) geom = new Geom(vdata);
+  geom->add_primitive(tris);
+  return geom;
+}
+
+typedef std::array<LPoint3, 3> ClusterTriangle;
+
+/**
+ * Returns the vertex positions of the indicated range of triangles of the
+ * first primitive of the Geom.
+ */
+static pvector<ClusterTriangle>
+get_cluster_triangles(const Geom *geom, int first_index, int num_indices) {
+  CPT(GeomPrimitive) prim = geom->get_primitive(0);
+  GeomVertexReader vertex(geom->get_vertex_data(), InternalName::get_vertex());
+  pvector<ClusterTriangle> triangles;
+  for (int i = first_index; i < first_index + num_indices; i += 3) {
+    ClusterTriangle tri;
+    for (int j = 0; j < 3; ++j) {
+      vertex.set_row(prim->get_vertex(i + j));
+      tri[j] = vertex.get_data3();
+    }
+    triangles.push_back(tri);
+  }
+  return triangles;
+}
+
+/**
+ * Returns the unit normal of the front face of the triangle.
+ */
+static LVector3
+get_cluster_normal(const ClusterTriangle &tri) {
+  LVector3 normal = (tri[1] - tri[0]).cross(tri[2] - tri[0]);
+  normal.normalize();
+  return normal;
+}
+
+TEST_CASE("Geom clusters facing away are culled", "[gobj]") {
+  PT(Geom) geom = make_clustered_sphere(64, 128)->make_clusters(64);
+  CPT(GeomClusters) clusters = geom->get_clusters();
+  REQUIRE(clusters != nullptr);
+  int num_triangles = geom->get_num_triangles();
+
+  LPoint3 camera_pos(5, 0, 0);
+  CPT(Geom) culled = geom->cull_clusters(nullptr, &camera_pos, false, nullptr, Thread::get_current_thread());
+  REQUIRE(culled != nullptr);
+  REQUIRE(culled != geom);
+  CHECK(culled->get_vertex_data() == geom->get_vertex_data());
+  CHECK(culled->get_clusters() == nullptr);
+  CAPTURE(num_triangles, culled->get_num_triangles());
+  CHECK(culled->get_num_triangles() < num_triangles * 55 / 100);
+  CHECK(culled->get_num_triangles() > num_triangles / 4);
+
+  // None of the culled clusters has a triangle facing the camera.
+  BitArray visible;
+  clusters->get_visible(visible, nullptr, &camera_pos, false);
+  for (size_t n = 0; n < clusters->get_num_clusters(); ++n) {
+    if (!visible.get_bit((int)n)) {
+      CHECK(clusters->is_back_facing(n, camera_pos));
+      for (const ClusterTriangle &tri : get_cluster_triangles(geom, clusters->get_first_index(n), clusters->get_num_indices(n))) {
+        CHECK(get_cluster_normal(tri).dot(camera_pos - tri[0]) <= 0);
+      }
+    }
+  }
+
+  // The result is reused as long as the same clusters are visible.
+  CHECK(geom->cull_clusters(nullptr, &camera_pos, false, nullptr, Thread::get_current_thread()) == culled);
+
+  // With the winding reversed, the far side is drawn instead, which is more
+  // of the sphere, since the camera is so close.
+  CPT(Geom) reversed = geom->cull_clusters(nullptr, &camera_pos, true, nullptr, Thread::get_current_thread());
+  REQUIRE(reversed != nullptr);
+  CHECK(reversed != culled);
+  CHECK(reversed->get_num_triangles() > culled->get_num_triangles());
+  CHECK(reversed->get_num_triangles() < num_triangles * 8 / 10);
+}
+
+TEST_CASE("Geom clusters are culled separately for each camera", "[gobj]") {
+  PT(Geom) geom = make_clustered_sphere(32, 64)->make_clusters(64);
+  REQUIRE(geom->get_clusters() != nullptr);
+
+  // Two cameras on opposite sides, taking turns, each keep their own result.
+  int camera_a, camera_b;
+  LPoint3 pos_a(5, 0, 0);
+  LPoint3 pos_b(-5, 0, 0);
+  CPT(Geom) culled_a = geom->cull_clusters(nullptr, &pos_a, false, &camera_a, Thread::get_current_thread());
+  CPT(Geom) culled_b = geom->cull_clusters(nullptr, &pos_b, false, &camera_b, Thread::get_current_thread());
+  REQUIRE(culled_a != nullptr);
+  REQUIRE(culled_b != nullptr);
+  CHECK(culled_a != culled_b);
+  CHECK(geom->cull_clusters(nullptr, &pos_a, false, &camera_a, Thread::get_current_thread()) == culled_a);
+  CHECK(geom->cull_clusters(nullptr, &pos_b, false, &camera_b, Thread::get_current_thread()) == culled_b);
+
+  // Only the least recently used ones are replaced by other cameras.
+  int others[4];
+  for (int &other : others) {
+    LPoint3 pos(0, 5, 0);
+    CHECK(geom->cull_clusters(nullptr, &pos, false, &other, Thread::get_current_thread()) != nullptr);
+    CHECK(geom->cull_clusters(nullptr, &pos_b, false, &camera_b, Thread::get_current_thread()) == culled_b);
+  }
+  CHECK(geom->cull_clusters(nullptr, &pos_a, false, &camera_a, Thread::get_current_thread()) != culled_a);
+}
+
+TEST_CASE("Geom clusters outside the frustum are culled", "[gobj]") {
+  PT(Geom) geom = make_clustered_sphere(64, 128);
+  geom->make_clusters_in_place(64);
+  CPT(GeomClusters) clusters = geom->get_clusters();
+  REQUIRE(clusters != nullptr);
+  int num_triangles = geom->get_num_triangles();
+
+  // Only the top of the sphere is in view.
+  PT(BoundingBox) frustum = new BoundingBox(LPoint3(-2, -2, 0.5f), LPoint3(2, 2, 2));
+  CPT(Geom) culled = geom->cull_clusters(frustum, nullptr, false, nullptr, Thread::get_current_thread());
+  REQUIRE(culled != nullptr);
+  CHECK(culled->get_num_triangles() < num_triangles / 2);
+
+  BitArray visible;
+  int num_visible = clusters->get_visible(visible, frustum, nullptr, false);
+  CHECK(num_visible == culled->get_num_triangles() * 3);
+  for (size_t n = 0; n < clusters->get_num_clusters(); ++n) {
+    if (!visible.get_bit((int)n)) {
+      for (const ClusterTriangle &tri : get_cluster_triangles(geom, clusters->get_first_index(n), clusters->get_num_indices(n))) {
+        for (const LPoint3 &point : tri) {
+          CHECK(point[2] < 0.5f);
+        }
+      }
+    }
+  }
+
+  // Nothing is drawn if the frustum misses everything, and the whole Geom if
+  // it contains everything.
+  PT(BoundingBox) away = new BoundingBox(LPoint3(5, 5, 5), LPoint3(6, 6, 6));
+  CHECK(geom->cull_clusters(away, nullptr, false, nullptr, Thread::get_current_thread()) == nullptr);
+  PT(BoundingBox) all = new BoundingBox(LPoint3(-2, -2, -2), LPoint3(2, 2, 2));
+  CHECK(geom->cull_clusters(all, nullptr, false, nullptr, Thread::get_current_thread()) == geom);
+}
+
+// This measures the cost of culling the clusters of a large mesh.  Run it
+// explicitly with: run_cxx_tests "[benchmark]"
+TEST_CASE("Geom cluster culling", "[.][benchmark][gobj]") {
+  PT(Geom) geom = make_clustered_sphere(256, 512)->make_clusters();
+  CPT(GeomClusters) clusters = geom->get_clusters();
+  PT(BoundingBox) frustum = new BoundingBox(LPoint3(-2, -2, 0), LPoint3(2, 2, 2));
+  LPoint3 camera_pos(5, 0, 0);
+
+  BENCHMARK("find visible clusters of 261632 triangles") {
+    BitArray visible;
+    return clusters->get_visible(visible, frustum, &camera_pos, false);
+  };
+}
@@ -0,0 +1,100 @@
+from panda3d.core import GeomVertexReader, GeomNode, NodePath
+
+
+def get_triangles(geom):
+    prim = geom.get_primitive(0)
+    return [tuple(prim.get_vertex(i + j) for j in range(3))
+            for i in range(0, prim.get_num_vertices(), 3)]
+
+
+def normalize_triangle(tri):
+    # Rotates the vertices so that the lowest index comes first, so that the
+    # same triangles compare equal regardless of where they start.
+    i = tri.index(min(tri))
+    return tri[i:] + tri[:i]
+
+
+def test_geom_clusters_partition(make_sphere):
+    geom = make_sphere(24, 48)
+    num_triangles = geom.get_num_triangles()
+    assert geom.clusters is None
+    orig_triangles = sorted(map(normalize_triangle, get_triangles(geom)))
+
+    assert geom.make_clusters_in_place(64)
+    clusters = geom.clusters
+    assert clusters is not None
+    assert geom.get_num_triangles() == num_triangles
+    assert clusters.get_total_num_indices() == num_triangles * 3
+    assert clusters.get_num_clusters() >= num_triangles // 64
+    assert clusters.get_num_clusters() <= (num_triangles // 64) * 2
+
+    # The same triangles are there, only in another order.
+    new_triangles = sorted(map(normalize_triangle, get_triangles(geom)))
+    assert new_triangles == orig_triangles
+
+    prim = geom.get_primitive(0)
+    vertex = GeomVertexReader(geom.get_vertex_data(), "vertex")
+    next_index = 0
+    for n in range(clusters.get_num_clusters()):
+        first_index = clusters.get_first_index(n)
+        num_indices = clusters.get_num_indices(n)
+        assert first_index == next_index
+        assert 0 < num_indices <= 64 * 3
+        next_index += num_indices
+
+        # The bounds must contain the triangles and their normals.
+        center = clusters.get_center(n)
+        radius = clusters.get_radius(n)
+        axis = clusters.get_cone_axis(n)
+        cutoff = clusters.get_cone_cutoff(n)
+        assert cutoff < 1
+        min_dot = (1 - cutoff * cutoff) ** 0.5
+        for i in range(first_index, first_index + num_indices, 3):
+            points = []
+            for j in range(3):
+                vertex.set_row(prim.get_vertex(i + j))
+                points.append(vertex.get_data3())
+            for point in points:
+                assert (point - center).length() <= radius + 1e-4
+            normal = (points[1] - points[0]).cross(points[2] - points[0]).normalized()
+            assert normal.dot(axis) >= min_dot - 1e-4
+
+    assert next_index == num_triangles * 3
+
+
+def test_geom_clusters_discarded(make_sphere):
+    geom = make_sphere(16, 32).make_clusters(32)
+    clusters = geom.clusters
+    assert clusters is not None
+
+    # Modifying the Geom discards the clusters.
+    copy = geom.make_copy()
+    assert copy.clusters == clusters
+    copy.reverse_in_place()
+    assert copy.clusters is None
+
+    copy = geom.make_copy()
+    copy.set_vertex_data(geom.get_vertex_data().reverse_normals())
+    assert copy.clusters is None
+
+
+def test_geom_clusters_bam(make_sphere):
+    geom = make_sphere(16, 32).make_clusters(32)
+    clusters = geom.clusters
+    assert clusters is not None
+
+    node = GeomNode("sphere")
+    node.add_geom(geom)
+    read_node = NodePath.decode_from_bam_stream(NodePath(node).encode_to_bam_stream()).node()
+    read_clusters = read_node.get_geom(0).clusters
+    assert read_clusters is not None
+
+    assert read_clusters.get_num_clusters() == clusters.get_num_clusters()
+    for n in range(clusters.get_num_clusters()):
+        assert read_clusters.get_first_index(n) == clusters.get_first_index(n)
+        assert read_clusters.get_num_indices(n) == clusters.get_num_indices(n)
+        assert read_clusters.get_center(n) == clusters.get_center(n)
+        assert read_clusters.get_radius(n) == clusters.get_radius(n)
+        assert read_clusters.get_cone_axis(n) == clusters.get_cone_axis(n)
+        assert read_clusters.get_cone_cutoff(n) == clusters.get_cone_cutoff(n)
+
@@ -0,0 +1,183 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file test_geom_vertex_reader_range.cxx
+ * @author rdb
+ * @date 2026-10-17
+ */
+
+#include "geom.h"
+#include "geomTriangles.h"
+#include "geomVertexData.h"
+#include "geomVertexReader.h"
+#include "geomVertexWriter.h"
+#include "boundingBox.h"
+
+#include "catch_amalgamated.hpp"
+
+static const int num_rows = 37;
+
+/**
+ * Makes a vertex data with the indicated format for the vertex column, and
+ * optionally a normal column interleaved with it, filled with a
+ * deterministic pattern.
+ */
+static PT(GeomVertexData)
+make_data(int num_components, GeomEnums::NumericType numeric_type,
+          GeomEnums::Contents contents, bool interleaved) {
+  PT(GeomVertexArrayFormat) array = new GeomVertexArrayFormat;
+  array->add_column(InternalName::get_vertex(), num_components, numeric_type, contents);
+  if (interleaved) {
+    array->add_column(InternalName::get_normal(), 3, GeomEnums::NT_float32, GeomEnums::C_normal);
+  }
+
+  PT(GeomVertexData) vdata = new GeomVertexData
+    ("data", GeomVertexFormat::register_format(array), GeomEnums::UH_static);
+  vdata->unclean_set_num_rows(num_rows);
+
+  GeomVertexWriter vertex(vdata, InternalName::get_vertex());
+  for (int i = 0; i < num_rows; ++i) {
+    vertex.set_data4((PN_stdfloat)(i % 7), (PN_stdfloat)(i * 3 % 11),
+                     (PN_stdfloat)(i % 5) - 2, (PN_stdfloat)(i % 3 + 1));
+  }
+  return vdata;
+}
+
+TEST_CASE("GeomVertexReader range reads match per-row reads", "[gobj]") {
+  struct Format {
+    int _num_components;
+    GeomEnums::NumericType _numeric_type;
+    GeomEnums::Contents _contents;
+    bool _interleaved;
+  };
+  Format format = GENERATE(
+    Format {3, GeomEnums::NT_float32, GeomEnums::C_point, false},
+    Format {3, GeomEnums::NT_float32, GeomEnums::C_point, true},
+    Format {4, GeomEnums::NT_float32, GeomEnums::C_point, false},
+    Format {4, GeomEnums::NT_float32, GeomEnums::C_color, false},
+    Format {2, GeomEnums::NT_float32, GeomEnums::C_point, false},
+    Format {3, GeomEnums::NT_float64, GeomEnums::C_point, true},
+    Format {4, GeomEnums::NT_uint8, GeomEnums::C_color, false},
+    Format {3, GeomEnums::NT_int16, GeomEnums::C_point, false});
+  CAPTURE(format._num_components, format._numeric_type, format._interleaved);
+
+  PT(GeomVertexData) vdata = make_data(format._num_components, format._numeric_type,
+                                       format._contents, format._interleaved);
+
+  for (int first : {0, 5}) {
+    CAPTURE(first);
+    int count = num_rows - first - 3;
+
+    GeomVertexReader expected(vdata, InternalName::get_vertex());
+    expected.set_row(first);
+
+    GeomVertexReader reader(vdata, InternalName::get_vertex());
+    reader.set_row(first);
+    pvector<LVecBase3> buffer3;
+    const LVecBase3 *data3 = reader.get_data3_range(count, buffer3);
+    REQUIRE(data3 != nullptr);
+    CHECK(reader.get_read_row() == first + count);
+    for (int i = 0; i < count; ++i) {
+      CHECK(data3[i] == expected.get_data3());
+    }
+
+    expected.set_row(first);
+    reader.set_row(first);
+    epvector<LVecBase4> buffer4;
+    const LVecBase4 *data4 = reader.get_data4_range(count, buffer4);
+    REQUIRE(data4 != nullptr);
+    for (int i = 0; i < count; ++i) {
+      CHECK(data4[i] == expected.get_data4());
+    }
+
+    // The explicitly-typed variants convert as necessary.
+    expected.set_row(first);
+    reader.set_row(first);
+    pvector<LVecBase3d> buffer3d;
+    const LVecBase3d *data3d = reader.get_data3d_range(count, buffer3d);
+    REQUIRE(data3d != nullptr);
+    for (int i = 0; i < count; ++i) {
+      CHECK(data3d[i] == expected.get_data3d());
+    }
+
+    expected.set_row(first);
+    reader.set_row(first);
+    epvector<LVecBase4f> buffer4f;
+    const LVecBase4f *data4f = reader.get_data4f_range(count, buffer4f);
+    REQUIRE(data4f != nullptr);
+    for (int i = 0; i < count; ++i) {
+      CHECK(data4f[i] == expected.get_data4f());
+    }
+  }
+}
+
+TEST_CASE("GeomVertexReader range read of packed float32 is zero-copy", "[gobj]") {
+  PT(GeomVertexData) vdata = make_data(3, GeomEnums::NT_float32, GeomEnums::C_point, false);
+
+  GeomVertexReader reader(vdata, InternalName::get_vertex());
+  reader.set_row(2);
+  pvector<LVecBase3f> buffer;
+  const LVecBase3f *data = reader.get_data3f_range(10, buffer);
+  REQUIRE(data != nullptr);
+  CHECK(buffer.empty());
+
+  // The writer has already divided the points by the w we gave it.
+  CHECK(data[0] == LVecBase3f(2, 6, 0) / 3);
+
+  // Reading nothing is fine, too.
+  CHECK(reader.get_data3f_range(0, buffer) == buffer.data());
+}
+
+TEST_CASE("GeomPrimitive bounds use the referenced vertices", "[gobj]") {
+  PT(GeomVertexData) vdata = make_data(3, GeomEnums::NT_float32, GeomEnums::C_point, true);
+
+  // Set two vertices outside the range referenced by the primitive.
+  {
+    GeomVertexWriter vertex(vdata, InternalName::get_vertex());
+    vertex.set_row(0);
+    vertex.set_data3(-100, -100, -100);
+    vertex.set_row(num_rows - 1);
+    vertex.set_data3(100, 100, 100);
+  }
+
+  PT(GeomTriangles) tris = new GeomTriangles(GeomEnums::UH_static);
+  SECTION("indexed") {
+    tris->add_vertices(7, 3, 12);
+    tris->add_vertices(20, 3, 9);
+  }
+  SECTION("nonindexed") {
+    tris->add_consecutive_vertices(3, 18);
+  }
+  REQUIRE(tris->get_num_vertices() > 0);
+
+  // Compute the expected bounds the slow way.
+  LPoint3 min_point, max_point;
+  {
+    GeomVertexReader reader(vdata, InternalName::get_vertex());
+    for (int i = 0; i < tris->get_num_vertices(); ++i) {
+      reader.set_row(tris->get_vertex(i));
+      LPoint3 vertex = reader.get_data3();
+      if (i == 0) {
+        min_point = vertex;
+        max_point = vertex;
+      } else {
+        min_point = min_point.fmin(vertex);
+        max_point = max_point.fmax(vertex);
+      }
+    }
+  }
+
+  PT(Geom) geom = new Geom(vdata);
+  geom->add_primitive(tris);
+  geom->set_bounds_type(BoundingVolume::BT_box);
+  CPT(BoundingVolume) bounds = geom->get_bounds();
+  const BoundingBox *box = bounds->as_bounding_box();
+  REQUIRE(box != nullptr);
+  CHECK(box->get_minq() == min_point);
+  CHECK(box->get_maxq() == max_point);
+}
@@ -0,0 +1,118 @@
+from panda3d.core import Geom, GeomVertexData, GeomVertexFormat
+from panda3d.core import GeomVertexWriter, GeomVertexReader
+from panda3d.core import GeomTriangles, GeomTristrips
+import pytest
+
+
+def make_flat_grid(size):
+    # A flat square grid of the indicated number of quads on each side, with
+    # only a vertex column.
+    vdata = GeomVertexData("grid", GeomVertexFormat.get_v3(), Geom.UH_static)
+    vertex = GeomVertexWriter(vdata, "vertex")
+    for y in range(size + 1):
+        for x in range(size + 1):
+            vertex.add_data3(x, y, 0)
+
+    tris = GeomTriangles(Geom.UH_static)
+    for y in range(size):
+        for x in range(size):
+            v = y * (size + 1) + x
+            tris.add_vertices(v, v + 1, v + size + 2)
+            tris.add_vertices(v, v + size + 2, v + size + 1)
+
+    geom = Geom(vdata)
+    geom.add_primitive(tris)
+    return geom
+
+
+def get_triangles(geom, column):
+    prim = geom.get_primitive(0).decompose()
+    reader = GeomVertexReader(geom.get_vertex_data(), column)
+    triangles = []
+    for i in range(0, prim.get_num_vertices(), 3):
+        triangle = []
+        for j in range(3):
+            reader.set_row(prim.get_vertex(i + j))
+            triangle.append(reader.get_data3())
+        triangles.append(triangle)
+    return triangles
+
+
+def calc_projected_area(geom):
+    # The sum of the signed areas of the triangles, projected onto the XY
+    # plane.
+    area = 0
+    for p0, p1, p2 in get_triangles(geom, "vertex"):
+        area += (p1 - p0).cross(p2 - p0)[2] * 0.5
+    return area
+
+
+def test_simplify_target_count(make_sphere):
+    geom = make_sphere(24, 48, texcoords=True)
+    orig_triangles = geom.get_num_triangles()
+    vdata = geom.get_vertex_data()
+
+    target = orig_triangles // 4
+    simple = geom.simplify(target)
+    num_triangles = simple.get_num_triangles()
+    assert num_triangles <= target
+    assert num_triangles > target // 2
+
+    # The original is not affected, and the vertex data is shared.
+    assert geom.get_num_triangles() == orig_triangles
+    assert simple.get_vertex_data() == vdata
+
+    # No triangle straddles the UV seam.
+    assert simple.get_primitive(0).is_of_type(GeomTriangles)
+    for triangle in get_triangles(simple, "texcoord"):
+        us = [uv[0] for uv in triangle]
+        assert max(us) - min(us) < 0.5
+
+
+def test_simplify_error_limit(make_sphere):
+    geom = make_sphere(24, 48, texcoords=True)
+    orig_triangles = geom.get_num_triangles()
+
+    max_error = 0.01
+    error = geom.simplify_in_place(0, max_error)
+    num_triangles = geom.get_num_triangles()
+    assert error > 0
+    assert error <= max_error
+    assert num_triangles < orig_triangles
+
+    # A looser limit allows more simplification.
+    error2 = geom.simplify_in_place(0, max_error * 10)
+    assert error2 <= max_error * 10
+    assert geom.get_num_triangles() < num_triangles
+
+
+def test_simplify_border():
+    geom = make_flat_grid(16)
+    orig_area = calc_projected_area(geom)
+    assert orig_area == pytest.approx(16 * 16)
+
+    # The border of a flat mesh is kept in place.
+    error = geom.simplify_in_place(0, 0.001)
+    assert error == pytest.approx(0, abs=0.001)
+    assert geom.get_num_triangles() <= 16 * 16 * 2 // 10
+    assert calc_projected_area(geom) == pytest.approx(orig_area)
+
+
+def test_simplify_strips():
+    geom = make_flat_grid(8)
+    strips = GeomTristrips(Geom.UH_static)
+    for y in range(8):
+        for x in range(9):
+            strips.add_vertex((y + 1) * 9 + x)
+            strips.add_vertex(y * 9 + x)
+        strips.close_primitive()
+    geom.set_primitive(0, strips)
+    orig_triangles = geom.get_num_triangles()
+    assert orig_triangles == 8 * 8 * 2
+
+    # The strips are decomposed into triangles.
+    geom.simplify_in_place(orig_triangles // 2)
+    assert geom.get_num_primitives() == 1
+    assert type(geom.get_primitive(0)) is GeomTriangles
+    assert geom.get_num_triangles() <= orig_triangles // 2
+    assert calc_projected_area(geom) == pytest.approx(calc_projected_area(make_flat_grid(8)))
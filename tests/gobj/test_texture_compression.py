@@ -0,0 +1,88 @@
+from panda3d.core import Texture, SamplerState, load_prc_file_data, unload_prc_file
+from contextlib import contextmanager
+import struct
+import pytest
+
+
+@contextmanager
+def prc(data):
+    page = load_prc_file_data("test_texture_compression", data)
+    try:
+        yield
+    finally:
+        unload_prc_file(page)
+
+
+def make_texture(component_type, format):
+    # A size that is not a multiple of the block size, filled with a smooth
+    # pattern.
+    tex = Texture("test")
+    tex.setup_2d_texture(10, 6, component_type, format)
+    tex.minfilter = SamplerState.FT_linear
+
+    num_components = tex.get_num_components()
+    values = [20 + x * 12 + y * 8 + c * 20
+              for y in range(6) for x in range(10) for c in range(num_components)]
+    if component_type == Texture.T_float:
+        tex.set_ram_image(struct.pack("%df" % len(values), *(v / 64.0 for v in values)))
+    else:
+        tex.set_ram_image(bytes(values))
+    return tex
+
+
+def get_values(tex):
+    data = memoryview(tex.get_ram_image()).tobytes()
+    if tex.get_component_type() == Texture.T_float:
+        return struct.unpack("%df" % (len(data) // 4), data)
+    else:
+        return tuple(data)
+
+
+def compress_round_trip(tex, compression):
+    # Compresses the texture in the indicated mode and uncompresses it again,
+    # and returns the largest error, in units of the component type.
+    original = get_values(tex)
+
+    assert tex.compress_ram_image(compression, Texture.QL_normal)
+    assert tex.get_ram_image_compression() == compression
+    assert tex.get_num_ram_mipmap_images() == 1
+
+    assert tex.uncompress_ram_image()
+    assert tex.get_ram_image_compression() == Texture.CM_off
+
+    result = get_values(tex)
+    assert len(result) == len(original)
+    return max(abs(a - b) for a, b in zip(original, result))
+
+
+@pytest.mark.parametrize("compression,component_type,format,max_error", [
+    (Texture.CM_dxt1, Texture.T_unsigned_byte, Texture.F_rgb, 16),
+    (Texture.CM_dxt5, Texture.T_unsigned_byte, Texture.F_rgba, 16),
+    (Texture.CM_rgtc, Texture.T_unsigned_byte, Texture.F_rg, 8),
+    (Texture.CM_bptc, Texture.T_unsigned_byte, Texture.F_rgba, 12),
+    (Texture.CM_bptc, Texture.T_float, Texture.F_rgb32, 0.5),
+])
+def test_texture_compress_round_trip(compression, component_type, format, max_error):
+    tex = make_texture(component_type, format)
+    assert compress_round_trip(tex, compression) <= max_error
+
+
+def test_texture_compress_automatic():
+    # Floating-point textures are compressed as BPTC float.
+    tex = make_texture(Texture.T_float, Texture.F_rgb32)
+    assert tex.compress_ram_image()
+    assert tex.get_ram_image_compression() == Texture.CM_bptc
+
+    # A 10x6 image takes 3x2 blocks.
+    assert tex.get_ram_image_size() == 3 * 2 * 16
+
+
+def test_texture_compress_threads():
+    serial = make_texture(Texture.T_unsigned_byte, Texture.F_rgba)
+    parallel = serial.make_copy()
+
+    assert serial.compress_ram_image(Texture.CM_dxt5, Texture.QL_best)
+    with prc("texture-compress-num-threads 4"):
+        assert parallel.compress_ram_image(Texture.CM_dxt5, Texture.QL_best)
+
+    assert memoryview(serial.get_ram_image()) == memoryview(parallel.get_ram_image())
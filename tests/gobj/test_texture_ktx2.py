@@ -0,0 +1,184 @@
+from panda3d.core import Texture, Filename, Notify, PandaSystem, StringStream
+import struct
+import zlib
+import pytest
+
+
+@pytest.fixture
+def notify_log():
+    # Captures the messages written to the notify output, so that the errors
+    # can be checked instead of ending up in the test output.
+    notify = Notify.ptr()
+    old_stream = notify.get_ostream_ptr()
+    stream = StringStream()
+    notify.set_ostream_ptr(stream, False)
+    yield stream
+    notify.set_ostream_ptr(old_stream, False)
+
+
+def make_ktx2(vk_format, width, height, levels, num_faces=1, num_levels=None,
+              supercompression=0, uncompressed_sizes=None, dfd=b""):
+    # Builds a KTX2 file.  levels[n] holds the (possibly supercompressed) data
+    # of mipmap level n, and uncompressed_sizes[n] its size before
+    # supercompression.  The levels are stored smallest first, with some
+    # padding between them, as the specification requires.
+    if num_levels is None:
+        num_levels = len(levels)
+    if uncompressed_sizes is None:
+        uncompressed_sizes = [len(level) for level in levels]
+
+    dfd_offset = 80 + len(levels) * 24
+    offset = dfd_offset + len(dfd)
+    offsets = [0] * len(levels)
+    for n in reversed(range(len(levels))):
+        offset = (offset + 7) & ~7
+        offsets[n] = offset
+        offset += len(levels[n])
+
+    data = b"\xABKTX 20\xBB\r\n\x1A\n"
+    data += struct.pack("<9I", vk_format, 1, width, height, 0, 0, num_faces,
+                        num_levels, supercompression)
+    data += struct.pack("<4I2Q", dfd_offset if dfd else 0, len(dfd), 0, 0, 0, 0)
+    for n in range(len(levels)):
+        data += struct.pack("<3Q", offsets[n], len(levels[n]), uncompressed_sizes[n])
+    data += dfd
+    for n in reversed(range(len(levels))):
+        data += bytes(offsets[n] - len(data))
+        data += levels[n]
+    return data
+
+
+def make_pattern(size, seed):
+    return bytes((i * 7 + seed * 31) & 0xff for i in range(size))
+
+
+def read_ktx2(tmp_path, data):
+    path = tmp_path / "test.ktx2"
+    path.write_bytes(data)
+    tex = Texture()
+    return tex, tex.read(Filename.from_os_specific(str(path)))
+
+
+def get_image(tex, n=0):
+    return memoryview(tex.get_ram_mipmap_image(n)).tobytes()
+
+
+def test_texture_ktx2_rgba_mipmaps(tmp_path):
+    levels = [make_pattern(4 * 2 * 4, 0), make_pattern(2 * 1 * 4, 1), make_pattern(1 * 1 * 4, 2)]
+
+    # VK_FORMAT_R8G8B8A8_UNORM
+    tex, success = read_ktx2(tmp_path, make_ktx2(37, 4, 2, levels))
+    assert success
+    assert tex.get_texture_type() == Texture.TT_2d_texture
+    assert tex.get_x_size() == 4
+    assert tex.get_y_size() == 2
+    assert tex.get_format() == Texture.F_rgba8
+    assert tex.get_component_type() == Texture.T_unsigned_byte
+    assert tex.get_num_ram_mipmap_images() == 3
+
+    # The red and blue channels are swapped to match Panda's ordering.
+    for n, level in enumerate(levels):
+        image = get_image(tex, n)
+        assert len(image) == len(level)
+        for i in range(0, len(image), 4):
+            assert image[i:i + 4] == bytes((level[i + 2], level[i + 1], level[i], level[i + 3]))
+
+
+def test_texture_ktx2_header_only():
+    # VK_FORMAT_R32_SFLOAT, cut off after the level index.
+    data = make_ktx2(100, 16, 8, [make_pattern(16 * 8 * 4, 0)])
+    tex = Texture()
+    assert tex.read_ktx(StringStream(data[:104]), "test.ktx2", True)
+    assert tex.get_x_size() == 16
+    assert tex.get_y_size() == 8
+    assert tex.get_format() == Texture.F_r32
+    assert tex.get_component_type() == Texture.T_float
+    assert not tex.has_ram_image()
+
+
+def test_texture_ktx2_block_compressed(tmp_path):
+    # Two 4x4 blocks of BC1 data, for an 8x4 image.
+    blocks = make_pattern(16, 0)
+    tex, success = read_ktx2(tmp_path, make_ktx2(131, 8, 4, [blocks]))
+    assert success
+    assert tex.get_ram_image_compression() == Texture.CM_dxt1
+    assert tex.get_format() == Texture.F_rgb
+    assert get_image(tex) == blocks
+
+    # It can be decoded for a GSG that doesn't support it.
+    assert tex.uncompress_ram_image()
+    assert tex.get_ram_image_size() == 8 * 4 * 3
+
+
+def test_texture_ktx2_cube_map(tmp_path):
+    faces = b"".join(bytes((face * 10,)) * 16 for face in range(6))
+
+    # VK_FORMAT_R8_UNORM
+    tex, success = read_ktx2(tmp_path, make_ktx2(9, 4, 4, [faces], num_faces=6))
+    assert success
+    assert tex.get_texture_type() == Texture.TT_cube_map
+    assert tex.get_z_size() == 6
+    assert get_image(tex) == faces
+
+
+def test_texture_ktx2_generate_mipmaps(tmp_path):
+    # A level count of 0 asks for the mipmaps to be generated.
+    tex, success = read_ktx2(tmp_path, make_ktx2(9, 8, 8, [make_pattern(64, 0)], num_levels=0))
+    assert success
+    assert tex.get_num_ram_mipmap_images() == 4
+
+
+def test_texture_ktx2_zlib(tmp_path, notify_log):
+    if not PandaSystem.get_global_ptr().has_system("zlib"):
+        pytest.skip("Panda3D was built without zlib")
+
+    levels = [make_pattern(8 * 8, 0), make_pattern(4 * 4, 1)]
+    data = make_ktx2(9, 8, 8, [zlib.compress(level) for level in levels],
+                     supercompression=3, uncompressed_sizes=[len(level) for level in levels])
+    tex, success = read_ktx2(tmp_path, data)
+    assert success
+    assert tex.get_num_ram_mipmap_images() == 2
+    assert get_image(tex, 0) == levels[0]
+    assert get_image(tex, 1) == levels[1]
+
+    # Corrupt data is rejected.
+    data = make_ktx2(9, 8, 8, [b"garbage"], supercompression=3, uncompressed_sizes=[64])
+    tex, success = read_ktx2(tmp_path, data)
+    assert not success
+    assert b"invalid supercompressed data for mipmap level 0" in notify_log.data
+
+
+def test_texture_ktx2_zstd(tmp_path):
+    if not PandaSystem.get_global_ptr().has_system("zstd"):
+        pytest.skip("Panda3D was built without Zstandard")
+
+    # The bytes 0 to 15, twice, as compressed by the zstd tool.
+    frame = bytes((
+        0x28, 0xb5, 0x2f, 0xfd, 0x24, 0x20, 0xbd, 0x00, 0x00, 0x88, 0x00, 0x01,
+        0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d,
+        0x0e, 0x0f, 0x00, 0x01, 0x00, 0xa7, 0x9b, 0x4b, 0x87, 0xbc, 0xf4, 0x63,
+    ))
+    data = make_ktx2(9, 8, 4, [frame], supercompression=2, uncompressed_sizes=[32])
+    tex, success = read_ktx2(tmp_path, data)
+    assert success
+    assert get_image(tex) == bytes(range(16)) * 2
+
+
+@pytest.mark.parametrize("uastc", [False, True])
+def test_texture_ktx2_basis_invalid(tmp_path, notify_log, uastc):
+    # ETC1S data is marked by the BasisLZ supercompression scheme, and UASTC
+    # data by the color model in the data format descriptor.
+    if uastc:
+        # An 8x8 image takes 64 bytes of UASTC data, not 32.
+        dfd = struct.pack("<4I", 44, 0, 2 | (40 << 16), 166) + bytes(28)
+        data = make_ktx2(0, 8, 8, [make_pattern(32, 0)], dfd=dfd)
+    else:
+        data = make_ktx2(0, 8, 8, [make_pattern(32, 0)], supercompression=1,
+                         uncompressed_sizes=[64])
+
+    tex, success = read_ktx2(tmp_path, data)
+    assert not success
+    if PandaSystem.get_global_ptr().has_system("basisu"):
+        assert b"invalid Basis Universal data" in notify_log.data
+    else:
+        assert b"built without Basis Universal support" in notify_log.data
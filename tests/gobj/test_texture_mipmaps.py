@@ -0,0 +1,250 @@
+from panda3d.core import Texture, load_prc_file_data, unload_prc_file
+from contextlib import contextmanager
+import struct
+import pytest
+
+
+@contextmanager
+def prc(data):
+    page = load_prc_file_data("test_texture_mipmaps", data)
+    try:
+        yield
+    finally:
+        unload_prc_file(page)
+
+
+def pattern(size):
+    # A pattern that has no structure at the scale of a single pixel, so that
+    # every sample of the filter matters.
+    return bytes((i * 37 + (i >> 5) * 11) & 0xff for i in range(size))
+
+
+def float_pattern(count):
+    # Same as above, but with floats between 0 and 4.
+    return struct.pack("%df" % count, *(b / 64.0 for b in pattern(count)))
+
+
+def get_image(tex, n, fmt="B"):
+    data = memoryview(tex.get_ram_mipmap_image(n)).tobytes()
+    return struct.unpack("%d%s" % (len(data) // struct.calcsize(fmt), fmt), data)
+
+
+def offset_of(x_size, y_size, num_components, x, y, z, c):
+    return ((z * y_size + y) * x_size + x) * num_components + c
+
+
+@pytest.mark.parametrize("x_size", [37, 1])
+@pytest.mark.parametrize("y_size", [20, 1])
+@pytest.mark.parametrize("num_components", [4, 3])
+def test_texture_mipmaps_2d_byte(x_size, y_size, num_components):
+    # An odd size, so that the last row and column are dropped, and a width
+    # that is not a multiple of the vector width.
+    if x_size == 1 and y_size == 1:
+        pytest.skip("no mipmap levels")
+
+    tex = Texture("mipmaps")
+    tex.setup_2d_texture(x_size, y_size, Texture.T_unsigned_byte,
+                         Texture.F_rgba if num_components == 4 else Texture.F_rgb)
+    tex.set_ram_image(pattern(x_size * y_size * num_components))
+    tex.generate_ram_mipmap_images()
+
+    src = get_image(tex, 0)
+    dst = get_image(tex, 1)
+    to_x_size = max(x_size >> 1, 1)
+    to_y_size = max(y_size >> 1, 1)
+    assert len(dst) == to_x_size * to_y_size * num_components
+
+    for y in range(to_y_size):
+        for x in range(to_x_size):
+            x1 = min(x * 2 + 1, x_size - 1)
+            y1 = min(y * 2 + 1, y_size - 1)
+            for c in range(num_components):
+                total = (src[offset_of(x_size, y_size, num_components, x * 2, y * 2, 0, c)] +
+                         src[offset_of(x_size, y_size, num_components, x1, y * 2, 0, c)] +
+                         src[offset_of(x_size, y_size, num_components, x * 2, y1, 0, c)] +
+                         src[offset_of(x_size, y_size, num_components, x1, y1, 0, c)])
+                assert dst[offset_of(to_x_size, to_y_size, num_components, x, y, 0, c)] == total >> 2
+
+
+def test_texture_mipmaps_2d_float():
+    tex = Texture("mipmaps")
+    tex.setup_2d_texture(37, 20, Texture.T_float, Texture.F_rgba32)
+    tex.set_ram_image(float_pattern(37 * 20 * 4))
+    tex.generate_ram_mipmap_images()
+
+    src = get_image(tex, 0, "f")
+    dst = get_image(tex, 1, "f")
+    for y in range(10):
+        for x in range(18):
+            for c in range(4):
+                expected = (src[offset_of(37, 20, 4, x * 2, y * 2, 0, c)] +
+                            src[offset_of(37, 20, 4, x * 2 + 1, y * 2, 0, c)] +
+                            src[offset_of(37, 20, 4, x * 2, y * 2 + 1, 0, c)] +
+                            src[offset_of(37, 20, 4, x * 2 + 1, y * 2 + 1, 0, c)]) / 4
+                assert dst[offset_of(18, 10, 4, x, y, 0, c)] == pytest.approx(expected, rel=1e-6)
+
+
+def test_texture_mipmaps_half_float():
+    tex = Texture("mipmaps")
+    tex.setup_2d_texture(8, 4, Texture.T_half_float, Texture.F_rgba16)
+    tex.set_ram_image(struct.pack("128e", *((i % 13) * 0.75 - 2.0 for i in range(128))))
+    assert tex.get_expected_num_mipmap_levels() == 4
+    tex.generate_ram_mipmap_images()
+    assert tex.get_num_ram_mipmap_images() == 4
+
+    src = get_image(tex, 0, "e")
+    dst = get_image(tex, 1, "e")
+    for y in range(2):
+        for x in range(4):
+            for c in range(4):
+                expected = sum(src[offset_of(8, 4, 4, x * 2 + dx, y * 2 + dy, 0, c)]
+                               for dy in range(2) for dx in range(2)) / 4
+                assert dst[offset_of(4, 2, 4, x, y, 0, c)] == pytest.approx(expected, abs=0.002)
+
+
+def test_texture_mipmaps_3d():
+    tex = Texture("mipmaps")
+    tex.setup_3d_texture(9, 6, 5, Texture.T_unsigned_byte, Texture.F_rgba)
+    tex.set_ram_image(pattern(9 * 6 * 5 * 4))
+    tex.generate_ram_mipmap_images()
+
+    src = get_image(tex, 0)
+    dst = get_image(tex, 1)
+    assert len(dst) == 4 * 3 * 2 * 4
+    for z in range(2):
+        for y in range(3):
+            for x in range(4):
+                for c in range(4):
+                    total = sum(src[offset_of(9, 6, 4, x * 2 + (d & 1), y * 2 + ((d >> 1) & 1), z * 2 + (d >> 2), c)]
+                                for d in range(8))
+                    assert dst[offset_of(4, 3, 4, x, y, z, c)] == total >> 3
+
+
+@pytest.mark.parametrize("filter", ["box", "kaiser", "lanczos"])
+def test_texture_mipmaps_cube_faces(filter):
+    # Each face is filtered by itself, so a face never picks up the color of
+    # another.
+    tex = Texture("mipmaps")
+    tex.setup_cube_map(16, Texture.T_unsigned_byte, Texture.F_rgba)
+    page_size = tex.get_expected_ram_page_size()
+    tex.set_ram_image(bytes(40 * (i // page_size) for i in range(page_size * 6)))
+
+    with prc("texture-mipmap-filter " + filter):
+        tex.generate_ram_mipmap_images()
+    assert tex.get_num_ram_mipmap_images() == 5
+
+    for n in range(1, 5):
+        image = get_image(tex, n)
+        page_size = tex.get_expected_ram_mipmap_page_size(n)
+        assert len(image) == page_size * 6
+        assert image == tuple(40 * (i // page_size) for i in range(len(image)))
+
+
+def make_cube_map():
+    tex = Texture("cube map")
+    tex.setup_cube_map(70, Texture.T_unsigned_byte, Texture.F_rgba)
+    tex.set_ram_image(pattern(70 * 70 * 6 * 4))
+    return tex
+
+
+def make_3d_texture():
+    tex = Texture("3-D texture")
+    tex.setup_3d_texture(33, 17, 12, Texture.T_float, Texture.F_rgba32)
+    tex.set_ram_image(float_pattern(33 * 17 * 12 * 4))
+    return tex
+
+
+def make_short_texture():
+    tex = Texture("short")
+    tex.setup_2d_texture(51, 40, Texture.T_unsigned_short, Texture.F_rgb16)
+    tex.set_ram_image(pattern(51 * 40 * 3 * 2))
+    return tex
+
+
+@pytest.mark.parametrize("make_texture", [make_cube_map, make_3d_texture, make_short_texture])
+@pytest.mark.parametrize("filter", ["box", "lanczos"])
+def test_texture_mipmaps_threads(make_texture, filter):
+    serial = make_texture()
+    parallel = make_texture()
+
+    with prc("texture-mipmap-filter " + filter):
+        serial.generate_ram_mipmap_images()
+        with prc("texture-mipmap-num-threads 4"):
+            parallel.generate_ram_mipmap_images()
+
+    assert serial.get_num_ram_mipmap_images() == parallel.get_num_ram_mipmap_images()
+    for n in range(serial.get_num_ram_mipmap_images()):
+        assert memoryview(serial.get_ram_mipmap_image(n)) == memoryview(parallel.get_ram_mipmap_image(n))
+
+
+@pytest.mark.parametrize("filter", ["kaiser", "lanczos"])
+def test_texture_mipmaps_filter_constant(filter):
+    # The filters are normalized, so that an image of a single color stays
+    # that color, even at the edges and in the odd-sized levels.
+    tex = Texture("mipmaps")
+    tex.setup_3d_texture(23, 10, 7, Texture.T_unsigned_byte, Texture.F_rgba)
+    tex.set_ram_image(bytes((10, 100, 200, 255)) * (23 * 10 * 7))
+
+    with prc("texture-mipmap-filter " + filter):
+        tex.generate_ram_mipmap_images()
+    assert tex.get_num_ram_mipmap_images() == tex.get_expected_num_mipmap_levels()
+
+    for n in range(1, tex.get_num_ram_mipmap_images()):
+        image = get_image(tex, n)
+        num_pixels = (tex.get_expected_mipmap_x_size(n) *
+                      tex.get_expected_mipmap_y_size(n) *
+                      tex.get_expected_mipmap_z_size(n))
+        assert image == (10, 100, 200, 255) * num_pixels
+
+
+@pytest.mark.parametrize("filter", ["kaiser", "lanczos"])
+def test_texture_mipmaps_filter_ramp(filter):
+    # The filters are symmetric, so a linear ramp remains a ramp, sampled at
+    # the centers of the new pixels, away from the edges.
+    tex = Texture("mipmaps")
+    tex.setup_2d_texture(64, 1, Texture.T_float, Texture.F_r32)
+    tex.set_ram_image(struct.pack("64f", *(x + 0.5 for x in range(64))))
+
+    with prc("texture-mipmap-filter " + filter):
+        tex.generate_ram_mipmap_images()
+
+    image = get_image(tex, 1, "f")
+    assert len(image) == 32
+    for x in range(3, 29):
+        assert image[x] == pytest.approx(x * 2 + 1, abs=1e-3)
+
+    # Unlike the box filter, a sharp edge overshoots.
+    tex.set_ram_image(struct.pack("64f", *(float(x >= 31) for x in range(64))))
+    with prc("texture-mipmap-filter " + filter):
+        tex.generate_ram_mipmap_images()
+    image = get_image(tex, 1, "f")
+    assert min(image) < 0
+    assert max(image) > 1
+
+
+@pytest.mark.parametrize("filter", ["box", "lanczos"])
+def test_texture_mipmaps_alpha_weighted(filter):
+    # Opaque blue pixels next to transparent green ones.  The components are
+    # stored in BGRA order.
+    opaque = bytes((255, 0, 0, 255))
+    clear = bytes((0, 255, 0, 0))
+    tex = Texture("mipmaps")
+    tex.setup_2d_texture(8, 8, Texture.T_unsigned_byte, Texture.F_rgba)
+    tex.set_ram_image((opaque + clear) * 32)
+
+    with prc("texture-mipmap-filter " + filter):
+        tex.generate_ram_mipmap_images()
+    image = get_image(tex, 1)
+    assert image[1] > 64
+
+    # With alpha weighting, the green does not bleed into the blue.
+    with prc("texture-mipmap-filter " + filter + "\ntexture-mipmap-alpha-weighted true"):
+        tex.generate_ram_mipmap_images()
+    image = get_image(tex, 1)
+    assert len(image) == 4 * 4 * 4
+    for i in range(0, len(image), 4):
+        assert image[i:i + 3] == (255, 0, 0)
+        assert 0 < image[i + 3] < 255
+
+    if filter == "box":
+        assert set(image[3::4]) <= {127, 128}
@@ -0,0 +1,139 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file test_texture_pool_concurrency.cxx
+ * @author rdb
+ * @date 2026-10-17
+ */
+
+#include "texture.h"
+#include "texturePool.h"
+#include "texturePoolFilter.h"
+#include "config_gobj.h"
+#include "string_utils.h"
+
+#include "catch_amalgamated.hpp"
+
+#include <atomic>
+#include <thread>
+
+/**
+ * Counts the number of times the pool goes to disk for a texture.  The pool
+ * only consults its filters just before it reads a texture.
+ */
+class CountingPoolFilter : public TexturePoolFilter {
+public:
+  virtual PT(Texture) pre_load(const Filename &, const Filename &, int, int,
+                               bool, const LoaderOptions &) override {
+    ++_num_loads;
+    return nullptr;
+  }
+
+  std::atomic<int> _num_loads {0};
+};
+
+TEST_CASE("TexturePool loads each texture once from many threads", "[gobj]") {
+  static const int num_textures = 5000;
+  static const int num_threads = 16;
+
+  // Write a directory full of small, distinct texture files.
+  Filename dir = Filename::temporary(Filename::get_temp_directory().get_fullpath(), "texpool");
+  REQUIRE(dir.mkdir());
+
+  std::vector<Filename> filenames;
+  PT(Texture) source = new Texture("source");
+  source->setup_2d_texture(4, 4, Texture::T_unsigned_byte, Texture::F_rgba);
+  for (int i = 0; i < num_textures; ++i) {
+    PTA_uchar image = source->modify_ram_image();
+    for (size_t j = 0; j < image.size(); ++j) {
+      image[j] = (unsigned char)((i + j * 37) & 0xff);
+    }
+    Filename filename(dir, "tex" + format_string(i) + ".txo");
+    REQUIRE(source->write(filename));
+    filenames.push_back(filename);
+  }
+
+  CountingPoolFilter filter;
+  REQUIRE(TexturePool::register_filter(&filter));
+
+  // Don't report every one of them being loaded.
+  NotifySeverity severity = gobj_cat->get_severity();
+  gobj_cat->set_severity(NS_warning);
+
+  // Every thread loads all of them, each starting somewhere else, so that
+  // they keep asking for the same textures at around the same time.
+  std::vector<std::vector<PT(Texture)> > results(num_threads);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; ++t) {
+    threads.emplace_back([&, t] {
+      std::vector<PT(Texture)> &result = results[t];
+      result.resize(num_textures);
+      int start = (t * num_textures) / num_threads;
+      for (int i = 0; i < num_textures; ++i) {
+        int n = (start + ((t & 1) ? num_textures - i : i)) % num_textures;
+        result[n] = TexturePool::load_texture(filenames[n]);
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+
+  gobj_cat->set_severity(severity);
+  TexturePool::unregister_filter(&filter);
+
+  // Each texture was read exactly once, and everyone got the same one.
+  CHECK(filter._num_loads == num_textures);
+  int num_mismatched = 0;
+  for (int n = 0; n < num_textures; ++n) {
+    Texture *tex = results[0][n];
+    REQUIRE(tex != nullptr);
+    CHECK(tex->get_fullpath() == filenames[n]);
+    for (int t = 1; t < num_threads; ++t) {
+      if (results[t][n] != tex) {
+        ++num_mismatched;
+      }
+    }
+  }
+  CHECK(num_mismatched == 0);
+
+  // Loading them again does not go to disk.
+  CHECK(TexturePool::load_texture(filenames[42]) == results[0][42]);
+  CHECK(filter._num_loads == num_textures);
+
+  for (int n = 0; n < num_textures; ++n) {
+    TexturePool::release_texture(results[0][n]);
+    filenames[n].unlink();
+  }
+  results.clear();
+  dir.rmdir();
+}
+
+TEST_CASE("TexturePool shares a failed load with waiting threads", "[gobj]") {
+  Filename missing = Filename::temporary(Filename::get_temp_directory().get_fullpath(), "missing", ".txo");
+
+  NotifySeverity severity = gobj_cat->get_severity();
+  gobj_cat->set_severity(NS_fatal);
+
+  std::atomic<int> num_loaded {0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&] {
+      if (TexturePool::load_texture(missing) != nullptr) {
+        ++num_loaded;
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+
+  gobj_cat->set_severity(severity);
+  CHECK(num_loaded == 0);
+  CHECK(!TexturePool::has_texture(missing));
+}
@@ -0,0 +1,234 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file test_texture_streaming.cxx
+ * @author rdb
+ * @date 2026-10-17
+ */
+
+#include "texture.h"
+#include "texturePool.h"
+#include "textureStreamingManager.h"
+#include "config_gobj.h"
+#include "clockObject.h"
+#include "loaderOptions.h"
+
+#include "catch_amalgamated.hpp"
+
+/**
+ * Writes a texture with a full mipmap chain to a temporary txo file, from
+ * which fresh copies can then be read.  The file is removed again when this
+ * object goes away.
+ */
+class StreamingFile {
+public:
+  StreamingFile(int size, int seed) {
+    _filename = Filename::temporary(Filename::get_temp_directory().get_fullpath(), "stream", ".txo");
+    _original = new Texture("stream");
+    _original->setup_2d_texture(size, size, Texture::T_unsigned_byte, Texture::F_rgba);
+    PTA_uchar image = _original->modify_ram_image();
+    for (size_t i = 0; i < image.size(); ++i) {
+      image[i] = (unsigned char)((i * 13 + seed * 71 + (i >> 7)) & 0xff);
+    }
+    _original->generate_ram_mipmap_images();
+    REQUIRE(_original->write(_filename));
+  }
+  ~StreamingFile() {
+    _filename.unlink();
+  }
+
+  PT(Texture) read() const {
+    PT(Texture) tex = new Texture("stream");
+    REQUIRE(tex->read(_filename));
+    return tex;
+  }
+
+  Filename _filename;
+  PT(Texture) _original;
+};
+
+/**
+ * Returns the number of bytes of the mipmap levels of a square RGBA texture
+ * of the given size, from the given level down.
+ */
+static size_t
+levels_size(int size, int first_level) {
+  size_t bytes = 0;
+  for (int n = first_level; (size >> n) > 0; ++n) {
+    bytes += (size_t)(size >> n) * (size >> n) * 4;
+  }
+  return bytes;
+}
+
+TEST_CASE("Texture streaming keeps only the smallest levels resident", "[gobj]") {
+  TextureStreamingManager *mgr = TextureStreamingManager::get_global_ptr();
+  texture_streaming_min_size = 32;
+  size_t base_bytes = mgr->get_resident_bytes();
+
+  StreamingFile file(256, 0);
+  PT(Texture) tex = file.read();
+  REQUIRE(tex->get_num_ram_mipmap_images() == 9);
+
+  mgr->add_texture(tex);
+  CHECK(tex->is_streaming());
+  CHECK(mgr->has_texture(tex));
+  CHECK(mgr->get_min_level(tex) == 3);
+  CHECK(mgr->get_resident_level(tex) == 3);
+  CHECK(tex->get_x_size() == 32);
+  CHECK(tex->get_y_size() == 32);
+  CHECK(tex->get_num_ram_mipmap_images() == 6);
+  CHECK(mgr->get_resident_bytes() - base_bytes == levels_size(256, 3));
+
+  // The resident levels are those of the original.
+  for (int n = 0; n < 6; ++n) {
+    CPTA_uchar a = tex->get_ram_mipmap_image(n);
+    CPTA_uchar b = file._original->get_ram_mipmap_image(n + 3);
+    REQUIRE(a.size() == b.size());
+    CHECK(memcmp(a.p(), b.p(), a.size()) == 0);
+  }
+
+  // Removing it from the manager keeps what is resident.
+  mgr->remove_texture(tex);
+  CHECK(!tex->is_streaming());
+  CHECK(mgr->get_resident_bytes() == base_bytes);
+  CHECK(tex->get_x_size() == 32);
+
+  texture_streaming_min_size.clear_local_value();
+}
+
+TEST_CASE("Texture streaming loads requested levels", "[gobj]") {
+  TextureStreamingManager *mgr = TextureStreamingManager::get_global_ptr();
+  texture_streaming_min_size = 16;
+  size_t base_bytes = mgr->get_resident_bytes();
+
+  StreamingFile file(64, 1);
+  PT(Texture) tex = file.read();
+  mgr->add_texture(tex);
+  REQUIRE(mgr->get_resident_level(tex) == 2);
+
+  // A level that is already resident is done right away.
+  PT(AsyncFuture) fut = mgr->request_level(tex, 2);
+  REQUIRE(fut != nullptr);
+  CHECK(fut->done());
+
+  fut = mgr->request_level(tex, 1, 5);
+  REQUIRE(fut != nullptr);
+  fut->wait();
+  CHECK(mgr->get_num_pending_requests() == 0);
+  CHECK(mgr->get_resident_level(tex) == 1);
+  CHECK(tex->get_x_size() == 32);
+  CHECK(tex->get_num_ram_mipmap_images() == 6);
+  CHECK(mgr->get_resident_bytes() - base_bytes == levels_size(64, 1));
+
+  mgr->request_level(tex, 0)->wait();
+  CHECK(mgr->get_resident_level(tex) == 0);
+  CHECK(tex->get_x_size() == 64);
+  REQUIRE(tex->get_num_ram_mipmap_images() == 7);
+  for (int n = 0; n < 7; ++n) {
+    CPTA_uchar a = tex->get_ram_mipmap_image(n);
+    CPTA_uchar b = file._original->get_ram_mipmap_image(n);
+    REQUIRE(a.size() == b.size());
+    CHECK(memcmp(a.p(), b.p(), a.size()) == 0);
+  }
+
+  // Destroying the texture gives back its bytes.
+  tex.clear();
+  CHECK(mgr->get_resident_bytes() == base_bytes);
+
+  texture_streaming_min_size.clear_local_value();
+}
+
+TEST_CASE("Texture streaming evicts levels to stay within budget", "[gobj]") {
+  TextureStreamingManager *mgr = TextureStreamingManager::get_global_ptr();
+  ClockObject *clock = ClockObject::get_global_clock();
+  texture_streaming_min_size = 16;
+  size_t base_bytes = mgr->get_resident_bytes();
+
+  StreamingFile file_a(64, 2);
+  StreamingFile file_b(64, 3);
+  PT(Texture) a = file_a.read();
+  PT(Texture) b = file_b.read();
+  mgr->add_texture(a);
+  mgr->add_texture(b);
+
+  // There is room for one of them to be at full size.
+  size_t budget = base_bytes + levels_size(64, 0) + levels_size(64, 2);
+  mgr->set_budget(budget);
+
+  clock->tick();
+  mgr->request_level(a, 0, 10)->wait();
+  CHECK(mgr->get_resident_level(a) == 0);
+
+  SECTION("in favor of a more recently used texture") {
+    // A has not been used this frame, so it makes room for B.
+    clock->tick();
+    mgr->request_level(b, 0, 1)->wait();
+    CHECK(mgr->get_resident_level(b) == 0);
+    CHECK(mgr->get_resident_level(a) == 2);
+    CHECK(a->get_x_size() == 16);
+  }
+
+  SECTION("but not for a less important texture") {
+    // In the same frame, the one with the higher priority wins.
+    mgr->request_level(b, 0, 1)->wait();
+    CHECK(mgr->get_resident_level(a) == 0);
+    CHECK(mgr->get_resident_level(b) == 2);
+  }
+
+  CHECK(mgr->get_resident_bytes() <= budget);
+
+  // Lowering the budget drops levels right away, but never the smallest.
+  mgr->set_budget(0);
+  CHECK(mgr->get_resident_level(a) == 2);
+  CHECK(mgr->get_resident_level(b) == 2);
+  CHECK(mgr->get_resident_bytes() - base_bytes == 2 * levels_size(64, 2));
+
+  mgr->set_budget(-1);
+  mgr->remove_texture(a);
+  mgr->remove_texture(b);
+  texture_streaming_min_size.clear_local_value();
+}
+
+TEST_CASE("Texture streaming maps screen size to mipmap level", "[gobj]") {
+  TextureStreamingManager *mgr = TextureStreamingManager::get_global_ptr();
+  ClockObject *clock = ClockObject::get_global_clock();
+  texture_streaming_min_size = 8;
+
+  StreamingFile file(64, 4);
+  PT(Texture) tex = file.read();
+  mgr->add_texture(tex);
+  REQUIRE(mgr->get_resident_level(tex) == 3);
+
+  // An object that covers 20 pixels needs the 32x32 level.
+  clock->tick();
+  mgr->request_screen_size(tex, 20);
+  for (int i = 0; i < 100 && mgr->get_num_pending_requests() > 0; ++i) {
+    Thread::sleep(0.01);
+  }
+  CHECK(mgr->get_resident_level(tex) == 1);
+
+  mgr->remove_texture(tex);
+  texture_streaming_min_size.clear_local_value();
+}
+
+TEST_CASE("TexturePool streams textures loaded with TF_streaming", "[gobj]") {
+  texture_streaming_min_size = 16;
+
+  StreamingFile file(64, 5);
+  LoaderOptions options;
+  options.set_texture_flags(options.get_texture_flags() | LoaderOptions::TF_streaming);
+  PT(Texture) tex = TexturePool::load_texture(file._filename, 0, false, options);
+  REQUIRE(tex != nullptr);
+  CHECK(tex->is_streaming());
+  CHECK(tex->get_x_size() == 16);
+  CHECK(tex->has_ram_image());
+
+  TexturePool::release_texture(tex);
+  TextureStreamingManager::get_global_ptr()->remove_texture(tex);
+  texture_streaming_min_size.clear_local_value();
+}
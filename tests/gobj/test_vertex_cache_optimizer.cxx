@@ -0,0 +1,90 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file test_vertex_cache_optimizer.cxx
+ * @author rdb
+ * @date 2026-10-17
+ */
+
+#include "geom.h"
+#include "geomTriangles.h"
+#include "geomVertexData.h"
+#include "geomVertexWriter.h"
+#include "vertexCacheOptimizer.h"
+#include "randomizer.h"
+
+#include "catch_amalgamated.hpp"
+
+#include <algorithm>
+#include <array>
+
+/**
+ * Makes a Geom containing a grid of size x size quads, whose triangles are
+ * listed in a random order, to simulate a badly ordered mesh.
+ */
+static PT(Geom)
+make_shuffled_grid(int size) {
+  int num_vertices = (size + 1) * (size + 1);
+  PT(GeomVertexData) vdata = new GeomVertexData
+    ("grid", GeomVertexFormat::get_v3n3(), GeomEnums::UH_static);
+  vdata->unclean_set_num_rows(num_vertices);
+
+  GeomVertexWriter vertex(vdata, InternalName::get_vertex());
+  GeomVertexWriter normal(vdata, InternalName::get_normal());
+  for (int i = 0; i < num_vertices; ++i) {
+    PN_stdfloat x = (PN_stdfloat)(i % (size + 1));
+    PN_stdfloat y = (PN_stdfloat)(i / (size + 1));
+    vertex.set_data3(x, y, csin(x * 0.3f) + ccos(y * 0.2f));
+    normal.set_data3(0, 0, 1);
+  }
+
+  pvector<std::array<int, 3> > triangles;
+  for (int y = 0; y < size; ++y) {
+    for (int x = 0; x < size; ++x) {
+      int v = y * (size + 1) + x;
+      triangles.push_back({v, v + 1, v + size + 2});
+      triangles.push_back({v, v + size + 2, v + size + 1});
+    }
+  }
+  Randomizer random(42);
+  for (size_t i = triangles.size() - 1; i > 0; --i) {
+    std::swap(triangles[i], triangles[random.random_int((int)i + 1)]);
+  }
+
+  PT(GeomTriangles) tris = new GeomTriangles(GeomEnums::UH_static);
+  for (const std::array<int, 3> &tri : triangles) {
+    tris->add_vertices(tri[0], tri[1], tri[2]);
+  }
+
+  PT(Geom) geom = new Geom(vdata);
+  geom->add_primitive(tris);
+  return geom;
+}
+
+TEST_CASE("VertexCacheOptimizer computes the ACMR", "[gobj]") {
+  // Each triangle shares an edge with the last, so after the first triangle
+  // only one vertex is transformed per triangle.
+  static const int fan[] = {0, 1, 2, 0, 2, 3, 0, 3, 4, 0, 4, 5};
+  CHECK(VertexCacheOptimizer::calc_acmr(fan, 12, 6, 16) == Catch::Approx(6.0 / 4));
+
+  // With a cache size of 3, every vertex that was not in the last triangle
+  // is a miss, including the center of the fan after the first eviction.
+  CHECK(VertexCacheOptimizer::calc_acmr(fan, 12, 6, 3) > 6.0 / 4);
+
+  CHECK(VertexCacheOptimizer::calc_acmr(nullptr, 0, 0, 16) == 0);
+}
+
+// This measures the cost of optimizing a large mesh.  Run it explicitly
+// with: run_cxx_tests "[benchmark]"
+TEST_CASE("Vertex cache optimization", "[.][benchmark][gobj]") {
+  PT(Geom) geom = make_shuffled_grid(256);
+
+  BENCHMARK("optimize 131072 triangles") {
+    return geom->optimize_vertex_cache(true);
+  };
+}
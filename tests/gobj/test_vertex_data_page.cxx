@@ -0,0 +1,114 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file test_vertex_data_page.cxx
+ * @author rdb
+ * @date 2026-10-17
+ */
+
+#include "vertexDataBook.h"
+#include "vertexDataBlock.h"
+#include "vertexDataPage.h"
+#include "vertexDataSaveFile.h"
+#include "config_gobj.h"
+#include "thread.h"
+
+#include "catch_amalgamated.hpp"
+
+static const size_t page_data_size = 64 * 1024;
+
+/**
+ * Fills the indicated block with a pattern that compresses well, and returns
+ * the pointer to its data.
+ */
+static unsigned char *
+fill_block(VertexDataBlock *block, size_t size) {
+  unsigned char *data = block->get_pointer(true);
+  for (size_t i = 0; i < size; ++i) {
+    data[i] = (unsigned char)((i / 64) & 0xff);
+  }
+  return data;
+}
+
+/**
+ * Returns true if the block still holds the pattern written by fill_block().
+ */
+static bool
+check_block(VertexDataBlock *block, size_t size) {
+  const unsigned char *data = block->get_pointer(true);
+  for (size_t i = 0; i < size; ++i) {
+    if (data[i] != (unsigned char)((i / 64) & 0xff)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+TEST_CASE("VertexDataPage compresses pages written to disk", "[gobj]") {
+  VertexDataBook book(page_data_size);
+  PT(VertexDataBlock) block = book.alloc(page_data_size);
+  REQUIRE(block != nullptr);
+  fill_block(block, page_data_size);
+
+  VertexDataPage *page = block->get_page();
+  REQUIRE(page->get_ram_class() == VertexDataPage::RC_resident);
+
+  VertexDataSaveFile *save_file = VertexDataPage::get_save_file();
+  size_t used_before = (save_file != nullptr) ? save_file->get_used_file_size() : 0;
+
+  ((SimpleLruPage *)page)->evict_lru();
+  VertexDataPage::flush_threads();
+
+  CHECK(page->get_ram_class() == VertexDataPage::RC_disk);
+
+  save_file = VertexDataPage::get_save_file();
+  REQUIRE(save_file != nullptr);
+  size_t used = save_file->get_used_file_size() - used_before;
+  CHECK(used > 0);
+#ifdef HAVE_ZLIB
+  // vertex-data-compress-on-disk is on by default.
+  CHECK(used < page_data_size / 2);
+#endif
+
+  CHECK(check_block(block, page_data_size));
+  CHECK(page->get_ram_class() == VertexDataPage::RC_resident);
+
+  // Don't leave the paging threads waiting around at exit.
+  VertexDataPage::stop_threads();
+}
+
+TEST_CASE("VertexDataPage prefetch reads page in the background", "[gobj]") {
+  VertexDataBook book(page_data_size);
+  PT(VertexDataBlock) block = book.alloc(page_data_size);
+  REQUIRE(block != nullptr);
+  fill_block(block, page_data_size);
+
+  VertexDataPage *page = block->get_page();
+  CHECK(page->request_prefetch());
+
+  ((SimpleLruPage *)page)->evict_lru();
+  VertexDataPage::flush_threads();
+  REQUIRE(page->get_ram_class() == VertexDataPage::RC_disk);
+
+  // This does not wait for the page to be read.
+  CHECK_FALSE(page->request_prefetch());
+
+  VertexDataPage::flush_threads();
+  if (Thread::is_threading_supported() && vertex_data_page_threads > 0) {
+    CHECK(page->get_ram_class() == VertexDataPage::RC_resident);
+  } else {
+    // Without page threads, a prefetch is only a hint, and does nothing.
+    CHECK(page->get_ram_class() == VertexDataPage::RC_disk);
+  }
+  CHECK(VertexDataPage::get_num_pending_prefetches() == 0);
+
+  CHECK(check_block(block, page_data_size));
+  CHECK(page->get_ram_class() == VertexDataPage::RC_resident);
+
+  VertexDataPage::stop_threads();
+}
@@ -0,0 +1,93 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file test_bounding_volume_batch.cxx
+ * @author rdb
+ * @date 2026-10-17
+ */
+
+#include "boundingVolumeBatch.h"
+#include "boundingSphere.h"
+#include "boundingBox.h"
+#include "boundingHexahedron.h"
+#include "omniBoundingVolume.h"
+#include "pvector.h"
+
+#include "catch_amalgamated.hpp"
+
+static PT(BoundingHexahedron)
+make_frustum() {
+  LFrustum frustum;
+  frustum.make_perspective(60, 45, 1, 100);
+  return new BoundingHexahedron(frustum, false, CS_zup_right);
+}
+
+/**
+ * Checks that the batch gives the same results as contains() for each of the
+ * indicated volumes.
+ */
+static void
+check_batch(const GeometricBoundingVolume *frustum,
+            const pvector<PT(GeometricBoundingVolume)> &volumes) {
+  BoundingVolumeBatch batch;
+  for (const GeometricBoundingVolume *volume : volumes) {
+    batch.add_volume(volume);
+  }
+  REQUIRE(batch.get_num_volumes() == volumes.size());
+
+  pvector<int> results(volumes.size(), -1);
+  batch.contained_by(frustum, &results[0]);
+
+  for (size_t i = 0; i < volumes.size(); ++i) {
+    INFO("volume " << i << ": " << *volumes[i]);
+    CHECK(results[i] == frustum->contains(volumes[i]));
+  }
+}
+
+TEST_CASE("BoundingVolumeBatch matches contains() for spheres", "[mathutil]") {
+  PT(BoundingHexahedron) frustum = make_frustum();
+
+  // Sweep a grid of spheres of varying sizes through and around the frustum,
+  // so that we get a mix of spheres that are fully inside, partially inside
+  // and fully outside.  The count is not a multiple of four, so that the
+  // remainder is tested as well.
+  pvector<PT(GeometricBoundingVolume)> volumes;
+  for (int x = -60; x <= 60; x += 15) {
+    for (int y = -10; y <= 110; y += 15) {
+      for (int z = -40; z <= 40; z += 20) {
+        PN_stdfloat radius = 0.5f + (PN_stdfloat)((x + y + z) & 15);
+        volumes.push_back(new BoundingSphere(LPoint3(x, y, z), radius));
+      }
+    }
+  }
+  volumes.push_back(new BoundingSphere(LPoint3(0, 50, 0), 1));
+  REQUIRE(volumes.size() % 4 != 0);
+
+  check_batch(frustum, volumes);
+}
+
+TEST_CASE("BoundingVolumeBatch matches contains() for other volumes", "[mathutil]") {
+  PT(BoundingHexahedron) frustum = make_frustum();
+
+  pvector<PT(GeometricBoundingVolume)> volumes;
+  volumes.push_back(new BoundingSphere(LPoint3(0, 10, 0), 1));
+  volumes.push_back(new BoundingBox(LPoint3(-1, 9, -1), LPoint3(1, 11, 1)));
+  volumes.push_back(new BoundingSphere);
+  volumes.push_back(new OmniBoundingVolume);
+  volumes.push_back(new BoundingBox(LPoint3(-1, -11, -1), LPoint3(1, -9, 1)));
+  volumes.push_back(new BoundingSphere(LPoint3(0, -10, 0), 1));
+  volumes.push_back(new BoundingSphere(LPoint3(0, 100, 0), 5));
+  volumes.push_back(new BoundingSphere(LPoint3(0, 50, 0), 500));
+
+  check_batch(frustum, volumes);
+
+  // Against a frustum that isn't a hexahedron, everything is tested one by
+  // one, but the results should still be the same.
+  PT(BoundingSphere) sphere = new BoundingSphere(LPoint3(0, 10, 0), 5);
+  check_batch(sphere, volumes);
+}
@@ -0,0 +1,321 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file test_cull_result.cxx
+ * @author rdb
+ * @date 2026-10-17
+ */
+
+#include "cullResult.h"
+#include "cullTraverser.h"
+#include "binCullHandler.h"
+#include "sceneSetup.h"
+#include "sceneSnapshot.h"
+#include "camera.h"
+#include "perspectiveLens.h"
+#include "geomNode.h"
+#include "geomTriangles.h"
+#include "geomVertexWriter.h"
+#include "colorAttrib.h"
+#include "shaderAttrib.h"
+#include "cullBinAttrib.h"
+#include "geomVertexReader.h"
+#include "graphicsEngine.h"
+#include "graphicsPipeSelection.h"
+#include "graphicsOutput.h"
+#include "frameBufferProperties.h"
+#include "windowProperties.h"
+#include "configVariableInt.h"
+#include "configVariableBool.h"
+
+#include "catch_amalgamated.hpp"
+
+/**
+ * Opens an offscreen tinydisplay buffer for the duration of a test, since
+ * the CullResult needs its GSG for munging.  get_gsg() returns nullptr if
+ * tinydisplay isn't available.  The buffer is closed again at the end of the
+ * test, which also terminates the render threads.
+ */
+class CullResultBuffer {
+public:
+  CullResultBuffer() {
+    GraphicsPipeSelection *selection = GraphicsPipeSelection::get_global_ptr();
+    PT(GraphicsPipe) pipe = selection->make_pipe("TinyOffscreenGraphicsPipe", "p3tinydisplay");
+    if (pipe != nullptr && pipe->is_valid()) {
+      GraphicsEngine *engine = GraphicsEngine::get_global_ptr();
+      _buffer = engine->make_output(pipe, "buffer", 0, FrameBufferProperties(),
+                                    WindowProperties::size(32, 32),
+                                    GraphicsPipe::BF_refuse_window);
+      engine->open_windows();
+    }
+  }
+
+  ~CullResultBuffer() {
+    if (_buffer != nullptr) {
+      GraphicsEngine::get_global_ptr()->remove_all_windows();
+    }
+  }
+
+  GraphicsStateGuardian *get_gsg() const {
+    return (_buffer != nullptr) ? _buffer->get_gsg() : nullptr;
+  }
+
+private:
+  GraphicsOutput *_buffer = nullptr;
+};
+
+static PT(Geom)
+make_cull_result_triangle() {
+  PT(GeomVertexData) vdata = new GeomVertexData("tri", GeomVertexFormat::get_v3(), Geom::UH_static);
+  GeomVertexWriter vertex(vdata, InternalName::get_vertex());
+  vertex.add_data3(0, 0, 0);
+  vertex.add_data3(1, 0, 0);
+  vertex.add_data3(0, 0, 1);
+
+  PT(GeomTriangles) tris = new GeomTriangles(Geom::UH_static);
+  tris->add_vertices(0, 1, 2);
+
+  PT(Geom) geom = new Geom(vdata);
+  geom->add_primitive(tris);
+  return geom;
+}
+
+/**
+ * Runs a cull traversal of the given scene into a new CullResult, as the
+ * GraphicsEngine would, but without finishing the cull, so that the bins
+ * still hold their objects in the order in which they were found.  If a
+ * snapshot of the scene is given, the traversal uses it.
+ */
+static PT(CullResult)
+cull_into_result(GraphicsStateGuardian *gsg, const NodePath &root,
+                 int num_threads, SceneSnapshot *snapshot = nullptr) {
+  PT(Camera) camera = new Camera("camera", new PerspectiveLens);
+  NodePath camera_np = root.attach_new_node(camera);
+  camera_np.set_pos(0, -50, 0);
+
+  PT(SceneSetup) scene_setup = new SceneSetup;
+  scene_setup->set_scene_root(root);
+  scene_setup->set_camera_path(camera_np);
+  scene_setup->set_camera_node(camera);
+  scene_setup->set_lens(camera->get_lens());
+  scene_setup->set_initial_state(RenderState::make_empty());
+  scene_setup->set_camera_transform(camera_np.get_transform(root));
+  scene_setup->set_world_transform(root.get_transform(camera_np));
+  scene_setup->set_cs_transform(TransformState::make_identity());
+  scene_setup->set_cs_world_transform(root.get_transform(camera_np));
+
+  PT(CullResult) result = new CullResult(gsg, PStatCollector("test"));
+  BinCullHandler handler(result);
+
+  CullTraverser trav;
+  trav.set_cull_handler(&handler);
+  trav.set_num_threads(num_threads);
+  trav.set_scene_snapshot(snapshot);
+  trav.set_scene(scene_setup, gsg, false);
+  trav.traverse(root);
+  trav.end_traverse();
+
+  camera_np.remove_node();
+  return result;
+}
+
+TEST_CASE("CullTraverser finds the same objects in the same order in parallel", "[pgraph]") {
+  CullResultBuffer buffer;
+  GraphicsStateGuardian *gsg = buffer.get_gsg();
+  if (gsg == nullptr) {
+    SKIP("tinydisplay offscreen buffers are not available");
+  }
+
+  // Each child has a different transform, some of them a different state,
+  // and a subtree of its own, to check that the objects found by each worker
+  // end up in the right place.
+  PT(Geom) geom = make_cull_result_triangle();
+  NodePath root("root");
+  int num_children = ConfigVariableInt("cull-parallel-min-children").get_value() * 4;
+  for (int i = 0; i < num_children; ++i) {
+    NodePath child = root.attach_new_node("child");
+    child.set_pos(i, 0, 0);
+    if (i % 3 == 0) {
+      child.set_color(LColor(1, 0, 0, 1));
+    }
+    for (int j = 0; j < 3; ++j) {
+      PT(GeomNode) geom_node = new GeomNode("leaf");
+      geom_node->add_geom(geom);
+      child.attach_new_node(geom_node).set_pos(0, 0, j);
+    }
+  }
+
+  // The parallel traversal of a snapshot of the scene must agree as well.
+  bool use_snapshot = GENERATE(false, true);
+  CAPTURE(use_snapshot);
+  PT(SceneSnapshot) snapshot;
+  if (use_snapshot) {
+    snapshot = new SceneSnapshot(root);
+  }
+
+  PT(PandaNode) serial = cull_into_result(gsg, root, 0)->make_result_graph();
+  PT(PandaNode) parallel = cull_into_result(gsg, root, 4, snapshot)->make_result_graph();
+
+  // The result graph has a node per bin, each with a GeomNode per object.
+  REQUIRE(serial->get_num_children() == 1);
+  REQUIRE(parallel->get_num_children() == serial->get_num_children());
+  PandaNode *serial_bin = serial->get_child(0);
+  PandaNode *parallel_bin = parallel->get_child(0);
+  CHECK(parallel_bin->get_name() == serial_bin->get_name());
+  REQUIRE(serial_bin->get_num_children() == num_children * 3);
+  REQUIRE(parallel_bin->get_num_children() == serial_bin->get_num_children());
+
+  for (int i = 0; i < serial_bin->get_num_children(); ++i) {
+    GeomNode *a = DCAST(GeomNode, serial_bin->get_child(i));
+    GeomNode *b = DCAST(GeomNode, parallel_bin->get_child(i));
+    CHECK(b->get_transform() == a->get_transform());
+    CHECK(b->get_state() == a->get_state());
+    REQUIRE(a->get_num_geoms() == 1);
+    REQUIRE(b->get_num_geoms() == 1);
+    CHECK(b->get_geom(0)->get_vertex_data() == a->get_geom(0)->get_vertex_data());
+  }
+
+  // And they are in the order of the scene graph.
+  GeomNode *last = DCAST(GeomNode, serial_bin->get_child(num_children * 3 - 1));
+  CHECK(last->get_transform()->get_pos().almost_equal(LPoint3(num_children - 1, 50, 2)));
+}
+
+/**
+ * Adds count GeomNodes with the given Geom and state to the root, each with a
+ * different transform.  They are all scaled, so that they end up with the
+ * same RescaleNormalAttrib.
+ */
+static void
+add_instanced_nodes(NodePath root, Geom *geom, const RenderState *state,
+                    int count, pvector<NodePath> &nodes) {
+  for (int i = 0; i < count; ++i) {
+    PT(GeomNode) geom_node = new GeomNode("instance");
+    geom_node->add_geom(geom, state);
+    NodePath np = root.attach_new_node(geom_node);
+    np.set_pos_hpr_scale(i * 2, i, -i, i * 30, 0, i * 10, 1, 1, 1.5f + i * 0.5f);
+    nodes.push_back(np);
+  }
+}
+
+/**
+ * Returns the node for the named bin in the result graph of a CullResult.
+ */
+static PandaNode *
+find_result_bin(PandaNode *result_graph, const std::string &name) {
+  for (int i = 0; i < result_graph->get_num_children(); ++i) {
+    if (result_graph->get_child(i)->get_name() == name) {
+      return result_graph->get_child(i);
+    }
+  }
+  return nullptr;
+}
+
+/**
+ * Returns the number of instances that the munger stored in the vertex data
+ * of the first Geom of the indicated GeomNode, or 0 if it isn't instanced.
+ */
+static int
+get_num_munged_instances(PandaNode *node) {
+  CPT(GeomVertexData) vdata = DCAST(GeomNode, node)->get_geom(0)->get_vertex_data();
+  int array_index = vdata->get_format()->get_array_with(InternalName::get_instance_matrix());
+  if (array_index < 0) {
+    return 0;
+  }
+  return vdata->get_array(array_index)->get_num_rows();
+}
+
+TEST_CASE("CullResult batches instanced objects in state-sorted bins", "[pgraph]") {
+  CullResultBuffer buffer;
+  GraphicsStateGuardian *gsg = buffer.get_gsg();
+  if (gsg == nullptr) {
+    SKIP("tinydisplay offscreen buffers are not available");
+  }
+
+  ConfigVariableBool batching("cull-instance-batching");
+  batching.set_value(true);
+
+  static const int num_instances = 5;
+  PT(Geom) geom = make_cull_result_triangle();
+  CPT(RenderAttrib) shader_attrib = DCAST(ShaderAttrib, ShaderAttrib::make())
+    ->set_flag(ShaderAttrib::F_hardware_instancing, true);
+  CPT(RenderState) state = RenderState::make(shader_attrib);
+
+  NodePath root("root");
+  pvector<NodePath> nodes;
+  add_instanced_nodes(root, geom, state, num_instances, nodes);
+
+  // These aren't batched, because the shader doesn't do instancing.
+  pvector<NodePath> plain_nodes;
+  add_instanced_nodes(root, geom, RenderState::make_empty(), 2, plain_nodes);
+
+  PT(PandaNode) result_graph = cull_into_result(gsg, root, 0)->make_result_graph();
+  batching.clear_local_value();
+
+  // The batch is held back until the end of the traversal, so it comes last.
+  PandaNode *opaque = find_result_bin(result_graph, "opaque");
+  REQUIRE(opaque != nullptr);
+  REQUIRE(opaque->get_num_children() == 3);
+  CHECK(get_num_munged_instances(opaque->get_child(0)) == 0);
+  CHECK(get_num_munged_instances(opaque->get_child(1)) == 0);
+
+  // It has the transform of the first object, and the transform of each
+  // instance is relative to that.
+  PandaNode *batch = opaque->get_child(2);
+  REQUIRE(get_num_munged_instances(batch) == num_instances);
+
+  LMatrix4 cs_world_mat = LMatrix4::translate_mat(0, 50, 0);
+  CPT(TransformState) base = batch->get_transform();
+  CHECK(base->get_mat().almost_equal(nodes[0].get_net_transform()->get_mat() * cs_world_mat));
+
+  GeomVertexReader reader(DCAST(GeomNode, batch)->get_geom(0)->get_vertex_data(),
+                          InternalName::get_instance_matrix());
+  for (int i = 0; i < num_instances; ++i) {
+    CPT(TransformState) internal_transform =
+      TransformState::make_mat(nodes[i].get_net_transform()->get_mat() * cs_world_mat);
+    CPT(TransformState) expected = base->invert_compose(internal_transform);
+    CHECK(reader.get_matrix4().almost_equal(expected->get_mat()));
+  }
+}
+
+TEST_CASE("CullResult leaves instanced objects in other bins alone", "[pgraph]") {
+  CullResultBuffer buffer;
+  GraphicsStateGuardian *gsg = buffer.get_gsg();
+  if (gsg == nullptr) {
+    SKIP("tinydisplay offscreen buffers are not available");
+  }
+
+  ConfigVariableBool batching("cull-instance-batching");
+  batching.set_value(true);
+
+  PT(Geom) geom = make_cull_result_triangle();
+  CPT(RenderAttrib) shader_attrib = DCAST(ShaderAttrib, ShaderAttrib::make())
+    ->set_flag(ShaderAttrib::F_hardware_instancing, true);
+
+  // Batching these would change the order in which they are drawn.
+  NodePath root("root");
+  pvector<NodePath> nodes;
+  add_instanced_nodes(root, geom, RenderState::make(shader_attrib, CullBinAttrib::make("unsorted", 0)), 4, nodes);
+  add_instanced_nodes(root, geom, RenderState::make(shader_attrib, CullBinAttrib::make("transparent", 0)), 3, nodes);
+
+  PT(PandaNode) result_graph = cull_into_result(gsg, root, 0)->make_result_graph();
+  batching.clear_local_value();
+
+  PandaNode *unsorted = find_result_bin(result_graph, "unsorted");
+  REQUIRE(unsorted != nullptr);
+  REQUIRE(unsorted->get_num_children() == 4);
+  for (int i = 0; i < unsorted->get_num_children(); ++i) {
+    CHECK(get_num_munged_instances(unsorted->get_child(i)) == 0);
+  }
+
+  PandaNode *transparent = find_result_bin(result_graph, "transparent");
+  REQUIRE(transparent != nullptr);
+  REQUIRE(transparent->get_num_children() == 3);
+  for (int i = 0; i < transparent->get_num_children(); ++i) {
+    CHECK(get_num_munged_instances(transparent->get_child(i)) == 0);
+  }
+}
@@ -0,0 +1,114 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file test_flatten.cxx
+ * @author rdb
+ * @date 2026-10-17
+ */
+
+#include "sceneGraphReducer.h"
+#include "nodePath.h"
+#include "geomNode.h"
+#include "geom.h"
+#include "geomTriangles.h"
+#include "geomVertexData.h"
+#include "geomVertexWriter.h"
+#include "colorAttrib.h"
+
+#include "catch_amalgamated.hpp"
+
+/**
+ * Returns a GeomNode with a single box-shaped Geom in it, with its own
+ * GeomVertexData.
+ */
+static PT(GeomNode)
+make_box(const std::string &name, PN_stdfloat size) {
+  PT(GeomVertexData) vdata = new GeomVertexData
+    ("building", GeomVertexFormat::get_v3n3(), Geom::UH_static);
+  vdata->unclean_set_num_rows(8);
+  GeomVertexWriter vertex(vdata, InternalName::get_vertex());
+  GeomVertexWriter normal(vdata, InternalName::get_normal());
+  for (int i = 0; i < 8; ++i) {
+    LPoint3 point((i & 1) ? size : 0, (i & 2) ? size : 0, (i & 4) ? size * 3 : 0);
+    vertex.set_data3(point);
+    normal.set_data3(normalize(point - LPoint3(size / 2)));
+  }
+
+  static const int faces[6][4] = {
+    {0, 1, 3, 2}, {4, 6, 7, 5}, {0, 4, 5, 1},
+    {2, 3, 7, 6}, {0, 2, 6, 4}, {1, 5, 7, 3},
+  };
+  PT(GeomTriangles) tris = new GeomTriangles(Geom::UH_static);
+  for (const int *face : faces) {
+    tris->add_vertices(face[0], face[1], face[2]);
+    tris->add_vertices(face[0], face[2], face[3]);
+  }
+
+  PT(Geom) geom = new Geom(vdata);
+  geom->add_primitive(tris);
+
+  PT(GeomNode) node = new GeomNode(name);
+  node->add_geom(geom);
+  return node;
+}
+
+/**
+ * Builds a city of the indicated number of blocks, each with the indicated
+ * number of buildings, each in their own node with their own transform.
+ * Alternate blocks are colored differently, so that not everything can be
+ * combined together.
+ */
+static NodePath
+make_city(int num_blocks, int num_buildings) {
+  NodePath city("city");
+  for (int b = 0; b < num_blocks; ++b) {
+    NodePath block = city.attach_new_node("block");
+    block.set_pos(b * 100, 0, 0);
+    if (b % 2 == 1) {
+      block.set_color(LColor(1, 0, 0, 1));
+    }
+    for (int i = 0; i < num_buildings; ++i) {
+      NodePath lot = block.attach_new_node("lot");
+      lot.set_pos((i % 10) * 10, (i / 10) * 10, 0);
+      lot.attach_new_node(make_box("building", 2 + i % 5));
+    }
+  }
+  return city;
+}
+
+/**
+ * Performs the same operations as NodePath::flatten_strong(), using the
+ * indicated number of threads.  Returns the number of nodes removed.
+ */
+static int
+flatten_strong(NodePath &root, int num_threads) {
+  SceneGraphReducer gr;
+  gr.set_num_threads(num_threads);
+  gr.apply_attribs(root.node());
+  int num_removed = gr.flatten(root.node(), ~0);
+  gr.make_compatible_state(root.node());
+  gr.collect_vertex_data(root.node(), ~(SceneGraphReducer::CVD_format | SceneGraphReducer::CVD_name | SceneGraphReducer::CVD_animation_type));
+  gr.unify(root.node(), false);
+  return num_removed;
+}
+
+// This measures how flattening scales with the number of threads.  Run it
+// explicitly with: run_cxx_tests "[benchmark]"
+TEST_CASE("Flatten with threads", "[.][benchmark][pgraph]") {
+  for (int num_threads : {0, 1, 2, 4, 8}) {
+    BENCHMARK_ADVANCED("flatten_strong with " + std::to_string(num_threads) + " threads")(Catch::Benchmark::Chronometer meter) {
+      pvector<NodePath> cities;
+      for (int i = 0; i < meter.runs(); ++i) {
+        cities.push_back(make_city(32, 100));
+      }
+      meter.measure([&] (int i) {
+        return flatten_strong(cities[i], num_threads);
+      });
+    };
+  }
+}
@@ -0,0 +1,107 @@
+from panda3d.core import SceneGraphReducer, NodePath, GeomNode, Geom
+from panda3d.core import GeomVertexData, GeomVertexFormat, GeomVertexWriter
+from panda3d.core import GeomTriangles, LPoint3
+
+
+def make_box(name, size):
+    # Returns a GeomNode with a single box-shaped Geom in it, with its own
+    # GeomVertexData.
+    vdata = GeomVertexData("building", GeomVertexFormat.get_v3n3(), Geom.UH_static)
+    vertex = GeomVertexWriter(vdata, "vertex")
+    normal = GeomVertexWriter(vdata, "normal")
+    for i in range(8):
+        point = LPoint3(size if i & 1 else 0, size if i & 2 else 0, size * 3 if i & 4 else 0)
+        vertex.add_data3(point)
+        normal.add_data3((point - LPoint3(size / 2)).normalized())
+
+    tris = GeomTriangles(Geom.UH_static)
+    for face in ((0, 1, 3, 2), (4, 6, 7, 5), (0, 4, 5, 1),
+                 (2, 3, 7, 6), (0, 2, 6, 4), (1, 5, 7, 3)):
+        tris.add_vertices(face[0], face[1], face[2])
+        tris.add_vertices(face[0], face[2], face[3])
+
+    geom = Geom(vdata)
+    geom.add_primitive(tris)
+    node = GeomNode(name)
+    node.add_geom(geom)
+    return node
+
+
+def make_city(num_blocks, num_buildings):
+    # Builds a city of blocks of buildings, each in their own node with their
+    # own transform.  Alternate blocks are colored differently, so that not
+    # everything can be combined together.
+    city = NodePath("city")
+    for b in range(num_blocks):
+        block = city.attach_new_node("block")
+        block.set_pos(b * 100, 0, 0)
+        if b % 2 == 1:
+            block.set_color(1, 0, 0, 1)
+        for i in range(num_buildings):
+            lot = block.attach_new_node("lot")
+            lot.set_pos((i % 10) * 10, (i // 10) * 10, 0)
+            lot.attach_new_node(make_box("building", 2 + i % 5))
+    return city
+
+
+def flatten_strong(root, num_threads):
+    # Performs the same operations as NodePath.flatten_strong(), using the
+    # indicated number of threads.  Returns the number of nodes removed.
+    gr = SceneGraphReducer()
+    gr.set_num_threads(num_threads)
+    gr.apply_attribs(root.node())
+    num_removed = gr.flatten(root.node(), ~0)
+    gr.make_compatible_state(root.node())
+    gr.collect_vertex_data(root.node(), ~(SceneGraphReducer.CVD_format |
+                                          SceneGraphReducer.CVD_name |
+                                          SceneGraphReducer.CVD_animation_type))
+    gr.unify(root.node(), False)
+    return num_removed
+
+
+def describe(node):
+    # Returns the structure of the scene graph, along with the contents of all
+    # of its Geoms, as a list that may be compared with that of another graph.
+    result = [(str(node), str(node.get_transform()), str(node.get_state()))]
+    if node.is_geom_node():
+        for i in range(node.get_num_geoms()):
+            geom = node.get_geom(i)
+            vdata = geom.get_vertex_data()
+            result.append(str(node.get_geom_state(i)))
+            result.append(str(vdata.get_format()))
+            for array in vdata.get_arrays():
+                result.append(memoryview(array).tobytes())
+            for prim in geom.get_primitives():
+                result.append((type(prim), tuple(prim.get_vertex_list())))
+    for child in node.get_children():
+        result += describe(child)
+    return result
+
+
+def test_flatten_threads():
+    serial = make_city(8, 20)
+    parallel = make_city(8, 20)
+
+    serial_removed = flatten_strong(serial, 0)
+    parallel_removed = flatten_strong(parallel, 4)
+    assert parallel_removed == serial_removed
+    assert serial_removed > 0
+
+    assert describe(parallel.node()) == describe(serial.node())
+
+    # The blocks have been combined, according to their color.
+    assert parallel.node().get_num_children() <= 2
+
+
+def test_flatten_threads_instanced():
+    serial = make_city(4, 10)
+    parallel = make_city(4, 10)
+
+    # Share a building between two blocks; this rules out flattening the
+    # blocks independently.
+    serial.get_child(0).get_child(0).instance_to(serial.get_child(1))
+    parallel.get_child(0).get_child(0).instance_to(parallel.get_child(1))
+
+    assert flatten_strong(parallel, 4) == flatten_strong(serial, 0)
+
+    assert describe(parallel.node()) == describe(serial.node())
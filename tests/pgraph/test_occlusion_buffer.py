@@ -0,0 +1,147 @@
+from panda3d.core import OcclusionBuffer, OccluderNode, PerspectiveLens
+from panda3d.core import BoundingSphere, BoundingBox, NodePath
+from panda3d.core import LMatrix4, Camera
+from panda3d.core import GraphicsPipe, FrameBufferProperties, WindowProperties
+from panda3d.core import load_prc_file_data, unload_prc_file
+from contextlib import contextmanager
+import pytest
+
+
+@contextmanager
+def prc(data):
+    page = load_prc_file_data("test_occlusion_buffer", data)
+    try:
+        yield
+    finally:
+        unload_prc_file(page)
+
+
+def make_lens():
+    lens = PerspectiveLens(90, 90)
+    lens.set_near_far(1, 100)
+    return lens
+
+
+@pytest.fixture
+def buffer():
+    # A camera at the origin, looking down the Y axis with a 90 degree field
+    # of view, with a 10x10 occluder 10 units in front of it.
+    buffer = OcclusionBuffer(64, 64)
+    buffer.clear(LMatrix4.ident_mat(), make_lens().get_projection_mat())
+    assert buffer.add_quad((-5, 10, -5), (5, 10, -5), (5, 10, 5), (-5, 10, 5))
+    buffer.update_hierarchy()
+    return buffer
+
+
+def test_occlusion_buffer_culls_behind(buffer):
+    assert buffer.is_occluded(BoundingSphere((0, 20, 0), 1))
+    assert buffer.is_occluded(BoundingSphere((7, 20, -7), 1))
+    assert buffer.is_occluded(BoundingBox((-8, 30, -8), (8, 40, 8)))
+
+    # The same box, moved by a transform.
+    box = BoundingBox((-1, -1, -1), (1, 1, 1))
+    assert buffer.is_occluded(box, LMatrix4.translate_mat(0, 50, 0))
+    assert not buffer.is_occluded(box, LMatrix4.translate_mat(0, 5, 0))
+
+
+def test_occlusion_buffer_keeps_visible(buffer):
+    # In front of the occluder.
+    assert not buffer.is_occluded(BoundingSphere((0, 5, 0), 1))
+
+    # Intersecting the occluder.
+    assert not buffer.is_occluded(BoundingSphere((0, 10, 0), 1))
+
+    # Behind it, but sticking out to the side.
+    assert not buffer.is_occluded(BoundingSphere((10, 20, 0), 1))
+    assert not buffer.is_occluded(BoundingBox((-15, 30, -1), (15, 40, 1)))
+
+    # Crossing the near plane.
+    assert not buffer.is_occluded(BoundingSphere((0, 0, 0), 2))
+
+
+def test_occlusion_buffer_back_facing():
+    buffer = OcclusionBuffer(64, 64)
+    buffer.clear(LMatrix4.ident_mat(), make_lens().get_projection_mat())
+    assert not buffer.add_quad((-5, 10, 5), (5, 10, 5), (5, 10, -5), (-5, 10, -5))
+    buffer.update_hierarchy()
+
+    assert not buffer.is_occluded(BoundingSphere((0, 20, 0), 1))
+
+
+def test_occlusion_buffer_hierarchy(buffer):
+    # Each texel of a level must hold the farthest depth of the texels below.
+    for level in range(1, buffer.get_num_levels()):
+        scale = 1 << (level - 1)
+        width = (buffer.width + scale - 1) // scale
+        height = (buffer.height + scale - 1) // scale
+        for y in range(height):
+            for x in range(width):
+                assert buffer.get_depth(x // 2, y // 2, level) >= buffer.get_depth(x, y, level - 1)
+
+    # The middle of the occluder is covered, the corners of the screen are not.
+    assert buffer.get_depth(32, 32) < 1
+    assert buffer.get_depth(0, 0) == 1
+    assert buffer.get_depth(63, 63) == 1
+
+
+def test_occlusion_buffer_occluder_node():
+    root = NodePath("root")
+    occluder_node = OccluderNode("occluder")
+    occluder_node.set_vertices((-5, 0, -5), (5, 0, -5), (5, 0, 5), (-5, 0, 5))
+    occluder = root.attach_new_node(occluder_node)
+    occluder.set_y(10)
+
+    lens = make_lens()
+    buffer = OcclusionBuffer(64, 64)
+    buffer.clear(LMatrix4.ident_mat(), lens.get_projection_mat())
+    assert buffer.add_occluder(occluder, root)
+    assert buffer.has_occluder(occluder)
+    assert buffer.get_num_occluders() == 1
+    buffer.update_hierarchy()
+
+    assert buffer.is_occluded(BoundingSphere((0, 20, 0), 1))
+
+    buffer.clear(LMatrix4.ident_mat(), lens.get_projection_mat())
+    assert not buffer.has_occluder(occluder)
+
+
+def test_occlusion_buffer_follows_viewport(graphics_pipe, graphics_engine):
+    output = graphics_engine.make_output(
+        graphics_pipe,
+        'buffer',
+        0,
+        FrameBufferProperties(),
+        WindowProperties.size(64, 32),
+        GraphicsPipe.BF_refuse_window
+    )
+    graphics_engine.open_windows()
+
+    if output is None:
+        pytest.skip("GraphicsPipe cannot make offscreen buffers")
+
+    root = NodePath("root")
+    region = output.make_display_region()
+    region.camera = root.attach_new_node(Camera("camera"))
+
+    try:
+        with prc("occlusion-buffer-size 64"):
+            # The buffer that is created automatically takes on the aspect
+            # ratio of the viewport, also when it changes later on.
+            graphics_engine.render_frame()
+            buffer = region.cull_traverser.get_occlusion_buffer()
+            assert buffer is not None
+            assert (buffer.width, buffer.height) == (64, 32)
+
+            region.set_dimensions(0, 0.25, 0, 1)
+            graphics_engine.render_frame()
+            buffer = region.cull_traverser.get_occlusion_buffer()
+            assert (buffer.width, buffer.height) == (64, 128)
+
+            # A buffer that was set explicitly is left alone.
+            buffer = OcclusionBuffer(16, 16)
+            region.cull_traverser.set_occlusion_buffer(buffer)
+            region.set_dimensions(0, 1, 0, 1)
+            graphics_engine.render_frame()
+            assert region.cull_traverser.get_occlusion_buffer() == buffer
+    finally:
+        graphics_engine.remove_window(output)
@@ -0,0 +1,195 @@
+from panda3d.core import SceneSnapshot, CullTraverser, NodePath, ColorAttrib
+from panda3d.core import LPoint3, LMatrix4, GeomNode, Camera
+from panda3d.core import GraphicsPipe, FrameBufferProperties, WindowProperties
+import pytest
+
+
+def test_scene_snapshot_order():
+    root = NodePath("root")
+    a = root.attach_new_node("a")
+    a1 = a.attach_new_node("a1")
+    a2 = a.attach_new_node("a2")
+    b = root.attach_new_node("b")
+
+    snapshot = SceneSnapshot(root)
+    snapshot.update()
+    assert snapshot.get_num_records() == 5
+
+    # The hierarchy is recorded in depth-first order.
+    nodes = [snapshot.get_node(n) for n in range(5)]
+    assert nodes == [root.node(), a.node(), a1.node(), a2.node(), b.node()]
+    assert snapshot.get_node_path(3) == a2
+
+    assert [snapshot.get_parent(n) for n in range(5)] == [-1, 0, 1, 1, 0]
+    assert [snapshot.get_skip(n) for n in range(5)] == [5, 4, 3, 4, 5]
+
+
+def test_scene_snapshot_net_transform():
+    root = NodePath("root")
+    a = root.attach_new_node("a")
+    a1 = a.attach_new_node("a1")
+    a.set_pos(1, 2, 3)
+    a1.set_pos(10, 0, 0)
+    a.set_color((1, 0, 0, 1))
+
+    snapshot = SceneSnapshot(root)
+    snapshot.update()
+    assert snapshot.get_num_records() == 3
+
+    assert snapshot.get_net_transform(2).get_pos() == LPoint3(11, 2, 3)
+    assert snapshot.get_net_transform(2) == a1.get_net_transform()
+    assert snapshot.get_net_state(2).has_attrib(ColorAttrib)
+
+
+def test_scene_snapshot_update():
+    root = NodePath("root")
+    for i in range(10):
+        child = root.attach_new_node("child")
+        for j in range(10):
+            child.attach_new_node("leaf")
+
+    snapshot = SceneSnapshot(root)
+    snapshot.update()
+    assert snapshot.get_num_records() == 111
+    assert snapshot.num_rebuilt == 111
+
+    # Nothing changed.
+    snapshot.update()
+    assert snapshot.num_rebuilt == 0
+
+    # Moving one leaf only rebuilds the path to it.
+    leaf = root.get_child(3).get_child(4)
+    leaf.set_pos(0, 5, 0)
+    snapshot.update()
+    assert snapshot.num_rebuilt == 3
+    assert snapshot.get_num_records() == 111
+    assert snapshot.get_net_transform(1 + 3 * 11 + 1 + 4).get_pos() == LPoint3(0, 5, 0)
+
+    # Moving a child rebuilds the leaves below it as well.
+    root.get_child(5).set_pos(1, 0, 0)
+    snapshot.update()
+    assert snapshot.num_rebuilt == 12
+
+    # Adding a node.
+    extra = root.get_child(9).attach_new_node("extra")
+    snapshot.update()
+    assert snapshot.get_num_records() == 112
+    assert snapshot.get_node(111) == extra.node()
+    assert snapshot.get_skip(0) == 112
+    assert snapshot.get_parent(111) == 1 + 9 * 11
+
+    # Removing one.
+    root.get_child(0).remove_node()
+    snapshot.update()
+    assert snapshot.get_num_records() == 101
+    assert snapshot.get_node(1) == root.get_child(0).node()
+    assert snapshot.get_parent(2) == 1
+
+    # Explicitly marking a subtree dirty.
+    snapshot.mark_dirty(root.get_child(2))
+    snapshot.update()
+    assert snapshot.num_rebuilt == 12
+
+    snapshot.mark_dirty()
+    snapshot.update()
+    assert snapshot.num_rebuilt == 101
+
+
+def test_scene_snapshot_opaque():
+    root = NodePath("root")
+    hidden = root.attach_new_node("hidden")
+    hidden.attach_new_node("child")
+    shown = root.attach_new_node("shown")
+    shown.attach_new_node("child")
+    hidden.hide()
+
+    # The children of the hidden node are left out.
+    snapshot = SceneSnapshot(root)
+    snapshot.update()
+    assert snapshot.get_num_records() == 4
+    assert snapshot.is_opaque(1)
+    assert snapshot.get_skip(1) == 2
+    assert not snapshot.is_opaque(2)
+    assert snapshot.get_node(2) == shown.node()
+
+    hidden.show()
+    snapshot.update()
+    assert snapshot.get_num_records() == 5
+    assert not snapshot.is_opaque(1)
+
+
+def test_scene_snapshot_cull_traverser():
+    root = NodePath("root")
+    snapshot = SceneSnapshot(root)
+
+    trav = CullTraverser()
+    assert trav.get_scene_snapshot() is None
+    trav.set_scene_snapshot(snapshot)
+    assert trav.get_scene_snapshot() == snapshot
+    trav.set_scene_snapshot(None)
+    assert trav.get_scene_snapshot() is None
+
+
+def get_culled_triangles(engine, region):
+    # Returns the number of triangles of each Geom in the cull result.
+    engine.render_frame()
+    result = NodePath(region.make_cull_result_graph())
+    return sorted(geom.get_num_triangles()
+                  for path in result.find_all_matches("**/+GeomNode")
+                  for geom in path.node().get_geoms())
+
+
+def test_scene_snapshot_cluster_cull(graphics_pipe, graphics_engine, make_sphere):
+    buffer = graphics_engine.make_output(
+        graphics_pipe,
+        'buffer',
+        0,
+        FrameBufferProperties(),
+        WindowProperties.size(32, 32),
+        GraphicsPipe.BF_refuse_window
+    )
+    graphics_engine.open_windows()
+
+    if buffer is None:
+        pytest.skip("GraphicsPipe cannot make offscreen buffers")
+
+    def make_clustered_sphere(x):
+        geom = make_sphere(24, 48)
+        geom.transform_vertices(LMatrix4.translate_mat(x, 0, 0))
+        assert geom.make_clusters_in_place(32)
+        return geom
+
+    # A node with several Geoms, one of which sticks out of the view frustum,
+    # and one with a single Geom that does.
+    root = NodePath("root")
+    multi = GeomNode("multi")
+    multi.add_geom(make_clustered_sphere(0))
+    multi.add_geom(make_clustered_sphere(-2))
+    root.attach_new_node(multi).set_y(6)
+    single = GeomNode("single")
+    single.add_geom(make_clustered_sphere(2))
+    root.attach_new_node(single).set_y(6)
+    num_triangles = 3 * make_sphere(24, 48).get_num_triangles()
+
+    camera = root.attach_new_node(Camera("camera"))
+    region = buffer.make_display_region()
+    region.camera = camera
+
+    try:
+        expected = get_culled_triangles(graphics_engine, region)
+        assert len(expected) == 3
+        assert sum(expected) < num_triangles
+
+        trav = CullTraverser()
+        trav.set_scene_snapshot(SceneSnapshot(root))
+        region.set_cull_traverser(trav)
+        assert get_culled_triangles(graphics_engine, region) == expected
+
+        # With everything in view, only the back-facing clusters are culled.
+        camera.set_y(-20)
+        expected = get_culled_triangles(graphics_engine, region)
+        assert len(expected) == 3
+        region.set_cull_traverser(CullTraverser())
+        assert get_culled_triangles(graphics_engine, region) == expected
+    finally:
+        graphics_engine.remove_window(buffer)
@@ -0,0 +1,194 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file test_state_compose.cxx
+ * @author rdb
+ * @date 2026-10-17
+ */
+
+#include "transformState.h"
+#include "renderState.h"
+#include "colorScaleAttrib.h"
+#include "colorAttrib.h"
+#include "pvector.h"
+
+#include "catch_amalgamated.hpp"
+
+#include <future>
+#include <thread>
+
+typedef pvector<CPT(TransformState)> Transforms;
+typedef pvector<CPT(RenderState)> States;
+
+static Transforms
+make_transforms(int count) {
+  Transforms transforms;
+  for (int i = 0; i < count; ++i) {
+    transforms.push_back(TransformState::make_pos_hpr(
+      LVecBase3(i, i * 2, 0), LVecBase3(i * 10, 0, 0)));
+  }
+  return transforms;
+}
+
+static States
+make_states(int count) {
+  States states;
+  for (int i = 0; i < count; ++i) {
+    if (i % 2 == 0) {
+      states.push_back(RenderState::make(
+        ColorScaleAttrib::make(LVecBase4(i / (PN_stdfloat)count, 1, 1, 1))));
+    } else {
+      states.push_back(RenderState::make(
+        ColorAttrib::make_flat(LColor(1, i / (PN_stdfloat)count, 1, 1))));
+    }
+  }
+  return states;
+}
+
+/**
+ * Composes every pair of the given states the indicated number of times, from
+ * the indicated number of threads at once, and stores the results of the last
+ * round of each thread in results.
+ */
+template<class State>
+static void
+compose_from_threads(const pvector<CPT(State)> &states, int num_threads,
+                     int num_rounds, pvector<pvector<CPT(State)> > &results) {
+  results.clear();
+  results.resize(num_threads);
+
+  auto compose_all = [&] (int ti) {
+    pvector<CPT(State)> &out = results[ti];
+    for (int round = 0; round < num_rounds; ++round) {
+      out.clear();
+      for (const State *a : states) {
+        for (const State *b : states) {
+          out.push_back(a->compose(b));
+          out.push_back(a->invert_compose(b));
+        }
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (int ti = 1; ti < num_threads; ++ti) {
+    threads.emplace_back(compose_all, ti);
+  }
+  compose_all(0);
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+}
+
+TEST_CASE("TransformState::compose is consistent across threads", "[pgraph]") {
+  Transforms transforms = make_transforms(24);
+
+  pvector<Transforms> expected;
+  compose_from_threads(transforms, 1, 1, expected);
+
+  pvector<Transforms> results;
+  compose_from_threads(transforms, 8, 4, results);
+
+  // Since the states are unique, every thread should have arrived at the very
+  // same objects as the single-threaded run.
+  for (const Transforms &result : results) {
+    REQUIRE(result.size() == expected[0].size());
+    for (size_t i = 0; i < result.size(); ++i) {
+      CHECK(result[i] == expected[0][i]);
+    }
+  }
+}
+
+TEST_CASE("RenderState::compose is consistent across threads", "[pgraph]") {
+  States states = make_states(24);
+
+  pvector<States> expected;
+  compose_from_threads(states, 1, 1, expected);
+
+  pvector<States> results;
+  compose_from_threads(states, 8, 4, results);
+
+  for (const States &result : results) {
+    REQUIRE(result.size() == expected[0].size());
+    for (size_t i = 0; i < result.size(); ++i) {
+      CHECK(result[i] == expected[0][i]);
+    }
+  }
+}
+
+TEST_CASE("State caches may be cleared while composing", "[pgraph]") {
+  Transforms transforms = make_transforms(16);
+
+  pvector<Transforms> expected;
+  compose_from_threads(transforms, 1, 1, expected);
+
+  pvector<Transforms> results;
+  std::thread clearer([] {
+    for (int i = 0; i < 20; ++i) {
+      TransformState::clear_cache();
+      std::this_thread::yield();
+    }
+  });
+  compose_from_threads(transforms, 4, 20, results);
+  clearer.join();
+
+  for (const Transforms &result : results) {
+    REQUIRE(result.size() == expected[0].size());
+    for (size_t i = 0; i < result.size(); ++i) {
+      CHECK(result[i] == expected[0][i]);
+    }
+  }
+}
+
+#if defined(HAVE_THREADS) && !defined(SIMPLE_THREADS)
+TEST_CASE("Garbage collection empties the caches of idle threads", "[pgraph]") {
+  CPT(TransformState) a = TransformState::make_pos(LVecBase3(1, 2, 3));
+  CPT(TransformState) b = TransformState::make_hpr(LVecBase3(45, 0, 0));
+  CPT(TransformState) result;
+
+  // The thread composes a state and then sits idle until we are done.
+  std::promise<void> composed;
+  std::promise<void> done;
+  std::thread thread([&] {
+    result = a->compose(b);
+    composed.set_value();
+    done.get_future().wait();
+  });
+  composed.get_future().wait();
+
+  int ref_count = result->get_ref_count();
+  TransformState::garbage_collect();
+  CHECK(result->get_ref_count() == ref_count - 1);
+
+  done.set_value();
+  thread.join();
+}
+#endif
+
+// This measures how well compose() scales when it is called from several
+// threads at once.  Run it explicitly with: run_cxx_tests "[benchmark]"
+TEST_CASE("State composition contention", "[.][benchmark][pgraph]") {
+  Transforms transforms = make_transforms(64);
+  States states = make_states(64);
+  pvector<Transforms> transform_results;
+  pvector<States> state_results;
+
+  for (int num_threads : {1, 2, 4, 8}) {
+    std::string suffix = " from " + std::to_string(num_threads) + " threads";
+
+    BENCHMARK("TransformState::compose" + suffix) {
+      compose_from_threads(transforms, num_threads, 8, transform_results);
+      return transform_results.size();
+    };
+
+    BENCHMARK("RenderState::compose" + suffix) {
+      compose_from_threads(states, num_threads, 8, state_results);
+      return state_results.size();
+    };
+  }
+}
@@ -1,3 +1,4 @@
+import pytest
 from panda3d import core
 
 # Some dummy textures we can use for our texture attributes.
@@ -212,3 +213,44 @@ def test_textureattrib_compare():
     assert tattr1.compare_to(tattr2) != 0
     assert tattr2.compare_to(tattr1) != 0
     assert tattr2.compare_to(tattr1) == -tattr1.compare_to(tattr2)
+
+
+def test_textureattrib_streaming_cull_callback(graphics_pipe, graphics_engine):
+    # A state that was already rendered gets a cull callback once its texture
+    # starts streaming, so that the texture can ask for its mipmap levels.
+    buffer = graphics_engine.make_output(
+        graphics_pipe,
+        'buffer',
+        0,
+        core.FrameBufferProperties(),
+        core.WindowProperties.size(32, 32),
+        core.GraphicsPipe.BF_refuse_window
+    )
+    graphics_engine.open_windows()
+    if buffer is None:
+        pytest.skip("GraphicsPipe cannot make offscreen buffers")
+
+    tex = core.Texture("streaming")
+    tex.setup_2d_texture(64, 64, core.Texture.T_unsigned_byte, core.Texture.F_rgba)
+    tex.set_ram_image(b"\x80" * (64 * 64 * 4))
+
+    render = core.NodePath("render")
+    card = render.attach_new_node(core.CardMaker("card").generate())
+    card.set_pos(-0.5, 5, -0.5)
+    card.set_texture(tex)
+    camera = render.attach_new_node(core.Camera("camera"))
+    buffer.make_display_region().camera = camera
+
+    state = card.get_state()
+    graphics_engine.render_frame()
+    assert not state.has_cull_callback()
+
+    manager = core.TextureStreamingManager.get_global_ptr()
+    manager.add_texture(tex)
+    try:
+        assert tex.is_streaming()
+        graphics_engine.render_frame()
+        assert state.has_cull_callback()
+    finally:
+        manager.remove_texture(tex)
+        graphics_engine.remove_window(buffer)
@@ -1,4 +1,4 @@
-from panda3d.core import TransformState, Mat4, Mat3
+from panda3d.core import TransformState, Mat4, Mat3, ConfigVariableInt
 
 
 def test_transform_identity():
@@ -66,3 +66,23 @@ def test_transform_invalid():
 
     state2 = TransformState.make_invalid()
     assert state.this == state2.this
+
+
+def test_transform_garbage_collect_budget():
+    budget = ConfigVariableInt('garbage-collect-states-budget')
+    old_budget = budget.value
+    budget.value = 1
+    try:
+        states = [TransformState.make_pos((i, 0.25, -0.75)) for i in range(5000)]
+        del states
+
+        # Even with a tiny budget, repeated calls must eventually free all of
+        # the states, since each call resumes where the last one stopped.
+        freed = 0
+        for i in range(10000):
+            freed += TransformState.garbage_collect()
+            if freed >= 5000:
+                break
+        assert freed >= 5000
+    finally:
+        budget.value = old_budget
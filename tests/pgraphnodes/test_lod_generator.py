@@ -0,0 +1,59 @@
+from panda3d.core import LODGenerator, FadeLODNode, GeomNode, PandaNode
+
+
+def test_lod_generator_levels(make_sphere):
+    model = PandaNode("model")
+    sphere = GeomNode("sphere")
+    sphere.add_geom(make_sphere(32, 64))
+    model.add_child(sphere)
+    orig_triangles = sphere.get_geom(0).get_num_triangles()
+
+    generator = LODGenerator()
+    generator.add_level(10, 0.5)
+    generator.add_level_triangles(50, 200)
+    generator.far_distance = 1000
+    lod = generator.generate(model)
+
+    assert lod.get_num_children() == 3
+    assert lod.get_num_switches() == 3
+    assert not lod.is_of_type(FadeLODNode)
+    assert lod.get_child(0) == model
+    assert (lod.get_in(0), lod.get_out(0)) == (10, 0)
+    assert (lod.get_in(1), lod.get_out(1)) == (50, 10)
+    assert (lod.get_in(2), lod.get_out(2)) == (1000, 50)
+
+    # The original is left alone.
+    assert sphere.get_geom(0).get_num_triangles() == orig_triangles
+
+    prev_triangles = orig_triangles
+    for i in range(1, 3):
+        level = lod.get_child(i)
+        assert level.get_num_children() == 1
+        gnode = level.get_child(0)
+        assert gnode.is_geom_node()
+        geom = gnode.get_geom(0)
+        assert geom.get_vertex_data() == sphere.get_geom(0).get_vertex_data()
+
+        num_triangles = geom.get_num_triangles()
+        assert num_triangles == generator.get_level_num_triangles(i - 1)
+        assert num_triangles < prev_triangles
+        assert generator.get_level_error(i - 1) > 0
+        prev_triangles = num_triangles
+
+    assert generator.get_level_num_triangles(0) <= orig_triangles // 2
+    assert generator.get_level_num_triangles(1) <= 200
+
+
+def test_lod_generator_fade(make_sphere):
+    sphere = GeomNode("sphere")
+    sphere.add_geom(make_sphere(16, 32))
+
+    generator = LODGenerator()
+    generator.fade = True
+    generator.add_level(20, 0, 0.05)
+
+    lod = generator.generate(sphere)
+    assert lod.is_of_type(FadeLODNode)
+    assert lod.get_num_children() == 2
+    assert generator.get_level_error(0) <= 0.05
+    assert generator.get_level_num_triangles(0) < 16 * 32 * 2